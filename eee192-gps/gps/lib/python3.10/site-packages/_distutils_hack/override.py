@@ -1 +0,0 @@
-__import__('_distutils_hack').do_override()
@@ -1,4 +0,0 @@
-from ._dists import Distribution
-from ._envs import Environment
-
-__all__ = ["Distribution", "Environment"]
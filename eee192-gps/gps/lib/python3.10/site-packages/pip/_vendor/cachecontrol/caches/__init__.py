@@ -1,9 +0,0 @@
-# SPDX-FileCopyrightText: 2015 Eric Larson
-#
-# SPDX-License-Identifier: Apache-2.0
-
-from .file_cache import FileCache, SeparateBodyFileCache
-from .redis_cache import RedisCache
-
-
-__all__ = ["FileCache", "SeparateBodyFileCache", "RedisCache"]
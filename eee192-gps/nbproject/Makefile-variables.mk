@@ -1,10 +0,0 @@
-#
-# Generated - do not edit!
-#
-# NOCDDL
-#
-CND_BASEDIR=`pwd`
-# default configuration
-CND_ARTIFACT_DIR_default=dist/default/production
-CND_ARTIFACT_NAME_default=eee192-gps.production.hex
-CND_ARTIFACT_PATH_default=dist/default/production/eee192-gps.production.hex
@@ -0,0 +1,396 @@
+/**
+ * @file host/lib/capscan.c
+ * @brief Record scanner for mixed terminal captures
+ */
+
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "capscan.h"
+
+/// Longest NMEA sentence looked for, '$' to LF (the standard allows 82)
+#define CAPSCAN_NMEA_MAX	96
+
+/// The only PMS frame the parser decodes: "BM", length 28, 26 data, checksum
+#define CAPSCAN_PMS_FRAME_LEN	32
+
+/// State of one scan
+typedef struct scan_type {
+	const uint8_t       *base;
+	const uint8_t       *end;
+	const capscan_ops_t *ops;
+	capscan_stats_t     *st;
+
+	// Text line being assembled
+	char   line[CAPSCAN_LINE_MAX];
+	size_t line_len;
+	size_t line_start;	// Capture offset of the line
+	int    line_cut;
+} scan_t;
+
+/////////////////////////////////////////////////////////////////////////////
+// Candidate search
+
+#define CAPSCAN_IS_CANDIDATE(c)	((c) == 0x1B || (c) == '$' || (c) == 0x42 || (c) == '\n')
+
+/// First ESC, '$', 0x42 or LF in [p, end), or end
+static const uint8_t *scan_next(const uint8_t *p, const uint8_t *end)
+{
+#if defined(__SSE2__)
+	const __m128i esc = _mm_set1_epi8(0x1B);
+	const __m128i dol = _mm_set1_epi8('$');
+	const __m128i bee = _mm_set1_epi8(0x42);
+	const __m128i lf  = _mm_set1_epi8('\n');
+
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128((const __m128i *)p);
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, esc), _mm_cmpeq_epi8(v, dol)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, bee), _mm_cmpeq_epi8(v, lf)));
+		unsigned mask = (unsigned)_mm_movemask_epi8(m);
+
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+		p += 16;
+	}
+#else
+	/*
+	 * SWAR: a byte of (w ^ pattern) is zero where w holds the pattern byte.
+	 * The zero-byte test can also flag a byte above a real match, never
+	 * below one, so the lowest flag is exact (little-endian load order).
+	 */
+	const uint64_t ones = 0x0101010101010101ull, highs = 0x8080808080808080ull;
+
+	while (end - p >= 8) {
+		uint64_t w, x, hit = 0;
+
+		memcpy(&w, p, sizeof(w));
+		x = w ^ (ones * 0x1B); hit |= (x - ones) & ~x & highs;
+		x = w ^ (ones * '$');  hit |= (x - ones) & ~x & highs;
+		x = w ^ (ones * 0x42); hit |= (x - ones) & ~x & highs;
+		x = w ^ (ones * '\n'); hit |= (x - ones) & ~x & highs;
+		if (hit != 0 && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+			return p + (__builtin_ctzll(hit) >> 3);
+		if (hit != 0)
+			break;
+		p += 8;
+	}
+#endif
+	while (p < end && !CAPSCAN_IS_CANDIDATE(*p))
+		++p;
+	return p;
+}
+
+const char *capscan_engine(void)
+{
+#if defined(__SSE2__)
+	return "SSE2";
+#else
+	return "SWAR";
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Records
+
+static void report_bad(scan_t *s, size_t off, size_t len, const char *why)
+{
+	s->st->bad_bytes += len;
+	if (s->ops->on_bad != NULL)
+		s->ops->on_bad(s->ops->user, off, len, why);
+}
+
+static void line_append(scan_t *s, const uint8_t *p, size_t len)
+{
+	size_t room = sizeof(s->line) - s->line_len;
+
+	if (len > room) {
+		len = room;
+		s->line_cut = 1;
+	}
+	memcpy(&s->line[s->line_len], p, len);
+	s->line_len += len;
+}
+
+/// Drop the line so far (framing in front of a record)
+static void line_reset(scan_t *s, size_t next)
+{
+	s->line_len = 0;
+	s->line_cut = 0;
+	s->line_start = next;
+}
+
+/// Close the line at an LF; blank lines are not reported
+static void line_end(scan_t *s, size_t next)
+{
+	size_t len = s->line_len;
+	int binary = 0, blank = 1;
+
+	while (len > 0 && s->line[len - 1] == '\r')
+		--len;
+	for (size_t i = 0; i < len; ++i) {
+		uint8_t c = (uint8_t)s->line[i];
+
+		if ((c < 0x20 && c != '\t' && c != '\r') || c >= 0x7F)
+			binary = 1;
+		else if (c != ' ' && c != '\t' && c != '\r')
+			blank = 0;
+	}
+
+	if (binary) {
+		++s->st->txt_bad;
+		report_bad(s, s->line_start, next - s->line_start, "binary in text");
+	} else if (!blank) {
+		++s->st->txt;
+		s->st->txt_cut += (uint64_t)s->line_cut;
+		if (s->ops->on_text != NULL)
+			s->ops->on_text(s->ops->user, s->line_start, s->line, len);
+	}
+	line_reset(s, next);
+}
+
+static int hexval(uint8_t c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	return -1;
+}
+
+/// "$" + 5-character address + "," at p
+static int is_nmea_start(const uint8_t *p, const uint8_t *end)
+{
+	if (end - p < 7 || p[0] != '$' || p[6] != ',')
+		return 0;
+	for (int i = 1; i <= 5; ++i)
+		if (!((p[i] >= 'A' && p[i] <= 'Z') || (p[i] >= '0' && p[i] <= '9')))
+			return 0;
+	return 1;
+}
+
+/// A PMS header at p (the frame itself may still be damaged)
+static int is_pms_start(const uint8_t *p, const uint8_t *end)
+{
+	return end - p >= 4 && p[0] == PMS_PACKET_START_BYTE_1 &&
+	       p[1] == PMS_PACKET_START_BYTE_2 && p[2] == 0x00 &&
+	       p[3] == CAPSCAN_PMS_FRAME_LEN - 4;
+}
+
+/// A PMS header, a CSI sequence or a sentence address starts at p
+static int looks_like_start(const uint8_t *p, const uint8_t *end)
+{
+	if (p[0] == 0x1B)
+		return end - p >= 2 && p[1] == '[';
+	return is_pms_start(p, end) || is_nmea_start(p, end);
+}
+
+/**
+ * Try a sentence at p ('$'). Returns the bytes consumed, or 0 if this is not
+ * the start of a sentence (then '$' is ordinary text).
+ */
+static size_t try_nmea(scan_t *s, const uint8_t *p)
+{
+	size_t lim = (size_t)(s->end - p) < CAPSCAN_NMEA_MAX ?
+		     (size_t)(s->end - p) : CAPSCAN_NMEA_MAX;
+	size_t off = (size_t)(p - s->base);
+	const uint8_t *q, *tail, *star;
+	uint8_t sum = 0;
+	int hi, lo;
+
+	if (!is_nmea_start(p, s->end))
+		return 0;
+
+	/*
+	 * Up to the LF. A sentence cut short in the echo runs into whatever
+	 * was printed next, usually a tag (ESC) or another sentence ('$').
+	 */
+	for (q = p + 1; q < p + lim; ++q) {
+		if (*q == '\n' || *q == 0x1B || *q == '$')
+			break;
+		if (*q < 0x20 && *q != '\r')
+			break;
+	}
+	if (q == p + lim || *q != '\n') {
+		++s->st->nmea_bad;
+		report_bad(s, off, (size_t)(q - p), "nmea truncated");
+		return (size_t)(q - p);
+	}
+
+	// ... "*" + 2 hex digits [CR] LF
+	tail = q;
+	if (tail[-1] == '\r')
+		--tail;
+	star = tail - 3;
+	if (star <= p + 6 || star[0] != '*' ||
+	    (hi = hexval(star[1])) < 0 || (lo = hexval(star[2])) < 0) {
+		++s->st->nmea_bad;
+		report_bad(s, off, (size_t)(q + 1 - p), "nmea truncated");
+		return (size_t)(q + 1 - p);
+	}
+
+	for (const uint8_t *c = p + 1; c < star; ++c)
+		sum ^= *c;
+	if (sum != (uint8_t)((hi << 4) | lo)) {
+		++s->st->nmea_bad;
+		report_bad(s, off, (size_t)(q + 1 - p), "nmea checksum");
+	} else {
+		++s->st->nmea;
+		if (s->ops->on_nmea != NULL)
+			s->ops->on_nmea(s->ops->user, off, (const char *)p, (size_t)(star + 3 - p));
+	}
+	return (size_t)(q + 1 - p);
+}
+
+/**
+ * Try a PMS frame at p (0x42). Returns the bytes consumed, or 0 if this is
+ * not a frame header (then 0x42 is an ordinary 'B').
+ */
+static size_t try_pms(scan_t *s, const uint8_t *p)
+{
+	pms_parser_internal_state_t parser;
+	pms_parser_status_t res = PMS_PARSER_PROCESSING_BYTE;
+	size_t avail = (size_t)(s->end - p);
+	size_t off = (size_t)(p - s->base);
+	const uint8_t *resync;
+	pms_data_t d;
+
+	if (!is_pms_start(p, s->end))
+		return 0;
+
+	if (avail >= CAPSCAN_PMS_FRAME_LEN) {
+		pms_parser_init(&parser);
+		for (size_t i = 0; i < CAPSCAN_PMS_FRAME_LEN; ++i)
+			res = pms_parser_feed_byte(NULL, &parser, p[i], &d);
+	}
+	if (res == PMS_PARSER_OK) {
+		++s->st->pms;
+		if (s->ops->on_pms != NULL)
+			s->ops->on_pms(s->ops->user, off, &d);
+		return CAPSCAN_PMS_FRAME_LEN;
+	}
+
+	/*
+	 * Damaged or cut short (bytes lost in the echo, or the frame split
+	 * over two echoed chunks): skip it, but not past anything that looks
+	 * like the start of the next record.
+	 */
+	if (avail > CAPSCAN_PMS_FRAME_LEN)
+		avail = CAPSCAN_PMS_FRAME_LEN;
+	for (resync = p + 2; resync < p + avail; ++resync) {
+		if (looks_like_start(resync, s->end)) {
+			avail = (size_t)(resync - p);
+			break;
+		}
+	}
+	++s->st->pms_bad;
+	report_bad(s, off, avail, (size_t)(s->end - p) < CAPSCAN_PMS_FRAME_LEN ?
+		   "pms truncated" : "pms checksum");
+	return avail;
+}
+
+/// Length of the CSI sequence at p (ESC '['), or 0 if it is not one
+static size_t try_ansi(const uint8_t *p, const uint8_t *end)
+{
+	// ESC [ parameters (0x30-0x3F) intermediates (0x20-0x2F) final (0x40-0x7E)
+	const uint8_t *q = p + 2;
+
+	if (end - p < 3 || p[1] != '[')
+		return 0;
+	while (q < end && q - p < 24 && *q >= 0x20 && *q <= 0x3F)
+		++q;
+	if (q < end && *q >= 0x40 && *q <= 0x7E)
+		return (size_t)(q + 1 - p);
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void capscan_run(const uint8_t *base, size_t size, size_t begin, size_t stop,
+		 const capscan_ops_t *ops, capscan_stats_t *st)
+{
+	scan_t s = { .base = base, .end = base + size, .ops = ops, .st = st };
+	const uint8_t *p = base + begin, *lim = base + (stop < size ? stop : size);
+
+	line_reset(&s, begin);
+	while (p < lim) {
+		const uint8_t *q = scan_next(p, s.end);
+		size_t n = 0;
+
+		if (q >= lim) {
+			line_append(&s, p, (size_t)(lim - p));
+			break;
+		}
+		line_append(&s, p, (size_t)(q - p));
+
+		switch (*q) {
+		case '\n':
+			line_end(&s, (size_t)(q + 1 - base));
+			p = q + 1;
+			continue;
+		case 0x1B:
+			if ((n = try_ansi(q, s.end)) != 0) {
+				++st->ansi;
+				p = q + n;
+				continue;
+			}
+			break;
+		case '$':
+			// A sentence (or what is left of one) ends the line as well
+			if ((n = try_nmea(&s, q)) != 0) {
+				line_reset(&s, (size_t)(q + n - base));
+				p = q + n;
+				continue;
+			}
+			break;
+		default:
+			if ((n = try_pms(&s, q)) != 0) {
+				line_reset(&s, (size_t)(q + n - base));
+				p = q + n;
+				continue;
+			}
+			break;
+		}
+
+		// Not the start of anything; an ordinary character of the line
+		line_append(&s, q, 1);
+		p = q + 1;
+	}
+	/*
+	 * A line still open at a piece boundary runs into the record the next
+	 * piece starts with (a PMS frame behind its "[PM RAW]" tag), which
+	 * drops it as framing; only the end of the image ends it as text.
+	 */
+	if (s.line_len > 0 && lim == s.end)
+		line_end(&s, (size_t)(lim - base));
+}
+
+size_t capscan_resync(const uint8_t *base, size_t size, size_t off)
+{
+	const uint8_t *p = base + off, *end = base + size;
+
+	if (off == 0)
+		return 0;
+	while ((p = scan_next(p, end)) < end) {
+		/*
+		 * Text and sentences start a line; a PMS frame (which may come
+		 * without any line structure) must also pass its checksum.
+		 */
+		if ((*p == '$' || *p == 0x1B) && p[-1] == '\n' && looks_like_start(p, end))
+			return (size_t)(p - base);
+		if (is_pms_start(p, end) && end - p >= CAPSCAN_PMS_FRAME_LEN) {
+			uint16_t sum = 0;
+
+			for (int i = 0; i < CAPSCAN_PMS_FRAME_LEN - 2; ++i)
+				sum += p[i];
+			if (sum == (uint16_t)((p[30] << 8) | p[31]))
+				return (size_t)(p - base);
+		}
+		++p;
+	}
+	return size;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file host/lib/capscan.h
+ * @brief Record scanner for mixed terminal captures
+ *
+ * A PuTTY capture of the board's CDC port interleaves ANSI-coloured text
+ * lines from src/terminal_ui.c, NMEA sentences echoed behind a "[GPS RAW]"
+ * tag, and binary PMS frames echoed unescaped behind a "[PM" tag. Plain
+ * sensor captures (only NMEA, or only PMS frames) are a special case of the
+ * same layout.
+ *
+ * capscan_run() walks a memory image of a capture once and hands each record
+ * to a callback: NMEA sentences whose XOR checksum matches, PMS frames the
+ * firmware's parser (src/parsers/pms_parser.c) accepts, text lines with the
+ * ANSI sequences removed, and the corrupt spans in between. Tags in front
+ * of a record on the same line are framing and are dropped.
+ *
+ * The scan jumps between candidate bytes (ESC, '$', 0x42 and LF) with
+ * 16-byte SSE2 compares, or 8-byte SWAR words where SSE2 is not available.
+ *
+ * Large captures can be scanned in pieces, in parallel: capscan_resync()
+ * finds the first point at or after an offset where a record starts on a
+ * fresh line, and scanning each piece from one such point to the next gives
+ * the same records as one scan of the whole capture.
+ */
+
+#if !defined(CAPSCAN_H_)
+#define CAPSCAN_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "parsers/pms_parser.h"
+
+/// Record callbacks; any may be NULL. Offsets are from the start of the image.
+typedef struct capscan_ops_type {
+	/// A sentence, from '$' to the checksum (no line ending)
+	void (*on_nmea)(void *user, size_t off, const char *s, size_t len);
+	/// A PMS frame
+	void (*on_pms)(void *user, size_t off, const pms_data_t *d);
+	/// A non-blank text line, ANSI sequences and line ending removed
+	void (*on_text)(void *user, size_t off, const char *s, size_t len);
+	/// A corrupt span, with a short reason
+	void (*on_bad)(void *user, size_t off, size_t len, const char *why);
+	void *user;
+} capscan_ops_t;
+
+/// Counters of one scan; capscan_run() adds to them
+typedef struct capscan_stats_type {
+	uint64_t nmea, nmea_bad;
+	uint64_t pms, pms_bad;
+	uint64_t txt, txt_bad;
+	uint64_t txt_cut;	///< Text lines longer than CAPSCAN_LINE_MAX
+	uint64_t ansi;		///< ANSI sequences removed
+	uint64_t bad_bytes;	///< Bytes covered by corrupt spans
+} capscan_stats_t;
+
+/// Text kept per line; longer lines are cut (and counted)
+#define CAPSCAN_LINE_MAX	512
+
+/**
+ * Scan the records that start in [begin, stop)
+ *
+ * @param	base	Capture image
+ * @param	size	Size of the image; records may run past @p stop
+ * @param	begin	First offset to scan; a capscan_resync() point, or 0
+ * @param	stop	No record starting at or after this offset is reported;
+ *			a capscan_resync() point, or @p size
+ * @param	ops	Callbacks
+ * @param	st	Counters to add to
+ */
+void capscan_run(const uint8_t *base, size_t size, size_t begin, size_t stop,
+		 const capscan_ops_t *ops, capscan_stats_t *st);
+
+/**
+ * First resynchronisation point at or after an offset
+ *
+ * @return	An offset in [off, size]; size if there is none
+ */
+size_t capscan_resync(const uint8_t *base, size_t size, size_t off);
+
+/// Name of the candidate search compiled in ("SSE2" or "SWAR")
+const char *capscan_engine(void);
+
+#endif // CAPSCAN_H_
@@ -0,0 +1,773 @@
+/**
+ * @file host/lib/sarc.c
+ * @brief Columnar archive of sensor rows
+ */
+
+#include <errno.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sarc.h"
+
+#define SARC_VERSION		3
+
+/// Worst case of one column of one block (a 64-bit value plus tag per row)
+#define SARC_COL_MAX		(SARC_BLOCK_ROWS * 10 + 16)
+
+#define SARC_PAYLOAD_MAX	(SARC_NR_COLS * (SARC_COL_MAX + 5))
+
+struct sarc_writer_type {
+	FILE    *f;
+	uint32_t nr_rows;
+	sarc_row_t rows[SARC_BLOCK_ROWS];
+	uint8_t  col[SARC_COL_MAX];
+	uint8_t  payload[SARC_PAYLOAD_MAX];
+	uint64_t bytes;
+	int      err;
+
+	// Index
+	sarc_block_info_t *index;
+	uint32_t nr_blocks, max_blocks;
+};
+
+struct sarc_reader_type {
+	FILE    *f;
+	sarc_block_info_t *index;
+	uint32_t nr_blocks;
+	uint8_t  payload[SARC_PAYLOAD_MAX];
+
+	// Sequential scan
+	int64_t  t_from, t_to;
+	uint32_t next_block;
+	int      nr_rows, next_row;
+	uint32_t blocks_read, blocks_skipped;
+	sarc_row_t rows[SARC_BLOCK_ROWS];
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Byte-level helpers
+
+static uint64_t zigzag(int64_t v)
+{
+	return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63);
+}
+
+static int64_t unzigzag(uint64_t v)
+{
+	return (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+}
+
+static size_t put_varint(uint8_t *p, uint64_t v)
+{
+	size_t n = 0;
+
+	while (v >= 0x80) {
+		p[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	p[n++] = (uint8_t)v;
+	return n;
+}
+
+/// Decode a varint from [*p, end); returns -1 if it runs off the end
+static int get_varint(const uint8_t **p, const uint8_t *end, uint64_t *v)
+{
+	uint64_t r = 0;
+
+	for (int shift = 0; shift < 64 && *p < end; shift += 7) {
+		uint8_t b = *(*p)++;
+
+		r |= (uint64_t)(b & 0x7F) << shift;
+		if ((b & 0x80) == 0) {
+			*v = r;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+static void put_u16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+	put_u16(p, (uint16_t)v);
+	put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void put_u64(uint8_t *p, uint64_t v)
+{
+	put_u32(p, (uint32_t)v);
+	put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t get_u16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const uint8_t *p)
+{
+	return (uint32_t)get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static uint64_t get_u64(const uint8_t *p)
+{
+	return (uint64_t)get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+static uint64_t f64_bits(double v)
+{
+	uint64_t b;
+
+	memcpy(&b, &v, sizeof(b));
+	return b;
+}
+
+static double bits_f64(uint64_t b)
+{
+	double v;
+
+	memcpy(&v, &b, sizeof(v));
+	return v;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Bit streams (MSB first)
+
+typedef struct bitw_type {
+	uint8_t *buf;
+	size_t   len;		// Whole bytes written
+	uint64_t acc;
+	int      nr;		// Bits in acc
+} bitw_t;
+
+static void bit_put(bitw_t *w, uint64_t v, int n)
+{
+	// Split wide fields so the accumulator never holds more than 64 bits
+	if (n > 32) {
+		bit_put(w, v >> 32, n - 32);
+		n = 32;
+		v &= 0xFFFFFFFFu;
+	}
+	w->acc = (w->acc << n) | (n == 64 ? v : v & ((1ull << n) - 1));
+	w->nr += n;
+	while (w->nr >= 8) {
+		w->nr -= 8;
+		w->buf[w->len++] = (uint8_t)(w->acc >> w->nr);
+	}
+}
+
+static size_t bit_flush(bitw_t *w)
+{
+	if (w->nr > 0)
+		w->buf[w->len++] = (uint8_t)(w->acc << (8 - w->nr));
+	w->nr = 0;
+	return w->len;
+}
+
+typedef struct bitr_type {
+	const uint8_t *p, *end;
+	uint64_t acc;
+	int      nr;
+	int      err;
+} bitr_t;
+
+static uint64_t bit_get(bitr_t *r, int n)
+{
+	uint64_t v = 0;
+
+	if (n > 32) {
+		v = bit_get(r, n - 32) << 32;
+		n = 32;
+	}
+	while (r->nr < n) {
+		if (r->p == r->end) {
+			r->err = 1;
+			return 0;
+		}
+		r->acc = (r->acc << 8) | *r->p++;
+		r->nr += 8;
+	}
+	r->nr -= n;
+	return v | ((r->acc >> r->nr) & ((1ull << n) - 1));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Column encodings
+
+/*
+ * Delta-of-delta buckets, on the zig-zag value:
+ *   0         -> '0'
+ *   < 2^7     -> '10'    + 7 bits
+ *   < 2^9     -> '110'   + 9 bits
+ *   < 2^12    -> '1110'  + 12 bits
+ *   < 2^32    -> '11110' + 32 bits
+ *   otherwise -> '11111' + 64 bits
+ */
+static size_t enc_dod(const sarc_row_t *rows, uint32_t n, uint8_t *out)
+{
+	bitw_t w = { .buf = out };
+	int64_t prev = 0, delta = 0;
+
+	for (uint32_t i = 0; i < n; ++i) {
+		int64_t d = rows[i].t_ms - prev;
+		uint64_t z = zigzag(d - delta);
+
+		if (i == 0)
+			bit_put(&w, (uint64_t)rows[i].t_ms, 64);
+		else if (z == 0)
+			bit_put(&w, 0x0, 1);
+		else if (z < (1u << 7))
+			bit_put(&w, (0x2ull << 7) | z, 2 + 7);
+		else if (z < (1u << 9))
+			bit_put(&w, (0x6ull << 9) | z, 3 + 9);
+		else if (z < (1u << 12))
+			bit_put(&w, (0xEull << 12) | z, 4 + 12);
+		else if (z < (1ull << 32)) {
+			bit_put(&w, 0x1E, 5);
+			bit_put(&w, z, 32);
+		} else {
+			bit_put(&w, 0x1F, 5);
+			bit_put(&w, z, 64);
+		}
+		if (i > 0)
+			delta = d;
+		prev = rows[i].t_ms;
+	}
+	return bit_flush(&w);
+}
+
+static int dec_dod(const uint8_t *p, size_t len, uint32_t n, sarc_row_t *rows)
+{
+	bitr_t r = { .p = p, .end = p + len };
+	int64_t prev = 0, delta = 0;
+
+	for (uint32_t i = 0; i < n; ++i) {
+		uint64_t z = 0;
+
+		if (i == 0) {
+			prev = (int64_t)bit_get(&r, 64);
+			rows[i].t_ms = prev;
+			continue;
+		}
+		if (bit_get(&r, 1) == 0)
+			z = 0;
+		else if (bit_get(&r, 1) == 0)
+			z = bit_get(&r, 7);
+		else if (bit_get(&r, 1) == 0)
+			z = bit_get(&r, 9);
+		else if (bit_get(&r, 1) == 0)
+			z = bit_get(&r, 12);
+		else if (bit_get(&r, 1) == 0)
+			z = bit_get(&r, 32);
+		else
+			z = bit_get(&r, 64);
+		delta += unzigzag(z);
+		prev += delta;
+		rows[i].t_ms = prev;
+	}
+	return r.err ? -1 : 0;
+}
+
+/*
+ * Gorilla XOR, on the IEEE 754 bits:
+ *   same value                     -> '0'
+ *   XOR within the previous window -> '10' + the window's bits
+ *   otherwise                      -> '11' + 5 bits leading zeros
+ *                                     + 6 bits (length - 1) + length bits
+ */
+static size_t enc_xor(const sarc_row_t *rows, uint32_t n, size_t field, uint8_t *out)
+{
+	bitw_t w = { .buf = out };
+	uint64_t prev = 0;
+	int lead = -1, trail = 0;
+
+	for (uint32_t i = 0; i < n; ++i) {
+		uint64_t v = f64_bits(*(const double *)((const char *)&rows[i] + field));
+		uint64_t x = v ^ prev;
+
+		prev = v;
+		if (i == 0) {
+			bit_put(&w, v, 64);
+			continue;
+		}
+		if (x == 0) {
+			bit_put(&w, 0x0, 1);
+			continue;
+		}
+
+		int l = __builtin_clzll(x), t = __builtin_ctzll(x);
+
+		if (l > 31)
+			l = 31;
+		if (lead >= 0 && l >= lead && t >= trail) {
+			bit_put(&w, 0x2, 2);
+			bit_put(&w, x >> trail, 64 - lead - trail);
+		} else {
+			lead = l;
+			trail = t;
+			bit_put(&w, 0x3, 2);
+			bit_put(&w, (uint64_t)lead, 5);
+			bit_put(&w, (uint64_t)(63 - lead - trail), 6);
+			bit_put(&w, x >> trail, 64 - lead - trail);
+		}
+	}
+	return bit_flush(&w);
+}
+
+static int dec_xor(const uint8_t *p, size_t len, uint32_t n, size_t field, sarc_row_t *rows)
+{
+	bitr_t r = { .p = p, .end = p + len };
+	uint64_t prev = 0;
+	int lead = -1, trail = 0;
+
+	for (uint32_t i = 0; i < n; ++i) {
+		double *dst = (double *)((char *)&rows[i] + field);
+
+		if (i == 0) {
+			prev = bit_get(&r, 64);
+		} else if (bit_get(&r, 1) != 0) {
+			if (bit_get(&r, 1) != 0) {
+				lead = (int)bit_get(&r, 5);
+				trail = 64 - lead - ((int)bit_get(&r, 6) + 1);
+				if (trail < 0)
+					return -1;
+			} else if (lead < 0) {
+				return -1;
+			}
+			prev ^= bit_get(&r, 64 - lead - trail) << trail;
+		}
+		*dst = bits_f64(prev);
+	}
+	return r.err ? -1 : 0;
+}
+
+static size_t enc_pm(const sarc_row_t *rows, uint32_t n, int k, uint8_t *out)
+{
+	size_t len = 0;
+	int64_t prev = 0;
+
+	for (uint32_t i = 0; i < n; ++i) {
+		len += put_varint(&out[len], zigzag((int64_t)rows[i].pm[k] - prev));
+		prev = rows[i].pm[k];
+	}
+	return len;
+}
+
+static int dec_pm(const uint8_t *p, size_t len, uint32_t n, int k, sarc_row_t *rows)
+{
+	const uint8_t *end = p + len;
+	int64_t prev = 0;
+
+	for (uint32_t i = 0; i < n; ++i) {
+		uint64_t v;
+
+		if (get_varint(&p, end, &v) != 0)
+			return -1;
+		prev += unzigzag(v);
+		rows[i].pm[k] = (uint16_t)prev;
+	}
+	return p == end ? 0 : -1;
+}
+
+int sarc_decode_columns(const uint8_t *payload, size_t len, uint32_t nr_rows,
+			uint32_t cols, sarc_row_t *rows)
+{
+	const uint8_t *p = payload, *end = payload + len;
+
+	if (nr_rows == 0 || nr_rows > SARC_BLOCK_ROWS)
+		return -1;
+	for (int c = 0; c < SARC_NR_COLS; ++c) {
+		uint64_t n;
+		int res;
+
+		if (get_varint(&p, end, &n) != 0 || n > (uint64_t)(end - p))
+			return -1;
+		if ((cols & (1u << c)) == 0)
+			res = 0;
+		else if (c == 0)
+			res = dec_dod(p, n, nr_rows, rows);
+		else if (c == 1)
+			res = dec_xor(p, n, nr_rows, offsetof(sarc_row_t, lat), rows);
+		else if (c == 2)
+			res = dec_xor(p, n, nr_rows, offsetof(sarc_row_t, lon), rows);
+		else
+			res = dec_pm(p, n, nr_rows, c - 3, rows);
+		if (res != 0)
+			return -1;
+		p += n;
+	}
+	return p == end ? 0 : -1;
+}
+
+int sarc_decode_block(const uint8_t *payload, size_t len, uint32_t nr_rows,
+		      sarc_row_t *rows)
+{
+	return sarc_decode_columns(payload, len, nr_rows, (1u << SARC_NR_COLS) - 1, rows);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Index entries
+
+static void block_info_put(uint8_t *p, const sarc_block_info_t *bi)
+{
+	put_u64(p, bi->offset);
+	put_u32(p + 8, bi->nr_rows);
+	put_u32(p + 12, bi->payload_len);
+	put_u64(p + 16, (uint64_t)bi->t_min);
+	put_u64(p + 24, (uint64_t)bi->t_max);
+	put_u64(p + 32, f64_bits(bi->lat_min));
+	put_u64(p + 40, f64_bits(bi->lat_max));
+	put_u64(p + 48, f64_bits(bi->lon_min));
+	put_u64(p + 56, f64_bits(bi->lon_max));
+	for (int k = 0; k < SARC_NR_PM; ++k) {
+		put_u16(p + 64 + 2 * k, bi->pm_min[k]);
+		put_u16(p + 64 + 2 * SARC_NR_PM + 2 * k, bi->pm_max[k]);
+		put_u64(p + 116 + 8 * k, bi->pm_sum[k]);
+	}
+	put_u32(p + 112, bi->nr_fix);
+}
+
+void sarc_block_info_get(const uint8_t *p, sarc_block_info_t *bi)
+{
+	bi->offset = get_u64(p);
+	bi->nr_rows = get_u32(p + 8);
+	bi->payload_len = get_u32(p + 12);
+	bi->t_min = (int64_t)get_u64(p + 16);
+	bi->t_max = (int64_t)get_u64(p + 24);
+	bi->lat_min = bits_f64(get_u64(p + 32));
+	bi->lat_max = bits_f64(get_u64(p + 40));
+	bi->lon_min = bits_f64(get_u64(p + 48));
+	bi->lon_max = bits_f64(get_u64(p + 56));
+	for (int k = 0; k < SARC_NR_PM; ++k) {
+		bi->pm_min[k] = get_u16(p + 64 + 2 * k);
+		bi->pm_max[k] = get_u16(p + 64 + 2 * SARC_NR_PM + 2 * k);
+		bi->pm_sum[k] = get_u64(p + 116 + 8 * k);
+	}
+	bi->nr_fix = get_u32(p + 112);
+}
+
+/// Statistics of decoded rows
+static void block_info_fill(sarc_block_info_t *bi, const sarc_row_t *rows, uint32_t n)
+{
+	bi->nr_rows = n;
+	bi->t_min = bi->t_max = rows[0].t_ms;
+	bi->lat_min = bi->lat_max = bi->lon_min = bi->lon_max = NAN;
+	bi->nr_fix = 0;
+	for (int k = 0; k < SARC_NR_PM; ++k) {
+		bi->pm_min[k] = bi->pm_max[k] = rows[0].pm[k];
+		bi->pm_sum[k] = 0;
+	}
+
+	for (uint32_t i = 0; i < n; ++i) {
+		const sarc_row_t *r = &rows[i];
+
+		if (r->t_ms < bi->t_min)
+			bi->t_min = r->t_ms;
+		if (r->t_ms > bi->t_max)
+			bi->t_max = r->t_ms;
+		// fmin/fmax ignore a NAN operand
+		bi->lat_min = fmin(bi->lat_min, r->lat);
+		bi->lat_max = fmax(bi->lat_max, r->lat);
+		bi->lon_min = fmin(bi->lon_min, r->lon);
+		bi->lon_max = fmax(bi->lon_max, r->lon);
+		if (!isnan(r->lat))
+			++bi->nr_fix;
+		for (int k = 0; k < SARC_NR_PM; ++k) {
+			bi->pm_sum[k] += r->pm[k];
+			if (r->pm[k] < bi->pm_min[k])
+				bi->pm_min[k] = r->pm[k];
+			if (r->pm[k] > bi->pm_max[k])
+				bi->pm_max[k] = r->pm[k];
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Writer
+
+sarc_writer_t *sarc_create(const char *path)
+{
+	static const uint8_t hdr[8] = { 'S', 'A', 'R', 'C', SARC_VERSION, 0, 0, 0 };
+	sarc_writer_t *w = calloc(1, sizeof(*w));
+
+	if (w == NULL)
+		return NULL;
+	if ((w->f = fopen(path, "wb")) == NULL) {
+		free(w);
+		return NULL;
+	}
+	if (fwrite(hdr, 1, sizeof(hdr), w->f) != sizeof(hdr))
+		w->err = 1;
+	w->bytes = sizeof(hdr);
+	return w;
+}
+
+static void sarc_flush(sarc_writer_t *w)
+{
+	uint8_t hdr[SARC_BLOCK_HDR_LEN] = { 'B', 'L', 'K', '2' };
+	sarc_block_info_t *bi;
+	size_t len = 0;
+
+	if (w->nr_rows == 0)
+		return;
+	if (w->nr_blocks == w->max_blocks) {
+		w->max_blocks = w->max_blocks ? w->max_blocks * 2 : 256;
+		bi = realloc(w->index, w->max_blocks * sizeof(*w->index));
+		if (bi == NULL) {
+			w->err = 1;
+			return;
+		}
+		w->index = bi;
+	}
+
+	for (int c = 0; c < SARC_NR_COLS; ++c) {
+		size_t n;
+
+		if (c == 0)
+			n = enc_dod(w->rows, w->nr_rows, w->col);
+		else if (c == 1)
+			n = enc_xor(w->rows, w->nr_rows, offsetof(sarc_row_t, lat), w->col);
+		else if (c == 2)
+			n = enc_xor(w->rows, w->nr_rows, offsetof(sarc_row_t, lon), w->col);
+		else
+			n = enc_pm(w->rows, w->nr_rows, c - 3, w->col);
+		len += put_varint(&w->payload[len], n);
+		memcpy(&w->payload[len], w->col, n);
+		len += n;
+	}
+
+	bi = &w->index[w->nr_blocks++];
+	block_info_fill(bi, w->rows, w->nr_rows);
+	bi->offset = w->bytes;
+	bi->payload_len = (uint32_t)len;
+
+	put_u32(&hdr[4], w->nr_rows);
+	put_u32(&hdr[8], (uint32_t)len);
+	if (fwrite(hdr, 1, sizeof(hdr), w->f) != sizeof(hdr) ||
+	    fwrite(w->payload, 1, len, w->f) != len)
+		w->err = 1;
+	w->bytes += sizeof(hdr) + len;
+	w->nr_rows = 0;
+}
+
+int sarc_append(sarc_writer_t *w, const sarc_row_t *row)
+{
+	w->rows[w->nr_rows++] = *row;
+	if (w->nr_rows == SARC_BLOCK_ROWS)
+		sarc_flush(w);
+	return w->err ? -1 : 0;
+}
+
+uint64_t sarc_bytes_written(const sarc_writer_t *w)
+{
+	return w->bytes;
+}
+
+int sarc_close(sarc_writer_t *w)
+{
+	uint8_t hdr[8] = { 'I', 'D', 'X', '2' };
+	uint8_t ent[SARC_BLOCK_INFO_LEN];
+	uint8_t trailer[12];
+	int err;
+
+	sarc_flush(w);
+	put_u32(&hdr[4], w->nr_blocks);
+	put_u64(trailer, w->bytes);
+	memcpy(&trailer[8], "SARC", 4);
+	if (fwrite(hdr, 1, sizeof(hdr), w->f) != sizeof(hdr))
+		w->err = 1;
+	for (uint32_t i = 0; i < w->nr_blocks; ++i) {
+		block_info_put(ent, &w->index[i]);
+		if (fwrite(ent, 1, sizeof(ent), w->f) != sizeof(ent))
+			w->err = 1;
+	}
+	if (fwrite(trailer, 1, sizeof(trailer), w->f) != sizeof(trailer))
+		w->err = 1;
+
+	err = w->err;
+	if (fclose(w->f) != 0)
+		err = 1;
+	free(w->index);
+	free(w);
+	return err ? -1 : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Reader
+
+/// Load the index from the end of the file; -1 if there is none
+static int sarc_load_index(sarc_reader_t *r)
+{
+	uint8_t trailer[12], hdr[8], ent[SARC_BLOCK_INFO_LEN];
+	uint64_t off;
+
+	if (fseeko(r->f, -(off_t)sizeof(trailer), SEEK_END) != 0 ||
+	    fread(trailer, 1, sizeof(trailer), r->f) != sizeof(trailer) ||
+	    memcmp(&trailer[8], "SARC", 4) != 0)
+		return -1;
+	off = get_u64(trailer);
+	if (fseeko(r->f, (off_t)off, SEEK_SET) != 0 ||
+	    fread(hdr, 1, sizeof(hdr), r->f) != sizeof(hdr) ||
+	    memcmp(hdr, "IDX2", 4) != 0)
+		return -1;
+	r->nr_blocks = get_u32(&hdr[4]);
+	r->index = calloc(r->nr_blocks ? r->nr_blocks : 1, sizeof(*r->index));
+	if (r->index == NULL)
+		return -1;
+	for (uint32_t i = 0; i < r->nr_blocks; ++i) {
+		if (fread(ent, 1, sizeof(ent), r->f) != sizeof(ent))
+			return -1;
+		sarc_block_info_get(ent, &r->index[i]);
+	}
+	return 0;
+}
+
+/// Rebuild the index by decoding every block (for an unfinished archive)
+static int sarc_walk(sarc_reader_t *r)
+{
+	uint32_t max = 0;
+	uint64_t off = 8;
+
+	free(r->index);
+	r->index = NULL;
+	r->nr_blocks = 0;
+	for (;;) {
+		uint8_t hdr[SARC_BLOCK_HDR_LEN];
+		sarc_block_info_t *bi;
+		uint32_t nr, len;
+
+		if (fseeko(r->f, (off_t)off, SEEK_SET) != 0 ||
+		    fread(hdr, 1, sizeof(hdr), r->f) != sizeof(hdr) ||
+		    memcmp(hdr, "BLK2", 4) != 0)
+			break;
+		nr = get_u32(&hdr[4]);
+		len = get_u32(&hdr[8]);
+		if (len > sizeof(r->payload) || fread(r->payload, 1, len, r->f) != len ||
+		    sarc_decode_block(r->payload, len, nr, r->rows) != 0)
+			break;
+		if (r->nr_blocks == max) {
+			max = max ? max * 2 : 256;
+			bi = realloc(r->index, max * sizeof(*r->index));
+			if (bi == NULL)
+				return -1;
+			r->index = bi;
+		}
+		bi = &r->index[r->nr_blocks++];
+		block_info_fill(bi, r->rows, nr);
+		bi->offset = off;
+		bi->payload_len = len;
+		off += sizeof(hdr) + len;
+	}
+	return 0;
+}
+
+sarc_reader_t *sarc_open(const char *path)
+{
+	sarc_reader_t *r = calloc(1, sizeof(*r));
+	uint8_t hdr[8];
+
+	if (r == NULL)
+		return NULL;
+	if ((r->f = fopen(path, "rb")) == NULL) {
+		free(r);
+		return NULL;
+	}
+	if (fread(hdr, 1, sizeof(hdr), r->f) != sizeof(hdr) ||
+	    memcmp(hdr, "SARC", 4) != 0 || hdr[4] != SARC_VERSION) {
+		fclose(r->f);
+		free(r);
+		errno = EINVAL;
+		return NULL;
+	}
+	if (sarc_load_index(r) != 0 && sarc_walk(r) != 0) {
+		sarc_close_reader(r);
+		errno = ENOMEM;
+		return NULL;
+	}
+	sarc_set_range(r, INT64_MIN, INT64_MAX);
+	return r;
+}
+
+uint32_t sarc_nr_blocks(const sarc_reader_t *r)
+{
+	return r->nr_blocks;
+}
+
+const sarc_block_info_t *sarc_block_info(const sarc_reader_t *r, uint32_t i)
+{
+	return i < r->nr_blocks ? &r->index[i] : NULL;
+}
+
+int sarc_read_block(sarc_reader_t *r, uint32_t i, sarc_row_t *rows)
+{
+	const sarc_block_info_t *bi = sarc_block_info(r, i);
+	uint8_t hdr[SARC_BLOCK_HDR_LEN];
+
+	if (bi == NULL || bi->payload_len > sizeof(r->payload))
+		return -1;
+	if (fseeko(r->f, (off_t)bi->offset, SEEK_SET) != 0 ||
+	    fread(hdr, 1, sizeof(hdr), r->f) != sizeof(hdr) ||
+	    memcmp(hdr, "BLK2", 4) != 0 ||
+	    get_u32(&hdr[4]) != bi->nr_rows || get_u32(&hdr[8]) != bi->payload_len ||
+	    fread(r->payload, 1, bi->payload_len, r->f) != bi->payload_len ||
+	    sarc_decode_block(r->payload, bi->payload_len, bi->nr_rows, rows) != 0)
+		return -1;
+	return (int)bi->nr_rows;
+}
+
+void sarc_set_range(sarc_reader_t *r, int64_t t_from, int64_t t_to)
+{
+	r->t_from = t_from;
+	r->t_to = t_to;
+	r->next_block = 0;
+	r->nr_rows = r->next_row = 0;
+	r->blocks_read = r->blocks_skipped = 0;
+}
+
+int sarc_next(sarc_reader_t *r, sarc_row_t *row)
+{
+	for (;;) {
+		while (r->next_row < r->nr_rows) {
+			const sarc_row_t *s = &r->rows[r->next_row++];
+
+			if (s->t_ms >= r->t_from && s->t_ms <= r->t_to) {
+				*row = *s;
+				return 1;
+			}
+		}
+		if (r->next_block == r->nr_blocks)
+			return 0;
+
+		const sarc_block_info_t *bi = &r->index[r->next_block];
+
+		if (bi->t_max < r->t_from || bi->t_min > r->t_to) {
+			++r->next_block;
+			++r->blocks_skipped;
+			continue;
+		}
+		r->nr_rows = sarc_read_block(r, r->next_block++, r->rows);
+		r->next_row = 0;
+		if (r->nr_rows < 0)
+			return -1;
+		++r->blocks_read;
+	}
+}
+
+void sarc_scan_stats(const sarc_reader_t *r, uint32_t *read, uint32_t *skipped)
+{
+	*read = r->blocks_read;
+	*skipped = r->blocks_skipped;
+}
+
+void sarc_close_reader(sarc_reader_t *r)
+{
+	fclose(r->f);
+	free(r->index);
+	free(r);
+}
@@ -0,0 +1,172 @@
+/**
+ * @file host/lib/sarc.h
+ * @brief Columnar archive of sensor rows (timestamp, position, PM channels)
+ *
+ * Rows are stored in blocks of up to SARC_BLOCK_ROWS. Within a block each
+ * column is stored on its own, with an encoding suited to it:
+ *
+ * - t_ms: delta-of-delta, bit-packed. A steady sampling rate costs one bit
+ *   per row; jitter costs 9 to 16 bits.
+ * - lat, lon: XOR with the previous value (Gorilla). An unchanged position
+ *   costs one bit; a change costs the bits between the leading and trailing
+ *   zeros of the XOR, and usually reuses the previous window.
+ * - pm[]: difference from the previous row, as a zig-zag varint; slowly
+ *   varying readings take one byte each.
+ *
+ * Blocks are independent. An index at the end of the file gives the offset,
+ * row count and the min/max of every column for each block, so a reader
+ * can skip blocks outside a time range (or a value range) without touching
+ * them. It also holds the PM sums, so a block that lies wholly inside a query
+ * contributes to a mean without being decoded.
+ *
+ * File layout (all integers little-endian; version 3):
+ *
+ *   header   "SARC" u8 version u8[3] 0
+ *   block    "BLK2" u32 nr_rows u32 payload_len payload
+ *   ...
+ *   index    "IDX2" u32 nr_blocks sarc_block_info_t[nr_blocks] (serialised)
+ *   trailer  u64 index_offset "SARC"
+ *
+ * The payload holds the column streams t_ms, lat, lon, pm[0] ... pm[11],
+ * each preceded by its length as a varint. An archive without its index (the
+ * writer did not finish) is still readable block by block from the start.
+ */
+
+#if !defined(SARC_H_)
+#define SARC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#define SARC_NR_PM		12
+#define SARC_BLOCK_ROWS		4096
+
+/// One row: a PMS reading with the GPS time and position it was taken at
+typedef struct sarc_row_type {
+	int64_t  t_ms;			///< UTC, ms since the epoch (0: unknown)
+	double   lat, lon;		///< Degrees, negative south/west (NAN: no fix)
+	uint16_t pm[SARC_NR_PM];	///< PMS channels, in pms_data_t order
+} sarc_row_t;
+
+/// Index entry of one block
+typedef struct sarc_block_info_type {
+	uint64_t offset;		///< File offset of the block header
+	uint32_t nr_rows;
+	uint32_t payload_len;
+	int64_t  t_min, t_max;
+	double   lat_min, lat_max;	///< NAN if no row of the block has a fix
+	double   lon_min, lon_max;
+	uint16_t pm_min[SARC_NR_PM];
+	uint16_t pm_max[SARC_NR_PM];
+	uint32_t nr_fix;		///< Rows with a position
+	uint64_t pm_sum[SARC_NR_PM];	///< For means without decoding
+} sarc_block_info_t;
+
+/// Size of a serialised sarc_block_info_t
+#define SARC_BLOCK_INFO_LEN	(8 + 4 + 4 + 2 * 8 + 4 * 8 + 2 * 2 * SARC_NR_PM + \
+				 4 + 8 * SARC_NR_PM)
+
+/// Size of a block header ("BLK2" nr_rows payload_len)
+#define SARC_BLOCK_HDR_LEN	12
+
+/// Columns of a block payload, in order, as bit numbers for sarc_decode_columns()
+#define SARC_COL_T		0
+#define SARC_COL_LAT		1
+#define SARC_COL_LON		2
+#define SARC_COL_PM(k)		(3 + (k))
+#define SARC_NR_COLS		(3 + SARC_NR_PM)
+
+typedef struct sarc_writer_type sarc_writer_t;
+typedef struct sarc_reader_type sarc_reader_t;
+
+/**
+ * Create (or truncate) an archive
+ *
+ * @return	The writer, or NULL on error (with errno set)
+ */
+sarc_writer_t *sarc_create(const char *path);
+
+/// Append one row; returns 0, or -1 on a write error
+int sarc_append(sarc_writer_t *w, const sarc_row_t *row);
+
+/// Flush the last block, write the index and close; 0, or -1 on a write error
+int sarc_close(sarc_writer_t *w);
+
+/// Bytes written so far (complete blocks only)
+uint64_t sarc_bytes_written(const sarc_writer_t *w);
+
+/**
+ * Decode a block payload
+ *
+ * @param	payload		The bytes after the block header
+ * @param	len		payload_len from the header
+ * @param	nr_rows		nr_rows from the header
+ * @param	rows		Room for nr_rows rows
+ *
+ * @return	0, or -1 if the payload is damaged
+ */
+int sarc_decode_block(const uint8_t *payload, size_t len, uint32_t nr_rows,
+		      sarc_row_t *rows);
+
+/**
+ * Decode some columns of a block payload
+ *
+ * The other columns are stepped over by their length and left untouched in
+ * @p rows.
+ *
+ * @param	cols	Bit mask of SARC_COL_* numbers
+ *
+ * @return	0, or -1 if the payload is damaged
+ */
+int sarc_decode_columns(const uint8_t *payload, size_t len, uint32_t nr_rows,
+			uint32_t cols, sarc_row_t *rows);
+
+/// Deserialise an index entry (SARC_BLOCK_INFO_LEN bytes)
+void sarc_block_info_get(const uint8_t *p, sarc_block_info_t *bi);
+
+/**
+ * Open an archive
+ *
+ * The index is loaded if present; otherwise the blocks are found by walking
+ * the file once.
+ *
+ * @return	The reader, or NULL on error (errno set; EINVAL if the file
+ *		is not an archive)
+ */
+sarc_reader_t *sarc_open(const char *path);
+
+uint32_t sarc_nr_blocks(const sarc_reader_t *r);
+
+const sarc_block_info_t *sarc_block_info(const sarc_reader_t *r, uint32_t i);
+
+/**
+ * Decode one block
+ *
+ * @param	rows	Room for SARC_BLOCK_ROWS rows
+ *
+ * @return	Number of rows, or -1 if the block is damaged
+ */
+int sarc_read_block(sarc_reader_t *r, uint32_t i, sarc_row_t *rows);
+
+/**
+ * Limit sarc_next() to rows with t_from <= t_ms <= t_to, and rewind
+ *
+ * Blocks whose time range does not overlap are skipped without being read.
+ */
+void sarc_set_range(sarc_reader_t *r, int64_t t_from, int64_t t_to);
+
+/**
+ * Read the next row (in the range set by sarc_set_range(), if any)
+ *
+ * @return	1 with @p row filled, 0 at the end, -1 if the file is damaged
+ */
+int sarc_next(sarc_reader_t *r, sarc_row_t *row);
+
+/// Blocks decoded and skipped by sarc_next() so far
+void sarc_scan_stats(const sarc_reader_t *r, uint32_t *read, uint32_t *skipped);
+
+void sarc_close_reader(sarc_reader_t *r);
+
+#endif // SARC_H_
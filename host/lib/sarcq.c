@@ -0,0 +1,355 @@
+/**
+ * @file host/lib/sarcq.c
+ * @brief Time-range and aggregate queries over memory-mapped archives
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sarcq.h"
+
+#define SARCQ_HIST_LEN	65536
+
+struct sarcq_type {
+	const uint8_t *base;
+	size_t   size;
+
+	// Sparse time index: the blocks sorted by t_min, and the running
+	// maximum of t_max in that order (non-decreasing, so searchable)
+	sarc_block_info_t *blocks;
+	int64_t *t_max_run;
+	uint32_t nr_blocks;
+	uint64_t nr_rows;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Aggregates
+
+void sarcq_query_init(sarcq_query_t *qq)
+{
+	memset(qq, 0, sizeof(*qq));
+	qq->t_from = INT64_MIN;
+	qq->t_to = INT64_MAX;
+}
+
+int sarcq_agg_init(sarcq_agg_t *a, bool percentiles)
+{
+	memset(a, 0, sizeof(*a));
+	a->min = UINT16_MAX;
+	if (percentiles && (a->hist = calloc(SARCQ_HIST_LEN, sizeof(*a->hist))) == NULL)
+		return -1;
+	return 0;
+}
+
+void sarcq_agg_free(sarcq_agg_t *a)
+{
+	free(a->hist);
+	a->hist = NULL;
+}
+
+double sarcq_agg_mean(const sarcq_agg_t *a)
+{
+	return a->count ? (double)a->sum / (double)a->count : NAN;
+}
+
+uint16_t sarcq_agg_percentile(const sarcq_agg_t *a, double p)
+{
+	uint64_t rank, seen = 0;
+
+	if (a->hist == NULL || a->count == 0)
+		return 0;
+	rank = (uint64_t)ceil(p / 100.0 * (double)a->count);
+	if (rank < 1)
+		rank = 1;
+	for (uint32_t v = 0; v < SARCQ_HIST_LEN; ++v) {
+		seen += a->hist[v];
+		if (seen >= rank)
+			return (uint16_t)v;
+	}
+	return a->max;
+}
+
+static void agg_add(sarcq_agg_t *a, uint16_t v, uint64_t n)
+{
+	a->count += n;
+	a->sum += (uint64_t)v * n;
+	if (v < a->min)
+		a->min = v;
+	if (v > a->max)
+		a->max = v;
+	if (a->hist != NULL)
+		a->hist[v] += n;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Mapping
+
+static int cmp_t_min(const void *a, const void *b)
+{
+	const sarc_block_info_t *x = a, *y = b;
+
+	if (x->t_min != y->t_min)
+		return x->t_min < y->t_min ? -1 : 1;
+	return x->offset < y->offset ? -1 : x->offset > y->offset;
+}
+
+sarcq_t *sarcq_open(const char *path)
+{
+	sarcq_t *q = calloc(1, sizeof(*q));
+	sarc_reader_t *r;
+	struct stat sb;
+	int fd;
+
+	if (q == NULL)
+		return NULL;
+
+	// The reader finds the index (or rebuilds it); keep a copy
+	if ((r = sarc_open(path)) == NULL) {
+		free(q);
+		return NULL;
+	}
+	q->nr_blocks = sarc_nr_blocks(r);
+	q->blocks = malloc((q->nr_blocks ? q->nr_blocks : 1) * sizeof(*q->blocks));
+	q->t_max_run = malloc((q->nr_blocks ? q->nr_blocks : 1) * sizeof(*q->t_max_run));
+	if (q->blocks == NULL || q->t_max_run == NULL) {
+		sarc_close_reader(r);
+		sarcq_close(q);
+		errno = ENOMEM;
+		return NULL;
+	}
+	for (uint32_t i = 0; i < q->nr_blocks; ++i) {
+		q->blocks[i] = *sarc_block_info(r, i);
+		q->nr_rows += q->blocks[i].nr_rows;
+	}
+	sarc_close_reader(r);
+
+	qsort(q->blocks, q->nr_blocks, sizeof(*q->blocks), cmp_t_min);
+	for (uint32_t i = 0; i < q->nr_blocks; ++i) {
+		int64_t t = q->blocks[i].t_max;
+
+		q->t_max_run[i] = i > 0 && q->t_max_run[i - 1] > t ? q->t_max_run[i - 1] : t;
+	}
+
+	if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &sb) != 0) {
+		if (fd >= 0)
+			close(fd);
+		sarcq_close(q);
+		return NULL;
+	}
+	q->size = (size_t)sb.st_size;
+	q->base = mmap(NULL, q->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (q->base == MAP_FAILED) {
+		q->base = NULL;
+		sarcq_close(q);
+		return NULL;
+	}
+	// Queries jump from block to block
+	madvise((void *)q->base, q->size, MADV_RANDOM);
+
+	for (uint32_t i = 0; i < q->nr_blocks; ++i) {
+		const sarc_block_info_t *bi = &q->blocks[i];
+
+		if (bi->offset + SARC_BLOCK_HDR_LEN + bi->payload_len > q->size) {
+			sarcq_close(q);
+			errno = EINVAL;
+			return NULL;
+		}
+	}
+	return q;
+}
+
+void sarcq_close(sarcq_t *q)
+{
+	if (q->base != NULL)
+		munmap((void *)q->base, q->size);
+	free(q->blocks);
+	free(q->t_max_run);
+	free(q);
+}
+
+uint32_t sarcq_nr_blocks(const sarcq_t *q)
+{
+	return q->nr_blocks;
+}
+
+uint64_t sarcq_nr_rows(const sarcq_t *q)
+{
+	return q->nr_rows;
+}
+
+void sarcq_time_span(const sarcq_t *q, int64_t *t_min, int64_t *t_max)
+{
+	*t_min = q->nr_blocks ? q->blocks[0].t_min : 0;
+	*t_max = q->nr_blocks ? q->t_max_run[q->nr_blocks - 1] : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Queries
+
+/// Blocks [*lo, *hi) of the sorted index that can overlap [t_from, t_to]
+static void time_candidates(const sarcq_t *q, const sarcq_query_t *qq,
+			    uint32_t *lo, uint32_t *hi)
+{
+	uint32_t a = 0, b = q->nr_blocks;
+
+	// First block whose running t_max reaches t_from
+	while (a < b) {
+		uint32_t m = a + (b - a) / 2;
+
+		if (q->t_max_run[m] < qq->t_from)
+			a = m + 1;
+		else
+			b = m;
+	}
+	*lo = a;
+
+	// First block that starts after t_to
+	b = q->nr_blocks;
+	while (a < b) {
+		uint32_t m = a + (b - a) / 2;
+
+		if (q->blocks[m].t_min <= qq->t_to)
+			a = m + 1;
+		else
+			b = m;
+	}
+	*hi = a;
+}
+
+typedef enum {
+	BLOCK_OUTSIDE,
+	BLOCK_PARTIAL,
+	BLOCK_INSIDE,
+} block_cover_t;
+
+static block_cover_t block_cover(const sarc_block_info_t *bi, const sarcq_query_t *qq,
+				 bool *time_partial, bool *box_partial)
+{
+	if (bi->t_max < qq->t_from || bi->t_min > qq->t_to)
+		return BLOCK_OUTSIDE;
+	*time_partial = bi->t_min < qq->t_from || bi->t_max > qq->t_to;
+	*box_partial = false;
+	if (qq->bbox) {
+		if (bi->nr_fix == 0 ||
+		    bi->lat_max < qq->lat_min || bi->lat_min > qq->lat_max ||
+		    bi->lon_max < qq->lon_min || bi->lon_min > qq->lon_max)
+			return BLOCK_OUTSIDE;
+		*box_partial = bi->nr_fix != bi->nr_rows ||
+			       bi->lat_min < qq->lat_min || bi->lat_max > qq->lat_max ||
+			       bi->lon_min < qq->lon_min || bi->lon_max > qq->lon_max;
+	}
+	return *time_partial || *box_partial ? BLOCK_PARTIAL : BLOCK_INSIDE;
+}
+
+static bool row_selected(const sarc_row_t *row, const sarcq_query_t *qq,
+			 bool time_partial, bool box_partial)
+{
+	if (time_partial && (row->t_ms < qq->t_from || row->t_ms > qq->t_to))
+		return false;
+	// A NAN latitude fails both comparisons
+	if (box_partial && !(row->lat >= qq->lat_min && row->lat <= qq->lat_max &&
+			     row->lon >= qq->lon_min && row->lon <= qq->lon_max))
+		return false;
+	return true;
+}
+
+static int decode(const sarcq_t *q, const sarc_block_info_t *bi, uint32_t cols,
+		  sarc_row_t *rows)
+{
+	return sarc_decode_columns(q->base + bi->offset + SARC_BLOCK_HDR_LEN,
+				   bi->payload_len, bi->nr_rows, cols, rows);
+}
+
+int sarcq_aggregate(const sarcq_t *q, const sarcq_query_t *qq, int k, sarcq_agg_t *a)
+{
+	sarc_row_t *rows = NULL;
+	uint32_t lo, hi;
+	int res = 0;
+
+	time_candidates(q, qq, &lo, &hi);
+	a->blocks_skipped += q->nr_blocks - (hi - lo);
+
+	for (uint32_t i = lo; i < hi && res == 0; ++i) {
+		const sarc_block_info_t *bi = &q->blocks[i];
+		bool time_partial, box_partial;
+		uint32_t cols = 1u << SARC_COL_PM(k);
+
+		switch (block_cover(bi, qq, &time_partial, &box_partial)) {
+		case BLOCK_OUTSIDE:
+			++a->blocks_skipped;
+			continue;
+		case BLOCK_INSIDE:
+			if (a->hist == NULL) {
+				a->count += bi->nr_rows;
+				a->sum += bi->pm_sum[k];
+				if (bi->pm_min[k] < a->min)
+					a->min = bi->pm_min[k];
+				if (bi->pm_max[k] > a->max)
+					a->max = bi->pm_max[k];
+				++a->blocks_indexed;
+				continue;
+			}
+			if (bi->pm_min[k] == bi->pm_max[k]) {
+				agg_add(a, bi->pm_min[k], bi->nr_rows);
+				++a->blocks_indexed;
+				continue;
+			}
+			break;
+		case BLOCK_PARTIAL:
+			break;
+		}
+
+		if (rows == NULL && (rows = malloc(SARC_BLOCK_ROWS * sizeof(*rows))) == NULL)
+			return -1;
+		if (time_partial)
+			cols |= 1u << SARC_COL_T;
+		if (box_partial)
+			cols |= (1u << SARC_COL_LAT) | (1u << SARC_COL_LON);
+		if (decode(q, bi, cols, rows) != 0) {
+			res = -1;
+			break;
+		}
+		++a->blocks_decoded;
+		for (uint32_t j = 0; j < bi->nr_rows; ++j)
+			if (row_selected(&rows[j], qq, time_partial, box_partial))
+				agg_add(a, rows[j].pm[k], 1);
+	}
+	free(rows);
+	return res;
+}
+
+int sarcq_scan(const sarcq_t *q, const sarcq_query_t *qq,
+	       int (*fn)(void *user, const sarc_row_t *row), void *user)
+{
+	sarc_row_t *rows = malloc(SARC_BLOCK_ROWS * sizeof(*rows));
+	uint32_t lo, hi;
+	int res = 0;
+
+	if (rows == NULL)
+		return -1;
+	time_candidates(q, qq, &lo, &hi);
+	for (uint32_t i = lo; i < hi && res == 0; ++i) {
+		const sarc_block_info_t *bi = &q->blocks[i];
+		bool time_partial, box_partial;
+
+		if (block_cover(bi, qq, &time_partial, &box_partial) == BLOCK_OUTSIDE)
+			continue;
+		if (decode(q, bi, (1u << SARC_NR_COLS) - 1, rows) != 0) {
+			res = -1;
+			break;
+		}
+		for (uint32_t j = 0; j < bi->nr_rows && res == 0; ++j)
+			if (row_selected(&rows[j], qq, time_partial, box_partial))
+				res = fn(user, &rows[j]);
+	}
+	free(rows);
+	return res;
+}
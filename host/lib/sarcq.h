@@ -0,0 +1,103 @@
+/**
+ * @file host/lib/sarcq.h
+ * @brief Time-range and aggregate queries over memory-mapped archives
+ *
+ * An archive (host/lib/sarc.h) is mapped whole and its block index is sorted
+ * by start time into a sparse time index: with the running maximum of the
+ * block end times, the blocks a time range can touch are found by two
+ * binary searches, and all the others are never looked at.
+ *
+ * Of the blocks in range:
+ *
+ * - a block that lies wholly inside the query adds its index statistics
+ *   (count, sum, min, max) to an aggregate without being decoded;
+ * - a block at the edge of the query has only the columns the query needs
+ *   decoded: the time and position columns to filter on, and the one PM
+ *   channel being aggregated.
+ *
+ * Percentiles need every value, so with them a block in range always has
+ * its PM column decoded (unless the index shows it holds a single value);
+ * the values go into a 65536-bucket histogram, which gives exact results.
+ */
+
+#if !defined(SARCQ_H_)
+#define SARCQ_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sarc.h"
+
+typedef struct sarcq_type sarcq_t;
+
+/// Rows a query selects
+typedef struct sarcq_query_type {
+	int64_t t_from, t_to;		///< Inclusive, ms since the epoch
+	bool    bbox;			///< Also limit to the box below (rows with a fix)
+	double  lat_min, lat_max;
+	double  lon_min, lon_max;
+} sarcq_query_t;
+
+/// Running aggregate of one PM channel, over one or more archives
+typedef struct sarcq_agg_type {
+	uint64_t count, sum;
+	uint16_t min, max;
+	uint64_t *hist;			///< 65536 counts, or NULL: no percentiles
+
+	// Work done
+	uint64_t blocks_skipped;	///< Not touched at all
+	uint64_t blocks_indexed;	///< Answered from the index
+	uint64_t blocks_decoded;
+} sarcq_agg_t;
+
+/// Select every row
+void sarcq_query_init(sarcq_query_t *qq);
+
+/// Clear an aggregate; 0, or -1 if the histogram cannot be allocated
+int sarcq_agg_init(sarcq_agg_t *a, bool percentiles);
+
+void sarcq_agg_free(sarcq_agg_t *a);
+
+double sarcq_agg_mean(const sarcq_agg_t *a);
+
+/// Nearest-rank percentile (0 < p <= 100); needs the histogram
+uint16_t sarcq_agg_percentile(const sarcq_agg_t *a, double p);
+
+/**
+ * Map an archive
+ *
+ * Unfinished archives (without an index) are indexed by walking them once.
+ *
+ * @return	The archive, or NULL on error (errno set; EINVAL if the file
+ *		is not an archive)
+ */
+sarcq_t *sarcq_open(const char *path);
+
+void sarcq_close(sarcq_t *q);
+
+uint32_t sarcq_nr_blocks(const sarcq_t *q);
+
+uint64_t sarcq_nr_rows(const sarcq_t *q);
+
+/// Earliest and latest timestamps (0 and 0 if the archive is empty)
+void sarcq_time_span(const sarcq_t *q, int64_t *t_min, int64_t *t_max);
+
+/**
+ * Add PM channel @p k of the rows selected by @p qq to @p a
+ *
+ * Thread-safe: any number of queries can run on one archive at a time.
+ *
+ * @return	0, or -1 if a block is damaged or out of memory
+ */
+int sarcq_aggregate(const sarcq_t *q, const sarcq_query_t *qq, int k, sarcq_agg_t *a);
+
+/**
+ * Call @p fn for every row selected by @p qq, block by block in time order
+ *
+ * @return	0, the first non-zero value @p fn returned, or -1 if a block is
+ *		damaged or out of memory
+ */
+int sarcq_scan(const sarcq_t *q, const sarcq_query_t *qq,
+	       int (*fn)(void *user, const sarc_row_t *row), void *user);
+
+#endif // SARCQ_H_
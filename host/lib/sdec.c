@@ -0,0 +1,178 @@
+/**
+ * @file host/lib/sdec.c
+ * @brief Streaming decoder of the board's port into archive rows
+ */
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sdec.h"
+
+void sdec_init(sdec_t *d)
+{
+	memset(d, 0, sizeof(*d));
+	nmea_sentence_init(&d->nmea);
+	pms_parser_init(&d->pms);
+	d->lat = d->lon = NAN;
+}
+
+void sdec_resync(sdec_t *d)
+{
+	nmea_sentence_init(&d->nmea);
+	pms_parser_init(&d->pms);
+	d->lat = d->lon = NAN;
+}
+
+/// "$" and a five-letter address: a sentence, not a '$' in binary PMS data
+static bool looks_like_sentence(const char *s)
+{
+	for (int i = 1; i <= 5; ++i)
+		if (!((s[i] >= 'A' && s[i] <= 'Z') || (s[i] >= '0' && s[i] <= '9')))
+			return false;
+	return s[6] == ',';
+}
+
+bool sdec_nmea_checksum_ok(const char *s)
+{
+	uint8_t sum = 0;
+	const char *p = s + 1;
+	unsigned v;
+
+	if (s[0] != '$')
+		return false;
+	while (*p && *p != '*')
+		sum ^= (uint8_t)*p++;
+	return *p == '*' && sscanf(p + 1, "%2x", &v) == 1 && v == sum;
+}
+
+double sdec_nmea_coord(const char *s, size_t len, int deg_digits, char hemi)
+{
+	char buf[24];
+	double v = 0;
+
+	if (len <= (size_t)deg_digits || len >= sizeof(buf) || hemi == '\0')
+		return NAN;
+	for (int i = 0; i < deg_digits; ++i) {
+		if (s[i] < '0' || s[i] > '9')
+			return NAN;
+		v = v * 10 + (s[i] - '0');
+	}
+	memcpy(buf, s + deg_digits, len - deg_digits);
+	buf[len - deg_digits] = '\0';
+	v += strtod(buf, NULL) / 60.0;
+	return hemi == 'S' || hemi == 'W' ? -v : v;
+}
+
+bool sdec_nmea_fix(const char *s, size_t len, sdec_fix_t *fx)
+{
+	const char *f[16], *end, *p = s + 1;
+	size_t fl[16];
+	int nf = 0;
+	int lat;	// Field of the latitude; hemisphere and longitude follow
+
+	if (len < 7)
+		return false;
+	if ((end = memchr(s, '*', len)) == NULL)
+		end = s + len;
+	while (nf < 16) {
+		const char *c = memchr(p, ',', (size_t)(end - p));
+
+		f[nf] = p;
+		fl[nf] = (size_t)((c ? c : end) - p);
+		++nf;
+		if (c == NULL)
+			break;
+		p = c + 1;
+	}
+	if (fl[0] != 5 || nf < 7)
+		return false;
+
+	memset(fx, 0, sizeof(*fx));
+	memcpy(fx->type, f[0] + 2, 3);
+	if (strcmp(fx->type, "RMC") == 0) {
+		fx->valid = fl[2] > 0 && f[2][0] == 'A';
+		fx->tod = f[1];
+		fx->tod_len = fl[1];
+		if (nf >= 10) {
+			fx->date = f[9];
+			fx->date_len = fl[9];
+		}
+		lat = 3;
+	} else if (strcmp(fx->type, "GGA") == 0) {
+		fx->valid = fl[6] > 0 && f[6][0] >= '1' && f[6][0] <= '8';
+		fx->tod = f[1];
+		fx->tod_len = fl[1];
+		lat = 2;
+	} else if (strcmp(fx->type, "GLL") == 0) {
+		fx->valid = fl[6] > 0 && f[6][0] == 'A';
+		fx->tod = f[5];
+		fx->tod_len = fl[5];
+		lat = 1;
+	} else {
+		return false;
+	}
+
+	fx->lat = fx->lon = NAN;
+	if (fx->valid) {
+		fx->lat = sdec_nmea_coord(f[lat], fl[lat], 2, fl[lat + 1] ? f[lat + 1][0] : '\0');
+		fx->lon = sdec_nmea_coord(f[lat + 2], fl[lat + 2], 3, fl[lat + 3] ? f[lat + 3][0] : '\0');
+		if (isnan(fx->lat) || isnan(fx->lon))
+			fx->lat = fx->lon = NAN;
+	}
+	return true;
+}
+
+void sdec_feed(sdec_t *d, const uint8_t *buf, size_t len, int64_t t_ms,
+	       sdec_row_fn fn, void *user)
+{
+	pms_data_t pm;
+	sarc_row_t row;
+
+	d->bytes += len;
+	for (size_t i = 0; i < len; ++i) {
+		const char *s = nmea_sentence_feed(&d->nmea, (char)buf[i]);
+		pms_parser_status_t st;
+
+		if (s && looks_like_sentence(s)) {
+			sdec_fix_t fx;
+
+			if (sdec_nmea_checksum_ok(s)) {
+				++d->nmea_ok;
+				if (sdec_nmea_fix(s, strlen(s), &fx)) {
+					d->lat = fx.lat;
+					d->lon = fx.lon;
+				}
+			} else {
+				++d->nmea_bad;
+			}
+		}
+
+		st = pms_parser_feed_byte(NULL, &d->pms, buf[i], &pm);
+		if (st == PMS_PARSER_OK) {
+			++d->pms_ok;
+			row.t_ms = t_ms;
+			row.lat = d->lat;
+			row.lon = d->lon;
+			row.pm[0] = pm.pm1_0_std;
+			row.pm[1] = pm.pm2_5_std;
+			row.pm[2] = pm.pm10_std;
+			row.pm[3] = pm.pm1_0_atm;
+			row.pm[4] = pm.pm2_5_atm;
+			row.pm[5] = pm.pm10_atm;
+			row.pm[6] = pm.particles_0_3um;
+			row.pm[7] = pm.particles_0_5um;
+			row.pm[8] = pm.particles_1_0um;
+			row.pm[9] = pm.particles_2_5um;
+			row.pm[10] = pm.particles_5_0um;
+			row.pm[11] = pm.particles_10um;
+			fn(user, &row);
+		} else if (st == PMS_PARSER_CHECKSUM_ERROR ||
+			   st == PMS_PARSER_INVALID_LENGTH ||
+			   st == PMS_PARSER_BUFFER_OVERFLOW) {
+			++d->pms_bad;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+/**
+ * @file host/lib/sdec.h
+ * @brief Streaming decoder of the board's port into archive rows
+ *
+ * Turns the byte stream of one unit (the board's CDC port, or a sensor
+ * wired straight to a UART adapter) into sarc_row_t rows, a chunk at a
+ * time, with no limit on how the stream is cut into chunks. Every byte goes
+ * through the firmware's own decoders: the NMEA sentence assembler
+ * (src/parsers/nmea_parse.c) and the PMS frame parser
+ * (src/parsers/pms_parser.c). Sentences must pass their XOR checksum; RMC,
+ * GGA and GLL sentences from any talker update the position. Each PMS frame
+ * becomes a row carrying the position last reported, and the time the
+ * caller gives for the chunk the frame ended in.
+ *
+ * The text lines and the "[GPS RAW]" / "[PM RAW]" tags the board adds are
+ * ignored by both decoders, so board output and raw sensor output decode
+ * alike.
+ *
+ * The NMEA helpers below (checksum, coordinates, the position fields of a
+ * sentence) are the ones the decoder uses; the host tools that look at
+ * sentences on their own use them too.
+ */
+
+#if !defined(SDEC_H_)
+#define SDEC_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "parsers/nmea_parser.h"
+#include "parsers/pms_parser.h"
+#include "sarc.h"
+
+/// Decoder of one stream
+typedef struct sdec_type {
+	nmea_sentence_state_t       nmea;
+	pms_parser_internal_state_t pms;
+	double lat, lon;		///< Last position (NAN: no fix yet, or lost)
+
+	// Counters
+	uint64_t bytes;
+	uint64_t nmea_ok, nmea_bad;	///< Sentences, by checksum ('$' bytes in
+					///< binary data are not counted)
+	uint64_t pms_ok, pms_bad;	///< Frames, by the parser's verdict
+} sdec_t;
+
+typedef void (*sdec_row_fn)(void *user, const sarc_row_t *row);
+
+void sdec_init(sdec_t *d);
+
+/// Start over after a gap in the stream: forget a partial sentence or frame
+/// and the position; the counters carry on
+void sdec_resync(sdec_t *d);
+
+/// Decode a chunk; @p fn gets one row, stamped @p t_ms, per PMS frame
+void sdec_feed(sdec_t *d, const uint8_t *buf, size_t len, int64_t t_ms,
+	       sdec_row_fn fn, void *user);
+
+/// Position fields of one RMC, GGA or GLL sentence (any talker)
+typedef struct sdec_fix_type {
+	char        type[4];	///< "RMC", "GGA" or "GLL"
+	bool        valid;	///< The receiver reported a fix
+	double      lat, lon;	///< Signed degrees; NAN without a well-formed fix
+	const char *tod;	///< "hhmmss[.sss]" field, pointing into the sentence
+	size_t      tod_len;
+	const char *date;	///< RMC "ddmmyy" field; NULL for the others
+	size_t      date_len;
+} sdec_fix_t;
+
+/// '$...*hh' with a matching XOR checksum
+bool sdec_nmea_checksum_ok(const char *s);
+
+/// "(d)ddmm.mmmm" (@p len bytes, not terminated) and hemisphere to signed
+/// degrees; NAN if malformed
+double sdec_nmea_coord(const char *s, size_t len, int deg_digits, char hemi);
+
+/// Split sentence @p s (@p len bytes, checksum optional) into @p fx; false
+/// if it is not an RMC, GGA or GLL sentence
+bool sdec_nmea_fix(const char *s, size_t len, sdec_fix_t *fx);
+
+#endif // SDEC_H_
@@ -0,0 +1,474 @@
+/**
+ * @file host/lib/sgen.c
+ * @brief Synthetic GPS receiver and PMS5003 output
+ *
+ * See sgen.h. Distances are small enough for a flat-earth approximation
+ * around the current position. The position error is a first-order
+ * Gauss-Markov process per axis, so consecutive fixes wander together as a
+ * receiver's do instead of jumping independently. Loss of fix is a
+ * two-state Markov chain whose outages last ten seconds on average.
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sgen.h"
+
+#define M_PER_DEG	111320.0	// Metres per degree of latitude
+#define ERR_TAU_S	60.0		// Correlation time of the position error
+#define TURN_SD		0.3		// Random-walk heading change, rad per sqrt(s)
+#define OUTAGE_S	10.0		// Mean length of a loss of fix
+#define EPISODE_TAU_S	90.0		// Decay of a traffic episode
+#define LOCAL_UTC_H	8		// The rush hours are local (Philippine) time
+
+void sgen_cfg_default(sgen_cfg_t *c)
+{
+	memset(c, 0, sizeof(*c));
+	c->seed = 0x2545F491;
+	c->t0_ms = (int64_t)time(NULL) * 1000;
+	c->gps_hz = 1;
+	c->sentences = SGEN_RMC | SGEN_GGA | SGEN_GLL;
+	strcpy(c->talker, "GP");
+	c->nr_sats = 10;
+	c->noise_m = 2.5;
+	c->lat0 = 14.6537;
+	c->lon0 = 121.0687;
+	c->radius_m = 1000;
+	c->speed_mps = 1.4;
+	c->pm_hz = 1;
+	c->profile = SGEN_PM_CONST;
+	c->pm_base = 25;
+	c->pm_peak = 150;
+	c->pm_noise = 0.05;
+	c->episodes_h = 6;
+	c->duration_s = 3600;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// xorshift32
+static uint32_t rng_next(sgen_t *g)
+{
+	uint32_t x = g->rng;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	g->rng = x;
+	return x;
+}
+
+// Uniform on (0, 1)
+static double uniform(sgen_t *g)
+{
+	return (rng_next(g) + 0.5) / 4294967296.0;
+}
+
+// Standard normal (Box-Muller)
+static double gauss(sgen_t *g)
+{
+	return sqrt(-2 * log(uniform(g))) * cos(2 * M_PI * uniform(g));
+}
+
+void sgen_init(sgen_t *g, const sgen_cfg_t *c)
+{
+	memset(g, 0, sizeof(*g));
+	g->c = *c;
+	g->rng = c->seed ? c->seed : 1;
+	if (g->c.nr_sats > 16)
+		g->c.nr_sats = 16;
+	g->dir = 1;
+	g->fix = c->no_fix < 1;
+	if (c->route != NULL && c->nr_route > 0) {
+		g->lat = c->route[0].lat;
+		g->lon = c->route[0].lon;
+		g->leg = c->nr_route > 1 ? 1 : 0;
+	} else {
+		g->lat = c->lat0;
+		g->lon = c->lon0;
+		g->heading = uniform(g) * 2 * M_PI;
+	}
+
+	// Satellites in view: distinct PRNs scattered over the sky
+	for (unsigned i = 0; i < g->c.nr_sats; ++i) {
+		uint8_t prn;
+		bool dup;
+
+		do {
+			prn = (uint8_t)(1 + rng_next(g) % 32);
+			dup = false;
+			for (unsigned k = 0; k < i; ++k)
+				dup |= g->sat_prn[k] == prn;
+		} while (dup);
+		g->sat_prn[i] = prn;
+		g->sat_el[i] = 5 + uniform(g) * 80;
+		g->sat_az[i] = uniform(g) * 360;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Route
+
+static double dist_m(double lat1, double lon1, double lat2, double lon2)
+{
+	double dn = (lat2 - lat1) * M_PER_DEG;
+	double de = (lon2 - lon1) * M_PER_DEG * cos(lat1 * M_PI / 180);
+
+	return sqrt(dn * dn + de * de);
+}
+
+static void step(sgen_t *g, double d, double heading)
+{
+	g->lat += d * cos(heading) / M_PER_DEG;
+	g->lon += d * sin(heading) / (M_PER_DEG * cos(g->lat * M_PI / 180));
+}
+
+static void walk_random(sgen_t *g, double h)
+{
+	double away = dist_m(g->c.lat0, g->c.lon0, g->lat, g->lon);
+
+	g->heading += TURN_SD * sqrt(h) * gauss(g);
+	if (away > g->c.radius_m) {
+		// Head back towards the start
+		double dn = (g->c.lat0 - g->lat) * M_PER_DEG;
+		double de = (g->c.lon0 - g->lon) * M_PER_DEG * cos(g->lat * M_PI / 180);
+
+		g->heading = atan2(de, dn) + 0.3 * gauss(g);
+	}
+	step(g, g->c.speed_mps * h, g->heading);
+}
+
+static void walk_route(sgen_t *g, double h)
+{
+	const sgen_point_t *r = g->c.route;
+	size_t nr = g->c.nr_route;
+	double d = g->c.speed_mps * h;
+
+	// Bounded, so a route of identical points cannot spin
+	for (size_t k = 0; d > 0 && nr > 1 && k < 2 * nr; ++k) {
+		const sgen_point_t *p = &r[g->leg];
+		double left = dist_m(g->lat, g->lon, p->lat, p->lon);
+
+		if (left <= d) {
+			g->lat = p->lat;
+			g->lon = p->lon;
+			d -= left;
+			if (g->c.pingpong) {
+				if (g->leg + g->dir >= nr || (g->dir < 0 && g->leg == 0))
+					g->dir = -g->dir;
+				g->leg += g->dir;
+			} else {
+				g->leg = (g->leg + 1) % nr;
+			}
+			continue;
+		}
+		g->heading = atan2((p->lon - g->lon) * cos(g->lat * M_PI / 180),
+				   p->lat - g->lat);
+		step(g, d, g->heading);
+		d = 0;
+	}
+}
+
+// Move the unit forward to @p t_us; earlier times leave it where it is
+static void advance(sgen_t *g, uint64_t t_us)
+{
+	double dt;
+
+	if (t_us <= g->t_us)
+		return;
+	dt = (t_us - g->t_us) / 1e6;
+	while (dt > 0) {
+		double h = dt > 1 ? 1 : dt;
+		double a = exp(-h / ERR_TAU_S), s = sqrt(1 - a * a) * g->c.noise_m;
+
+		if (g->c.route != NULL)
+			walk_route(g, h);
+		else
+			walk_random(g, h);
+		g->err_n = a * g->err_n + s * gauss(g);
+		g->err_e = a * g->err_e + s * gauss(g);
+		dt -= h;
+	}
+	g->t_us = t_us;
+}
+
+void sgen_position(const sgen_t *g, double *lat, double *lon)
+{
+	*lat = g->lat;
+	*lon = g->lon;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// NMEA
+
+// Append "$<talker><body>*CS\r\n"
+static size_t put(sgen_t *g, char *out, size_t size, const char *body)
+{
+	uint8_t sum = 0;
+	int n;
+
+	for (const char *c = g->c.talker; *c; ++c)
+		sum ^= (uint8_t)*c;
+	for (const char *c = body; *c; ++c)
+		sum ^= (uint8_t)*c;
+	n = snprintf(out, size, "$%s%s*%02X\r\n", g->c.talker, body, sum);
+	return (n < 0 || (size_t)n >= size) ? 0 : (size_t)n;
+}
+
+static void fmt_coord(char *out, size_t size, double v, int deg_digits, char pos, char neg)
+{
+	double a = fabs(v);
+	int d = (int)a;
+	double m = (a - d) * 60;
+
+	// Rounding to 5 decimals can carry into the degrees
+	if (m >= 59.999995) {
+		m = 0;
+		++d;
+	}
+	snprintf(out, size, "%0*d%08.5f,%c", deg_digits, d, m, v < 0 ? neg : pos);
+}
+
+size_t sgen_gps_epoch(sgen_t *g, uint64_t n, char *buf, size_t size)
+{
+	uint64_t t_us = (uint64_t)(n * 1e6 / g->c.gps_hz);
+	int64_t t_ms = g->c.t0_ms + (int64_t)(t_us / 1000);
+	time_t secs = (time_t)(t_ms / 1000);
+	char hms[32], date[32], lat[24], lon[24], body[160];
+	double flat, flon, hdop, p_regain, p_lose;
+	unsigned used = 0;
+	struct tm tm;
+	size_t len = 0;
+
+	advance(g, t_us);
+
+	// Fix state: outages of OUTAGE_S on average, no_fix of the time
+	p_regain = 1 / (OUTAGE_S * g->c.gps_hz);
+	p_lose = g->c.no_fix < 1 ? p_regain * g->c.no_fix / (1 - g->c.no_fix) : 1;
+	if (g->fix)
+		g->fix = uniform(g) >= p_lose;
+	else
+		g->fix = g->c.no_fix < 1 && uniform(g) < p_regain;
+
+	gmtime_r(&secs, &tm);
+	snprintf(hms, sizeof(hms), "%02d%02d%02d.%02d", tm.tm_hour, tm.tm_min,
+		 tm.tm_sec, (int)(t_ms % 1000) / 10);
+	snprintf(date, sizeof(date), "%02d%02d%02d", tm.tm_mday, tm.tm_mon + 1,
+		 tm.tm_year % 100);
+	flat = g->lat + g->err_n / M_PER_DEG;
+	flon = g->lon + g->err_e / (M_PER_DEG * cos(g->lat * M_PI / 180));
+	fmt_coord(lat, sizeof(lat), flat, 2, 'N', 'S');
+	fmt_coord(lon, sizeof(lon), flon, 3, 'E', 'W');
+	for (unsigned i = 0; i < g->c.nr_sats; ++i) {
+		used += g->sat_el[i] > 10;
+		g->sat_az[i] = fmod(g->sat_az[i] + 0.5 / 60 / g->c.gps_hz, 360);
+	}
+	hdop = used ? 0.6 + 4.0 / used : 99.99;
+
+	if (g->c.sentences & SGEN_RMC) {
+		if (g->fix)
+			snprintf(body, sizeof(body), "RMC,%s,A,%s,%s,%.1f,%.1f,%s,,,A", hms,
+				 lat, lon, g->c.speed_mps * 1.943844,
+				 fmod(g->heading * 180 / M_PI + 360, 360), date);
+		else
+			snprintf(body, sizeof(body), "RMC,%s,V,,,,,,,%s,,,N", hms, date);
+		len += put(g, buf + len, size - len, body);
+	}
+	if (g->c.sentences & SGEN_GGA) {
+		if (g->fix)
+			snprintf(body, sizeof(body), "GGA,%s,%s,%s,1,%02u,%.2f,%.1f,M,46.9,M,,",
+				 hms, lat, lon, used, hdop, 45 + g->err_n);
+		else
+			snprintf(body, sizeof(body), "GGA,%s,,,,,0,00,99.99,,,,,,", hms);
+		len += put(g, buf + len, size - len, body);
+	}
+	if (g->c.sentences & SGEN_GLL) {
+		if (g->fix)
+			snprintf(body, sizeof(body), "GLL,%s,%s,%s,A,A", lat, lon, hms);
+		else
+			snprintf(body, sizeof(body), "GLL,,,,,%s,V,N", hms);
+		len += put(g, buf + len, size - len, body);
+	}
+	if ((g->c.sentences & SGEN_GSV) && g->c.nr_sats > 0) {
+		unsigned msgs = (g->c.nr_sats + 3) / 4;
+
+		for (unsigned m = 0; m < msgs; ++m) {
+			int o = snprintf(body, sizeof(body), "GSV,%u,%u,%02u", msgs, m + 1,
+					 g->c.nr_sats);
+
+			for (unsigned i = 4 * m; i < 4 * m + 4 && i < g->c.nr_sats; ++i) {
+				int snr = (int)(20 + g->sat_el[i] / 4 + 2 * gauss(g));
+
+				if (g->fix)
+					o += snprintf(body + o, sizeof(body) - o, ",%02u,%02d,%03d,%02d",
+						      g->sat_prn[i], (int)g->sat_el[i],
+						      (int)g->sat_az[i], snr < 0 ? 0 : snr);
+				else
+					o += snprintf(body + o, sizeof(body) - o, ",%02u,%02d,%03d,",
+						      g->sat_prn[i], (int)g->sat_el[i],
+						      (int)g->sat_az[i]);
+			}
+			len += put(g, buf + len, size - len, body);
+		}
+	}
+	++g->epochs;
+	g->bytes += len;
+	return len;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// PMS5003
+
+static double level_at(sgen_t *g, uint64_t t_us)
+{
+	const sgen_cfg_t *c = &g->c;
+	double v = c->pm_base, h;
+
+	switch (c->profile) {
+	case SGEN_PM_RUSH:
+		h = fmod((c->t0_ms + t_us / 1000) / 3.6e6 + LOCAL_UTC_H, 24);
+		v *= 1 + exp(-(h - 8) * (h - 8) / 4.5) + exp(-(h - 18) * (h - 18) / 4.5);
+		break;
+	case SGEN_PM_RAMP:
+		if (c->duration_s > 0)
+			v += (c->pm_peak - c->pm_base) * fmin(1, t_us / 1e6 / c->duration_s);
+		break;
+	case SGEN_PM_TRAFFIC: {
+		double dt = (t_us - g->episode_t_us) / 1e6;
+
+		// Decay the running episode, then maybe start another
+		g->episode *= exp(-dt / EPISODE_TAU_S);
+		if (uniform(g) < 1 - exp(-dt * c->episodes_h / 3600))
+			g->episode += (c->pm_peak - c->pm_base) * (0.3 + 0.7 * uniform(g));
+		g->episode_t_us = t_us;
+		v += g->episode;
+		break;
+	}
+	default:
+		break;
+	}
+	for (size_t i = 0; i < c->nr_hotspots; ++i) {
+		const sgen_hotspot_t *s = &c->hotspots[i];
+		double d = dist_m(g->lat, g->lon, s->lat, s->lon) / s->radius_m;
+
+		v += s->peak * exp(-d * d / 2);
+	}
+	return v;
+}
+
+static uint16_t clamp16(double v)
+{
+	return v <= 0 ? 0 : v >= 65535 ? 65535 : (uint16_t)lround(v);
+}
+
+size_t sgen_pm_frame(sgen_t *g, uint64_t n, uint8_t *out)
+{
+	uint64_t t_us = (uint64_t)(n * 1e6 / g->c.pm_hz);
+	uint16_t w[13], sum = 0;
+	double pm25, pm1, pm10, cf, n03, n25;
+
+	advance(g, t_us);
+	pm25 = level_at(g, t_us) * (1 + g->c.pm_noise * gauss(g));
+	if (pm25 < 0)
+		pm25 = 0;
+	pm1 = pm25 * (0.68 + 0.02 * gauss(g));
+	pm10 = pm25 * (1.3 + 0.05 * gauss(g));
+
+	// The CF=1 values read high once the air is dirty
+	cf = pm25 <= 30 ? 1 : 1 + fmin(0.5, (pm25 - 30) / 140);
+	n03 = 120 * pm1 + 200;
+	n25 = 0.006 * n03 + 0.5 * (pm10 - pm25);
+
+	w[0]  = clamp16(pm1 * cf);
+	w[1]  = clamp16(pm25 * cf);
+	w[2]  = clamp16(pm10 * cf);
+	w[3]  = clamp16(pm1);
+	w[4]  = clamp16(pm25);
+	w[5]  = clamp16(pm10);
+	w[6]  = clamp16(n03 * (1 + 0.02 * gauss(g)));
+	w[7]  = clamp16(0.33 * n03 * (1 + 0.03 * gauss(g)));
+	w[8]  = clamp16(0.058 * n03 * (1 + 0.05 * gauss(g)));
+	w[9]  = clamp16(n25);
+	w[10] = clamp16(0.3 * n25);
+	w[11] = clamp16(0.1 * n25);
+	w[12] = 0x9700;		// Version 0x97, no error
+
+	out[0] = 0x42;
+	out[1] = 0x4D;
+	out[2] = 0x00;
+	out[3] = 28;
+	for (int k = 0; k < 13; ++k) {
+		out[4 + 2 * k] = (uint8_t)(w[k] >> 8);
+		out[5 + 2 * k] = (uint8_t)w[k];
+	}
+	for (int k = 0; k < 30; ++k)
+		sum += out[k];
+	out[30] = (uint8_t)(sum >> 8);
+	out[31] = (uint8_t)sum;
+	++g->frames;
+	g->bytes += SGEN_PMS_FRAME;
+	return SGEN_PMS_FRAME;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int sgen_route_load(const char *path, sgen_point_t **route, size_t *nr)
+{
+	FILE *f = fopen(path, "r");
+	sgen_point_t *r = NULL;
+	size_t n = 0;
+	char line[256];
+
+	if (f == NULL)
+		return -1;
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char *p = line + strspn(line, " \t"), *end;
+		sgen_point_t pt, *grown;
+
+		if (*p == '#' || *p == '\n' || *p == '\r' || *p == '\0')
+			continue;
+		pt.lat = strtod(p, &end);
+		if (end == p || *end != ',')
+			goto bad;
+		p = end + 1;
+		pt.lon = strtod(p, &end);
+		if (end == p || fabs(pt.lat) > 90 || fabs(pt.lon) > 180)
+			goto bad;
+		if ((grown = realloc(r, (n + 1) * sizeof(*r))) == NULL) {
+			free(r);
+			fclose(f);
+			return -1;
+		}
+		r = grown;
+		r[n++] = pt;
+	}
+	fclose(f);
+	if (n < 2) {
+		free(r);
+		errno = EINVAL;
+		return -1;
+	}
+	*route = r;
+	*nr = n;
+	return 0;
+bad:
+	free(r);
+	fclose(f);
+	errno = EINVAL;
+	return -1;
+}
+
+int sgen_profile_parse(const char *name)
+{
+	static const char *const names[] = { "const", "rush", "ramp", "traffic" };
+
+	for (int i = 0; i < (int)(sizeof(names) / sizeof(names[0])); ++i)
+		if (strcmp(name, names[i]) == 0)
+			return i;
+	return -1;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file host/lib/sgen.h
+ * @brief Synthetic GPS receiver and PMS5003 output
+ *
+ * Produces what the board's two sensors would send, as byte streams ready
+ * for a UART: NMEA epochs (RMC, GGA, GLL and GSV, with valid checksums) at
+ * any fix rate, and PMS5003 frames at any report rate. Both streams come
+ * from one model of a unit moving through a pollution field:
+ *
+ * - The route is either scripted (waypoints followed at a set speed, looped
+ *   or ping-ponged) or a random walk that turns back towards its start when
+ *   it strays beyond a radius. Reported positions carry correlated noise, as
+ *   a receiver's do, and a fraction of epochs can be sent without a fix
+ *   (empty fields, status V), as in the captures taken indoors.
+ * - The pollution is a profile in time (constant, a day's two rush hours, a
+ *   linear ramp, or random traffic episodes that decay) plus hotspots in
+ *   space, with multiplicative noise on every reading. The other channels
+ *   follow PM2.5 with the ratios of urban aerosol.
+ *
+ * Time runs from the configured start; each stream is asked for its items in
+ * order. A generator is deterministic for a given seed.
+ */
+
+#if !defined(SGEN_H_)
+#define SGEN_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/// Sentences in an epoch (sgen_cfg_t::sentences)
+#define SGEN_RMC	0x01
+#define SGEN_GGA	0x02
+#define SGEN_GLL	0x04
+#define SGEN_GSV	0x08
+#define SGEN_ALL	(SGEN_RMC | SGEN_GGA | SGEN_GLL | SGEN_GSV)
+
+/// Largest epoch: RMC, GGA, GLL and four GSV sentences
+#define SGEN_EPOCH_MAX	640
+
+/// Size of a PMS5003 frame
+#define SGEN_PMS_FRAME	32
+
+/// Pollution profiles in time
+typedef enum sgen_profile_type {
+	SGEN_PM_CONST = 0,	///< Steady at the base level
+	SGEN_PM_RUSH,		///< Base level, doubled around 08:00 and 18:00 UTC+8
+	SGEN_PM_RAMP,		///< From the base level to the peak over the run
+	SGEN_PM_TRAFFIC		///< Base level plus random episodes that decay
+} sgen_profile_t;
+
+/// A point of a scripted route
+typedef struct sgen_point_type {
+	double lat, lon;	///< Degrees
+} sgen_point_t;
+
+/// A place where PM2.5 is raised, falling off as a Gaussian with distance
+typedef struct sgen_hotspot_type {
+	double lat, lon;	///< Degrees
+	double radius_m;	///< Distance at which the excess falls to 61%
+	double peak;		///< Excess PM2.5 at the centre, in ug/m3
+} sgen_hotspot_t;
+
+/// Generator settings; start from sgen_cfg_default()
+typedef struct sgen_cfg_type {
+	uint32_t seed;
+	int64_t  t0_ms;		///< UTC at time zero
+
+	// GPS
+	double   gps_hz;	///< Epochs per second
+	unsigned sentences;	///< SGEN_* mask
+	char     talker[3];	///< "GP", "GN", ...
+	unsigned nr_sats;	///< Satellites in view, 0 to 16
+	double   noise_m;	///< Standard deviation of the position error
+	double   no_fix;	///< Fraction of epochs without a fix, 0 to 1
+
+	// Route
+	const sgen_point_t *route;	///< Waypoints; NULL for a random walk
+	size_t   nr_route;
+	bool     pingpong;	///< Walk the waypoints back and forth, not in a loop
+	double   lat0, lon0;	///< Start of a random walk
+	double   radius_m;	///< A random walk turns back beyond this
+	double   speed_mps;
+
+	// PM
+	double   pm_hz;		///< Frames per second
+	sgen_profile_t profile;
+	double   pm_base;	///< PM2.5 base level, ug/m3
+	double   pm_peak;	///< PM2.5 reached by a ramp or an episode
+	double   pm_noise;	///< Relative standard deviation of a reading
+	double   episodes_h;	///< Episodes per hour (SGEN_PM_TRAFFIC)
+	double   duration_s;	///< Length of the run (SGEN_PM_RAMP)
+	const sgen_hotspot_t *hotspots;
+	size_t   nr_hotspots;
+} sgen_cfg_t;
+
+/// Generator state
+typedef struct sgen_type {
+	sgen_cfg_t c;
+	uint32_t rng;
+
+	// Route
+	uint64_t t_us;		///< Time the unit has been moved to
+	double   lat, lon;	///< True position
+	double   heading;	///< Radians from north
+	size_t   leg;		///< Waypoint being walked to
+	int      dir;		///< +1 or -1 along the waypoints
+	double   err_n, err_e;	///< Position error, metres
+	bool     fix;
+
+	// Satellites
+	double   sat_el[16], sat_az[16];
+	uint8_t  sat_prn[16];
+
+	// PM
+	double   episode;	///< Current episode excess, ug/m3
+	uint64_t episode_t_us;
+
+	// Counters
+	uint64_t epochs, frames, bytes;
+} sgen_t;
+
+/// Defaults: 1 Hz RMC+GGA+GLL, a random walk on campus, 1 Hz PMS at 25 ug/m3
+void sgen_cfg_default(sgen_cfg_t *c);
+
+/// Start a generator; the route and hotspots must outlive it
+void sgen_init(sgen_t *g, const sgen_cfg_t *c);
+
+/**
+ * The NMEA sentences of one epoch
+ *
+ * @param	g	Generator
+ * @param	n	Epoch number; epoch @p n is at n / gps_hz seconds
+ * @param	buf	Where to store the sentences
+ * @param	size	Size of @p buf; SGEN_EPOCH_MAX always suffices
+ *
+ * @return	Number of bytes stored
+ */
+size_t sgen_gps_epoch(sgen_t *g, uint64_t n, char *buf, size_t size);
+
+/**
+ * One PMS5003 frame
+ *
+ * @param	g	Generator
+ * @param	n	Frame number; frame @p n is at n / pm_hz seconds
+ * @param	out	Where to store the SGEN_PMS_FRAME bytes
+ *
+ * @return	SGEN_PMS_FRAME
+ */
+size_t sgen_pm_frame(sgen_t *g, uint64_t n, uint8_t *out);
+
+/// The true position of the unit at the last item produced
+void sgen_position(const sgen_t *g, double *lat, double *lon);
+
+/**
+ * Read a route: one "lat,lon" waypoint per line; '#' starts a comment
+ *
+ * @return	0 on success, -1 on error (with errno set; EINVAL for a bad
+ *		line or fewer than two waypoints)
+ */
+int sgen_route_load(const char *path, sgen_point_t **route, size_t *nr);
+
+/// Parse a profile name ("const", "rush", "ramp", "traffic"); -1 if unknown
+int sgen_profile_parse(const char *name);
+
+#endif	// !defined(SGEN_H_)
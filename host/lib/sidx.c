@@ -0,0 +1,1080 @@
+/**
+ * @file host/lib/sidx.c
+ * @brief Spatial grid index over geotagged samples
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "sidx.h"
+
+#define SIDX_VERSION		1
+#define SIDX_ORDER		0x01020304u
+#define SIDX_MAX_THREADS	64
+
+/// Metres per degree of latitude (equirectangular, good at city scale)
+#define M_PER_DEG		111320.0
+
+/// A sample with its sort key, while bulk loading
+typedef struct keyed_type {
+	uint64_t     key;
+	sidx_point_t p;
+} keyed_t;
+
+/// A cell of the delta (open addressing; count 0 and no samples: free slot)
+typedef struct dcell_type {
+	int32_t  cx, cy;
+	uint32_t n, cap;
+	sidx_point_t *p;
+} dcell_t;
+
+struct sidx_type {
+	int32_t  cell_e7;
+
+	// Base, mapped from a file or built in memory
+	const sidx_cell_t  *cells;
+	const sidx_point_t *pts;
+	uint64_t nr_cells, nr_pts;
+	void    *map;
+	size_t   map_len;
+	sidx_cell_t  *own_cells;
+	sidx_point_t *own_pts;
+
+	// Delta
+	dcell_t *dcells;
+	size_t   dcap, nr_dcells;
+	uint64_t nr_dpts;
+
+	// Extent of all cells, so searches need not wander off the data
+	bool     empty;
+	int32_t  cx_min, cx_max, cy_min, cy_max;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Cells and keys
+
+static int32_t floor_div(int32_t v, int32_t c)
+{
+	return v >= 0 ? v / c : (int32_t)(-((-(int64_t)v + c - 1) / c));
+}
+
+static int32_t to_e7(double deg)
+{
+	double v = deg * 1e7;
+
+	if (v > INT32_MAX)
+		return INT32_MAX;
+	if (v < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)llround(v);
+}
+
+/// Sort key: cell row, then column (offset so they compare unsigned)
+static uint64_t cell_key(int32_t cx, int32_t cy)
+{
+	return ((uint64_t)((uint32_t)cy ^ 0x80000000u) << 32) | ((uint32_t)cx ^ 0x80000000u);
+}
+
+static uint64_t point_key(const sidx_t *x, const sidx_point_t *p)
+{
+	return cell_key(floor_div(p->lon_e7, x->cell_e7), floor_div(p->lat_e7, x->cell_e7));
+}
+
+static int cmp_point(uint64_t ka, const sidx_point_t *a, uint64_t kb, const sidx_point_t *b)
+{
+	if (ka != kb)
+		return ka < kb ? -1 : 1;
+	if (a->t_ms != b->t_ms)
+		return a->t_ms < b->t_ms ? -1 : 1;
+	if (a->lat_e7 != b->lat_e7)
+		return a->lat_e7 < b->lat_e7 ? -1 : 1;
+	if (a->lon_e7 != b->lon_e7)
+		return a->lon_e7 < b->lon_e7 ? -1 : 1;
+	return memcmp(a->pm, b->pm, sizeof(a->pm));
+}
+
+static int cmp_keyed(const void *a, const void *b)
+{
+	const keyed_t *x = a, *y = b;
+
+	return cmp_point(x->key, &x->p, y->key, &y->p);
+}
+
+static void extent_add(sidx_t *x, int32_t cx, int32_t cy)
+{
+	if (x->empty) {
+		x->cx_min = x->cx_max = cx;
+		x->cy_min = x->cy_max = cy;
+		x->empty = false;
+		return;
+	}
+	if (cx < x->cx_min)
+		x->cx_min = cx;
+	if (cx > x->cx_max)
+		x->cx_max = cx;
+	if (cy < x->cy_min)
+		x->cy_min = cy;
+	if (cy > x->cy_max)
+		x->cy_max = cy;
+}
+
+/// First base cell whose key is >= @p key
+static uint64_t base_lower(const sidx_t *x, uint64_t key)
+{
+	uint64_t a = 0, b = x->nr_cells;
+
+	while (a < b) {
+		uint64_t m = a + (b - a) / 2;
+
+		if (cell_key(x->cells[m].cx, x->cells[m].cy) < key)
+			a = m + 1;
+		else
+			b = m;
+	}
+	return a;
+}
+
+static const sidx_cell_t *base_find(const sidx_t *x, int32_t cx, int32_t cy)
+{
+	uint64_t i = base_lower(x, cell_key(cx, cy));
+
+	if (i < x->nr_cells && x->cells[i].cx == cx && x->cells[i].cy == cy)
+		return &x->cells[i];
+	return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Delta
+
+static size_t delta_slot(const sidx_t *x, int32_t cx, int32_t cy)
+{
+	uint64_t h = cell_key(cx, cy) * 0x9E3779B97F4A7C15ull;
+	size_t i = (size_t)(h >> 32) & (x->dcap - 1);
+
+	while (x->dcells[i].p != NULL && (x->dcells[i].cx != cx || x->dcells[i].cy != cy))
+		i = (i + 1) & (x->dcap - 1);
+	return i;
+}
+
+static const dcell_t *delta_find(const sidx_t *x, int32_t cx, int32_t cy)
+{
+	const dcell_t *d;
+
+	if (x->nr_dcells == 0)
+		return NULL;
+	d = &x->dcells[delta_slot(x, cx, cy)];
+	return d->p != NULL ? d : NULL;
+}
+
+static int delta_grow(sidx_t *x)
+{
+	size_t cap = x->dcap ? x->dcap * 2 : 1024;
+	dcell_t *old = x->dcells, *cells = calloc(cap, sizeof(*cells));
+	size_t old_cap = x->dcap;
+
+	if (cells == NULL)
+		return -1;
+	x->dcells = cells;
+	x->dcap = cap;
+	for (size_t i = 0; i < old_cap; ++i)
+		if (old[i].p != NULL)
+			x->dcells[delta_slot(x, old[i].cx, old[i].cy)] = old[i];
+	free(old);
+	return 0;
+}
+
+static void delta_free(sidx_t *x)
+{
+	for (size_t i = 0; i < x->dcap; ++i)
+		free(x->dcells[i].p);
+	free(x->dcells);
+	x->dcells = NULL;
+	x->dcap = x->nr_dcells = 0;
+	x->nr_dpts = 0;
+}
+
+int sidx_insert(sidx_t *x, const sidx_point_t *p)
+{
+	int32_t cx = floor_div(p->lon_e7, x->cell_e7), cy = floor_div(p->lat_e7, x->cell_e7);
+	dcell_t *d;
+
+	if ((x->nr_dcells + 1) * 10 > x->dcap * 7 && delta_grow(x) != 0)
+		return -1;
+	d = &x->dcells[delta_slot(x, cx, cy)];
+	if (d->n == d->cap) {
+		uint32_t cap = d->cap ? d->cap * 2 : 16;
+		sidx_point_t *np = realloc(d->p, cap * sizeof(*np));
+
+		if (np == NULL)
+			return -1;
+		if (d->p == NULL) {
+			d->cx = cx;
+			d->cy = cy;
+			++x->nr_dcells;
+		}
+		d->p = np;
+		d->cap = cap;
+	}
+	d->p[d->n++] = *p;
+	++x->nr_dpts;
+	extent_add(x, cx, cy);
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Building a base
+
+static void base_release(sidx_t *x)
+{
+	if (x->map != NULL)
+		munmap(x->map, x->map_len);
+	free(x->own_cells);
+	free(x->own_pts);
+	x->map = NULL;
+	x->own_cells = NULL;
+	x->own_pts = NULL;
+	x->cells = NULL;
+	x->pts = NULL;
+	x->nr_cells = x->nr_pts = 0;
+}
+
+static void extent_from_base(sidx_t *x)
+{
+	for (uint64_t i = 0; i < x->nr_cells; ++i)
+		extent_add(x, x->cells[i].cx, x->cells[i].cy);
+}
+
+/// Copy the delta into @p dst, sorted; returns the number of samples
+static size_t delta_to_run(const sidx_t *x, keyed_t *dst)
+{
+	size_t n = 0;
+
+	for (size_t i = 0; i < x->dcap; ++i) {
+		const dcell_t *d = &x->dcells[i];
+
+		for (uint32_t j = 0; j < d->n; ++j) {
+			dst[n].key = cell_key(d->cx, d->cy);
+			dst[n++].p = d->p[j];
+		}
+	}
+	qsort(dst, n, sizeof(*dst), cmp_keyed);
+	return n;
+}
+
+/**
+ * Replace base and delta with one base: the base merged with sorted runs
+ *
+ * Run i is run[bounds[i]] ... run[bounds[i + 1] - 1]. The runs must include
+ * the delta (see delta_to_run()).
+ */
+static int rebuild(sidx_t *x, const keyed_t *run, const size_t *bounds, int nr_runs)
+{
+	uint64_t n = x->nr_pts + bounds[nr_runs], bi = 0, nr_cells = 0;
+	size_t head[SIDX_MAX_THREADS + 1];
+	sidx_point_t *pts = malloc((n ? n : 1) * sizeof(*pts));
+	sidx_cell_t *cells;
+	uint64_t prev_key = 0;
+
+	if (pts == NULL)
+		return -1;
+	for (int r = 0; r < nr_runs; ++r)
+		head[r] = bounds[r];
+
+	// (nr_runs + 1)-way merge; the run count is small, so a linear pick
+	for (uint64_t o = 0; o < n; ++o) {
+		const sidx_point_t *best = NULL;
+		uint64_t best_key = 0;
+		int from = -1;
+
+		if (bi < x->nr_pts) {
+			best = &x->pts[bi];
+			best_key = point_key(x, best);
+		}
+		for (int r = 0; r < nr_runs; ++r) {
+			if (head[r] == bounds[r + 1])
+				continue;
+			if (best == NULL || cmp_point(run[head[r]].key, &run[head[r]].p, best_key, best) < 0) {
+				best = &run[head[r]].p;
+				best_key = run[head[r]].key;
+				from = r;
+			}
+		}
+		pts[o] = *best;
+		if (from < 0)
+			++bi;
+		else
+			++head[from];
+		if (o == 0 || best_key != prev_key)
+			++nr_cells;
+		prev_key = best_key;
+	}
+
+	if ((cells = calloc(nr_cells ? nr_cells : 1, sizeof(*cells))) == NULL) {
+		free(pts);
+		return -1;
+	}
+	nr_cells = 0;
+	for (uint64_t o = 0; o < n; ++o) {
+		int32_t cx = floor_div(pts[o].lon_e7, x->cell_e7);
+		int32_t cy = floor_div(pts[o].lat_e7, x->cell_e7);
+		sidx_cell_t *c = nr_cells ? &cells[nr_cells - 1] : NULL;
+
+		if (c == NULL || c->cx != cx || c->cy != cy) {
+			c = &cells[nr_cells++];
+			c->cx = cx;
+			c->cy = cy;
+			c->first = o;
+		}
+		++c->count;
+		for (int k = 0; k < SARC_NR_PM; ++k) {
+			c->pm_sum[k] += pts[o].pm[k];
+			if (pts[o].pm[k] > c->pm_max[k])
+				c->pm_max[k] = pts[o].pm[k];
+		}
+	}
+
+	base_release(x);
+	delta_free(x);
+	x->cells = x->own_cells = cells;
+	x->pts = x->own_pts = pts;
+	x->nr_cells = nr_cells;
+	x->nr_pts = n;
+	x->empty = true;
+	extent_from_base(x);
+	return 0;
+}
+
+typedef struct sort_job_type {
+	const sidx_t *x;
+	const sidx_point_t *src;	// Samples to convert, or NULL: already in dst
+	keyed_t *dst;
+	size_t   n;
+} sort_job_t;
+
+static void *sort_worker(void *arg)
+{
+	sort_job_t *j = arg;
+
+	if (j->src != NULL)
+		for (size_t i = 0; i < j->n; ++i) {
+			j->dst[i].p = j->src[i];
+			j->dst[i].key = point_key(j->x, &j->src[i]);
+		}
+	qsort(j->dst, j->n, sizeof(*j->dst), cmp_keyed);
+	return NULL;
+}
+
+static int clamp_threads(int threads)
+{
+	return threads < 1 ? 1 : threads > SIDX_MAX_THREADS ? SIDX_MAX_THREADS : threads;
+}
+
+int sidx_insert_many(sidx_t *x, const sidx_point_t *p, size_t n, int threads)
+{
+	keyed_t *run = malloc((n + x->nr_dpts + 1) * sizeof(*run));
+	size_t bounds[SIDX_MAX_THREADS + 2];
+	sort_job_t jobs[SIDX_MAX_THREADS];
+	pthread_t th[SIDX_MAX_THREADS];
+	int res;
+
+	if (run == NULL)
+		return -1;
+	threads = clamp_threads(threads);
+	for (int t = 0; t <= threads; ++t)
+		bounds[t] = n * (size_t)t / (size_t)threads;
+	for (int t = 0; t < threads; ++t) {
+		jobs[t] = (sort_job_t){ x, p + bounds[t], run + bounds[t], bounds[t + 1] - bounds[t] };
+		pthread_create(&th[t], NULL, sort_worker, &jobs[t]);
+	}
+	bounds[threads + 1] = n + delta_to_run(x, run + n);
+	for (int t = 0; t < threads; ++t)
+		pthread_join(th[t], NULL);
+
+	res = rebuild(x, run, bounds, threads + 1);
+	free(run);
+	return res;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Bulk loading from archives
+
+typedef struct load_item_type {
+	int      arc;
+	uint32_t block;
+	uint32_t nr_fix;
+	size_t   out;		// Position of its first sample in the run
+} load_item_t;
+
+typedef struct load_job_type {
+	const sidx_t *x;
+	const char *const *archives;
+	int      nr_archives;
+	const load_item_t *items;
+	size_t   first, last;	// Items [first, last)
+	keyed_t *run;
+	size_t   begin, end;	// Its part of the run
+	int      err;
+} load_job_t;
+
+void sidx_point_from_row(sidx_point_t *p, const sarc_row_t *row)
+{
+	p->t_ms = row->t_ms;
+	p->lat_e7 = to_e7(row->lat);
+	p->lon_e7 = to_e7(row->lon);
+	memcpy(p->pm, row->pm, sizeof(p->pm));
+}
+
+static void *load_worker(void *arg)
+{
+	load_job_t *j = arg;
+	sarc_reader_t **readers = calloc((size_t)j->nr_archives, sizeof(*readers));
+	sarc_row_t *rows = malloc(SARC_BLOCK_ROWS * sizeof(*rows));
+
+	if (readers == NULL || rows == NULL)
+		j->err = ENOMEM;
+	for (size_t i = j->first; i < j->last && j->err == 0; ++i) {
+		const load_item_t *it = &j->items[i];
+		keyed_t *dst = j->run + it->out;
+		uint32_t got = 0;
+		int n;
+
+		if (readers[it->arc] == NULL &&
+		    (readers[it->arc] = sarc_open(j->archives[it->arc])) == NULL) {
+			j->err = errno;
+			break;
+		}
+		if ((n = sarc_read_block(readers[it->arc], it->block, rows)) < 0) {
+			j->err = EINVAL;
+			break;
+		}
+		for (int r = 0; r < n; ++r) {
+			if (isnan(rows[r].lat))
+				continue;
+			if (got < it->nr_fix) {
+				sidx_point_from_row(&dst[got].p, &rows[r]);
+				dst[got].key = point_key(j->x, &dst[got].p);
+			}
+			++got;
+		}
+		if (got != it->nr_fix)
+			j->err = EINVAL;
+	}
+	if (j->err == 0)
+		qsort(j->run + j->begin, j->end - j->begin, sizeof(*j->run), cmp_keyed);
+
+	for (int a = 0; readers != NULL && a < j->nr_archives; ++a)
+		if (readers[a] != NULL)
+			sarc_close_reader(readers[a]);
+	free(readers);
+	free(rows);
+	return NULL;
+}
+
+int sidx_bulk_load(sidx_t *x, const char *const *archives, int nr_archives, int threads)
+{
+	load_item_t *items = NULL;
+	size_t nr_items = 0, total = 0;
+	size_t bounds[SIDX_MAX_THREADS + 2];
+	load_job_t jobs[SIDX_MAX_THREADS];
+	pthread_t th[SIDX_MAX_THREADS];
+	keyed_t *run = NULL;
+	int err = 0;
+
+	// The index of every archive gives each block's place in the run
+	for (int a = 0; a < nr_archives && err == 0; ++a) {
+		sarc_reader_t *r = sarc_open(archives[a]);
+		load_item_t *ni;
+
+		if (r == NULL) {
+			err = errno;
+			break;
+		}
+		ni = realloc(items, (nr_items + sarc_nr_blocks(r) + 1) * sizeof(*items));
+		if (ni == NULL) {
+			err = ENOMEM;
+		} else {
+			items = ni;
+			for (uint32_t b = 0; b < sarc_nr_blocks(r); ++b) {
+				const sarc_block_info_t *bi = sarc_block_info(r, b);
+
+				if (bi->nr_fix == 0)
+					continue;
+				items[nr_items++] = (load_item_t){ a, b, bi->nr_fix, total };
+				total += bi->nr_fix;
+			}
+		}
+		sarc_close_reader(r);
+	}
+	if (err == 0 && (run = malloc((total + x->nr_dpts + 1) * sizeof(*run))) == NULL)
+		err = ENOMEM;
+	if (err != 0) {
+		free(items);
+		errno = err;
+		return -1;
+	}
+
+	// Contiguous item ranges of about equal sample counts
+	threads = clamp_threads(threads);
+	for (int t = 0, i = 0; t < threads; ++t) {
+		size_t goal = total * (size_t)(t + 1) / (size_t)threads;
+
+		jobs[t] = (load_job_t){ x, archives, nr_archives, items, (size_t)i, (size_t)i,
+					run, 0, 0, 0 };
+		jobs[t].begin = (size_t)i < nr_items ? items[i].out : total;
+		while ((size_t)i < nr_items && (items[i].out < goal || t == threads - 1))
+			++i;
+		jobs[t].last = (size_t)i;
+		jobs[t].end = (size_t)i < nr_items ? items[i].out : total;
+		bounds[t] = jobs[t].begin;
+		pthread_create(&th[t], NULL, load_worker, &jobs[t]);
+	}
+	bounds[threads] = total;
+	bounds[threads + 1] = total + delta_to_run(x, run + total);
+	for (int t = 0; t < threads; ++t) {
+		pthread_join(th[t], NULL);
+		if (jobs[t].err != 0)
+			err = jobs[t].err;
+	}
+
+	if (err == 0 && rebuild(x, run, bounds, threads + 1) != 0)
+		err = ENOMEM;
+	free(run);
+	free(items);
+	if (err != 0) {
+		errno = err;
+		return -1;
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Creating, opening and saving
+
+sidx_t *sidx_create(double cell_deg)
+{
+	sidx_t *x = calloc(1, sizeof(*x));
+
+	if (x == NULL)
+		return NULL;
+	x->cell_e7 = to_e7(cell_deg);
+	if (x->cell_e7 < 1)
+		x->cell_e7 = 1;
+	x->empty = true;
+	return x;
+}
+
+sidx_t *sidx_open(const char *path)
+{
+	const sidx_file_hdr_t *h;
+	struct stat sb;
+	sidx_t *x;
+	int fd;
+
+	if ((fd = open(path, O_RDONLY)) < 0)
+		return NULL;
+	if (fstat(fd, &sb) != 0) {
+		close(fd);
+		return NULL;
+	}
+	if ((size_t)sb.st_size < sizeof(*h)) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+	if ((x = sidx_create(SIDX_DEFAULT_CELL_DEG)) == NULL) {
+		close(fd);
+		return NULL;
+	}
+	x->map_len = (size_t)sb.st_size;
+	x->map = mmap(NULL, x->map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (x->map == MAP_FAILED) {
+		x->map = NULL;
+		sidx_close(x);
+		return NULL;
+	}
+
+	h = x->map;
+	if (memcmp(h->magic, "SIDX", 4) != 0 || h->order != SIDX_ORDER ||
+	    h->version != SIDX_VERSION || h->cell_e7 < 1 ||
+	    h->cells_off + h->nr_cells * sizeof(sidx_cell_t) > x->map_len ||
+	    h->points_off + h->nr_points * sizeof(sidx_point_t) > x->map_len ||
+	    h->cells_off % 8 != 0 || h->points_off % 8 != 0) {
+		sidx_close(x);
+		errno = EINVAL;
+		return NULL;
+	}
+	x->cell_e7 = h->cell_e7;
+	x->cells = (const sidx_cell_t *)((const uint8_t *)x->map + h->cells_off);
+	x->pts = (const sidx_point_t *)((const uint8_t *)x->map + h->points_off);
+	x->nr_cells = h->nr_cells;
+	x->nr_pts = h->nr_points;
+	extent_from_base(x);
+	return x;
+}
+
+int sidx_save(sidx_t *x, const char *path)
+{
+	sidx_file_hdr_t h = { .magic = { 'S', 'I', 'D', 'X' } };
+	char tmp[4096];
+	FILE *f;
+
+	if (x->nr_dpts > 0) {
+		keyed_t *run = malloc(x->nr_dpts * sizeof(*run));
+		size_t bounds[2] = { 0, 0 };
+		int res;
+
+		if (run == NULL)
+			return -1;
+		bounds[1] = delta_to_run(x, run);
+		res = rebuild(x, run, bounds, 1);
+		free(run);
+		if (res != 0)
+			return -1;
+	}
+
+	h.order = SIDX_ORDER;
+	h.version = SIDX_VERSION;
+	h.cell_e7 = x->cell_e7;
+	h.nr_cells = x->nr_cells;
+	h.nr_points = x->nr_pts;
+	h.cells_off = sizeof(h);
+	h.points_off = h.cells_off + x->nr_cells * sizeof(sidx_cell_t);
+
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if ((f = fopen(tmp, "wb")) == NULL)
+		return -1;
+	if (fwrite(&h, sizeof(h), 1, f) != 1 ||
+	    fwrite(x->cells, sizeof(*x->cells), x->nr_cells, f) != x->nr_cells ||
+	    fwrite(x->pts, sizeof(*x->pts), x->nr_pts, f) != x->nr_pts ||
+	    fflush(f) != 0 || fsync(fileno(f)) != 0) {
+		fclose(f);
+		unlink(tmp);
+		return -1;
+	}
+	if (fclose(f) != 0 || rename(tmp, path) != 0) {
+		unlink(tmp);
+		return -1;
+	}
+	return 0;
+}
+
+void sidx_close(sidx_t *x)
+{
+	base_release(x);
+	delta_free(x);
+	free(x);
+}
+
+double sidx_cell_deg(const sidx_t *x)
+{
+	return x->cell_e7 / 1e7;
+}
+
+uint64_t sidx_nr_points(const sidx_t *x)
+{
+	return x->nr_pts + x->nr_dpts;
+}
+
+uint64_t sidx_nr_cells(const sidx_t *x)
+{
+	uint64_t n = x->nr_cells;
+
+	for (size_t i = 0; i < x->dcap; ++i)
+		if (x->dcells[i].p != NULL && base_find(x, x->dcells[i].cx, x->dcells[i].cy) == NULL)
+			++n;
+	return n;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Window queries
+
+/// A box in cell and e7 units, clipped to the extent
+typedef struct win_type {
+	int32_t lat0, lat1, lon0, lon1;		// e7, inclusive
+	int32_t cx0, cx1, cy0, cy1;		// Cells, inclusive
+} win_t;
+
+static bool win_init(const sidx_t *x, const sidx_box_t *box, win_t *w)
+{
+	w->lat0 = to_e7(box->lat_min);
+	w->lat1 = to_e7(box->lat_max);
+	w->lon0 = to_e7(box->lon_min);
+	w->lon1 = to_e7(box->lon_max);
+	w->cx0 = floor_div(w->lon0, x->cell_e7);
+	w->cx1 = floor_div(w->lon1, x->cell_e7);
+	w->cy0 = floor_div(w->lat0, x->cell_e7);
+	w->cy1 = floor_div(w->lat1, x->cell_e7);
+	if (x->empty || w->lat0 > w->lat1 || w->lon0 > w->lon1)
+		return false;
+	if (w->cx0 < x->cx_min)
+		w->cx0 = x->cx_min;
+	if (w->cx1 > x->cx_max)
+		w->cx1 = x->cx_max;
+	if (w->cy0 < x->cy_min)
+		w->cy0 = x->cy_min;
+	if (w->cy1 > x->cy_max)
+		w->cy1 = x->cy_max;
+	return w->cx0 <= w->cx1 && w->cy0 <= w->cy1;
+}
+
+static bool win_has_cell(const win_t *w, int32_t cx, int32_t cy)
+{
+	return cx >= w->cx0 && cx <= w->cx1 && cy >= w->cy0 && cy <= w->cy1;
+}
+
+static bool win_covers_cell(const sidx_t *x, const win_t *w, int32_t cx, int32_t cy)
+{
+	int64_t lon0 = (int64_t)cx * x->cell_e7, lat0 = (int64_t)cy * x->cell_e7;
+
+	return lon0 >= w->lon0 && lon0 + x->cell_e7 - 1 <= w->lon1 &&
+	       lat0 >= w->lat0 && lat0 + x->cell_e7 - 1 <= w->lat1;
+}
+
+static bool win_has_point(const win_t *w, const sidx_point_t *p)
+{
+	return p->lat_e7 >= w->lat0 && p->lat_e7 <= w->lat1 &&
+	       p->lon_e7 >= w->lon0 && p->lon_e7 <= w->lon1;
+}
+
+/**
+ * Call @p fn for every base cell in the window, row by row
+ *
+ * @return	0, or the first non-zero value @p fn returned
+ */
+static int base_cells_in(const sidx_t *x, const win_t *w,
+			 int (*fn)(void *user, const sidx_cell_t *c), void *user)
+{
+	for (int32_t cy = w->cy0; cy <= w->cy1; ++cy) {
+		for (uint64_t i = base_lower(x, cell_key(w->cx0, cy));
+		     i < x->nr_cells && x->cells[i].cy == cy && x->cells[i].cx <= w->cx1; ++i) {
+			int res = fn(user, &x->cells[i]);
+
+			if (res != 0)
+				return res;
+		}
+	}
+	return 0;
+}
+
+typedef struct window_ctx_type {
+	const sidx_t *x;
+	const win_t *w;
+	int (*fn)(void *user, const sidx_point_t *p);
+	void *user;
+	int k;
+	sidx_agg_t *a;
+} window_ctx_t;
+
+static int window_cell(void *user, const sidx_cell_t *c)
+{
+	window_ctx_t *ctx = user;
+	bool whole = win_covers_cell(ctx->x, ctx->w, c->cx, c->cy);
+
+	for (uint32_t i = 0; i < c->count; ++i) {
+		const sidx_point_t *p = &ctx->x->pts[c->first + i];
+
+		if (whole || win_has_point(ctx->w, p)) {
+			int res = ctx->fn(ctx->user, p);
+
+			if (res != 0)
+				return res;
+		}
+	}
+	return 0;
+}
+
+int sidx_window(const sidx_t *x, const sidx_box_t *box,
+		int (*fn)(void *user, const sidx_point_t *p), void *user)
+{
+	window_ctx_t ctx = { x, NULL, fn, user, 0, NULL };
+	win_t w;
+	int res;
+
+	if (!win_init(x, box, &w))
+		return 0;
+	ctx.w = &w;
+	if ((res = base_cells_in(x, &w, window_cell, &ctx)) != 0)
+		return res;
+	for (size_t i = 0; i < x->dcap; ++i) {
+		const dcell_t *d = &x->dcells[i];
+
+		if (d->p == NULL || !win_has_cell(&w, d->cx, d->cy))
+			continue;
+		for (uint32_t j = 0; j < d->n; ++j)
+			if (win_has_point(&w, &d->p[j]) && (res = fn(user, &d->p[j])) != 0)
+				return res;
+	}
+	return 0;
+}
+
+static void agg_point(sidx_agg_t *a, uint16_t v)
+{
+	++a->count;
+	a->sum += v;
+	if (v > a->max)
+		a->max = v;
+}
+
+static int agg_cell(void *user, const sidx_cell_t *c)
+{
+	window_ctx_t *ctx = user;
+
+	if (win_covers_cell(ctx->x, ctx->w, c->cx, c->cy)) {
+		ctx->a->count += c->count;
+		ctx->a->sum += c->pm_sum[ctx->k];
+		if (c->pm_max[ctx->k] > ctx->a->max)
+			ctx->a->max = c->pm_max[ctx->k];
+		++ctx->a->cells_whole;
+		return 0;
+	}
+	++ctx->a->cells_edge;
+	for (uint32_t i = 0; i < c->count; ++i) {
+		const sidx_point_t *p = &ctx->x->pts[c->first + i];
+
+		if (win_has_point(ctx->w, p))
+			agg_point(ctx->a, p->pm[ctx->k]);
+	}
+	return 0;
+}
+
+void sidx_window_agg(const sidx_t *x, const sidx_box_t *box, int k, sidx_agg_t *a)
+{
+	window_ctx_t ctx = { x, NULL, NULL, NULL, k, a };
+	win_t w;
+
+	if (!win_init(x, box, &w))
+		return;
+	ctx.w = &w;
+	base_cells_in(x, &w, agg_cell, &ctx);
+	for (size_t i = 0; i < x->dcap; ++i) {
+		const dcell_t *d = &x->dcells[i];
+
+		if (d->p == NULL || !win_has_cell(&w, d->cx, d->cy))
+			continue;
+		++a->cells_edge;
+		for (uint32_t j = 0; j < d->n; ++j)
+			if (win_has_point(&w, &d->p[j]))
+				agg_point(a, d->p[j].pm[k]);
+	}
+}
+
+typedef struct cells_ctx_type {
+	const sidx_t *x;
+	int (*fn)(void *user, const sidx_cell_stats_t *c);
+	void *user;
+} cells_ctx_t;
+
+static void stats_init(const sidx_t *x, sidx_cell_stats_t *s, int32_t cx, int32_t cy)
+{
+	memset(s, 0, sizeof(*s));
+	s->lat = (double)cy * x->cell_e7 / 1e7;
+	s->lon = (double)cx * x->cell_e7 / 1e7;
+}
+
+static void stats_add_delta(sidx_cell_stats_t *s, const dcell_t *d)
+{
+	for (uint32_t j = 0; d != NULL && j < d->n; ++j) {
+		++s->count;
+		for (int k = 0; k < SARC_NR_PM; ++k) {
+			s->pm_sum[k] += d->p[j].pm[k];
+			if (d->p[j].pm[k] > s->pm_max[k])
+				s->pm_max[k] = d->p[j].pm[k];
+		}
+	}
+}
+
+static int cells_cell(void *user, const sidx_cell_t *c)
+{
+	cells_ctx_t *ctx = user;
+	sidx_cell_stats_t s;
+
+	stats_init(ctx->x, &s, c->cx, c->cy);
+	s.count = c->count;
+	memcpy(s.pm_sum, c->pm_sum, sizeof(s.pm_sum));
+	memcpy(s.pm_max, c->pm_max, sizeof(s.pm_max));
+	stats_add_delta(&s, delta_find(ctx->x, c->cx, c->cy));
+	return ctx->fn(ctx->user, &s);
+}
+
+int sidx_cells(const sidx_t *x, const sidx_box_t *box,
+	       int (*fn)(void *user, const sidx_cell_stats_t *c), void *user)
+{
+	cells_ctx_t ctx = { x, fn, user };
+	win_t w;
+	int res;
+
+	if (!win_init(x, box, &w))
+		return 0;
+	if ((res = base_cells_in(x, &w, cells_cell, &ctx)) != 0)
+		return res;
+	// Cells only the delta has
+	for (size_t i = 0; i < x->dcap; ++i) {
+		const dcell_t *d = &x->dcells[i];
+		sidx_cell_stats_t s;
+
+		if (d->p == NULL || !win_has_cell(&w, d->cx, d->cy) ||
+		    base_find(x, d->cx, d->cy) != NULL)
+			continue;
+		stats_init(x, &s, d->cx, d->cy);
+		stats_add_delta(&s, d);
+		if ((res = fn(user, &s)) != 0)
+			return res;
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Nearest neighbours
+
+typedef struct near_type {
+	double       d;
+	sidx_point_t p;
+} near_t;
+
+typedef struct near_ctx_type {
+	int32_t lat_e7, lon_e7;
+	double  m_per_e7_lat, m_per_e7_lon;
+	near_t *heap;		// Max-heap on d
+	size_t  n, k;
+} near_ctx_t;
+
+static void heap_sift_down(near_t *h, size_t n, size_t i)
+{
+	for (;;) {
+		size_t l = 2 * i + 1, r = l + 1, m = i;
+		near_t t;
+
+		if (l < n && h[l].d > h[m].d)
+			m = l;
+		if (r < n && h[r].d > h[m].d)
+			m = r;
+		if (m == i)
+			return;
+		t = h[i];
+		h[i] = h[m];
+		h[m] = t;
+		i = m;
+	}
+}
+
+static void near_offer(near_ctx_t *c, const sidx_point_t *p)
+{
+	double dy = (double)(p->lat_e7 - c->lat_e7) * c->m_per_e7_lat;
+	double dx = (double)(p->lon_e7 - c->lon_e7) * c->m_per_e7_lon;
+	double d = sqrt(dx * dx + dy * dy);
+
+	if (c->n < c->k) {
+		size_t i = c->n++;
+
+		c->heap[i] = (near_t){ d, *p };
+		while (i > 0 && c->heap[(i - 1) / 2].d < c->heap[i].d) {
+			near_t t = c->heap[i];
+
+			c->heap[i] = c->heap[(i - 1) / 2];
+			c->heap[(i - 1) / 2] = t;
+			i = (i - 1) / 2;
+		}
+	} else if (d < c->heap[0].d) {
+		c->heap[0] = (near_t){ d, *p };
+		heap_sift_down(c->heap, c->n, 0);
+	}
+}
+
+static void near_cell(const sidx_t *x, near_ctx_t *c, int32_t cx, int32_t cy)
+{
+	const sidx_cell_t *bc;
+	const dcell_t *d;
+
+	if (cx < x->cx_min || cx > x->cx_max || cy < x->cy_min || cy > x->cy_max)
+		return;
+	if ((bc = base_find(x, cx, cy)) != NULL)
+		for (uint32_t i = 0; i < bc->count; ++i)
+			near_offer(c, &x->pts[bc->first + i]);
+	if ((d = delta_find(x, cx, cy)) != NULL)
+		for (uint32_t i = 0; i < d->n; ++i)
+			near_offer(c, &d->p[i]);
+}
+
+static int cmp_near(const void *a, const void *b)
+{
+	const near_t *x = a, *y = b;
+
+	return x->d < y->d ? -1 : x->d > y->d;
+}
+
+size_t sidx_nearest(const sidx_t *x, double lat, double lon, size_t k,
+		    sidx_point_t *out, double *dist_m)
+{
+	near_ctx_t c = { to_e7(lat), to_e7(lon), M_PER_DEG / 1e7, 0, NULL, 0, k };
+	int32_t qcx = floor_div(c.lon_e7, x->cell_e7), qcy = floor_div(c.lat_e7, x->cell_e7);
+
+	if (k == 0 || x->empty || (c.heap = malloc(k * sizeof(*c.heap))) == NULL)
+		return 0;
+	c.m_per_e7_lon = c.m_per_e7_lat * cos(lat * M_PI / 180.0);
+
+	// The extent, as offsets from the query cell; rings are clipped to it
+	int64_t xlo = (int64_t)x->cx_min - qcx, xhi = (int64_t)x->cx_max - qcx;
+	int64_t ylo = (int64_t)x->cy_min - qcy, yhi = (int64_t)x->cy_max - qcy;
+	int64_t r0 = 0;
+
+	// Rings closer in than the extent are empty
+	r0 = xlo > r0 ? xlo : r0;
+	r0 = -xhi > r0 ? -xhi : r0;
+	r0 = ylo > r0 ? ylo : r0;
+	r0 = -yhi > r0 ? -yhi : r0;
+
+	for (int64_t r = r0;; ++r) {
+		// Ring r: the border of the (2r + 1)-cell square around the query
+		int64_t dx0 = -r > xlo ? -r : xlo, dx1 = r < xhi ? r : xhi;
+		int64_t dy0 = -r + 1 > ylo ? -r + 1 : ylo, dy1 = r - 1 < yhi ? r - 1 : yhi;
+
+		for (int64_t dx = dx0; dx <= dx1; ++dx) {
+			if (-r >= ylo)
+				near_cell(x, &c, (int32_t)(qcx + dx), (int32_t)(qcy - r));
+			if (r > 0 && r <= yhi)
+				near_cell(x, &c, (int32_t)(qcx + dx), (int32_t)(qcy + r));
+		}
+		for (int64_t dy = dy0; dy <= dy1; ++dy) {
+			if (-r >= xlo)
+				near_cell(x, &c, (int32_t)(qcx - r), (int32_t)(qcy + dy));
+			if (r <= xhi)
+				near_cell(x, &c, (int32_t)(qcx + r), (int32_t)(qcy + dy));
+		}
+
+		// Done once the square holds every cell ...
+		if (qcx - r <= x->cx_min && qcx + r >= x->cx_max &&
+		    qcy - r <= x->cy_min && qcy + r >= x->cy_max)
+			break;
+		// ... or nothing outside it can beat the k-th sample found
+		if (c.n == c.k) {
+			double west = (double)(c.lon_e7 - (qcx - r) * (int64_t)x->cell_e7);
+			double east = (double)((qcx + r + 1) * (int64_t)x->cell_e7 - c.lon_e7);
+			double south = (double)(c.lat_e7 - (qcy - r) * (int64_t)x->cell_e7);
+			double north = (double)((qcy + r + 1) * (int64_t)x->cell_e7 - c.lat_e7);
+			double reach = fmin(fmin(west, east) * c.m_per_e7_lon,
+					    fmin(south, north) * c.m_per_e7_lat);
+
+			if (reach >= c.heap[0].d)
+				break;
+		}
+	}
+
+	qsort(c.heap, c.n, sizeof(*c.heap), cmp_near);
+	for (size_t i = 0; i < c.n; ++i) {
+		out[i] = c.heap[i].p;
+		if (dist_m != NULL)
+			dist_m[i] = c.heap[i].d;
+	}
+	free(c.heap);
+	return c.n;
+}
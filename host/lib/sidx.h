@@ -0,0 +1,177 @@
+/**
+ * @file host/lib/sidx.h
+ * @brief Spatial grid index over geotagged samples
+ *
+ * Samples are bucketed into a uniform grid of square cells (in degrees; the
+ * default 0.001 is about 110 m). The index has two parts:
+ *
+ * - a base: every sample sorted by cell (row, then column), with a cell
+ *   directory holding the first sample, count, PM sums and PM maxima of each
+ *   cell. A saved index is this part, and is memory-mapped when opened;
+ * - a delta: samples inserted since, in a hash table of cells, so that an
+ *   ingest path can add samples one at a time.
+ *
+ * Queries see both. sidx_save() merges the delta into a new base.
+ *
+ * Bulk loading (sidx_bulk_load(), sidx_insert_many()) skips the delta: the
+ * samples are converted and sorted on a pool of threads and merged with the
+ * base in one pass.
+ *
+ * A window query answers cells wholly inside the window from the directory
+ * and only looks at the samples of the cells on its edges. A k-nearest query
+ * searches rings of cells outwards from the query point and stops once the
+ * next ring cannot hold anything closer than the k-th sample found.
+ *
+ * File layout, in host byte order (a marker in the header rejects files from
+ * a machine of the other order); the structs below are the on-disk records:
+ *
+ *   sidx_file_hdr_t
+ *   sidx_cell_t[nr_cells]		sorted by (cy, cx)
+ *   sidx_point_t[nr_points]	sorted by (cy, cx, t_ms)
+ */
+
+#if !defined(SIDX_H_)
+#define SIDX_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sarc.h"
+
+#define SIDX_DEFAULT_CELL_DEG	0.001
+
+/// One sample
+typedef struct sidx_point_type {
+	int64_t  t_ms;
+	int32_t  lat_e7, lon_e7;	///< Degrees * 1e7
+	uint16_t pm[SARC_NR_PM];	///< In sarc_row_t order
+} sidx_point_t;
+
+/// One cell of the directory
+typedef struct sidx_cell_type {
+	int32_t  cx, cy;		///< floor(lon_e7 / cell_e7), floor(lat_e7 / cell_e7)
+	uint64_t first;			///< Index of the cell's first sample
+	uint32_t count;
+	uint16_t pm_max[SARC_NR_PM];
+	uint32_t pad;
+	uint64_t pm_sum[SARC_NR_PM];
+} sidx_cell_t;
+
+typedef struct sidx_file_hdr_type {
+	char     magic[4];		///< "SIDX"
+	uint32_t order;			///< 0x01020304
+	uint32_t version;
+	int32_t  cell_e7;
+	uint64_t nr_cells;
+	uint64_t nr_points;
+	uint64_t cells_off, points_off;
+	uint8_t  pad[16];
+} sidx_file_hdr_t;
+
+/// A latitude/longitude box, in degrees, bounds included
+typedef struct sidx_box_type {
+	double lat_min, lat_max;
+	double lon_min, lon_max;
+} sidx_box_t;
+
+/// Running aggregate of one PM channel over a window
+typedef struct sidx_agg_type {
+	uint64_t count, sum;
+	uint16_t max;
+	uint64_t cells_whole;		///< Answered from the directory
+	uint64_t cells_edge;		///< Samples looked at
+} sidx_agg_t;
+
+/// A cell as seen by sidx_cells(): base and delta added up
+typedef struct sidx_cell_stats_type {
+	double   lat, lon;		///< South-west corner
+	uint64_t count;
+	uint64_t pm_sum[SARC_NR_PM];
+	uint16_t pm_max[SARC_NR_PM];
+} sidx_cell_stats_t;
+
+typedef struct sidx_type sidx_t;
+
+/// An empty index with cells of @p cell_deg degrees; NULL if out of memory
+sidx_t *sidx_create(double cell_deg);
+
+/**
+ * Map a saved index
+ *
+ * @return	The index, or NULL on error (errno set; EINVAL if the file is
+ *		not an index of this machine's byte order)
+ */
+sidx_t *sidx_open(const char *path);
+
+/**
+ * Merge the delta into the base and write the index
+ *
+ * The file is written next to @p path and renamed over it, so a reader
+ * never sees it half-written.
+ *
+ * @return	0, or -1 on error (errno set)
+ */
+int sidx_save(sidx_t *x, const char *path);
+
+void sidx_close(sidx_t *x);
+
+double sidx_cell_deg(const sidx_t *x);
+
+uint64_t sidx_nr_points(const sidx_t *x);
+
+/// Cells with at least one sample (a cell in base and delta counts once)
+uint64_t sidx_nr_cells(const sidx_t *x);
+
+/// Add one sample to the delta; 0, or -1 if out of memory
+int sidx_insert(sidx_t *x, const sidx_point_t *p);
+
+/// Add many samples to the base, sorting them on @p threads threads
+int sidx_insert_many(sidx_t *x, const sidx_point_t *p, size_t n, int threads);
+
+/**
+ * Add the rows with a position of every archive to the base
+ *
+ * The blocks of all archives are shared out between @p threads threads,
+ * which decode and sort them.
+ *
+ * @return	0, or -1 on error (errno set; EINVAL for a damaged archive)
+ */
+int sidx_bulk_load(sidx_t *x, const char *const *archives, int nr_archives, int threads);
+
+/// Convert an archive row (which must have a position)
+void sidx_point_from_row(sidx_point_t *p, const sarc_row_t *row);
+
+/**
+ * Call @p fn for every sample in @p box
+ *
+ * @return	0, or the first non-zero value @p fn returned
+ */
+int sidx_window(const sidx_t *x, const sidx_box_t *box,
+		int (*fn)(void *user, const sidx_point_t *p), void *user);
+
+/// Add PM channel @p k of the samples in @p box to @p a (zero it first)
+void sidx_window_agg(const sidx_t *x, const sidx_box_t *box, int k, sidx_agg_t *a);
+
+/**
+ * Call @p fn for every cell that overlaps @p box
+ *
+ * The whole cell is counted, also where it reaches outside the box.
+ *
+ * @return	0, or the first non-zero value @p fn returned
+ */
+int sidx_cells(const sidx_t *x, const sidx_box_t *box,
+	       int (*fn)(void *user, const sidx_cell_stats_t *c), void *user);
+
+/**
+ * Find the @p k samples nearest to a point
+ *
+ * @param	out	Room for @p k samples, nearest first
+ * @param	dist_m	Room for @p k distances in metres, or NULL
+ *
+ * @return	Number of samples found (less than @p k if the index is smaller)
+ */
+size_t sidx_nearest(const sidx_t *x, double lat, double lon, size_t k,
+		    sidx_point_t *out, double *dist_m);
+
+#endif // SIDX_H_
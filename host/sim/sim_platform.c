@@ -0,0 +1,576 @@
+/**
+ * @file host/sim/sim_platform.c
+ * @brief Simulated board: the platform layer for running the firmware on the host
+ *
+ * See sim_platform.h. Nothing here runs on its own: the receive lines are
+ * advanced to the current time whenever the firmware calls
+ * platform_do_loop_one(), which is where the interrupt-driven drivers would
+ * have done the same work between loop iterations.
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "platform.h"
+#include "sim_platform.h"
+
+__thread sim_board_t *sim_board;
+
+/// Character times of silence that complete a partly filled buffer
+#define SIM_IDLE_CHARS	3
+
+/// Busy polls of the terminal within one loop iteration taken as a wait loop
+#define SIM_SPIN_POLLS	64
+
+/// Fragments accepted by one terminal transmission, as in platform/usart.c
+#define SIM_TX_FRAGS_MAX 32
+
+static uint64_t host_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t board_clock(const sim_board_t *b)
+{
+	return b->clock_ns != NULL ? *b->clock_ns : host_ns();
+}
+
+static uint64_t board_ns(const sim_board_t *b)
+{
+	return board_clock(b) - b->t0_ns;
+}
+
+uint64_t sim_board_now_us(const sim_board_t *b)
+{
+	return board_ns(b) / 1000u;
+}
+
+void sim_board_init(sim_board_t *b, int cdc_fd, uint32_t baud)
+{
+	memset(b, 0, sizeof(*b));
+	b->baud   = baud;
+	b->cdc_fd = cdc_fd;
+	b->byte_ns = (uint32_t)(10000000000ull / baud);
+	b->t0_ns  = host_ns();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Receive lines
+
+uint64_t sim_sensor_on_ns(const sim_sensor_t *s, uint64_t t_ns)
+{
+	uint64_t on = (uint64_t)s->on_s * 1000000000u;
+	uint64_t cycle = on + (uint64_t)s->off_s * 1000000000u;
+	uint64_t part;
+
+	if (s->off_s == 0)
+		return t_ns;
+	part = t_ns % cycle;
+	return t_ns / cycle * on + (part < on ? part : on);
+}
+
+static bool line_powered(const sim_sensor_t *s, uint64_t t_us)
+{
+	uint64_t cycle = (uint64_t)s->on_s + s->off_s;
+
+	return s->off_s == 0 || t_us % (cycle * 1000000u) < (uint64_t)s->on_s * 1000000u;
+}
+
+static void line_complete(sim_sensor_t *s)
+{
+	++s->buffers;
+	s->desc->compl_info.data_len = s->idx;
+	s->desc->compl_type = PLATFORM_USART_RX_COMPL_DATA;
+	s->desc = NULL;
+	s->idx = 0;
+}
+
+static bool line_arm(sim_sensor_t *s, platform_usart_rx_async_desc_t *desc)
+{
+	if (!desc || !desc->buf || desc->max_len == 0 || s->desc != NULL)
+		return false;
+	desc->compl_type = PLATFORM_USART_RX_COMPL_NONE;
+	desc->compl_info.data_len = 0;
+	s->idx  = 0;
+	s->desc = desc;
+	return true;
+}
+
+static void line_abort(sim_sensor_t *s)
+{
+	if (s->desc != NULL)
+		line_complete(s);
+}
+
+// Sensors are not clocked by the board; without jitter a report would meet
+// the firmware's output at the same point of its cycle every time (xorshift32)
+static uint32_t line_rng(sim_sensor_t *s)
+{
+	uint32_t x = s->seed ? s->seed : 0x2545F491u;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	s->seed = x;
+	return x;
+}
+
+// True with probability @p p
+static bool line_chance(sim_sensor_t *s, double p)
+{
+	return p > 0 && line_rng(s) < p * 4294967296.0;
+}
+
+// Trials until the first success, each with probability @p p (p > 0)
+static uint64_t line_geometric(sim_sensor_t *s, double p)
+{
+	double u = (line_rng(s) + 0.5) / 4294967296.0;
+
+	if (p >= 1)
+		return 1;
+	return 1 + (uint64_t)(log(u) / log1p(-p));
+}
+
+/*
+ * What a receiver sampling at its own rate reads from a sender whose clock is
+ * @p ppm fast: bit k of the frame (start bit 0, stop bit 9) is sampled in its
+ * middle, which falls in the sender's bit (k + 0.5) * (1 + ppm / 1e6). Past
+ * the stop bit the line is idle, or the next start bit if one follows at once.
+ */
+static uint8_t line_sample(sim_impair_t *im, uint8_t c)
+{
+	uint16_t frame = (uint16_t)(0x200u | ((unsigned)c << 1));
+	double scale = 1 + im->baud_ppm / 1e6;
+	uint8_t out = 0;
+
+	for (int k = 1; k <= 9; ++k) {
+		int j = (int)floor((k + 0.5) * scale);
+		int bit = (j < 0) ? 1 : (j <= 9) ? (frame >> j) & 1 : 0;
+
+		if (k <= 8)
+			out |= (uint8_t)(bit << (k - 1));
+		else if (!bit)
+			++im->framing;
+	}
+	if (out != c)
+		++im->misread;
+	return out;
+}
+
+// Work out how, and when, the byte at @c pos arrives
+static void line_stage(const sim_board_t *b, sim_sensor_t *s)
+{
+	sim_impair_t *im = &s->impair;
+	uint64_t byte_ns = b->byte_ns;
+	uint8_t c = s->buf[s->pos];
+
+	if (s->pos == 0)
+		s->slip_ns = 0;
+	if (im->baud_ppm != 0)
+		byte_ns = (uint64_t)(byte_ns / (1 + im->baud_ppm / 1e6));
+	if (im->gap_ns != 0)
+		s->slip_ns += line_rng(s) % im->gap_ns;
+	s->at_ns = s->start_us * 1000u + (s->pos + 1) * byte_ns + s->slip_ns;
+	s->copies = 1;
+
+	if (im->burst_left == 0 && line_chance(s, im->burst_p))
+		im->burst_left = im->burst_len > 1 ?
+				 line_geometric(s, 1 / im->burst_len) : 1;
+	if (im->burst_left != 0) {
+		--im->burst_left;
+		++im->dropped;
+		s->copies = 0;
+	} else {
+		if (im->baud_ppm != 0)
+			c = line_sample(im, c);
+		if (im->ber > 0) {
+			if (im->bits_left == 0)
+				im->bits_left = line_geometric(s, im->ber);
+			while (im->bits_left <= 8) {
+				c ^= (uint8_t)(1u << (im->bits_left - 1));
+				++im->flipped;
+				im->bits_left += line_geometric(s, im->ber);
+			}
+			im->bits_left -= 8;
+		}
+		if (line_chance(s, im->dup_p)) {
+			++im->duplicated;
+			s->copies = 2;
+		}
+	}
+	if ((s->copies != 1 || c != s->buf[s->pos]) && im->hit_us == 0)
+		im->hit_us = s->at_ns / 1000u;
+	s->value = c;
+	s->staged = true;
+}
+
+// Bring a line up to @p now_ns
+static void line_service(const sim_board_t *b, sim_sensor_t *s, uint64_t now_ns)
+{
+	uint64_t now = now_ns / 1000u;
+	uint64_t byte_ns = b->byte_ns;
+
+	if (s->report == NULL)
+		return;
+	if (s->next_us == 0 && s->reports == 0)
+		s->next_us = s->phase_us;
+
+	/*
+	 * The firmware's loop is far faster on the target than the rate at
+	 * which boards are stepped here, so a buffer that filled up since the
+	 * last iteration holds the rest of the line until the firmware has had
+	 * one iteration to arm the next one. Only then are bytes lost.
+	 */
+	s->held = false;
+
+	for (;;) {
+		// Start the next report once the previous one is on the wire
+		if (s->pos == s->len && now >= s->next_us) {
+			if (s->period_us != 0 && !line_powered(s, s->next_us)) {
+				++s->skipped;
+				s->next_us += s->period_us;
+				continue;
+			}
+			s->start_us = s->next_us;
+			s->next_us += s->period_us;
+			if (s->jitter_us != 0)
+				s->start_us += line_rng(s) % s->jitter_us;
+			s->len = s->report(s->user, s->seq++, s->buf, sizeof(s->buf));
+			s->pos = 0;
+			++s->reports;
+			if (s->period_us == 0)
+				break;
+		}
+
+		// Bytes whose stop bit has arrived by now
+		while (s->pos < s->len) {
+			if (!s->staged)
+				line_stage(b, s);
+			if (s->at_ns > now_ns)
+				break;
+			if (s->copies == 0) {
+				s->staged = false;
+				++s->pos;
+				continue;
+			}
+			if (s->desc == NULL) {
+				if (s->held)
+					break;
+				if (s->impair.hit_us == 0)
+					s->impair.hit_us = s->at_ns / 1000u;
+				++s->lost;
+			} else {
+				s->desc->buf[s->idx++] = (char)s->value;
+				s->last_us = s->at_ns / 1000u;
+				++s->bytes;
+				if (s->idx >= s->desc->max_len) {
+					line_complete(s);
+					s->held = true;
+				}
+			}
+
+			// A duplicate follows one character later
+			if (--s->copies != 0) {
+				s->slip_ns += b->byte_ns;
+				s->at_ns += b->byte_ns;
+				continue;
+			}
+			s->staged = false;
+			++s->pos;
+		}
+		if (s->pos < s->len || now < s->next_us)
+			break;
+
+		// A report longer than its period delays the ones after it
+		if (s->start_us + (s->len * byte_ns + s->slip_ns) / 1000u > s->next_us) {
+			++s->late;
+			s->next_us += s->period_us;
+		}
+	}
+
+	// IDLE timeout
+	if (s->desc != NULL && s->idx > 0 && s->pos == s->len &&
+	    now >= s->last_us + (SIM_IDLE_CHARS * byte_ns) / 1000u)
+		line_complete(s);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Terminal
+
+static void cdc_service(sim_board_t *b)
+{
+	platform_usart_rx_async_desc_t *desc = b->cdc_rx;
+	ssize_t n;
+
+	if (desc == NULL || b->cdc_fd < 0)
+		return;
+	n = read(b->cdc_fd, desc->buf, desc->max_len);
+	if (n <= 0)
+		return;
+	b->cdc_rx_bytes += (uint64_t)n;
+	desc->compl_info.data_len = (uint16_t)n;
+	desc->compl_type = PLATFORM_USART_RX_COMPL_DATA;
+	b->cdc_rx = NULL;
+}
+
+// A firmware waiting on a busy terminal hands the thread over
+static bool cdc_busy_poll(sim_board_t *b)
+{
+	if (board_ns(b) >= b->tx_until_ns)
+		return false;
+	if (++b->spins > SIM_SPIN_POLLS && b->yield != NULL)
+		b->yield(b);
+	return true;
+}
+
+bool platform_usart_cdc_tx_async(const platform_usart_tx_bufdesc_t *desc,
+				 unsigned int nr_desc)
+{
+	sim_board_t *b = sim_board;
+	struct iovec iov[SIM_TX_FRAGS_MAX];
+	size_t total = 0;
+	ssize_t n = 0;
+
+	if (nr_desc == 0 || nr_desc > SIM_TX_FRAGS_MAX || cdc_busy_poll(b))
+		return false;
+	for (unsigned int i = 0; i < nr_desc; ++i) {
+		iov[i].iov_base = (void *)desc[i].buf;
+		iov[i].iov_len  = desc[i].len;
+		total += desc[i].len;
+	}
+
+	/*
+	 * The bytes are copied out at once, so the caller's buffers are free
+	 * early; the line still stays busy for as long as the wire would.
+	 */
+	if (b->cdc_fd >= 0) {
+		n = writev(b->cdc_fd, iov, (int)nr_desc);
+		if (n < 0)
+			n = 0;
+	}
+	++b->cdc_tx_calls;
+	b->cdc_tx_bytes += total;
+	b->cdc_tx_dropped += total - (size_t)n;
+	b->tx_until_ns = board_ns(b) + (uint64_t)total * b->byte_ns;
+	return true;
+}
+
+void platform_usart_cdc_tx_abort(void)
+{
+	sim_board->tx_until_ns = 0;
+}
+
+bool platform_usart_cdc_tx_busy(void)
+{
+	return cdc_busy_poll(sim_board);
+}
+
+bool platform_usart_cdc_rx_async(platform_usart_rx_async_desc_t *desc)
+{
+	sim_board_t *b = sim_board;
+
+	if (!desc || !desc->buf || desc->max_len == 0 || b->cdc_rx != NULL)
+		return false;
+	desc->compl_type = PLATFORM_USART_RX_COMPL_NONE;
+	desc->compl_info.data_len = 0;
+	b->cdc_rx = desc;
+	return true;
+}
+
+void platform_usart_cdc_rx_abort(void)
+{
+	sim_board_t *b = sim_board;
+
+	if (b->cdc_rx != NULL) {
+		b->cdc_rx->compl_info.data_len = 0;
+		b->cdc_rx->compl_type = PLATFORM_USART_RX_COMPL_DATA;
+		b->cdc_rx = NULL;
+	}
+}
+
+bool platform_usart_cdc_rx_busy(void)
+{
+	return sim_board->cdc_rx != NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Sensor receivers (src/drivers/)
+
+bool gps_platform_usart_cdc_rx_async(platform_usart_rx_async_desc_t *desc)
+{
+	return line_arm(&sim_board->gps, desc);
+}
+
+void gps_platform_usart_cdc_rx_abort(void)
+{
+	line_abort(&sim_board->gps);
+}
+
+bool gps_platform_usart_cdc_rx_busy(void)
+{
+	return sim_board->gps.desc != NULL;
+}
+
+void gps_platform_usart_init(void)
+{
+}
+
+void gps_platform_usart_tick_handler(const platform_timespec_t *tick)
+{
+	(void)tick;
+}
+
+bool pm_platform_usart_cdc_rx_async(platform_usart_rx_async_desc_t *desc)
+{
+	return line_arm(&sim_board->pm, desc);
+}
+
+void pm_platform_usart_cdc_rx_abort(void)
+{
+	line_abort(&sim_board->pm);
+}
+
+bool pm_platform_usart_cdc_rx_busy(void)
+{
+	return sim_board->pm.desc != NULL;
+}
+
+void pm_platform_usart_init(void)
+{
+}
+
+void pm_platform_usart_tick_handler(const platform_timespec_t *tick)
+{
+	(void)tick;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Board
+
+void platform_init(void)
+{
+	sim_board_t *b = sim_board;
+
+	b->t0_ns = board_clock(b);
+	b->tx_until_ns = 0;
+	b->gpo_ns = 0;
+}
+
+void platform_do_loop_one(void)
+{
+	sim_board_t *b = sim_board;
+	uint64_t now;
+
+	++b->loops;
+	b->spins = 0;
+	if (b->yield != NULL)
+		b->yield(b);
+
+	now = board_ns(b);
+	line_service(b, &b->gps, now);
+	line_service(b, &b->pm, now);
+	cdc_service(b);
+}
+
+uint16_t platform_pb_get_event(void)
+{
+	return 0;
+}
+
+void platform_gpo_modify(uint16_t set, uint16_t clr)
+{
+	sim_board_t *b = sim_board;
+	uint64_t now = board_ns(b);
+
+	if (b->gpo & PLATFORM_GPO_LED_ONBOARD)
+		b->led_ns += now - b->gpo_ns;
+	b->gpo_ns = now;
+	b->gpo = (uint16_t)((b->gpo | set) & ~clr);
+}
+
+void platform_tick_count(platform_timespec_t *tick)
+{
+	uint64_t ns = board_ns(sim_board);
+
+	// Whole ticks only, as the SysTick handler counts them
+	ns -= ns % (PLATFORM_TICK_PERIOD_US * 1000u);
+	tick->nr_sec  = (uint32_t)(ns / 1000000000u);
+	tick->nr_nsec = (uint32_t)(ns % 1000000000u);
+}
+
+void platform_tick_hrcount(platform_timespec_t *tick)
+{
+	uint64_t ns = board_ns(sim_board);
+
+	tick->nr_sec  = (uint32_t)(ns / 1000000000u);
+	tick->nr_nsec = (uint32_t)(ns % 1000000000u);
+}
+
+int platform_timespec_compare(const platform_timespec_t *lhs,
+	const platform_timespec_t *rhs)
+{
+	if (lhs->nr_sec != rhs->nr_sec)
+		return (lhs->nr_sec < rhs->nr_sec) ? -1 : +1;
+	if (lhs->nr_nsec != rhs->nr_nsec)
+		return (lhs->nr_nsec < rhs->nr_nsec) ? -1 : +1;
+	return 0;
+}
+
+void platform_tick_delta(
+	platform_timespec_t *diff,
+	const platform_timespec_t *lhs, const platform_timespec_t *rhs
+	)
+{
+	uint64_t l = (uint64_t)lhs->nr_sec * 1000000000u + lhs->nr_nsec;
+	uint64_t r = (uint64_t)rhs->nr_sec * 1000000000u + rhs->nr_nsec;
+	uint64_t d = (l >= r) ? (l - r) : 0;
+
+	diff->nr_sec  = (uint32_t)(d / 1000000000u);
+	diff->nr_nsec = (uint32_t)(d % 1000000000u);
+}
+
+// No DSU on the host; crc32.c falls back to its table
+bool platform_dsu_crc32(const void *addr, uint32_t len, uint32_t *crc)
+{
+	(void)addr;
+	(void)len;
+	(void)crc;
+	return false;
+}
+
+bool platform_rxcap_take(unsigned int src, uint32_t *age_us)
+{
+	(void)src;
+	(void)age_us;
+	return false;
+}
+
+// Host stack frames say nothing about the M23's; nothing is watched
+void platform_stack_get_stats(platform_stack_stats_t *out)
+{
+	memset(out, 0, sizeof(*out));
+}
+
+// Nothing runs as an interrupt on the host; there is nothing to mask or time
+platform_crit_t platform_crit_enter(void)
+{
+	return 0;
+}
+
+void platform_crit_exit(platform_crit_t state)
+{
+	(void)state;
+}
+
+void platform_crit_get_stats(platform_crit_stats_t *out)
+{
+	memset(out, 0, sizeof(*out));
+}
@@ -0,0 +1,189 @@
+/**
+ * @file host/sim/sim_platform.h
+ * @brief Simulated board: the platform layer for running the firmware on the host
+ *
+ * The model stands in for platform/ and src/drivers/: it implements every
+ * function the application calls from platform.h (plus the GPS and PM
+ * receivers), so src/main.c and everything it links run on the host
+ * unmodified. Any number of boards can exist in one process; the platform
+ * functions act on the board in @c sim_board, which the tool sets on the
+ * running thread before entering a board's firmware.
+ *
+ * Each sensor UART delivers its reports byte by byte at the configured
+ * baud rate into whichever receive descriptor the firmware has armed. A
+ * descriptor completes when it fills up or when the line has been idle for
+ * three character times, as in the drivers; bytes that arrive while the
+ * firmware goes a whole loop iteration without arming a descriptor are lost
+ * and counted, as the hardware would lose them. Each receive line can also
+ * be impaired (sim_impair_t) the way long cables and noisy supplies impair
+ * a real one: flipped bits, bursts of lost bytes, duplicated bytes, a sender
+ * whose clock is off, and gaps between characters. The terminal UART writes
+ * to a file descriptor (normally a pty master) and stays busy for as long
+ * as the bytes would take on the wire; console input is read from the same
+ * descriptor.
+ *
+ * A sensor can be powered on and off on a fixed duty cycle; it sends
+ * nothing while off. The board keeps the counts that the energy model
+ * (sim_power.h) turns into charge: bytes and buffers delivered, terminal
+ * transmissions, and the time each sensor and the LED were on.
+ *
+ * Time is the host's monotonic clock, measured from platform_init(), unless
+ * the tool gives the board a virtual clock of its own.
+ */
+
+#if !defined(SIM_PLATFORM_H_)
+#define SIM_PLATFORM_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "platform.h"
+
+/**
+ * Produce a sensor's next report
+ *
+ * @param	user	Opaque pointer given with the sensor
+ * @param	seq	Report number, from zero
+ * @param	buf	Where to store the report
+ * @param	size	Size of @p buf
+ *
+ * @return	Number of bytes stored; zero sends nothing this period
+ */
+typedef size_t (*sim_report_fn)(void *user, uint64_t seq, uint8_t *buf,
+				size_t size);
+
+/// Maximum size of a single sensor report
+#define SIM_REPORT_MAX 2048
+
+/**
+ * Impairment of a receive line; all zero for a clean line
+ *
+ * Damage is applied byte by byte as the bytes arrive, from the line's own
+ * PRNG, so a run is repeatable for a given seed.
+ */
+typedef struct sim_impair_type {
+	double    ber;		///< Probability of each data bit arriving flipped
+	double    burst_p;	///< Probability per byte of a burst of losses starting
+	double    burst_len;	///< Mean length of a burst, in bytes
+	double    dup_p;	///< Probability per byte of it arriving twice
+	int32_t   baud_ppm;	///< Error of the sender's clock, in parts per million
+	uint32_t  gap_ns;	///< Each character is preceded by up to this much idle time
+
+	// Counters
+	uint64_t  flipped;	///< Bits flipped
+	uint64_t  dropped;	///< Bytes lost in bursts
+	uint64_t  duplicated;	///< Bytes delivered twice
+	uint64_t  misread;	///< Bytes sampled wrongly because of the clock error
+	uint64_t  framing;	///< ... of which had a bad stop bit
+	uint64_t  hit_us;	///< Arrival of the earliest byte damaged or lost
+				///< (for any reason) since the tool last zeroed this
+
+	// Private
+	uint64_t  burst_left;	///< Bytes still to lose in the current burst
+	uint64_t  bits_left;	///< Next flipped bit, counted from the next byte's first
+} sim_impair_t;
+
+/// A sensor attached to one of the receive UARTs
+typedef struct sim_sensor_type {
+	sim_report_fn report;	///< Report generator; NULL for a silent line
+	void     *user;		///< Passed to @c report
+	uint32_t  period_us;	///< Time between the starts of two reports
+	uint32_t  phase_us;	///< Start of the first report after platform_init()
+	uint32_t  jitter_us;	///< Each report starts up to this much late
+	uint32_t  seed;		///< State of the jitter's PRNG
+	sim_impair_t impair;	///< Line impairment
+	uint32_t  on_s;		///< Duty cycle: seconds powered, from platform_init()...
+	uint32_t  off_s;	///< ... then seconds off; 0 for always on
+
+	// Counters
+	uint64_t  reports;	///< Reports started
+	uint64_t  bytes;	///< Bytes stored into receive buffers
+	uint64_t  lost;		///< Bytes that arrived with no buffer armed
+	uint64_t  late;		///< Reports skipped because the previous one was still on the wire
+	uint64_t  buffers;	///< Receive buffers completed
+	uint64_t  skipped;	///< Reports not sent because the sensor was off
+
+	// Line state (private)
+	uint8_t   buf[SIM_REPORT_MAX];
+	size_t    len, pos;
+	uint64_t  seq;
+	uint64_t  start_us;	///< Arrival of the current report's first bit
+	uint64_t  next_us;	///< Start of the next report
+	uint64_t  last_us;	///< Arrival of the last byte stored
+	platform_usart_rx_async_desc_t *desc;
+	uint16_t  idx;
+	bool      held;		///< A buffer filled since the last loop iteration
+
+	// Next byte on the wire, once impaired (private)
+	bool      staged;
+	uint8_t   copies;	///< Times it arrives: 0 (lost), 1 or 2
+	uint8_t   value;
+	uint64_t  at_ns;	///< Arrival of its stop bit
+	uint64_t  slip_ns;	///< Gaps and duplicates so far in this report
+} sim_sensor_t;
+
+/// One simulated board
+typedef struct sim_board_type {
+	uint32_t baud;		///< Rate of all three UARTs
+	int      cdc_fd;	///< Terminal; non-blocking, or -1 to discard output
+	sim_sensor_t gps;	///< Sensor on the GPS UART
+	sim_sensor_t pm;	///< Sensor on the PM UART
+
+	/**
+	 * Called at the start of every platform_do_loop_one(), and whenever the
+	 * firmware keeps polling a busy terminal without running its loop;
+	 * the tool uses it to hand the thread to another board.
+	 */
+	void   (*yield)(struct sim_board_type *b);
+	void    *user;		///< For the tool's use
+	const uint64_t *clock_ns; ///< Virtual time for the board; NULL for the host's
+
+	// Counters
+	uint64_t loops;		///< Calls to platform_do_loop_one()
+	uint64_t cdc_tx_bytes;	///< Bytes accepted for the terminal
+	uint64_t cdc_tx_dropped;///< ... of which the descriptor would not take
+	uint64_t cdc_tx_calls;	///< Transmissions started on the terminal
+	uint64_t cdc_rx_bytes;	///< Console bytes delivered to the firmware
+	uint16_t gpo;		///< Output state (PLATFORM_GPO_*)
+	uint64_t led_ns;	///< Time the LED was on, up to its last change
+	uint64_t gpo_ns;	///< Time of the last output change
+
+	// Private
+	uint64_t t0_ns;		///< Host time at platform_init()
+	uint32_t byte_ns;	///< One character (10 bits) at @c baud
+	uint64_t tx_until_ns;	///< Terminal busy until this time
+	uint32_t spins;		///< Busy polls since the last loop iteration
+	platform_usart_rx_async_desc_t *cdc_rx;
+} sim_board_t;
+
+/// The board that the platform functions act on; set per thread by the tool
+extern __thread sim_board_t *sim_board;
+
+/**
+ * Prepare a board
+ *
+ * Sensors are silent until their @c report member is set. A virtual clock
+ * (@c clock_ns) and line impairments are set after this, before
+ * platform_init().
+ *
+ * @param	b	Board
+ * @param	cdc_fd	Terminal descriptor, or -1
+ * @param	baud	UART rate
+ */
+void sim_board_init(sim_board_t *b, int cdc_fd, uint32_t baud);
+
+/// Microseconds since the board's platform_init()
+uint64_t sim_board_now_us(const sim_board_t *b);
+
+/**
+ * Time a sensor has been powered
+ *
+ * @param	s	Sensor
+ * @param	t_ns	Time since platform_init()
+ *
+ * @return	Time powered in [0, @p t_ns], in nanoseconds
+ */
+uint64_t sim_sensor_on_ns(const sim_sensor_t *s, uint64_t t_ns);
+
+#endif	// !defined(SIM_PLATFORM_H_)
@@ -0,0 +1,175 @@
+/**
+ * @file host/sim/sim_power.c
+ * @brief Energy model of a simulated board
+ *
+ * See sim_power.h.
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <string.h>
+
+#include "sim_power.h"
+
+/// An entry of the table: name, default and unit
+static const struct {
+	const char *name;
+	double      def;
+	const char *unit;
+} entries[SIM_PWR_NR_ENTRIES] = {
+	[SIM_PWR_CPU_MHZ]   = { "cpu_mhz",   24,     "MHz" },
+	[SIM_PWR_PL]        = { "pl",        2,      "performance level" },
+	[SIM_PWR_RUN_PL0]   = { "run_pl0",   45,     "uA/MHz" },
+	[SIM_PWR_RUN_PL2]   = { "run_pl2",   65,     "uA/MHz" },
+	[SIM_PWR_IDLE_PL0]  = { "idle_pl0",  15,     "uA/MHz" },
+	[SIM_PWR_IDLE_PL2]  = { "idle_pl2",  22,     "uA/MHz" },
+	[SIM_PWR_CLOCKS]    = { "clocks",    330,    "uA" },
+	[SIM_PWR_SERCOM]    = { "sercom",    45,     "uA" },
+	[SIM_PWR_TX]        = { "tx",        60,     "uA" },
+	[SIM_PWR_LED]       = { "led",       2000,   "uA" },
+	[SIM_PWR_GPS_ACQ]   = { "gps_acq",   45000,  "uA" },
+	[SIM_PWR_GPS_TRACK] = { "gps_track", 37000,  "uA" },
+	[SIM_PWR_GPS_OFF]   = { "gps_off",   15,     "uA" },
+	[SIM_PWR_GPS_TTFF]  = { "gps_ttff",  30,     "s" },
+	[SIM_PWR_PM_ON]     = { "pm_on",     80000,  "uA" },
+	[SIM_PWR_PM_OFF]    = { "pm_off",    200,    "uA" },
+	[SIM_PWR_BOARD]     = { "board",     150,    "uA" },
+	[SIM_PWR_C_LOOP]    = { "c_loop",    900,    "cycles" },
+	[SIM_PWR_C_RX_BYTE] = { "c_rx_byte", 80,     "cycles" },
+	[SIM_PWR_C_RX_DONE] = { "c_rx_done", 150,    "cycles" },
+	[SIM_PWR_C_TX]      = { "c_tx",      2500,   "cycles" },
+	[SIM_PWR_C_TX_BYTE] = { "c_tx_byte", 10,     "cycles" },
+};
+
+static const char *const part_names[SIM_PART_NR] = {
+	[SIM_PART_CPU]   = "cpu",
+	[SIM_PART_UART]  = "uart",
+	[SIM_PART_LED]   = "led",
+	[SIM_PART_GPS]   = "gps",
+	[SIM_PART_PM]    = "pm",
+	[SIM_PART_BOARD] = "board",
+};
+
+void sim_power_table_default(sim_power_table_t *t)
+{
+	for (int i = 0; i < SIM_PWR_NR_ENTRIES; ++i)
+		t->v[i] = entries[i].def;
+}
+
+int sim_power_table_set(sim_power_table_t *t, const char *spec)
+{
+	const char *eq = strchr(spec, '=');
+	char *end;
+	double v;
+
+	if (eq == NULL)
+		return -1;
+	v = strtod(eq + 1, &end);
+	if (end == eq + 1 || *end != '\0' || v < 0)
+		return -1;
+	for (int i = 0; i < SIM_PWR_NR_ENTRIES; ++i) {
+		if (strlen(entries[i].name) == (size_t)(eq - spec) &&
+		    strncmp(entries[i].name, spec, (size_t)(eq - spec)) == 0) {
+			t->v[i] = v;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+void sim_power_table_print(const sim_power_table_t *t, FILE *f)
+{
+	for (int i = 0; i < SIM_PWR_NR_ENTRIES; ++i)
+		fprintf(f, "  %-10s %9g %s\n", entries[i].name, t->v[i], entries[i].unit);
+}
+
+const char *sim_power_part_name(sim_power_part_t part)
+{
+	return part_names[part];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+// Time spent acquiring: the first @p ttff_ns of every period powered
+static uint64_t acq_ns(const sim_sensor_t *s, uint64_t t_ns, uint64_t ttff_ns)
+{
+	uint64_t on, cycle, part;
+
+	if (s->off_s == 0)
+		return t_ns < ttff_ns ? t_ns : ttff_ns;
+	on = (uint64_t)s->on_s * 1000000000u;
+	cycle = on + (uint64_t)s->off_s * 1000000000u;
+	if (ttff_ns > on)
+		ttff_ns = on;
+	part = t_ns % cycle;
+	return t_ns / cycle * ttff_ns + (part < ttff_ns ? part : ttff_ns);
+}
+
+// Charge in mAh of a current in uA over a time in ns
+static double mah(double ua, double ns)
+{
+	return ua * ns / 3.6e15;
+}
+
+void sim_power_account(const sim_power_table_t *t, const sim_board_t *b,
+		       sim_power_t *p)
+{
+	const double *v = t->v;
+	uint64_t now = sim_board_now_us(b) * 1000u;
+	double mhz = v[SIM_PWR_CPU_MHZ];
+	bool pl2 = v[SIM_PWR_PL] >= 1;
+	double run = mhz * v[pl2 ? SIM_PWR_RUN_PL2 : SIM_PWR_RUN_PL0];
+	double idle = mhz * v[pl2 ? SIM_PWR_IDLE_PL2 : SIM_PWR_IDLE_PL0];
+	double cycles, busy_ns, tx_ns, led_ns;
+
+	memset(p, 0, sizeof(*p));
+	p->hours = now / 3.6e12;
+	if (now == 0)
+		return;
+
+	// CPU: running throughout as built; the estimated work otherwise
+	cycles = b->loops * v[SIM_PWR_C_LOOP] +
+		 (b->gps.bytes + b->pm.bytes) * v[SIM_PWR_C_RX_BYTE] +
+		 (b->gps.buffers + b->pm.buffers) * v[SIM_PWR_C_RX_DONE] +
+		 b->cdc_tx_calls * v[SIM_PWR_C_TX] +
+		 b->cdc_tx_bytes * v[SIM_PWR_C_TX_BYTE];
+	busy_ns = mhz > 0 ? cycles * 1e3 / mhz : 0;
+	if (busy_ns > now)
+		busy_ns = now;
+	p->cpu_busy = busy_ns / now;
+	p->mah[SIM_PART_CPU] = mah(run + v[SIM_PWR_CLOCKS], now);
+	p->cpu_sleep_mah = mah(run, busy_ns) + mah(idle, now - busy_ns) +
+			   mah(v[SIM_PWR_CLOCKS], now);
+
+	// Terminal and both sensor lines
+	tx_ns = (double)b->cdc_tx_bytes * b->byte_ns;
+	if (tx_ns > now)
+		tx_ns = now;
+	p->mah[SIM_PART_UART] = mah(3 * v[SIM_PWR_SERCOM], now) + mah(v[SIM_PWR_TX], tx_ns);
+
+	led_ns = b->led_ns;
+	if (b->gpo & PLATFORM_GPO_LED_ONBOARD)
+		led_ns += now - b->gpo_ns;
+	p->mah[SIM_PART_LED] = mah(v[SIM_PWR_LED], led_ns);
+
+	// Sensors; a line with nothing on it has no sensor fitted
+	if (b->gps.report != NULL) {
+		uint64_t on = sim_sensor_on_ns(&b->gps, now);
+		uint64_t acq = acq_ns(&b->gps, now, (uint64_t)(v[SIM_PWR_GPS_TTFF] * 1e9));
+
+		p->mah[SIM_PART_GPS] = mah(v[SIM_PWR_GPS_ACQ], acq) +
+				       mah(v[SIM_PWR_GPS_TRACK], on - acq) +
+				       mah(v[SIM_PWR_GPS_OFF], now - on);
+	}
+	if (b->pm.report != NULL) {
+		uint64_t on = sim_sensor_on_ns(&b->pm, now);
+
+		p->mah[SIM_PART_PM] = mah(v[SIM_PWR_PM_ON], on) +
+				      mah(v[SIM_PWR_PM_OFF], now - on);
+	}
+	p->mah[SIM_PART_BOARD] = mah(v[SIM_PWR_BOARD], now);
+
+	for (int i = 0; i < SIM_PART_NR; ++i)
+		p->total_mah += p->mah[i];
+	p->total_sleep_mah = p->total_mah - p->mah[SIM_PART_CPU] + p->cpu_sleep_mah;
+}
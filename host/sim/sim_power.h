@@ -0,0 +1,120 @@
+/**
+ * @file host/sim/sim_power.h
+ * @brief Energy model of a simulated board
+ *
+ * Turns what a board did (sim_platform.h) into the charge it would have
+ * drawn from its supply, from a table of currents. The table lists, per
+ * consumer, the current of each of its power states:
+ *
+ * - the CPU at its clock and performance level (PL0 or PL2), both running
+ *   and asleep in IDLE, and the clock generators that feed it;
+ * - the SERCOMs, always on for the two sensor lines, plus the extra drawn
+ *   while the terminal transmits;
+ * - the LED;
+ * - the GPS receiver acquiring a fix after power-up, tracking, and in
+ *   backup while off;
+ * - the PMS5003 with its fan running and asleep;
+ * - whatever else on the board draws a constant current.
+ *
+ * The firmware polls in a loop and never sleeps, so as built the CPU runs
+ * the whole time. The work it actually does is estimated in cycles, from
+ * the same kind of cost table as host/tools/loopcap.c: a cost per loop
+ * iteration, per byte and buffer received, and per terminal transmission
+ * and byte. The model reports the charge as built, and the charge the CPU
+ * would draw if it slept in IDLE whenever it had no work, so that a change
+ * to the firmware's power handling can be weighed before it is written.
+ *
+ * Every entry has a name, so that a tool can take overrides as NAME=VALUE.
+ * The defaults are typical datasheet figures, not measurements of a board.
+ */
+
+#if !defined(SIM_POWER_H_)
+#define SIM_POWER_H_
+
+#include <stdio.h>
+
+#include "sim_platform.h"
+
+/// Entries of the current table
+typedef enum sim_power_entry_type {
+	SIM_PWR_CPU_MHZ,	///< CPU clock, MHz
+	SIM_PWR_PL,		///< Performance level, 0 or 2
+	SIM_PWR_RUN_PL0,	///< CPU running at PL0, uA per MHz
+	SIM_PWR_RUN_PL2,	///< CPU running at PL2, uA per MHz
+	SIM_PWR_IDLE_PL0,	///< CPU in IDLE at PL0, uA per MHz
+	SIM_PWR_IDLE_PL2,	///< CPU in IDLE at PL2, uA per MHz
+	SIM_PWR_CLOCKS,		///< DFLL and PLL, uA
+	SIM_PWR_SERCOM,		///< One enabled SERCOM, uA
+	SIM_PWR_TX,		///< Terminal SERCOM transmitting, extra uA
+	SIM_PWR_LED,		///< LED on, uA
+	SIM_PWR_GPS_ACQ,	///< GPS acquiring, uA
+	SIM_PWR_GPS_TRACK,	///< GPS tracking, uA
+	SIM_PWR_GPS_OFF,	///< GPS in backup, uA
+	SIM_PWR_GPS_TTFF,	///< Time to first fix after power-up, s
+	SIM_PWR_PM_ON,		///< PMS5003 running, uA
+	SIM_PWR_PM_OFF,		///< PMS5003 asleep, uA
+	SIM_PWR_BOARD,		///< Regulator and the rest of the board, uA
+	SIM_PWR_C_LOOP,		///< Cycles per loop iteration
+	SIM_PWR_C_RX_BYTE,	///< Cycles per byte received
+	SIM_PWR_C_RX_DONE,	///< Cycles per receive buffer completed
+	SIM_PWR_C_TX,		///< Cycles per terminal transmission
+	SIM_PWR_C_TX_BYTE,	///< Cycles per terminal byte
+	SIM_PWR_NR_ENTRIES
+} sim_power_entry_t;
+
+/// Current table
+typedef struct sim_power_table_type {
+	double v[SIM_PWR_NR_ENTRIES];
+} sim_power_table_t;
+
+/// Consumers reported separately
+typedef enum sim_power_part_type {
+	SIM_PART_CPU,		///< CPU and clocks, as built
+	SIM_PART_UART,		///< SERCOMs
+	SIM_PART_LED,
+	SIM_PART_GPS,
+	SIM_PART_PM,
+	SIM_PART_BOARD,
+	SIM_PART_NR
+} sim_power_part_t;
+
+/// Charge drawn by a board
+typedef struct sim_power_type {
+	double hours;			///< Time covered
+	double mah[SIM_PART_NR];	///< Charge per consumer, mAh
+	double total_mah;		///< Sum of @c mah
+	double cpu_busy;		///< Fraction of the time the CPU had work
+	double cpu_sleep_mah;		///< CPU and clocks, sleeping when idle
+	double total_sleep_mah;		///< Total, sleeping when idle
+} sim_power_t;
+
+/// Fill in the default table
+void sim_power_table_default(sim_power_table_t *t);
+
+/**
+ * Set one entry
+ *
+ * @param	t	Table
+ * @param	spec	NAME=VALUE
+ *
+ * @return	0, or -1 if the name is unknown or the value is not a number
+ */
+int sim_power_table_set(sim_power_table_t *t, const char *spec);
+
+/// List the entries, their values and units
+void sim_power_table_print(const sim_power_table_t *t, FILE *f);
+
+/**
+ * Work out the charge a board drew
+ *
+ * @param	t	Table
+ * @param	b	Board; its counters up to now are used
+ * @param	p	Result
+ */
+void sim_power_account(const sim_power_table_t *t, const sim_board_t *b,
+		       sim_power_t *p);
+
+/// Name of a consumer
+const char *sim_power_part_name(sim_power_part_t part);
+
+#endif	// !defined(SIM_POWER_H_)
@@ -0,0 +1,453 @@
+/**
+ * @file host/sim/sim_sdcard.c
+ * @brief Byte-level model of an SD card in SPI mode, backed by an image file
+ *
+ * See sim_sdcard.h. The card is modelled as a byte exchanger: each byte the
+ * host clocks out is fed to the card's state machine, which returns the byte
+ * it drives on MISO. Each byte is stamped with the virtual time at which it
+ * crosses the wire, so busy periods end mid-transfer exactly as they would on
+ * real hardware.
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "platform.h"
+#include "sdcard.h"
+#include "sim_sdcard.h"
+
+/// SERCOM2 GCLK on the target; SCK is derived from it as on the target
+#define SIM_SD_GCLK_HZ		24000000u
+
+/// DMA set-up cost of a transfer
+#define SIM_SD_XFER_SETUP_US	2
+
+/// Card modes
+enum {
+	CARD_CMD = 0,		///< Parsing commands
+	CARD_WR_TOKEN,		///< In CMD25, waiting for a data or stop token
+	CARD_WR_DATA,		///< Collecting a data block and its CRC
+	CARD_WR_RESP,		///< Next byte is the data response
+	CARD_STOP_STUFF,	///< Next byte is the stuff byte after a stop token
+	CARD_BUSY		///< Holding MISO low
+};
+
+static struct {
+	int fd;
+	uint32_t nr_blocks;
+	sim_sd_timing_t t;
+	bool present;
+
+	// SPI
+	uint32_t spi_hz;
+	bool selected;
+	uint64_t busy_until_us;	///< End of the transfer in flight
+
+	// Card
+	uint8_t mode;
+	uint8_t mode_after_busy;
+	uint64_t card_busy_until;
+	bool idle;		///< Not yet initialized by ACMD41
+	bool app;		///< Previous command was CMD55
+	bool init_started;
+	uint64_t init_start_us;
+	uint32_t hint;		///< Blocks announced by ACMD23 for the next CMD25
+	uint32_t wr_lba;
+	uint32_t wr_nr;		///< Blocks received by the current CMD25
+	uint32_t wr_hint;
+	uint8_t cmd[6];
+	unsigned cmd_len;
+	uint8_t blk[SD_BLOCK_SZ + 2];
+	unsigned blk_len;
+
+	// Response queue; bytes from @c gate_pos on are held until @c gate_us
+	uint8_t out[1 + 2 + 1 + 512 + 2 + 8];
+	unsigned out_len, out_pos, gate_pos;
+	uint64_t gate_us;
+
+	uint64_t now_us;	///< Time of the byte being exchanged
+	sim_sd_stats_t stats;
+} card;
+
+/////////////////////////////////////////////////////////////////////////////
+
+static uint32_t get_be32(const uint8_t *p)
+{
+	return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+	       ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint8_t crc7(const uint8_t *p, unsigned len)
+{
+	uint8_t crc = 0;
+
+	while (len--) {
+		uint8_t c = *p++;
+		for (int i = 0; i < 8; ++i) {
+			crc <<= 1;
+			if ((c ^ crc) & 0x80)
+				crc ^= 0x09;
+			c <<= 1;
+		}
+	}
+	return crc & 0x7F;
+}
+
+static void respond(const uint8_t *b, unsigned len)
+{
+	memcpy(card.out, b, len);
+	card.out_len = len;
+	card.out_pos = 0;
+	card.gate_pos = len;
+}
+
+/// Append a data block (token, @p len bytes, CRC) released at @p ready_us
+static void respond_data(const uint8_t *d, unsigned len, uint64_t ready_us)
+{
+	card.gate_pos = card.out_len;
+	card.gate_us = ready_us;
+	card.out[card.out_len++] = 0xFE;
+	memcpy(&card.out[card.out_len], d, len);
+	card.out_len += len;
+	card.out[card.out_len++] = 0x00;
+	card.out[card.out_len++] = 0x00;
+}
+
+static uint8_t r1(void)
+{
+	return card.idle ? 0x01 : 0x00;
+}
+
+static void build_csd(uint8_t *csd)
+{
+	uint32_t c_size = card.nr_blocks / 1024u - 1u;
+
+	memset(csd, 0, 16);
+	csd[0] = 0x40;			// CSD version 2.0
+	csd[5] = 0x09;			// READ_BL_LEN = 512
+	csd[7] = (uint8_t)((c_size >> 16) & 0x3F);
+	csd[8] = (uint8_t)(c_size >> 8);
+	csd[9] = (uint8_t)c_size;
+}
+
+static void do_command(void)
+{
+	uint8_t idx = card.cmd[0] & 0x3F;
+	uint32_t arg = get_be32(&card.cmd[1]);
+	bool app = card.app;
+	uint8_t resp[8];
+	uint8_t buf[SD_BLOCK_SZ];
+
+	card.app = false;
+	resp[0] = 0xFF;			// NCR
+
+	// CRC is only checked where SPI mode requires it
+	if ((idx == 0 || idx == 8) &&
+	    (card.cmd[5] >> 1) != crc7(card.cmd, 5)) {
+		resp[1] = r1() | 0x08;
+		respond(resp, 2);
+		return;
+	}
+
+	switch (idx) {
+	case 0:
+		card.idle = true;
+		card.init_started = false;
+		card.hint = 0;
+		resp[1] = 0x01;
+		respond(resp, 2);
+		break;
+	case 8:
+		resp[1] = r1();
+		resp[2] = 0x00;
+		resp[3] = 0x00;
+		resp[4] = (uint8_t)((arg >> 8) & 0x0F);
+		resp[5] = (uint8_t)arg;
+		respond(resp, 6);
+		break;
+	case 55:
+		card.app = true;
+		resp[1] = r1();
+		respond(resp, 2);
+		break;
+	case 41:
+		if (!app)
+			goto illegal;
+		if (!card.init_started) {
+			card.init_started = true;
+			card.init_start_us = card.now_us;
+		}
+		if (card.now_us - card.init_start_us >= card.t.init_us)
+			card.idle = false;
+		resp[1] = r1();
+		respond(resp, 2);
+		break;
+	case 58:
+		resp[1] = r1();
+		resp[2] = card.idle ? 0x00 : 0xC0;	// Powered up, CCS
+		resp[3] = 0xFF;
+		resp[4] = 0x80;
+		resp[5] = 0x00;
+		respond(resp, 6);
+		break;
+	case 9:
+		build_csd(buf);
+		resp[1] = r1();
+		respond(resp, 2);
+		respond_data(buf, 16, card.now_us);
+		break;
+	case 16:
+		resp[1] = (arg == SD_BLOCK_SZ) ? r1() : (r1() | 0x40);
+		respond(resp, 2);
+		break;
+	case 23:
+		if (!app)
+			goto illegal;
+		card.hint = card.t.ignore_hint ? 0 : (arg & 0x7FFFFF);
+		resp[1] = r1();
+		respond(resp, 2);
+		break;
+	case 17:
+		if (card.idle || arg >= card.nr_blocks) {
+			resp[1] = r1() | 0x20;		// Address error
+			respond(resp, 2);
+			break;
+		}
+		if (pread(card.fd, buf, sizeof(buf), (off_t)arg * SD_BLOCK_SZ) !=
+		    (ssize_t)sizeof(buf))
+			memset(buf, 0, sizeof(buf));
+		card.stats.blocks_read++;
+		resp[1] = 0x00;
+		respond(resp, 2);
+		respond_data(buf, sizeof(buf), card.now_us + card.t.read_us);
+		break;
+	case 25:
+		if (card.idle || arg >= card.nr_blocks) {
+			resp[1] = r1() | 0x20;
+			respond(resp, 2);
+			break;
+		}
+		card.stats.write_cmds++;
+		if (card.hint > 0)
+			card.stats.hinted_cmds++;
+		card.wr_lba = arg;
+		card.wr_nr = 0;
+		card.wr_hint = card.hint;
+		card.hint = 0;
+		card.mode = CARD_WR_TOKEN;
+		resp[1] = 0x00;
+		respond(resp, 2);
+		break;
+	default:
+	illegal:
+		resp[1] = r1() | 0x04;
+		respond(resp, 2);
+		break;
+	}
+}
+
+/// Program the block just received and work out how long that keeps us busy
+static void program_block(void)
+{
+	uint64_t busy = card.t.prog_us;
+
+	if (card.wr_lba + card.wr_nr < card.nr_blocks &&
+	    pwrite(card.fd, card.blk, SD_BLOCK_SZ,
+		   (off_t)(card.wr_lba + card.wr_nr) * SD_BLOCK_SZ) < 0)
+		perror("sim_sdcard: pwrite");
+
+	if (card.wr_nr == 0)
+		busy += card.t.open_us;
+	if (card.wr_nr >= card.wr_hint)
+		busy += card.t.erase_us;
+	card.stats.blocks_written++;
+	if (card.t.gc_every > 0 &&
+	    card.stats.blocks_written % card.t.gc_every == 0) {
+		busy += card.t.gc_us;
+		card.stats.gc_stalls++;
+	}
+	card.wr_nr++;
+	card.stats.busy_us += busy;
+	card.card_busy_until = card.now_us + busy;
+}
+
+/// Exchange one byte with the card
+static uint8_t card_xchg(uint8_t mosi)
+{
+	if (!card.present || !card.selected)
+		return 0xFF;
+
+	// A pending response goes out first, whatever the host sends meanwhile
+	if (card.out_pos < card.out_len) {
+		if (card.out_pos >= card.gate_pos && card.now_us < card.gate_us)
+			return 0xFF;
+		return card.out[card.out_pos++];
+	}
+
+	switch (card.mode) {
+	case CARD_WR_TOKEN:
+		if (mosi == 0xFC) {
+			card.blk_len = 0;
+			card.mode = CARD_WR_DATA;
+		} else if (mosi == 0xFD) {
+			card.mode = CARD_STOP_STUFF;
+		}
+		return 0xFF;
+	case CARD_WR_DATA:
+		card.blk[card.blk_len++] = mosi;
+		if (card.blk_len == sizeof(card.blk)) {
+			program_block();
+			card.mode = CARD_WR_RESP;
+		}
+		return 0xFF;
+	case CARD_WR_RESP:
+		card.mode = CARD_BUSY;
+		card.mode_after_busy = CARD_WR_TOKEN;
+		return 0xE5;		// Data accepted
+	case CARD_STOP_STUFF:
+		card.card_busy_until = card.now_us + card.t.stop_us;
+		card.stats.busy_us += card.t.stop_us;
+		card.mode = CARD_BUSY;
+		card.mode_after_busy = CARD_CMD;
+		return 0xFF;
+	case CARD_BUSY:
+		if (card.now_us < card.card_busy_until)
+			return 0x00;
+		card.mode = card.mode_after_busy;
+		return 0xFF;
+	default:
+		break;
+	}
+
+	if (card.cmd_len == 0 && (mosi & 0xC0) != 0x40)
+		return 0xFF;
+	card.cmd[card.cmd_len++] = mosi;
+	if (card.cmd_len == sizeof(card.cmd)) {
+		card.cmd_len = 0;
+		do_command();
+	}
+	return 0xFF;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Platform functions used by src/sdcard.c
+
+void platform_spi_sd_set_baud(uint32_t hz)
+{
+	uint32_t baud;
+
+	// Same rounding as platform/spi.c
+	if (hz == 0)
+		hz = 1;
+	baud = (SIM_SD_GCLK_HZ + 2 * hz - 1) / (2 * hz);
+	baud = (baud > 0) ? baud - 1 : 0;
+	if (baud > 255)
+		baud = 255;
+	card.spi_hz = SIM_SD_GCLK_HZ / (2 * (baud + 1));
+}
+
+void platform_spi_sd_select(bool sel)
+{
+	if (!sel) {
+		/*
+		 * Deselecting abandons a partial command, any queued reply
+		 * and (a simplification) an unfinished multi-block write
+		 */
+		card.cmd_len = 0;
+		card.out_len = card.out_pos = 0;
+		if (card.mode != CARD_BUSY)
+			card.mode = CARD_CMD;
+	}
+	card.selected = sel;
+}
+
+bool platform_spi_sd_busy(void)
+{
+	return sim_now_us < card.busy_until_us;
+}
+
+bool platform_spi_sd_xfer_async(const void *tx, void *rx, uint16_t len)
+{
+	const uint8_t *t = tx;
+	uint8_t *r = rx;
+	uint64_t byte_ns = 8000000000ull / card.spi_hz;
+	uint64_t t0_ns = (sim_now_us + SIM_SD_XFER_SETUP_US) * 1000ull;
+
+	if (len == 0 || platform_spi_sd_busy())
+		return false;
+
+	for (uint16_t i = 0; i < len; ++i) {
+		uint8_t miso;
+
+		card.now_us = (t0_ns + byte_ns * (i + 1)) / 1000ull;
+		miso = card_xchg(t ? t[i] : 0xFF);
+		if (r)
+			r[i] = miso;
+	}
+	card.busy_until_us = sim_now_us + SIM_SD_XFER_SETUP_US +
+			     (byte_ns * len + 999) / 1000ull;
+
+	card.stats.bytes_clocked += len;
+	card.stats.xfers++;
+	if (len > card.stats.xfer_max)
+		card.stats.xfer_max = len;
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int sim_sd_open(const char *path, uint32_t nr_blocks, bool fresh,
+		const sim_sd_timing_t *t)
+{
+	memset(&card, 0, sizeof(card));
+	card.fd = open(path, O_RDWR | O_CREAT | (fresh ? O_TRUNC : 0), 0644);
+	if (card.fd < 0)
+		return -1;
+	if (ftruncate(card.fd, (off_t)nr_blocks * SD_BLOCK_SZ) < 0) {
+		int e = errno;
+		close(card.fd);
+		errno = e;
+		return -1;
+	}
+	card.nr_blocks = nr_blocks & ~1023u;	// Whole C_SIZE units
+	card.t = *t;
+	card.present = true;
+	card.idle = true;
+	platform_spi_sd_set_baud(PLATFORM_SPI_SD_HZ_INIT);
+	return 0;
+}
+
+void sim_sd_close(void)
+{
+	if (card.fd >= 0)
+		close(card.fd);
+	card.fd = -1;
+}
+
+void sim_sd_set_present(bool present)
+{
+	if (present && !card.present) {
+		// A freshly inserted card is powered up from scratch
+		card.mode = CARD_CMD;
+		card.idle = true;
+		card.init_started = false;
+		card.cmd_len = 0;
+		card.out_len = card.out_pos = 0;
+	}
+	card.present = present;
+}
+
+uint32_t sim_sd_spi_hz(void)
+{
+	return card.spi_hz;
+}
+
+void sim_sd_get_stats(sim_sd_stats_t *out)
+{
+	*out = card.stats;
+}
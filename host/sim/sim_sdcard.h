@@ -0,0 +1,84 @@
+/**
+ * @file host/sim/sim_sdcard.h
+ * @brief Byte-level model of an SD card in SPI mode, backed by an image file
+ *
+ * The model stands in for platform/spi.c: it implements the
+ * platform_spi_sd_*() functions from platform.h, so src/sdcard.c runs on the
+ * host unmodified. Every byte the driver clocks is answered the way a card
+ * would (R1/R3/R7 responses, data tokens, data responses, busy signalling),
+ * and transfers take as long as they would on the wire.
+ *
+ * Card timing is parametric rather than a model of any real card: a
+ * per-block programming time, an extra cost for the first block of a write
+ * command, an erase cost for blocks not announced by a pre-erase hint
+ * (ACMD23), and a periodic housekeeping stall that stands in for the card's
+ * internal garbage collection.
+ *
+ * The tool linking this file provides the virtual clock, @c sim_now_us.
+ */
+
+#if !defined(SIM_SDCARD_H_)
+#define SIM_SDCARD_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// Virtual time in microseconds; defined by the tool
+extern uint64_t sim_now_us;
+
+/// Card timing
+typedef struct sim_sd_timing_type {
+	uint32_t read_us;	///< CMD17 to data token
+	uint32_t prog_us;	///< Busy after every block of a multi-block write
+	uint32_t open_us;	///< Extra busy after the first block of a command
+	uint32_t erase_us;	///< Extra busy for a block not covered by ACMD23
+	uint32_t stop_us;	///< Busy after the stop token
+	uint32_t gc_every;	///< Blocks between housekeeping stalls (0: never)
+	uint32_t gc_us;		///< Length of a housekeeping stall
+	uint32_t init_us;	///< Time ACMD41 takes to leave the idle state
+	bool     ignore_hint;	///< Behave as if ACMD23 was never sent
+} sim_sd_timing_t;
+
+/// Defaults that resemble a mid-range card
+#define SIM_SD_TIMING_DEFAULT { 300, 250, 1000, 400, 500, 4096, 100000, 50000, false }
+
+/// Counters describing card and bus activity
+typedef struct sim_sd_stats_type {
+	uint64_t bytes_clocked;	///< Bytes exchanged over SPI
+	uint64_t xfers;		///< SPI transfers
+	uint32_t xfer_max;	///< Longest single transfer, in bytes
+	uint64_t busy_us;	///< Total busy time signalled after writes
+	uint32_t blocks_written;
+	uint32_t blocks_read;
+	uint32_t write_cmds;	///< CMD25 commands
+	uint32_t hinted_cmds;	///< ... of which were preceded by ACMD23
+	uint32_t gc_stalls;
+} sim_sd_stats_t;
+
+/**
+ * Open (or create) a card image
+ *
+ * @param	path		Image file; created if missing
+ * @param	nr_blocks	Card capacity in 512-byte blocks; the file is
+ *				extended (sparsely) to this size
+ * @param	fresh		Discard the current contents of the image
+ * @param	t		Card timing
+ *
+ * @return	0 on success, -1 on error (with errno set)
+ */
+int sim_sd_open(const char *path, uint32_t nr_blocks, bool fresh,
+		const sim_sd_timing_t *t);
+
+/// Close the image
+void sim_sd_close(void);
+
+/// Insert or remove the card; a removed card never drives MISO
+void sim_sd_set_present(bool present);
+
+/// Current SCK frequency, in Hz
+uint32_t sim_sd_spi_hz(void);
+
+/// Copy the current counters
+void sim_sd_get_stats(sim_sd_stats_t *out);
+
+#endif	// !defined(SIM_SDCARD_H_)
@@ -0,0 +1,531 @@
+/**
+ * @file host/tools/abcmp.c
+ * @brief Compares two builds of the ingest pipeline on identical input.
+ *
+ * A change to a parser or to the CRC engine should either leave its output
+ * alone or change it on purpose, and should not make it slower by accident.
+ * This tool loads two builds of the pipeline side by side, A (-a, the
+ * baseline) and B (-b), each a shared object built from its own tree, and
+ * runs both on the same byte streams, stage by stage:
+ *
+ * - assemble: nmea_sentence_feed() over the GPS stream;
+ * - gll:      nmea_parse_gpgll_and_format() on every GLL sentence;
+ * - pms:      pms_parser_feed_byte() over the PM stream;
+ * - crc32:    crc32_update() over both streams in 504-byte blocks, the
+ *             payload of a log block.
+ *
+ * First every output of B is checked against A's, and the first difference
+ * of each stage is shown. Then each stage is timed -n times per build, with
+ * the order of A and B alternating from one run to the next so that drift
+ * in the host's speed falls on both. For each stage the tool prints the
+ * mean time per item of each build, and the change of B against A with its
+ * 95% confidence interval (Welch). A change counts as a regression when the
+ * whole interval lies above zero and the change itself exceeds -e percent.
+ * The exit status is 1 if any output differs or any stage regressed.
+ *
+ * The streams are -g (NMEA text) and -q (PMS5003 bytes) when given, such as
+ * the files sgen or capdemux write; otherwise -t seconds of 10 Hz fixes
+ * with every sentence and 10 Hz PM frames are generated with host/lib/sgen.h.
+ *
+ * Each build is loaded from a private copy (through a memfd), so A and B
+ * may even be the same file, which is what -B does: it compares the build
+ * given with -a against itself, and fails if the outputs differ or if any
+ * stage is flagged, which would be a false alarm.
+ *
+ * Build (from the repository root, and for B from the other tree):
+ *   cc -O2 -fPIC -shared -Wl,-Bsymbolic -Iinc -o pipe_a.so \
+ *      src/parsers/nmea_parse.c src/parsers/pms_parser.c src/crc32.c
+ *   cc -O2 -Wall -rdynamic -Iinc -Ihost/lib -o abcmp host/tools/abcmp.c \
+ *      host/lib/sgen.c -ldl -lm
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parsers/pms_parser.h"
+#include "platform.h"
+#include "sgen.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins, shared by both builds
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+// No DSU on the host; crc32.c falls back to its table
+bool platform_dsu_crc32(const void *addr, uint32_t len, uint32_t *crc)
+{
+	(void)addr;
+	(void)len;
+	(void)crc;
+	return false;
+}
+
+void platform_tick_hrcount(platform_timespec_t *tick)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	tick->nr_sec  = (uint32_t)ts.tv_sec;
+	tick->nr_nsec = (uint32_t)ts.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// Room for a parser's state; a build may have grown it
+#define ABCMP_STATE_MAX		4096
+
+/// Bytes of a log block's payload, per CRC
+#define ABCMP_CRC_BLOCK		504
+
+static double opt_secs = 600;
+static unsigned opt_runs = 20;
+static double opt_effect = 2;		// Percent
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Builds
+
+/// One build of the pipeline
+typedef struct build_type {
+	const char *path;
+	void (*nmea_init)(void *state);
+	const char *(*nmea_feed)(void *state, char c);
+	bool (*gll)(const char *sentence, char *out, size_t size);
+	void (*pms_init)(void *state);
+	pms_parser_status_t (*pms_feed)(struct prog_state_type *ps, void *state,
+					uint8_t byte, pms_data_t *out);
+	uint32_t (*crc)(uint32_t crc, const void *buf, size_t len);
+	_Alignas(16) uint8_t state[ABCMP_STATE_MAX];
+} build_t;
+
+static void *read_file(const char *path, size_t *len)
+{
+	struct stat st;
+	void *p;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		perror(path);
+		if (fd >= 0)
+			close(fd);
+		return NULL;
+	}
+	p = malloc((size_t)st.st_size + 1);
+	if (p == NULL || read(fd, p, (size_t)st.st_size) != st.st_size) {
+		perror(path);
+		free(p);
+		close(fd);
+		return NULL;
+	}
+	close(fd);
+	*len = (size_t)st.st_size;
+	return p;
+}
+
+// Load a private copy, so that A and B never share statics or symbols
+static int build_load(build_t *b, const char *path)
+{
+	char name[64];
+	size_t len;
+	void *image, *h;
+	int fd;
+
+	b->path = path;
+	if ((image = read_file(path, &len)) == NULL)
+		return -1;
+	fd = memfd_create("abcmp", MFD_CLOEXEC);
+	if (fd < 0 || write(fd, image, len) != (ssize_t)len) {
+		perror("memfd");
+		free(image);
+		return -1;
+	}
+	free(image);
+	snprintf(name, sizeof(name), "/proc/self/fd/%d", fd);
+	if ((h = dlopen(name, RTLD_NOW | RTLD_LOCAL)) == NULL) {
+		fprintf(stderr, "%s: %s\n", path, dlerror());
+		return -1;
+	}
+	// The descriptor stays open, so the next copy gets a name of its own
+
+	*(void **)&b->nmea_init = dlsym(h, "nmea_sentence_init");
+	*(void **)&b->nmea_feed = dlsym(h, "nmea_sentence_feed");
+	*(void **)&b->gll       = dlsym(h, "nmea_parse_gpgll_and_format");
+	*(void **)&b->pms_init  = dlsym(h, "pms_parser_init");
+	*(void **)&b->pms_feed  = dlsym(h, "pms_parser_feed_byte");
+	*(void **)&b->crc       = dlsym(h, "crc32_update");
+	if (!b->nmea_init || !b->nmea_feed || !b->gll || !b->pms_init ||
+	    !b->pms_feed) {
+		fprintf(stderr, "%s: missing parser entry points\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Input
+
+static uint8_t *gps_data, *pm_data;
+static size_t gps_len, pm_len;
+
+/// The GLL sentences of the stream, assembled by A, as input to "gll"
+static char **glls;
+static size_t nr_glls;
+
+static int generate(void)
+{
+	sgen_cfg_t c;
+	sgen_t g;
+	uint64_t n_gps = (uint64_t)(opt_secs * 10), n_pm = n_gps;
+
+	sgen_cfg_default(&c);
+	c.t0_ms = 1700000000000;
+	c.gps_hz = 10;
+	c.pm_hz = 10;
+	c.sentences = SGEN_ALL;
+	c.no_fix = 0.05;
+	sgen_init(&g, &c);
+
+	gps_data = malloc(n_gps * SGEN_EPOCH_MAX);
+	pm_data = malloc(n_pm * SGEN_PMS_FRAME);
+	if (gps_data == NULL || pm_data == NULL) {
+		perror("malloc");
+		return -1;
+	}
+	for (uint64_t i = 0; i < n_gps; ++i)
+		gps_len += sgen_gps_epoch(&g, i, (char *)gps_data + gps_len,
+					  SGEN_EPOCH_MAX);
+	for (uint64_t i = 0; i < n_pm; ++i)
+		pm_len += sgen_pm_frame(&g, i, pm_data + pm_len);
+	return 0;
+}
+
+static int collect_glls(build_t *a)
+{
+	size_t max = 0;
+
+	a->nmea_init(a->state);
+	for (size_t i = 0; i < gps_len; ++i) {
+		const char *s = a->nmea_feed(a->state, (char)gps_data[i]);
+
+		if (s == NULL || strncmp(s + 3, "GLL", 3) != 0)
+			continue;
+		if (nr_glls == max) {
+			char **grown;
+
+			max = max ? 2 * max : 1024;
+			if ((grown = realloc(glls, max * sizeof(*glls))) == NULL) {
+				perror("realloc");
+				return -1;
+			}
+			glls = grown;
+		}
+		if ((glls[nr_glls++] = strdup(s)) == NULL) {
+			perror("strdup");
+			return -1;
+		}
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Stages
+
+/// Output of one item, for comparison
+typedef struct item_type {
+	char text[288];
+} item_t;
+
+typedef struct stage_type {
+	const char *name;
+	const char *unit;
+	/// Run over the whole input; with @p out, record each item's output
+	size_t (*run)(build_t *b, item_t *out, size_t max);
+} stage_t;
+
+static size_t stage_assemble(build_t *b, item_t *out, size_t max)
+{
+	size_t n = 0;
+
+	b->nmea_init(b->state);
+	for (size_t i = 0; i < gps_len; ++i) {
+		const char *s = b->nmea_feed(b->state, (char)gps_data[i]);
+
+		if (s == NULL)
+			continue;
+		if (out != NULL && n < max)
+			snprintf(out[n].text, sizeof(out[n].text), "%s", s);
+		++n;
+	}
+	return n;
+}
+
+static size_t stage_gll(build_t *b, item_t *out, size_t max)
+{
+	char buf[256];
+
+	for (size_t i = 0; i < nr_glls; ++i) {
+		bool ok = b->gll(glls[i], buf, sizeof(buf));
+
+		if (out != NULL && i < max)
+			snprintf(out[i].text, sizeof(out[i].text), "%d %s", ok,
+				 ok ? buf : "");
+	}
+	return nr_glls;
+}
+
+static size_t stage_pms(build_t *b, item_t *out, size_t max)
+{
+	pms_data_t d;
+	size_t n = 0;
+
+	b->pms_init(b->state);
+	for (size_t i = 0; i < pm_len; ++i) {
+		pms_parser_status_t st = b->pms_feed(NULL, b->state, pm_data[i], &d);
+
+		if (st == PMS_PARSER_PROCESSING_BYTE)
+			continue;
+		if (out != NULL && n < max) {
+			if (st == PMS_PARSER_OK)
+				snprintf(out[n].text, sizeof(out[n].text),
+					 "@%zu ok %u %u %u %u %u %u", i, d.pm1_0_std,
+					 d.pm2_5_std, d.pm10_std, d.pm1_0_atm,
+					 d.pm2_5_atm, d.pm10_atm);
+			else
+				snprintf(out[n].text, sizeof(out[n].text),
+					 "@%zu status %d", i, (int)st);
+		}
+		++n;
+	}
+	return n;
+}
+
+static size_t stage_crc(build_t *b, item_t *out, size_t max)
+{
+	const uint8_t *streams[2] = { gps_data, pm_data };
+	size_t lens[2] = { gps_len, pm_len }, n = 0;
+
+	for (int s = 0; s < 2; ++s)
+		for (size_t at = 0; at < lens[s]; at += ABCMP_CRC_BLOCK) {
+			size_t len = lens[s] - at < ABCMP_CRC_BLOCK ?
+				     lens[s] - at : ABCMP_CRC_BLOCK;
+			uint32_t crc = b->crc(0, streams[s] + at, len);
+
+			if (out != NULL && n < max)
+				snprintf(out[n].text, sizeof(out[n].text),
+					 "%08x", (unsigned)crc);
+			++n;
+		}
+	return n;
+}
+
+static const stage_t stages[] = {
+	{ "assemble", "sentence", stage_assemble },
+	{ "gll",      "sentence", stage_gll },
+	{ "pms",      "frame",    stage_pms },
+	{ "crc32",    "block",    stage_crc },
+};
+#define NR_STAGES (sizeof(stages) / sizeof(stages[0]))
+
+static bool stage_usable(const stage_t *st, const build_t *a, const build_t *b)
+{
+	return st->run != stage_crc || (a->crc != NULL && b->crc != NULL);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Comparison
+
+/// Items whose outputs differ; the first difference is printed
+static size_t compare(const stage_t *st, build_t *a, build_t *b)
+{
+	size_t na = st->run(a, NULL, 0), nb = st->run(b, NULL, 0);
+	size_t n = na > nb ? na : nb, diff = 0;
+	item_t *oa = calloc(n + 1, sizeof(*oa)), *ob = calloc(n + 1, sizeof(*ob));
+
+	if (oa == NULL || ob == NULL) {
+		perror("calloc");
+		exit(1);
+	}
+	st->run(a, oa, n);
+	st->run(b, ob, n);
+	for (size_t i = 0; i < n; ++i) {
+		if (strcmp(oa[i].text, ob[i].text) == 0)
+			continue;
+		if (diff++ == 0)
+			printf("  %s: first difference at %s %zu\n    A: %.*s\n    B: %.*s\n",
+			       st->name, st->unit, i,
+			       (int)strcspn(oa[i].text, "\r\n"),
+			       i < na ? oa[i].text : "(none)",
+			       (int)strcspn(ob[i].text, "\r\n"),
+			       i < nb ? ob[i].text : "(none)");
+	}
+	free(oa);
+	free(ob);
+	return diff;
+}
+
+/// Two-sided 95% quantile of Student's t (Cornish-Fisher expansion)
+static double t95(double df)
+{
+	const double z = 1.959964;
+	double z3 = z * z * z, z5 = z3 * z * z;
+
+	return z + (z3 + z) / (4 * df) + (5 * z5 + 16 * z3 + 3 * z) / (96 * df * df);
+}
+
+static void mean_var(const double *x, unsigned n, double *mean, double *var)
+{
+	double s = 0, ss = 0;
+
+	for (unsigned i = 0; i < n; ++i)
+		s += x[i];
+	*mean = s / n;
+	for (unsigned i = 0; i < n; ++i)
+		ss += (x[i] - *mean) * (x[i] - *mean);
+	*var = n > 1 ? ss / (n - 1) : 0;
+}
+
+/// Time a stage; returns true if B regressed
+static bool time_stage(const stage_t *st, build_t *a, build_t *b)
+{
+	double ta[opt_runs], tb[opt_runs];
+	double ma, va, mb, vb, se, df, d, lo, hi;
+	size_t items = st->run(a, NULL, 0);
+	bool slower;
+
+	if (items == 0)
+		items = 1;
+	st->run(a, NULL, 0);		// Warm both up
+	st->run(b, NULL, 0);
+	for (unsigned r = 0; r < opt_runs; ++r) {
+		for (int k = 0; k < 2; ++k) {
+			bool first_a = (r & 1) == 0;
+			build_t *x = (k == 0) == first_a ? a : b;
+			uint64_t t0 = now_ns();
+
+			st->run(x, NULL, 0);
+			((x == a) ? ta : tb)[r] = (double)(now_ns() - t0) / items;
+		}
+	}
+	mean_var(ta, opt_runs, &ma, &va);
+	mean_var(tb, opt_runs, &mb, &vb);
+
+	// Welch's interval for mean(B) - mean(A), relative to mean(A)
+	se = sqrt(va / opt_runs + vb / opt_runs);
+	df = se > 0 ? pow(se, 4) / (pow(va / opt_runs, 2) / (opt_runs - 1) +
+				    pow(vb / opt_runs, 2) / (opt_runs - 1)) : 1e9;
+	d = mb - ma;
+	lo = 100 * (d - t95(df) * se) / ma;
+	hi = 100 * (d + t95(df) * se) / ma;
+	slower = lo > 0 && 100 * d / ma > opt_effect;
+
+	printf("  %-9s %9.1f %9.1f ns/%-8s %+7.2f%% [%+7.2f%%, %+7.2f%%]  %s\n",
+	       st->name, ma, mb, st->unit, 100 * d / ma, lo, hi,
+	       slower ? "SLOWER" :
+	       (hi < 0 && -100 * d / ma > opt_effect) ? "faster" : "same");
+	return slower;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s -a A.so -b B.so [-g GPS.nmea] [-q PM.pms] [-t SECONDS] [-n RUNS]\n"
+		"       [-e PERCENT]\n"
+		"       %s -B -a A.so [-t SECONDS] [-n RUNS]\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	static build_t a, b;
+	const char *path_a = NULL, *path_b = NULL, *gps_path = NULL, *pm_path = NULL;
+	size_t diffs = 0;
+	unsigned slower = 0;
+	bool bench = false;
+	uint64_t t0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:b:g:q:t:n:e:Bh")) != -1) {
+		switch (opt) {
+		case 'a': path_a = optarg; break;
+		case 'b': path_b = optarg; break;
+		case 'g': gps_path = optarg; break;
+		case 'q': pm_path = optarg; break;
+		case 't': opt_secs = strtod(optarg, NULL); break;
+		case 'n': opt_runs = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'e': opt_effect = strtod(optarg, NULL); break;
+		case 'B': bench = true; break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (bench && path_b == NULL)
+		path_b = path_a;
+	if (optind != argc || path_a == NULL || path_b == NULL ||
+	    opt_runs < 3 || opt_secs <= 0) {
+		usage(argv[0]);
+		return 2;
+	}
+	if (build_load(&a, path_a) != 0 || build_load(&b, path_b) != 0)
+		return 2;
+
+	if (gps_path != NULL || pm_path != NULL) {
+		if ((gps_path != NULL && (gps_data = read_file(gps_path, &gps_len)) == NULL) ||
+		    (pm_path != NULL && (pm_data = read_file(pm_path, &pm_len)) == NULL))
+			return 2;
+	} else if (generate() != 0) {
+		return 2;
+	}
+	if (collect_glls(&a) != 0)
+		return 2;
+	printf("abcmp: A %s, B %s\n  input: %zu GPS bytes (%zu GLL sentences), "
+	       "%zu PM bytes; %u runs\n", a.path, b.path, gps_len, nr_glls,
+	       pm_len, opt_runs);
+
+	t0 = now_ns();
+	printf("outputs:\n");
+	for (size_t i = 0; i < NR_STAGES; ++i) {
+		size_t d;
+
+		if (!stage_usable(&stages[i], &a, &b))
+			continue;
+		d = compare(&stages[i], &a, &b);
+		printf("  %-9s %s\n", stages[i].name, d ? "DIFFER" : "identical");
+		diffs += d;
+	}
+
+	printf("times:      %9s %9s              B vs A    95%% interval\n", "A", "B");
+	for (size_t i = 0; i < NR_STAGES; ++i)
+		if (stage_usable(&stages[i], &a, &b))
+			slower += time_stage(&stages[i], &a, &b);
+
+	printf("%s: %zu outputs differ, %u stages slower (threshold %.1f%%) in %.1f s\n",
+	       bench ? "abcmp bench (A against itself)" : "abcmp",
+	       diffs, slower, opt_effect, (now_ns() - t0) / 1e9);
+	return (diffs || slower) ? 1 : 0;
+}
@@ -0,0 +1,882 @@
+/**
+ * @file host/tools/bulkdl_client.c
+ * @brief Host client for the bulk log download protocol.
+ *
+ * Three modes are provided:
+ *
+ * - Serial mode: attach to the board's CDC port (or a pty) and download the
+ *   record log into a file. A sidecar file (<out>.first) records which log
+ *   block the file starts at, so re-running the command after an
+ *   interruption (or later, once more data has been logged) only fetches the
+ *   blocks the file does not have yet. The newest block is usually partial;
+ *   it is re-fetched in full on the next run.
+ *
+ * - Metrics mode (-m): attach as above and print the device's metrics
+ *   (metrics.h) in the format of the terminal's "metrics" command.
+ *
+ * - Self-test mode (-S): link src/bulkdl.c and src/logstore.c against a
+ *   simulated link running on virtual time, fill the log, download it with
+ *   frame loss, an outage and a client restart part-way through, verify the
+ *   result byte for byte and report the link utilization. No board needed.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -DLOGSTORE_BACKEND=0 -o bulkdl_client \
+ *      host/tools/bulkdl_client.c src/bulkdl.c src/logstore.c src/crc32.c \
+ *      src/metrics.c src/scratch.c
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bulkdl.h"
+#include "crc32.h"
+#include "logstore.h"
+#include "metrics.h"
+#include "uplink.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// Deterministic PRNG (xorshift32), so loss patterns are reproducible
+static uint32_t rng_state = 0x2545F491;
+static uint32_t rng_next(void)
+{
+	uint32_t x = rng_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+static int rng_chance(double pct)
+{
+	return ((rng_next() % 1000000u) / 10000.0) < pct;
+}
+
+static void put_u32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+static uint32_t get_u32(const uint8_t *p)
+{
+	return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+	       ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// Blocks that can be held out of order (the largest SACK reach)
+#define CL_REORDER 64
+
+/// Client-side frame parser, reorder buffer and ACK generator
+typedef struct cl_type {
+	// Frame assembly
+	uint8_t  frame[BULKDL_BLOCK_FRAME_MAX];
+	uint16_t idx;
+
+	// What the device reported
+	int      have_info;
+	uint32_t dev_first;
+	uint32_t dev_end;
+
+	// Session
+	int      in_session;
+	int      done;
+	uint32_t first;                 // Log block at offset 0 of the output
+	uint32_t next;                  // Next block to write to the output
+	uint32_t end;                   // One past the last block of the session
+
+	// Metrics listing
+	int      metrics_reply;         // A METRICS frame arrived since the last request
+	unsigned metrics_next;          // Index of the next metric to ask for
+	unsigned metrics_total;
+
+	// Blocks received ahead of 'next'
+	uint8_t  have[CL_REORDER];
+	uint16_t len[CL_REORDER];
+	uint8_t  data[CL_REORDER][LOGSTORE_BLOCK_SZ];
+
+	// Statistics
+	unsigned long frames_ok;
+	unsigned long frames_bad;
+	unsigned long blocks_ok;
+	unsigned long blocks_dup;
+	unsigned long blocks_evicted;
+	unsigned long bytes_written;
+
+	// Sinks
+	void (*send)(struct cl_type *cl, const uint8_t *frame, size_t len);
+	void (*write)(struct cl_type *cl, const uint8_t *data, size_t len);
+	void *user;
+} cl_t;
+
+static void cl_send_frame(cl_t *cl, uint8_t type, const uint8_t *p, uint16_t plen)
+{
+	uint8_t f[BULKDL_HDR_LEN + 8 + BULKDL_CRC_LEN];
+
+	f[0] = BULKDL_SYNC_1;
+	f[1] = BULKDL_SYNC_2;
+	f[2] = type;
+	f[3] = 0;
+	f[4] = (uint8_t)plen;
+	f[5] = (uint8_t)(plen >> 8);
+	memcpy(&f[BULKDL_HDR_LEN], p, plen);
+	put_u32(&f[BULKDL_HDR_LEN + plen],
+		crc32_update(0, &f[2], (BULKDL_HDR_LEN - 2) + plen));
+	cl->send(cl, f, BULKDL_HDR_LEN + plen + BULKDL_CRC_LEN);
+}
+
+static void cl_info_req(cl_t *cl)
+{
+	cl_send_frame(cl, BULKDL_TYPE_INFO_REQ, NULL, 0);
+}
+
+static void cl_start(cl_t *cl)
+{
+	uint8_t p[8];
+
+	put_u32(&p[0], cl->next);
+	put_u32(&p[4], BULKDL_TO_NEWEST);
+	cl_send_frame(cl, BULKDL_TYPE_START, p, sizeof(p));
+}
+
+static void cl_stop(cl_t *cl)
+{
+	cl_send_frame(cl, BULKDL_TYPE_STOP, NULL, 0);
+}
+
+static void cl_metrics_req(cl_t *cl)
+{
+	uint8_t p[2];
+
+	p[0] = (uint8_t)cl->metrics_next;
+	p[1] = (uint8_t)(cl->metrics_next >> 8);
+	cl->metrics_reply = 0;
+	cl_send_frame(cl, BULKDL_TYPE_METRICS_REQ, p, sizeof(p));
+}
+
+/// Print the metric records of a METRICS frame that continues the listing
+static void cl_metrics(cl_t *cl, const uint8_t *p, uint16_t plen)
+{
+	metric_snapshot_t m;
+	char line[512];
+	uint16_t at, n;
+
+	if ((unsigned)(p[0] | (p[1] << 8)) != cl->metrics_next)
+		return;         // A late reply to an earlier request
+	cl->metrics_total = p[2] | (p[3] << 8);
+	for (at = 4; at < plen; at += n) {
+		if ((n = metrics_decode(&p[at], plen - at, &m)) == 0) {
+			cl->frames_bad++;
+			break;
+		}
+		metrics_format(&m, line, sizeof(line));
+		fputs(line, stdout);
+		cl->metrics_next++;
+	}
+	cl->metrics_reply = 1;
+}
+
+static void cl_ack(cl_t *cl)
+{
+	uint8_t p[8];
+	uint32_t sack = 0;
+
+	for (unsigned i = 0; i < 32; ++i)
+		if (cl->have[(cl->next + 1 + i) % CL_REORDER])
+			sack |= 1UL << i;
+	put_u32(&p[0], cl->next);
+	put_u32(&p[4], sack);
+	cl_send_frame(cl, BULKDL_TYPE_ACK, p, sizeof(p));
+}
+
+static void cl_block(cl_t *cl, uint32_t blk, const uint8_t *d, uint16_t len)
+{
+	unsigned s = blk % CL_REORDER;
+
+	if (blk < cl->next || blk - cl->next >= 33 || cl->have[s]) {
+		cl->blocks_dup++;
+		return;
+	}
+	cl->blocks_ok++;
+	cl->have[s] = 1;
+	cl->len[s] = len;
+	memcpy(cl->data[s], d, len);
+
+	// Write out whatever is now contiguous
+	while (cl->have[cl->next % CL_REORDER]) {
+		s = cl->next % CL_REORDER;
+		if (cl->len[s] == 0) {
+			// Evicted on the device while in flight; keep offsets intact
+			memset(cl->data[s], 0, LOGSTORE_BLOCK_SZ);
+			cl->len[s] = LOGSTORE_BLOCK_SZ;
+			cl->blocks_evicted++;
+		}
+		cl->write(cl, cl->data[s], cl->len[s]);
+		cl->bytes_written += cl->len[s];
+		cl->have[s] = 0;
+		cl->next++;
+	}
+}
+
+static void cl_handle_frame(cl_t *cl, uint8_t type, uint8_t flags,
+			    const uint8_t *p, uint16_t plen)
+{
+	switch (type) {
+	case BULKDL_TYPE_INFO:
+		if (plen < 12 || (p[8] | (p[9] << 8)) != LOGSTORE_BLOCK_SZ) {
+			cl->frames_bad++;
+			return;
+		}
+		cl->dev_first = get_u32(&p[0]);
+		cl->dev_end = get_u32(&p[4]);
+		cl->have_info = 1;
+		if (flags & BULKDL_FLAG_SESSION) {
+			cl->in_session = 1;
+			cl->end = cl->dev_end;
+		}
+		break;
+	case BULKDL_TYPE_BLOCK:
+		if (plen < 4 || !cl->in_session) {
+			cl->frames_bad++;
+			return;
+		}
+		cl_block(cl, get_u32(&p[0]), &p[4], plen - 4);
+		cl_ack(cl);
+		break;
+	case BULKDL_TYPE_DONE:
+		if (cl->in_session && cl->next >= cl->end)
+			cl->done = 1;
+		break;
+	case BULKDL_TYPE_METRICS:
+		if (plen < 4) {
+			cl->frames_bad++;
+			return;
+		}
+		cl_metrics(cl, p, plen);
+		break;
+	default:
+		cl->frames_bad++;
+		return;
+	}
+	cl->frames_ok++;
+}
+
+static void cl_feed(cl_t *cl, const uint8_t *buf, size_t len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		uint8_t c = buf[i];
+		uint16_t plen;
+
+		if (cl->idx == 0 && c != BULKDL_SYNC_1)
+			continue;
+		if (cl->idx == 1 && c != BULKDL_SYNC_2) {
+			cl->idx = (c == BULKDL_SYNC_1) ? 1 : 0;
+			continue;
+		}
+		cl->frame[cl->idx++] = c;
+		if (cl->idx < BULKDL_HDR_LEN)
+			continue;
+
+		plen = cl->frame[4] | (cl->frame[5] << 8);
+		if (plen > BULKDL_BLOCK_FRAME_MAX - BULKDL_HDR_LEN - BULKDL_CRC_LEN) {
+			cl->idx = 0;
+			cl->frames_bad++;
+			continue;
+		}
+		if (cl->idx < BULKDL_HDR_LEN + plen + BULKDL_CRC_LEN)
+			continue;
+
+		cl->idx = 0;
+		if (crc32_update(0, &cl->frame[2], (BULKDL_HDR_LEN - 2) + plen) !=
+		    get_u32(&cl->frame[BULKDL_HDR_LEN + plen])) {
+			cl->frames_bad++;
+			continue;
+		}
+		cl_handle_frame(cl, cl->frame[2], cl->frame[3],
+				&cl->frame[BULKDL_HDR_LEN], plen);
+	}
+}
+
+/**
+ * Recover from @p quiet_s seconds without a frame from the device
+ *
+ * A lost ACK is repaired by repeating it. After a few silent seconds the
+ * device may have dropped the session (or only the DONE frame was lost), so
+ * a new session is started from where the output leaves off.
+ */
+static void cl_nudge(cl_t *cl, unsigned quiet_s)
+{
+	if (cl->next >= cl->end || quiet_s >= 3)
+		cl_start(cl);
+	else
+		cl_ack(cl);
+}
+
+/**
+ * Prepare a client to continue an output that already holds @p nr_bytes
+ * bytes starting at log block @p first
+ *
+ * @return Number of bytes of the output to keep (the partial tail block is
+ *         dropped, as it may have grown since)
+ */
+static size_t cl_resume(cl_t *cl, uint32_t first, size_t nr_bytes)
+{
+	cl->first = first;
+	cl->next = first + (uint32_t)(nr_bytes / LOGSTORE_BLOCK_SZ);
+	return (size_t)(cl->next - first) * LOGSTORE_BLOCK_SZ;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Serial mode
+
+static int serial_fd = -1;
+static volatile sig_atomic_t interrupted;
+
+static void on_sigint(int sig)
+{
+	(void)sig;
+	interrupted = 1;
+}
+
+static void serial_send(cl_t *cl, const uint8_t *f, size_t len)
+{
+	(void)cl;
+	if (write(serial_fd, f, len) < 0)
+		perror("write");
+}
+
+static void serial_write(cl_t *cl, const uint8_t *d, size_t len)
+{
+	FILE *out = cl->user;
+
+	if (fwrite(d, 1, len, out) != len)
+		perror("fwrite");
+	fflush(out);
+}
+
+static speed_t baud_to_speed(long baud)
+{
+	switch (baud) {
+	case 9600:   return B9600;
+	case 19200:  return B19200;
+	case 38400:  return B38400;
+	case 57600:  return B57600;
+	case 115200: return B115200;
+	default:     return B0;
+	}
+}
+
+static int serial_open(const char *path, long baud)
+{
+	struct termios tio;
+	int fd = open(path, O_RDWR | O_NOCTTY);
+
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	if (isatty(fd)) {
+		if (tcgetattr(fd, &tio) != 0) {
+			perror("tcgetattr");
+			close(fd);
+			return -1;
+		}
+		cfmakeraw(&tio);
+		if (baud_to_speed(baud) != B0) {
+			cfsetispeed(&tio, baud_to_speed(baud));
+			cfsetospeed(&tio, baud_to_speed(baud));
+		}
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	return fd;
+}
+
+static double mono_s(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * Wait for device frames until @p until_fn says so or @p timeout_s passes
+ *
+ * @return 1 if the condition was met, 0 on timeout, -1 on error/interrupt
+ */
+static int serial_pump(cl_t *cl, int (*until_fn)(cl_t *), double timeout_s)
+{
+	double deadline = mono_s() + timeout_s;
+	uint8_t buf[1024];
+
+	while (!until_fn(cl)) {
+		double left = deadline - mono_s();
+		struct timeval tv;
+		fd_set rfds;
+		ssize_t n;
+
+		if (interrupted)
+			return -1;
+		if (left <= 0)
+			return 0;
+		tv.tv_sec = (time_t)left;
+		tv.tv_usec = (suseconds_t)((left - tv.tv_sec) * 1e6);
+		FD_ZERO(&rfds);
+		FD_SET(serial_fd, &rfds);
+		n = select(serial_fd + 1, &rfds, NULL, NULL, &tv);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			continue;
+		n = read(serial_fd, buf, sizeof(buf));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			return -1;
+		cl_feed(cl, buf, (size_t)n);
+	}
+	return 1;
+}
+
+static int until_info(cl_t *cl)    { return cl->have_info; }
+static int until_session(cl_t *cl) { return cl->in_session; }
+static int until_done(cl_t *cl)    { return cl->done; }
+static int until_metrics(cl_t *cl) { return cl->metrics_reply; }
+
+static int run_serial(const char *path, long baud, const char *out_path)
+{
+	static cl_t cl;
+	char side_path[4096];
+	unsigned long first = 0;
+	struct stat st;
+	FILE *side, *out;
+	unsigned long last_next;
+	double t0, t_last;
+	int r, tries;
+
+	snprintf(side_path, sizeof(side_path), "%s.first", out_path);
+	serial_fd = serial_open(path, baud);
+	if (serial_fd < 0)
+		return 1;
+	signal(SIGINT, on_sigint);
+	cl.send = serial_send;
+	cl.write = serial_write;
+
+	// Where does the device's log start and end?
+	for (tries = 0, r = 0; tries < 10 && r == 0; ++tries) {
+		cl_info_req(&cl);
+		r = serial_pump(&cl, until_info, 0.5);
+	}
+	if (r <= 0) {
+		fprintf(stderr, "%s: no reply from the device\n", path);
+		return 1;
+	}
+
+	// Where does the existing download (if any) leave off?
+	if ((side = fopen(side_path, "r")) != NULL) {
+		if (fscanf(side, "%lu", &first) != 1)
+			first = 0;
+		fclose(side);
+	}
+	if (stat(out_path, &st) != 0 || access(side_path, F_OK) != 0)
+		st.st_size = 0;
+	truncate(out_path, (off_t)cl_resume(&cl, (uint32_t)first, (size_t)st.st_size));
+	if (st.st_size == 0 || cl.next < cl.dev_first) {
+		if (st.st_size != 0)
+			fprintf(stderr, "blocks %u..%u were evicted on the device; "
+				"starting a new download\n", cl.next, cl.dev_first - 1);
+		cl_resume(&cl, cl.dev_first, 0);
+		truncate(out_path, 0);
+	}
+	if ((side = fopen(side_path, "w")) == NULL) {
+		perror(side_path);
+		return 1;
+	}
+	fprintf(side, "%u\n", cl.first);
+	fclose(side);
+	if ((out = fopen(out_path, "ab")) == NULL) {
+		perror(out_path);
+		return 1;
+	}
+	cl.user = out;
+
+	fprintf(stderr, "device log: blocks %u..%u; fetching from block %u\n",
+		cl.dev_first, cl.dev_end, cl.next);
+	t0 = t_last = mono_s();
+	last_next = cl.next;
+
+	// Start (or restart) the session until the device confirms it
+	for (tries = 0, r = 0; tries < 10 && r == 0; ++tries) {
+		cl_start(&cl);
+		r = serial_pump(&cl, until_session, 1.0);
+	}
+
+	// Nudge the device whenever it goes quiet; give up if nothing moves
+	while (r > 0 && !cl.done) {
+		r = serial_pump(&cl, until_done, 1.0);
+		if (cl.next != last_next) {
+			last_next = cl.next;
+			t_last = mono_s();
+		}
+		if (r == 0) {
+			if (mono_s() - t_last > 30.0)
+				break;
+			cl_nudge(&cl, (unsigned)(mono_s() - t_last));
+			r = 1;
+		}
+	}
+	if (!cl.done)
+		cl_stop(&cl);
+	fclose(out);
+
+	fprintf(stderr, "%s: blocks %u..%u, %lu B in %.1f s (%.0f B/s), "
+		"%lu dup, %lu bad frames, %lu evicted\n",
+		cl.done ? "complete" : "interrupted; re-run to resume",
+		cl.first, cl.next, cl.bytes_written, mono_s() - t0,
+		cl.bytes_written / (mono_s() - t0 + 1e-9),
+		cl.blocks_dup, cl.frames_bad, cl.blocks_evicted);
+	return cl.done ? 0 : 2;
+}
+
+static int run_metrics(const char *path, long baud)
+{
+	static cl_t cl;
+	int r = 1, tries = 0;
+
+	serial_fd = serial_open(path, baud);
+	if (serial_fd < 0)
+		return 1;
+	signal(SIGINT, on_sigint);
+	cl.send = serial_send;
+
+	// One frame holds a few records; ask on from the last one printed
+	do {
+		unsigned before = cl.metrics_next;
+
+		cl_metrics_req(&cl);
+		r = serial_pump(&cl, until_metrics, 0.5);
+		tries = (r > 0 && cl.metrics_next != before) ? 0 : tries + 1;
+	} while (r >= 0 && tries < 10 && (r == 0 || cl.metrics_next < cl.metrics_total));
+
+	if (r <= 0 || cl.metrics_next < cl.metrics_total) {
+		fprintf(stderr, "%s: no reply from the device\n", path);
+		return 1;
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Self-test mode: the firmware's download module against a simulated link
+
+/// Virtual time, in microseconds
+static uint64_t sim_now_us;
+
+/// Link parameters
+static long     sim_baud = 38400;
+static double   sim_frame_loss_pct = 0.0;
+static uint64_t sim_outage_start_us = 1ull * 1000000;
+static uint64_t sim_outage_len_us = 0;
+static uint64_t sim_latency_us = 2000;
+
+/// Device -> host: frames of the current DMA request, each with its end time
+static struct {
+	uint8_t  f[BULKDL_BLOCK_FRAME_MAX];
+	size_t   len;
+	uint64_t done_us;
+} sim_tx[BULKDL_BURST];
+static unsigned sim_tx_nr, sim_tx_idx;
+static unsigned long sim_link_bytes;
+
+/// Host -> device: requests in transit
+#define SIM_REQ_Q 64
+static struct {
+	uint8_t  f[BULKDL_HDR_LEN + 8 + BULKDL_CRC_LEN];
+	size_t   len;
+	uint64_t due_us;
+} sim_reqq[SIM_REQ_Q];
+static unsigned sim_reqq_head, sim_reqq_tail;
+
+/// Whether the (simulated) client program is running at all
+static int sim_client_up = 1;
+
+static int sim_in_outage(uint64_t t)
+{
+	return t >= sim_outage_start_us &&
+	       t < sim_outage_start_us + sim_outage_len_us;
+}
+
+static uint64_t sim_byte_time_us(size_t n)
+{
+	return (uint64_t)n * 10u * 1000000u / (uint64_t)sim_baud;
+}
+
+// Platform functions used by src/bulkdl.c and src/crc32.c
+void platform_tick_count(platform_timespec_t *tick)
+{
+	tick->nr_sec  = (uint32_t)(sim_now_us / 1000000u);
+	tick->nr_nsec = (uint32_t)(sim_now_us % 1000000u) * 1000u;
+}
+void platform_tick_hrcount(platform_timespec_t *tick)
+{
+	platform_tick_count(tick);
+}
+bool platform_usart_cdc_tx_busy(void)
+{
+	return sim_tx_idx < sim_tx_nr;
+}
+bool platform_usart_cdc_tx_async(const platform_usart_tx_bufdesc_t *desc,
+				 unsigned int nr_desc)
+{
+	uint64_t t = sim_now_us;
+
+	if (platform_usart_cdc_tx_busy() || nr_desc > BULKDL_BURST)
+		return false;
+	for (unsigned int i = 0; i < nr_desc; ++i) {
+		memcpy(sim_tx[i].f, desc[i].buf, desc[i].len);
+		sim_tx[i].len = desc[i].len;
+		t += sim_byte_time_us(desc[i].len);
+		sim_tx[i].done_us = t;
+	}
+	sim_tx_nr = nr_desc;
+	sim_tx_idx = 0;
+	return true;
+}
+
+static void sim_send(cl_t *cl, const uint8_t *f, size_t len)
+{
+	uint64_t due = sim_now_us + sim_latency_us + sim_byte_time_us(len);
+
+	(void)cl;
+	if (sim_in_outage(sim_now_us) || sim_in_outage(due) ||
+	    rng_chance(sim_frame_loss_pct))
+		return;
+	if (sim_reqq_head - sim_reqq_tail >= SIM_REQ_Q)
+		return;
+	memcpy(sim_reqq[sim_reqq_head % SIM_REQ_Q].f, f, len);
+	sim_reqq[sim_reqq_head % SIM_REQ_Q].len = len;
+	sim_reqq[sim_reqq_head % SIM_REQ_Q].due_us = due;
+	++sim_reqq_head;
+}
+
+/// The client's output "file"
+static uint8_t *sim_out;
+static size_t   sim_out_len;
+
+static void sim_write(cl_t *cl, const uint8_t *d, size_t len)
+{
+	(void)cl;
+	memcpy(&sim_out[sim_out_len], d, len);
+	sim_out_len += len;
+}
+
+static int run_selftest(double interrupt_frac)
+{
+	static cl_t cl;
+	static uint8_t ref[LOGSTORE_RAM_SZ + LOGSTORE_BLOCK_SZ];
+	uint32_t first, end, counter = 0;
+	uint64_t t_done_us = 0, last_rx_us = 0, last_nudge_us = 0;
+	uint64_t start_due_us = 0, t_down_us = 0;
+	unsigned long total = 0;
+	int restarted = 0;
+	bulkdl_stats_t bs;
+
+	logstore_init();
+	bulkdl_init();
+
+	// Fill the log past its capacity, so the oldest blocks are evicted
+	while (total < LOGSTORE_RAM_SZ + LOGSTORE_RAM_SZ / 4 + 100) {
+		uint8_t rec[4 + 24] = {0};
+		uint32_t ts_ms = counter * 250;
+
+		memcpy(&rec[0], &ts_ms, 4);
+		memcpy(&rec[4], &counter, 4);
+		logstore_append(UPLINK_REC_PM, rec, sizeof(rec));
+		total += 2 + sizeof(rec);
+		++counter;
+	}
+	first = logstore_first_block();
+	end = logstore_end_block();
+	for (uint32_t b = first; b < end; ++b)
+		logstore_read_block(b, &ref[(size_t)(b - first) * LOGSTORE_BLOCK_SZ]);
+	total = total - (unsigned long)first * LOGSTORE_BLOCK_SZ;
+
+	sim_out = calloc(1, (size_t)(end - first) * LOGSTORE_BLOCK_SZ);
+	if (sim_out == NULL)
+		return 1;
+	cl.send = sim_send;
+	cl.write = sim_write;
+	cl_resume(&cl, first, 0);
+
+	for (sim_now_us = 0; !cl.done && sim_now_us < 3600ull * 1000000;
+	     sim_now_us += 100) {
+		platform_timespec_t now;
+
+		// Client (re)starts and asks for whatever it does not have
+		if (sim_client_up && !cl.in_session && sim_now_us >= start_due_us) {
+			cl_start(&cl);
+			start_due_us = sim_now_us + 1000000;
+		}
+
+		// Device -> host frames complete one after the other
+		while (sim_tx_idx < sim_tx_nr &&
+		       sim_tx[sim_tx_idx].done_us <= sim_now_us) {
+			sim_link_bytes += sim_tx[sim_tx_idx].len;
+			if (sim_client_up && !sim_in_outage(sim_now_us) &&
+			    !rng_chance(sim_frame_loss_pct)) {
+				unsigned long before = cl.frames_ok;
+
+				cl_feed(&cl, sim_tx[sim_tx_idx].f, sim_tx[sim_tx_idx].len);
+				if (cl.frames_ok != before)
+					last_rx_us = sim_now_us;
+			}
+			++sim_tx_idx;
+		}
+
+		// Quiet link: nudge the device once a second
+		if (sim_client_up && cl.in_session &&
+		    sim_now_us - last_rx_us >= 1000000 &&
+		    sim_now_us - last_nudge_us >= 1000000) {
+			cl_nudge(&cl, (unsigned)((sim_now_us - last_rx_us) / 1000000));
+			last_nudge_us = sim_now_us;
+		}
+
+		// Kill the client part-way through, and start a fresh one later
+		if (!restarted && interrupt_frac > 0 &&
+		    cl.next - first >= (uint32_t)(interrupt_frac * (end - first))) {
+			size_t keep;
+
+			restarted = 1;
+			sim_client_up = 0;
+			t_down_us = sim_now_us;
+			keep = sim_out_len;
+			memset(&cl, 0, sizeof(cl));
+			cl.send = sim_send;
+			cl.write = sim_write;
+			sim_out_len = cl_resume(&cl, first, keep);
+		}
+		if (!sim_client_up && sim_now_us - t_down_us >= 3000000) {
+			sim_client_up = 1;
+			start_due_us = sim_now_us;
+		}
+
+		// Host -> device requests arrive
+		while (sim_reqq_tail != sim_reqq_head &&
+		       sim_reqq[sim_reqq_tail % SIM_REQ_Q].due_us <= sim_now_us) {
+			bulkdl_rx_feed((const char *)sim_reqq[sim_reqq_tail % SIM_REQ_Q].f,
+				       (uint16_t)sim_reqq[sim_reqq_tail % SIM_REQ_Q].len);
+			++sim_reqq_tail;
+		}
+
+		platform_tick_count(&now);
+		bulkdl_service(&now);
+	}
+	t_done_us = sim_now_us;
+
+	bulkdl_get_stats(&bs);
+	printf("link:     %ld bd, frame loss %.1f%%, outage %.1f s at t=%.1f s, "
+	       "client restart %s\n",
+	       sim_baud, sim_frame_loss_pct, sim_outage_len_us / 1e6,
+	       sim_outage_start_us / 1e6, restarted ? "after 3.0 s down" : "off");
+	printf("log:      blocks %u..%u (%lu B, %u B/block), window %u, burst %u\n",
+	       first, end, total, LOGSTORE_BLOCK_SZ, BULKDL_WINDOW, BULKDL_BURST);
+	printf("device:   sessions %u (done %u, expired %u), blocks sent %u, "
+	       "resent %u, timeouts %u, bad requests %u\n",
+	       bs.sessions, bs.sessions_done, bs.sessions_expired,
+	       bs.blocks_sent, bs.blocks_resent, bs.timeouts, bs.frames_bad);
+	printf("client:   %lu B written, %lu dup blocks, %lu bad frames, "
+	       "%lu evicted blocks\n",
+	       (unsigned long)sim_out_len, cl.blocks_dup, cl.frames_bad,
+	       cl.blocks_evicted);
+	if (cl.done) {
+		double secs = t_done_us / 1e6;
+
+		printf("transfer: %.2f s, goodput %.0f B/s = %.1f%% of the %ld B/s "
+		       "link; link busy %.1f%% of the time\n",
+		       secs, total / secs, 100.0 * total / secs / (sim_baud / 10.0),
+		       sim_baud / 10,
+		       100.0 * sim_link_bytes / secs / (sim_baud / 10.0));
+	} else {
+		printf("transfer: NOT complete\n");
+	}
+
+	if (!cl.done || sim_out_len != total || memcmp(sim_out, ref, total) != 0) {
+		printf("verify:   MISMATCH\n");
+		return 2;
+	}
+	printf("verify:   output matches the device log byte for byte\n");
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-d DEVICE] [-b BAUD] -o OUT.bin\n"
+		"       %s [-d DEVICE] [-b BAUD] -m\n"
+		"       %s -S [-b BAUD] [-l FRAME_LOSS_PCT] [-a OUTAGE_START_S]\n"
+		"          [-w OUTAGE_LEN_S] [-i INTERRUPT_AT_FRACTION] [-s SEED]\n",
+		argv0, argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dev = "/dev/ttyACM0";
+	const char *out = NULL;
+	long baud = 38400;
+	double loss = 0.0, interrupt_frac = 0.0;
+	int selftest = 0, metrics = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:b:o:l:Sma:w:i:s:h")) != -1) {
+		switch (c) {
+		case 'd': dev = optarg; break;
+		case 'b': baud = strtol(optarg, NULL, 10); break;
+		case 'o': out = optarg; break;
+		case 'l': loss = strtod(optarg, NULL); break;
+		case 'S': selftest = 1; break;
+		case 'm': metrics = 1; break;
+		case 'a': sim_outage_start_us = (uint64_t)(strtod(optarg, NULL) * 1e6); break;
+		case 'w': sim_outage_len_us = (uint64_t)(strtod(optarg, NULL) * 1e6); break;
+		case 'i': interrupt_frac = strtod(optarg, NULL); break;
+		case 's': rng_state = (uint32_t)strtoul(optarg, NULL, 0) | 1u; break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (selftest) {
+		if (baud <= 0 || interrupt_frac >= 1.0) {
+			usage(argv[0]);
+			return 1;
+		}
+		sim_baud = baud;
+		sim_frame_loss_pct = loss;
+		return run_selftest(interrupt_frac);
+	}
+
+	if (metrics)
+		return run_metrics(dev, baud);
+	if (out == NULL) {
+		usage(argv[0]);
+		return 1;
+	}
+	return run_serial(dev, baud, out);
+}
@@ -0,0 +1,511 @@
+/**
+ * @file host/tools/capconv.c
+ * @brief Batch converter from terminal captures to columnar archives.
+ *
+ * Converts any number of captures (putty.log-style, as recorded from the
+ * board or from the sensors directly) into one archive each (host/lib/sarc.h):
+ * a row per PMS frame, with the UTC time and position of the GPS data last
+ * seen before it.
+ *
+ * Each capture is memory-mapped and cut into chunks of -c MiB at
+ * resynchronisation points (host/lib/capscan.h), so every chunk can be
+ * decoded on its own. A pool of -j threads decodes the chunks of all
+ * captures; the main thread merges them in order and writes the archives.
+ *
+ * A chunk cannot know the GPS state left by the chunks before it. Its rows
+ * therefore record only what the chunk itself has seen (date, time of day,
+ * position, each possibly unknown), and the merge fills in the rest from the
+ * state carried over from the previous chunk, so the output does not depend
+ * on the chunk size or the number of threads.
+ *
+ * The output of each capture goes to OUTDIR, named after the capture path
+ * with '/' replaced by '_' (unit07/putty.log -> unit07_putty.log.sarc), so
+ * captures of many units with the same file name do not collide.
+ *
+ * -B converts the same inputs with 1, 2, 4, ... up to -j threads (into a
+ * scratch directory) and prints the speed-up of each.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -pthread -Iinc -Ihost/lib -o capconv host/tools/capconv.c \
+ *      host/lib/capscan.c host/lib/sarc.c host/lib/sdec.c \
+ *      src/parsers/nmea_parse.c src/parsers/pms_parser.c -lm
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "capscan.h"
+#include "sarc.h"
+#include "sdec.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// GPS state
+
+#define FIX_DATE	0x1	// days is valid
+#define FIX_TOD		0x2	// tod_ms is valid
+#define FIX_POS		0x4	// lat/lon are valid (NAN: the receiver has no fix)
+
+/// What is known about the GPS at some point of a capture
+typedef struct fix_type {
+	uint8_t known;		// FIX_*
+	int32_t days;		// UTC date, days since 1970-01-01
+	int32_t tod_ms;		// UTC time of day
+	double  lat, lon;
+} fix_t;
+
+/// Days since 1970-01-01 of a civil date
+static int32_t days_from_civil(int y, int m, int d)
+{
+	int era, yoe, doy, doe;
+
+	y -= m <= 2;
+	era = y / 400;
+	yoe = y - era * 400;
+	doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+	doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+static int digits(const char *s, int n)
+{
+	int v = 0;
+
+	for (int i = 0; i < n; ++i) {
+		if (s[i] < '0' || s[i] > '9')
+			return -1;
+		v = v * 10 + (s[i] - '0');
+	}
+	return v;
+}
+
+/// "hhmmss[.sss]" to ms; -1 if malformed
+static int32_t parse_tod(const char *s, size_t len)
+{
+	int h, m, sec, ms = 0;
+
+	if (len < 6 || (h = digits(s, 2)) < 0 || (m = digits(s + 2, 2)) < 0 ||
+	    (sec = digits(s + 4, 2)) < 0 || h > 23 || m > 59 || sec > 60)
+		return -1;
+	if (len > 7 && s[6] == '.') {
+		int scale = 100;
+
+		for (size_t i = 7; i < len && scale > 0; ++i, scale /= 10)
+			ms += (s[i] - '0') * scale;
+	}
+	return ((h * 60 + m) * 60 + sec) * 1000 + ms;
+}
+
+/// "ddmmyy" to days since the epoch; -1 if malformed
+static int32_t parse_date(const char *s, size_t len)
+{
+	int d, m, y;
+
+	if (len != 6 || (d = digits(s, 2)) < 1 || (m = digits(s + 2, 2)) < 1 ||
+	    (y = digits(s + 4, 2)) < 0 || d > 31 || m > 12)
+		return -1;
+	return days_from_civil(2000 + y, m, d);
+}
+
+/// Update the GPS state from a (checksum-verified) sentence
+static void fix_update(fix_t *fx, const char *s, size_t len)
+{
+	sdec_fix_t sf;
+	int32_t v;
+
+	// RMC and GLL carry the receiver status the position depends on
+	if (!sdec_nmea_fix(s, len, &sf) || strcmp(sf.type, "GGA") == 0)
+		return;
+	if ((v = parse_tod(sf.tod, sf.tod_len)) >= 0) {
+		fx->tod_ms = v;
+		fx->known |= FIX_TOD;
+	}
+	if (sf.date != NULL && (v = parse_date(sf.date, sf.date_len)) >= 0) {
+		fx->days = v;
+		fx->known |= FIX_DATE;
+	}
+	fx->lat = sf.lat;
+	fx->lon = sf.lon;
+	fx->known |= FIX_POS;
+}
+
+/// Fill what @p fx does not know from @p prev
+static void fix_inherit(fix_t *fx, const fix_t *prev)
+{
+	if (!(fx->known & FIX_DATE) && (prev->known & FIX_DATE))
+		fx->days = prev->days;
+	if (!(fx->known & FIX_TOD) && (prev->known & FIX_TOD))
+		fx->tod_ms = prev->tod_ms;
+	if (!(fx->known & FIX_POS) && (prev->known & FIX_POS)) {
+		fx->lat = prev->lat;
+		fx->lon = prev->lon;
+	}
+	fx->known |= prev->known;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Chunks and captures
+
+/// A PMS frame and the GPS state the chunk had seen before it
+typedef struct crow_type {
+	fix_t    fix;
+	uint16_t pm[SARC_NR_PM];
+} crow_t;
+
+struct job_type;
+
+typedef struct task_type {
+	struct job_type *job;
+	size_t begin, stop;
+
+	// Results
+	crow_t *rows;
+	size_t  nr_rows, max_rows;
+	fix_t   fix;		// GPS state at the end of the chunk
+	capscan_stats_t st;
+	int     done;
+} task_t;
+
+typedef struct job_type {
+	const char    *path;
+	char           out[4096];
+	const uint8_t *base;
+	size_t         size;
+	unsigned       first_task, nr_tasks;
+
+	sarc_writer_t *w;
+	fix_t          carry;
+	uint64_t       rows;
+	capscan_stats_t st;
+} job_t;
+
+static void on_nmea(void *user, size_t off, const char *s, size_t len)
+{
+	task_t *t = user;
+
+	(void)off;
+	fix_update(&t->fix, s, len);
+}
+
+static void on_pms(void *user, size_t off, const pms_data_t *d)
+{
+	task_t *t = user;
+	crow_t *r;
+
+	(void)off;
+	if (t->nr_rows == t->max_rows) {
+		t->max_rows = t->max_rows ? t->max_rows * 2 : 1024;
+		t->rows = realloc(t->rows, t->max_rows * sizeof(*t->rows));
+		if (t->rows == NULL) {
+			perror("realloc");
+			exit(1);
+		}
+	}
+	r = &t->rows[t->nr_rows++];
+	r->fix = t->fix;
+	r->pm[0] = d->pm1_0_std;
+	r->pm[1] = d->pm2_5_std;
+	r->pm[2] = d->pm10_std;
+	r->pm[3] = d->pm1_0_atm;
+	r->pm[4] = d->pm2_5_atm;
+	r->pm[5] = d->pm10_atm;
+	r->pm[6] = d->particles_0_3um;
+	r->pm[7] = d->particles_0_5um;
+	r->pm[8] = d->particles_1_0um;
+	r->pm[9] = d->particles_2_5um;
+	r->pm[10] = d->particles_5_0um;
+	r->pm[11] = d->particles_10um;
+}
+
+static void task_run(task_t *t)
+{
+	capscan_ops_t ops = { .on_nmea = on_nmea, .on_pms = on_pms, .user = t };
+
+	t->fix.lat = t->fix.lon = NAN;
+	capscan_run(t->job->base, t->job->size, t->begin, t->stop, &ops, &t->st);
+}
+
+/// Merge a finished chunk into its capture's archive
+static int task_merge(task_t *t)
+{
+	job_t *j = t->job;
+
+	for (size_t i = 0; i < t->nr_rows; ++i) {
+		crow_t *r = &t->rows[i];
+		sarc_row_t row;
+
+		fix_inherit(&r->fix, &j->carry);
+		row.t_ms = (r->fix.known & (FIX_DATE | FIX_TOD)) == (FIX_DATE | FIX_TOD) ?
+			   (int64_t)r->fix.days * 86400000 + r->fix.tod_ms : 0;
+		row.lat = (r->fix.known & FIX_POS) ? r->fix.lat : NAN;
+		row.lon = (r->fix.known & FIX_POS) ? r->fix.lon : NAN;
+		memcpy(row.pm, r->pm, sizeof(row.pm));
+		if (sarc_append(j->w, &row) != 0)
+			return -1;
+	}
+	fix_inherit(&t->fix, &j->carry);
+	j->carry = t->fix;
+	j->rows += t->nr_rows;
+
+	j->st.nmea += t->st.nmea;
+	j->st.nmea_bad += t->st.nmea_bad;
+	j->st.pms += t->st.pms;
+	j->st.pms_bad += t->st.pms_bad;
+	j->st.bad_bytes += t->st.bad_bytes;
+
+	free(t->rows);
+	t->rows = NULL;
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Thread pool
+
+static task_t *tasks;
+static unsigned nr_tasks, next_task, merged;
+static unsigned window;		// Chunks decoded ahead of the merge, at most
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  cond = PTHREAD_COND_INITIALIZER;
+
+static void *worker(void *arg)
+{
+	(void)arg;
+	pthread_mutex_lock(&lock);
+	for (;;) {
+		task_t *t;
+
+		// Bound the decoded rows waiting for the merge
+		while (next_task < nr_tasks && next_task >= merged + window)
+			pthread_cond_wait(&cond, &lock);
+		if (next_task == nr_tasks)
+			break;
+		t = &tasks[next_task++];
+		pthread_mutex_unlock(&lock);
+
+		task_run(t);
+
+		pthread_mutex_lock(&lock);
+		t->done = 1;
+		pthread_cond_broadcast(&cond);
+	}
+	pthread_mutex_unlock(&lock);
+	return NULL;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/// Map the captures and cut them into chunks
+static job_t *plan(char **paths, unsigned nr_paths, const char *outdir, size_t chunk)
+{
+	job_t *jobs = calloc(nr_paths, sizeof(*jobs));
+	unsigned max_tasks = 0;
+
+	nr_tasks = 0;
+	for (unsigned i = 0; i < nr_paths; ++i) {
+		job_t *j = &jobs[i];
+		struct stat sb;
+		int fd = open(paths[i], O_RDONLY);
+		size_t at = 0;
+		char *c;
+
+		if (fd < 0 || fstat(fd, &sb) != 0) {
+			perror(paths[i]);
+			exit(1);
+		}
+		j->path = paths[i];
+		j->size = (size_t)sb.st_size;
+		j->base = j->size ? mmap(NULL, j->size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+		close(fd);
+		if (j->base == MAP_FAILED) {
+			perror(paths[i]);
+			exit(1);
+		}
+		if (j->size)
+			madvise((void *)j->base, j->size, MADV_SEQUENTIAL);
+
+		snprintf(j->out, sizeof(j->out), "%s/%s.sarc", outdir, paths[i]);
+		for (c = j->out + strlen(outdir) + 1; *c; ++c)
+			if (*c == '/')
+				*c = '_';
+		j->carry.lat = j->carry.lon = NAN;
+
+		j->first_task = nr_tasks;
+		do {
+			size_t next = j->size;
+
+			if (at + chunk < j->size)
+				next = capscan_resync(j->base, j->size, at + chunk);
+			if (nr_tasks == max_tasks) {
+				max_tasks = max_tasks ? max_tasks * 2 : 64;
+				tasks = realloc(tasks, max_tasks * sizeof(*tasks));
+			}
+			memset(&tasks[nr_tasks], 0, sizeof(*tasks));
+			tasks[nr_tasks].begin = at;
+			tasks[nr_tasks].stop = next;
+			++nr_tasks;
+			at = next;
+		} while (at < j->size);
+		j->nr_tasks = nr_tasks - j->first_task;
+	}
+	// Job pointers are set once the task array has stopped moving
+	for (unsigned i = 0; i < nr_paths; ++i)
+		for (unsigned k = 0; k < jobs[i].nr_tasks; ++k)
+			tasks[jobs[i].first_task + k].job = &jobs[i];
+	return jobs;
+}
+
+static int convert(char **paths, unsigned nr_paths, const char *outdir,
+		   size_t chunk, unsigned nr_threads, int quiet, double *secs)
+{
+	pthread_t th[256];
+	job_t *jobs;
+	uint64_t t0 = now_ns(), in_bytes = 0, out_bytes = 0, rows = 0;
+	int err = 0;
+
+	jobs = plan(paths, nr_paths, outdir, chunk);
+	next_task = merged = 0;
+	window = 4 * nr_threads;
+	for (unsigned i = 0; i < nr_threads; ++i)
+		pthread_create(&th[i], NULL, worker, NULL);
+
+	for (unsigned i = 0; i < nr_tasks; ++i) {
+		task_t *t = &tasks[i];
+		job_t *j = t->job;
+
+		pthread_mutex_lock(&lock);
+		while (!t->done)
+			pthread_cond_wait(&cond, &lock);
+		pthread_mutex_unlock(&lock);
+
+		if (i == j->first_task && (j->w = sarc_create(j->out)) == NULL) {
+			perror(j->out);
+			exit(1);
+		}
+		if (task_merge(t) != 0)
+			err = 1;
+
+		pthread_mutex_lock(&lock);
+		++merged;
+		pthread_cond_broadcast(&cond);
+		pthread_mutex_unlock(&lock);
+
+		if (i == j->first_task + j->nr_tasks - 1) {
+			uint64_t ob = sarc_bytes_written(j->w);
+
+			if (sarc_close(j->w) != 0) {
+				perror(j->out);
+				err = 1;
+			}
+			// Close flushed the last block; stat for the final size
+			struct stat sb;
+			if (stat(j->out, &sb) == 0)
+				ob = (uint64_t)sb.st_size;
+			if (!quiet)
+				printf("%s -> %s: %llu rows, %llu/%llu NMEA/PMS ok, %llu/%llu bad, %u chunks, %.1fx smaller\n",
+				       j->path, j->out, (unsigned long long)j->rows,
+				       (unsigned long long)j->st.nmea, (unsigned long long)j->st.pms,
+				       (unsigned long long)j->st.nmea_bad, (unsigned long long)j->st.pms_bad,
+				       j->nr_tasks, ob ? (double)j->size / ob : 0.0);
+			in_bytes += j->size;
+			out_bytes += ob;
+			rows += j->rows;
+			if (j->size)
+				munmap((void *)j->base, j->size);
+		}
+	}
+	for (unsigned i = 0; i < nr_threads; ++i)
+		pthread_join(th[i], NULL);
+
+	*secs = (now_ns() - t0) / 1e9;
+	if (!quiet)
+		printf("%u captures, %.1f MiB in %.2f s (%.0f MiB/s, %u threads): %llu rows, %.1f MiB out\n",
+		       nr_paths, in_bytes / 1048576.0, *secs, in_bytes / 1048576.0 / *secs,
+		       nr_threads, (unsigned long long)rows, out_bytes / 1048576.0);
+	free(tasks);
+	tasks = NULL;
+	free(jobs);
+	return err;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-j THREADS] [-c CHUNK_MIB] [-d OUTDIR] CAPTURE...\n"
+		"       %s -B [-j MAX_THREADS] [-c CHUNK_MIB] CAPTURE...\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *outdir = ".";
+	long nr_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	double chunk_mib = 16.0, secs;
+	int bench = 0, c;
+
+	while ((c = getopt(argc, argv, "j:c:d:Bh")) != -1) {
+		switch (c) {
+		case 'j': nr_threads = strtol(optarg, NULL, 10); break;
+		case 'c': chunk_mib = strtod(optarg, NULL); break;
+		case 'd': outdir = optarg; break;
+		case 'B': bench = 1; break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind == argc || nr_threads < 1 || nr_threads > 256 || chunk_mib <= 0) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (bench) {
+		char tmp[] = "/tmp/capconv.XXXXXX";
+		double base = 0;
+
+		if (mkdtemp(tmp) == NULL) {
+			perror("mkdtemp");
+			return 1;
+		}
+		printf("threads   seconds   speed-up\n");
+		for (long n = 1; n <= nr_threads; n = n < nr_threads && n * 2 > nr_threads ? nr_threads : n * 2) {
+			convert(&argv[optind], (unsigned)(argc - optind), tmp,
+				(size_t)(chunk_mib * 1048576), (unsigned)n, 1, &secs);
+			if (n == 1)
+				base = secs;
+			printf("%7ld %9.2f %9.2fx\n", n, secs, base / secs);
+			if (n == nr_threads)
+				break;
+		}
+		printf("(scratch output left in %s)\n", tmp);
+		return 0;
+	}
+	return convert(&argv[optind], (unsigned)(argc - optind), outdir,
+		       (size_t)(chunk_mib * 1048576), (unsigned)nr_threads, 0, &secs);
+}
@@ -0,0 +1,337 @@
+/**
+ * @file host/tools/capdemux.c
+ * @brief Splits mixed terminal captures into typed record streams.
+ *
+ * A PuTTY capture of the board's CDC port interleaves three kinds of data:
+ *
+ * - ANSI-coloured text lines from src/terminal_ui.c;
+ * - raw NMEA sentences, echoed behind a "[GPS RAW]" tag;
+ * - binary PMS frames (0x42 0x4D ...), echoed unescaped behind a "[PM" tag,
+ *   so they can contain any byte, line endings included.
+ *
+ * This tool walks the capture once and writes each kind to its own stream:
+ *
+ * - PREFIX.nmea     offset, sentence (XOR checksum verified)
+ * - PREFIX.pms.csv  offset and the 12 PMS channels (frame checksum verified
+ *                   by the firmware's parser, src/parsers/pms_parser.c)
+ * - PREFIX.txt      offset, text line with the ANSI sequences removed
+ * - PREFIX.bad      offset, length and reason of every corrupt span: NMEA
+ *                   and PMS records that fail their checksum or are cut
+ *                   short, and lines holding bytes a terminal line cannot
+ *
+ * The tags in front of a record on the same line are framing and are
+ * dropped. The capture is memory-mapped and scanned by host/lib/capscan.c.
+ *
+ * -G writes a synthetic capture in the same layout, with a given share of
+ * damaged records, for checking the counts and timing large files.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -Ihost/lib -o capdemux host/tools/capdemux.c \
+ *      host/lib/capscan.c src/parsers/pms_parser.c
+ */
+
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "capscan.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static FILE *out_nmea, *out_pms, *out_txt, *out_bad;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Streams
+
+static void on_nmea(void *user, size_t off, const char *s, size_t len)
+{
+	(void)user;
+	fprintf(out_nmea, "%zu,%.*s\n", off, (int)len, s);
+}
+
+static void on_pms(void *user, size_t off, const pms_data_t *d)
+{
+	(void)user;
+	fprintf(out_pms, "%zu,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u\n", off,
+		d->pm1_0_std, d->pm2_5_std, d->pm10_std,
+		d->pm1_0_atm, d->pm2_5_atm, d->pm10_atm,
+		d->particles_0_3um, d->particles_0_5um, d->particles_1_0um,
+		d->particles_2_5um, d->particles_5_0um, d->particles_10um);
+}
+
+static void on_text(void *user, size_t off, const char *s, size_t len)
+{
+	(void)user;
+	fprintf(out_txt, "%zu,%.*s\n", off, (int)len, s);
+}
+
+static void on_bad(void *user, size_t off, size_t len, const char *why)
+{
+	(void)user;
+	fprintf(out_bad, "%zu,%zu,%s\n", off, len, why);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Synthetic captures
+
+/// Deterministic PRNG (xorshift32), so generated captures are reproducible
+static uint32_t rng_state = 0x2545F491;
+static uint32_t rng_next(void)
+{
+	uint32_t x = rng_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+
+/// Step a reading by -1, 0 or +1 within [lo, hi], like a slowly drifting sensor
+static unsigned drift(unsigned v, unsigned lo, unsigned hi)
+{
+	unsigned r = rng_next() % 4;
+
+	if (r == 0 && v > lo)
+		return v - 1;
+	if (r == 1 && v < hi)
+		return v + 1;
+	return v;
+}
+
+/// Damage a record: flip a byte, or cut it short (as the echo can)
+static size_t damage(uint8_t *rec, size_t len)
+{
+	if (rng_next() & 1) {
+		rec[1 + rng_next() % (len - 3)] ^= 0x10;
+		return len;
+	}
+	return 4 + rng_next() % (len - 8);
+}
+
+static int generate(const char *path, double mbytes, double bad_pct)
+{
+	static const char *const texts[] = {
+		"\033[1;36m[STATUS]\033[0m GPS: \033[32mOK\033[0m | PM: \033[32mOK\033[0m | Uptime: %lu s\r\n",
+		"\033[33m[LAT]\033[0m GPS %lu/%lu stamped: avg 412 us, min 180, max 977\r\n",
+		"\033[2K\r\033[97m%02lu:%02lu:%02lu\033[0m | Lat: 14.6\033[0m | Long: 121.07 | PM2.5: %lu ug/m3\r\n",
+	};
+	FILE *f = fopen(path, "wb");
+	unsigned long long target = (unsigned long long)(mbytes * 1024 * 1024);
+	unsigned long long written = 0, recs = 0, bad = 0;
+	unsigned long t = 0;
+	unsigned threshold = (unsigned)(bad_pct * 100.0);
+	// A unit walking slowly around campus, and what its sensor reads
+	unsigned lat = 390000, lon = 40000;	// 1e-4 minutes past 14 N, 121 E
+	unsigned pm[12] = { 18, 25, 31, 14, 21, 29, 3100, 920, 160, 12, 3, 1 };
+
+	if (f == NULL) {
+		perror(path);
+		return 1;
+	}
+	while (written < target) {
+		uint8_t rec[128];
+		char body[96];
+		size_t len;
+		int is_bad = (rng_next() % 10000u) < threshold;
+
+		switch (rng_next() % 4) {
+		case 0: {	// NMEA echo, GLL and RMC in turn
+			unsigned long sec = t / 4;
+			char hms[16];
+			uint8_t sum = 0;
+
+			snprintf(hms, sizeof(hms), "%02lu%02lu%02lu.00",
+				 sec / 3600 % 24, sec / 60 % 60, sec % 60);
+			if (rng_next() % 8 == 0) {
+				lat = drift(lat, 10000, 590000);
+				lon = drift(lon, 10000, 590000);
+			}
+			if (t & 1)
+				snprintf(body, sizeof(body), "GPGLL,14%02u.%04u,N,121%02u.%04u,E,%s,A,A",
+					 lat / 10000, lat % 10000, lon / 10000, lon % 10000, hms);
+			else
+				snprintf(body, sizeof(body), "GPRMC,%s,A,14%02u.%04u,N,121%02u.%04u,E,0.0,,%02lu0525,,,A",
+					 hms, lat / 10000, lat % 10000, lon / 10000, lon % 10000,
+					 1 + sec / 86400 % 28);
+			for (const char *c = body; *c; ++c)
+				sum ^= (uint8_t)*c;
+			written += (unsigned long long)fprintf(f, "\033[32m[GPS RAW] \033[0m");
+			len = (size_t)snprintf((char *)rec, sizeof(rec), "$%s*%02X\r\n", body, sum);
+			break;
+		}
+		case 1: {	// PMS echo, behind the tag the firmware leaves
+			uint16_t sum = 0;
+
+			rec[0] = 0x42; rec[1] = 0x4D; rec[2] = 0x00; rec[3] = 28;
+			for (int i = 0; i < 12; ++i) {
+				pm[i] = drift(pm[i], 0, i < 6 ? 500 : 20000);
+				rec[4 + 2 * i] = (uint8_t)(pm[i] >> 8);
+				rec[5 + 2 * i] = (uint8_t)pm[i];
+			}
+			rec[28] = 0x97;		// Version, error code
+			rec[29] = 0x00;
+			for (int i = 0; i < 30; ++i)
+				sum += rec[i];
+			rec[30] = (uint8_t)(sum >> 8);
+			rec[31] = (uint8_t)sum;
+			written += (unsigned long long)fprintf(f, "\033[33m[PM");
+			len = 32;
+			break;
+		}
+		default:	// Text
+			len = (size_t)snprintf((char *)rec, sizeof(rec), texts[rng_next() % 3],
+					       t, t % 60, t / 2, t % 97);
+			is_bad = 0;
+			--recs;
+			break;
+		}
+		if (is_bad) {
+			len = damage(rec, len);
+			++bad;
+		}
+		fwrite(rec, 1, len, f);
+		written += len;
+		if (rec[0] == 0x42)
+			written += (unsigned long long)fprintf(f, "\r\n");
+		++recs;
+		++t;
+	}
+	fclose(f);
+	fprintf(stderr, "%s: %llu bytes, %llu records, %llu damaged\n", path, written, recs, bad);
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static FILE *open_stream(const char *prefix, const char *suffix, const char *header)
+{
+	char path[4096];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s%s", prefix, suffix);
+	if ((f = fopen(path, "w")) == NULL) {
+		perror(path);
+		exit(1);
+	}
+	setvbuf(f, NULL, _IOFBF, 1 << 20);
+	if (header != NULL)
+		fputs(header, f);
+	return f;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-o PREFIX] CAPTURE\n"
+		"       %s -G CAPTURE [-n MBYTES] [-c DAMAGED_PCT] [-s SEED]\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *prefix = NULL, *gen = NULL;
+	double mbytes = 64.0, bad_pct = 1.0;
+	capscan_ops_t ops = { 0 };
+	capscan_stats_t st = { 0 };
+	struct stat sb;
+	const uint8_t *map;
+	uint64_t t0, dt;
+	int c, fd;
+
+	while ((c = getopt(argc, argv, "o:G:n:c:s:h")) != -1) {
+		switch (c) {
+		case 'o': prefix = optarg; break;
+		case 'G': gen = optarg; break;
+		case 'n': mbytes = strtod(optarg, NULL); break;
+		case 'c': bad_pct = strtod(optarg, NULL); break;
+		case 's': rng_state = (uint32_t)strtoul(optarg, NULL, 0) | 1u; break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (gen != NULL)
+		return generate(gen, mbytes, bad_pct);
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if ((fd = open(argv[optind], O_RDONLY)) < 0 || fstat(fd, &sb) != 0) {
+		perror(argv[optind]);
+		return 1;
+	}
+	if (sb.st_size == 0) {
+		fprintf(stderr, "%s: empty\n", argv[optind]);
+		return 1;
+	}
+	map = mmap(NULL, (size_t)sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED) {
+		perror("mmap");
+		return 1;
+	}
+	madvise((void *)map, (size_t)sb.st_size, MADV_SEQUENTIAL);
+
+	if (prefix != NULL) {
+		out_nmea = open_stream(prefix, ".nmea", "offset,sentence\n");
+		out_pms  = open_stream(prefix, ".pms.csv",
+				       "offset,pm1_0_std,pm2_5_std,pm10_std,pm1_0_atm,pm2_5_atm,pm10_atm,"
+				       "n0_3,n0_5,n1_0,n2_5,n5_0,n10\n");
+		out_txt  = open_stream(prefix, ".txt", "offset,line\n");
+		out_bad  = open_stream(prefix, ".bad", "offset,length,reason\n");
+		ops.on_nmea = on_nmea;
+		ops.on_pms = on_pms;
+		ops.on_text = on_text;
+		ops.on_bad = on_bad;
+	}
+
+	t0 = now_ns();
+	capscan_run(map, (size_t)sb.st_size, 0, (size_t)sb.st_size, &ops, &st);
+	dt = now_ns() - t0;
+
+	if (prefix != NULL) {
+		fclose(out_nmea);
+		fclose(out_pms);
+		fclose(out_txt);
+		fclose(out_bad);
+	}
+	printf("%s: %lld bytes in %.3f s (%.0f MB/s, %s scan)\n", argv[optind],
+	       (long long)sb.st_size, dt / 1e9, sb.st_size / 1048576.0 / (dt / 1e9),
+	       capscan_engine());
+	printf("  nmea  %12llu ok %10llu bad\n",
+	       (unsigned long long)st.nmea, (unsigned long long)st.nmea_bad);
+	printf("  pms   %12llu ok %10llu bad\n",
+	       (unsigned long long)st.pms, (unsigned long long)st.pms_bad);
+	printf("  text  %12llu ok %10llu bad (%llu cut)\n", (unsigned long long)st.txt,
+	       (unsigned long long)st.txt_bad, (unsigned long long)st.txt_cut);
+	printf("  ansi  %12llu sequences removed\n", (unsigned long long)st.ansi);
+	printf("  corrupt spans cover %llu bytes\n", (unsigned long long)st.bad_bytes);
+	munmap((void *)map, (size_t)sb.st_size);
+	close(fd);
+	return 0;
+}
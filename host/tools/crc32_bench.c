@@ -0,0 +1,273 @@
+/**
+ * @file host/tools/crc32_bench.c
+ * @brief Checks and times the CRC32 service (src/crc32.c) on the host.
+ *
+ * - Verifies crc32_update() and crc32_sw() against a bit-at-a-time reference
+ *   and the standard check value, over random lengths, alignments and chain
+ *   split points (the same splits the DSU path makes at word boundaries).
+ * - Times the table against the bit-wise loop and the 16-entry nibble table
+ *   that bulkdl.c used before, in ns per call and MB/s.
+ * - Runs the firmware's own crc32_bench() on the host clock, which gives the
+ *   software half of the comparison the board prints at start-up with
+ *   CRC32_BENCH_AT_BOOT set in src/main.c (the DSU half needs the board).
+ *
+ * Built with -DCRC32_BACKEND=1, the DSU path of crc32_update() runs against
+ * a stand-in for platform_dsu_crc32() that rejects misaligned ranges, so the
+ * head/word/tail split is checked as well.
+ *
+ * With -d the tool instead reads those start-up lines from the board and
+ * prints the speed-up of the DSU at each length.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -o crc32_bench host/tools/crc32_bench.c src/crc32.c
+ */
+
+#define _DEFAULT_SOURCE
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "crc32.h"
+#include "platform.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Platform stand-ins
+
+void platform_tick_hrcount(platform_timespec_t *tick)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	tick->nr_sec  = (uint32_t)ts.tv_sec;
+	tick->nr_nsec = (uint32_t)ts.tv_nsec;
+}
+
+/// Words processed by the DSU stand-in, to confirm the DSU path was taken
+static uint64_t dsu_words;
+
+bool platform_dsu_crc32(const void *addr, uint32_t len, uint32_t *crc)
+{
+	const uint8_t *p = addr;
+	uint32_t reg = *crc;
+
+	if (((uintptr_t)addr & 0x3) != 0 || len == 0 || (len & 0x3) != 0) {
+		fprintf(stderr, "platform_dsu_crc32: bad range %p+%u\n", addr, len);
+		abort();
+	}
+	for (uint32_t i = 0; i < len; ++i) {
+		reg ^= p[i];
+		for (int k = 0; k < 8; ++k)
+			reg = (reg >> 1) ^ (0xEDB88320u & -(reg & 1u));
+	}
+	dsu_words += len / 4;
+	*crc = reg;
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Reference engines
+
+static uint32_t crc32_bitwise(uint32_t crc, const void *buf, size_t len)
+{
+	const uint8_t *p = buf;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		for (int k = 0; k < 8; ++k)
+			crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+	}
+	return ~crc;
+}
+
+/// The implementation bulkdl.c carried before src/crc32.c
+static uint32_t crc32_nibble(uint32_t crc, const void *buf, size_t len)
+{
+	static const uint32_t tbl[16] = {
+		0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+		0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+		0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+		0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+	};
+	const uint8_t *p = buf;
+
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		crc = (crc >> 4) ^ tbl[crc & 0x0F];
+		crc = (crc >> 4) ^ tbl[crc & 0x0F];
+	}
+	return ~crc;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static bool verify(void)
+{
+	static uint8_t buf[4096 + 8];
+	unsigned bad = 0;
+
+	if (crc32_update(0, "123456789", 9) != 0xCBF43926u ||
+	    crc32_sw(0, "123456789", 9) != 0xCBF43926u) {
+		printf("verify:   check value wrong\n");
+		return false;
+	}
+	srand(1);
+	for (size_t i = 0; i < sizeof(buf); ++i)
+		buf[i] = (uint8_t)rand();
+	for (int n = 0; n < 20000; ++n) {
+		size_t off = (size_t)rand() % 8;
+		size_t len = (size_t)rand() % 4096;
+		size_t cut = len ? (size_t)rand() % len : 0;
+		uint32_t want = crc32_bitwise(0, &buf[off], len);
+
+		if (crc32_update(0, &buf[off], len) != want ||
+		    crc32_sw(0, &buf[off], len) != want ||
+		    crc32_update(crc32_update(0, &buf[off], cut),
+				 &buf[off + cut], len - cut) != want)
+			++bad;
+	}
+	printf("verify:   20000 random buffers, %u mismatches (%s path%s)\n", bad,
+	       CRC32_BACKEND == CRC32_BACKEND_DSU ? "DSU" : "software",
+	       CRC32_BACKEND == CRC32_BACKEND_DSU && dsu_words == 0 ? " NOT taken" : "");
+	if (CRC32_BACKEND == CRC32_BACKEND_DSU && dsu_words == 0)
+		return false;
+	return bad == 0;
+}
+
+typedef uint32_t (*engine_fn)(uint32_t, const void *, size_t);
+
+static double time_engine(engine_fn fn, const uint8_t *buf, size_t len)
+{
+	volatile uint32_t sink;
+	unsigned reps = (unsigned)(64u * 1024u * 1024u / (len + 16));
+	uint64_t t0 = now_ns();
+
+	for (unsigned r = 0; r < reps; ++r)
+		sink = fn(0, buf, len);
+	(void)sink;
+	return (double)(now_ns() - t0) / reps;
+}
+
+static void bench_host(void)
+{
+	static const size_t lens[] = { 8, 32, 128, 504, 1016, 4096 };
+	static uint8_t buf[4096 + 2];
+
+	for (size_t i = 0; i < sizeof(buf); ++i)
+		buf[i] = (uint8_t)(i * 31u);
+	printf("\n  length   bit-wise ns    nibble ns     table ns   table MB/s\n");
+	for (size_t i = 0; i < sizeof(lens) / sizeof(lens[0]); ++i) {
+		double b = time_engine(crc32_bitwise, &buf[2], lens[i]);
+		double n = time_engine(crc32_nibble, &buf[2], lens[i]);
+		double t = time_engine(crc32_sw, &buf[2], lens[i]);
+
+		printf("  %6zu %13.1f %12.1f %12.1f %12.1f\n",
+		       lens[i], b, n, t, lens[i] * 1e3 / t);
+	}
+}
+
+static void bench_firmware(void)
+{
+	crc32_bench_t res[CRC32_BENCH_NR_LENS];
+	bool agree = crc32_bench(res);
+
+	printf("\ncrc32_bench() on the host%s:\n",
+	       CRC32_BACKEND == CRC32_BACKEND_DSU ? " (dsu = the bit-wise stand-in)" : "");
+	for (unsigned i = 0; i < CRC32_BENCH_NR_LENS; ++i)
+		printf("  crc32 %4u B: sw %7lu ns, dsu %7lu ns\n", (unsigned)res[i].len,
+		       (unsigned long)res[i].sw_ns, (unsigned long)res[i].dsu_ns);
+	printf("  engines %s\n", agree ? "agree" : "DISAGREE");
+}
+
+static speed_t baud_to_speed(long baud)
+{
+	switch (baud) {
+	case 9600:   return B9600;
+	case 19200:  return B19200;
+	case 38400:  return B38400;
+	case 57600:  return B57600;
+	case 115200: return B115200;
+	default:     return B0;
+	}
+}
+
+/// Read the start-up benchmark from the board and summarise it
+static int read_board(const char *dev, long baud)
+{
+	struct termios tio;
+	FILE *f;
+	char line[128];
+	int fd = open(dev, O_RDWR | O_NOCTTY);
+	unsigned nr = 0;
+
+	if (fd < 0) {
+		perror(dev);
+		return 1;
+	}
+	if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		if (baud_to_speed(baud) != B0) {
+			cfsetispeed(&tio, baud_to_speed(baud));
+			cfsetospeed(&tio, baud_to_speed(baud));
+		}
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	f = fdopen(fd, "r");
+	printf("waiting for the board's start-up benchmark (reset it now)...\n");
+	printf("\n  length     sw ns    dsu ns   speed-up   dsu MB/s\n");
+	while (fgets(line, sizeof(line), f) != NULL) {
+		unsigned len;
+		unsigned long sw, dsu;
+		char word[16];
+
+		if (sscanf(line, "crc32 %u B: sw %lu ns, dsu %lu ns", &len, &sw, &dsu) == 3) {
+			printf("  %6u %9lu %9lu %9.1fx %10.2f\n", len, sw, dsu,
+			       dsu ? (double)sw / dsu : 0.0,
+			       dsu ? len * 1e3 / dsu : 0.0);
+			++nr;
+		} else if (sscanf(line, "crc32: engines %15s", word) == 1) {
+			printf("  engines %s\n", word);
+			break;
+		}
+	}
+	fclose(f);
+	return nr == CRC32_BENCH_NR_LENS ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+	const char *dev = NULL;
+	long baud = 38400;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:b:h")) != -1) {
+		switch (c) {
+		case 'd': dev = optarg; break;
+		case 'b': baud = strtol(optarg, NULL, 0); break;
+		default:
+			fprintf(stderr, "usage: %s [-d TTY [-b BAUD]]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (dev != NULL)
+		return read_board(dev, baud);
+
+	if (!verify())
+		return 2;
+	bench_host();
+	bench_firmware();
+	return 0;
+}
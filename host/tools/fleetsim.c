@@ -0,0 +1,904 @@
+/**
+ * @file host/tools/fleetsim.c
+ * @brief Runs a fleet of simulated boards, each running the real firmware.
+ *
+ * Every board runs the application as built for the target (src/main.c, the
+ * terminal UI, uplink, log store, parsers) on the simulated platform layer of
+ * host/sim/sim_platform.h, with its sensors fed from a synthetic generator or
+ * from a replayed session, and its terminal on a pty of its own. Anything
+ * that reads a board's port, such as ingestd or livesrv, sees what it would
+ * see on the board's USB port.
+ *
+ * The application keeps its state in file-scope statics, so one copy of it
+ * can only run one board. The firmware is therefore built once as a shared
+ * object, and every board loads a private copy of it (through a memfd, so
+ * the dynamic loader does not fold the copies into one), each with its own
+ * statics; the copies resolve the platform functions against this program.
+ * Each board's main() runs as a coroutine on a stack of its own. Boards are
+ * spread over a pool of threads (-j), and a thread runs each of its boards
+ * for one loop iteration every -L microseconds; a board waiting on a busy
+ * terminal also gives up the thread.
+ *
+ * Sensors, at -b baud on each line:
+ * - Synthetic (default): host/lib/sgen.h, with RMC, GGA and GLL at -r Hz
+ *   along a random walk around the campus, and a PMS5003 frame once a second
+ *   following the -p profile; every board has its own seed and start.
+ * - Replayed: -G takes the .nmea file and -P the .pms.csv file that capdemux
+ *   writes; the sentences are sent in one-second bursts, each starting at an
+ *   RMC sentence, and the frames one a second. Every board starts at its own
+ *   place in the session, and the session loops.
+ *
+ * With -l the pty of every board is listed as NAME=DEVICE, ready for
+ * ingestd. Every -v seconds the loop rate and line counters are printed.
+ *
+ * At the end, the charge every board drew is worked out with the energy
+ * model of host/sim/sim_power.h and printed in mAh per hour, per consumer,
+ * both as built and as if the CPU slept whenever it had no work. -E sets an
+ * entry of the current table (-E help lists them), and -D powers a sensor
+ * on a duty cycle, e.g. -D pm=30/270 for 30 s on in every 5 minutes.
+ * Time on a board is the host's, so the loop runs every -L microseconds
+ * rather than as fast as the target would spin; that sets the number of
+ * iterations the model charges, and a firmware that slept would wake about
+ * as often.
+ *
+ * With -B the tool reads every board's port itself for -t seconds, decodes
+ * it with host/lib/sdec.h, and checks that every board echoed PMS frames
+ * and NMEA sentences and that no echoed sentence was damaged. The firmware
+ * skips echoes while its terminal is busy, so not every report is echoed.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -fPIC -shared -Wl,-Bsymbolic -Iinc -DLOGSTORE_BACKEND=0 \
+ *      -o fleetsim_fw.so src/main.c src/terminal_ui.c src/uplink.c \
+ *      src/logstore.c src/bulkdl.c src/crc32.c src/rxlat.c \
+ *      src/scratch.c src/ram_budget.c src/metrics.c \
+ *      src/parsers/nmea_parse.c src/parsers/pms_parser.c
+ *   cc -O2 -Wall -pthread -rdynamic -Iinc -Ihost/sim -Ihost/lib \
+ *      -o fleetsim host/tools/fleetsim.c host/sim/sim_platform.c \
+ *      host/sim/sim_power.c host/lib/sdec.c host/lib/sgen.c src/parsers/nmea_parse.c \
+ *      src/parsers/pms_parser.c -ldl -lm
+ */
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <ucontext.h>
+#include <unistd.h>
+
+#include "sdec.h"
+#include "sgen.h"
+#include "sim_platform.h"
+#include "sim_power.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define FLEETSIM_STACK_SZ	(128 * 1024)	// Coroutine stack of a board
+#define FLEETSIM_REPORT_US	1000000		// PM report period; replayed GPS bursts
+#define FLEETSIM_GPS_JITTER_US	20000		// Receivers drift against the board's clock
+#define FLEETSIM_PM_JITTER_US	100000		// The PMS5003 is not clocked at all
+#define FLEETSIM_READ_SZ	4096		// -B: bytes per read of a port
+
+static const char *opt_fw = "./fleetsim_fw.so";
+static const char *opt_list;
+static const char *opt_gps, *opt_pm;
+static long opt_baud = 38400;
+static unsigned opt_threads;
+static unsigned opt_loop_us = 2000;
+static unsigned opt_report;		// Seconds between stats lines; 0: none
+static double opt_secs;			// 0: until SIGINT/SIGTERM
+static sim_power_table_t power;
+static uint32_t opt_duty[2][2];		// GPS and PM: seconds on, off
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	stop_requested = 1;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/// Let this process have as many descriptors as the hard limit allows
+static void raise_fd_limit(void)
+{
+	struct rlimit rl;
+
+	if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+	}
+}
+
+/// Deterministic PRNG (xorshift32); one state per board
+static uint32_t rng_next(uint32_t *state)
+{
+	uint32_t x = *state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	return x;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Boards
+
+/// PMS5003 data words (the last is reserved)
+#define PMS_NR_WORDS	13
+
+typedef struct worker_type worker_t;
+
+typedef struct board_type {
+	sim_board_t sim;
+	char     name[16];
+	char     pts[32];
+	int      master;
+	worker_t *worker;
+
+	// Firmware
+	int    (*fw_main)(void);
+	ucontext_t ctx;
+	bool     exited;
+	uint64_t next_ns;		// Next loop iteration
+	uint64_t late;			// Iterations started a whole period late
+
+	// Sensors
+	uint32_t rng;
+	sgen_t   gen;
+	size_t   gps_at, pm_at;		// Replay cursors
+	uint64_t gps_sentences;		// Sentences fed
+
+	// -B
+	sdec_t   dec;
+	uint64_t rows;
+} board_t;
+
+struct worker_type {
+	pthread_t  thread;
+	ucontext_t ctx;
+	board_t  **boards;
+	unsigned   nr_boards;
+	struct rusage ru;
+};
+
+static board_t *boards;
+static unsigned nr_boards;
+static worker_t *workers;
+static volatile bool workers_stop;
+
+// Hand the thread back to the worker; the board resumes from here
+static void board_yield(sim_board_t *b)
+{
+	board_t *bd = b->user;
+
+	swapcontext(&bd->ctx, &bd->worker->ctx);
+}
+
+static __thread board_t *entering;
+
+static void board_entry(void)
+{
+	board_t *bd = entering;
+
+	bd->fw_main();
+	bd->exited = true;	// uc_link returns to the worker
+}
+
+static void *worker_main(void *arg)
+{
+	worker_t *w = arg;
+	uint64_t loop_ns = (uint64_t)opt_loop_us * 1000u;
+
+	while (!workers_stop) {
+		uint64_t t = now_ns(), next = t + loop_ns;
+		struct timespec ts;
+
+		for (unsigned i = 0; i < w->nr_boards; ++i) {
+			board_t *bd = w->boards[i];
+
+			if (bd->exited)
+				continue;
+			if (bd->next_ns <= t) {
+				sim_board = &bd->sim;
+				entering = bd;
+				swapcontext(&w->ctx, &bd->ctx);
+				bd->next_ns += loop_ns;
+				t = now_ns();
+				if (bd->next_ns + loop_ns <= t) {
+					++bd->late;
+					bd->next_ns = t + loop_ns;
+				}
+			}
+			if (bd->next_ns < next)
+				next = bd->next_ns;
+		}
+		ts.tv_sec = (time_t)(next / 1000000000u);
+		ts.tv_nsec = (long)(next % 1000000000u);
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+	}
+	getrusage(RUSAGE_THREAD, &w->ru);
+	return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Synthetic sensors (host/lib/sgen.h)
+
+static sgen_cfg_t gen_cfg;
+
+static size_t gps_synth(void *user, uint64_t seq, uint8_t *buf, size_t size)
+{
+	board_t *bd = user;
+	size_t n = sgen_gps_epoch(&bd->gen, seq, (char *)buf, size);
+
+	for (size_t k = 0; k < n; ++k)
+		bd->gps_sentences += buf[k] == '\n';
+	return n;
+}
+
+static size_t pm_synth(void *user, uint64_t seq, uint8_t *buf, size_t size)
+{
+	board_t *bd = user;
+
+	(void)size;
+	return sgen_pm_frame(&bd->gen, seq, buf);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Replayed sensors
+
+// A PMS5003 frame holding @p words
+static size_t pms_frame(uint8_t *out, const uint16_t *words)
+{
+	uint16_t sum = 0;
+
+	out[0] = 0x42;
+	out[1] = 0x4D;
+	out[2] = 0x00;
+	out[3] = 2 * PMS_NR_WORDS + 2;
+	for (int k = 0; k < PMS_NR_WORDS; ++k) {
+		out[4 + 2 * k] = (uint8_t)(words[k] >> 8);
+		out[5 + 2 * k] = (uint8_t)words[k];
+	}
+	for (int k = 0; k < 30; ++k)
+		sum += out[k];
+	out[30] = (uint8_t)(sum >> 8);
+	out[31] = (uint8_t)sum;
+	return 32;
+}
+
+static char  **rp_gps;			// One burst per entry
+static unsigned *rp_gps_nr;		// Sentences in each burst
+static size_t  nr_rp_gps;
+static uint16_t (*rp_pm)[PMS_NR_WORDS];
+static size_t  nr_rp_pm;
+
+// Load capdemux's PREFIX.nmea: "offset,sentence" lines
+static int replay_load_gps(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[512], *cur = NULL;
+	size_t cur_len = 0;
+	unsigned cur_nr = 0;
+
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		char *s = strchr(line, ',');
+		size_t n;
+
+		if (s == NULL || *++s != '$')
+			continue;	// Header
+		n = strcspn(s, "\r\n");
+		// A burst starts at every RMC sentence
+		if (cur != NULL && (strncmp(s + 3, "RMC", 3) == 0 ||
+				    cur_len + n + 2 >= SIM_REPORT_MAX)) {
+			rp_gps = realloc(rp_gps, (nr_rp_gps + 1) * sizeof(*rp_gps));
+			rp_gps_nr = realloc(rp_gps_nr, (nr_rp_gps + 1) * sizeof(*rp_gps_nr));
+			rp_gps[nr_rp_gps] = cur;
+			rp_gps_nr[nr_rp_gps++] = cur_nr;
+			cur = NULL;
+		}
+		if (cur == NULL) {
+			cur = calloc(1, SIM_REPORT_MAX);
+			cur_len = 0;
+			cur_nr = 0;
+		}
+		memcpy(cur + cur_len, s, n);
+		memcpy(cur + cur_len + n, "\r\n", 3);
+		cur_len += n + 2;
+		++cur_nr;
+	}
+	if (cur != NULL) {
+		rp_gps = realloc(rp_gps, (nr_rp_gps + 1) * sizeof(*rp_gps));
+		rp_gps_nr = realloc(rp_gps_nr, (nr_rp_gps + 1) * sizeof(*rp_gps_nr));
+		rp_gps[nr_rp_gps] = cur;
+		rp_gps_nr[nr_rp_gps++] = cur_nr;
+	}
+	fclose(f);
+	if (nr_rp_gps == 0) {
+		fprintf(stderr, "%s: no sentences\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+// Load capdemux's PREFIX.pms.csv: "offset,<12 channels>" lines
+static int replay_load_pm(const char *path)
+{
+	FILE *f = fopen(path, "r");
+	char line[512];
+
+	if (f == NULL) {
+		perror(path);
+		return -1;
+	}
+	while (fgets(line, sizeof(line), f) != NULL) {
+		uint16_t w[PMS_NR_WORDS] = { 0 };
+		char *p = line, *end;
+		int k;
+
+		strtoull(p, &end, 10);
+		if (end == p || *end != ',')
+			continue;	// Header
+		for (k = 0, p = end; k < PMS_NR_WORDS - 1 && *p == ','; ++k) {
+			w[k] = (uint16_t)strtoul(p + 1, &end, 10);
+			p = end;
+		}
+		if (k != PMS_NR_WORDS - 1)
+			continue;
+		rp_pm = realloc(rp_pm, (nr_rp_pm + 1) * sizeof(*rp_pm));
+		memcpy(rp_pm[nr_rp_pm++], w, sizeof(w));
+	}
+	fclose(f);
+	if (nr_rp_pm == 0) {
+		fprintf(stderr, "%s: no frames\n", path);
+		return -1;
+	}
+	return 0;
+}
+
+static size_t gps_replay(void *user, uint64_t seq, uint8_t *buf, size_t size)
+{
+	board_t *bd = user;
+	size_t i = (bd->gps_at + seq) % nr_rp_gps;
+	size_t n = strlen(rp_gps[i]);
+
+	(void)size;
+	memcpy(buf, rp_gps[i], n);
+	bd->gps_sentences += rp_gps_nr[i];
+	return n;
+}
+
+static size_t pm_replay(void *user, uint64_t seq, uint8_t *buf, size_t size)
+{
+	board_t *bd = user;
+
+	(void)size;
+	return pms_frame(buf, rp_pm[(bd->pm_at + seq) % nr_rp_pm]);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Set-up
+
+// A private copy of the firmware, and its entry point
+static int (*fw_load(const void *image, size_t len))(void)
+{
+	char path[64];
+	void *h, *sym;
+	int fd = memfd_create("fleetsim_fw", MFD_CLOEXEC);
+
+	if (fd < 0) {
+		perror("memfd_create");
+		return NULL;
+	}
+	if (write(fd, image, len) != (ssize_t)len) {
+		perror("memfd write");
+		close(fd);
+		return NULL;
+	}
+	/*
+	 * The descriptor stays open: the loader recognises objects by name, and
+	 * a reused descriptor number would name an object already loaded.
+	 */
+	snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+	if ((h = dlopen(path, RTLD_NOW | RTLD_LOCAL)) == NULL) {
+		fprintf(stderr, "%s\n", dlerror());
+		close(fd);
+		return NULL;
+	}
+	if ((sym = dlsym(h, "main")) == NULL) {
+		fprintf(stderr, "%s: no main()\n", opt_fw);
+		return NULL;
+	}
+	return (int (*)(void))sym;
+}
+
+static int board_setup(board_t *bd, unsigned i, const void *image, size_t len)
+{
+	void *stack;
+	int m, fd;
+
+	snprintf(bd->name, sizeof(bd->name), "sim%03u", i);
+	m = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+	if (m < 0 || grantpt(m) != 0 || unlockpt(m) != 0) {
+		perror("posix_openpt");
+		return -1;
+	}
+	snprintf(bd->pts, sizeof(bd->pts), "%s", ptsname(m));
+	// Raw from the start, or the line discipline would echo output back
+	if ((fd = open(bd->pts, O_RDWR | O_NOCTTY)) >= 0) {
+		struct termios tio;
+
+		if (tcgetattr(fd, &tio) == 0) {
+			cfmakeraw(&tio);
+			tcsetattr(fd, TCSANOW, &tio);
+		}
+		close(fd);
+	}
+	bd->master = m;
+
+	sim_board_init(&bd->sim, m, (uint32_t)opt_baud);
+	bd->sim.yield = board_yield;
+	bd->sim.user  = bd;
+	bd->rng = 0x2545F491u ^ (i * 0x9E3779B9u);
+	if (bd->rng == 0)
+		bd->rng = 1;
+	if (opt_gps == NULL || opt_pm == NULL) {
+		sgen_cfg_t c = gen_cfg;
+
+		c.seed = rng_next(&bd->rng);
+		c.lat0 += 0.002 * ((int)(rng_next(&bd->rng) % 101) - 50);
+		c.lon0 += 0.002 * ((int)(rng_next(&bd->rng) % 101) - 50);
+		sgen_init(&bd->gen, &c);
+	}
+
+	bd->sim.gps.user = bd;
+	bd->sim.gps.period_us = opt_gps != NULL ? FLEETSIM_REPORT_US :
+				(uint32_t)(1e6 / gen_cfg.gps_hz);
+	bd->sim.gps.phase_us = 100000 + rng_next(&bd->rng) % bd->sim.gps.period_us;
+	bd->sim.gps.jitter_us = FLEETSIM_GPS_JITTER_US;
+	bd->sim.gps.seed = rng_next(&bd->rng);
+	bd->sim.pm.user = bd;
+	bd->sim.pm.period_us = FLEETSIM_REPORT_US;
+	bd->sim.pm.phase_us = 100000 + rng_next(&bd->rng) % FLEETSIM_REPORT_US;
+	bd->sim.pm.jitter_us = FLEETSIM_PM_JITTER_US;
+	bd->sim.pm.seed = rng_next(&bd->rng);
+	bd->sim.gps.on_s = opt_duty[0][0];
+	bd->sim.gps.off_s = opt_duty[0][1];
+	bd->sim.pm.on_s = opt_duty[1][0];
+	bd->sim.pm.off_s = opt_duty[1][1];
+	if (opt_gps != NULL) {
+		bd->sim.gps.report = gps_replay;
+		bd->gps_at = ((size_t)i * 7919) % nr_rp_gps;
+	} else {
+		bd->sim.gps.report = gps_synth;
+	}
+	if (opt_pm != NULL) {
+		bd->sim.pm.report = pm_replay;
+		bd->pm_at = ((size_t)i * 7919) % nr_rp_pm;
+	} else {
+		bd->sim.pm.report = pm_synth;
+	}
+
+	if ((bd->fw_main = fw_load(image, len)) == NULL)
+		return -1;
+	stack = mmap(NULL, FLEETSIM_STACK_SZ, PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_STACK, -1, 0);
+	if (stack == MAP_FAILED) {
+		perror("mmap");
+		return -1;
+	}
+	mprotect(stack, 4096, PROT_NONE);	// Guard page
+	getcontext(&bd->ctx);
+	bd->ctx.uc_stack.ss_sp = stack;
+	bd->ctx.uc_stack.ss_size = FLEETSIM_STACK_SZ;
+	bd->ctx.uc_link = &bd->worker->ctx;
+	makecontext(&bd->ctx, board_entry, 0);
+	sdec_init(&bd->dec);
+	return 0;
+}
+
+static void *read_file(const char *path, size_t *len)
+{
+	struct stat st;
+	void *buf;
+	int fd = open(path, O_RDONLY);
+
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		perror(path);
+		return NULL;
+	}
+	buf = malloc((size_t)st.st_size);
+	if (buf == NULL || read(fd, buf, (size_t)st.st_size) != st.st_size) {
+		perror(path);
+		close(fd);
+		return NULL;
+	}
+	close(fd);
+	*len = (size_t)st.st_size;
+	return buf;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Running
+
+/// Fleet-wide totals
+typedef struct totals_type {
+	uint64_t loops, late;
+	uint64_t gps_sent, gps_lost, pm_sent, pm_lost;
+	uint64_t cdc_bytes, cdc_dropped;
+} totals_t;
+
+// Counters are read while the workers update them; a stats line may be off by one
+static void totals(totals_t *t)
+{
+	memset(t, 0, sizeof(*t));
+	for (unsigned i = 0; i < nr_boards; ++i) {
+		const sim_board_t *b = &boards[i].sim;
+
+		t->loops += b->loops;
+		t->late += boards[i].late;
+		t->gps_sent += b->gps.reports;
+		t->gps_lost += b->gps.lost;
+		t->pm_sent += b->pm.reports;
+		t->pm_lost += b->pm.lost;
+		t->cdc_bytes += b->cdc_tx_bytes;
+		t->cdc_dropped += b->cdc_tx_dropped;
+	}
+}
+
+static void print_stats(const totals_t *prev, unsigned secs)
+{
+	totals_t t;
+
+	totals(&t);
+	fprintf(stderr,
+		"fleetsim: %u boards, %.0f loops/s (%.0f wanted), %llu late, "
+		"%llu GPS + %llu PM reports, %llu bytes lost on sensor lines, "
+		"%.0f terminal B/s, %llu dropped\n",
+		nr_boards, (double)(t.loops - prev->loops) / secs,
+		nr_boards * 1e6 / opt_loop_us,
+		(unsigned long long)(t.late - prev->late),
+		(unsigned long long)(t.gps_sent - prev->gps_sent),
+		(unsigned long long)(t.pm_sent - prev->pm_sent),
+		(unsigned long long)(t.gps_lost + t.pm_lost - prev->gps_lost - prev->pm_lost),
+		(double)(t.cdc_bytes - prev->cdc_bytes) / secs,
+		(unsigned long long)(t.cdc_dropped - prev->cdc_dropped));
+}
+
+// Mean charge per board, with the spread of the total over the boards
+static void print_energy(void)
+{
+	sim_power_t p, sum = { 0 };
+	double lo = 0, hi = 0;
+
+	for (unsigned i = 0; i < nr_boards; ++i) {
+		double rate;
+
+		sim_power_account(&power, &boards[i].sim, &p);
+		if (p.hours <= 0)
+			continue;
+		rate = p.total_mah / p.hours;
+		if (i == 0 || rate < lo)
+			lo = rate;
+		if (i == 0 || rate > hi)
+			hi = rate;
+		sum.hours += p.hours;
+		for (int k = 0; k < SIM_PART_NR; ++k)
+			sum.mah[k] += p.mah[k];
+		sum.total_mah += p.total_mah;
+		sum.cpu_sleep_mah += p.cpu_sleep_mah;
+		sum.total_sleep_mah += p.total_sleep_mah;
+		sum.cpu_busy += p.cpu_busy * p.hours;
+	}
+	if (sum.hours <= 0)
+		return;
+	printf("  energy:    %.2f mAh/h per board (%.2f to %.2f):",
+	       sum.total_mah / sum.hours, lo, hi);
+	for (int k = 0; k < SIM_PART_NR; ++k)
+		printf(" %s %.2f", sim_power_part_name((sim_power_part_t)k),
+		       sum.mah[k] / sum.hours);
+	printf("\n             CPU busy %.2f%%; sleeping when idle: CPU %.3f, "
+	       "total %.2f mAh/h\n", 100 * sum.cpu_busy / sum.hours,
+	       sum.cpu_sleep_mah / sum.hours, sum.total_sleep_mah / sum.hours);
+}
+
+static void on_row(void *user, const sarc_row_t *row)
+{
+	(void)row;
+	++((board_t *)user)->rows;
+}
+
+// -B: read every port until the time is up
+static void read_ports(uint64_t t_end)
+{
+	struct epoll_event evs[64];
+	uint8_t buf[FLEETSIM_READ_SZ];
+	int epfd = epoll_create1(EPOLL_CLOEXEC);
+
+	for (unsigned i = 0; i < nr_boards; ++i) {
+		board_t *bd = &boards[i];
+		struct epoll_event ev = { .events = EPOLLIN };
+		int fd = open(bd->pts, O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+		if (fd < 0) {
+			perror(bd->pts);
+			continue;
+		}
+		ev.data.u64 = ((uint64_t)i << 32) | (uint32_t)fd;	// Board and descriptor
+		epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+	}
+	while (!stop_requested && now_ns() < t_end) {
+		int n = epoll_wait(epfd, evs, 64, 100);
+
+		for (int k = 0; k < n; ++k) {
+			board_t *bd = &boards[evs[k].data.u64 >> 32];
+			int fd = (int)(uint32_t)evs[k].data.u64;
+			ssize_t r = read(fd, buf, sizeof(buf));
+
+			if (r > 0)
+				sdec_feed(&bd->dec, buf, (size_t)r, 0, on_row, bd);
+		}
+	}
+	close(epfd);
+}
+
+static int run(bool bench)
+{
+	uint64_t t0 = now_ns(), t_end = opt_secs > 0 ? t0 + (uint64_t)(opt_secs * 1e9) : UINT64_MAX;
+	uint64_t last = t0;
+	totals_t prev = { 0 }, t;
+	double cpu = 0;
+
+	for (unsigned i = 0; i < nr_boards; ++i)
+		boards[i].next_ns = t0 + (uint64_t)opt_loop_us * 1000u * i / nr_boards;
+	for (unsigned w = 0; w < opt_threads; ++w)
+		pthread_create(&workers[w].thread, NULL, worker_main, &workers[w]);
+
+	if (bench) {
+		read_ports(t_end);
+	} else {
+		while (!stop_requested && now_ns() < t_end) {
+			uint64_t t = now_ns();
+
+			usleep(100000);
+			if (opt_report && t - last >= opt_report * 1000000000ull) {
+				print_stats(&prev, opt_report);
+				totals(&prev);
+				last = t;
+			}
+		}
+	}
+	workers_stop = true;
+	for (unsigned w = 0; w < opt_threads; ++w) {
+		pthread_join(workers[w].thread, NULL);
+		cpu += workers[w].ru.ru_utime.tv_sec + workers[w].ru.ru_utime.tv_usec / 1e6 +
+		       workers[w].ru.ru_stime.tv_sec + workers[w].ru.ru_stime.tv_usec / 1e6;
+	}
+
+	totals(&t);
+	printf("fleetsim: %u boards for %.1f s on %u threads\n", nr_boards,
+	       (now_ns() - t0) / 1e9, opt_threads);
+	printf("  loops:     %llu (%.0f/s per board, %.0f wanted), %llu late\n",
+	       (unsigned long long)t.loops, t.loops / ((now_ns() - t0) / 1e9) / nr_boards,
+	       1e6 / opt_loop_us, (unsigned long long)t.late);
+	printf("  sensors:   %llu GPS and %llu PM reports, %llu + %llu bytes lost\n",
+	       (unsigned long long)t.gps_sent, (unsigned long long)t.pm_sent,
+	       (unsigned long long)t.gps_lost, (unsigned long long)t.pm_lost);
+	printf("  terminal:  %llu bytes, %llu dropped by full ptys\n",
+	       (unsigned long long)t.cdc_bytes, (unsigned long long)t.cdc_dropped);
+	printf("  CPU:       workers %.2f s (%.2f us per loop iteration)\n",
+	       cpu, t.loops ? cpu * 1e6 / t.loops : 0.0);
+	print_energy();
+	return 0;
+}
+
+// -B: compare what every board echoed with what it was fed
+static int check(void)
+{
+	uint64_t fed_pm = 0, rows = 0, fed_nmea = 0, nmea_ok = 0, nmea_bad = 0, pms_bad = 0;
+	unsigned silent = 0, shown = 0;
+
+	for (unsigned i = 0; i < nr_boards; ++i) {
+		board_t *bd = &boards[i];
+
+		fed_pm += bd->sim.pm.reports;
+		fed_nmea += bd->gps_sentences;
+		rows += bd->rows;
+		nmea_ok += bd->dec.nmea_ok;
+		nmea_bad += bd->dec.nmea_bad;
+		pms_bad += bd->dec.pms_bad;
+		if (bd->rows == 0 || bd->dec.nmea_ok == 0)
+			++silent;
+		if ((bd->rows == 0 || bd->dec.nmea_ok == 0 || bd->dec.nmea_bad) && shown++ < 5)
+			fprintf(stderr, "  %s (%s): %llu frames and %llu sentences echoed, "
+				"%llu sentences damaged\n",
+				bd->name, bd->pts, (unsigned long long)bd->rows,
+				(unsigned long long)bd->dec.nmea_ok,
+				(unsigned long long)bd->dec.nmea_bad);
+	}
+	/*
+	 * The firmware drops an echo whenever its terminal is busy, so fewer
+	 * are echoed than fed. In a build with UPLINK_ENABLED, a "42 4D" inside
+	 * a binary uplink frame starts a PMS frame that fails its checksum; only
+	 * damaged sentences count.
+	 */
+	printf("  echoed:    %llu of %llu PMS frames, %llu of %llu sentences; "
+	       "%llu sentences damaged, %llu false PMS starts; %u boards silent\n",
+	       (unsigned long long)rows, (unsigned long long)fed_pm,
+	       (unsigned long long)nmea_ok, (unsigned long long)fed_nmea,
+	       (unsigned long long)nmea_bad, (unsigned long long)pms_bad, silent);
+	return (silent || nmea_bad) ? 1 : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-n BOARDS] [-j THREADS] [-f FIRMWARE.so] [-L LOOP_US] [-b BAUD]\n"
+		"       [-r GPS_HZ] [-p const|rush|ramp|traffic] [-G SESSION.nmea] [-P SESSION.pms.csv]\n"
+		"       [-l LISTFILE] [-v SECONDS] [-t SECONDS] [-E NAME=VALUE|help]...\n"
+		"       [-D gps|pm=ON_S/OFF_S]...\n"
+		"       %s -B [-n BOARDS] [-t SECONDS] ...\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned n = 16;
+	bool bench = false;
+	void *image;
+	size_t image_len;
+	int opt, ret;
+
+	opt_threads = (unsigned)sysconf(_SC_NPROCESSORS_ONLN);
+	sgen_cfg_default(&gen_cfg);
+	sim_power_table_default(&power);
+	while ((opt = getopt(argc, argv, "n:j:f:L:b:r:p:G:P:l:v:t:E:D:Bh")) != -1) {
+		switch (opt) {
+		case 'n': n = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'j': opt_threads = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'f': opt_fw = optarg; break;
+		case 'L': opt_loop_us = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'b': opt_baud = strtol(optarg, NULL, 0); break;
+		case 'r': gen_cfg.gps_hz = strtod(optarg, NULL); break;
+		case 'p':
+			if ((ret = sgen_profile_parse(optarg)) < 0) {
+				fprintf(stderr, "%s: unknown profile\n", optarg);
+				return 2;
+			}
+			gen_cfg.profile = (sgen_profile_t)ret;
+			break;
+		case 'G': opt_gps = optarg; break;
+		case 'P': opt_pm = optarg; break;
+		case 'l': opt_list = optarg; break;
+		case 'v': opt_report = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 't': opt_secs = strtod(optarg, NULL); break;
+		case 'E':
+			if (strcmp(optarg, "help") == 0) {
+				sim_power_table_print(&power, stdout);
+				return 0;
+			}
+			if (sim_power_table_set(&power, optarg) != 0) {
+				fprintf(stderr, "%s: unknown entry or bad value (-E help lists them)\n",
+					optarg);
+				return 2;
+			}
+			break;
+		case 'D': {
+			unsigned on, off, k;
+			char which[4];
+
+			if (sscanf(optarg, "%3[a-z]=%u/%u", which, &on, &off) != 3 ||
+			    (k = strcmp(which, "gps") == 0 ? 0 :
+				 strcmp(which, "pm") == 0 ? 1 : 2) > 1 ||
+			    on == 0) {
+				fprintf(stderr, "%s: expected gps=ON_S/OFF_S or pm=ON_S/OFF_S\n",
+					optarg);
+				return 2;
+			}
+			opt_duty[k][0] = on;
+			opt_duty[k][1] = off;
+			break;
+		}
+		case 'B': bench = true; break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (optind != argc || n == 0 || opt_threads == 0 || opt_loop_us == 0 ||
+	    opt_baud < 1200 || !(gen_cfg.gps_hz >= 0.1 && gen_cfg.gps_hz <= 20)) {
+		usage(argv[0]);
+		return 2;
+	}
+	if (opt_threads > n)
+		opt_threads = n;
+	if (bench && opt_secs <= 0)
+		opt_secs = 10;
+	if (opt_secs > 0)
+		gen_cfg.duration_s = opt_secs;
+	if ((opt_gps != NULL && replay_load_gps(opt_gps) != 0) ||
+	    (opt_pm != NULL && replay_load_pm(opt_pm) != 0))
+		return 1;
+	if ((image = read_file(opt_fw, &image_len)) == NULL)
+		return 1;
+
+	raise_fd_limit();
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	signal(SIGPIPE, SIG_IGN);
+	boards = calloc(n, sizeof(*boards));
+	workers = calloc(opt_threads, sizeof(*workers));
+	if (boards == NULL || workers == NULL) {
+		perror("calloc");
+		return 1;
+	}
+	for (unsigned w = 0; w < opt_threads; ++w)
+		workers[w].boards = calloc((n + opt_threads - 1) / opt_threads, sizeof(board_t *));
+	for (unsigned i = 0; i < n; ++i) {
+		worker_t *w = &workers[i % opt_threads];
+
+		boards[i].worker = w;
+		w->boards[w->nr_boards++] = &boards[i];
+		if (board_setup(&boards[i], i, image, image_len) != 0)
+			return 1;
+		nr_boards = i + 1;
+	}
+	free(image);
+
+	if (opt_list != NULL) {
+		FILE *f = fopen(opt_list, "w");
+
+		if (f == NULL) {
+			perror(opt_list);
+			return 1;
+		}
+		for (unsigned i = 0; i < nr_boards; ++i)
+			fprintf(f, "%s=%s\n", boards[i].name, boards[i].pts);
+		fclose(f);
+	}
+
+	if (bench)
+		printf("fleetsim bench: %u boards, loop every %u us, %s sensors, %.0f s\n",
+		       nr_boards, opt_loop_us, (opt_gps || opt_pm) ? "replayed" : "synthetic",
+		       opt_secs);
+	ret = run(bench);
+	if (bench && ret == 0)
+		ret = check();
+	return ret;
+}
@@ -0,0 +1,635 @@
+/**
+ * @file host/tools/heattile.c
+ * @brief Aggregates archived PM readings into web-mercator tile pyramids.
+ *
+ * Every sample with a position (host/lib/sarc.h) is binned into its zoom-18
+ * tile; zooms 17 down to 10 are rolled up from those. Each tile gets the
+ * count, mean and max of one PM channel, written as OUT/Z/X/Y.json, the
+ * usual slippy-map layout.
+ *
+ * The archive blocks are shared out to a thread pool. Each thread keeps its
+ * own table of partial aggregates, so threads never contend; the tables are
+ * merged when all blocks are done.
+ *
+ * Runs are incremental. OUT/.heattile.state keeps the zoom-18 aggregates of
+ * each input, with its size and modification time. An input already there
+ * and unchanged is not read again; a new or changed one is (its old
+ * contribution is dropped), and only the tiles those inputs touch, at every
+ * zoom, are recomputed and rewritten. Inputs not named keep their
+ * contribution.
+ *
+ * -B times the aggregation (without output) on 1, 2, 4, ... threads.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -pthread -Ihost/lib -o heattile host/tools/heattile.c \
+ *      host/lib/sarc.c -lm
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sarc.h"
+
+#define ZOOM_MIN	10
+#define ZOOM_MAX	18
+#define MAX_THREADS	64
+#define STATE_NAME	".heattile.state"
+#define STATE_VERSION	1
+
+/// sarc_row_t.pm, in order
+static const char *const columns[SARC_NR_PM] = {
+	"pm1_0_std", "pm2_5_std", "pm10_std", "pm1_0_atm", "pm2_5_atm", "pm10_atm",
+	"n0_3", "n0_5", "n1_0", "n2_5", "n5_0", "n10",
+};
+
+/////////////////////////////////////////////////////////////////////////////
+// Tile tables
+
+/// Aggregate of one tile; also the record of the state file
+typedef struct tile_type {
+	uint64_t key;		// See tile_key(); 0: free slot
+	uint64_t count, sum;
+	uint32_t max;
+	uint32_t pad;
+} tile_t;
+
+/// Open-addressing hash table of tiles
+typedef struct table_type {
+	tile_t *t;
+	size_t  cap, n;
+} table_t;
+
+/// Zoom, column and row in one key (never 0: the zoom is at least 1)
+static uint64_t tile_key(unsigned z, uint32_t x, uint32_t y)
+{
+	return ((uint64_t)z << 58) | ((uint64_t)x << 29) | y;
+}
+
+static unsigned key_z(uint64_t k) { return (unsigned)(k >> 58); }
+static uint32_t key_x(uint64_t k) { return (uint32_t)(k >> 29) & 0x1FFFFFFF; }
+static uint32_t key_y(uint64_t k) { return (uint32_t)k & 0x1FFFFFFF; }
+
+/// The tile containing tile @p k at zoom @p z
+static uint64_t key_parent(uint64_t k, unsigned z)
+{
+	unsigned s = key_z(k) - z;
+
+	return tile_key(z, key_x(k) >> s, key_y(k) >> s);
+}
+
+static size_t table_slot(const table_t *tb, uint64_t key)
+{
+	size_t i = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & (tb->cap - 1);
+
+	while (tb->t[i].key != 0 && tb->t[i].key != key)
+		i = (i + 1) & (tb->cap - 1);
+	return i;
+}
+
+static const tile_t *table_find(const table_t *tb, uint64_t key)
+{
+	const tile_t *t;
+
+	if (tb->n == 0)
+		return NULL;
+	t = &tb->t[table_slot(tb, key)];
+	return t->key != 0 ? t : NULL;
+}
+
+/// Find or add a tile; exits if out of memory, as the rest of the tool does
+static tile_t *table_get(table_t *tb, uint64_t key)
+{
+	tile_t *t;
+
+	if ((tb->n + 1) * 10 > tb->cap * 7) {
+		table_t nt = { calloc(tb->cap ? tb->cap * 2 : 4096, sizeof(tile_t)),
+			       tb->cap ? tb->cap * 2 : 4096, tb->n };
+
+		if (nt.t == NULL) {
+			perror("heattile");
+			exit(1);
+		}
+		for (size_t i = 0; i < tb->cap; ++i)
+			if (tb->t[i].key != 0)
+				nt.t[table_slot(&nt, tb->t[i].key)] = tb->t[i];
+		free(tb->t);
+		*tb = nt;
+	}
+	t = &tb->t[table_slot(tb, key)];
+	if (t->key == 0) {
+		t->key = key;
+		++tb->n;
+	}
+	return t;
+}
+
+static void tile_add(tile_t *t, const tile_t *from)
+{
+	t->count += from->count;
+	t->sum += from->sum;
+	if (from->max > t->max)
+		t->max = from->max;
+}
+
+static void table_free(table_t *tb)
+{
+	free(tb->t);
+	memset(tb, 0, sizeof(*tb));
+}
+
+/// Web-mercator tile of a position at zoom @p z
+static uint64_t lat_lon_key(double lat, double lon, unsigned z)
+{
+	double n = (double)(1u << z);
+	double lr = fmax(-85.05112878, fmin(85.05112878, lat)) * M_PI / 180.0;
+	double x = (lon + 180.0) / 360.0 * n;
+	double y = (1.0 - log(tan(lr) + 1.0 / cos(lr)) / M_PI) / 2.0 * n;
+
+	x = fmin(fmax(x, 0.0), n - 1);
+	y = fmin(fmax(y, 0.0), n - 1);
+	return tile_key(z, (uint32_t)x, (uint32_t)y);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Inputs
+
+typedef struct input_type {
+	char    *path;
+	int64_t  size, mtime_ns;
+	table_t  tiles;		// Zoom 18 partial aggregates
+	bool     dirty;		// To be read on this run
+} input_t;
+
+static input_t *inputs;
+static size_t nr_inputs;
+
+static input_t *input_find(const char *path)
+{
+	for (size_t i = 0; i < nr_inputs; ++i)
+		if (strcmp(inputs[i].path, path) == 0)
+			return &inputs[i];
+	return NULL;
+}
+
+static input_t *input_add(const char *path)
+{
+	input_t *in;
+
+	inputs = realloc(inputs, (nr_inputs + 1) * sizeof(*inputs));
+	if (inputs == NULL || (path = strdup(path)) == NULL) {
+		perror("heattile");
+		exit(1);
+	}
+	in = &inputs[nr_inputs++];
+	memset(in, 0, sizeof(*in));
+	in->path = (char *)path;
+	return in;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// State file
+
+static int state_load(const char *path, int *column)
+{
+	FILE *f = fopen(path, "rb");
+	uint32_t hdr[4];
+
+	if (f == NULL)
+		return errno == ENOENT ? 0 : -1;
+	if (fread(hdr, sizeof(hdr), 1, f) != 1 || memcmp(hdr, "HTST", 4) != 0 ||
+	    hdr[1] != STATE_VERSION) {
+		fclose(f);
+		errno = EINVAL;
+		return -1;
+	}
+	*column = (int)hdr[2];
+	for (uint32_t i = 0; i < hdr[3]; ++i) {
+		uint32_t len;
+		uint64_t nr;
+		char name[4096];
+		input_t *in;
+
+		if (fread(&len, sizeof(len), 1, f) != 1 || len >= sizeof(name) ||
+		    fread(name, 1, len, f) != len)
+			goto bad;
+		name[len] = '\0';
+		in = input_add(name);
+		if (fread(&in->size, sizeof(in->size), 1, f) != 1 ||
+		    fread(&in->mtime_ns, sizeof(in->mtime_ns), 1, f) != 1 ||
+		    fread(&nr, sizeof(nr), 1, f) != 1)
+			goto bad;
+		for (uint64_t j = 0; j < nr; ++j) {
+			tile_t t;
+
+			if (fread(&t, sizeof(t), 1, f) != 1)
+				goto bad;
+			*table_get(&in->tiles, t.key) = t;
+		}
+	}
+	fclose(f);
+	return 0;
+bad:
+	fclose(f);
+	errno = EINVAL;
+	return -1;
+}
+
+static int state_save(const char *path, int column)
+{
+	uint32_t hdr[4] = { 0, STATE_VERSION, (uint32_t)column, (uint32_t)nr_inputs };
+	char tmp[4096 + 8];
+	FILE *f;
+	int err = 0;
+
+	memcpy(hdr, "HTST", 4);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if ((f = fopen(tmp, "wb")) == NULL)
+		return -1;
+	if (fwrite(hdr, sizeof(hdr), 1, f) != 1)
+		err = 1;
+	for (size_t i = 0; i < nr_inputs && !err; ++i) {
+		const input_t *in = &inputs[i];
+		uint32_t len = (uint32_t)strlen(in->path);
+		uint64_t nr = in->tiles.n;
+
+		if (fwrite(&len, sizeof(len), 1, f) != 1 || fwrite(in->path, 1, len, f) != len ||
+		    fwrite(&in->size, sizeof(in->size), 1, f) != 1 ||
+		    fwrite(&in->mtime_ns, sizeof(in->mtime_ns), 1, f) != 1 ||
+		    fwrite(&nr, sizeof(nr), 1, f) != 1)
+			err = 1;
+		for (size_t j = 0; j < in->tiles.cap && !err; ++j)
+			if (in->tiles.t[j].key != 0 && fwrite(&in->tiles.t[j], sizeof(tile_t), 1, f) != 1)
+				err = 1;
+	}
+	if (fclose(f) != 0 || err || rename(tmp, path) != 0) {
+		unlink(tmp);
+		return -1;
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Aggregation
+
+typedef struct item_type {
+	uint32_t input;		// Index into the dirty inputs
+	uint32_t block;
+} item_t;
+
+static item_t *items;
+static size_t nr_items, next_item;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct worker_type {
+	pthread_t th;
+	input_t **dirty;
+	size_t   nr_dirty;
+	int      column;
+	table_t  tiles;		// Keyed by zoom-18 tile, with the input index on top
+	uint64_t samples;
+	int      err;
+} worker_t;
+
+/// Thread-table key: the zoom-18 key (58 bits) and the input index (6 bits) do not fit
+/// together, so the input goes in the zoom field and the zoom is implied
+static uint64_t worker_key(uint32_t input, uint64_t k18)
+{
+	return ((uint64_t)(input + 1) << 58) | (k18 & ((1ull << 58) - 1));
+}
+
+static void *worker(void *arg)
+{
+	worker_t *w = arg;
+	sarc_reader_t **readers = calloc(w->nr_dirty, sizeof(*readers));
+	sarc_row_t *rows = malloc(SARC_BLOCK_ROWS * sizeof(*rows));
+
+	if (readers == NULL || rows == NULL) {
+		w->err = ENOMEM;
+		goto out;
+	}
+	for (;;) {
+		size_t i;
+		int n;
+
+		pthread_mutex_lock(&lock);
+		i = next_item++;
+		pthread_mutex_unlock(&lock);
+		if (i >= nr_items)
+			break;
+
+		const item_t *it = &items[i];
+
+		if (readers[it->input] == NULL &&
+		    (readers[it->input] = sarc_open(w->dirty[it->input]->path)) == NULL) {
+			w->err = errno;
+			break;
+		}
+		if ((n = sarc_read_block(readers[it->input], it->block, rows)) < 0) {
+			w->err = EINVAL;
+			break;
+		}
+		for (int r = 0; r < n; ++r) {
+			tile_t *t;
+
+			if (isnan(rows[r].lat))
+				continue;
+			t = table_get(&w->tiles, worker_key(it->input,
+							   lat_lon_key(rows[r].lat, rows[r].lon, ZOOM_MAX)));
+			++t->count;
+			t->sum += rows[r].pm[w->column];
+			if (rows[r].pm[w->column] > t->max)
+				t->max = rows[r].pm[w->column];
+			++w->samples;
+		}
+	}
+out:
+	for (size_t i = 0; readers != NULL && i < w->nr_dirty; ++i)
+		if (readers[i] != NULL)
+			sarc_close_reader(readers[i]);
+	free(readers);
+	free(rows);
+	return NULL;
+}
+
+/**
+ * Aggregate the dirty inputs into their zoom-18 tables on @p threads threads
+ *
+ * @return	Samples binned, or -1 on error (reported)
+ */
+static int64_t aggregate(input_t **dirty, size_t nr_dirty, int column, int threads)
+{
+	worker_t w[MAX_THREADS];
+	uint64_t samples = 0;
+	int err = 0;
+
+	if (nr_dirty >= 63) {
+		// The thread tables have six bits for the input; do it in batches
+		int64_t a = aggregate(dirty, 62, column, threads);
+		int64_t b = a < 0 ? -1 : aggregate(dirty + 62, nr_dirty - 62, column, threads);
+
+		return b < 0 ? -1 : a + b;
+	}
+
+	nr_items = next_item = 0;
+	for (size_t i = 0; i < nr_dirty; ++i) {
+		sarc_reader_t *r = sarc_open(dirty[i]->path);
+
+		if (r == NULL) {
+			perror(dirty[i]->path);
+			return -1;
+		}
+		items = realloc(items, (nr_items + sarc_nr_blocks(r) + 1) * sizeof(*items));
+		if (items == NULL) {
+			perror("heattile");
+			exit(1);
+		}
+		for (uint32_t b = 0; b < sarc_nr_blocks(r); ++b)
+			if (sarc_block_info(r, b)->nr_fix > 0)
+				items[nr_items++] = (item_t){ (uint32_t)i, b };
+		sarc_close_reader(r);
+		table_free(&dirty[i]->tiles);
+	}
+
+	for (int t = 0; t < threads; ++t) {
+		w[t] = (worker_t){ .dirty = dirty, .nr_dirty = nr_dirty, .column = column };
+		pthread_create(&w[t].th, NULL, worker, &w[t]);
+	}
+	for (int t = 0; t < threads; ++t) {
+		pthread_join(w[t].th, NULL);
+		if (w[t].err != 0)
+			err = w[t].err;
+	}
+
+	// Merge the thread tables into the inputs' tables
+	for (int t = 0; t < threads; ++t) {
+		for (size_t i = 0; i < w[t].tiles.cap; ++i) {
+			const tile_t *pt = &w[t].tiles.t[i];
+			tile_t *to;
+
+			if (pt->key == 0)
+				continue;
+			to = table_get(&dirty[(pt->key >> 58) - 1]->tiles,
+				       tile_key(ZOOM_MAX, key_x(pt->key), key_y(pt->key)));
+			tile_add(to, &(tile_t){ 0, pt->count, pt->sum, pt->max, 0 });
+		}
+		samples += w[t].samples;
+		table_free(&w[t].tiles);
+	}
+	if (err != 0) {
+		errno = err;
+		perror("heattile");
+		return -1;
+	}
+	return (int64_t)samples;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Output
+
+static int write_tile(const char *out, uint64_t key, const tile_t *t)
+{
+	char path[4096];
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/%u/%u/%u.json", out, key_z(key), key_x(key), key_y(key));
+	if (t == NULL || t->count == 0)
+		return unlink(path) == 0 || errno == ENOENT ? 0 : -1;
+
+	// Make OUT/Z/X as needed
+	for (char *p = path + strlen(out) + 1; (p = strchr(p, '/')) != NULL; ++p) {
+		*p = '\0';
+		if (mkdir(path, 0777) != 0 && errno != EEXIST)
+			return -1;
+		*p = '/';
+	}
+	if ((f = fopen(path, "w")) == NULL)
+		return -1;
+	fprintf(f, "{\"z\":%u,\"x\":%u,\"y\":%u,\"count\":%" PRIu64 ",\"mean\":%.2f,\"max\":%u}\n",
+		key_z(key), key_x(key), key_y(key), t->count, (double)t->sum / t->count, t->max);
+	return fclose(f);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int bench(char **paths, int nr_paths, int column, int max_threads)
+{
+	input_t **dirty = malloc((size_t)nr_paths * sizeof(*dirty));
+	double t1 = 0;
+
+	for (int i = 0; i < nr_paths; ++i)
+		input_add(paths[i]);
+	for (int i = 0; i < nr_paths; ++i)
+		dirty[i] = &inputs[i];
+	for (int t = 1; t <= max_threads; t *= 2) {
+		uint64_t t0 = now_ns();
+		int64_t n = aggregate(dirty, (size_t)nr_paths, column, t);
+		double dt = (now_ns() - t0) / 1e9;
+
+		if (n < 0)
+			return 1;
+		if (t == 1)
+			t1 = dt;
+		printf("%2d threads: %" PRId64 " samples in %.3f s (%.1f M/s, %.2fx)\n",
+		       t, n, dt, n / dt / 1e6, t1 / dt);
+	}
+	free(dirty);
+	return 0;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s -o OUTDIR [-j THREADS] [-c COLUMN] ARCHIVE...\n"
+		"       %s -B [-j MAX_THREADS] [-c COLUMN] ARCHIVE...\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *out = NULL;
+	int threads = 1, column = 4, state_column = -1, do_bench = 0, c;
+	input_t **dirty;
+	size_t nr_dirty = 0, written = 0;
+	table_t total = { 0 }, affected[ZOOM_MAX + 1];
+	char state[4096];
+	uint64_t t0 = now_ns();
+	int64_t samples;
+
+	while ((c = getopt(argc, argv, "o:j:c:Bh")) != -1) {
+		switch (c) {
+		case 'o': out = optarg; break;
+		case 'j':
+			threads = atoi(optarg);
+			threads = threads < 1 ? 1 : threads > MAX_THREADS ? MAX_THREADS : threads;
+			break;
+		case 'c':
+			for (column = 0; column < SARC_NR_PM && strcmp(optarg, columns[column]) != 0; ++column)
+				;
+			if (column == SARC_NR_PM) {
+				fprintf(stderr, "unknown column: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'B': do_bench = 1; break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind == argc || (out == NULL && !do_bench)) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (do_bench)
+		return bench(&argv[optind], argc - optind, column, threads);
+
+	if (mkdir(out, 0777) != 0 && errno != EEXIST) {
+		perror(out);
+		return 1;
+	}
+	snprintf(state, sizeof(state), "%s/%s", out, STATE_NAME);
+	if (state_load(state, &state_column) != 0) {
+		perror(state);
+		return 1;
+	}
+	if (state_column >= 0 && state_column != column) {
+		fprintf(stderr, "%s holds %s; use another directory for %s\n", out,
+			columns[state_column], columns[column]);
+		return 1;
+	}
+
+	// New and changed inputs
+	for (int i = optind; i < argc; ++i) {
+		input_t *in = input_find(argv[i]);
+		struct stat sb;
+
+		if (stat(argv[i], &sb) != 0) {
+			perror(argv[i]);
+			return 1;
+		}
+		if (in == NULL)
+			in = input_add(argv[i]);
+		if (in->size != (int64_t)sb.st_size ||
+		    in->mtime_ns != (int64_t)sb.st_mtim.tv_sec * 1000000000 + sb.st_mtim.tv_nsec) {
+			in->size = (int64_t)sb.st_size;
+			in->mtime_ns = (int64_t)sb.st_mtim.tv_sec * 1000000000 + sb.st_mtim.tv_nsec;
+			in->dirty = true;
+		}
+	}
+	dirty = malloc((nr_inputs + 1) * sizeof(*dirty));
+	for (size_t i = 0; i < nr_inputs; ++i)
+		if (inputs[i].dirty)
+			dirty[nr_dirty++] = &inputs[i];
+	if (nr_dirty == 0) {
+		printf("%s: up to date (%zu inputs)\n", out, nr_inputs);
+		return 0;
+	}
+
+	// The zoom-18 tiles the dirty inputs covered before, and cover now
+	memset(affected, 0, sizeof(affected));
+	for (size_t i = 0; i < nr_dirty; ++i)
+		for (size_t j = 0; j < dirty[i]->tiles.cap; ++j)
+			if (dirty[i]->tiles.t[j].key != 0)
+				table_get(&affected[ZOOM_MAX], dirty[i]->tiles.t[j].key);
+	if ((samples = aggregate(dirty, nr_dirty, column, threads)) < 0)
+		return 1;
+	for (size_t i = 0; i < nr_dirty; ++i)
+		for (size_t j = 0; j < dirty[i]->tiles.cap; ++j)
+			if (dirty[i]->tiles.t[j].key != 0)
+				table_get(&affected[ZOOM_MAX], dirty[i]->tiles.t[j].key);
+	for (size_t j = 0; j < affected[ZOOM_MAX].cap; ++j)
+		for (unsigned z = ZOOM_MIN; z < ZOOM_MAX && affected[ZOOM_MAX].t[j].key != 0; ++z)
+			table_get(&affected[z], key_parent(affected[ZOOM_MAX].t[j].key, z));
+
+	// Recompute the affected tiles from every input's zoom-18 aggregates
+	for (size_t i = 0; i < nr_inputs; ++i) {
+		for (size_t j = 0; j < inputs[i].tiles.cap; ++j) {
+			const tile_t *t = &inputs[i].tiles.t[j];
+
+			if (t->key == 0)
+				continue;
+			for (unsigned z = ZOOM_MIN; z <= ZOOM_MAX; ++z) {
+				uint64_t pk = key_parent(t->key, z);
+
+				if (table_find(&affected[z], pk) != NULL)
+					tile_add(table_get(&total, pk), t);
+			}
+		}
+	}
+	for (unsigned z = ZOOM_MIN; z <= ZOOM_MAX; ++z) {
+		for (size_t j = 0; j < affected[z].cap; ++j) {
+			uint64_t key = affected[z].t[j].key;
+
+			if (key == 0)
+				continue;
+			if (write_tile(out, key, table_find(&total, key)) != 0) {
+				perror(out);
+				return 1;
+			}
+			++written;
+		}
+	}
+	if (state_save(state, column) != 0) {
+		perror(state);
+		return 1;
+	}
+	printf("%s: %zu of %zu inputs read, %" PRId64 " samples, %zu tiles rewritten (z%d-z%d) in %.2f s\n",
+	       out, nr_dirty, nr_inputs, samples, written, ZOOM_MIN, ZOOM_MAX,
+	       (now_ns() - t0) / 1e9);
+	return 0;
+}
@@ -0,0 +1,1035 @@
+/**
+ * @file host/tools/ingestd.c
+ * @brief Ingests the live output of many units into archives.
+ *
+ * Replaces one PuTTY window and one Python scraper per unit. The daemon opens
+ * every given serial port or pty non-blocking and waits on all of them in one
+ * epoll loop. The main thread only reads: each read becomes a chunk stamped
+ * with the host's clock, which is queued on its unit. Units with queued
+ * chunks are handed to a pool of worker threads. A unit is decoded by at most
+ * one worker at a time, so its chunks are decoded in order, with the
+ * decoder state (host/lib/sdec.h) carried from one chunk to the next.
+ *
+ * Each PMS frame becomes an archive row (host/lib/sarc.h) holding the host
+ * time of the read it completed in, the last GPS position the unit reported
+ * and the 12 PMS channels. All units are stamped from the same clock, so
+ * their archives line up whether or not a unit has a GPS fix. The archives
+ * are OUTDIR/NAME/YYYYmmddTHHMMSSZ.sarc, one per unit and rotation period
+ * (-R seconds); a period is closed, index and all, when its first row past
+ * the end arrives or when the daemon stops.
+ *
+ * Every -v seconds, and into OUTDIR/ingestd.stats.json every 5 s, the daemon
+ * reports per unit: the bytes and rows per second, checksum failures, read
+ * errors and reopens, the backlog waiting for a worker (capped per unit; the
+ * oldest reads beyond it are dropped and counted), and the latency from the
+ * read to the row reaching its archive writer (mean, 99th percentile and
+ * maximum). A port that goes away is reopened every second, and its data is
+ * decoded afresh from there, as after dropped reads.
+ *
+ * With -B the tool instead creates -n ptys, feeds each a simulated unit's
+ * output from a separate thread (tagged NMEA RMC sentences, binary PMS
+ * frames and status lines, as the board prints them) for -t seconds, ingests
+ * them into OUTDIR, and then checks every archive against what was sent.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -pthread -Iinc -Ihost/lib -o ingestd host/tools/ingestd.c \
+ *      host/lib/sdec.c host/lib/sarc.c src/parsers/nmea_parse.c \
+ *      src/parsers/pms_parser.c -lm
+ */
+
+#define _GNU_SOURCE
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sarc.h"
+#include "sdec.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define INGESTD_CHUNK		4096	// Bytes per read
+#define INGESTD_READS_PER_WAKE	8	// Reads of one port before moving on
+#define INGESTD_BACKLOG_MAX	(256 * INGESTD_CHUNK)	// Bytes queued per unit
+#define INGESTD_STATS_S		5	// Seconds between stats file updates
+#define INGESTD_LAT_BUCKETS	32	// Latency histogram: [2^i, 2^(i+1)) us
+
+static const char *opt_outdir;
+static long opt_baud = 9600;
+static unsigned opt_threads = 2;
+static unsigned opt_rotate_s = 3600;
+static unsigned opt_report;		// Seconds between stats lines; 0: none
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	stop_requested = 1;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int64_t wall_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/// Let this process have as many descriptors as the hard limit allows
+static void raise_fd_limit(void)
+{
+	struct rlimit rl;
+
+	if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Units
+
+/// One read, waiting to be decoded
+typedef struct chunk_type {
+	struct chunk_type *next;
+	uint64_t t_ns;			// Monotonic time of the read
+	int64_t  t_ms;			// Wall-clock time of the read
+	bool     gap;			// Data before it was lost: decode afresh
+	size_t   len;
+	uint8_t  data[INGESTD_CHUNK];
+} chunk_t;
+
+/// Counters a worker publishes after each batch (under the lock)
+typedef struct ustats_type {
+	uint64_t bytes, rows;
+	uint64_t nmea_bad, pms_bad;
+	uint64_t write_errors;
+	uint64_t dropped;		// Bytes lost to a full backlog
+	uint64_t chunks, lat_sum_us, lat_max_us;
+	uint64_t lat_hist[INGESTD_LAT_BUCKETS];
+} ustats_t;
+
+typedef struct unit_type {
+	const char *path;
+	char        name[64];		// Archive directory under OUTDIR
+	int         fd;			// -1 while the port is gone
+
+	// Under the lock
+	chunk_t            *pending, *pending_tail;
+	size_t              backlog;	// Bytes in pending
+	bool                queued;	// On the run queue, or being decoded
+	struct unit_type   *run_next;
+	ustats_t            st;
+
+	// Owned by the worker decoding the unit
+	sdec_t         dec;
+	sarc_writer_t *w;
+	int64_t        w_period;	// Rotation period the writer covers
+	char           w_path[4096];
+	uint64_t       write_errors;	// Rows lost to archive errors
+
+	// Owned by the main thread
+	uint64_t  read_errors, reopens;
+	bool      gap;			// The next read follows lost data (a reopen)
+	ustats_t  prev;			// At the last report, for rates
+	ustats_t  prev_file;		// At the last stats file, for rates
+} unit_t;
+
+static unit_t *units;
+static unsigned nr_units;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  work = PTHREAD_COND_INITIALIZER;
+static unit_t *run_head, *run_tail;
+static chunk_t *free_chunks;
+static uint64_t chunks_allocated;
+static bool workers_stop;
+
+/// A chunk from the free list, or a new one
+static chunk_t *chunk_get(void)
+{
+	chunk_t *c;
+
+	pthread_mutex_lock(&lock);
+	if ((c = free_chunks) != NULL)
+		free_chunks = c->next;
+	pthread_mutex_unlock(&lock);
+	if (c == NULL) {
+		if ((c = malloc(sizeof(*c))) == NULL) {
+			perror("malloc");
+			exit(1);
+		}
+		++chunks_allocated;
+	}
+	return c;
+}
+
+/**
+ * Queue a chunk on its unit, and the unit for a worker if it is idle
+ *
+ * A unit whose workers fall behind keeps at most INGESTD_BACKLOG_MAX bytes
+ * queued: its oldest chunks are dropped (and counted), so a stalled unit
+ * cannot take all the memory and resumes with current data.
+ */
+static void chunk_queue(unit_t *u, chunk_t *c)
+{
+	bool dropped = false;
+
+	c->next = NULL;
+	c->gap = u->gap;
+	u->gap = false;
+	pthread_mutex_lock(&lock);
+	while (u->pending && u->backlog + c->len > INGESTD_BACKLOG_MAX) {
+		chunk_t *old = u->pending;
+
+		if ((u->pending = old->next) == NULL)
+			u->pending_tail = NULL;
+		u->backlog -= old->len;
+		u->st.dropped += old->len;
+		old->next = free_chunks;
+		free_chunks = old;
+		dropped = true;
+	}
+	if (dropped)
+		(u->pending ? u->pending : c)->gap = true;
+	if (u->pending_tail)
+		u->pending_tail->next = c;
+	else
+		u->pending = c;
+	u->pending_tail = c;
+	u->backlog += c->len;
+	if (!u->queued) {
+		u->queued = true;
+		u->run_next = NULL;
+		if (run_tail)
+			run_tail->run_next = u;
+		else
+			run_head = u;
+		run_tail = u;
+		pthread_cond_signal(&work);
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Archives
+
+/// First free OUTDIR/NAME/STAMP[-N].sarc for a period
+static void archive_path(const unit_t *u, int64_t period, char *out, size_t size)
+{
+	time_t t = (time_t)(period * opt_rotate_s);
+	struct tm tm;
+	char stamp[32];
+
+	gmtime_r(&t, &tm);
+	strftime(stamp, sizeof(stamp), "%Y%m%dT%H%M%SZ", &tm);
+	snprintf(out, size, "%s/%s/%s.sarc", opt_outdir, u->name, stamp);
+	for (int n = 1; access(out, F_OK) == 0; ++n)
+		snprintf(out, size, "%s/%s/%s-%d.sarc", opt_outdir, u->name, stamp, n);
+}
+
+static void archive_close(unit_t *u)
+{
+	if (u->w && sarc_close(u->w) != 0)
+		fprintf(stderr, "ingestd: %s: %s\n", u->w_path, strerror(errno));
+	u->w = NULL;
+}
+
+/// Append a decoded row, rotating the archive when its period is over
+static void on_row(void *user, const sarc_row_t *row)
+{
+	unit_t *u = user;
+	int64_t period = row->t_ms / ((int64_t)opt_rotate_s * 1000);
+
+	if (u->w && period != u->w_period)
+		archive_close(u);
+	if (u->w == NULL) {
+		archive_path(u, period, u->w_path, sizeof(u->w_path));
+		if ((u->w = sarc_create(u->w_path)) == NULL) {
+			fprintf(stderr, "ingestd: %s: %s\n", u->w_path, strerror(errno));
+			++u->write_errors;
+			return;
+		}
+		u->w_period = period;
+	}
+	if (sarc_append(u->w, row) != 0)
+		++u->write_errors;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Workers
+
+static unsigned lat_bucket(uint64_t us)
+{
+	unsigned b = 0;
+
+	while (us > 1 && b < INGESTD_LAT_BUCKETS - 1) {
+		us >>= 1;
+		++b;
+	}
+	return b;
+}
+
+/// Decode everything queued on a unit; called without the lock
+static void unit_decode(unit_t *u, chunk_t *list)
+{
+	uint64_t rows_before = u->dec.pms_ok;
+	uint64_t lat_hist[INGESTD_LAT_BUCKETS] = { 0 };
+	uint64_t lat_sum = 0, lat_max = 0, chunks = 0;
+	size_t bytes = 0;
+	chunk_t *c, *last = NULL;
+
+	for (c = list; c; c = c->next) {
+		uint64_t before = u->dec.pms_ok, us;
+
+		if (c->gap)
+			sdec_resync(&u->dec);
+		sdec_feed(&u->dec, c->data, c->len, c->t_ms, on_row, u);
+		bytes += c->len;
+		last = c;
+		if (u->dec.pms_ok == before)
+			continue;
+		// Read to archived, for the reads that completed a row
+		us = (now_ns() - c->t_ns) / 1000;
+		lat_sum += us;
+		lat_max = us > lat_max ? us : lat_max;
+		++lat_hist[lat_bucket(us)];
+		++chunks;
+	}
+
+	pthread_mutex_lock(&lock);
+	u->backlog -= bytes;
+	u->st.bytes = u->dec.bytes;
+	u->st.rows += u->dec.pms_ok - rows_before;
+	u->st.nmea_bad = u->dec.nmea_bad;
+	u->st.pms_bad = u->dec.pms_bad;
+	u->st.write_errors = u->write_errors;
+	u->st.chunks += chunks;
+	u->st.lat_sum_us += lat_sum;
+	if (lat_max > u->st.lat_max_us)
+		u->st.lat_max_us = lat_max;
+	for (unsigned i = 0; i < INGESTD_LAT_BUCKETS; ++i)
+		u->st.lat_hist[i] += lat_hist[i];
+	if (last) {
+		last->next = free_chunks;
+		free_chunks = list;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+static void *worker(void *arg)
+{
+	struct rusage *ru = arg;
+
+	pthread_mutex_lock(&lock);
+	for (;;) {
+		unit_t *u;
+		chunk_t *list;
+
+		while (run_head == NULL && !workers_stop)
+			pthread_cond_wait(&work, &lock);
+		if (run_head == NULL)
+			break;
+		u = run_head;
+		if ((run_head = u->run_next) == NULL)
+			run_tail = NULL;
+		list = u->pending;
+		u->pending = u->pending_tail = NULL;
+		pthread_mutex_unlock(&lock);
+
+		unit_decode(u, list);
+
+		pthread_mutex_lock(&lock);
+		if (u->pending) {
+			// More arrived meanwhile: back of the queue, for fairness
+			u->run_next = NULL;
+			if (run_tail)
+				run_tail->run_next = u;
+			else
+				run_head = u;
+			run_tail = u;
+		} else {
+			u->queued = false;
+		}
+	}
+	pthread_mutex_unlock(&lock);
+	getrusage(RUSAGE_THREAD, ru);
+	return NULL;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Ports
+
+static speed_t baud_to_speed(long baud)
+{
+	switch (baud) {
+	case 9600:   return B9600;
+	case 19200:  return B19200;
+	case 38400:  return B38400;
+	case 57600:  return B57600;
+	case 115200: return B115200;
+	default:     return B0;
+	}
+}
+
+static int epfd = -1, timer_fd = -1;
+
+static int serial_open(unit_t *u, bool quiet)
+{
+	struct termios tio;
+	struct epoll_event ev = { .events = EPOLLIN, .data.ptr = u };
+	int fd = open(u->path, O_RDONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+	if (fd < 0) {
+		if (!quiet)
+			fprintf(stderr, "ingestd: %s: %s\n", u->path, strerror(errno));
+		return -1;
+	}
+	if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		if (baud_to_speed(opt_baud) != B0) {
+			cfsetispeed(&tio, baud_to_speed(opt_baud));
+			cfsetospeed(&tio, baud_to_speed(opt_baud));
+		}
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+	return fd;
+}
+
+static void unit_read(unit_t *u)
+{
+	for (int i = 0; i < INGESTD_READS_PER_WAKE; ++i) {
+		chunk_t *c = chunk_get();
+		ssize_t n = read(u->fd, c->data, sizeof(c->data));
+
+		if (n > 0) {
+			c->t_ns = now_ns();
+			c->t_ms = wall_ms();
+			c->len = (size_t)n;
+			chunk_queue(u, c);
+			if ((size_t)n < sizeof(c->data))
+				return;
+			continue;
+		}
+		pthread_mutex_lock(&lock);
+		c->next = free_chunks;
+		free_chunks = c;
+		pthread_mutex_unlock(&lock);
+		if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+		// EOF, or EIO once a pty's other end or a USB port goes away
+		++u->read_errors;
+		fprintf(stderr, "ingestd: %s closed; reopening\n", u->path);
+		close(u->fd);
+		u->fd = -1;
+		return;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Stats
+
+/// Latency percentile from a histogram: the upper edge of its bucket, or the maximum
+static double lat_pct_ms(const uint64_t *hist, uint64_t n, double p, uint64_t max_us)
+{
+	uint64_t want = (uint64_t)ceil(n * p / 100.0), seen = 0;
+
+	for (unsigned i = 0; i < INGESTD_LAT_BUCKETS; ++i) {
+		seen += hist[i];
+		if (n && seen >= want)
+			return (double)((2ull << i) < max_us ? (2ull << i) : max_us) / 1000.0;
+	}
+	return 0;
+}
+
+/// Counters and backlog of every unit
+static void snapshot(ustats_t *now, size_t *backlog)
+{
+	pthread_mutex_lock(&lock);
+	for (unsigned i = 0; i < nr_units; ++i) {
+		now[i] = units[i].st;
+		backlog[i] = units[i].backlog;
+	}
+	pthread_mutex_unlock(&lock);
+}
+
+static void print_stats(unsigned secs)
+{
+	ustats_t *now = malloc(nr_units * sizeof(*now));
+	size_t *backlog = malloc(nr_units * sizeof(*backlog));
+
+	if (now == NULL || backlog == NULL) {
+		free(now);
+		free(backlog);
+		return;
+	}
+	snapshot(now, backlog);
+	fprintf(stderr, "%-16s %4s %8s %7s %8s %6s %6s %5s %5s %8s %8s %8s %8s %8s\n",
+		"unit", "port", "B/s", "rows/s", "rows", "nmea!", "pms!", "rerr",
+		"reop", "backlog", "dropped", "lat_avg", "lat_p99", "lat_max");
+	for (unsigned i = 0; i < nr_units; ++i) {
+		unit_t *u = &units[i];
+		ustats_t *s = &now[i], d = *s;
+
+		d.chunks -= u->prev.chunks;
+		d.lat_sum_us -= u->prev.lat_sum_us;
+		for (unsigned k = 0; k < INGESTD_LAT_BUCKETS; ++k)
+			d.lat_hist[k] -= u->prev.lat_hist[k];
+		fprintf(stderr,
+			"%-16s %4s %8.0f %7.1f %8llu %6llu %6llu %5llu %5llu %8zu %8llu %6.2fms %6.2fms %6.2fms\n",
+			u->name, u->fd >= 0 ? "open" : "gone",
+			(double)(s->bytes - u->prev.bytes) / secs,
+			(double)(s->rows - u->prev.rows) / secs,
+			(unsigned long long)s->rows,
+			(unsigned long long)s->nmea_bad, (unsigned long long)s->pms_bad,
+			(unsigned long long)u->read_errors, (unsigned long long)u->reopens,
+			backlog[i], (unsigned long long)s->dropped,
+			d.chunks ? (double)d.lat_sum_us / d.chunks / 1000.0 : 0.0,
+			lat_pct_ms(d.lat_hist, d.chunks, 99, s->lat_max_us), s->lat_max_us / 1000.0);
+		u->prev = *s;
+	}
+	free(now);
+	free(backlog);
+}
+
+/// OUTDIR/ingestd.stats.json, replaced whole
+static void write_stats_file(unsigned secs)
+{
+	char path[4096], tmp[4096 + 8];
+	ustats_t *now = malloc(nr_units * sizeof(*now));
+	size_t *backlog = malloc(nr_units * sizeof(*backlog));
+	FILE *f;
+
+	snprintf(path, sizeof(path), "%s/ingestd.stats.json", opt_outdir);
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if (now == NULL || backlog == NULL || (f = fopen(tmp, "w")) == NULL) {
+		free(now);
+		free(backlog);
+		return;
+	}
+	snapshot(now, backlog);
+	fprintf(f, "{\"t\":%lld,\"interval_s\":%u,\"chunks_allocated\":%llu,\"units\":[",
+		(long long)wall_ms(), secs, (unsigned long long)chunks_allocated);
+	for (unsigned i = 0; i < nr_units; ++i) {
+		unit_t *u = &units[i];
+		ustats_t *s = &now[i], d = *s;
+
+		d.chunks -= u->prev_file.chunks;
+		d.lat_sum_us -= u->prev_file.lat_sum_us;
+		for (unsigned k = 0; k < INGESTD_LAT_BUCKETS; ++k)
+			d.lat_hist[k] -= u->prev_file.lat_hist[k];
+		fprintf(f, "%s\n{\"name\":\"%s\",\"path\":\"%s\",\"open\":%s,"
+			"\"bytes\":%llu,\"rows\":%llu,\"bytes_per_s\":%.1f,\"rows_per_s\":%.2f,"
+			"\"nmea_bad\":%llu,\"pms_bad\":%llu,\"read_errors\":%llu,\"reopens\":%llu,"
+			"\"write_errors\":%llu,\"backlog\":%zu,\"dropped\":%llu,"
+			"\"lat_avg_ms\":%.3f,\"lat_p99_ms\":%.3f,\"lat_max_ms\":%.3f}",
+			i ? "," : "", u->name, u->path, u->fd >= 0 ? "true" : "false",
+			(unsigned long long)s->bytes, (unsigned long long)s->rows,
+			(double)(s->bytes - u->prev_file.bytes) / secs,
+			(double)(s->rows - u->prev_file.rows) / secs,
+			(unsigned long long)s->nmea_bad, (unsigned long long)s->pms_bad,
+			(unsigned long long)u->read_errors, (unsigned long long)u->reopens,
+			(unsigned long long)s->write_errors, backlog[i], (unsigned long long)s->dropped,
+			d.chunks ? (double)d.lat_sum_us / d.chunks / 1000.0 : 0.0,
+			lat_pct_ms(d.lat_hist, d.chunks, 99, s->lat_max_us), s->lat_max_us / 1000.0);
+		u->prev_file = *s;
+	}
+	fprintf(f, "\n]}\n");
+	if (fclose(f) == 0)
+		rename(tmp, path);
+	free(now);
+	free(backlog);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Daemon
+
+/// Called every second from the main loop (and so by -B to end the run)
+static void (*tick_hook)(uint64_t tick);
+
+/**
+ * Ingest until SIGINT / SIGTERM
+ *
+ * @param	worker_ru	Room for the CPU time of each worker, or NULL
+ * @param	main_ru		Room for the main thread's CPU time, or NULL
+ */
+static int run(struct rusage *worker_ru, struct rusage *main_ru)
+{
+	struct sigaction sa = { .sa_handler = on_signal };
+	struct itimerspec its = { { 1, 0 }, { 1, 0 } };
+	struct epoll_event ev = { .events = EPOLLIN, .data.ptr = NULL };
+	struct epoll_event evs[256];
+	struct rusage *ru = calloc(opt_threads, sizeof(*ru));
+	pthread_t *tids = calloc(opt_threads, sizeof(*tids));
+	uint64_t tick = 0;
+
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	raise_fd_limit();
+	if (ru == NULL || tids == NULL) {
+		perror("calloc");
+		return 1;
+	}
+
+	if (mkdir(opt_outdir, 0777) != 0 && errno != EEXIST) {
+		perror(opt_outdir);
+		return 1;
+	}
+	for (unsigned i = 0; i < nr_units; ++i) {
+		char dir[4096];
+
+		snprintf(dir, sizeof(dir), "%s/%s", opt_outdir, units[i].name);
+		if (mkdir(dir, 0777) != 0 && errno != EEXIST) {
+			perror(dir);
+			return 1;
+		}
+	}
+
+	if ((epfd = epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+	    (timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+		perror("epoll");
+		return 1;
+	}
+	timerfd_settime(timer_fd, 0, &its, NULL);
+	epoll_ctl(epfd, EPOLL_CTL_ADD, timer_fd, &ev);	// data.ptr NULL: the timer
+	for (unsigned i = 0; i < nr_units; ++i) {
+		sdec_init(&units[i].dec);
+		units[i].fd = serial_open(&units[i], false);
+	}
+	for (unsigned i = 0; i < opt_threads; ++i)
+		pthread_create(&tids[i], NULL, worker, &ru[i]);
+
+	while (!stop_requested) {
+		int n = epoll_wait(epfd, evs, sizeof(evs) / sizeof(evs[0]), -1);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0) {
+			perror("epoll_wait");
+			break;
+		}
+		for (int i = 0; i < n; ++i) {
+			unit_t *u = evs[i].data.ptr;
+			uint64_t expirations;
+
+			if (u) {
+				if (u->fd >= 0)
+					unit_read(u);
+				continue;
+			}
+			if (read(timer_fd, &expirations, sizeof(expirations)) <= 0)
+				continue;
+			++tick;
+			for (unsigned k = 0; k < nr_units; ++k)
+				if (units[k].fd < 0 && (units[k].fd = serial_open(&units[k], true)) >= 0) {
+					// What was cut off at the close is not continued here
+					units[k].gap = true;
+					++units[k].reopens;
+				}
+			if (opt_report && tick % opt_report == 0)
+				print_stats(opt_report);
+			if (tick % INGESTD_STATS_S == 0)
+				write_stats_file(INGESTD_STATS_S);
+			if (tick_hook)
+				tick_hook(tick);
+		}
+	}
+
+	// Drain what was read, then close every archive with its index
+	pthread_mutex_lock(&lock);
+	workers_stop = true;
+	pthread_cond_broadcast(&work);
+	pthread_mutex_unlock(&lock);
+	for (unsigned i = 0; i < opt_threads; ++i)
+		pthread_join(tids[i], NULL);
+	for (unsigned i = 0; i < nr_units; ++i) {
+		archive_close(&units[i]);
+		if (units[i].fd >= 0)
+			close(units[i].fd);
+	}
+	if (main_ru)
+		getrusage(RUSAGE_THREAD, main_ru);
+	if (worker_ru)
+		memcpy(worker_ru, ru, opt_threads * sizeof(*ru));
+	free(ru);
+	free(tids);
+	return 0;
+}
+
+/// NAME=PATH, or PATH named after itself ("/dev/ttyACM0" -> "ttyACM0")
+static void unit_set(unit_t *u, const char *arg)
+{
+	const char *eq = strchr(arg, '=');
+	char *p;
+
+	memset(u, 0, sizeof(*u));
+	u->fd = -1;
+	if (eq && eq != arg) {
+		snprintf(u->name, sizeof(u->name), "%.*s", (int)(eq - arg), arg);
+		u->path = eq + 1;
+	} else {
+		u->path = arg;
+		snprintf(u->name, sizeof(u->name), "%s",
+			 strncmp(arg, "/dev/", 5) == 0 ? arg + 5 : arg);
+	}
+	for (p = u->name; *p; ++p)
+		if (*p == '/' || *p == ' ')
+			*p = '_';
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark: simulated units on ptys
+
+/// Deterministic PRNG (xorshift32), so the simulated units are reproducible
+static uint32_t rng_state = 0x2545F491;
+static uint32_t rng_next(void)
+{
+	uint32_t x = rng_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+
+/// The feeding side of one simulated unit
+typedef struct sim_type {
+	int      master;
+	uint64_t next_ns;		// Next report
+	double   lat, lon;
+	uint16_t pm[SARC_NR_PM];
+	uint64_t frames, frames_lost;	// Written / cut short by a full pty
+} sim_t;
+
+static sim_t *sims;
+static unsigned sim_rate = 10;
+static double sim_secs = 10;
+static volatile int sim_done;
+static uint64_t sim_done_tick;
+
+/// One report of a unit as the board prints it: status line, RMC, PMS frame
+static size_t sim_report(sim_t *s, uint64_t seq, uint8_t *out)
+{
+	time_t now = time(NULL);
+	struct tm tm;
+	char body[96];
+	size_t n = 0;
+	uint8_t sum = 0;
+	uint16_t fsum = 0;
+	double alat = fabs(s->lat), alon = fabs(s->lon);
+
+	gmtime_r(&now, &tm);
+	if (seq % 10 == 0)
+		n += (size_t)sprintf((char *)out + n,
+				     "\033[1;36m[STATUS]\033[0m GPS: \033[32mOK\033[0m | "
+				     "PM: \033[32mOK\033[0m | Uptime: %llu s\r\n",
+				     (unsigned long long)(seq / sim_rate));
+	snprintf(body, sizeof(body), "GPRMC,%02d%02d%02d.00,A,%02d%07.4f,%c,%03d%07.4f,%c,0.5,0.0,%02d%02d%02d,,,A",
+		 tm.tm_hour, tm.tm_min, tm.tm_sec,
+		 (int)alat, (alat - (int)alat) * 60, s->lat < 0 ? 'S' : 'N',
+		 (int)alon, (alon - (int)alon) * 60, s->lon < 0 ? 'W' : 'E',
+		 tm.tm_mday, tm.tm_mon + 1, tm.tm_year % 100);
+	for (const char *c = body; *c; ++c)
+		sum ^= (uint8_t)*c;
+	n += (size_t)sprintf((char *)out + n, "\033[32m[GPS RAW] \033[0m$%s*%02X\r\n", body, sum);
+
+	n += (size_t)sprintf((char *)out + n, "\033[33m[PM RAW] \033[0m");
+	out[n] = 0x42; out[n + 1] = 0x4D; out[n + 2] = 0x00; out[n + 3] = 28;
+	for (int k = 0; k < 13; ++k) {
+		uint16_t v = k < SARC_NR_PM ? s->pm[k] : 0;
+
+		out[n + 4 + 2 * k] = (uint8_t)(v >> 8);
+		out[n + 5 + 2 * k] = (uint8_t)v;
+	}
+	for (int k = 0; k < 30; ++k)
+		fsum += out[n + k];
+	out[n + 30] = (uint8_t)(fsum >> 8);
+	out[n + 31] = (uint8_t)fsum;
+	n += 32;
+	out[n++] = '\r';
+	out[n++] = '\n';
+
+	// Move on: a slow walk, and readings that drift
+	s->lat += ((int)(rng_next() % 3) - 1) * 1e-5;
+	s->lon += ((int)(rng_next() % 3) - 1) * 1e-5;
+	for (int k = 0; k < SARC_NR_PM; ++k) {
+		unsigned r = rng_next() % 4;
+
+		if (r == 0 && s->pm[k] > 1)
+			--s->pm[k];
+		else if (r == 1 && s->pm[k] < 2000)
+			++s->pm[k];
+	}
+	return n;
+}
+
+static void *sim_feeder(void *arg)
+{
+	uint64_t period = 1000000000ull / sim_rate, t0 = now_ns();
+	uint64_t t_end = t0 + (uint64_t)(sim_secs * 1e9);
+	uint8_t buf[512];
+
+	(void)arg;
+	for (unsigned i = 0; i < nr_units; ++i)
+		sims[i].next_ns = t0 + period * i / nr_units;
+	for (;;) {
+		uint64_t t = now_ns(), next = UINT64_MAX;
+		struct timespec ts;
+
+		if (t >= t_end)
+			break;
+		for (unsigned i = 0; i < nr_units; ++i) {
+			sim_t *s = &sims[i];
+
+			while (s->next_ns <= t) {
+				size_t n = sim_report(s, s->frames + s->frames_lost, buf);
+				ssize_t w = write(s->master, buf, n);
+
+				if (w == (ssize_t)n)
+					++s->frames;
+				else
+					++s->frames_lost;
+				s->next_ns += period;
+			}
+			if (s->next_ns < next)
+				next = s->next_ns;
+		}
+		if (next > t_end)
+			next = t_end;
+		ts.tv_sec = (time_t)(next / 1000000000u);
+		ts.tv_nsec = (long)(next % 1000000000u);
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+	}
+	sim_done = 1;
+	return NULL;
+}
+
+/// Stop the daemon two seconds after the feeder is done
+static void sim_tick(uint64_t tick)
+{
+	if (!sim_done)
+		return;
+	if (sim_done_tick == 0)
+		sim_done_tick = tick;
+	else if (tick >= sim_done_tick + 2)
+		stop_requested = 1;
+}
+
+/// Rows in all archives of a unit; -1 if one is damaged
+static int64_t unit_rows(const unit_t *u, uint64_t *no_fix)
+{
+	char dir[4096], path[8192];
+	struct dirent *de;
+	int64_t rows = 0;
+	DIR *d;
+
+	snprintf(dir, sizeof(dir), "%s/%s", opt_outdir, u->name);
+	if ((d = opendir(dir)) == NULL)
+		return -1;
+	while ((de = readdir(d)) != NULL) {
+		sarc_reader_t *r;
+		sarc_row_t row;
+		int ret;
+
+		if (strstr(de->d_name, ".sarc") == NULL)
+			continue;
+		snprintf(path, sizeof(path), "%s/%s", dir, de->d_name);
+		if ((r = sarc_open(path)) == NULL) {
+			rows = -1;
+			break;
+		}
+		while ((ret = sarc_next(r, &row)) == 1) {
+			++rows;
+			*no_fix += isnan(row.lat);
+		}
+		sarc_close_reader(r);
+		if (ret < 0) {
+			rows = -1;
+			break;
+		}
+	}
+	closedir(d);
+	return rows;
+}
+
+static int run_bench(unsigned n)
+{
+	static char (*paths)[32];
+	struct rusage *wru = calloc(opt_threads, sizeof(*wru)), mru;
+	uint64_t sent = 0, lost = 0, stored = 0, no_fix = 0, chunks = 0, lat_sum = 0, lat_max = 0;
+	uint64_t hist[INGESTD_LAT_BUCKETS] = { 0 };
+	unsigned bad_units = 0;
+	pthread_t feeder;
+	double wcpu = 0;
+
+	raise_fd_limit();
+	sims = calloc(n, sizeof(*sims));
+	units = calloc(n, sizeof(*units));
+	paths = calloc(n, sizeof(*paths));
+	if (sims == NULL || units == NULL || paths == NULL || wru == NULL) {
+		perror("calloc");
+		return 1;
+	}
+	for (unsigned i = 0; i < n; ++i) {
+		char arg[64];
+		int m = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC), fd;
+
+		if (m < 0 || grantpt(m) != 0 || unlockpt(m) != 0) {
+			perror("posix_openpt");
+			return 1;
+		}
+		snprintf(paths[i], sizeof(paths[i]), "%s", ptsname(m));
+		// Raw from the start: the feeder may write before the daemon opens it
+		if ((fd = open(paths[i], O_RDWR | O_NOCTTY)) >= 0) {
+			struct termios tio;
+
+			if (tcgetattr(fd, &tio) == 0) {
+				cfmakeraw(&tio);
+				tcsetattr(fd, TCSANOW, &tio);
+			}
+			close(fd);
+		}
+		snprintf(arg, sizeof(arg), "sim%03u=", i);
+		unit_set(&units[i], arg);
+		units[i].path = paths[i];
+		sims[i].master = m;
+		sims[i].lat = 14.55 + 0.001 * (i % 16);
+		sims[i].lon = 121.0 + 0.001 * (i / 16);
+		for (int k = 0; k < SARC_NR_PM; ++k)
+			sims[i].pm[k] = (uint16_t)(10 + 5 * k + rng_next() % 20);
+	}
+	nr_units = n;
+	tick_hook = sim_tick;
+
+	printf("ingestd bench: %u units at %u reports/s for %.0f s, %u workers -> %s\n",
+	       n, sim_rate, sim_secs, opt_threads, opt_outdir);
+	pthread_create(&feeder, NULL, sim_feeder, NULL);
+	if (run(wru, &mru) != 0)
+		return 1;
+	pthread_join(feeder, NULL);
+
+	for (unsigned i = 0; i < n; ++i) {
+		int64_t rows = unit_rows(&units[i], &no_fix);
+
+		sent += sims[i].frames;
+		lost += sims[i].frames_lost;
+		if (rows < 0 || (uint64_t)rows != sims[i].frames) {
+			if (bad_units++ < 5)
+				fprintf(stderr, "  %s: %lld rows stored, %llu frames sent\n",
+					units[i].name, (long long)rows,
+					(unsigned long long)sims[i].frames);
+		} else {
+			stored += (uint64_t)rows;
+		}
+		chunks += units[i].st.chunks;
+		lat_sum += units[i].st.lat_sum_us;
+		if (units[i].st.lat_max_us > lat_max)
+			lat_max = units[i].st.lat_max_us;
+		for (unsigned k = 0; k < INGESTD_LAT_BUCKETS; ++k)
+			hist[k] += units[i].st.lat_hist[k];
+	}
+	for (unsigned i = 0; i < opt_threads; ++i)
+		wcpu += wru[i].ru_utime.tv_sec + wru[i].ru_utime.tv_usec / 1e6 +
+			wru[i].ru_stime.tv_sec + wru[i].ru_stime.tv_usec / 1e6;
+
+	printf("  frames:    %llu sent (%llu lost to full ptys), %llu stored, %u units wrong\n",
+	       (unsigned long long)sent, (unsigned long long)lost,
+	       (unsigned long long)stored, bad_units);
+	printf("  positions: %llu rows without one (before a unit's first RMC)\n",
+	       (unsigned long long)no_fix);
+	printf("  latency:   read to archive writer: mean %.3f ms, p99 <= %.3f ms, max %.2f ms\n",
+	       chunks ? lat_sum / 1000.0 / chunks : 0.0, lat_pct_ms(hist, chunks, 99, lat_max),
+	       lat_max / 1000.0);
+	printf("  CPU:       reader %.2f s, workers %.2f s (%.2f us per row)\n",
+	       mru.ru_utime.tv_sec + mru.ru_utime.tv_usec / 1e6 +
+	       mru.ru_stime.tv_sec + mru.ru_stime.tv_usec / 1e6,
+	       wcpu, sent ? wcpu * 1e6 / sent : 0.0);
+	return bad_units ? 1 : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s -o OUTDIR [-j THREADS] [-b BAUD] [-R ROTATE_S] [-v SECONDS] [NAME=]DEVICE...\n"
+		"       %s -B -o OUTDIR [-n UNITS] [-r REPORTS_PER_S] [-t SECONDS] [-j THREADS]\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned nr_sims = 128;
+	int bench = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "o:j:b:R:v:Bn:r:t:h")) != -1) {
+		switch (c) {
+		case 'o': opt_outdir = optarg; break;
+		case 'j': opt_threads = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'b': opt_baud = strtol(optarg, NULL, 0); break;
+		case 'R': opt_rotate_s = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'v': opt_report = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'B': bench = 1; break;
+		case 'n': nr_sims = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'r': sim_rate = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 't': sim_secs = strtod(optarg, NULL); break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (opt_outdir == NULL || opt_threads == 0 || opt_rotate_s == 0 ||
+	    (bench ? nr_sims == 0 || sim_rate == 0 || sim_secs <= 0 : optind == argc)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (bench)
+		return run_bench(nr_sims);
+
+	nr_units = (unsigned)(argc - optind);
+	if ((units = calloc(nr_units, sizeof(*units))) == NULL) {
+		perror("calloc");
+		return 1;
+	}
+	for (unsigned i = 0; i < nr_units; ++i)
+		unit_set(&units[i], argv[optind + i]);
+	fprintf(stderr, "ingestd: %u units -> %s, %u workers\n", nr_units, opt_outdir, opt_threads);
+	return run(NULL, NULL);
+}
@@ -0,0 +1,1494 @@
+/**
+ * @file host/tools/livesrv.c
+ * @brief Serves the board's live data to browsers over SSE and WebSocket.
+ *
+ * Only one program can hold the CDC port, so live viewing used to mean one
+ * PuTTY window. This daemon owns the port (or a pty), decodes what the board
+ * sends once, and fans the samples out to any number of local viewers:
+ *
+ * - GET /        a small page that shows the latest reading
+ * - GET /events  Server-Sent Events: "event: pm" and "event: gps" messages
+ * - GET /ws      the same messages as WebSocket text frames
+ * - GET /stats   counters, as JSON
+ *
+ * Each sample is decoded with the firmware's own decoders (the NMEA sentence
+ * assembler in src/parsers/nmea_parse.c, the PMS frame parser in
+ * src/parsers/pms_parser.c) and formatted once, into a reference-counted
+ * message holding both its SSE and its WebSocket encoding. Viewers queue
+ * references to it, so the cost per viewer is one pointer and a share of a
+ * writev().
+ *
+ * Every viewer has a bounded queue (-q messages). A viewer that reads more
+ * slowly than samples arrive loses its oldest queued samples, and is never
+ * allowed to hold up the port or the other viewers. -w caps the kernel's
+ * send buffer of each viewer, which bounds the memory hundreds of stalled
+ * viewers can pin and makes them skip to fresh samples sooner. Everything (the port,
+ * the listening socket, the viewers and a 1 s timer) runs in one epoll loop
+ * with non-blocking sockets.
+ *
+ * With -B the tool instead benchmarks itself: it starts the server on a pty
+ * in a child process, connects the given number of SSE and WebSocket
+ * viewers (some of them deliberately stalled) and feeds PMS frames at a
+ * given rate, then reports the delivery latency, the drops and the server's
+ * CPU time.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -Ihost/lib -o livesrv host/tools/livesrv.c \
+ *      host/lib/sdec.c src/parsers/nmea_parse.c src/parsers/pms_parser.c
+ */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parsers/nmea_parser.h"
+#include "parsers/pms_parser.h"
+#include "sdec.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define LIVESRV_KEEPALIVE_S	15	// Idle SSE comment / WebSocket ping
+#define LIVESRV_REQ_TIMEOUT_S	10	// To send a whole request
+#define LIVESRV_IN_MAX		2048	// Request, or incoming WebSocket frames
+
+static const char *opt_dev;
+static long opt_baud = 9600;
+static unsigned opt_queue = 256;
+static unsigned opt_report;		// Seconds between stats lines; 0: none
+static int opt_sndbuf;			// Socket send buffer per viewer; 0: the kernel's
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	stop_requested = 1;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int64_t wall_ms(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/// Let this process have as many descriptors as the hard limit allows
+static void raise_fd_limit(void)
+{
+	struct rlimit rl;
+
+	if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < rl.rlim_max) {
+		rl.rlim_cur = rl.rlim_max;
+		setrlimit(RLIMIT_NOFILE, &rl);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// SHA-1 and base64, for the WebSocket handshake (RFC 6455 section 4.2.2)
+
+static uint32_t rol32(uint32_t x, int n)
+{
+	return (x << n) | (x >> (32 - n));
+}
+
+static void sha1_block(uint32_t h[5], const uint8_t *p)
+{
+	uint32_t w[80], a, b, c, d, e, f, k, t;
+
+	for (int i = 0; i < 16; ++i)
+		w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16 |
+		       (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+	for (int i = 16; i < 80; ++i)
+		w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+	a = h[0]; b = h[1]; c = h[2]; d = h[3]; e = h[4];
+	for (int i = 0; i < 80; ++i) {
+		if (i < 20) {
+			f = (b & c) | (~b & d);
+			k = 0x5A827999;
+		} else if (i < 40) {
+			f = b ^ c ^ d;
+			k = 0x6ED9EBA1;
+		} else if (i < 60) {
+			f = (b & c) | (b & d) | (c & d);
+			k = 0x8F1BBCDC;
+		} else {
+			f = b ^ c ^ d;
+			k = 0xCA62C1D6;
+		}
+		t = rol32(a, 5) + f + e + k + w[i];
+		e = d;
+		d = c;
+		c = rol32(b, 30);
+		b = a;
+		a = t;
+	}
+	h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+}
+
+static void sha1(const void *data, size_t len, uint8_t out[20])
+{
+	uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+	const uint8_t *p = data;
+	uint8_t tail[128] = { 0 };
+	size_t full = len & ~(size_t)63, rest = len - full, tail_len;
+	uint64_t bits = (uint64_t)len * 8;
+
+	for (size_t i = 0; i < full; i += 64)
+		sha1_block(h, p + i);
+	memcpy(tail, p + full, rest);
+	tail[rest] = 0x80;
+	tail_len = rest < 56 ? 64 : 128;
+	for (int i = 0; i < 8; ++i)
+		tail[tail_len - 1 - i] = (uint8_t)(bits >> (8 * i));
+	sha1_block(h, tail);
+	if (tail_len == 128)
+		sha1_block(h, tail + 64);
+	for (int i = 0; i < 5; ++i) {
+		out[4 * i] = (uint8_t)(h[i] >> 24);
+		out[4 * i + 1] = (uint8_t)(h[i] >> 16);
+		out[4 * i + 2] = (uint8_t)(h[i] >> 8);
+		out[4 * i + 3] = (uint8_t)h[i];
+	}
+}
+
+/// Base64 of @p len bytes; @p out needs 4 * ((len + 2) / 3) + 1 bytes
+static void base64(const uint8_t *p, size_t len, char *out)
+{
+	static const char tab[] =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	size_t i;
+
+	for (i = 0; i + 2 < len; i += 3) {
+		*out++ = tab[p[i] >> 2];
+		*out++ = tab[(p[i] & 3) << 4 | p[i + 1] >> 4];
+		*out++ = tab[(p[i + 1] & 15) << 2 | p[i + 2] >> 6];
+		*out++ = tab[p[i + 2] & 63];
+	}
+	if (i < len) {
+		*out++ = tab[p[i] >> 2];
+		if (i + 1 < len) {
+			*out++ = tab[(p[i] & 3) << 4 | p[i + 1] >> 4];
+			*out++ = tab[(p[i + 1] & 15) << 2];
+		} else {
+			*out++ = tab[(p[i] & 3) << 4];
+			*out++ = '=';
+		}
+		*out++ = '=';
+	}
+	*out = '\0';
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Messages
+
+enum { ENC_SSE, ENC_WS };
+
+/// An outgoing message, shared by every viewer that queues it
+typedef struct msg_type {
+	unsigned    refs;
+	bool        pinned;		// Never dropped (response headers)
+	const char *buf[2];		// By ENC_*
+	uint32_t    len[2];
+	char        data[];
+} msg_t;
+
+static msg_t *msg_alloc(size_t size)
+{
+	msg_t *m = malloc(sizeof(*m) + size);
+
+	if (m == NULL) {
+		perror("malloc");
+		exit(1);
+	}
+	m->refs = 1;
+	m->pinned = false;
+	return m;
+}
+
+static void msg_unref(msg_t *m)
+{
+	if (m && --m->refs == 0)
+		free(m);
+}
+
+/// A message sent as is, whatever the encoding
+static msg_t *msg_raw(const void *p, size_t len)
+{
+	msg_t *m = msg_alloc(len);
+
+	memcpy(m->data, p, len);
+	m->buf[ENC_SSE] = m->buf[ENC_WS] = m->data;
+	m->len[ENC_SSE] = m->len[ENC_WS] = (uint32_t)len;
+	return m;
+}
+
+/// Length of a WebSocket frame header for a payload of @p len bytes
+static size_t ws_hdr(uint8_t *h, unsigned opcode, size_t len)
+{
+	h[0] = (uint8_t)(0x80 | opcode);
+	if (len < 126) {
+		h[1] = (uint8_t)len;
+		return 2;
+	}
+	if (len < 65536) {
+		h[1] = 126;
+		h[2] = (uint8_t)(len >> 8);
+		h[3] = (uint8_t)len;
+		return 4;
+	}
+	h[1] = 127;
+	for (int i = 0; i < 8; ++i)
+		h[2 + i] = (uint8_t)((uint64_t)len >> (56 - 8 * i));
+	return 10;
+}
+
+/// A data event: "event: TYPE" for SSE, a text frame for WebSocket
+static msg_t *msg_event(const char *type, uint64_t seq, const char *json, size_t len)
+{
+	msg_t *m = msg_alloc(64 + len + 14 + len);
+	char *p = m->data;
+	int n;
+
+	n = sprintf(p, "id: %llu\nevent: %s\ndata: ", (unsigned long long)seq, type);
+	memcpy(p + n, json, len);
+	memcpy(p + n + len, "\n\n", 2);
+	m->buf[ENC_SSE] = p;
+	m->len[ENC_SSE] = (uint32_t)(n + len + 2);
+
+	p += m->len[ENC_SSE];
+	n = (int)ws_hdr((uint8_t *)p, 0x1, len);
+	memcpy(p + n, json, len);
+	m->buf[ENC_WS] = p;
+	m->len[ENC_WS] = (uint32_t)(n + len);
+	return m;
+}
+
+/// An SSE comment / a WebSocket ping, which keeps proxies and idle tabs open
+static msg_t *msg_keepalive(void)
+{
+	static const char sse[] = ": keepalive\n\n";
+	static const uint8_t ping[] = { 0x89, 0x00 };
+	msg_t *m = msg_alloc(sizeof(sse) + sizeof(ping));
+
+	memcpy(m->data, sse, sizeof(sse) - 1);
+	memcpy(m->data + sizeof(sse) - 1, ping, sizeof(ping));
+	m->buf[ENC_SSE] = m->data;
+	m->len[ENC_SSE] = sizeof(sse) - 1;
+	m->buf[ENC_WS] = m->data + sizeof(sse) - 1;
+	m->len[ENC_WS] = sizeof(ping);
+	return m;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Viewers
+
+enum client_state {
+	CL_HTTP,		// Reading the request
+	CL_SSE,			// Subscribed
+	CL_WS,			// Subscribed
+	CL_DONE			// Sending a last response, then closing
+};
+
+typedef struct client_type {
+	int      fd;
+	enum client_state state;
+	uint64_t since;		// Timer tick it connected at
+
+	char     in[LIVESRV_IN_MAX];
+	size_t   in_len;
+
+	// Queue: a ring of opt_queue message references
+	msg_t  **q;
+	unsigned head, count;
+	size_t   off;		// Bytes of q[head] already sent
+	bool     want_out;	// Waiting for EPOLLOUT
+
+	int      sub_idx;	// In subs[], or -1
+	int      dirty_idx;	// In dirty[], or -1
+
+	uint64_t sent, dropped;
+} client_t;
+
+static int epfd = -1, listen_fd = -1, serial_fd = -1, timer_fd = -1;
+
+static client_t **by_fd;	// Viewers by descriptor
+static int nr_by_fd;
+
+static client_t **subs;		// Subscribed viewers
+static int nr_subs, max_subs;
+
+static client_t **dirty;	// Viewers with newly queued messages
+static int nr_dirty, max_dirty;
+
+static uint64_t tick;
+
+/// Server counters
+static struct {
+	uint64_t bytes_in, nmea, nmea_bad, pms, pms_bad;
+	uint64_t events, queued, drops, bytes_out;
+	uint64_t accepted, peak;
+	int      nr_clients, nr_sse, nr_ws;
+} st;
+
+static void *grow(void *p, int *max, size_t elem)
+{
+	*max = *max ? *max * 2 : 64;
+	p = realloc(p, (size_t)*max * elem);
+	if (p == NULL) {
+		perror("realloc");
+		exit(1);
+	}
+	return p;
+}
+
+static void client_want_out(client_t *c, bool on)
+{
+	struct epoll_event ev = { .events = EPOLLIN | (on ? EPOLLOUT : 0), .data.fd = c->fd };
+
+	if (c->want_out == on)
+		return;
+	c->want_out = on;
+	epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+}
+
+static void client_unsubscribe(client_t *c)
+{
+	if (c->sub_idx < 0)
+		return;
+	subs[c->sub_idx] = subs[--nr_subs];
+	subs[c->sub_idx]->sub_idx = c->sub_idx;
+	c->sub_idx = -1;
+	if (c->state == CL_SSE)
+		--st.nr_sse;
+	else
+		--st.nr_ws;
+}
+
+static void client_close(client_t *c)
+{
+	client_unsubscribe(c);
+	if (c->dirty_idx >= 0)
+		dirty[c->dirty_idx] = NULL;
+	while (c->count) {
+		msg_unref(c->q[c->head]);
+		c->head = (c->head + 1) % opt_queue;
+		--c->count;
+	}
+	by_fd[c->fd] = NULL;
+	close(c->fd);
+	--st.nr_clients;
+	free(c->q);
+	free(c);
+}
+
+/// Drop the oldest message that has not started to go out and is not pinned
+static bool client_drop_oldest(client_t *c)
+{
+	for (unsigned i = 0; i < c->count; ++i) {
+		unsigned at = (c->head + i) % opt_queue;
+
+		if ((i == 0 && c->off > 0) || c->q[at]->pinned)
+			continue;
+		msg_unref(c->q[at]);
+		for (unsigned j = i; j + 1 < c->count; ++j)
+			c->q[(c->head + j) % opt_queue] = c->q[(c->head + j + 1) % opt_queue];
+		--c->count;
+		++c->dropped;
+		++st.drops;
+		return true;
+	}
+	return false;
+}
+
+/// Queue a message; it goes out on the next flush
+static void client_push(client_t *c, msg_t *m)
+{
+	if (c->count == opt_queue && !client_drop_oldest(c))
+		return;
+	++m->refs;
+	c->q[(c->head + c->count) % opt_queue] = m;
+	++c->count;
+	++st.queued;
+	if (c->dirty_idx < 0) {
+		if (nr_dirty == max_dirty)
+			dirty = grow(dirty, &max_dirty, sizeof(*dirty));
+		c->dirty_idx = nr_dirty;
+		dirty[nr_dirty++] = c;
+	}
+}
+
+/**
+ * Write as much of the queue as the socket takes
+ *
+ * @return	false if the viewer was closed
+ */
+static bool client_flush(client_t *c)
+{
+	int enc = c->state == CL_WS ? ENC_WS : ENC_SSE;
+
+	while (c->count) {
+		struct iovec iov[32];
+		int n = 0;
+		ssize_t w;
+
+		for (unsigned i = 0; i < c->count && n < 32; ++i) {
+			const msg_t *m = c->q[(c->head + i) % opt_queue];
+			size_t skip = i == 0 ? c->off : 0;
+
+			iov[n].iov_base = (char *)m->buf[enc] + skip;
+			iov[n].iov_len = m->len[enc] - skip;
+			++n;
+		}
+		w = writev(c->fd, iov, n);
+		if (w < 0) {
+			if (errno == EINTR)
+				continue;
+			if (errno == EAGAIN || errno == EWOULDBLOCK) {
+				client_want_out(c, true);
+				return true;
+			}
+			client_close(c);
+			return false;
+		}
+		st.bytes_out += (uint64_t)w;
+		while (w > 0) {
+			msg_t *m = c->q[c->head];
+			size_t left = m->len[enc] - c->off;
+
+			if ((size_t)w < left) {
+				c->off += (size_t)w;
+				break;
+			}
+			w -= (ssize_t)left;
+			msg_unref(m);
+			c->head = (c->head + 1) % opt_queue;
+			--c->count;
+			c->off = 0;
+			++c->sent;
+		}
+	}
+	client_want_out(c, false);
+	if (c->state == CL_DONE) {
+		client_close(c);
+		return false;
+	}
+	return true;
+}
+
+/// Flush every viewer that had something queued since the last call
+static void flush_dirty(void)
+{
+	for (int i = 0; i < nr_dirty; ++i) {
+		client_t *c = dirty[i];
+
+		if (c == NULL)
+			continue;
+		c->dirty_idx = -1;
+		if (!c->want_out)
+			client_flush(c);
+	}
+	nr_dirty = 0;
+}
+
+/// Queue a message for every subscribed viewer
+static void broadcast(msg_t *m)
+{
+	for (int i = 0; i < nr_subs; ++i)
+		client_push(subs[i], m);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Decoding
+
+/// What the last GLL or RMC sentence said
+typedef struct fix_type {
+	bool   known;		// A GLL or RMC sentence was seen
+	bool   valid;		// ... and the receiver had a fix
+	double lat, lon;
+	char   utc[16];		// "hh:mm:ss", or empty
+} fix_t;
+
+static nmea_sentence_state_t nmea;
+static pms_parser_internal_state_t pms;
+static fix_t fix;
+static uint64_t seq;
+static msg_t *latest_pm, *latest_gps;	// Sent to new viewers straight away
+
+/// Update the fix from a GLL or RMC sentence; false for any other sentence
+static bool fix_update(const char *s)
+{
+	sdec_fix_t fx;
+
+	if (!sdec_nmea_fix(s, strlen(s), &fx) || strcmp(fx.type, "GGA") == 0)
+		return false;
+
+	fix.known = true;
+	fix.valid = !isnan(fx.lat);
+	if (fix.valid) {
+		fix.lat = fx.lat;
+		fix.lon = fx.lon;
+	}
+	if (fx.tod_len >= 6)
+		snprintf(fix.utc, sizeof(fix.utc), "%.2s:%.2s:%.2s", fx.tod, fx.tod + 2, fx.tod + 4);
+	else
+		fix.utc[0] = '\0';
+	return true;
+}
+
+static int json_pos(char *p, size_t size)
+{
+	if (!fix.valid)
+		return snprintf(p, size, "\"lat\":null,\"lon\":null");
+	return snprintf(p, size, "\"lat\":%.7f,\"lon\":%.7f", fix.lat, fix.lon);
+}
+
+/// Format an event once, queue it for every viewer and keep it for newcomers
+static void publish(const char *type, const char *json, size_t len, msg_t **latest)
+{
+	msg_t *m = msg_event(type, seq, json, len);
+
+	++st.events;
+	broadcast(m);
+	msg_unref(*latest);
+	*latest = m;		// Takes the reference msg_event() returned
+}
+
+static void on_sentence(const char *s)
+{
+	char json[256];
+	int n;
+
+	if (!sdec_nmea_checksum_ok(s)) {
+		++st.nmea_bad;
+		return;
+	}
+	++st.nmea;
+	if (!fix_update(s))
+		return;
+	++seq;
+	n = snprintf(json, sizeof(json), "{\"type\":\"gps\",\"seq\":%llu,\"t\":%lld,\"utc\":\"%s\",\"fix\":%s,",
+		     (unsigned long long)seq, (long long)wall_ms(), fix.utc,
+		     fix.valid ? "true" : "false");
+	n += json_pos(json + n, sizeof(json) - (size_t)n);
+	json[n++] = '}';
+	publish("gps", json, (size_t)n, &latest_gps);
+}
+
+static void on_frame(const pms_data_t *d)
+{
+	char json[384];
+	int n;
+
+	++seq;
+	n = snprintf(json, sizeof(json),
+		     "{\"type\":\"pm\",\"seq\":%llu,\"t\":%lld,\"pm\":[%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u,%u],",
+		     (unsigned long long)seq, (long long)wall_ms(),
+		     d->pm1_0_std, d->pm2_5_std, d->pm10_std,
+		     d->pm1_0_atm, d->pm2_5_atm, d->pm10_atm,
+		     d->particles_0_3um, d->particles_0_5um, d->particles_1_0um,
+		     d->particles_2_5um, d->particles_5_0um, d->particles_10um);
+	n += json_pos(json + n, sizeof(json) - (size_t)n);
+	json[n++] = '}';
+	publish("pm", json, (size_t)n, &latest_pm);
+}
+
+/// Feed port bytes to both decoders; either ignores the other's data
+static void decode(const uint8_t *buf, size_t len)
+{
+	pms_data_t d;
+
+	st.bytes_in += len;
+	for (size_t i = 0; i < len; ++i) {
+		const char *s = nmea_sentence_feed(&nmea, (char)buf[i]);
+		pms_parser_status_t ps;
+
+		if (s)
+			on_sentence(s);
+		ps = pms_parser_feed_byte(NULL, &pms, buf[i], &d);
+		if (ps == PMS_PARSER_OK) {
+			++st.pms;
+			on_frame(&d);
+		} else if (ps == PMS_PARSER_CHECKSUM_ERROR ||
+			   ps == PMS_PARSER_INVALID_LENGTH ||
+			   ps == PMS_PARSER_BUFFER_OVERFLOW) {
+			++st.pms_bad;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// The port
+
+static speed_t baud_to_speed(long baud)
+{
+	switch (baud) {
+	case 9600:   return B9600;
+	case 19200:  return B19200;
+	case 38400:  return B38400;
+	case 57600:  return B57600;
+	case 115200: return B115200;
+	default:     return B0;
+	}
+}
+
+static int serial_open(const char *path, long baud, bool quiet)
+{
+	struct termios tio;
+	struct epoll_event ev = { .events = EPOLLIN };
+	int fd = open(path, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+
+	if (fd < 0) {
+		if (!quiet)
+			perror(path);
+		return -1;
+	}
+	if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+		cfmakeraw(&tio);
+		if (baud_to_speed(baud) != B0) {
+			cfsetispeed(&tio, baud_to_speed(baud));
+			cfsetospeed(&tio, baud_to_speed(baud));
+		}
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	ev.data.fd = fd;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+	nmea_sentence_init(&nmea);
+	pms_parser_init(&pms);
+	return fd;
+}
+
+static void serial_read(void)
+{
+	uint8_t buf[4096];
+
+	for (;;) {
+		ssize_t n = read(serial_fd, buf, sizeof(buf));
+
+		if (n > 0) {
+			decode(buf, (size_t)n);
+			continue;
+		}
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		// EOF, or EIO once a pty's other end or a USB port goes away
+		fprintf(stderr, "livesrv: %s closed; reopening\n", opt_dev);
+		close(serial_fd);
+		serial_fd = -1;
+		break;
+	}
+	flush_dirty();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// HTTP and WebSocket
+
+static const char page[] =
+	"<!doctype html>\n<meta charset=utf-8>\n<title>PM live</title>\n"
+	"<pre id=o>Waiting for data...</pre>\n<script>\n"
+	"var o = document.getElementById('o'), g = 'no GPS data';\n"
+	"var es = new EventSource('/events');\n"
+	"es.addEventListener('gps', function (e) {\n"
+	"  var d = JSON.parse(e.data);\n"
+	"  g = d.utc + ' UTC  ' + (d.fix ? d.lat.toFixed(6) + ', ' + d.lon.toFixed(6) : 'no fix');\n"
+	"});\n"
+	"es.addEventListener('pm', function (e) {\n"
+	"  var d = JSON.parse(e.data);\n"
+	"  o.textContent = 'PM1.0 ' + d.pm[3] + '  PM2.5 ' + d.pm[4] + '  PM10 ' + d.pm[5] +\n"
+	"    ' ug/m3\\n' + g + '\\n#' + d.seq;\n"
+	"});\n"
+	"</script>\n";
+
+/// Value of a request header, trimmed; false if there is none
+static bool header_get(const char *req, const char *name, char *out, size_t size)
+{
+	size_t nlen = strlen(name);
+	const char *p = strstr(req, "\r\n");
+
+	while (p && p[2] != '\r' && p[2] != '\0') {
+		const char *line = p + 2, *end = strstr(line, "\r\n");
+
+		if (end == NULL)
+			break;
+		if (strncasecmp(line, name, nlen) == 0 && line[nlen] == ':') {
+			const char *v = line + nlen + 1;
+			size_t len;
+
+			while (*v == ' ' || *v == '\t')
+				++v;
+			len = (size_t)(end - v);
+			while (len && (v[len - 1] == ' ' || v[len - 1] == '\t'))
+				--len;
+			if (len >= size)
+				return false;
+			memcpy(out, v, len);
+			out[len] = '\0';
+			return true;
+		}
+		p = end;
+	}
+	return false;
+}
+
+/// A complete response; the connection closes once it is sent
+static void respond(client_t *c, const char *status, const char *type,
+		    const char *body, size_t len)
+{
+	char hdr[256];
+	int n = snprintf(hdr, sizeof(hdr),
+			 "HTTP/1.1 %s\r\nContent-Type: %s\r\nContent-Length: %zu\r\n"
+			 "Cache-Control: no-cache\r\nConnection: close\r\n\r\n",
+			 status, type, len);
+	msg_t *m = msg_alloc((size_t)n + len);
+
+	memcpy(m->data, hdr, (size_t)n);
+	memcpy(m->data + n, body, len);
+	m->buf[ENC_SSE] = m->buf[ENC_WS] = m->data;
+	m->len[ENC_SSE] = m->len[ENC_WS] = (uint32_t)(n + len);
+	m->pinned = true;
+	c->state = CL_DONE;
+	client_push(c, m);
+	msg_unref(m);
+}
+
+static void respond_stats(client_t *c)
+{
+	char body[512];
+	int n = snprintf(body, sizeof(body),
+			 "{\"port\":%s,\"clients\":%d,\"sse\":%d,\"ws\":%d,\"peak_clients\":%llu,"
+			 "\"accepted\":%llu,\"bytes_in\":%llu,\"nmea\":%llu,\"nmea_bad\":%llu,"
+			 "\"pms\":%llu,\"pms_bad\":%llu,\"events\":%llu,\"queued\":%llu,"
+			 "\"drops\":%llu,\"bytes_out\":%llu}\n",
+			 serial_fd >= 0 ? "true" : "false", st.nr_clients, st.nr_sse, st.nr_ws,
+			 (unsigned long long)st.peak, (unsigned long long)st.accepted,
+			 (unsigned long long)st.bytes_in, (unsigned long long)st.nmea,
+			 (unsigned long long)st.nmea_bad, (unsigned long long)st.pms,
+			 (unsigned long long)st.pms_bad, (unsigned long long)st.events,
+			 (unsigned long long)st.queued, (unsigned long long)st.drops,
+			 (unsigned long long)st.bytes_out);
+
+	respond(c, "200 OK", "application/json", body, (size_t)n);
+}
+
+/// Start streaming: the response headers, then the latest samples
+static void subscribe(client_t *c, enum client_state state, const char *hdr, size_t len)
+{
+	msg_t *m = msg_raw(hdr, len);
+
+	m->pinned = true;
+	client_push(c, m);
+	msg_unref(m);
+	if (latest_gps)
+		client_push(c, latest_gps);
+	if (latest_pm)
+		client_push(c, latest_pm);
+
+	c->state = state;
+	if (nr_subs == max_subs)
+		subs = grow(subs, &max_subs, sizeof(*subs));
+	c->sub_idx = nr_subs;
+	subs[nr_subs++] = c;
+	if (state == CL_SSE)
+		++st.nr_sse;
+	else
+		++st.nr_ws;
+}
+
+static void handle_request(client_t *c)
+{
+	static const char sse_hdr[] =
+		"HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\n"
+		"Cache-Control: no-cache\r\nConnection: keep-alive\r\n"
+		"Access-Control-Allow-Origin: *\r\n\r\nretry: 2000\n\n";
+	static const char ws_guid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+	char method[8], path[256], value[128];
+
+	if (sscanf(c->in, "%7s %255s", method, path) != 2) {
+		respond(c, "400 Bad Request", "text/plain", "bad request\n", 12);
+		return;
+	}
+	path[strcspn(path, "?")] = '\0';
+	if (strcmp(method, "GET") != 0) {
+		respond(c, "405 Method Not Allowed", "text/plain", "GET only\n", 9);
+	} else if (strcmp(path, "/") == 0) {
+		respond(c, "200 OK", "text/html; charset=utf-8", page, sizeof(page) - 1);
+	} else if (strcmp(path, "/stats") == 0) {
+		respond_stats(c);
+	} else if (strcmp(path, "/events") == 0) {
+		subscribe(c, CL_SSE, sse_hdr, sizeof(sse_hdr) - 1);
+	} else if (strcmp(path, "/ws") == 0) {
+		char key[128], accept[32], hdr[256];
+		uint8_t digest[20];
+		int n;
+
+		if (!header_get(c->in, "Upgrade", value, sizeof(value)) ||
+		    strcasecmp(value, "websocket") != 0 ||
+		    !header_get(c->in, "Sec-WebSocket-Key", value, sizeof(value)) ||
+		    strlen(value) + sizeof(ws_guid) > sizeof(key)) {
+			respond(c, "400 Bad Request", "text/plain", "WebSocket upgrade expected\n", 27);
+			return;
+		}
+		snprintf(key, sizeof(key), "%s%s", value, ws_guid);
+		sha1(key, strlen(key), digest);
+		base64(digest, sizeof(digest), accept);
+		n = snprintf(hdr, sizeof(hdr),
+			     "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n"
+			     "Connection: Upgrade\r\nSec-WebSocket-Accept: %s\r\n\r\n", accept);
+		subscribe(c, CL_WS, hdr, (size_t)n);
+	} else {
+		respond(c, "404 Not Found", "text/plain", "not found\n", 10);
+	}
+}
+
+/// Handle the frames a WebSocket viewer sends: close and ping; the rest is ignored
+static void ws_input(client_t *c)
+{
+	size_t pos = 0;
+
+	while (c->in_len - pos >= 2) {
+		uint8_t *p = (uint8_t *)c->in + pos, hdr[4];
+		unsigned op = p[0] & 0x0f;
+		size_t len = p[1] & 0x7f, hl = 2;
+
+		if (!(p[1] & 0x80) || len == 127) {
+			// Unmasked, or larger than we take: not a viewer we can serve
+			c->state = CL_DONE;
+			break;
+		}
+		if (len == 126) {
+			if (c->in_len - pos < 4)
+				break;
+			len = (size_t)p[2] << 8 | p[3];
+			hl = 4;
+		}
+		// client_read() keeps a byte for the terminator; a frame must fit in the rest
+		if (hl + 4 + len > sizeof(c->in) - 1) {
+			c->state = CL_DONE;
+			break;
+		}
+		if (c->in_len - pos < hl + 4 + len)
+			break;
+		for (size_t i = 0; i < len; ++i)
+			p[hl + 4 + i] ^= p[hl + i % 4];
+
+		if (op == 0x8) {
+			static const uint8_t close_frame[] = { 0x88, 0x00 };
+			msg_t *m = msg_raw(close_frame, sizeof(close_frame));
+
+			client_unsubscribe(c);
+			c->state = CL_DONE;
+			client_push(c, m);
+			msg_unref(m);
+			break;
+		}
+		if (op == 0x9 && len < 126) {
+			uint8_t pong[2 + 125];
+			msg_t *m;
+
+			ws_hdr(hdr, 0xA, len);
+			memcpy(pong, hdr, 2);
+			memcpy(pong + 2, p + hl + 4, len);
+			m = msg_raw(pong, 2 + len);
+			client_push(c, m);
+			msg_unref(m);
+		}
+		pos += hl + 4 + len;
+	}
+	memmove(c->in, c->in + pos, c->in_len - pos);
+	c->in_len -= pos;
+	if (c->state == CL_DONE)
+		client_unsubscribe(c);
+}
+
+static void client_read(client_t *c)
+{
+	for (;;) {
+		ssize_t n;
+		char *end;
+
+		// Past the request, input is only drained; keep room to read it into
+		if (c->state == CL_SSE || c->state == CL_DONE)
+			c->in_len = 0;
+		n = read(c->fd, c->in + c->in_len, sizeof(c->in) - 1 - c->in_len);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			break;
+		if (n <= 0) {
+			client_close(c);
+			return;
+		}
+		if (c->state == CL_SSE || c->state == CL_DONE)
+			continue;	// Nothing more is expected; discard
+		c->in_len += (size_t)n;
+		c->in[c->in_len] = '\0';
+
+		if (c->state == CL_WS) {
+			ws_input(c);
+		} else if ((end = strstr(c->in, "\r\n\r\n")) != NULL) {
+			size_t req_len = (size_t)(end - c->in) + 4;
+
+			end[2] = '\0';
+			handle_request(c);
+			// A WebSocket viewer may send frames right behind the request
+			memmove(c->in, c->in + req_len, c->in_len - req_len);
+			c->in_len -= req_len;
+			if (c->state == CL_WS)
+				ws_input(c);
+		} else if (c->in_len == sizeof(c->in) - 1) {
+			respond(c, "431 Request Header Fields Too Large", "text/plain",
+				"request too large\n", 18);
+			break;	// Sent below; a full buffer would read as EOF
+		}
+	}
+	if (c->state == CL_DONE && c->count == 0)
+		client_close(c);
+	else if (c->dirty_idx >= 0 && !c->want_out)
+		client_flush(c);
+}
+
+static void accept_clients(void)
+{
+	for (;;) {
+		int fd = accept4(listen_fd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+		struct epoll_event ev = { .events = EPOLLIN };
+		client_t *c;
+		int one = 1;
+
+		if (fd < 0) {
+			if (errno == EINTR || errno == ECONNABORTED)
+				continue;
+			if (errno == EMFILE || errno == ENFILE)
+				fprintf(stderr, "livesrv: out of descriptors at %d viewers\n",
+					st.nr_clients);
+			return;
+		}
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+		if (opt_sndbuf)
+			setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &opt_sndbuf, sizeof(opt_sndbuf));
+		if ((c = calloc(1, sizeof(*c))) == NULL ||
+		    (c->q = malloc(opt_queue * sizeof(*c->q))) == NULL) {
+			perror("malloc");
+			exit(1);
+		}
+		c->fd = fd;
+		c->state = CL_HTTP;
+		c->since = tick;
+		c->sub_idx = c->dirty_idx = -1;
+		while (fd >= nr_by_fd) {
+			int old = nr_by_fd;
+
+			by_fd = grow(by_fd, &nr_by_fd, sizeof(*by_fd));
+			memset(by_fd + old, 0, (size_t)(nr_by_fd - old) * sizeof(*by_fd));
+		}
+		by_fd[fd] = c;
+		ev.data.fd = fd;
+		epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+		++st.accepted;
+		if ((uint64_t)++st.nr_clients > st.peak)
+			st.peak = (uint64_t)st.nr_clients;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Server
+
+static void on_tick(void)
+{
+	static uint64_t last_events, last_out;
+
+	++tick;
+	if (serial_fd < 0)
+		serial_fd = serial_open(opt_dev, opt_baud, true);
+	if (tick % LIVESRV_KEEPALIVE_S == 0) {
+		msg_t *m = msg_keepalive();
+
+		broadcast(m);
+		msg_unref(m);
+	}
+	for (int fd = 0; fd < nr_by_fd; ++fd) {
+		client_t *c = by_fd[fd];
+
+		if (c && c->state == CL_HTTP && tick - c->since > LIVESRV_REQ_TIMEOUT_S)
+			client_close(c);
+	}
+	flush_dirty();
+
+	if (opt_report && tick % opt_report == 0) {
+		fprintf(stderr,
+			"[livesrv] viewers %d (sse %d, ws %d) | events %llu (+%llu) | drops %llu | "
+			"%llu B/s out | port %s, pms bad %llu, nmea bad %llu\n",
+			st.nr_clients, st.nr_sse, st.nr_ws,
+			(unsigned long long)st.events,
+			(unsigned long long)(st.events - last_events),
+			(unsigned long long)st.drops,
+			(unsigned long long)((st.bytes_out - last_out) / opt_report),
+			serial_fd >= 0 ? "open" : "closed",
+			(unsigned long long)st.pms_bad, (unsigned long long)st.nmea_bad);
+		last_events = st.events;
+		last_out = st.bytes_out;
+	}
+}
+
+static int serve(int lfd)
+{
+	struct sigaction sa = { .sa_handler = on_signal };
+	struct itimerspec its = { { 1, 0 }, { 1, 0 } };
+	struct epoll_event ev = { .events = EPOLLIN };
+	struct epoll_event evs[256];
+
+	signal(SIGPIPE, SIG_IGN);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	raise_fd_limit();
+
+	listen_fd = lfd;
+	if ((epfd = epoll_create1(EPOLL_CLOEXEC)) < 0 ||
+	    (timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC)) < 0) {
+		perror("epoll");
+		return 1;
+	}
+	timerfd_settime(timer_fd, 0, &its, NULL);
+	ev.data.fd = listen_fd;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, listen_fd, &ev);
+	ev.data.fd = timer_fd;
+	epoll_ctl(epfd, EPOLL_CTL_ADD, timer_fd, &ev);
+	if ((serial_fd = serial_open(opt_dev, opt_baud, false)) < 0)
+		fprintf(stderr, "livesrv: waiting for %s\n", opt_dev);
+
+	while (!stop_requested) {
+		int n = epoll_wait(epfd, evs, sizeof(evs) / sizeof(evs[0]), -1);
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0) {
+			perror("epoll_wait");
+			return 1;
+		}
+		for (int i = 0; i < n; ++i) {
+			int fd = evs[i].data.fd;
+			client_t *c;
+
+			if (fd == listen_fd) {
+				accept_clients();
+			} else if (fd == timer_fd) {
+				uint64_t expirations;
+
+				if (read(timer_fd, &expirations, sizeof(expirations)) > 0)
+					on_tick();
+			} else if (fd == serial_fd) {
+				serial_read();
+			} else if (fd < nr_by_fd && (c = by_fd[fd]) != NULL) {
+				if (evs[i].events & (EPOLLERR | EPOLLHUP)) {
+					client_close(c);
+					continue;
+				}
+				if ((evs[i].events & EPOLLOUT) && !client_flush(c))
+					continue;
+				if (evs[i].events & EPOLLIN)
+					client_read(c);
+			}
+		}
+	}
+	fprintf(stderr, "livesrv: %llu events, %llu viewers served, %llu drops\n",
+		(unsigned long long)st.events, (unsigned long long)st.accepted,
+		(unsigned long long)st.drops);
+	return 0;
+}
+
+/// Listening socket on "[ADDR:]PORT"; port 0 picks a free one
+static int listen_on(const char *spec)
+{
+	struct sockaddr_in sin = { .sin_family = AF_INET };
+	const char *colon = strrchr(spec, ':');
+	char addr[64] = "127.0.0.1";
+	int fd, one = 1;
+
+	if (colon) {
+		snprintf(addr, sizeof(addr), "%.*s", (int)(colon - spec), spec);
+		spec = colon + 1;
+	}
+	sin.sin_port = htons((uint16_t)atoi(spec));
+	if (inet_pton(AF_INET, addr, &sin.sin_addr) != 1) {
+		fprintf(stderr, "livesrv: bad address %s\n", addr);
+		return -1;
+	}
+	if ((fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0)) < 0 ||
+	    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+	    bind(fd, (struct sockaddr *)&sin, sizeof(sin)) != 0 ||
+	    listen(fd, 1024) != 0) {
+		perror("livesrv: listen");
+		return -1;
+	}
+	return fd;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark: the server on a pty, against many local viewers
+
+/// A benchmark viewer
+typedef struct bcl_type {
+	int      fd;
+	bool     ws, slow, streaming;
+	char     buf[8192];
+	size_t   len;
+	uint64_t got, last_seq, out_of_order;
+} bcl_t;
+
+static uint64_t *sent_ns;	// Write time of each event, by seq - 1
+static uint64_t nr_sent;
+static uint32_t *lat_us;	// Delivery latency of every event to a fast viewer
+static size_t nr_lat, max_lat;
+
+static int bench_connect(uint16_t port, bool ws, bool slow)
+{
+	static const char sse_req[] = "GET /events HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	static const char ws_req[] =
+		"GET /ws HTTP/1.1\r\nHost: localhost\r\nUpgrade: websocket\r\n"
+		"Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+		"Sec-WebSocket-Version: 13\r\n\r\n";
+	struct sockaddr_in sin = { .sin_family = AF_INET, .sin_port = htons(port) };
+	int fd = socket(AF_INET, SOCK_STREAM, 0), small = 4096;
+
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (slow)
+		setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+	if (fd < 0 || connect(fd, (struct sockaddr *)&sin, sizeof(sin)) != 0) {
+		perror("connect");
+		exit(1);
+	}
+	if (ws)
+		write(fd, ws_req, sizeof(ws_req) - 1);
+	else
+		write(fd, sse_req, sizeof(sse_req) - 1);
+	fcntl(fd, F_SETFL, O_NONBLOCK);
+	return fd;
+}
+
+/// Take the "seq" of every complete event in the buffer
+static void bench_scan(bcl_t *b, uint64_t t)
+{
+	char *p = b->buf, *end = b->buf + b->len, *hit;
+
+	if (!b->streaming) {
+		if ((hit = memmem(p, b->len, "\r\n\r\n", 4)) == NULL)
+			return;
+		b->streaming = true;
+		p = hit + 4;
+	}
+	while ((hit = memmem(p, (size_t)(end - p), "\"seq\":", 6)) != NULL) {
+		char *q = hit + 6;
+		uint64_t s = 0;
+
+		while (q < end && *q >= '0' && *q <= '9')
+			s = s * 10 + (uint64_t)(*q++ - '0');
+		if (q == end)
+			break;		// The number may go on in the next read
+		if (s != b->last_seq + 1)
+			++b->out_of_order;
+		b->last_seq = s;
+		++b->got;
+		if (s >= 1 && s <= nr_sent && nr_lat < max_lat)
+			lat_us[nr_lat++] = (uint32_t)((t - sent_ns[s - 1]) / 1000);
+		p = q;
+	}
+	if (end - p > 32)
+		p = end - 32;
+	memmove(b->buf, p, (size_t)(end - p));
+	b->len = (size_t)(end - p);
+}
+
+static void bench_frame(uint8_t *f, uint64_t i)
+{
+	uint16_t sum = 0;
+
+	f[0] = 0x42; f[1] = 0x4D; f[2] = 0x00; f[3] = 28;
+	for (int k = 0; k < 13; ++k) {
+		uint16_t v = k == 12 ? 0 : (uint16_t)(10 + k + i % 50);
+
+		f[4 + 2 * k] = (uint8_t)(v >> 8);
+		f[5 + 2 * k] = (uint8_t)v;
+	}
+	for (int k = 0; k < 30; ++k)
+		sum += f[k];
+	f[30] = (uint8_t)(sum >> 8);
+	f[31] = (uint8_t)sum;
+}
+
+/// GET /stats from the server and pick one counter out of it
+static unsigned long long bench_stat(uint16_t port, const char *name)
+{
+	struct sockaddr_in sin = { .sin_family = AF_INET, .sin_port = htons(port) };
+	static const char req[] = "GET /stats HTTP/1.1\r\nHost: localhost\r\n\r\n";
+	char buf[2048], key[64], *p;
+	size_t len = 0;
+	ssize_t n;
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+
+	sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (fd < 0 || connect(fd, (struct sockaddr *)&sin, sizeof(sin)) != 0)
+		return 0;
+	write(fd, req, sizeof(req) - 1);
+	while (len < sizeof(buf) - 1 && (n = read(fd, buf + len, sizeof(buf) - 1 - len)) > 0)
+		len += (size_t)n;
+	close(fd);
+	buf[len] = '\0';
+	snprintf(key, sizeof(key), "\"%s\":", name);
+	return (p = strstr(buf, key)) ? strtoull(p + strlen(key), NULL, 10) : 0;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static int run_bench(unsigned nr_clients, unsigned slow_pct, unsigned rate, double secs)
+{
+	unsigned nr_slow = nr_clients * slow_pct / 100, nr_fast = nr_clients - nr_slow;
+	uint64_t nr_frames = (uint64_t)(rate * secs), t0, t_end, fast_got = 0, slow_got = 0, ooo = 0;
+	struct sockaddr_in sin;
+	socklen_t slen = sizeof(sin);
+	struct rusage ru;
+	bcl_t *cl;
+	pid_t pid;
+	int master, lfd, bep, status;
+	uint16_t port;
+	double cpu;
+
+	raise_fd_limit();
+	signal(SIGPIPE, SIG_IGN);
+	if ((master = posix_openpt(O_RDWR | O_NOCTTY)) < 0 ||
+	    grantpt(master) != 0 || unlockpt(master) != 0) {
+		perror("posix_openpt");
+		return 1;
+	}
+	opt_dev = ptsname(master);
+	if ((lfd = listen_on("127.0.0.1:0")) < 0)
+		return 1;
+	getsockname(lfd, (struct sockaddr *)&sin, &slen);
+	port = ntohs(sin.sin_port);
+
+	if ((pid = fork()) == 0) {
+		close(master);
+		exit(serve(lfd));
+	}
+	close(lfd);
+
+	sent_ns = calloc(nr_frames ? nr_frames : 1, sizeof(*sent_ns));
+	max_lat = (size_t)(nr_frames * nr_fast);
+	lat_us = malloc((max_lat ? max_lat : 1) * sizeof(*lat_us));
+	cl = calloc(nr_clients, sizeof(*cl));
+	bep = epoll_create1(0);
+	if (sent_ns == NULL || lat_us == NULL || cl == NULL || bep < 0) {
+		perror("livesrv");
+		return 1;
+	}
+
+	// Viewers alternate between SSE and WebSocket; the first nr_slow never read
+	for (unsigned i = 0; i < nr_clients; ++i) {
+		struct epoll_event ev = { .events = EPOLLIN, .data.ptr = &cl[i] };
+
+		cl[i].ws = i & 1;
+		cl[i].slow = i < nr_slow;
+		cl[i].fd = bench_connect(port, cl[i].ws, cl[i].slow);
+		if (!cl[i].slow)
+			epoll_ctl(bep, EPOLL_CTL_ADD, cl[i].fd, &ev);
+	}
+	// Wait until every fast viewer is streaming
+	for (unsigned ready = 0; ready < nr_fast; ) {
+		struct epoll_event evs[64];
+		int n = epoll_wait(bep, evs, 64, 5000);
+
+		if (n <= 0) {
+			fprintf(stderr, "livesrv: only %u of %u viewers connected\n", ready, nr_fast);
+			kill(pid, SIGTERM);
+			return 1;
+		}
+		for (int i = 0; i < n; ++i) {
+			bcl_t *b = evs[i].data.ptr;
+			ssize_t r = read(b->fd, b->buf + b->len, sizeof(b->buf) - b->len);
+
+			if (r <= 0)
+				continue;
+			b->len += (size_t)r;
+			if (!b->streaming) {
+				bench_scan(b, 0);
+				ready += b->streaming;
+			}
+		}
+	}
+
+	printf("livesrv bench: %u viewers (%u SSE, %u WebSocket, %u stalled), queue %u, "
+	       "send buffer %d, %llu events at %u/s\n",
+	       nr_clients, nr_clients - nr_clients / 2, nr_clients / 2, nr_slow, opt_queue,
+	       opt_sndbuf,
+	       (unsigned long long)nr_frames, rate);
+
+	t0 = now_ns();
+	t_end = t0 + (uint64_t)(secs * 1e9);
+	for (;;) {
+		struct epoll_event evs[256];
+		uint64_t t = now_ns(), next;
+		int timeout, n;
+
+		while (nr_sent < nr_frames && t >= t0 + nr_sent * 1000000000ull / rate) {
+			uint8_t f[32];
+
+			bench_frame(f, nr_sent);
+			sent_ns[nr_sent++] = now_ns();
+			if (write(master, f, sizeof(f)) != sizeof(f)) {
+				perror("write");
+				return 1;
+			}
+		}
+		if (nr_sent == nr_frames && (fast_got == nr_frames * nr_fast || t > t_end + 2000000000ull))
+			break;
+		next = nr_sent < nr_frames ? t0 + nr_sent * 1000000000ull / rate : t + 100000000;
+		timeout = next > t ? (int)((next - t + 999999) / 1000000) : 0;
+		n = epoll_wait(bep, evs, 256, timeout);
+		for (int i = 0; i < n; ++i) {
+			bcl_t *b = evs[i].data.ptr;
+			uint64_t before = b->got;
+			ssize_t r;
+
+			while ((r = read(b->fd, b->buf + b->len, sizeof(b->buf) - b->len)) > 0) {
+				b->len += (size_t)r;
+				bench_scan(b, now_ns());
+			}
+			fast_got += b->got - before;
+		}
+	}
+
+	// Stalled viewers: what reached them, and what the server dropped
+	for (unsigned i = 0; i < nr_slow; ++i) {
+		ssize_t r;
+
+		while ((r = read(cl[i].fd, cl[i].buf + cl[i].len, sizeof(cl[i].buf) - cl[i].len)) > 0) {
+			cl[i].len += (size_t)r;
+			bench_scan(&cl[i], now_ns());
+		}
+		slow_got += cl[i].got;
+	}
+	for (unsigned i = nr_slow; i < nr_clients; ++i)
+		ooo += cl[i].out_of_order;
+	unsigned long long drops = bench_stat(port, "drops");
+
+	kill(pid, SIGTERM);
+	if (wait4(pid, &status, 0, &ru) < 0) {
+		perror("wait4");
+		return 1;
+	}
+	cpu = (double)ru.ru_utime.tv_sec + ru.ru_utime.tv_usec / 1e6 +
+	      (double)ru.ru_stime.tv_sec + ru.ru_stime.tv_usec / 1e6;
+
+	qsort(lat_us, nr_lat, sizeof(*lat_us), cmp_u32);
+	printf("  fast viewers:    %llu of %llu events delivered, %llu out of order\n",
+	       (unsigned long long)fast_got, (unsigned long long)(nr_frames * nr_fast),
+	       (unsigned long long)ooo);
+	if (nr_lat)
+		printf("  latency:         p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+		       lat_us[nr_lat / 2] / 1e3, lat_us[nr_lat * 99 / 100] / 1e3,
+		       lat_us[nr_lat - 1] / 1e3);
+	printf("  stalled viewers: %llu events received, %llu dropped by the server\n",
+	       (unsigned long long)slow_got, drops);
+	printf("  server CPU:      %.2f s over %.1f s (%.1f%% of a core), %.2f us per delivery\n",
+	       cpu, secs, 100.0 * cpu / secs,
+	       fast_got + slow_got + drops ? cpu * 1e6 / (double)(fast_got + slow_got + drops) : 0.0);
+	return fast_got == nr_frames * nr_fast && ooo == 0 ? 0 : 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s -d DEVICE [-b BAUD] [-l [ADDR:]PORT] [-q QUEUE] [-w SNDBUF] [-v SECONDS]\n"
+		"       %s -B [-n VIEWERS] [-s STALLED_PCT] [-r EVENTS_PER_S] [-t SECONDS]\n"
+		"          [-q QUEUE] [-w SNDBUF]\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *listen_spec = "127.0.0.1:8088";
+	unsigned nr_clients = 200, slow_pct = 10, rate = 100;
+	double secs = 5;
+	int bench = 0, lfd;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:b:l:q:w:v:Bn:s:r:t:h")) != -1) {
+		switch (c) {
+		case 'd': opt_dev = optarg; break;
+		case 'b': opt_baud = strtol(optarg, NULL, 0); break;
+		case 'l': listen_spec = optarg; break;
+		case 'q': opt_queue = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'w': opt_sndbuf = atoi(optarg); break;
+		case 'v': opt_report = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'B': bench = 1; break;
+		case 'n': nr_clients = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 's': slow_pct = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'r': rate = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 't': secs = strtod(optarg, NULL); break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (opt_queue < 4 || (bench ? nr_clients == 0 || slow_pct > 100 || rate == 0 || secs <= 0
+				    : opt_dev == NULL)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (bench)
+		return run_bench(nr_clients, slow_pct, rate, secs);
+
+	if ((lfd = listen_on(listen_spec)) < 0)
+		return 1;
+	fprintf(stderr, "livesrv: %s -> http://%s/\n", opt_dev, listen_spec);
+	return serve(lfd);
+}
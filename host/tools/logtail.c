@@ -0,0 +1,472 @@
+/**
+ * @file host/tools/logtail.c
+ * @brief Follows GPS and PM sensor capture files and prints the decoded data.
+ *
+ * Replaces the eee192-gps/convert_gps.py and eee192-pms/convert.py pollers,
+ * which reread the whole capture (putty.log) every second and therefore did
+ * more work the longer a session ran. This tool:
+ *
+ * - waits on inotify instead of a timer, so it sleeps until a capture grows;
+ * - remembers how far each file has been decoded and reads only the new
+ *   bytes, so the work per byte stays the same however long the log gets;
+ * - decodes with the firmware's own streaming decoders: the NMEA sentence
+ *   assembler and GPGLL formatter (src/parsers/nmea_parse.c) for GPS
+ *   captures, and the PMS frame parser (src/parsers/pms_parser.c) for the raw
+ *   binary PM captures.
+ *
+ * A capture that is truncated (PuTTY "overwrite") is decoded again from the
+ * start; one that is deleted or renamed away is picked up again once a file
+ * of the same name reappears. After each batch of new data the latest GPS fix
+ * and PM reading are printed, as the scripts did, and appended to -o.
+ *
+ * With -B the tool instead replays the given captures as if they grew in
+ * chunks of -k bytes, and compares decoding only the new bytes against
+ * re-decoding the whole capture each time (what the scripts did).
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -o logtail host/tools/logtail.c \
+ *      src/parsers/nmea_parse.c src/parsers/pms_parser.c
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "parsers/nmea_parser.h"
+#include "parsers/pms_parser.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define LOGTAIL_MAX_SRCS	8
+
+enum src_kind {
+	SRC_GPS,
+	SRC_PM
+};
+
+/// One followed capture file
+typedef struct src_type {
+	const char   *path;
+	char          name[NAME_MAX + 1];	// Base name, matched against directory events
+	enum src_kind kind;
+
+	int   fd;			// -1 while the file does not exist
+	dev_t dev;
+	ino_t ino;
+	off_t off;			// Bytes decoded so far
+	int   wd;			// inotify watch on the file itself
+	int   dir_wd;			// inotify watch on its directory
+	int   skip;			// Start the next open at the end (-e)
+
+	// Decoders
+	nmea_sentence_state_t       nmea;
+	pms_parser_internal_state_t pms;
+
+	// Latest decoded record, printed after each batch
+	char latest[160];
+	int  have_latest;
+
+	// Counters
+	unsigned long long bytes;
+	unsigned long      records;	// GPGLL sentences or good PMS frames
+	unsigned long      bad;		// PMS frames with errors
+	unsigned long      reopens;
+	unsigned long long decode_ns;
+} src_t;
+
+static src_t srcs[LOGTAIL_MAX_SRCS];
+static unsigned nr_srcs;
+
+static int opt_from_end;
+static FILE *out_log;
+
+static volatile sig_atomic_t stop_requested;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Decoding
+
+static void src_reset_decoder(src_t *s)
+{
+	nmea_sentence_init(&s->nmea);
+	pms_parser_init(&s->pms);
+}
+
+/// Feed new capture bytes; the cost is constant per byte
+static void src_decode(src_t *s, const uint8_t *buf, size_t len)
+{
+	char line[128];
+	pms_data_t pm;
+
+	for (size_t i = 0; i < len; ++i) {
+		if (s->kind == SRC_GPS) {
+			const char *sentence = nmea_sentence_feed(&s->nmea, (char)buf[i]);
+
+			if (sentence == NULL || strncmp(sentence, "$GPGLL,", 7) != 0)
+				continue;
+			if (!nmea_parse_gpgll_and_format(sentence, line, sizeof(line)))
+				continue;
+			line[strcspn(line, "\r\n")] = '\0';
+			snprintf(s->latest, sizeof(s->latest), "[GPS] %s", line);
+			s->have_latest = 1;
+			++s->records;
+		} else {
+			pms_parser_status_t st = pms_parser_feed_byte(NULL, &s->pms, buf[i], &pm);
+
+			if (st == PMS_PARSER_OK) {
+				// Atmospheric-environment values, as convert.py printed
+				snprintf(s->latest, sizeof(s->latest),
+					 "[PM]  PM1.0: %u | PM2.5: %u | PM10: %u || Unit: ug/m3",
+					 pm.pm1_0_atm, pm.pm2_5_atm, pm.pm10_atm);
+				s->have_latest = 1;
+				++s->records;
+			} else if (st == PMS_PARSER_CHECKSUM_ERROR ||
+				   st == PMS_PARSER_INVALID_LENGTH ||
+				   st == PMS_PARSER_BUFFER_OVERFLOW) {
+				++s->bad;
+			}
+		}
+	}
+	s->bytes += len;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Following the files
+
+/// (Re)open the capture if the path now names a different file
+static void src_open(src_t *s, int ifd)
+{
+	struct stat st;
+	int fd;
+
+	if (stat(s->path, &st) != 0)
+		return;
+	if (s->fd >= 0 && st.st_dev == s->dev && st.st_ino == s->ino)
+		return;
+	if ((fd = open(s->path, O_RDONLY | O_CLOEXEC)) < 0)
+		return;
+
+	if (s->fd >= 0) {
+		close(s->fd);
+		++s->reopens;
+	}
+	if (s->wd >= 0)
+		inotify_rm_watch(ifd, s->wd);
+
+	s->fd = fd;
+	s->dev = st.st_dev;
+	s->ino = st.st_ino;
+	s->off = 0;
+	src_reset_decoder(s);
+
+	if (s->skip)
+		s->off = st.st_size;
+
+	s->wd = ifd < 0 ? -1 :
+		inotify_add_watch(ifd, s->path, IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
+}
+
+/// Decode whatever was appended since the last call
+static void src_drain(src_t *s)
+{
+	static uint8_t buf[64 * 1024];
+	struct stat st;
+	uint64_t t0;
+	ssize_t n;
+
+	if (s->fd < 0)
+		return;
+
+	// Shorter than what was decoded: truncated and rewritten from the start
+	if (fstat(s->fd, &st) == 0 && st.st_size < s->off) {
+		s->off = 0;
+		src_reset_decoder(s);
+	}
+
+	t0 = now_ns();
+	while ((n = pread(s->fd, buf, sizeof(buf), s->off)) > 0) {
+		src_decode(s, buf, (size_t)n);
+		s->off += n;
+	}
+	s->decode_ns += now_ns() - t0;
+}
+
+static void src_print_latest(src_t *s)
+{
+	if (!s->have_latest)
+		return;
+	s->have_latest = 0;
+	printf("%s\n", s->latest);
+	if (out_log != NULL) {
+		fprintf(out_log, "%s\n", s->latest);
+		fflush(out_log);
+	}
+}
+
+static void print_stats(void)
+{
+	for (unsigned i = 0; i < nr_srcs; ++i) {
+		src_t *s = &srcs[i];
+
+		fprintf(stderr,
+			"[tail] %s: %llu B, %lu %s, %lu bad, %lu reopens, %.1f ns/B\n",
+			s->path, s->bytes, s->records,
+			s->kind == SRC_GPS ? "GPGLL" : "frames", s->bad, s->reopens,
+			s->bytes ? (double)s->decode_ns / s->bytes : 0.0);
+	}
+}
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	stop_requested = 1;
+}
+
+static int run_follow(int once)
+{
+	union {
+		struct inotify_event ev;
+		char buf[16 * (sizeof(struct inotify_event) + NAME_MAX + 1)];
+	} evbuf;
+	int ifd = -1;
+
+	if (!once) {
+		ifd = inotify_init1(IN_CLOEXEC);
+		if (ifd < 0) {
+			perror("inotify_init1");
+			return 1;
+		}
+	}
+
+	for (unsigned i = 0; i < nr_srcs; ++i) {
+		src_t *s = &srcs[i];
+		char dir[PATH_MAX];
+
+		s->fd = -1;
+		s->wd = -1;
+		s->dir_wd = -1;
+		src_reset_decoder(s);
+
+		/*
+		 * The directory watch sees the capture being created again after
+		 * a rotation or a fresh PuTTY session; it is added before the
+		 * first open so that no creation can be missed in between.
+		 */
+		snprintf(dir, sizeof(dir), "%s", s->path);
+		snprintf(s->name, sizeof(s->name), "%s", basename((char *)s->path));
+		if (ifd >= 0)
+			s->dir_wd = inotify_add_watch(ifd, dirname(dir),
+						      IN_CREATE | IN_MOVED_TO | IN_CLOSE_WRITE);
+		/*
+		 * -e skips only what a capture already holds at startup; one
+		 * that appears (or is replaced) later holds nothing but new data.
+		 */
+		s->skip = opt_from_end;
+		src_open(s, ifd);
+		s->skip = 0;
+		if (s->fd < 0 && once) {
+			perror(s->path);
+			return 1;
+		}
+		if (s->fd < 0)
+			fprintf(stderr, "[tail] %s: waiting for the file to appear\n", s->path);
+		src_drain(s);
+		src_print_latest(s);
+	}
+	if (once) {
+		print_stats();
+		return 0;
+	}
+
+	/*
+	 * No SA_RESTART: the signal must interrupt the blocking read() so the
+	 * statistics get printed.
+	 */
+	struct sigaction sa = { .sa_handler = on_signal };
+
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+	while (!stop_requested) {
+		ssize_t n = read(ifd, &evbuf, sizeof(evbuf));
+
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+
+		/*
+		 * Events only say which captures may have changed; each one is
+		 * looked at once per batch, however many events it produced.
+		 */
+		unsigned char touched[LOGTAIL_MAX_SRCS] = { 0 };
+
+		for (char *p = evbuf.buf; p < evbuf.buf + n; ) {
+			struct inotify_event *ev = (struct inotify_event *)p;
+
+			for (unsigned i = 0; i < nr_srcs; ++i) {
+				src_t *s = &srcs[i];
+
+				if (ev->wd == s->wd)
+					touched[i] = 1;
+				else if (ev->wd == s->dir_wd && ev->len > 0 &&
+					 strcmp(ev->name, s->name) == 0)
+					touched[i] = 2;
+			}
+			p += sizeof(struct inotify_event) + ev->len;
+		}
+		for (unsigned i = 0; i < nr_srcs; ++i) {
+			if (touched[i] == 0)
+				continue;
+			// Finish the old file first; its last lines may not be decoded yet
+			src_drain(&srcs[i]);
+			src_open(&srcs[i], ifd);
+			src_drain(&srcs[i]);
+			src_print_latest(&srcs[i]);
+		}
+		fflush(stdout);
+	}
+	print_stats();
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark: incremental decoding against re-decoding the whole capture
+
+static int run_bench(size_t chunk)
+{
+	printf("%-28s %10s %8s %14s %14s %9s\n", "capture", "bytes", "chunks",
+	       "tail ns/B", "rescan ns/B", "ratio");
+	for (unsigned i = 0; i < nr_srcs; ++i) {
+		src_t *s = &srcs[i];
+		FILE *f = fopen(s->path, "rb");
+		uint8_t *data;
+		long size;
+		uint64_t tail_ns, rescan_ns, t0;
+		unsigned long chunks = 0, tail_recs, rescan_recs = 0;
+
+		if (f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) <= 0) {
+			perror(s->path);
+			return 1;
+		}
+		rewind(f);
+		data = malloc((size_t)size);
+		if (data == NULL || fread(data, 1, (size_t)size, f) != (size_t)size) {
+			perror(s->path);
+			return 1;
+		}
+		fclose(f);
+
+		// Tail: decode each chunk once, as it arrives
+		src_reset_decoder(s);
+		s->records = 0;
+		t0 = now_ns();
+		for (long off = 0; off < size; off += (long)chunk) {
+			size_t len = (size_t)(size - off) < chunk ? (size_t)(size - off) : chunk;
+
+			src_decode(s, data + off, len);
+			++chunks;
+		}
+		tail_ns = now_ns() - t0;
+		tail_recs = s->records;
+
+		// Rescan: after each chunk, decode the whole capture so far again
+		t0 = now_ns();
+		for (long off = 0; off < size; off += (long)chunk) {
+			size_t len = (size_t)(size - off) < chunk ? (size_t)(size - off) : chunk;
+
+			src_reset_decoder(s);
+			s->records = 0;
+			src_decode(s, data, (size_t)off + len);
+		}
+		rescan_ns = now_ns() - t0;
+		rescan_recs = s->records;
+
+		printf("%-28s %10ld %8lu %14.1f %14.1f %8.0fx%s\n", s->path, size, chunks,
+		       (double)tail_ns / size, (double)rescan_ns / size,
+		       tail_ns ? (double)rescan_ns / tail_ns : 0.0,
+		       tail_recs == rescan_recs ? "" : "  (record counts differ!)");
+		free(data);
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-g GPS_CAPTURE]... [-p PM_CAPTURE]... [-o OUT.log] [-e | -1]\n"
+		"       %s -B [-k CHUNK_BYTES] [-g GPS_CAPTURE]... [-p PM_CAPTURE]...\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *out = NULL;
+	size_t chunk = 64;
+	int once = 0, bench = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "g:p:o:e1Bk:h")) != -1) {
+		switch (c) {
+		case 'g':
+		case 'p':
+			if (nr_srcs == LOGTAIL_MAX_SRCS) {
+				fprintf(stderr, "at most %d captures\n", LOGTAIL_MAX_SRCS);
+				return 1;
+			}
+			srcs[nr_srcs].path = optarg;
+			srcs[nr_srcs].kind = c == 'g' ? SRC_GPS : SRC_PM;
+			++nr_srcs;
+			break;
+		case 'o': out = optarg; break;
+		case 'e': opt_from_end = 1; break;
+		case '1': once = 1; break;
+		case 'B': bench = 1; break;
+		case 'k': chunk = (size_t)strtoul(optarg, NULL, 0); break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (nr_srcs == 0 || chunk == 0 || (once && opt_from_end)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (bench)
+		return run_bench(chunk);
+
+	if (out && (out_log = fopen(out, "a")) == NULL) {
+		perror(out);
+		return 1;
+	}
+	return run_follow(once);
+}
@@ -0,0 +1,665 @@
+/**
+ * @file host/tools/loopcap.c
+ * @brief Finds how slow the main loop may get before sensor bytes are lost.
+ *
+ * The sensor drivers have no interrupts: each platform_do_loop_one() moves
+ * at most one byte from each SERCOM into its receive buffer. With the FIFO
+ * disabled a SERCOM holds two unread characters, so a byte that completes
+ * while two are waiting is lost (BUFOVF). Every iteration of
+ * prog_loop_one() must therefore come round quickly enough, and the
+ * iterations that parse, print or log are the slow ones.
+ *
+ * This tool is a discrete-event model of that loop. Bytes complete on the
+ * GPS and PM lines at their baud rates (the streams come from
+ * host/lib/sgen.h); each iteration reads them as the drivers do, completes
+ * buffers on a full buffer or the drivers' 781.25 us idle timeout, and runs
+ * the stages of prog_loop_one() that the data calls for, each costing the
+ * cycles given in the cost table. The sentence assembler and PMS parser are
+ * the firmware's own, so the stages run exactly when they would. Terminal
+ * output drains by DMA at the terminal's baud rate, and output is skipped
+ * while the terminal is busy, as the UI does; the rate-limited combined
+ * display counts loop iterations, as main.c does.
+ *
+ * The cost table holds estimates for the Cortex-M23 at 24 MHz. Override any
+ * of them with -k NAME=CYCLES, and -k help lists them.
+ *
+ * For every combination of GPS baud rate (-g), PM baud rate (-p), fix rate
+ * (-r), sentence mix (-S, repeatable), display interval (-d) and debug
+ * output (-D), the tool runs -t seconds at the table's costs, then bisects
+ * on extra cycles added to every iteration. It reports the largest extra
+ * cost, to the cycle, at which no byte is lost, and the line that loses
+ * bytes first beyond it. Lists are comma-separated.
+ *
+ * Debug output is off unless -D asks for it. It cannot move a limit: main.c
+ * echoes a PM buffer ("PM RAW") before it dumps it ("PM HEX"), and the dump
+ * runs only with the terminal idle, which the echo has just made it not.
+ *
+ * With -B a default sweep is run and checked: each limit must lose nothing
+ * while one cycle more must lose bytes, and with every stage free but the
+ * loop itself, the limit must lie within one character time of the
+ * analytic bound for a steady stream.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -Ihost/lib -o loopcap host/tools/loopcap.c \
+ *      host/lib/sgen.c src/parsers/nmea_parse.c src/parsers/pms_parser.c -lm
+ */
+
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "sgen.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define LOOPCAP_CPU_HZ		24000000u	///< GCLK_GEN0
+#define LOOPCAP_IDLE_NS		781250u		///< Drivers' IDLE timeout
+#define LOOPCAP_HW_DEPTH	2		///< Unread characters a SERCOM holds
+#define LOOPCAP_MAX_EXTRA	2400000u	///< Bisection bound: 100 ms per iteration
+
+/// Cycles spent in each stage of the loop
+typedef struct cost_type {
+	const char *name;
+	uint32_t cycles;
+	const char *what;
+} cost_t;
+
+enum {
+	C_LOOP, C_RX_BYTE, C_RX_DONE, C_NMEA_CHAR, C_ECHO, C_ECHO_CHAR,
+	C_GLL, C_STORE, C_PMS_BYTE, C_PM_RAW, C_PM_RAW_BYTE, C_PM_HEX_BYTE,
+	C_DISPLAY, C_LATENCY, NR_COSTS
+};
+
+static cost_t costs[NR_COSTS] = {
+	[C_LOOP]        = { "loop",        900, "every iteration: tick handlers and idle services" },
+	[C_RX_BYTE]     = { "rx_byte",      80, "a byte moved into a receive buffer" },
+	[C_RX_DONE]     = { "rx_done",     150, "a completed buffer, handled and re-armed" },
+	[C_NMEA_CHAR]   = { "nmea_char",    30, "a character through the sentence assembler" },
+	[C_ECHO]        = { "echo",       2500, "a \"GPS RAW\" echo of a sentence" },
+	[C_ECHO_CHAR]   = { "echo_char",    10, "... per character" },
+	[C_GLL]         = { "gll",        9000, "nmea_parse_gpgll_and_format()" },
+	[C_STORE]       = { "store",      2500, "prog_store_record(): log store and uplink" },
+	[C_PMS_BYTE]    = { "pms_byte",     45, "a byte through pms_parser_feed_byte()" },
+	[C_PM_RAW]      = { "pm_raw",     2000, "a \"PM RAW\" display of a buffer" },
+	[C_PM_RAW_BYTE] = { "pm_raw_byte",  40, "... per byte" },
+	[C_PM_HEX_BYTE] = { "pm_hex_byte", 600, "a byte of the debug \"PM HEX\" dump" },
+	[C_DISPLAY]     = { "display",   12000, "the combined GPS and PM display line" },
+	[C_LATENCY]     = { "latency",    8000, "the debug ingest-latency line, every 10 s" },
+};
+
+/// One point of the sweep
+typedef struct config_type {
+	long     gps_baud, pm_baud, cdc_baud;
+	double   gps_hz;
+	unsigned sentences;
+	unsigned display_ms;
+	bool     debug;
+} config_t;
+
+/// What one run saw
+typedef struct outcome_type {
+	uint64_t dropped[2];		///< GPS, PM
+	uint64_t iterations;
+	uint64_t worst_ns;		///< Longest iteration
+	uint64_t busy_ns;		///< Time spent in iterations beyond the loop cost
+	uint64_t sentences, frames;	///< Decoded
+} outcome_t;
+
+static double opt_secs = 10;
+static uint32_t opt_seed = 1;
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Lines
+
+/// A sensor line: the wire, the SERCOM and the driver's receive buffer
+typedef struct line_type {
+	uint64_t byte_ns;
+	uint64_t period_ns, phase_ns;
+	uint64_t seq;			///< Next report
+	uint64_t start_ns;		///< Arrival of the current report's first bit
+	uint8_t  report[SGEN_EPOCH_MAX];
+	size_t   len, pos;
+
+	uint8_t  hw[LOOPCAP_HW_DEPTH];	///< Unread characters
+	unsigned nr_hw;
+	uint64_t dropped;
+
+	char     buf[GPS_RX_BUF_SZ];
+	uint16_t max_len, idx;
+	uint64_t idle_ns;		///< When the last byte was read
+	bool     done;
+} line_t;
+
+static sgen_t gen;
+
+static void line_init(line_t *l, long baud, uint64_t period_ns,
+		      uint64_t phase_ns, uint16_t max_len)
+{
+	memset(l, 0, sizeof(*l));
+	l->byte_ns = 10000000000ull / (uint64_t)baud;
+	l->period_ns = period_ns;
+	l->phase_ns = phase_ns;
+	l->max_len = max_len;
+}
+
+// Deliver every character whose stop bit has arrived by @p t into the SERCOM
+static void line_arrive(line_t *l, bool pm, uint64_t t)
+{
+	for (;;) {
+		if (l->pos == l->len) {
+			// A report starts on time, or once the last one is out
+			uint64_t due = l->phase_ns + l->seq * l->period_ns;
+			uint64_t end = l->start_ns + l->len * l->byte_ns;
+
+			if (due < end)
+				due = end;
+			if (due + l->byte_ns > t)
+				return;
+			l->start_ns = due;
+			l->len = pm ? sgen_pm_frame(&gen, l->seq, l->report)
+				    : sgen_gps_epoch(&gen, l->seq, (char *)l->report,
+						     sizeof(l->report));
+			l->pos = 0;
+			++l->seq;
+			if (l->len == 0)
+				continue;
+		}
+		if (l->start_ns + (l->pos + 1) * l->byte_ns > t)
+			return;
+		if (l->nr_hw < LOOPCAP_HW_DEPTH)
+			l->hw[l->nr_hw++] = l->report[l->pos];
+		else
+			++l->dropped;
+		++l->pos;
+	}
+}
+
+// One call of the driver's tick handler; returns the cycles it took
+static uint32_t line_tick(line_t *l, bool pm, uint64_t t)
+{
+	uint32_t cyc = 0;
+
+	line_arrive(l, pm, t);
+	if (l->nr_hw != 0) {
+		l->buf[l->idx++] = (char)l->hw[0];
+		memmove(l->hw, l->hw + 1, --l->nr_hw);
+		l->idle_ns = t;
+		cyc += costs[C_RX_BYTE].cycles;
+	}
+	if (l->idx >= l->max_len ||
+	    (l->idx > 0 && t - l->idle_ns >= LOOPCAP_IDLE_NS))
+		l->done = true;
+	return cyc;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// The loop
+
+static uint64_t cycles_ns(uint64_t cyc)
+{
+	return cyc * 1000000000ull / LOOPCAP_CPU_HZ;
+}
+
+/// Run @p c for opt_secs with @p extra cycles added to every iteration
+static void run(const config_t *c, uint32_t extra, outcome_t *o)
+{
+	nmea_sentence_state_t nmea;
+	pms_parser_internal_state_t pms;
+	pms_data_t pm_data;
+	line_t gps, pm;
+	sgen_cfg_t gc;
+	uint64_t t = 0, end = (uint64_t)(opt_secs * 1e9);
+	uint64_t cdc_byte_ns = 10000000000ull / (uint64_t)c->cdc_baud;
+	uint64_t tx_until = 0;
+	uint32_t display_counter = 0;
+	uint64_t latency_ns = 0;
+	bool ready = false;
+
+	sgen_cfg_default(&gc);
+	gc.seed = opt_seed;
+	gc.t0_ms = 1700000000000;
+	gc.gps_hz = c->gps_hz;
+	gc.sentences = c->sentences;
+	sgen_init(&gen, &gc);
+	line_init(&gps, c->gps_baud, (uint64_t)(1e9 / c->gps_hz), 100000000u,
+		  GPS_RX_BUF_SZ);
+	line_init(&pm, c->pm_baud, 1000000000u, 350000000u, PM_RX_BUF_SZ);
+	nmea_sentence_init(&nmea);
+	pms_parser_init(&pms);
+	memset(o, 0, sizeof(*o));
+
+	while (t < end) {
+		uint64_t t0 = t, cyc = costs[C_LOOP].cycles + extra;
+
+#define SPEND(n) do { cyc += (n); t = t0 + cycles_ns(cyc); } while (0)
+#define TX(len)  (tx_until = t + (uint64_t)(len) * cdc_byte_ns)
+
+		// platform_do_loop_one(): PM, then GPS
+		SPEND(line_tick(&pm, true, t));
+		SPEND(line_tick(&gps, false, t));
+
+		if (gps.done) {
+			SPEND(costs[C_RX_DONE].cycles);
+			for (uint16_t i = 0; i < gps.idx; ++i) {
+				const char *s = nmea_sentence_feed(&nmea, gps.buf[i]);
+				size_t n;
+
+				SPEND(costs[C_NMEA_CHAR].cycles);
+				if (s == NULL)
+					continue;
+				++o->sentences;
+				n = strlen(s);
+				if (t >= tx_until) {
+					SPEND(costs[C_ECHO].cycles + n * costs[C_ECHO_CHAR].cycles);
+					TX(n + 24);
+				}
+				if (strncmp(s, "$GPGLL", 6) == 0) {
+					SPEND(costs[C_STORE].cycles + costs[C_GLL].cycles);
+					ready = true;
+				}
+			}
+			gps.idx = 0;
+			gps.done = false;
+		}
+
+		if (pm.done) {
+			SPEND(costs[C_RX_DONE].cycles);
+			if (pm.idx >= 8 && t >= tx_until) {
+				SPEND(costs[C_PM_RAW].cycles + pm.idx * costs[C_PM_RAW_BYTE].cycles);
+				TX(3u * pm.idx + 24);
+			}
+			if (c->debug && pm.idx >= 8 && t >= tx_until) {
+				SPEND(pm.idx * costs[C_PM_HEX_BYTE].cycles);
+				TX(3u * pm.idx + 4u * (pm.idx / 16) + 24);
+			}
+			for (uint16_t i = 0; i < pm.idx; ++i) {
+				SPEND(costs[C_PMS_BYTE].cycles);
+				if (pms_parser_feed_byte(NULL, &pms, (uint8_t)pm.buf[i],
+							 &pm_data) == PMS_PARSER_OK) {
+					SPEND(costs[C_STORE].cycles);
+					++o->frames;
+					ready = true;
+					break;
+				}
+			}
+			pm.idx = 0;
+			pm.done = false;
+		}
+
+		// The display interval is counted in iterations of a nominal 2 ms
+		if (++display_counter >= c->display_ms / 2) {
+			display_counter = 0;
+			if (ready && t >= tx_until) {
+				SPEND(costs[C_DISPLAY].cycles);
+				TX(110);
+			}
+		}
+
+		if (c->debug && t - latency_ns >= 10000000000ull && t >= tx_until) {
+			SPEND(costs[C_LATENCY].cycles);
+			TX(100);
+			latency_ns = t;
+		}
+
+#undef SPEND
+#undef TX
+		++o->iterations;
+		if (t - t0 > o->worst_ns)
+			o->worst_ns = t - t0;
+		o->busy_ns += (t - t0) - cycles_ns(costs[C_LOOP].cycles + extra);
+	}
+	o->dropped[0] = gps.dropped;
+	o->dropped[1] = pm.dropped;
+}
+
+static bool lossless(const outcome_t *o)
+{
+	return o->dropped[0] == 0 && o->dropped[1] == 0;
+}
+
+/**
+ * Largest extra cost with no loss
+ *
+ * @param	c	Configuration
+ * @param	base	Filled with the run at the table's costs
+ * @param	beyond	Filled with the run one cycle beyond the limit
+ *
+ * @return	The limit; 0 also when the table's costs already lose bytes,
+ *		LOOPCAP_MAX_EXTRA when no limit was found
+ */
+static uint32_t limit(const config_t *c, outcome_t *base, outcome_t *beyond)
+{
+	uint32_t lo = 0, hi = LOOPCAP_MAX_EXTRA;
+	outcome_t o;
+
+	run(c, 0, base);
+	*beyond = *base;
+	if (!lossless(base))
+		return 0;
+	run(c, hi, beyond);
+	if (lossless(beyond))
+		return hi;
+	while (hi - lo > 1) {
+		uint32_t mid = lo + (hi - lo) / 2;
+
+		run(c, mid, &o);
+		if (lossless(&o)) {
+			lo = mid;
+		} else {
+			hi = mid;
+			*beyond = o;
+		}
+	}
+	return lo;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Sweeps
+
+static const struct {
+	const char *name;
+	unsigned mask;
+} sentence_names[] = {
+	{ "rmc", SGEN_RMC }, { "gga", SGEN_GGA }, { "gll", SGEN_GLL },
+	{ "gsv", SGEN_GSV }, { "all", SGEN_ALL },
+};
+
+static int parse_sentences(const char *arg, unsigned *mask)
+{
+	char buf[64], *save = NULL;
+
+	*mask = 0;
+	snprintf(buf, sizeof(buf), "%s", arg);
+	for (char *tok = strtok_r(buf, ",+", &save); tok != NULL;
+	     tok = strtok_r(NULL, ",+", &save)) {
+		size_t i;
+
+		for (i = 0; i < sizeof(sentence_names) / sizeof(sentence_names[0]); ++i)
+			if (strcasecmp(tok, sentence_names[i].name) == 0)
+				break;
+		if (i == sizeof(sentence_names) / sizeof(sentence_names[0]))
+			return -1;
+		*mask |= sentence_names[i].mask;
+	}
+	return *mask ? 0 : -1;
+}
+
+static void format_sentences(unsigned mask, char *buf, size_t size)
+{
+	size_t n = 0;
+
+	buf[0] = '\0';
+	if (mask == SGEN_ALL) {
+		snprintf(buf, size, "all");
+		return;
+	}
+	for (size_t i = 0; i < 4; ++i)
+		if (mask & sentence_names[i].mask)
+			n += (size_t)snprintf(buf + n, size - n, "%s%s", n ? "+" : "",
+					      sentence_names[i].name);
+}
+
+/// A comma-separated list of numbers
+static int parse_list(const char *arg, double *out, unsigned max)
+{
+	unsigned n = 0;
+	char *end;
+
+	for (const char *p = arg; *p != '\0'; p = end + (*end == ',')) {
+		if (n == max)
+			return -1;
+		out[n++] = strtod(p, &end);
+		if (end == p || (*end != ',' && *end != '\0'))
+			return -1;
+	}
+	return (int)n;
+}
+
+static void print_header(void)
+{
+	printf("%6s %6s %5s %-16s %5s %5s | %9s %8s %6s | %9s %9s %s\n",
+	       "gps", "pm", "hz", "sentences", "disp", "debug",
+	       "worst us", "busy %", "lost", "extra cyc", "loop us", "first lost");
+}
+
+static void print_row(const config_t *c, uint32_t lim, const outcome_t *base,
+		      const outcome_t *beyond)
+{
+	char mix[32];
+
+	format_sentences(c->sentences, mix, sizeof(mix));
+	printf("%6ld %6ld %5g %-16s %5u %5s | %9.1f %8.2f %6llu | ",
+	       c->gps_baud, c->pm_baud, c->gps_hz, mix, c->display_ms,
+	       c->debug ? "on" : "off", base->worst_ns / 1e3,
+	       100.0 * base->busy_ns / (opt_secs * 1e9),
+	       (unsigned long long)(base->dropped[0] + base->dropped[1]));
+	if (lim == LOOPCAP_MAX_EXTRA)
+		printf("%9s %9s %s\n", ">max", "-", "-");
+	else if (!lossless(base))
+		printf("%9s %9s %s\n", "none", "-",
+		       base->dropped[0] ? (base->dropped[1] ? "both" : "gps") : "pm");
+	else
+		printf("%9u %9.1f %s\n", lim,
+		       cycles_ns(costs[C_LOOP].cycles + lim) / 1e3,
+		       beyond->dropped[0] ? (beyond->dropped[1] ? "both" : "gps")
+					  : "pm");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Self-check
+
+static int bench(void)
+{
+	static const long bauds[] = { 9600, 38400 };
+	static const double rates[] = { 1, 10 };
+	cost_t saved[NR_COSTS];
+	outcome_t base, beyond, o;
+	config_t c = { .pm_baud = 9600, .cdc_baud = 38400,
+		       .sentences = SGEN_RMC | SGEN_GGA | SGEN_GLL,
+		       .display_ms = 200 };
+	uint64_t t0 = now_ns();
+	unsigned runs = 0, bad = 0;
+
+	print_header();
+	for (size_t b = 0; b < 2; ++b)
+		for (size_t r = 0; r < 2; ++r)
+			for (int d = 0; d < 2; ++d) {
+				uint32_t lim;
+
+				c.gps_baud = bauds[b];
+				c.gps_hz = rates[r];
+				c.debug = d;
+				lim = limit(&c, &base, &beyond);
+				print_row(&c, lim, &base, &beyond);
+				++runs;
+				if (!lossless(&base) || lim == LOOPCAP_MAX_EXTRA)
+					continue;
+				run(&c, lim, &o);
+				if (!lossless(&o)) {
+					fprintf(stderr, "  limit %u loses bytes\n", lim);
+					++bad;
+				}
+				run(&c, lim + 1, &o);
+				if (lossless(&o)) {
+					fprintf(stderr, "  limit %u + 1 loses nothing\n", lim);
+					++bad;
+				}
+			}
+
+	/*
+	 * With only the loop cost, a line of back-to-back characters is read
+	 * one per iteration, and the SERCOM absorbs LOOPCAP_HW_DEPTH of any
+	 * shortfall: a burst of n characters survives iterations of up to
+	 * (n + depth) / n character times. A 10 Hz stream of every sentence
+	 * saturates 9600 baud, so n is the whole run.
+	 */
+	memcpy(saved, costs, sizeof(costs));
+	for (size_t i = 0; i < NR_COSTS; ++i)
+		costs[i].cycles = 0;
+	costs[C_LOOP].cycles = 1;
+	c.gps_baud = 9600;
+	c.pm_baud = 1200;
+	c.gps_hz = 10;
+	c.sentences = SGEN_ALL;
+	c.debug = false;
+	{
+		uint32_t lim = limit(&c, &base, &beyond);
+		double byte_cyc = 10.0 * LOOPCAP_CPU_HZ / 9600;
+
+		printf("  free stages, saturated 9600 baud: limit %u cycles, "
+		       "one character %.0f cycles\n", lim + 1, byte_cyc);
+		if (fabs((lim + 1) - byte_cyc) > byte_cyc * 0.01) {
+			fprintf(stderr, "  limit is off the analytic bound\n");
+			++bad;
+		}
+	}
+	memcpy(costs, saved, sizeof(costs));
+
+	printf("loopcap bench: %u configurations of %.0f s in %.2f s; %u problems\n",
+	       runs, opt_secs, (now_ns() - t0) / 1e9, bad);
+	return bad ? 1 : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-g GPS_BAUDS] [-p PM_BAUDS] [-c CDC_BAUD] [-r GPS_HZ_LIST]\n"
+		"       [-S SENTENCES]... [-d DISPLAY_MS_LIST] [-D 0,1] [-k NAME=CYCLES]...\n"
+		"       [-t SECONDS] [-s SEED]\n"
+		"       %s -B [-t SECONDS]\n"
+		"       %s -k help\n",
+		argv0, argv0, argv0);
+}
+
+static int set_cost(const char *arg)
+{
+	char name[32];
+	unsigned cyc;
+
+	if (strcmp(arg, "help") == 0) {
+		for (size_t i = 0; i < NR_COSTS; ++i)
+			printf("%-12s %6u  %s\n", costs[i].name, costs[i].cycles,
+			       costs[i].what);
+		exit(0);
+	}
+	if (sscanf(arg, "%31[^=]=%u", name, &cyc) != 2)
+		return -1;
+	for (size_t i = 0; i < NR_COSTS; ++i)
+		if (strcmp(name, costs[i].name) == 0) {
+			costs[i].cycles = cyc;
+			return 0;
+		}
+	return -1;
+}
+
+int main(int argc, char **argv)
+{
+	double gps_bauds[8] = { 9600, 38400 }, pm_bauds[8] = { 9600 };
+	double rates[8] = { 1, 5, 10 }, displays[8] = { 200 }, debugs[2] = { 0 };
+	int nr_gps = 2, nr_pm = 1, nr_rates = 3, nr_displays = 1, nr_debugs = 1;
+	unsigned mixes[8], nr_mixes = 0;
+	long cdc_baud = 38400;
+	bool do_bench = false;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "g:p:c:r:S:d:D:k:t:s:Bh")) != -1) {
+		switch (opt) {
+		case 'g': nr_gps = parse_list(optarg, gps_bauds, 8); break;
+		case 'p': nr_pm = parse_list(optarg, pm_bauds, 8); break;
+		case 'c': cdc_baud = strtol(optarg, NULL, 0); break;
+		case 'r': nr_rates = parse_list(optarg, rates, 8); break;
+		case 'd': nr_displays = parse_list(optarg, displays, 8); break;
+		case 'D': nr_debugs = parse_list(optarg, debugs, 2); break;
+		case 'S':
+			if (nr_mixes == 8 || parse_sentences(optarg, &mixes[nr_mixes]) != 0) {
+				fprintf(stderr, "bad sentence list: %s\n", optarg);
+				return 2;
+			}
+			++nr_mixes;
+			break;
+		case 'k':
+			if (set_cost(optarg) != 0) {
+				fprintf(stderr, "bad cost: %s (-k help lists them)\n", optarg);
+				return 2;
+			}
+			break;
+		case 't': opt_secs = strtod(optarg, NULL); break;
+		case 's': opt_seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'B': do_bench = true; break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (optind != argc || nr_gps <= 0 || nr_pm <= 0 || nr_rates <= 0 ||
+	    nr_displays <= 0 || nr_debugs <= 0 || cdc_baud < 1200 || opt_secs <= 0) {
+		usage(argv[0]);
+		return 2;
+	}
+	for (int i = 0; i < nr_gps; ++i)
+		for (int j = 0; j < nr_pm; ++j)
+			if (gps_bauds[i] < 1200 || pm_bauds[j] < 1200) {
+				usage(argv[0]);
+				return 2;
+			}
+	for (int i = 0; i < nr_rates; ++i)
+		if (!(rates[i] >= 0.1 && rates[i] <= 20)) {
+			usage(argv[0]);
+			return 2;
+		}
+	if (do_bench)
+		return bench();
+	if (nr_mixes == 0) {
+		mixes[nr_mixes++] = SGEN_RMC | SGEN_GGA | SGEN_GLL;
+		mixes[nr_mixes++] = SGEN_ALL;
+	}
+
+	print_header();
+	for (int a = 0; a < nr_gps; ++a)
+	for (int b = 0; b < nr_pm; ++b)
+	for (int r = 0; r < nr_rates; ++r)
+	for (unsigned m = 0; m < nr_mixes; ++m)
+	for (int d = 0; d < nr_displays; ++d)
+	for (int g = 0; g < nr_debugs; ++g) {
+		config_t c = {
+			.gps_baud = (long)gps_bauds[a], .pm_baud = (long)pm_bauds[b],
+			.cdc_baud = cdc_baud, .gps_hz = rates[r],
+			.sentences = mixes[m], .display_ms = (unsigned)displays[d],
+			.debug = debugs[g] != 0,
+		};
+		outcome_t base, beyond;
+		uint32_t lim = limit(&c, &base, &beyond);
+
+		print_row(&c, lim, &base, &beyond);
+		fflush(stdout);
+	}
+	return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * @file host/tools/sarcdump.c
+ * @brief Prints the index and rows of a columnar archive (host/lib/sarc.h).
+ *
+ * By default the rows are printed as CSV. -f and -t limit them to a time
+ * range; blocks outside the range are skipped through the index without
+ * being read, and the number of blocks read and skipped goes to stderr.
+ * -i prints the block index instead: offset, rows, size and the min/max of
+ * time, position and PM2.5 of each block.
+ *
+ * Times are UTC, as YYYY-MM-DDTHH:MM:SS or as ms since the epoch.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Ihost/lib -o sarcdump host/tools/sarcdump.c host/lib/sarc.c -lm
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 700
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sarc.h"
+
+/// Index of PM2.5 (atmospheric) in sarc_row_t.pm
+#define PM2_5_ATM	4
+
+/////////////////////////////////////////////////////////////////////////////
+
+static int parse_time(const char *s, int64_t *t_ms)
+{
+	struct tm tm = { 0 };
+	const char *end = strptime(s, "%Y-%m-%dT%H:%M:%S", &tm);
+	char *num_end;
+
+	if (end != NULL && *end == '\0') {
+		*t_ms = (int64_t)timegm(&tm) * 1000;
+		return 0;
+	}
+	*t_ms = strtoll(s, &num_end, 10);
+	return *s != '\0' && *num_end == '\0' ? 0 : -1;
+}
+
+static void print_time(int64_t t_ms)
+{
+	time_t sec = (time_t)(t_ms / 1000);
+	struct tm tm;
+	char buf[32];
+
+	if (t_ms == 0) {
+		fputs("-", stdout);
+		return;
+	}
+	gmtime_r(&sec, &tm);
+	strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%S", &tm);
+	printf("%s.%03d", buf, (int)(t_ms % 1000));
+}
+
+static void print_index(const sarc_reader_t *r)
+{
+	uint64_t rows = 0, bytes = 0;
+
+	printf("block,offset,rows,bytes,t_min,t_max,lat_min,lat_max,lon_min,lon_max,pm2_5_min,pm2_5_max\n");
+	for (uint32_t i = 0; i < sarc_nr_blocks(r); ++i) {
+		const sarc_block_info_t *bi = sarc_block_info(r, i);
+
+		printf("%" PRIu32 ",%" PRIu64 ",%" PRIu32 ",%" PRIu32 ",", i, bi->offset,
+		       bi->nr_rows, bi->payload_len + SARC_BLOCK_HDR_LEN);
+		print_time(bi->t_min);
+		putchar(',');
+		print_time(bi->t_max);
+		printf(",%.7f,%.7f,%.7f,%.7f,%u,%u\n", bi->lat_min, bi->lat_max,
+		       bi->lon_min, bi->lon_max, bi->pm_min[PM2_5_ATM], bi->pm_max[PM2_5_ATM]);
+		rows += bi->nr_rows;
+		bytes += bi->payload_len + SARC_BLOCK_HDR_LEN;
+	}
+	fprintf(stderr, "%" PRIu32 " blocks, %" PRIu64 " rows, %.2f bytes/row\n",
+		sarc_nr_blocks(r), rows, rows ? (double)bytes / rows : 0.0);
+}
+
+static int print_rows(sarc_reader_t *r, int64_t t_from, int64_t t_to)
+{
+	uint32_t read, skipped;
+	uint64_t n = 0;
+	sarc_row_t row;
+	int res;
+
+	printf("time,lat,lon,pm1_0_std,pm2_5_std,pm10_std,pm1_0_atm,pm2_5_atm,pm10_atm,"
+	       "n0_3,n0_5,n1_0,n2_5,n5_0,n10\n");
+	sarc_set_range(r, t_from, t_to);
+	while ((res = sarc_next(r, &row)) == 1) {
+		print_time(row.t_ms);
+		if (isnan(row.lat))
+			printf(",,");
+		else
+			printf(",%.7f,%.7f", row.lat, row.lon);
+		for (int k = 0; k < SARC_NR_PM; ++k)
+			printf(",%u", row.pm[k]);
+		putchar('\n');
+		++n;
+	}
+	sarc_scan_stats(r, &read, &skipped);
+	fprintf(stderr, "%" PRIu64 " rows; %" PRIu32 " blocks read, %" PRIu32 " skipped\n",
+		n, read, skipped);
+	if (res < 0) {
+		fprintf(stderr, "damaged block\n");
+		return 1;
+	}
+	return 0;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr, "usage: %s [-i] [-f FROM] [-t TO] ARCHIVE\n", argv0);
+}
+
+int main(int argc, char **argv)
+{
+	int64_t t_from = INT64_MIN, t_to = INT64_MAX;
+	int index = 0, c, res;
+	sarc_reader_t *r;
+
+	while ((c = getopt(argc, argv, "if:t:h")) != -1) {
+		switch (c) {
+		case 'i': index = 1; break;
+		case 'f':
+		case 't':
+			if (parse_time(optarg, c == 'f' ? &t_from : &t_to) != 0) {
+				fprintf(stderr, "bad time: %s\n", optarg);
+				return 1;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 1;
+	}
+	if ((r = sarc_open(argv[optind])) == NULL) {
+		if (errno == EINVAL)
+			fprintf(stderr, "%s: not an archive\n", argv[optind]);
+		else
+			perror(argv[optind]);
+		return 1;
+	}
+	res = 0;
+	if (index)
+		print_index(r);
+	else
+		res = print_rows(r, t_from, t_to);
+	sarc_close_reader(r);
+	return res;
+}
@@ -0,0 +1,364 @@
+/**
+ * @file host/tools/sarcq.c
+ * @brief Aggregate queries over columnar archives (host/lib/sarcq.h).
+ *
+ * Prints the count, mean, min, max and (with -p) percentiles of one PM
+ * channel over the rows of one or more archives that fall in a time range
+ * and, with -b, a latitude/longitude box:
+ *
+ *   sarcq -c pm2_5_atm -f 2025-05-06T00:00:00 -t 2025-05-06T23:59:59 \
+ *         -b 14.64,121.06,14.66,121.08 -p 50,90,99 archive/unit07_putty.log.sarc
+ *
+ * Blocks outside the query are never read, blocks wholly inside it are
+ * answered from the archive index, and only the edges are decoded; the
+ * block counts are printed with the result.
+ *
+ * -G writes a synthetic archive of a given size (a unit logging at 1 Hz in
+ * sessions of a few hours, walking slowly, with drifting readings), and -B
+ * times queries of growing width against one, next to a full decode.
+ *
+ * Times are UTC, as YYYY-MM-DDTHH:MM:SS or as ms since the epoch.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Ihost/lib -o sarcq host/tools/sarcq.c host/lib/sarcq.c \
+ *      host/lib/sarc.c -lm
+ */
+
+#define _DEFAULT_SOURCE
+#define _XOPEN_SOURCE 700
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sarcq.h"
+
+#define MAX_PCTS	16
+
+/// sarc_row_t.pm, in order
+static const char *const columns[SARC_NR_PM] = {
+	"pm1_0_std", "pm2_5_std", "pm10_std", "pm1_0_atm", "pm2_5_atm", "pm10_atm",
+	"n0_3", "n0_5", "n1_0", "n2_5", "n5_0", "n10",
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int parse_time(const char *s, int64_t *t_ms)
+{
+	struct tm tm = { 0 };
+	const char *end = strptime(s, "%Y-%m-%dT%H:%M:%S", &tm);
+	char *num_end;
+
+	if (end != NULL && *end == '\0') {
+		*t_ms = (int64_t)timegm(&tm) * 1000;
+		return 0;
+	}
+	*t_ms = strtoll(s, &num_end, 10);
+	return *s != '\0' && *num_end == '\0' ? 0 : -1;
+}
+
+static int parse_box(const char *s, sarcq_query_t *qq)
+{
+	double lat0, lon0, lat1, lon1;
+
+	if (sscanf(s, "%lf,%lf,%lf,%lf", &lat0, &lon0, &lat1, &lon1) != 4)
+		return -1;
+	qq->bbox = true;
+	qq->lat_min = fmin(lat0, lat1);
+	qq->lat_max = fmax(lat0, lat1);
+	qq->lon_min = fmin(lon0, lon1);
+	qq->lon_max = fmax(lon0, lon1);
+	return 0;
+}
+
+static int parse_column(const char *s)
+{
+	for (int k = 0; k < SARC_NR_PM; ++k)
+		if (strcmp(s, columns[k]) == 0)
+			return k;
+	return -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Synthetic archives
+
+/// Deterministic PRNG (xorshift32), so generated archives are reproducible
+static uint32_t rng_state = 0x2545F491;
+static uint32_t rng_next(void)
+{
+	uint32_t x = rng_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+
+/// Step a reading by -1, 0 or +1 within [lo, hi], like a slowly drifting sensor
+static unsigned drift(unsigned v, unsigned lo, unsigned hi)
+{
+	unsigned r = rng_next() % 4;
+
+	if (r == 0 && v > lo)
+		return v - 1;
+	if (r == 1 && v < hi)
+		return v + 1;
+	return v;
+}
+
+static int generate(const char *path, double gbytes)
+{
+	uint64_t target = (uint64_t)(gbytes * 1024 * 1024 * 1024), rows = 0;
+	int64_t t = 1704067200000;		// 2024-01-01T00:00:00Z
+	unsigned lat = 390000, lon = 40000;	// 1e-4 minutes past 14 N, 121 E
+	unsigned pm[SARC_NR_PM] = { 18, 25, 31, 14, 21, 29, 3100, 920, 160, 12, 3, 1 };
+	uint32_t session = 0;
+	uint64_t t0 = now_ns();
+	sarc_writer_t *w = sarc_create(path);
+
+	if (w == NULL) {
+		perror(path);
+		return 1;
+	}
+	while (sarc_bytes_written(w) < target) {
+		sarc_row_t row;
+
+		if (session == 0) {
+			// Off for 30 min to 16 h, then on for 1 to 8 h
+			t += (1800 + (int64_t)(rng_next() % 55800)) * 1000;
+			session = 3600 + rng_next() % 25200;
+		}
+		--session;
+		t += rng_next() % 64 ? 1000 : 2000;	// The odd sample is lost
+		if (rng_next() % 8 == 0) {
+			lat = drift(lat, 10000, 590000);
+			lon = drift(lon, 10000, 590000);
+		}
+		row.t_ms = t;
+		if (rng_next() % 256 == 0) {
+			row.lat = row.lon = NAN;	// Lost the fix for a moment
+		} else {
+			row.lat = 14.0 + lat / 10000.0 / 60.0;
+			row.lon = 121.0 + lon / 10000.0 / 60.0;
+		}
+		for (int k = 0; k < SARC_NR_PM; ++k)
+			row.pm[k] = (uint16_t)(pm[k] = drift(pm[k], 0, k < 6 ? 500 : 20000));
+		if (sarc_append(w, &row) != 0)
+			break;
+		++rows;
+	}
+	if (sarc_close(w) != 0) {
+		perror(path);
+		return 1;
+	}
+	fprintf(stderr, "%s: %" PRIu64 " rows in %.1f s\n", path, rows, (now_ns() - t0) / 1e9);
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+static int bench(const char *path, int reps)
+{
+	static const struct {
+		const char *name;
+		int64_t ms;
+	} widths[] = {
+		{ "1 hour", 3600000 },
+		{ "1 day", 86400000 },
+		{ "1 week", 7 * 86400000LL },
+		{ "30 days", 30 * 86400000LL },
+		{ "all", 0 },
+	};
+	sarcq_t *q = sarcq_open(path);
+	int64_t t_min, t_max;
+	sarc_reader_t *r;
+	sarc_row_t row;
+	sarcq_query_t qq;
+	uint64_t t0, n = 0, sum = 0;
+	int k = 4;	// pm2_5_atm
+
+	if (q == NULL) {
+		perror(path);
+		return 1;
+	}
+	sarcq_time_span(q, &t_min, &t_max);
+	printf("%s: %" PRIu64 " rows, %" PRIu32 " blocks\n", path, sarcq_nr_rows(q),
+	       sarcq_nr_blocks(q));
+	printf("%-8s %12s %10s %9s %9s %12s %10s\n", "window", "rows", "mean ms",
+	       "indexed", "decoded", "+pct ms", "decoded");
+
+	for (size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); ++w) {
+		uint64_t dt[2] = { 0, 0 }, rows = 0, indexed = 0, decoded[2] = { 0, 0 };
+
+		for (int i = 0; i < reps; ++i) {
+			int64_t span = t_max - t_min - widths[w].ms;
+
+			sarcq_query_init(&qq);
+			if (widths[w].ms != 0) {
+				qq.t_from = t_min + (int64_t)((double)rng_next() / UINT32_MAX * span);
+				qq.t_to = qq.t_from + widths[w].ms - 1;
+			}
+			for (int pct = 0; pct < 2; ++pct) {
+				sarcq_agg_t a;
+
+				if (sarcq_agg_init(&a, pct) != 0)
+					return 1;
+				t0 = now_ns();
+				if (sarcq_aggregate(q, &qq, k, &a) != 0 ||
+				    (pct && sarcq_agg_percentile(&a, 99) > a.max)) {
+					fprintf(stderr, "%s: damaged\n", path);
+					return 1;
+				}
+				dt[pct] += now_ns() - t0;
+				decoded[pct] += a.blocks_decoded;
+				if (!pct) {
+					rows += a.count;
+					indexed += a.blocks_indexed;
+				}
+				sarcq_agg_free(&a);
+			}
+		}
+		printf("%-8s %12" PRIu64 " %10.3f %9.1f %9.1f %12.3f %10.1f\n", widths[w].name,
+		       rows / reps, dt[0] / 1e6 / reps, (double)indexed / reps,
+		       (double)decoded[0] / reps, dt[1] / 1e6 / reps, (double)decoded[1] / reps);
+	}
+	sarcq_close(q);
+
+	// What answering without an index costs: decode everything
+	if ((r = sarc_open(path)) == NULL) {
+		perror(path);
+		return 1;
+	}
+	t0 = now_ns();
+	while (sarc_next(r, &row) == 1) {
+		sum += row.pm[k];
+		++n;
+	}
+	printf("full decode: %" PRIu64 " rows in %.1f ms (mean %.2f)\n", n,
+	       (now_ns() - t0) / 1e6, n ? (double)sum / n : 0.0);
+	sarc_close_reader(r);
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-c COLUMN] [-f FROM] [-t TO] [-b LAT0,LON0,LAT1,LON1]\n"
+		"          [-p PCT[,PCT...]] ARCHIVE...\n"
+		"       %s -G ARCHIVE [-n GBYTES] [-s SEED]\n"
+		"       %s -B ARCHIVE [-r REPEATS]\n",
+		argv0, argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *gen = NULL, *bench_path = NULL;
+	double gbytes = 2.0, pcts[MAX_PCTS];
+	int nr_pcts = 0, k = 4, reps = 20, c;
+	sarcq_query_t qq;
+	sarcq_agg_t a;
+	uint64_t t0;
+
+	sarcq_query_init(&qq);
+	while ((c = getopt(argc, argv, "c:f:t:b:p:G:n:s:B:r:h")) != -1) {
+		switch (c) {
+		case 'c':
+			if ((k = parse_column(optarg)) < 0) {
+				fprintf(stderr, "unknown column: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'f':
+		case 't':
+			if (parse_time(optarg, c == 'f' ? &qq.t_from : &qq.t_to) != 0) {
+				fprintf(stderr, "bad time: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'b':
+			if (parse_box(optarg, &qq) != 0) {
+				fprintf(stderr, "bad box: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'p':
+			for (char *s = optarg, *end; *s != '\0' && nr_pcts < MAX_PCTS; s = end) {
+				pcts[nr_pcts] = strtod(s, &end);
+				if (end == s || pcts[nr_pcts] <= 0 || pcts[nr_pcts] > 100) {
+					fprintf(stderr, "bad percentile: %s\n", s);
+					return 1;
+				}
+				++nr_pcts;
+				if (*end == ',')
+					++end;
+			}
+			break;
+		case 'G': gen = optarg; break;
+		case 'n': gbytes = strtod(optarg, NULL); break;
+		case 's': rng_state = (uint32_t)strtoul(optarg, NULL, 0) | 1u; break;
+		case 'B': bench_path = optarg; break;
+		case 'r': reps = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (gen != NULL)
+		return generate(gen, gbytes);
+	if (bench_path != NULL)
+		return bench(bench_path, reps);
+	if (optind == argc) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	if (sarcq_agg_init(&a, nr_pcts > 0) != 0) {
+		perror("sarcq");
+		return 1;
+	}
+	t0 = now_ns();
+	for (int i = optind; i < argc; ++i) {
+		sarcq_t *q = sarcq_open(argv[i]);
+
+		if (q == NULL) {
+			if (errno == EINVAL)
+				fprintf(stderr, "%s: not an archive\n", argv[i]);
+			else
+				perror(argv[i]);
+			return 1;
+		}
+		if (sarcq_aggregate(q, &qq, k, &a) != 0) {
+			fprintf(stderr, "%s: damaged block\n", argv[i]);
+			return 1;
+		}
+		sarcq_close(q);
+	}
+
+	printf("%s: %" PRIu64 " rows", columns[k], a.count);
+	if (a.count > 0) {
+		printf(", mean %.2f, min %u, max %u", sarcq_agg_mean(&a), a.min, a.max);
+		for (int i = 0; i < nr_pcts; ++i)
+			printf(", p%g %u", pcts[i], sarcq_agg_percentile(&a, pcts[i]));
+	}
+	printf("\nblocks: %" PRIu64 " from the index, %" PRIu64 " decoded, %" PRIu64
+	       " skipped, in %.3f ms\n", a.blocks_indexed, a.blocks_decoded,
+	       a.blocks_skipped, (now_ns() - t0) / 1e6);
+	sarcq_agg_free(&a);
+	return 0;
+}
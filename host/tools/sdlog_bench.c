@@ -0,0 +1,389 @@
+/**
+ * @file host/tools/sdlog_bench.c
+ * @brief Sustained-throughput and latency benchmark for the SD card log.
+ *
+ * Runs the firmware's SD backend (src/logstore_sd.c) and card driver
+ * (src/sdcard.c) on virtual time against the card model in host/sim, with an
+ * image file standing in for the card. The main loop is simulated as one
+ * call to logstore_service() every -L microseconds, with records appended at
+ * a fixed rate (or, with -F, whenever the log accepts them).
+ *
+ * Reported:
+ * - sustained write throughput (bytes that reached the card per second)
+ * - per-record latency from logstore_append() until the record is on the
+ *   card (p50/p99/max), and records dropped because the card fell behind
+ * - the most SPI work started by a single service call, to show the main
+ *   loop is never held up by the card
+ *
+ * Afterwards the log is drained, the "board" is restarted on the same image,
+ * and the remounted log is read back and compared with what was appended.
+ * Running the tool again without -n appends to the same log.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -Ihost/sim -DLOGSTORE_BACKEND=1 -o sdlog_bench \
+ *      host/tools/sdlog_bench.c host/sim/sim_sdcard.c src/logstore_sd.c \
+ *      src/sdcard.c src/crc32.c
+ */
+
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "logstore.h"
+#include "sdcard.h"
+#include "sim_sdcard.h"
+#include "uplink.h"
+
+#if LOGSTORE_BACKEND != LOGSTORE_BACKEND_SD
+#error "Build with -DLOGSTORE_BACKEND=1"
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+// Virtual platform
+
+uint64_t sim_now_us;
+
+void platform_tick_count(platform_timespec_t *tick)
+{
+	tick->nr_sec  = (uint32_t)(sim_now_us / 1000000u);
+	tick->nr_nsec = (uint32_t)(sim_now_us % 1000000u) * 1000u;
+}
+
+void platform_tick_hrcount(platform_timespec_t *tick)
+{
+	platform_tick_count(tick);
+}
+
+/// One main-loop iteration: service the log and account for the SPI work
+static uint64_t loop_us = 50;
+static uint64_t svc_calls;
+static uint32_t svc_max_xfers, svc_max_bytes;
+
+static void loop_once(void)
+{
+	platform_timespec_t now;
+	sim_sd_stats_t a, b;
+
+	sim_sd_get_stats(&a);
+	platform_tick_count(&now);
+	logstore_service(&now);
+	sim_sd_get_stats(&b);
+
+	++svc_calls;
+	if (b.xfers - a.xfers > svc_max_xfers)
+		svc_max_xfers = (uint32_t)(b.xfers - a.xfers);
+	if (b.bytes_clocked - a.bytes_clocked > svc_max_bytes)
+		svc_max_bytes = (uint32_t)(b.bytes_clocked - a.bytes_clocked);
+	sim_now_us += loop_us;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Record bookkeeping
+
+/// Records not yet on the card: where each ends in the stream, and when it came
+static struct pending_type {
+	uint32_t end;
+	uint64_t t_us;
+} *pend;
+static size_t pend_head, pend_tail, pend_cap;
+
+static uint32_t *lat_us;
+static size_t lat_nr, lat_cap;
+
+/// Everything appended in this run, for the read-back check
+static uint8_t *ref;
+static size_t ref_len, ref_cap;
+
+static void *grow(void *p, size_t *cap, size_t need, size_t elem)
+{
+	if (need <= *cap)
+		return p;
+	*cap = (*cap == 0) ? 4096 : *cap;
+	while (*cap < need)
+		*cap *= 2;
+	p = realloc(p, *cap * elem);
+	if (p == NULL) {
+		perror("realloc");
+		exit(1);
+	}
+	return p;
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void note_durable(void)
+{
+	logstore_stats_t st;
+
+	logstore_get_stats(&st);
+	while (pend_tail < pend_head && pend[pend_tail].end <= st.bytes_durable) {
+		lat_us = grow(lat_us, &lat_cap, lat_nr + 1, sizeof(*lat_us));
+		lat_us[lat_nr++] = (uint32_t)(sim_now_us - pend[pend_tail].t_us);
+		++pend_tail;
+	}
+}
+
+static uint32_t rec_counter;
+
+/// Append one PM-style record of @p len data bytes; false if it was dropped
+static bool append_one(unsigned len)
+{
+	uint8_t rec[255];
+	uint32_t ts_ms = (uint32_t)(sim_now_us / 1000u);
+	logstore_stats_t st;
+
+	memcpy(&rec[0], &ts_ms, 4);
+	memcpy(&rec[4], &rec_counter, 4);
+	for (unsigned i = 8; i < len; ++i)
+		rec[i] = (uint8_t)(rec_counter * 7u + i);
+	if (!logstore_append(UPLINK_REC_PM, rec, (uint16_t)len))
+		return false;
+	++rec_counter;
+
+	ref = grow(ref, &ref_cap, ref_len + 2 + len, 1);
+	ref[ref_len++] = UPLINK_REC_PM;
+	ref[ref_len++] = (uint8_t)len;
+	memcpy(&ref[ref_len], rec, len);
+	ref_len += len;
+
+	logstore_get_stats(&st);
+	pend = grow(pend, &pend_cap, pend_head + 1, sizeof(*pend));
+	pend[pend_head].end = st.bytes_appended;
+	pend[pend_head].t_us = sim_now_us;
+	++pend_head;
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// Wait (in virtual time) for the log to mount; false on timeout
+static bool wait_mounted(double *secs)
+{
+	uint64_t t0 = sim_now_us;
+	logstore_stats_t st;
+
+	do {
+		loop_once();
+		logstore_get_stats(&st);
+	} while (!st.card_ok && sim_now_us - t0 < 5000000);
+	*secs = (sim_now_us - t0) / 1e6;
+	return st.card_ok;
+}
+
+/// Read the whole log back through logstore_read_block()
+static uint8_t *read_back(uint32_t first, uint32_t end, size_t *len)
+{
+	uint8_t *out = malloc((size_t)(end - first) * LOGSTORE_BLOCK_SZ + 1);
+	size_t n = 0;
+
+	if (out == NULL)
+		return NULL;
+	for (uint32_t b = first; b < end; ++b) {
+		uint16_t got;
+
+		while ((got = logstore_read_block(b, &out[n])) == LOGSTORE_READ_PENDING)
+			loop_once();
+		if (got < LOGSTORE_BLOCK_SZ && b + 1 != end) {
+			fprintf(stderr, "read-back: block %u has %u bytes\n", b, got);
+			free(out);
+			return NULL;
+		}
+		n += got;
+	}
+	*len = n;
+	return out;
+}
+
+/// Walk the record framing of a stream; returns the number of records
+static long count_records(const uint8_t *s, size_t len)
+{
+	size_t off = 0;
+	long nr = 0;
+
+	while (off + 2 <= len) {
+		if (s[off] != UPLINK_REC_PM && s[off] != UPLINK_REC_GPS)
+			return -1;
+		off += 2u + s[off + 1];
+		++nr;
+	}
+	return (off == len) ? nr : -1;
+}
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-i IMAGE] [-m CARD_MIB] [-n] [-t SECONDS] [-r REC_PER_S]\n"
+		"          [-z REC_BYTES] [-F] [-L LOOP_US] [-p PROG_US] [-e ERASE_US]\n"
+		"          [-o OPEN_US] [-g GC_EVERY_BLOCKS] [-G GC_US] [-H]\n"
+		"          [-P PULL_AT_S] [-W PULL_FOR_S]\n",
+		argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *img = "sdlog.img";
+	sim_sd_timing_t timing = SIM_SD_TIMING_DEFAULT;
+	uint32_t card_mib = 64;
+	bool fresh = false, flood = false;
+	double secs = 60.0, rate = 100.0, pull_at = -1.0, pull_for = 0.0;
+	unsigned rec_len = 26;
+	logstore_stats_t st;
+	sd_stats_t sds;
+	sim_sd_stats_t cs;
+	double mount_s, drain_s;
+	uint64_t t_end, next_rec_us = 0, interval_us;
+	uint32_t first, end;
+	unsigned long dropped = 0;
+	uint8_t *back;
+	size_t back_len = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "i:m:nt:r:z:FL:p:e:o:g:G:HP:W:h")) != -1) {
+		switch (c) {
+		case 'i': img = optarg; break;
+		case 'm': card_mib = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'n': fresh = true; break;
+		case 't': secs = strtod(optarg, NULL); break;
+		case 'r': rate = strtod(optarg, NULL); break;
+		case 'z': rec_len = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'F': flood = true; break;
+		case 'L': loop_us = strtoull(optarg, NULL, 0); break;
+		case 'p': timing.prog_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'e': timing.erase_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'o': timing.open_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'g': timing.gc_every = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'G': timing.gc_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'H': timing.ignore_hint = true; break;
+		case 'P': pull_at = strtod(optarg, NULL); break;
+		case 'W': pull_for = strtod(optarg, NULL); break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (rec_len < 8 || rec_len > 255 || rate <= 0 || loop_us == 0 || card_mib < 2) {
+		usage(argv[0]);
+		return 1;
+	}
+	if (sim_sd_open(img, card_mib * 2048u, fresh, &timing) < 0) {
+		perror(img);
+		return 1;
+	}
+
+	// Boot
+	logstore_init();
+	if (!wait_mounted(&mount_s)) {
+		fprintf(stderr, "%s: the log did not mount\n", img);
+		return 1;
+	}
+	first = logstore_first_block();
+	end = logstore_end_block();
+	printf("card:     %u MiB image %s, SPI %.1f MHz; prog %u us/blk, open %u us, "
+	       "erase %u us/blk%s, GC %u ms every %u blk\n",
+	       card_mib, img, sim_sd_spi_hz() / 1e6, timing.prog_us,
+	       timing.open_us, timing.erase_us,
+	       timing.ignore_hint ? " (hint ignored)" : " unless pre-erased",
+	       timing.gc_us / 1000, timing.gc_every);
+	printf("mount:    %.1f ms, log holds blocks %u..%u\n", mount_s * 1e3, first, end);
+	if (flood)
+		printf("load:     flood (%u B records, as fast as accepted) for %.0f s, "
+		       "main loop every %llu us\n", rec_len, secs,
+		       (unsigned long long)loop_us);
+	else
+		printf("load:     %.0f rec/s x %u B (%.0f B/s) for %.0f s, "
+		       "main loop every %llu us\n", rate, rec_len,
+		       rate * (rec_len + 2), secs, (unsigned long long)loop_us);
+
+	// Run
+	interval_us = (uint64_t)(1e6 / rate);
+	next_rec_us = sim_now_us;
+	t_end = sim_now_us + (uint64_t)(secs * 1e6);
+	while (sim_now_us < t_end) {
+		if (pull_at >= 0 && sim_now_us >= (uint64_t)(pull_at * 1e6)) {
+			uint64_t back_us = (uint64_t)((pull_at + pull_for) * 1e6);
+			sim_sd_set_present(sim_now_us >= back_us);
+		}
+		if (flood) {
+			while (append_one(rec_len))
+				;
+		} else {
+			while (next_rec_us <= sim_now_us) {
+				if (!append_one(rec_len))
+					++dropped;
+				next_rec_us += interval_us;
+			}
+		}
+		loop_once();
+		note_durable();
+	}
+	logstore_get_stats(&st);
+	printf("run:      %u records (%u B) appended, %lu dropped; %u B on the card "
+	       "= %.1f kB/s sustained\n",
+	       st.records_appended, st.bytes_appended, dropped,
+	       st.bytes_durable, st.bytes_durable / secs / 1e3);
+
+	// Drain, then report
+	{
+		uint64_t t0 = sim_now_us;
+
+		do {
+			loop_once();
+			note_durable();
+			logstore_get_stats(&st);
+		} while (st.bytes_durable < st.bytes_appended &&
+			 sim_now_us - t0 < 30000000);
+		drain_s = (sim_now_us - t0) / 1e6;
+	}
+	sd_get_stats(&sds);
+	sim_sd_get_stats(&cs);
+	printf("writes:   %u blocks in %u batches (%.1f blk/batch, %u/%u commands "
+	       "pre-erased), %u write errors; drained in %.2f s\n",
+	       st.blocks_written, st.write_batches,
+	       st.write_batches ? (double)st.blocks_written / st.write_batches : 0.0,
+	       cs.hinted_cmds, cs.write_cmds, st.write_errors, drain_s);
+	printf("card:     busy %.1f%% of the time, longest busy %.1f ms, %u GC stalls\n",
+	       100.0 * cs.busy_us / (double)sim_now_us, sds.busy_max_us / 1e3,
+	       cs.gc_stalls);
+	if (lat_nr > 0) {
+		qsort(lat_us, lat_nr, sizeof(*lat_us), cmp_u32);
+		printf("latency:  append -> on card: p50 %.1f ms, p99 %.1f ms, "
+		       "max %.1f ms (%zu records)\n",
+		       lat_us[lat_nr / 2] / 1e3, lat_us[lat_nr * 99 / 100] / 1e3,
+		       lat_us[lat_nr - 1] / 1e3, lat_nr);
+	}
+	printf("loop:     %llu service calls; at most %u SPI transfers (%u B) "
+	       "started by one call, longest transfer %u B\n",
+	       (unsigned long long)svc_calls, svc_max_xfers, svc_max_bytes,
+	       cs.xfer_max);
+
+	// Restart on the same image and read the log back
+	logstore_init();
+	if (!wait_mounted(&mount_s)) {
+		printf("remount:  FAILED\n");
+		return 2;
+	}
+	first = logstore_first_block();
+	end = logstore_end_block();
+	back = read_back(first, end, &back_len);
+	printf("remount:  %.1f ms, log holds blocks %u..%u (%zu B, %ld records)\n",
+	       mount_s * 1e3, first, end, back_len,
+	       back ? count_records(back, back_len) : -1L);
+	if (back == NULL || back_len < st.bytes_durable ||
+	    memcmp(&back[back_len - st.bytes_durable], ref, st.bytes_durable) != 0 ||
+	    count_records(back, back_len) < 0) {
+		printf("verify:   MISMATCH\n");
+		return 2;
+	}
+	printf("verify:   the %u B appended in this run read back intact%s\n",
+	       st.bytes_durable,
+	       st.bytes_durable < st.bytes_appended ? " (minus the undrained tail)" : "");
+	free(back);
+	sim_sd_close();
+	return 0;
+}
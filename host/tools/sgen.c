@@ -0,0 +1,501 @@
+/**
+ * @file host/tools/sgen.c
+ * @brief Generates GPS and PMS5003 sensor streams (host/lib/sgen.h).
+ *
+ * The captures taken so far were made at 1 Hz and mostly without a fix, so
+ * they cannot load the parsers with 10 Hz fixes, long routes or heavy PM
+ * traffic. This tool writes what the two sensors would send for -t seconds:
+ * NMEA epochs to -g and PMS5003 frames to -q, and optionally the true
+ * position and PM2.5 of every frame to -c as CSV, for checking what a
+ * pipeline made of the streams.
+ *
+ * Each line is a UART at -b baud. An epoch that does not fit on the line
+ * before the next one starts loses its last sentences whole, as a receiver
+ * set to too high a rate for its baud rate does; the same applies to PM
+ * frames. A regular file or pipe gets the streams as fast as they can be
+ * generated, with the times in the sentences running from the start time
+ * (-z); a terminal or pty gets them in real time, set to the baud rate.
+ *
+ * With -B the tool instead generates -t seconds of both streams (an hour by
+ * default), times the generator, and decodes the result with the firmware's
+ * parsers (host/lib/sdec.h): every sentence and frame must decode, and every
+ * decoded position must lie close to the true one.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -Ihost/lib -o sgen host/tools/sgen.c host/lib/sgen.c \
+ *      host/lib/sdec.c src/parsers/nmea_parse.c src/parsers/pms_parser.c -lm
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sdec.h"
+#include "sgen.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define SGEN_MAX_HOTSPOTS	16
+
+static long opt_baud = 38400;
+static double opt_secs = -1;		// -1: default for the mode
+
+static volatile sig_atomic_t stop_requested;
+
+static void on_signal(int sig)
+{
+	(void)sig;
+	stop_requested = 1;
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static speed_t baud_to_speed(long baud)
+{
+	switch (baud) {
+	case 9600:	return B9600;
+	case 19200:	return B19200;
+	case 38400:	return B38400;
+	case 57600:	return B57600;
+	case 115200:	return B115200;
+	case 230400:	return B230400;
+	case 460800:	return B460800;
+	default:	return 0;
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Lines
+
+/// One sensor's UART
+typedef struct line_type {
+	int      fd;
+	bool     tty;
+	uint64_t busy_us;	///< The line is busy until this time
+	uint64_t items, bytes;	///< Sentences or frames sent, and their bytes
+	uint64_t cut;		///< Sentences or frames that did not fit
+} line_t;
+
+static int line_open(line_t *l, const char *path)
+{
+	struct stat st;
+
+	memset(l, 0, sizeof(*l));
+	if (strcmp(path, "-") == 0)
+		l->fd = STDOUT_FILENO;
+	else if ((l->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_NOCTTY, 0644)) < 0) {
+		perror(path);
+		return -1;
+	}
+	if (fstat(l->fd, &st) == 0 && S_ISCHR(st.st_mode) && isatty(l->fd)) {
+		struct termios tio;
+		speed_t sp = baud_to_speed(opt_baud);
+
+		l->tty = true;
+		if (tcgetattr(l->fd, &tio) == 0) {
+			cfmakeraw(&tio);
+			if (sp != 0) {
+				cfsetispeed(&tio, sp);
+				cfsetospeed(&tio, sp);
+			}
+			tcsetattr(l->fd, TCSANOW, &tio);
+		}
+	}
+	return 0;
+}
+
+/**
+ * Keep the items of @p buf that fit on the line between @p t_us and
+ * @p next_us, dropping the rest whole; returns the bytes kept
+ *
+ * Items are NMEA sentences (up to a '\n') or, with @p item > 0, blocks of
+ * that many bytes.
+ */
+static size_t line_fit(line_t *l, uint64_t t_us, uint64_t next_us,
+		       char *buf, size_t len, size_t item)
+{
+	uint64_t cursor = l->busy_us > t_us ? l->busy_us : t_us;
+	size_t in = 0, out = 0;
+
+	while (in < len) {
+		size_t n = item;
+		uint64_t end;
+
+		if (n == 0) {
+			const char *nl = memchr(buf + in, '\n', len - in);
+
+			n = nl ? (size_t)(nl - (buf + in)) + 1 : len - in;
+		}
+		end = cursor + (uint64_t)(n * 10 * 1e6 / opt_baud);
+		if (end > next_us) {
+			++l->cut;
+		} else {
+			memmove(buf + out, buf + in, n);
+			out += n;
+			cursor = end;
+			++l->items;
+			l->bytes += n;
+		}
+		in += n;
+	}
+	l->busy_us = cursor;
+	return out;
+}
+
+static int write_all(int fd, const void *buf, size_t len)
+{
+	const char *p = buf;
+
+	while (len > 0) {
+		ssize_t w = write(fd, p, len);
+
+		if (w < 0) {
+			if (errno == EINTR)
+				continue;
+			return -1;
+		}
+		p += w;
+		len -= (size_t)w;
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Options
+
+static int parse_sentences(const char *arg, unsigned *mask)
+{
+	char tmp[64], *tok, *save = NULL;
+
+	*mask = 0;
+	snprintf(tmp, sizeof(tmp), "%s", arg);
+	for (tok = strtok_r(tmp, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+		if (strcasecmp(tok, "rmc") == 0)
+			*mask |= SGEN_RMC;
+		else if (strcasecmp(tok, "gga") == 0)
+			*mask |= SGEN_GGA;
+		else if (strcasecmp(tok, "gll") == 0)
+			*mask |= SGEN_GLL;
+		else if (strcasecmp(tok, "gsv") == 0)
+			*mask |= SGEN_GSV;
+		else if (strcasecmp(tok, "all") == 0)
+			*mask |= SGEN_ALL;
+		else
+			return -1;
+	}
+	return *mask ? 0 : -1;
+}
+
+static int parse_hotspot(const char *arg, sgen_hotspot_t *h)
+{
+	return sscanf(arg, "%lf,%lf,%lf,%lf", &h->lat, &h->lon, &h->radius_m,
+		      &h->peak) == 4 && h->radius_m > 0 ? 0 : -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Generating
+
+static int generate(const sgen_cfg_t *cfg, const char *gps_path,
+		    const char *pm_path, const char *truth_path)
+{
+	uint64_t gps_step = (uint64_t)(1e6 / cfg->gps_hz), pm_step = (uint64_t)(1e6 / cfg->pm_hz);
+	uint64_t ne = 0, nf = 0, dur_us, t0 = now_ns();
+	line_t gps = { .fd = -1 }, pm = { .fd = -1 };
+	FILE *truth = NULL;
+	bool realtime;
+	sgen_t g;
+
+	if ((gps_path != NULL && line_open(&gps, gps_path) != 0) ||
+	    (pm_path != NULL && line_open(&pm, pm_path) != 0))
+		return 1;
+	realtime = gps.tty || pm.tty;
+	if (truth_path != NULL) {
+		if ((truth = fopen(truth_path, "w")) == NULL) {
+			perror(truth_path);
+			return 1;
+		}
+		fprintf(truth, "t_ms,lat,lon,pm2_5_atm\n");
+	}
+	if (opt_secs < 0)
+		opt_secs = realtime ? 0 : 60;
+	dur_us = opt_secs > 0 ? (uint64_t)(opt_secs * 1e6) : UINT64_MAX;
+
+	sgen_init(&g, cfg);
+	while (!stop_requested) {
+		uint64_t te = gps.fd >= 0 ? (uint64_t)(ne * 1e6 / cfg->gps_hz) : UINT64_MAX;
+		uint64_t tf = (uint64_t)(nf * 1e6 / cfg->pm_hz);
+		uint64_t t = te < tf ? te : tf;
+
+		if (t >= dur_us)
+			break;
+		if (realtime) {
+			uint64_t at = t0 + t * 1000u;
+			struct timespec ts = { (time_t)(at / 1000000000u), (long)(at % 1000000000u) };
+
+			clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+		}
+		if (t == te) {
+			char buf[SGEN_EPOCH_MAX];
+			size_t n = sgen_gps_epoch(&g, ne++, buf, sizeof(buf));
+
+			n = line_fit(&gps, te, te + gps_step, buf, n, 0);
+			if (write_all(gps.fd, buf, n) != 0) {
+				perror("write");
+				return 1;
+			}
+		} else {
+			uint8_t fr[SGEN_PMS_FRAME];
+			size_t n = sgen_pm_frame(&g, nf++, fr);
+			double lat, lon;
+
+			if (truth != NULL) {
+				sgen_position(&g, &lat, &lon);
+				fprintf(truth, "%lld,%.7f,%.7f,%u\n",
+					(long long)(cfg->t0_ms + (int64_t)(tf / 1000)), lat, lon,
+					(unsigned)(fr[12] << 8 | fr[13]));
+			}
+			if (pm.fd < 0)
+				continue;
+			n = line_fit(&pm, tf, tf + pm_step, (char *)fr, n, SGEN_PMS_FRAME);
+			if (write_all(pm.fd, fr, n) != 0) {
+				perror("write");
+				return 1;
+			}
+		}
+	}
+	if (truth != NULL)
+		fclose(truth);
+
+	fprintf(stderr, "sgen: %.1f s: %llu epochs, %llu sentences (%llu bytes, %llu cut); "
+		"%llu frames (%llu cut)\n",
+		(ne ? ne / cfg->gps_hz : nf / cfg->pm_hz),
+		(unsigned long long)ne, (unsigned long long)gps.items,
+		(unsigned long long)gps.bytes, (unsigned long long)gps.cut,
+		(unsigned long long)pm.items, (unsigned long long)pm.cut);
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+typedef struct check_type {
+	sgen_t  *g;
+	uint64_t rows, fixed;
+	double   err_sum, err_max;
+} check_t;
+
+static void on_row(void *user, const sarc_row_t *row)
+{
+	check_t *c = user;
+	double lat, lon, dn, de;
+
+	++c->rows;
+	if (isnan(row->lat))
+		return;
+	sgen_position(c->g, &lat, &lon);
+	dn = (row->lat - lat) * 111320.0;
+	de = (row->lon - lon) * 111320.0 * cos(lat * M_PI / 180);
+	c->err_sum += sqrt(dn * dn + de * de);
+	if (sqrt(dn * dn + de * de) > c->err_max)
+		c->err_max = sqrt(dn * dn + de * de);
+	++c->fixed;
+}
+
+static int run_bench(const sgen_cfg_t *cfg)
+{
+	uint64_t epochs = (uint64_t)(opt_secs * cfg->gps_hz), frames = (uint64_t)(opt_secs * cfg->pm_hz);
+	uint64_t bytes = 0, t, sentences = 0, ne = 0, nf = 0;
+	double gen_s, lag_m;
+	check_t chk = { 0 };
+	sdec_t d;
+	sgen_t g;
+	char buf[SGEN_EPOCH_MAX];
+	uint8_t fr[SGEN_PMS_FRAME];
+
+	printf("sgen bench: %.0f s at %g Hz GPS (%u sats), %g Hz PM, %s route\n",
+	       opt_secs, cfg->gps_hz, cfg->nr_sats, cfg->pm_hz,
+	       cfg->route ? "scripted" : "random-walk");
+
+	// Generation alone
+	sgen_init(&g, cfg);
+	t = now_ns();
+	for (uint64_t i = 0; i < epochs; ++i)
+		bytes += sgen_gps_epoch(&g, i, buf, sizeof(buf));
+	for (uint64_t i = 0; i < frames; ++i)
+		bytes += sgen_pm_frame(&g, i, fr);
+	gen_s = (now_ns() - t) / 1e9;
+	printf("  generate:  %llu epochs + %llu frames, %.1f MB in %.3f s (%.1f MB/s, %.0f epochs/s)\n",
+	       (unsigned long long)epochs, (unsigned long long)frames, bytes / 1e6, gen_s,
+	       bytes / 1e6 / gen_s, epochs / gen_s);
+
+	// Both streams in time order through the firmware's decoders
+	sgen_init(&g, cfg);
+	sdec_init(&d);
+	chk.g = &g;
+	while (ne < epochs || nf < frames) {
+		uint64_t te = ne < epochs ? (uint64_t)(ne * 1e6 / cfg->gps_hz) : UINT64_MAX;
+		uint64_t tf = nf < frames ? (uint64_t)(nf * 1e6 / cfg->pm_hz) : UINT64_MAX;
+
+		if (te <= tf) {
+			size_t n = sgen_gps_epoch(&g, ne++, buf, sizeof(buf));
+
+			for (size_t k = 0; k < n; ++k)
+				sentences += buf[k] == '\n';
+			sdec_feed(&d, (const uint8_t *)buf, n, 0, on_row, &chk);
+		} else {
+			sdec_feed(&d, fr, sgen_pm_frame(&g, nf++, fr), 0, on_row, &chk);
+		}
+	}
+
+	/*
+	 * A row carries the last reported fix, up to one epoch old, so it may
+	 * lag the true position by a step on top of the receiver's error.
+	 */
+	lag_m = cfg->speed_mps / cfg->gps_hz;
+	printf("  decode:    %llu of %llu sentences, %llu bad; %llu of %llu frames, %llu bad\n",
+	       (unsigned long long)d.nmea_ok, (unsigned long long)sentences,
+	       (unsigned long long)d.nmea_bad, (unsigned long long)d.pms_ok,
+	       (unsigned long long)frames, (unsigned long long)d.pms_bad);
+	printf("  position:  %llu rows with a fix, error mean %.1f m, max %.1f m "
+	       "(noise %.1f m, lag up to %.1f m)\n",
+	       (unsigned long long)chk.fixed, chk.fixed ? chk.err_sum / chk.fixed : 0.0,
+	       chk.err_max, cfg->noise_m, lag_m);
+	if (d.nmea_ok != sentences || d.nmea_bad || d.pms_ok != frames || d.pms_bad ||
+	    chk.err_max > 6 * cfg->noise_m + lag_m + 1)
+		return 1;
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-g GPS_OUT] [-q PM_OUT] [-c TRUTH.csv] [-t SECONDS] [-b BAUD] [-s SEED] [-z UNIX_S]\n"
+		"       [-r GPS_HZ] [-S rmc,gga,gll,gsv|all] [-n SATS] [-T TALKER] [-e NOISE_M] [-x NO_FIX]\n"
+		"       [-R ROUTE.csv [-P]] [-o LAT,LON] [-d RADIUS_M] [-V SPEED_MPS]\n"
+		"       [-m PM_HZ] [-p const|rush|ramp|traffic] [-l BASE] [-u PEAK] [-N REL_NOISE]\n"
+		"       [-E EPISODES_PER_H] [-H LAT,LON,RADIUS_M,PEAK]...\n"
+		"       %s -B [-t SECONDS] [generator options]\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	static sgen_hotspot_t hotspots[SGEN_MAX_HOTSPOTS];
+	const char *gps_path = NULL, *pm_path = NULL, *truth_path = NULL;
+	sgen_point_t *route = NULL;
+	bool bench = false;
+	sgen_cfg_t cfg;
+	int opt, p;
+
+	sgen_cfg_default(&cfg);
+	while ((opt = getopt(argc, argv, "g:q:c:t:b:s:z:r:S:n:T:e:x:R:Po:d:V:m:p:l:u:N:E:H:Bh")) != -1) {
+		switch (opt) {
+		case 'g': gps_path = optarg; break;
+		case 'q': pm_path = optarg; break;
+		case 'c': truth_path = optarg; break;
+		case 't': opt_secs = strtod(optarg, NULL); break;
+		case 'b': opt_baud = strtol(optarg, NULL, 0); break;
+		case 's': cfg.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'z': cfg.t0_ms = (int64_t)(strtod(optarg, NULL) * 1000); break;
+		case 'r': cfg.gps_hz = strtod(optarg, NULL); break;
+		case 'S':
+			if (parse_sentences(optarg, &cfg.sentences) != 0) {
+				fprintf(stderr, "bad sentence list: %s\n", optarg);
+				return 2;
+			}
+			break;
+		case 'n': cfg.nr_sats = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'T': snprintf(cfg.talker, sizeof(cfg.talker), "%s", optarg); break;
+		case 'e': cfg.noise_m = strtod(optarg, NULL); break;
+		case 'x': cfg.no_fix = strtod(optarg, NULL); break;
+		case 'R':
+			if (sgen_route_load(optarg, &route, &cfg.nr_route) != 0) {
+				perror(optarg);
+				return 1;
+			}
+			cfg.route = route;
+			break;
+		case 'P': cfg.pingpong = true; break;
+		case 'o':
+			if (sscanf(optarg, "%lf,%lf", &cfg.lat0, &cfg.lon0) != 2) {
+				usage(argv[0]);
+				return 2;
+			}
+			break;
+		case 'd': cfg.radius_m = strtod(optarg, NULL); break;
+		case 'V': cfg.speed_mps = strtod(optarg, NULL); break;
+		case 'm': cfg.pm_hz = strtod(optarg, NULL); break;
+		case 'p':
+			if ((p = sgen_profile_parse(optarg)) < 0) {
+				fprintf(stderr, "unknown profile: %s\n", optarg);
+				return 2;
+			}
+			cfg.profile = (sgen_profile_t)p;
+			break;
+		case 'l': cfg.pm_base = strtod(optarg, NULL); break;
+		case 'u': cfg.pm_peak = strtod(optarg, NULL); break;
+		case 'N': cfg.pm_noise = strtod(optarg, NULL); break;
+		case 'E': cfg.episodes_h = strtod(optarg, NULL); break;
+		case 'H':
+			if (cfg.nr_hotspots == SGEN_MAX_HOTSPOTS ||
+			    parse_hotspot(optarg, &hotspots[cfg.nr_hotspots]) != 0) {
+				fprintf(stderr, "bad or too many hotspots: %s\n", optarg);
+				return 2;
+			}
+			++cfg.nr_hotspots;
+			break;
+		case 'B': bench = true; break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	cfg.hotspots = hotspots;
+	if (optind != argc || cfg.gps_hz <= 0 || cfg.pm_hz <= 0 || opt_baud < 300 ||
+	    cfg.no_fix < 0 || cfg.no_fix > 1 || (!bench && gps_path == NULL && pm_path == NULL)) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+	signal(SIGPIPE, SIG_IGN);
+	if (bench) {
+		if (opt_secs < 0)
+			opt_secs = 3600;
+		cfg.duration_s = opt_secs;
+		return run_bench(&cfg);
+	}
+	if (opt_secs > 0)
+		cfg.duration_s = opt_secs;
+	return generate(&cfg, gps_path, pm_path, truth_path);
+}
@@ -0,0 +1,614 @@
+/**
+ * @file host/tools/sidx.c
+ * @brief Builds and queries spatial indexes of archived samples (host/lib/sidx.h).
+ *
+ * Build an index from archives (the blocks are decoded and sorted on -j
+ * threads), or add archives to an existing one with -a:
+ *
+ *   sidx -o campaign.sidx -j 8 archive/unit*.sarc
+ *
+ * Query it: -w gives the count, mean and max of a PM channel in a box (or,
+ * with -C, per cell; with -P, every sample), -k the nearest samples to a
+ * point:
+ *
+ *   sidx -w 14.64,121.06,14.66,121.08 -c pm2_5_atm campaign.sidx
+ *   sidx -k 10 -n 14.6537,121.0685 campaign.sidx
+ *
+ * -G writes an index of synthetic samples (a fleet driving around Metro
+ * Manila), and -B times window and nearest queries of growing size against
+ * an index, and samples inserted one at a time. The first queries of each
+ * size are also answered by a linear great-circle scan of every sample, and
+ * must agree with the index.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -pthread -Ihost/lib -o sidx host/tools/sidx.c host/lib/sidx.c \
+ *      host/lib/sarc.c -lm
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sidx.h"
+
+/// sarc_row_t.pm, in order
+static const char *const columns[SARC_NR_PM] = {
+	"pm1_0_std", "pm2_5_std", "pm10_std", "pm1_0_atm", "pm2_5_atm", "pm10_atm",
+	"n0_3", "n0_5", "n1_0", "n2_5", "n5_0", "n10",
+};
+
+static int column = 4;	// pm2_5_atm
+
+/////////////////////////////////////////////////////////////////////////////
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int parse_box(const char *s, sidx_box_t *b)
+{
+	double lat0, lon0, lat1, lon1;
+
+	if (sscanf(s, "%lf,%lf,%lf,%lf", &lat0, &lon0, &lat1, &lon1) != 4)
+		return -1;
+	b->lat_min = fmin(lat0, lat1);
+	b->lat_max = fmax(lat0, lat1);
+	b->lon_min = fmin(lon0, lon1);
+	b->lon_max = fmax(lon0, lon1);
+	return 0;
+}
+
+static int parse_column(const char *s)
+{
+	for (int k = 0; k < SARC_NR_PM; ++k)
+		if (strcmp(s, columns[k]) == 0)
+			return k;
+	return -1;
+}
+
+static void print_point(const sidx_point_t *p)
+{
+	printf("%" PRId64 ",%.7f,%.7f", p->t_ms, p->lat_e7 / 1e7, p->lon_e7 / 1e7);
+	for (int k = 0; k < SARC_NR_PM; ++k)
+		printf(",%u", p->pm[k]);
+}
+
+static int print_point_line(void *user, const sidx_point_t *p)
+{
+	(void)user;
+	print_point(p);
+	putchar('\n');
+	return 0;
+}
+
+static int print_cell(void *user, const sidx_cell_stats_t *c)
+{
+	(void)user;
+	printf("%.7f,%.7f,%" PRIu64 ",%.2f,%u\n", c->lat, c->lon, c->count,
+	       (double)c->pm_sum[column] / c->count, c->pm_max[column]);
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Synthetic samples
+
+/// Deterministic PRNG (xorshift32), so generated indexes are reproducible
+static uint32_t rng_state = 0x2545F491;
+static uint32_t rng_next(void)
+{
+	uint32_t x = rng_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+
+static double rng_unit(void)
+{
+	return rng_next() / 4294967296.0;
+}
+
+/// Metro Manila, roughly
+#define GEN_LAT0	14.40
+#define GEN_LAT1	14.80
+#define GEN_LON0	120.95
+#define GEN_LON1	121.15
+#define GEN_UNITS	64
+
+/// A fleet of units sampling at 1 Hz while driving at 0 to 15 m/s
+static sidx_point_t *generate(size_t n)
+{
+	sidx_point_t *pts = malloc(n * sizeof(*pts));
+	struct {
+		double lat, lon, heading, speed;
+		unsigned pm[SARC_NR_PM];
+	} u[GEN_UNITS];
+	int64_t t = 1704067200000;	// 2024-01-01T00:00:00Z
+
+	if (pts == NULL)
+		return NULL;
+	for (int i = 0; i < GEN_UNITS; ++i) {
+		u[i].lat = GEN_LAT0 + rng_unit() * (GEN_LAT1 - GEN_LAT0);
+		u[i].lon = GEN_LON0 + rng_unit() * (GEN_LON1 - GEN_LON0);
+		u[i].heading = rng_unit() * 2 * M_PI;
+		u[i].speed = 0;
+		for (int k = 0; k < SARC_NR_PM; ++k)
+			u[i].pm[k] = 10 + rng_next() % 40;
+	}
+	for (size_t j = 0; j < n; ++j) {
+		int i = (int)(j % GEN_UNITS);
+		sidx_point_t *p = &pts[j];
+
+		if (i == 0)
+			t += 1000;
+		u[i].heading += (rng_unit() - 0.5) * 0.3;
+		u[i].speed = fmin(15.0, fmax(0.0, u[i].speed + (rng_unit() - 0.5) * 2));
+		u[i].lat += u[i].speed * cos(u[i].heading) / 111320.0;
+		u[i].lon += u[i].speed * sin(u[i].heading) / (111320.0 * cos(u[i].lat * M_PI / 180));
+		// Turn back at the edges
+		if (u[i].lat < GEN_LAT0 || u[i].lat > GEN_LAT1 ||
+		    u[i].lon < GEN_LON0 || u[i].lon > GEN_LON1) {
+			u[i].heading += M_PI;
+			u[i].lat = fmin(GEN_LAT1, fmax(GEN_LAT0, u[i].lat));
+			u[i].lon = fmin(GEN_LON1, fmax(GEN_LON0, u[i].lon));
+		}
+		p->t_ms = t;
+		p->lat_e7 = (int32_t)llround(u[i].lat * 1e7);
+		p->lon_e7 = (int32_t)llround(u[i].lon * 1e7);
+		for (int k = 0; k < SARC_NR_PM; ++k) {
+			unsigned r = rng_next() % 4;
+
+			if (r == 0 && u[i].pm[k] > 0)
+				--u[i].pm[k];
+			else if (r == 1 && u[i].pm[k] < 500)
+				++u[i].pm[k];
+			p->pm[k] = (uint16_t)u[i].pm[k];
+		}
+	}
+	return pts;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Benchmark
+
+/// Queries of each size also answered by a linear scan, and compared
+#define LIN_CHECKS	10
+
+/// Metres per degree of latitude, as host/lib/sidx.c measures distances
+#define LIN_M_PER_DEG	111320.0
+
+/// A sample as the linear scan sees it
+typedef struct lin_type {
+	int32_t  lat_e7, lon_e7;
+	double   lat_rad, cos_lat;
+	uint16_t pm;
+} lin_t;
+
+typedef struct lin_set_type {
+	lin_t *p;
+	size_t n, max;
+} lin_set_t;
+
+static int count_point(void *user, const sidx_point_t *p)
+{
+	(void)p;
+	++*(uint64_t *)user;
+	return 0;
+}
+
+static int lin_add(void *user, const sidx_point_t *p)
+{
+	lin_set_t *set = user;
+	lin_t *l;
+
+	if (set->n == set->max)
+		return 1;
+	l = &set->p[set->n++];
+	l->lat_e7 = p->lat_e7;
+	l->lon_e7 = p->lon_e7;
+	l->lat_rad = p->lat_e7 / 1e7 * M_PI / 180;
+	l->cos_lat = cos(l->lat_rad);
+	l->pm = p->pm[column];
+	return 0;
+}
+
+/// Count, sum and max of the samples in @p b, by looking at every one
+static void lin_window(const lin_set_t *set, const sidx_box_t *b, sidx_agg_t *a)
+{
+	int32_t lat0 = (int32_t)llround(b->lat_min * 1e7), lat1 = (int32_t)llround(b->lat_max * 1e7);
+	int32_t lon0 = (int32_t)llround(b->lon_min * 1e7), lon1 = (int32_t)llround(b->lon_max * 1e7);
+
+	for (size_t i = 0; i < set->n; ++i) {
+		const lin_t *l = &set->p[i];
+
+		if (l->lat_e7 < lat0 || l->lat_e7 > lat1 || l->lon_e7 < lon0 || l->lon_e7 > lon1)
+			continue;
+		++a->count;
+		a->sum += l->pm;
+		if (l->pm > a->max)
+			a->max = l->pm;
+	}
+}
+
+/// Haversine term of the great-circle distance; grows with the distance
+static double lin_hav(double lat_rad, double cos_lat, double lon_rad, const lin_t *l)
+{
+	double a = sin((l->lat_rad - lat_rad) / 2);
+	double b = sin((l->lon_e7 / 1e7 * M_PI / 180 - lon_rad) / 2);
+
+	return a * a + cos_lat * l->cos_lat * b * b;
+}
+
+static double lin_hav_to_m(double h)
+{
+	return 2 * (LIN_M_PER_DEG * 180 / M_PI) * asin(sqrt(fmin(1, h)));
+}
+
+/// Great-circle distance of the k-th nearest sample, by looking at every one
+static double lin_nearest(const lin_set_t *set, double lat, double lon, size_t k, double *heap)
+{
+	double lat_rad = lat * M_PI / 180, lon_rad = lon * M_PI / 180, cos_lat = cos(lat_rad);
+	size_t n = 0;
+
+	// Max-heap of the k smallest terms
+	for (size_t i = 0; i < set->n; ++i) {
+		double h = lin_hav(lat_rad, cos_lat, lon_rad, &set->p[i]);
+		size_t j;
+
+		if (n < k) {
+			for (j = n++; j > 0 && heap[(j - 1) / 2] < h; j = (j - 1) / 2)
+				heap[j] = heap[(j - 1) / 2];
+			heap[j] = h;
+		} else if (h < heap[0]) {
+			for (j = 0;;) {
+				size_t c = 2 * j + 1;
+
+				if (c + 1 < n && heap[c + 1] > heap[c])
+					++c;
+				if (c >= n || heap[c] <= h)
+					break;
+				heap[j] = heap[c];
+				j = c;
+			}
+			heap[j] = h;
+		}
+	}
+	return n > 0 ? lin_hav_to_m(heap[0]) : 0;
+}
+
+/// Great-circle distance from (@p lat, @p lon) to an index sample
+static double lin_dist(double lat, double lon, const sidx_point_t *p)
+{
+	lin_t l;
+	lin_set_t one = { &l, 0, 1 };
+	double lat_rad = lat * M_PI / 180;
+
+	lin_add(&one, p);
+	return lin_hav_to_m(lin_hav(lat_rad, cos(lat_rad), lon * M_PI / 180, &l));
+}
+
+static int bench(sidx_t *x, int reps)
+{
+	static const double sizes_m[] = { 100, 1000, 5000, 20000 };
+	static const size_t ks[] = { 1, 10, 100, 1000 };
+	const double m_per_deg = 111320.0;
+	static const sidx_box_t world = { -90, 90, -180, 180 };
+	sidx_point_t *out = malloc(1000 * sizeof(*out));
+	double *heap = malloc(1000 * sizeof(*heap));
+	lin_set_t set = { NULL, 0, (size_t)sidx_nr_points(x) };
+	int checks = reps < LIN_CHECKS ? reps : LIN_CHECKS;
+	sidx_point_t *ins;
+	uint64_t t0, dt;
+	size_t nr_ins = 1000000;
+
+	if (out == NULL || heap == NULL ||
+	    (set.p = malloc((set.max > 0 ? set.max : 1) * sizeof(*set.p))) == NULL)
+		return 1;
+	// The reference: every sample, for the linear scans
+	if (sidx_window(x, &world, lin_add, &set) != 0 || set.n != set.max) {
+		fprintf(stderr, "index lists %zu of %zu samples\n", set.n, set.max);
+		return 1;
+	}
+	printf("%" PRIu64 " samples in %" PRIu64 " cells of %g deg; the first %d queries of "
+	       "each size checked against a linear scan\n",
+	       sidx_nr_points(x), sidx_nr_cells(x), sidx_cell_deg(x), checks);
+	printf("%-12s %12s %10s %10s %10s %10s %10s\n", "window", "samples", "agg ms",
+	       "whole", "edge", "list ms", "linear ms");
+	for (size_t s = 0; s < sizeof(sizes_m) / sizeof(sizes_m[0]); ++s) {
+		uint64_t dt_agg = 0, dt_list = 0, dt_lin = 0, samples = 0, whole = 0, edge = 0;
+
+		for (int i = 0; i < reps; ++i) {
+			double h = sizes_m[s] / m_per_deg / 2;
+			double lat = GEN_LAT0 + h + rng_unit() * (GEN_LAT1 - GEN_LAT0 - 2 * h);
+			double w = h / cos(lat * M_PI / 180);
+			double lon = GEN_LON0 + w + rng_unit() * (GEN_LON1 - GEN_LON0 - 2 * w);
+			sidx_box_t b = { lat - h, lat + h, lon - w, lon + w };
+			sidx_agg_t a = { 0 };
+			uint64_t n = 0;
+
+			t0 = now_ns();
+			sidx_window_agg(x, &b, column, &a);
+			dt_agg += now_ns() - t0;
+			t0 = now_ns();
+			sidx_window(x, &b, count_point, &n);
+			dt_list += now_ns() - t0;
+			if (n != a.count) {
+				fprintf(stderr, "window mismatch: %" PRIu64 " listed, %" PRIu64 " counted\n",
+					n, a.count);
+				return 1;
+			}
+			if (i < checks) {
+				sidx_agg_t l = { 0 };
+
+				t0 = now_ns();
+				lin_window(&set, &b, &l);
+				dt_lin += now_ns() - t0;
+				if (l.count != a.count || l.sum != a.sum || l.max != a.max) {
+					fprintf(stderr, "window mismatch: index %" PRIu64 "/%" PRIu64 "/%u, "
+						"linear scan %" PRIu64 "/%" PRIu64 "/%u (count/sum/max)\n",
+						a.count, a.sum, (unsigned)a.max,
+						l.count, l.sum, (unsigned)l.max);
+					return 1;
+				}
+			}
+			samples += n;
+			whole += a.cells_whole;
+			edge += a.cells_edge;
+		}
+		printf("%7.0f m sq %12" PRIu64 " %10.3f %10" PRIu64 " %10" PRIu64 " %10.3f %10.3f\n",
+		       sizes_m[s], samples / reps, dt_agg / 1e6 / reps, whole / reps,
+		       edge / reps, dt_list / 1e6 / reps, checks > 0 ? dt_lin / 1e6 / checks : 0);
+	}
+
+	/*
+	 * The index ranks by a flat-earth distance, the linear scan by the
+	 * great-circle one; over these distances they differ by well under
+	 * 0.1%, so the k-th great-circle distances must agree to that.
+	 */
+	printf("%-12s %12s %10s %10s %10s\n", "nearest", "max dist m", "ms",
+	       "linear ms", "worst diff");
+	for (size_t s = 0; s < sizeof(ks) / sizeof(ks[0]); ++s) {
+		double dist[1000], far = 0, worst = 0;
+		uint64_t dt_lin = 0;
+
+		dt = 0;
+		for (int i = 0; i < reps; ++i) {
+			double lat = GEN_LAT0 + rng_unit() * (GEN_LAT1 - GEN_LAT0);
+			double lon = GEN_LON0 + rng_unit() * (GEN_LON1 - GEN_LON0);
+			size_t n;
+
+			t0 = now_ns();
+			n = sidx_nearest(x, lat, lon, ks[s], out, dist);
+			dt += now_ns() - t0;
+			if (n > 0)
+				far += dist[n - 1];
+			if (i < checks) {
+				size_t want = ks[s] < set.n ? ks[s] : set.n;
+				double kth, got = 0;
+
+				t0 = now_ns();
+				kth = lin_nearest(&set, lat, lon, ks[s], heap);
+				dt_lin += now_ns() - t0;
+				for (size_t j = 0; j < n; ++j)
+					got = fmax(got, lin_dist(lat, lon, &out[j]));
+				if (n != want || fabs(got - kth) > kth * 1e-3 + 0.01) {
+					fprintf(stderr, "nearest mismatch at %.7f,%.7f, k = %zu: index %zu samples "
+						"out to %.3f m, linear scan %zu out to %.3f m\n",
+						lat, lon, ks[s], n, got, want, kth);
+					return 1;
+				}
+				worst = fmax(worst, fabs(got - kth));
+			}
+		}
+		printf("k = %-8zu %12.1f %10.3f %10.3f %8.3f m\n", ks[s], far / reps, dt / 1e6 / reps,
+		       checks > 0 ? dt_lin / 1e6 / checks : 0, worst);
+	}
+	free(set.p);
+	free(heap);
+
+	// Incremental ingest: samples one at a time into the delta
+	if ((ins = generate(nr_ins)) == NULL)
+		return 1;
+	t0 = now_ns();
+	for (size_t i = 0; i < nr_ins; ++i)
+		if (sidx_insert(x, &ins[i]) != 0)
+			return 1;
+	dt = now_ns() - t0;
+	printf("insert: %zu samples in %.1f ms (%.0f ns each)\n", nr_ins, dt / 1e6,
+	       (double)dt / nr_ins);
+	free(ins);
+	free(out);
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s -o INDEX [-a] [-j THREADS] [-g CELL_DEG] ARCHIVE...\n"
+		"       %s -w LAT0,LON0,LAT1,LON1 [-c COLUMN] [-C | -P] INDEX\n"
+		"       %s -k K -n LAT,LON INDEX\n"
+		"       %s -G INDEX [-N MILLIONS] [-j THREADS] [-g CELL_DEG] [-s SEED]\n"
+		"       %s -B INDEX [-r REPEATS]\n",
+		argv0, argv0, argv0, argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *out = NULL, *gen = NULL, *bench_path = NULL, *path;
+	double cell_deg = SIDX_DEFAULT_CELL_DEG, millions = 10, lat = 0, lon = 0;
+	int threads = 1, add = 0, cells = 0, list = 0, reps = 100, c;
+	bool have_box = false, have_point = false;
+	size_t k = 0;
+	sidx_box_t box;
+	sidx_t *x;
+	uint64_t t0;
+
+	while ((c = getopt(argc, argv, "o:aj:g:w:c:CPk:n:G:N:s:B:r:h")) != -1) {
+		switch (c) {
+		case 'o': out = optarg; break;
+		case 'a': add = 1; break;
+		case 'j': threads = atoi(optarg); break;
+		case 'g': cell_deg = strtod(optarg, NULL); break;
+		case 'w':
+			if (parse_box(optarg, &box) != 0) {
+				fprintf(stderr, "bad box: %s\n", optarg);
+				return 1;
+			}
+			have_box = true;
+			break;
+		case 'c':
+			if ((column = parse_column(optarg)) < 0) {
+				fprintf(stderr, "unknown column: %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'C': cells = 1; break;
+		case 'P': list = 1; break;
+		case 'k': k = (size_t)strtoul(optarg, NULL, 0); break;
+		case 'n':
+			if (sscanf(optarg, "%lf,%lf", &lat, &lon) != 2) {
+				fprintf(stderr, "bad point: %s\n", optarg);
+				return 1;
+			}
+			have_point = true;
+			break;
+		case 'G': gen = optarg; break;
+		case 'N': millions = strtod(optarg, NULL); break;
+		case 's': rng_state = (uint32_t)strtoul(optarg, NULL, 0) | 1u; break;
+		case 'B': bench_path = optarg; break;
+		case 'r': reps = atoi(optarg) > 0 ? atoi(optarg) : 1; break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (gen != NULL) {
+		size_t n = (size_t)(millions * 1e6);
+		sidx_point_t *pts = generate(n);
+
+		if (pts == NULL || (x = sidx_create(cell_deg)) == NULL) {
+			perror("sidx");
+			return 1;
+		}
+		t0 = now_ns();
+		if (sidx_insert_many(x, pts, n, threads) != 0) {
+			perror("sidx");
+			return 1;
+		}
+		printf("%s: %zu samples sorted into %" PRIu64 " cells in %.1f ms (%d threads)\n",
+		       gen, n, sidx_nr_cells(x), (now_ns() - t0) / 1e6, threads);
+		free(pts);
+		if (sidx_save(x, gen) != 0) {
+			perror(gen);
+			return 1;
+		}
+		sidx_close(x);
+		return 0;
+	}
+
+	if (out != NULL) {
+		if (optind == argc) {
+			usage(argv[0]);
+			return 1;
+		}
+		x = add ? sidx_open(out) : sidx_create(cell_deg);
+		if (x == NULL) {
+			perror(out);
+			return 1;
+		}
+		t0 = now_ns();
+		if (sidx_bulk_load(x, (const char *const *)&argv[optind], argc - optind, threads) != 0) {
+			perror("sidx");
+			return 1;
+		}
+		printf("%s: %" PRIu64 " samples in %" PRIu64 " cells, loaded in %.1f ms (%d threads)\n",
+		       out, sidx_nr_points(x), sidx_nr_cells(x), (now_ns() - t0) / 1e6, threads);
+		if (sidx_save(x, out) != 0) {
+			perror(out);
+			return 1;
+		}
+		sidx_close(x);
+		return 0;
+	}
+
+	path = bench_path;
+	if (path == NULL && optind == argc - 1)
+		path = argv[optind];
+	if (path == NULL) {
+		usage(argv[0]);
+		return 1;
+	}
+	if ((x = sidx_open(path)) == NULL) {
+		if (errno == EINVAL)
+			fprintf(stderr, "%s: not an index\n", path);
+		else
+			perror(path);
+		return 1;
+	}
+	if (bench_path != NULL) {
+		int res = bench(x, reps);
+
+		sidx_close(x);
+		return res;
+	}
+
+	if (have_box && cells) {
+		printf("lat,lon,count,mean_%s,max_%s\n", columns[column], columns[column]);
+		sidx_cells(x, &box, print_cell, NULL);
+	} else if (have_box && list) {
+		printf("t_ms,lat,lon,pm1_0_std,pm2_5_std,pm10_std,pm1_0_atm,pm2_5_atm,pm10_atm,"
+		       "n0_3,n0_5,n1_0,n2_5,n5_0,n10\n");
+		sidx_window(x, &box, print_point_line, NULL);
+	} else if (have_box) {
+		sidx_agg_t a = { 0 };
+
+		t0 = now_ns();
+		sidx_window_agg(x, &box, column, &a);
+		printf("%s: %" PRIu64 " samples", columns[column], a.count);
+		if (a.count > 0)
+			printf(", mean %.2f, max %u", (double)a.sum / a.count, a.max);
+		printf("\ncells: %" PRIu64 " from the directory, %" PRIu64 " scanned, in %.3f ms\n",
+		       a.cells_whole, a.cells_edge, (now_ns() - t0) / 1e6);
+	} else if (have_point && k > 0) {
+		sidx_point_t *p = malloc(k * sizeof(*p));
+		double *d = malloc(k * sizeof(*d));
+		size_t n;
+
+		if (p == NULL || d == NULL) {
+			perror("sidx");
+			return 1;
+		}
+		t0 = now_ns();
+		n = sidx_nearest(x, lat, lon, k, p, d);
+		fprintf(stderr, "%zu samples in %.3f ms\n", n, (now_ns() - t0) / 1e6);
+		printf("dist_m,t_ms,lat,lon,pm1_0_std,pm2_5_std,pm10_std,pm1_0_atm,pm2_5_atm,pm10_atm,"
+		       "n0_3,n0_5,n1_0,n2_5,n5_0,n10\n");
+		for (size_t i = 0; i < n; ++i) {
+			printf("%.1f,", d[i]);
+			print_point(&p[i]);
+			putchar('\n');
+		}
+		free(p);
+		free(d);
+	} else {
+		printf("%" PRIu64 " samples in %" PRIu64 " cells of %g deg\n",
+		       sidx_nr_points(x), sidx_nr_cells(x), sidx_cell_deg(x));
+	}
+	sidx_close(x);
+	return 0;
+}
@@ -0,0 +1,523 @@
+/**
+ * @file host/tools/uartfault.c
+ * @brief Measures how the sensor parsers cope with impaired UART lines.
+ *
+ * The parsers have only ever been fed clean captures, so nobody knows what
+ * a flipped bit, a lost byte or a sender with a drifting clock costs, nor
+ * how long pms_parser_feed_byte() takes to find its way back into the
+ * stream after one. This tool runs one simulated board
+ * (host/sim/sim_platform.h) in virtual time, with its two sensor lines fed
+ * by host/lib/sgen.h and impaired as each configuration says, and reads the
+ * lines exactly as src/main.c does: the same buffer sizes, the same
+ * re-arming, the NMEA sentence assembler, and the PMS parser, including
+ * main.c's habit of dropping the rest of a buffer once a frame has parsed.
+ *
+ * Every sentence and frame sent is remembered, so each one that comes out of
+ * a parser can be matched against it. For each configuration and line the
+ * tool reports:
+ * - sent, and intact (decoded exactly as sent);
+ * - rejected by the checks (NMEA checksum; PMS checksum, length or overflow);
+ * - undetected: passed the checks but differs from everything sent;
+ * - the recovery time after each impairment: from the arrival of the first
+ *   damaged or lost byte to the delivery of the first intact sentence or
+ *   frame that started after it, as mean, 99th percentile and maximum.
+ *
+ * A configuration (-c, repeatable) is a comma-separated list of
+ * ber=P (bit error rate), burst=P/LEN (a burst of about LEN lost bytes
+ * starting at any byte with probability P), dup=P (a byte arriving twice),
+ * ppm=N (the sensors' clock this far off) and gap=US (up to this much idle
+ * time before every character); "clean" is a line with none of them.
+ * Without -c a built-in sweep is run.
+ *
+ * With -B the built-in sweep is run and checked: the clean line must lose
+ * nothing, every impaired line must show its damage in the counters, and a
+ * second run of one configuration must give identical results.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -Ihost/sim -Ihost/lib -o uartfault \
+ *      host/tools/uartfault.c host/sim/sim_platform.c host/lib/sdec.c \
+ *      host/lib/sgen.c src/parsers/nmea_parse.c src/parsers/pms_parser.c -lm
+ */
+
+#define _DEFAULT_SOURCE
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "sdec.h"
+#include "sgen.h"
+#include "sim_platform.h"
+
+/////////////////////////////////////////////////////////////////////////////
+// Firmware stand-ins
+
+/// The PMS parser reports its progress through main.c's debug output
+void debug_printf(struct prog_state_type *ps, const char *format, ...)
+{
+	(void)ps;
+	(void)format;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// Sentences and frames remembered for matching
+#define UARTFAULT_RING		256
+
+static double opt_secs = 600;
+static long opt_baud = 9600;
+static unsigned opt_loop_us = 500;
+static double opt_gps_hz = 1;
+static uint32_t opt_seed = 1;
+
+static const char *const sweep[] = {
+	"clean",
+	"ber=1e-5", "ber=1e-4", "ber=1e-3",
+	"burst=1e-4/8", "burst=1e-3/32",
+	"dup=1e-4", "dup=1e-3",
+	"ppm=20000", "ppm=-60000", "ppm=70000",
+	"gap=500", "gap=3000",
+	"ber=1e-4,burst=1e-4/16,dup=1e-4,ppm=20000,gap=200",
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static int parse_config(const char *spec, sim_impair_t *im)
+{
+	char buf[256], *save = NULL;
+
+	memset(im, 0, sizeof(*im));
+	if (strcmp(spec, "clean") == 0)
+		return 0;
+	snprintf(buf, sizeof(buf), "%s", spec);
+	for (char *tok = strtok_r(buf, ",", &save); tok != NULL;
+	     tok = strtok_r(NULL, ",", &save)) {
+		if (sscanf(tok, "ber=%lf", &im->ber) == 1 ||
+		    sscanf(tok, "burst=%lf/%lf", &im->burst_p, &im->burst_len) == 2 ||
+		    sscanf(tok, "dup=%lf", &im->dup_p) == 1 ||
+		    sscanf(tok, "ppm=%d", &im->baud_ppm) == 1)
+			continue;
+		if (strncmp(tok, "gap=", 4) == 0) {
+			im->gap_ns = (uint32_t)(strtod(tok + 4, NULL) * 1000);
+			continue;
+		}
+		return -1;
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Lines
+
+/// A sentence or frame sent
+typedef struct item_type {
+	uint64_t start_us;	///< Nominal arrival of its first byte
+	bool     seen;		///< Decoded intact already
+	uint8_t  len;
+	union {
+		char       text[NMEA_SENTENCE_MAX_LEN + 1];
+		pms_data_t pms;
+	} u;
+} item_t;
+
+/// Results for one line
+typedef struct result_type {
+	uint64_t sent, intact, rejected, undetected;
+	uint64_t hits;			///< Impairments followed by a recovery
+	double   rec_mean_ms, rec_p99_ms, rec_max_ms;
+	sim_impair_t im;		///< Counters of the line's impairment
+} result_t;
+
+/// One sensor line and its reader
+typedef struct line_type {
+	sim_sensor_t *s;
+	sgen_t   *gen;
+	bool      pm;
+
+	item_t    ring[UARTFAULT_RING];
+	uint64_t  nr_items;		///< Items ever put in the ring
+
+	platform_usart_rx_async_desc_t desc;
+	char      buf[GPS_RX_BUF_SZ];
+	nmea_sentence_state_t nmea;
+	pms_parser_internal_state_t pms;
+
+	uint64_t  pending_us;		///< First impairment not recovered from
+	double   *rec_ms;
+	size_t    nr_rec, max_rec;
+	result_t  r;
+} line_t;
+
+static item_t *line_remember(line_t *l, uint64_t start_us)
+{
+	item_t *it = &l->ring[l->nr_items++ % UARTFAULT_RING];
+
+	memset(it, 0, sizeof(*it));
+	it->start_us = start_us;
+	++l->r.sent;
+	return it;
+}
+
+static size_t gps_report(void *user, uint64_t seq, uint8_t *buf, size_t size)
+{
+	line_t *l = user;
+	size_t n = sgen_gps_epoch(l->gen, seq, (char *)buf, size);
+
+	for (size_t at = 0; at < n; ) {
+		const uint8_t *lf = memchr(buf + at, '\n', n - at);
+		size_t len = (size_t)(lf - (buf + at)) + 1;
+		item_t *it = line_remember(l, l->s->start_us +
+					    at * 10000000u / (uint64_t)opt_baud);
+
+		it->len = (uint8_t)(len < sizeof(it->u.text) ? len : sizeof(it->u.text) - 1);
+		memcpy(it->u.text, buf + at, it->len);
+		at += len;
+	}
+	return n;
+}
+
+static uint16_t be16(const uint8_t *p)
+{
+	return (uint16_t)((p[0] << 8) | p[1]);
+}
+
+static size_t pm_report(void *user, uint64_t seq, uint8_t *buf, size_t size)
+{
+	line_t *l = user;
+	item_t *it = line_remember(l, l->s->start_us);
+	uint16_t *w = &it->u.pms.pm1_0_std;
+
+	(void)size;
+	sgen_pm_frame(l->gen, seq, buf);
+	for (unsigned i = 0; i < 12; ++i)
+		w[i] = be16(buf + 4 + 2 * i);
+	it->len = SGEN_PMS_FRAME;
+	return SGEN_PMS_FRAME;
+}
+
+static item_t *line_match(line_t *l, const void *what, size_t len)
+{
+	uint64_t lo = l->nr_items > UARTFAULT_RING ? l->nr_items - UARTFAULT_RING : 0;
+
+	for (uint64_t n = l->nr_items; n-- > lo; ) {
+		item_t *it = &l->ring[n % UARTFAULT_RING];
+
+		if (l->pm ? memcmp(&it->u.pms, what, sizeof(pms_data_t)) == 0
+			  : (it->len == len && memcmp(it->u.text, what, len) == 0))
+			return it;
+	}
+	return NULL;
+}
+
+static void line_decoded(line_t *l, item_t *it, uint64_t now_us)
+{
+	if (it == NULL) {
+		++l->r.undetected;
+		return;
+	}
+	if (it->seen)
+		return;
+	it->seen = true;
+	++l->r.intact;
+	if (l->pending_us != 0 && it->start_us >= l->pending_us) {
+		if (l->nr_rec == l->max_rec) {
+			l->max_rec = l->max_rec ? 2 * l->max_rec : 1024;
+			l->rec_ms = realloc(l->rec_ms, l->max_rec * sizeof(*l->rec_ms));
+			if (l->rec_ms == NULL) {
+				perror("realloc");
+				exit(1);
+			}
+		}
+		l->rec_ms[l->nr_rec++] = (now_us - l->pending_us) / 1e3;
+		l->pending_us = 0;
+	}
+}
+
+// What src/main.c does with a completed receive buffer
+static void line_read(line_t *l, uint64_t now_us)
+{
+	if (l->s->impair.hit_us != 0) {
+		if (l->pending_us == 0)
+			l->pending_us = l->s->impair.hit_us;
+		l->s->impair.hit_us = 0;
+	}
+	if (l->desc.compl_type != PLATFORM_USART_RX_COMPL_DATA)
+		return;
+
+	for (uint16_t i = 0; i < l->desc.compl_info.data_len; ++i) {
+		if (l->pm) {
+			pms_data_t d;
+
+			switch (pms_parser_feed_byte(NULL, &l->pms, (uint8_t)l->buf[i], &d)) {
+			case PMS_PARSER_OK:
+				line_decoded(l, line_match(l, &d, sizeof(d)), now_us);
+				break;
+			case PMS_PARSER_CHECKSUM_ERROR:
+			case PMS_PARSER_INVALID_LENGTH:
+			case PMS_PARSER_BUFFER_OVERFLOW:
+				++l->r.rejected;
+				continue;
+			default:
+				continue;
+			}
+			break;		// main.c stops at the first frame
+		} else {
+			const char *s = nmea_sentence_feed(&l->nmea, l->buf[i]);
+
+			if (s == NULL)
+				continue;
+			if (!sdec_nmea_checksum_ok(s))
+				++l->r.rejected;
+			else
+				line_decoded(l, line_match(l, s, strlen(s)), now_us);
+		}
+	}
+	l->desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
+	if (l->pm)
+		pm_platform_usart_cdc_rx_async(&l->desc);
+	else
+		gps_platform_usart_cdc_rx_async(&l->desc);
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+	double x = *(const double *)a, y = *(const double *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void line_finish(line_t *l)
+{
+	result_t *r = &l->r;
+
+	r->im = l->s->impair;
+	r->hits = l->nr_rec;
+	if (l->nr_rec != 0) {
+		double sum = 0;
+
+		qsort(l->rec_ms, l->nr_rec, sizeof(*l->rec_ms), cmp_double);
+		for (size_t i = 0; i < l->nr_rec; ++i)
+			sum += l->rec_ms[i];
+		r->rec_mean_ms = sum / l->nr_rec;
+		r->rec_p99_ms = l->rec_ms[(size_t)ceil(0.99 * l->nr_rec) - 1];
+		r->rec_max_ms = l->rec_ms[l->nr_rec - 1];
+	}
+	free(l->rec_ms);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Runs
+
+static line_t gps, pm;
+
+/// Run one configuration; fills @p rg and @p rp
+static int run(const char *spec, result_t *rg, result_t *rp)
+{
+	static sim_board_t board;
+	sim_impair_t im;
+	sgen_cfg_t c;
+	sgen_t gen;
+	uint64_t clock = 0, end;
+
+	if (parse_config(spec, &im) != 0) {
+		fprintf(stderr, "bad configuration: %s\n", spec);
+		return -1;
+	}
+	sgen_cfg_default(&c);
+	c.seed = opt_seed;
+	c.t0_ms = 1700000000000;	// Fixed, so that runs repeat exactly
+	c.gps_hz = opt_gps_hz;
+	sgen_init(&gen, &c);
+
+	sim_board_init(&board, -1, (uint32_t)opt_baud);
+	board.clock_ns = &clock;
+	memset(&gps, 0, sizeof(gps));
+	memset(&pm, 0, sizeof(pm));
+	gps.s = &board.gps;
+	pm.s  = &board.pm;
+	gps.gen = pm.gen = &gen;
+	pm.pm = true;
+
+	board.gps.report = gps_report;
+	board.gps.user = &gps;
+	board.gps.period_us = (uint32_t)(1e6 / opt_gps_hz);
+	board.gps.phase_us = 100000;
+	board.gps.jitter_us = 20000;
+	board.gps.seed = opt_seed ^ 0x9E3779B9u;
+	board.gps.impair = im;
+	board.pm.report = pm_report;
+	board.pm.user = &pm;
+	board.pm.period_us = 1000000;
+	board.pm.phase_us = 350000;
+	board.pm.jitter_us = 100000;
+	board.pm.seed = opt_seed ^ 0x7F4A7C15u;
+	board.pm.impair = im;
+
+	sim_board = &board;
+	platform_init();
+	nmea_sentence_init(&gps.nmea);
+	pms_parser_init(&pm.pms);
+	gps.desc.buf = gps.buf;
+	gps.desc.max_len = GPS_RX_BUF_SZ;
+	pm.desc.buf = pm.buf;
+	pm.desc.max_len = PM_RX_BUF_SZ;
+	gps_platform_usart_cdc_rx_async(&gps.desc);
+	pm_platform_usart_cdc_rx_async(&pm.desc);
+
+	end = (uint64_t)(opt_secs * 1e9);
+	for (clock = 0; clock < end; clock += opt_loop_us * 1000u) {
+		platform_do_loop_one();
+		line_read(&gps, clock / 1000u);
+		line_read(&pm, clock / 1000u);
+	}
+	line_finish(&gps);
+	line_finish(&pm);
+	*rg = gps.r;
+	*rp = pm.r;
+	return 0;
+}
+
+static void print_header(void)
+{
+	printf("%-44s %-4s %7s %7s %6s %8s %10s %7s %22s\n",
+	       "configuration", "line", "sent", "intact", "lost%", "rejected",
+	       "undetected", "hits", "recovery ms mean/p99/max");
+}
+
+static void print_result(const char *spec, const char *name, const result_t *r)
+{
+	printf("%-44s %-4s %7llu %7llu %6.2f %8llu %10llu %7llu %8.0f/%6.0f/%6.0f\n",
+	       spec, name, (unsigned long long)r->sent,
+	       (unsigned long long)r->intact,
+	       r->sent ? 100.0 * (r->sent - r->intact) / r->sent : 0,
+	       (unsigned long long)r->rejected,
+	       (unsigned long long)r->undetected, (unsigned long long)r->hits,
+	       r->rec_mean_ms, r->rec_p99_ms, r->rec_max_ms);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Self-check
+
+static bool impaired(const sim_impair_t *im)
+{
+	return im->flipped || im->dropped || im->duplicated || im->misread;
+}
+
+static int bench(void)
+{
+	size_t nr = sizeof(sweep) / sizeof(sweep[0]);
+	result_t rg, rp, again_g, again_p;
+	uint64_t t0 = now_ns();
+	unsigned bad = 0;
+	double secs;
+
+	print_header();
+	for (size_t i = 0; i < nr; ++i) {
+		if (run(sweep[i], &rg, &rp) != 0)
+			return 1;
+		print_result(sweep[i], "gps", &rg);
+		print_result(sweep[i], "pm", &rp);
+
+		for (int k = 0; k < 2; ++k) {
+			const result_t *r = k ? &rp : &rg;
+
+			if (r->intact > r->sent || r->sent == 0) {
+				fprintf(stderr, "  %s: inconsistent counts\n", sweep[i]);
+				++bad;
+			} else if (i == 0 && (r->intact != r->sent || r->rejected ||
+					      r->undetected || impaired(&r->im))) {
+				fprintf(stderr, "  %s: clean line lost data\n", sweep[i]);
+				++bad;
+			} else if (i != 0 && impaired(&r->im) && r->intact == r->sent &&
+				   r->rejected == 0 && r->undetected == 0) {
+				fprintf(stderr, "  %s: damage left no trace\n", sweep[i]);
+				++bad;
+			}
+		}
+	}
+	secs = (now_ns() - t0) / 1e9;
+
+	if (run(sweep[nr - 1], &again_g, &again_p) != 0)
+		return 1;
+	if (again_g.intact != rg.intact || again_g.rejected != rg.rejected ||
+	    again_p.intact != rp.intact || again_p.rejected != rp.rejected ||
+	    again_p.rec_max_ms != rp.rec_max_ms) {
+		fprintf(stderr, "  a second run gave different results\n");
+		++bad;
+	}
+	printf("uartfault bench: %zu configurations of %.0f s at %ld baud in %.2f s "
+	       "(%.0fx real time); %u problems\n", nr, opt_secs, opt_baud, secs,
+	       nr * opt_secs / secs, bad);
+	return bad ? 1 : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-t SECONDS] [-b BAUD] [-L LOOP_US] [-r GPS_HZ] [-s SEED] [-c CONFIG]...\n"
+		"       %s -B [-t SECONDS] ...\n"
+		"CONFIG: clean, or any of ber=P,burst=P/LEN,dup=P,ppm=N,gap=US\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *configs[64];
+	unsigned nr_configs = 0;
+	bool do_bench = false;
+	result_t rg, rp;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "t:b:L:r:s:c:Bh")) != -1) {
+		switch (opt) {
+		case 't': opt_secs = strtod(optarg, NULL); break;
+		case 'b': opt_baud = strtol(optarg, NULL, 0); break;
+		case 'L': opt_loop_us = (unsigned)strtoul(optarg, NULL, 0); break;
+		case 'r': opt_gps_hz = strtod(optarg, NULL); break;
+		case 's': opt_seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+		case 'c':
+			if (nr_configs == sizeof(configs) / sizeof(configs[0])) {
+				usage(argv[0]);
+				return 2;
+			}
+			configs[nr_configs++] = optarg;
+			break;
+		case 'B': do_bench = true; break;
+		default:
+			usage(argv[0]);
+			return 2;
+		}
+	}
+	if (optind != argc || opt_secs <= 0 || opt_baud < 1200 ||
+	    opt_loop_us == 0 || !(opt_gps_hz >= 0.1 && opt_gps_hz <= 20)) {
+		usage(argv[0]);
+		return 2;
+	}
+	if (do_bench)
+		return bench();
+
+	if (nr_configs == 0)
+		for (size_t i = 0; i < sizeof(sweep) / sizeof(sweep[0]); ++i)
+			configs[nr_configs++] = sweep[i];
+	print_header();
+	for (unsigned i = 0; i < nr_configs; ++i) {
+		if (run(configs[i], &rg, &rp) != 0)
+			return 2;
+		print_result(configs[i], "gps", &rg);
+		print_result(configs[i], "pm", &rp);
+	}
+	return 0;
+}
@@ -0,0 +1,609 @@
+/**
+ * @file host/tools/uplink_gw.c
+ * @brief Local gateway stand-in for the store-and-forward uplink.
+ *
+ * Two modes are provided:
+ *
+ * - Serial mode: attach to the board's CDC port (or a pty), decode DATA
+ *   frames, acknowledge them and print the records as CSV. ACKs can be
+ *   dropped on purpose (-l) to exercise the firmware's retry path.
+ *
+ * - Self-test mode (-S): link src/uplink.c against a simulated link running
+ *   on virtual time, inject frame loss and a link outage, and report
+ *   throughput and how quickly the backlog drains once the link returns. No
+ *   board and no network are needed. The records go through the RAM backend
+ *   of the record log (src/logstore.c), made large enough to stand in for
+ *   the SD card.
+ *
+ * Build (from the repository root):
+ *   cc -O2 -Wall -Iinc -DUPLINK_ENABLED=1 -DLOGSTORE_BACKEND=0 \
+ *      -DLOGSTORE_RAM_BLOCKS=256 -o uplink_gw host/tools/uplink_gw.c \
+ *      src/uplink.c src/logstore.c
+ */
+
+#define _DEFAULT_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/select.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "logstore.h"
+#include "uplink.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// Deterministic PRNG (xorshift32), so loss patterns are reproducible
+static uint32_t rng_state = 0x2545F491;
+static uint32_t rng_next(void)
+{
+	uint32_t x = rng_state;
+
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	rng_state = x;
+	return x;
+}
+static int rng_chance(double pct)
+{
+	return ((rng_next() % 1000000u) / 10000.0) < pct;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// Gateway-side frame parser and sequence tracker
+typedef struct gw_type {
+	// Frame assembly
+	uint8_t  frame[UPLINK_HDR_LEN + UPLINK_PKT_PAYLOAD_MAX + UPLINK_CRC_LEN];
+	uint16_t idx;
+	uint16_t need;
+
+	// Sequence tracking
+	int      synced;
+	uint16_t expected;
+	uint16_t resync_seq;
+	uint16_t resync_crc;
+
+	// Statistics
+	unsigned long frames_ok;
+	unsigned long frames_bad;
+	unsigned long frames_dup;
+	unsigned long frames_gap;
+	unsigned long records;
+	unsigned long record_bytes;
+
+	// Sinks
+	void (*on_record)(struct gw_type *gw, uint8_t type,
+			  const uint8_t *data, uint8_t len);
+	void (*send_ack)(struct gw_type *gw, const uint8_t *frame, size_t len);
+	void *user;
+} gw_t;
+
+static void gw_ack(gw_t *gw, uint16_t seq)
+{
+	uint8_t f[UPLINK_HDR_LEN + UPLINK_CRC_LEN];
+	uint16_t crc;
+
+	f[0] = UPLINK_SYNC_1;
+	f[1] = UPLINK_SYNC_2;
+	f[2] = UPLINK_TYPE_ACK;
+	f[3] = 0;
+	f[4] = (uint8_t)(seq & 0xFF);
+	f[5] = (uint8_t)(seq >> 8);
+	f[6] = 0;
+	f[7] = 0;
+	crc = uplink_crc16(0xFFFF, &f[2], UPLINK_HDR_LEN - 2);
+	f[8] = (uint8_t)(crc & 0xFF);
+	f[9] = (uint8_t)(crc >> 8);
+	gw->send_ack(gw, f, sizeof(f));
+}
+
+static void gw_deliver(gw_t *gw, const uint8_t *p, uint16_t len)
+{
+	uint16_t off = 0;
+
+	while (off + 2 <= len) {
+		uint8_t type = p[off];
+		uint8_t rlen = p[off + 1];
+
+		if (off + 2 + rlen > len)
+			break;
+		gw->records++;
+		gw->record_bytes += rlen;
+		if (gw->on_record)
+			gw->on_record(gw, type, &p[off + 2], rlen);
+		off += 2 + rlen;
+	}
+}
+
+static void gw_handle_frame(gw_t *gw)
+{
+	const uint8_t *f = gw->frame;
+	uint16_t len = (uint16_t)f[6] | ((uint16_t)f[7] << 8);
+	uint16_t seq = (uint16_t)f[4] | ((uint16_t)f[5] << 8);
+	uint16_t crc = uplink_crc16(0xFFFF, &f[2], (UPLINK_HDR_LEN - 2) + len);
+	uint16_t rx_crc = (uint16_t)f[UPLINK_HDR_LEN + len] |
+			  ((uint16_t)f[UPLINK_HDR_LEN + len + 1] << 8);
+
+	if (crc != rx_crc || f[2] != UPLINK_TYPE_DATA) {
+		gw->frames_bad++;
+		return;
+	}
+
+	if (gw->synced && seq == gw->expected) {
+		// In order
+	} else if ((f[3] & UPLINK_FLAG_RESYNC) != 0 &&
+		   !(gw->synced && seq == gw->resync_seq && crc == gw->resync_crc)) {
+		/*
+		 * Start of a new sequence space (device boot, or the device
+		 * discarded unacknowledged data). Retransmissions of the same
+		 * packet are byte-identical, so they are told apart by CRC.
+		 */
+		gw->synced = 1;
+		gw->resync_seq = seq;
+		gw->resync_crc = crc;
+	} else if (gw->synced &&
+		   (uint16_t)(gw->expected - seq) <= UPLINK_WINDOW) {
+		// Already delivered; the ACK must have been lost
+		gw->frames_dup++;
+		gw_ack(gw, (uint16_t)(gw->expected - 1));
+		return;
+	} else {
+		// A predecessor was lost; the device will go back to it
+		gw->frames_gap++;
+		if (gw->synced)
+			gw_ack(gw, (uint16_t)(gw->expected - 1));
+		return;
+	}
+
+	gw->frames_ok++;
+	gw->synced = 1;
+	gw->expected = (uint16_t)(seq + 1);
+	gw_deliver(gw, &f[UPLINK_HDR_LEN], len);
+	gw_ack(gw, seq);
+}
+
+/// Repeats the last ACK so a backed-off device notices the link is back
+static void gw_keepalive(gw_t *gw)
+{
+	if (gw->synced)
+		gw_ack(gw, (uint16_t)(gw->expected - 1));
+}
+
+static void gw_feed(gw_t *gw, const uint8_t *buf, size_t len)
+{
+	for (size_t i = 0; i < len; ++i) {
+		uint8_t c = buf[i];
+
+		if (gw->idx == 0 && c != UPLINK_SYNC_1)
+			continue;
+		if (gw->idx == 1 && c != UPLINK_SYNC_2) {
+			gw->idx = (c == UPLINK_SYNC_1) ? 1 : 0;
+			continue;
+		}
+		gw->frame[gw->idx++] = c;
+		if (gw->idx == UPLINK_HDR_LEN) {
+			uint16_t plen = (uint16_t)gw->frame[6] |
+					((uint16_t)gw->frame[7] << 8);
+			if (plen > UPLINK_PKT_PAYLOAD_MAX) {
+				// Not a real header; resynchronize
+				gw->frames_bad++;
+				gw->idx = 0;
+				continue;
+			}
+			gw->need = UPLINK_HDR_LEN + plen + UPLINK_CRC_LEN;
+		}
+		if (gw->idx >= UPLINK_HDR_LEN && gw->idx == gw->need) {
+			gw_handle_frame(gw);
+			gw->idx = 0;
+		}
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Serial mode
+
+static double opt_ack_loss_pct = 0.0;
+
+static void serial_on_record(gw_t *gw, uint8_t type, const uint8_t *d, uint8_t len)
+{
+	FILE *out = (FILE *)gw->user;
+	uint32_t ts_ms;
+
+	if (len < 4)
+		return;
+	memcpy(&ts_ms, d, 4);
+	if (type == UPLINK_REC_PM && len >= 4 + 24) {
+		fprintf(out, "pm,%u", ts_ms);
+		for (int i = 0; i < 12; ++i) {
+			uint16_t v;
+			memcpy(&v, &d[4 + 2 * i], 2);
+			fprintf(out, ",%u", v);
+		}
+		fputc('\n', out);
+	} else if (type == UPLINK_REC_GPS) {
+		fprintf(out, "gps,%u,\"%.*s\"\n", ts_ms, len - 4, (const char *)&d[4]);
+	} else {
+		fprintf(out, "unknown-%u,%u,%u\n", type, ts_ms, len);
+	}
+	fflush(out);
+}
+
+static int serial_fd = -1;
+static void serial_send_ack(gw_t *gw, const uint8_t *f, size_t len)
+{
+	(void)gw;
+	if (rng_chance(opt_ack_loss_pct))
+		return;
+	if (write(serial_fd, f, len) < 0)
+		perror("write");
+}
+
+static speed_t baud_to_speed(long baud)
+{
+	switch (baud) {
+	case 9600:   return B9600;
+	case 19200:  return B19200;
+	case 38400:  return B38400;
+	case 57600:  return B57600;
+	case 115200: return B115200;
+	default:     return B0;
+	}
+}
+
+static int serial_open(const char *path, long baud)
+{
+	struct termios tio;
+	int fd = open(path, O_RDWR | O_NOCTTY);
+
+	if (fd < 0) {
+		perror(path);
+		return -1;
+	}
+	if (isatty(fd)) {
+		if (tcgetattr(fd, &tio) != 0) {
+			perror("tcgetattr");
+			close(fd);
+			return -1;
+		}
+		cfmakeraw(&tio);
+		if (baud_to_speed(baud) != B0) {
+			cfsetispeed(&tio, baud_to_speed(baud));
+			cfsetospeed(&tio, baud_to_speed(baud));
+		}
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+	return fd;
+}
+
+static int run_serial(const char *path, long baud, const char *out_path)
+{
+	static gw_t gw;
+	uint8_t buf[512];
+	FILE *out = stdout;
+	time_t last_report = time(NULL);
+	unsigned long last_bytes = 0;
+
+	serial_fd = serial_open(path, baud);
+	if (serial_fd < 0)
+		return 1;
+	if (out_path && (out = fopen(out_path, "a")) == NULL) {
+		perror(out_path);
+		return 1;
+	}
+
+	gw.on_record = serial_on_record;
+	gw.send_ack = serial_send_ack;
+	gw.user = out;
+
+	for (;;) {
+		struct timeval tv = { 1, 0 };
+		fd_set rfds;
+		ssize_t n;
+
+		FD_ZERO(&rfds);
+		FD_SET(serial_fd, &rfds);
+		n = select(serial_fd + 1, &rfds, NULL, NULL, &tv);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n == 0) {
+			gw_keepalive(&gw);
+			continue;
+		}
+
+		n = read(serial_fd, buf, sizeof(buf));
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n <= 0)
+			break;
+		gw_feed(&gw, buf, (size_t)n);
+
+		if (time(NULL) != last_report) {
+			last_report = time(NULL);
+			fprintf(stderr,
+				"[gw] frames ok=%lu dup=%lu gap=%lu bad=%lu | records=%lu | %lu B/s\n",
+				gw.frames_ok, gw.frames_dup, gw.frames_gap,
+				gw.frames_bad, gw.records,
+				gw.record_bytes - last_bytes);
+			last_bytes = gw.record_bytes;
+		}
+	}
+	return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+// Self-test mode: the firmware's uplink module against a simulated link
+
+/// Virtual time, in microseconds
+static uint64_t sim_now_us;
+
+/// Link parameters
+static long   sim_baud = 38400;
+static double sim_frame_loss_pct = 0.0;
+static uint64_t sim_outage_start_us = 20ull * 1000000;
+static uint64_t sim_outage_len_us = 10ull * 1000000;
+static uint64_t sim_latency_us = 2000;
+
+/// Device -> gateway: the frame currently "on the wire"
+static uint8_t  sim_tx_frame[UPLINK_HDR_LEN + UPLINK_PKT_PAYLOAD_MAX + UPLINK_CRC_LEN];
+static size_t   sim_tx_len;
+static uint64_t sim_tx_done_us;
+static int      sim_tx_active;
+static unsigned long sim_link_bytes;
+
+/// Gateway -> device: ACKs in transit
+#define SIM_ACK_Q 64
+static struct {
+	uint8_t  f[UPLINK_HDR_LEN + UPLINK_CRC_LEN];
+	uint64_t due_us;
+} sim_ackq[SIM_ACK_Q];
+static unsigned sim_ackq_head, sim_ackq_tail;
+
+static int sim_in_outage(uint64_t t)
+{
+	return t >= sim_outage_start_us &&
+	       t < sim_outage_start_us + sim_outage_len_us;
+}
+
+static uint64_t sim_byte_time_us(size_t n)
+{
+	return (uint64_t)n * 10u * 1000000u / (uint64_t)sim_baud;
+}
+
+// Platform functions used by src/uplink.c
+void platform_tick_count(platform_timespec_t *tick)
+{
+	tick->nr_sec  = (uint32_t)(sim_now_us / 1000000u);
+	tick->nr_nsec = (uint32_t)(sim_now_us % 1000000u) * 1000u;
+}
+bool platform_usart_cdc_tx_busy(void)
+{
+	return sim_tx_active;
+}
+bool platform_usart_cdc_tx_async(const platform_usart_tx_bufdesc_t *desc,
+				 unsigned int nr_desc)
+{
+	size_t len = 0;
+
+	if (sim_tx_active)
+		return false;
+	for (unsigned int i = 0; i < nr_desc; ++i) {
+		memcpy(&sim_tx_frame[len], desc[i].buf, desc[i].len);
+		len += desc[i].len;
+	}
+	sim_tx_len = len;
+	sim_tx_done_us = sim_now_us + sim_byte_time_us(len);
+	sim_tx_active = 1;
+	return true;
+}
+
+/// Per-run bookkeeping for the self-test gateway
+static struct {
+	uint32_t last_counter;
+	int      have_counter;
+	unsigned long delivered;
+	unsigned long duplicates;
+	unsigned long gaps;
+	uint32_t backlog_counter;      // Last record generated before the link returned
+	int      backlog_set;
+	uint64_t drained_us;           // When that record reached the gateway
+} st;
+
+static void sim_on_record(gw_t *gw, uint8_t type, const uint8_t *d, uint8_t len)
+{
+	uint32_t counter;
+
+	(void)gw;
+	if (type != UPLINK_REC_PM || len < 8)
+		return;
+	memcpy(&counter, &d[4], 4);
+	if (st.have_counter && counter <= st.last_counter) {
+		st.duplicates++;
+		return;
+	}
+	if (st.have_counter && counter != st.last_counter + 1)
+		st.gaps += counter - st.last_counter - 1;
+	st.last_counter = counter;
+	st.have_counter = 1;
+	st.delivered++;
+
+	if (st.backlog_set && st.drained_us == 0 && counter >= st.backlog_counter)
+		st.drained_us = sim_now_us;
+}
+
+static void sim_send_ack(gw_t *gw, const uint8_t *f, size_t len)
+{
+	uint64_t due = sim_now_us + sim_latency_us + sim_byte_time_us(len);
+
+	(void)gw;
+	if (sim_in_outage(sim_now_us) || sim_in_outage(due) ||
+	    rng_chance(sim_frame_loss_pct))
+		return;
+	if (sim_ackq_head - sim_ackq_tail >= SIM_ACK_Q)
+		return;
+	memcpy(sim_ackq[sim_ackq_head % SIM_ACK_Q].f, f, len);
+	sim_ackq[sim_ackq_head % SIM_ACK_Q].due_us = due;
+	++sim_ackq_head;
+}
+
+static int run_selftest(double rate_hz, double duration_s)
+{
+	static gw_t gw;
+	uint64_t end_us = (uint64_t)(duration_s * 1e6);
+	uint64_t step_us = 100;
+	uint64_t next_rec_us = 0;
+	uint64_t next_keepalive_us = 0;
+	uint64_t rec_period_us = (uint64_t)(1e6 / rate_hz);
+	uint64_t outage_end_us = sim_outage_start_us + sim_outage_len_us;
+	uint32_t counter = 0;
+	unsigned long generated = 0;
+	unsigned long backlog_records = 0;
+	uplink_stats_t us;
+
+	gw.on_record = sim_on_record;
+	gw.send_ack = sim_send_ack;
+	uplink_init();
+	logstore_init();
+
+	for (sim_now_us = 0; sim_now_us < end_us; sim_now_us += step_us) {
+		platform_timespec_t now;
+
+		// Sensor records arrive at a fixed rate
+		while (sim_now_us >= next_rec_us) {
+			uint8_t rec[4 + 24] = {0};
+			uint32_t ts_ms = (uint32_t)(sim_now_us / 1000u);
+
+			memcpy(&rec[0], &ts_ms, 4);
+			memcpy(&rec[4], &counter, 4);
+			logstore_append(UPLINK_REC_PM, rec, sizeof(rec));
+			++counter;
+			++generated;
+			next_rec_us += rec_period_us;
+		}
+
+		// Note the backlog at the moment the link comes back
+		if (!st.backlog_set && sim_outage_len_us > 0 &&
+		    sim_now_us >= outage_end_us) {
+			st.backlog_set = 1;
+			st.backlog_counter = counter - 1;
+			backlog_records = (st.have_counter) ?
+				(unsigned long)(counter - 1 - st.last_counter) : counter;
+		}
+
+		// Device -> gateway frame completes
+		if (sim_tx_active && sim_now_us >= sim_tx_done_us) {
+			sim_tx_active = 0;
+			sim_link_bytes += sim_tx_len;
+			if (!sim_in_outage(sim_now_us) &&
+			    !rng_chance(sim_frame_loss_pct))
+				gw_feed(&gw, sim_tx_frame, sim_tx_len);
+		}
+
+		// The gateway repeats its last ACK twice a second
+		if (sim_now_us >= next_keepalive_us) {
+			gw_keepalive(&gw);
+			next_keepalive_us = sim_now_us + 500000;
+		}
+
+		// Gateway -> device ACKs arrive
+		while (sim_ackq_tail != sim_ackq_head &&
+		       sim_ackq[sim_ackq_tail % SIM_ACK_Q].due_us <= sim_now_us) {
+			uplink_rx_feed((const char *)sim_ackq[sim_ackq_tail % SIM_ACK_Q].f,
+				       UPLINK_HDR_LEN + UPLINK_CRC_LEN);
+			++sim_ackq_tail;
+		}
+
+		platform_tick_count(&now);
+		logstore_service(&now);
+		uplink_service(&now);
+	}
+
+	uplink_get_stats(&us);
+	printf("link:     %ld bd, frame loss %.1f%%, outage %.1f s at t=%.1f s\n",
+	       sim_baud, sim_frame_loss_pct, sim_outage_len_us / 1e6,
+	       sim_outage_start_us / 1e6);
+	printf("records:  generated %lu, delivered %lu, duplicates %lu, "
+	       "missing %lu (log bytes skipped %u), still queued %u B\n",
+	       generated, st.delivered, st.duplicates, st.gaps,
+	       us.bytes_skipped, us.queue_used);
+	printf("packets:  sent %u, retried %u, acked %u, bad acks %u, "
+	       "gw dup %lu, gw gap %lu\n",
+	       us.packets_sent, us.packets_retried, us.packets_acked,
+	       us.acks_bad, gw.frames_dup, gw.frames_gap);
+	printf("link use: %.1f%% of %ld B/s, goodput %.0f B/s, queue peak %u of %u B\n",
+	       100.0 * sim_link_bytes / (duration_s * sim_baud / 10.0),
+	       sim_baud / 10, gw.record_bytes / duration_s,
+	       us.queue_peak, UPLINK_QUEUE_SZ);
+	if (st.backlog_set) {
+		if (st.drained_us) {
+			double t = (st.drained_us - outage_end_us) / 1e6;
+			printf("recovery: %lu-record backlog drained %.2f s after "
+			       "the link returned (%.0f records/s)\n",
+			       backlog_records, t,
+			       t > 0 ? backlog_records / t : 0.0);
+		} else {
+			printf("recovery: backlog of %lu records NOT drained by end of run\n",
+			       backlog_records);
+		}
+	}
+	return (st.duplicates == 0) ? 0 : 2;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"usage: %s [-d DEVICE] [-b BAUD] [-o OUT.csv] [-l ACK_LOSS_PCT]\n"
+		"       %s -S [-b BAUD] [-l FRAME_LOSS_PCT] [-r RECORDS_PER_S]\n"
+		"          [-t SECONDS] [-a OUTAGE_START_S] [-w OUTAGE_LEN_S] [-s SEED]\n",
+		argv0, argv0);
+}
+
+int main(int argc, char **argv)
+{
+	const char *dev = "/dev/ttyACM0";
+	const char *out = NULL;
+	long baud = 38400;
+	double loss = 0.0, rate = 4.0, duration = 60.0;
+	int selftest = 0;
+	int c;
+
+	while ((c = getopt(argc, argv, "d:b:o:l:Sr:t:a:w:s:h")) != -1) {
+		switch (c) {
+		case 'd': dev = optarg; break;
+		case 'b': baud = strtol(optarg, NULL, 10); break;
+		case 'o': out = optarg; break;
+		case 'l': loss = strtod(optarg, NULL); break;
+		case 'S': selftest = 1; break;
+		case 'r': rate = strtod(optarg, NULL); break;
+		case 't': duration = strtod(optarg, NULL); break;
+		case 'a': sim_outage_start_us = (uint64_t)(strtod(optarg, NULL) * 1e6); break;
+		case 'w': sim_outage_len_us = (uint64_t)(strtod(optarg, NULL) * 1e6); break;
+		case 's': rng_state = (uint32_t)strtoul(optarg, NULL, 0) | 1u; break;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (selftest) {
+		if (rate <= 0 || duration <= 0 || baud <= 0) {
+			usage(argv[0]);
+			return 1;
+		}
+		sim_baud = baud;
+		sim_frame_loss_pct = loss;
+		return run_selftest(rate, duration);
+	}
+
+	opt_ack_loss_pct = loss;
+	return run_serial(dev, baud, out);
+}
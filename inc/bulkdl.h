@@ -0,0 +1,145 @@
+/**
+ * @file bulkdl.h
+ * @brief Bulk download of the on-device record log over the CDC link.
+ *
+ * A host client pulls log blocks (see logstore.h) with a sliding-window,
+ * selective-repeat protocol: the device keeps up to BULKDL_WINDOW blocks in
+ * flight, the host acknowledges cumulatively plus a bitmap of blocks received
+ * out of order, and only blocks reported missing (or timed out) are re-sent.
+ * Every frame carries a CRC32, so a block is either delivered intact or
+ * discarded and re-requested. Because blocks are addressed by their absolute
+ * log number, an interrupted download resumes by simply starting a new
+ * session from the first block the host does not have yet.
+ *
+ * Frame layout (all multi-byte fields little-endian):
+ *
+ *   +------+------+------+-------+-------+---------+-------+
+ *   | 0xC3 | 0x3C | type | flags | len   | payload | crc32 |
+ *   |  1   |  1   |  1   |  1    | 2     | len     | 4     |
+ *   +------+------+------+-------+-------+---------+-------+
+ *
+ * The CRC (CRC-32/ISO-HDLC, see crc32.h) covers everything from @c type to
+ * the end of the payload. Payloads by frame type:
+ *
+ *   Host -> device
+ *   - INFO_REQ: none
+ *   - START:    from_block:4, to_block:4 (exclusive; 0xFFFFFFFF = newest)
+ *   - ACK:      next_block:4 (all blocks below it received), sack:4 (bit i
+ *               set = block next_block + 1 + i received)
+ *   - STOP:     none
+ *   - METRICS_REQ: first:2 (index of the first metric wanted)
+ *
+ *   Device -> host
+ *   - INFO:     first_block:4, end_block:4, block_sz:2, window:2; sent in
+ *               reply to INFO_REQ, and to START with BULKDL_FLAG_SESSION set
+ *               and the (clamped) range of the new session
+ *   - BLOCK:    block:4, data (LOGSTORE_BLOCK_SZ bytes, fewer for the newest
+ *               block, none if the block has been evicted meanwhile)
+ *   - DONE:     end_block:4; every block of the session was acknowledged
+ *   - METRICS:  first:2, total:2, then as many metric records (metrics.h)
+ *               from index @c first on as fit in one frame; the host asks
+ *               again from the index after the last record until it has
+ *               @c total
+ *
+ * METRICS_REQ is answered whether or not a session is active, so the counters
+ * can be read without downloading anything.
+ *
+ * While a session is active the device yields the CDC link to the transfer:
+ * terminal output and the uplink are held off until it completes, is
+ * stopped, or the host goes quiet for BULKDL_IDLE_TIMEOUT_MS.
+ */
+
+#ifndef BULKDL_H
+#define BULKDL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "platform.h"
+#include "logstore.h"
+
+// --- Frame Definitions ---
+#define BULKDL_SYNC_1                   0xC3
+#define BULKDL_SYNC_2                   0x3C
+#define BULKDL_HDR_LEN                  6   // Sync, type, flags, len
+#define BULKDL_CRC_LEN                  4
+
+#define BULKDL_TYPE_INFO_REQ            0x10 // Host -> device
+#define BULKDL_TYPE_START               0x11 // Host -> device
+#define BULKDL_TYPE_ACK                 0x12 // Host -> device
+#define BULKDL_TYPE_STOP                0x13 // Host -> device
+#define BULKDL_TYPE_METRICS_REQ         0x14 // Host -> device
+#define BULKDL_TYPE_INFO                0x20 // Device -> host
+#define BULKDL_TYPE_BLOCK               0x21 // Device -> host
+#define BULKDL_TYPE_DONE                0x22 // Device -> host
+#define BULKDL_TYPE_METRICS             0x23 // Device -> host
+
+#define BULKDL_FLAG_SESSION             0x01 // INFO describes a newly started session
+
+#define BULKDL_TO_NEWEST                0xFFFFFFFFu // START: download up to the newest block
+
+/// Size of a BLOCK frame carrying a complete block
+#define BULKDL_BLOCK_FRAME_MAX          (BULKDL_HDR_LEN + 4 + LOGSTORE_BLOCK_SZ + BULKDL_CRC_LEN)
+
+// --- Tunables ---
+#define BULKDL_WINDOW                   8    // Blocks in flight; at most 33 (SACK bitmap width + 1)
+#define BULKDL_BURST                    2    // Frames handed to the CDC driver per request
+#define BULKDL_RTO_MIN_MS               500  // Initial retransmission timeout
+#define BULKDL_RTO_MAX_MS               4000 // Backoff ceiling
+#define BULKDL_IDLE_TIMEOUT_MS          5000 // End the session if the host goes quiet
+
+/**
+ * @brief Counters describing download behaviour since @c bulkdl_init().
+ */
+typedef struct {
+    uint32_t sessions;          // START requests accepted
+    uint32_t sessions_done;     // Sessions that ran to completion
+    uint32_t sessions_expired;  // Sessions ended by the idle timeout
+    uint32_t blocks_sent;       // BLOCK frames sent (incl. retransmissions)
+    uint32_t blocks_resent;     // BLOCK frames re-sent (reported missing or timed out)
+    uint32_t blocks_acked;      // Blocks acknowledged by the host
+    uint32_t timeouts;          // Retransmission timeouts
+    uint32_t frames_bad;        // Host frames with a bad CRC, length or type
+} bulkdl_stats_t;
+
+/**
+ * @brief Initializes the download state machine and its request parser.
+ */
+void bulkdl_init(void);
+
+/**
+ * @brief Feeds bytes received from the host (CDC RX) into the request parser.
+ *
+ * Bytes that are not part of a valid download frame are ignored, so the same
+ * stream may be fed to other protocol parsers as well.
+ *
+ * @param buf Received bytes.
+ * @param len Number of bytes in @p buf.
+ */
+void bulkdl_rx_feed(const char *buf, uint16_t len);
+
+/**
+ * @brief Runs the window, retransmission and timeout logic.
+ *
+ * Hands at most BULKDL_BURST frames to the CDC driver per call, and only when
+ * the transmitter is idle. Intended to be called once per main-loop iteration.
+ *
+ * @param now Current time.
+ */
+void bulkdl_service(const platform_timespec_t *now);
+
+/**
+ * @brief Checks whether the download currently owns the CDC link.
+ *
+ * @return true while a session is active or a reply is waiting to be sent.
+ */
+bool bulkdl_active(void);
+
+/**
+ * @brief Copies the current download counters.
+ *
+ * @param out Destination for the counters.
+ */
+void bulkdl_get_stats(bulkdl_stats_t *out);
+
+#endif // BULKDL_H
@@ -0,0 +1,99 @@
+/**
+ * @file crc32.h
+ * @brief CRC-32/ISO-HDLC (as used by zlib) for frames, log sectors and records.
+ *
+ * One API with two engines:
+ *
+ * - CRC32_BACKEND_DSU uses the CRC32 engine of the Device Service Unit
+ *   (platform/dsu.c). The DSU only works on word-aligned runs of whole words,
+ *   so the bytes before the first and after the last aligned word, and any
+ *   buffer shorter than CRC32_DSU_MIN_LEN, go through the software engine. If
+ *   the DSU reports a bus error the software engine takes over for good.
+ *
+ * - CRC32_BACKEND_SW is a byte-wise table lookup (1 KiB table in flash). It
+ *   is what host builds use, and it is always available as crc32_sw().
+ *
+ * Both engines produce identical results, so data checked on the host (for
+ * example by host/tools/bulkdl_client.c) matches what the device computed.
+ */
+
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// --- Backend Selection ---
+#define CRC32_BACKEND_SW                0
+#define CRC32_BACKEND_DSU               1
+#ifndef CRC32_BACKEND
+#if defined(__XC32)
+#define CRC32_BACKEND                   CRC32_BACKEND_DSU
+#else
+#define CRC32_BACKEND                   CRC32_BACKEND_SW
+#endif
+#endif
+
+// --- Tunables ---
+#define CRC32_DSU_MIN_LEN               32  // Shorter buffers are cheaper in software
+
+/**
+ * @brief Counters describing how CRC work was split between the engines.
+ */
+typedef struct {
+    uint32_t bytes_sw;          // Bytes processed by the table
+    uint32_t bytes_dsu;         // Bytes processed by the DSU
+    uint32_t dsu_errors;        // DSU bus errors (the DSU is not used after the first)
+} crc32_stats_t;
+
+/**
+ * @brief Timing of one buffer length, as measured by crc32_bench().
+ */
+typedef struct {
+    uint16_t len;               // Buffer length, in bytes
+    uint32_t sw_ns;             // Time per call, software engine
+    uint32_t dsu_ns;            // Time per call, crc32_update() with the DSU (0: not available)
+} crc32_bench_t;
+
+/// Buffer lengths timed by crc32_bench(); 504 bytes is what a full bulkdl BLOCK frame covers
+#define CRC32_BENCH_LENS                { 8, 32, 128, 504, 1016 }
+#define CRC32_BENCH_NR_LENS             5
+
+/**
+ * @brief Computes the CRC with the configured engine.
+ *
+ * The value is chainable in the zlib style: pass 0 for the first block and the
+ * previous return value for the following ones.
+ *
+ * @param crc CRC of the preceding data, or 0.
+ * @param buf Data to include; any alignment.
+ * @param len Number of bytes in @p buf.
+ * @return Updated CRC.
+ */
+uint32_t crc32_update(uint32_t crc, const void *buf, size_t len);
+
+/**
+ * @brief Computes the CRC in software; same contract as crc32_update().
+ */
+uint32_t crc32_sw(uint32_t crc, const void *buf, size_t len);
+
+/**
+ * @brief Copies the engine counters.
+ *
+ * @param out Destination for the counters.
+ */
+void crc32_get_stats(crc32_stats_t *out);
+
+/**
+ * @brief Times both engines over buffers of CRC32_BENCH_LENS bytes.
+ *
+ * Blocks for a few milliseconds (on the target), and checks that both
+ * engines agree while doing so.
+ *
+ * @param out One result per length, in the order of CRC32_BENCH_LENS.
+ * @return true if the engines agreed on every buffer.
+ */
+bool crc32_bench(crc32_bench_t out[CRC32_BENCH_NR_LENS]);
+
+#endif // CRC32_H
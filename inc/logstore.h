@@ -0,0 +1,179 @@
+/**
+ * @file logstore.h
+ * @brief Append-only on-device record log, read back in fixed-size blocks.
+ *
+ * Records are appended as a byte stream using the same layout and type codes
+ * as uplink records, @code [rec_type:1][rec_len:1][rec_data:rec_len] @endcode
+ * (see uplink.h). The stream is addressed in LOGSTORE_BLOCK_SZ-byte blocks
+ * numbered from the first byte ever written, so a block number stays valid
+ * for the life of the log and a reader can resume from any block it has not
+ * yet seen. The newest block is usually partial and grows as records arrive.
+ *
+ * Two backends implement this interface; LOGSTORE_BACKEND selects one:
+ *
+ * - LOGSTORE_BACKEND_RAM (src/logstore.c) keeps the most recent
+ *   LOGSTORE_RAM_BLOCKS blocks in RAM; older blocks are evicted and are no
+ *   longer readable.
+ *
+ * - LOGSTORE_BACKEND_SD (src/logstore_sd.c) stages blocks in RAM and writes
+ *   them to an SD card (see sdcard.h) in batches, one block per 512-byte
+ *   sector starting at LOGSTORE_SD_FIRST_LBA. On start-up the end of the log
+ *   on the card is found again, and the log continues where it left off.
+ *   Without a card it behaves like the RAM backend with
+ *   LOGSTORE_SD_STAGE_BLOCKS blocks.
+ *
+ * Sector layout on the card (all multi-byte fields little-endian):
+ *
+ *   +-------+-------+------+-------+-------+---------------------+
+ *   | magic | block | used | epoch | crc32 | data                |
+ *   | 4     | 4     | 2    | 2     | 4     | LOGSTORE_BLOCK_SZ   |
+ *   +-------+-------+------+-------+-------+---------------------+
+ *
+ * @c used is the number of valid data bytes (the rest is zero). Only the
+ * newest block of a log is ever partial, and it is rewritten as it fills up.
+ * @c epoch tells one log apart from leftovers of an older one on the same
+ * card. The CRC (see crc32.h) covers the first 12 header bytes and all of
+ * @c data.
+ */
+
+#ifndef LOGSTORE_H
+#define LOGSTORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "platform.h"
+
+// --- Sector Format ---
+#define LOGSTORE_SECTOR_SZ              512
+#define LOGSTORE_SECTOR_HDR_SZ          16
+#define LOGSTORE_SECTOR_MAGIC           0x3153474Cu // "LGS1"
+#define LOGSTORE_BLOCK_SZ               (LOGSTORE_SECTOR_SZ - LOGSTORE_SECTOR_HDR_SZ)
+
+/// Returned by logstore_read_block() while the block is fetched from the card
+#define LOGSTORE_READ_PENDING           0xFFFF
+
+// --- Backend Selection ---
+#define LOGSTORE_BACKEND_RAM            0
+#define LOGSTORE_BACKEND_SD             1
+#ifndef LOGSTORE_BACKEND
+#define LOGSTORE_BACKEND                LOGSTORE_BACKEND_SD
+#endif
+
+// --- Tunables ---
+#ifndef LOGSTORE_RAM_BLOCKS
+#define LOGSTORE_RAM_BLOCKS             16   // Blocks of history held by the RAM backend
+#endif
+#define LOGSTORE_RAM_SZ                 (LOGSTORE_RAM_BLOCKS * LOGSTORE_BLOCK_SZ)
+
+#ifndef LOGSTORE_SD_FIRST_LBA
+#define LOGSTORE_SD_FIRST_LBA           2048 // Leaves room for a partition table
+#endif
+#define LOGSTORE_SD_STAGE_BLOCKS        8    // Blocks staged in RAM ahead of the card
+#define LOGSTORE_SD_BATCH_MIN           4    // Complete blocks that trigger a write
+#define LOGSTORE_SD_FLUSH_MS            1000 // Write anything older than this
+#define LOGSTORE_SD_RETRY_MS            2000 // Re-identify the card after an error
+
+/**
+ * @brief Counters describing the log since @c logstore_init().
+ *
+ * Byte counts include the two-byte record headers.
+ */
+typedef struct {
+    uint32_t records_appended;  // Records accepted by logstore_append()
+    uint32_t records_dropped;   // Records rejected because the staging area (or card) was full
+    uint32_t bytes_appended;    // Bytes accepted
+    uint32_t bytes_durable;     // Bytes of those that are on the card
+    uint32_t blocks_evicted;    // Blocks dropped from RAM without reaching a card
+    uint32_t blocks_written;    // Blocks written to the card (partial blocks count each time)
+    uint32_t write_batches;     // Multi-block writes to the card
+    uint32_t write_errors;      // Card writes that failed (and were retried)
+    bool     card_ok;           // The log is being kept on a card
+} logstore_stats_t;
+
+/**
+ * @brief Empties the log (RAM) or starts finding it on the card (SD).
+ *
+ * Block numbering restarts at zero for the RAM backend; the SD backend
+ * continues the numbering of the log on the card once it has been mounted.
+ * Until then the log reads as empty, but records are accepted.
+ */
+void logstore_init(void);
+
+/**
+ * @brief Runs the card mount, write-back and read state machines.
+ *
+ * Never waits on the card. Intended to be called once per main-loop
+ * iteration; a no-op for the RAM backend.
+ *
+ * @param now Current time.
+ */
+void logstore_service(const platform_timespec_t *now);
+
+/**
+ * @brief Appends a record to the log.
+ *
+ * Never waits on the card: if the record does not fit, either the oldest
+ * data is evicted (no card) or the record is dropped (card writes are
+ * lagging), so that what is on the card stays contiguous.
+ *
+ * @param type Record type (UPLINK_REC_*).
+ * @param data Record contents.
+ * @param len Length of @p data; at most 255 bytes.
+ * @return true if the record was stored, false if it was rejected.
+ */
+bool logstore_append(uint8_t type, const void *data, uint16_t len);
+
+/**
+ * @brief Returns the number of the oldest block that can still be read.
+ */
+uint32_t logstore_first_block(void);
+
+/**
+ * @brief Returns one past the number of the newest block holding any data.
+ */
+uint32_t logstore_end_block(void);
+
+/**
+ * @brief Finds the end of the log, which is always a record boundary.
+ *
+ * Like the block numbers, only meaningful once the log can be read (see
+ * @c logstore_get_boot()).
+ *
+ * @param blk Receives the block that the next byte will go to.
+ * @param off Receives the offset of that byte within the block.
+ */
+void logstore_get_end(uint32_t *blk, uint16_t *off);
+
+/**
+ * @brief Finds the first byte appended since @c logstore_init().
+ *
+ * @param blk Receives its block number.
+ * @param off Receives its offset within the block.
+ * @return false while the log reads as empty, as it does until the SD
+ *         backend has mounted it.
+ */
+bool logstore_get_boot(uint32_t *blk, uint16_t *off);
+
+/**
+ * @brief Copies one block out of the log.
+ *
+ * Blocks that are only on the card are fetched in the background: the call
+ * returns LOGSTORE_READ_PENDING, and a later call for the same block (after
+ * @c logstore_service() has run) returns the data.
+ *
+ * @param blk Block number.
+ * @param buf Destination of at least LOGSTORE_BLOCK_SZ bytes.
+ * @return Number of bytes copied: LOGSTORE_BLOCK_SZ for a complete block, less
+ *         for the newest (partial) block, 0 if the block is not available, or
+ *         LOGSTORE_READ_PENDING.
+ */
+uint16_t logstore_read_block(uint32_t blk, void *buf);
+
+/**
+ * @brief Copies the current log counters.
+ *
+ * @param out Destination for the counters.
+ */
+void logstore_get_stats(logstore_stats_t *out);
+
+#endif // LOGSTORE_H
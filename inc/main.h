@@ -9,9 +9,10 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "variant.h"      // FEATURE_GPS_ENABLED, FEATURE_PM_ENABLED
 #include "platform.h"      // For platform_usart_rx_async_desc_t, platform_usart_tx_bufdesc_t
 #include "parsers/pms_parser.h" // For pms_parser_internal_state_t, pms_data_t
-// #include "parsers/nmea_parser.h" // Or nmea_parse.h - For any GPS specific data types if needed directly here
+#include "parsers/nmea_parser.h" // For nmea_sentence_state_t
 
 // Application Flags (Example - to be expanded)
 #define PROG_FLAG_BANNER_PENDING            (1 << 0) // Request to display the startup banner
@@ -28,7 +29,8 @@
 #define CDC_RX_BUF_SZ                       64
 #define GPS_RX_BUF_SZ                       128
 #define PM_RX_BUF_SZ                        64 // PMS data packets are small (e.g., 32 bytes for PMS5003)
-#define GPS_ASSEMBLY_BUF_SZ                 256 // To assemble full NMEA sentences
+#define GPS_FORMAT_BUF_SZ                   128 // Formatted GPGLL line (time | lat | lon); taken from the scratch arena
+#define CONSOLE_LINE_SZ                     16  // Longest terminal command (e.g. "metrics")
 
 /**
  * @brief Main application state structure.
@@ -42,26 +44,35 @@ typedef struct prog_state_type {
     platform_usart_rx_async_desc_t cdc_rx_desc;
     char                        cdc_rx_buf[CDC_RX_BUF_SZ];
 
+#if FEATURE_GPS_ENABLED
     // GPS Module (SERCOM1)
     platform_usart_rx_async_desc_t gps_rx_desc;
     char                        gps_rx_buf[GPS_RX_BUF_SZ];
-    char                        gps_assembly_buf[GPS_ASSEMBLY_BUF_SZ];
-    uint16_t                    gps_assembly_len;
+    nmea_sentence_state_t       gps_sentence; // From nmea_parser.h; assembles sentences across RX chunks
     // Storage for parsed GPGLL data
     char                        parsed_gps_time[16];
     char                        parsed_gps_lat[20];
     char                        parsed_gps_lon[20];
+#endif
 
+#if FEATURE_PM_ENABLED
     // PM Sensor (SERCOM0)
     platform_usart_rx_async_desc_t pm_rx_desc;
     char                        pm_rx_buf[PM_RX_BUF_SZ];
     pms_parser_internal_state_t pms_parser_state; // From pms_parser.h
     pms_data_t                  latest_pms_data;  // From pms_parser.h
+#endif
 
     // UI state
     bool                        banner_displayed; // Whether banner has been displayed this session
     bool                        is_debug;         // Debug mode toggle for displaying raw hex data
 
+    // Terminal commands typed on the CDC link
+    char                        console_line[CONSOLE_LINE_SZ]; // Command being typed
+    uint8_t                     console_len;
+    bool                        metrics_pending;  // "metrics" received; listing in progress
+    uint16_t                    metrics_next;     // Next metric to list
+
     // Button state or other shared resources
     uint16_t button_event;
     
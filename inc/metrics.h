@@ -0,0 +1,189 @@
+/**
+ * @file metrics.h
+ * @brief Statically registered counters, gauges and histograms.
+ *
+ * A module exposes a metric with one line at file scope:
+ *
+ *     METRIC_COUNTER(uplink_retries);     // metric_inc(&uplink_retries)
+ *     METRIC_GAUGE(stack_used);           // metric_set(&stack_used, v)
+ *     METRIC_HISTOGRAM(loop_us);          // metric_observe(&loop_us, v)
+ *
+ * Each line defines the storage (static, in .bss) and a descriptor placed in
+ * the "metrics" linker section, so the registry is simply that section:
+ * nothing has to be called at start-up, and metrics.c finds every metric of
+ * every linked module through the __start_metrics/__stop_metrics symbols the
+ * linker provides. (The section must not be garbage-collected; the XC32
+ * projects build without "remove unused sections".)
+ *
+ * Updates are single atomic read-modify-writes (LDREX/STREX on the M23), so
+ * they may be made from interrupt handlers and the main loop alike without
+ * masking interrupts. A histogram's fields are updated one after another, so
+ * a reader may see an observation in its count before it shows in its sum.
+ *
+ * Histograms count observations in log2 buckets: bucket 0 holds 0, bucket b
+ * holds [2^(b-1), 2^b), and the last bucket everything above.
+ *
+ * Export: metrics_snapshot() copies a metric by index; metrics_format() turns
+ * a snapshot into a terminal line (the "metrics" command), metrics_encode()
+ * into the binary record carried by the bulk download's METRICS frame (see
+ * bulkdl.h), which metrics_decode() reads back on the host.
+ *
+ * Binary record (multi-byte fields little-endian):
+ *
+ *   kind:1, name_len:1, name (name_len bytes, no terminator), then
+ *   - counter:   value:4
+ *   - gauge:     value:4 (signed)
+ *   - histogram: count:4, sum:4, max:4, nr_buckets:1, bucket:4 each
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define METRICS_NAME_MAX                24   // Longest metric name
+#define METRICS_HIST_BUCKETS            16   // 0, [1,2), [2,4) ... [2^14, inf)
+
+/// Longest binary record (a histogram with the longest name)
+#define METRICS_RECORD_MAX              (2 + METRICS_NAME_MAX + 13 + 4 * METRICS_HIST_BUCKETS)
+
+// --- Metric Kinds ---
+#define METRIC_KIND_COUNTER             0
+#define METRIC_KIND_GAUGE               1
+#define METRIC_KIND_HISTOGRAM           2
+
+typedef struct {
+    volatile uint32_t value;
+} metric_counter_t;
+
+typedef struct {
+    volatile int32_t value;
+} metric_gauge_t;
+
+typedef struct {
+    volatile uint32_t count;
+    volatile uint32_t sum;                      // Wraps around
+    volatile uint32_t max;
+    volatile uint32_t bucket[METRICS_HIST_BUCKETS];
+} metric_histogram_t;
+
+/**
+ * @brief Registry entry, placed in the "metrics" section.
+ */
+typedef struct {
+    const char *name;
+    void       *data;                           // metric_*_t of the kind below
+    uint8_t     kind;                           // METRIC_KIND_*
+} metric_desc_t;
+
+/**
+ * @brief A metric's values at one moment, or as decoded from a record.
+ */
+typedef struct {
+    char     name[METRICS_NAME_MAX + 1];
+    uint8_t  kind;                              // METRIC_KIND_*
+    int32_t  value;                             // Counter (as unsigned) or gauge
+    uint32_t count;                             // Histogram fields
+    uint32_t sum;
+    uint32_t max;
+    uint32_t bucket[METRICS_HIST_BUCKETS];
+} metric_snapshot_t;
+
+#define METRIC_DEFINE_(type, kind, name) \
+    static type name; \
+    static const metric_desc_t metric_desc_##name \
+        __attribute__((section("metrics"), used, aligned(sizeof(void *)))) = \
+        { #name, (void *)&name, (kind) }; \
+    _Static_assert(sizeof(#name) <= METRICS_NAME_MAX + 1, "metric name too long: " #name)
+
+/// Defines and registers a counter named @p name.
+#define METRIC_COUNTER(name)    METRIC_DEFINE_(metric_counter_t, METRIC_KIND_COUNTER, name)
+
+/// Defines and registers a gauge named @p name.
+#define METRIC_GAUGE(name)      METRIC_DEFINE_(metric_gauge_t, METRIC_KIND_GAUGE, name)
+
+/// Defines and registers a log2-bucket histogram named @p name.
+#define METRIC_HISTOGRAM(name)  METRIC_DEFINE_(metric_histogram_t, METRIC_KIND_HISTOGRAM, name)
+
+// --- Updates (safe from interrupt handlers) ---
+
+static inline void metric_add(metric_counter_t *c, uint32_t n) {
+    __atomic_fetch_add(&c->value, n, __ATOMIC_RELAXED);
+}
+
+static inline void metric_inc(metric_counter_t *c) {
+    metric_add(c, 1);
+}
+
+static inline void metric_set(metric_gauge_t *g, int32_t v) {
+    __atomic_store_n(&g->value, v, __ATOMIC_RELAXED);
+}
+
+static inline void metric_gauge_add(metric_gauge_t *g, int32_t d) {
+    __atomic_fetch_add(&g->value, d, __ATOMIC_RELAXED);
+}
+
+static inline void metric_observe(metric_histogram_t *h, uint32_t v) {
+    unsigned int b = (v == 0) ? 0 : 32 - (unsigned int)__builtin_clz(v);
+    uint32_t max = __atomic_load_n(&h->max, __ATOMIC_RELAXED);
+
+    if (b >= METRICS_HIST_BUCKETS) {
+        b = METRICS_HIST_BUCKETS - 1;
+    }
+    __atomic_fetch_add(&h->bucket[b], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->count, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&h->sum, v, __ATOMIC_RELAXED);
+    while (v > max &&
+           !__atomic_compare_exchange_n(&h->max, &max, v, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        // max was reloaded; retry while v is still larger
+    }
+}
+
+// --- Registry and Export ---
+
+/**
+ * @brief Number of registered metrics.
+ */
+unsigned int metrics_count(void);
+
+/**
+ * @brief Returns the bytes of storage of all registered metrics.
+ *
+ * The storage sits in the modules that define the metrics; this sum is what
+ * the "metrics" entry of the RAM budget (ram_budget.h) is checked against.
+ */
+unsigned int metrics_ram_used(void);
+
+/**
+ * @brief Copies metric @p i.
+ *
+ * @return false if there is no metric @p i.
+ */
+bool metrics_snapshot(unsigned int i, metric_snapshot_t *out);
+
+/**
+ * @brief Formats a snapshot as one terminal line (with CR/LF).
+ *
+ * Histograms list their non-empty buckets by lower bound.
+ *
+ * @return Length of the line (as snprintf).
+ */
+int metrics_format(const metric_snapshot_t *s, char *buf, unsigned int size);
+
+/**
+ * @brief Encodes a snapshot as a binary record.
+ *
+ * @return Length of the record, or 0 if it does not fit in @p size bytes.
+ */
+uint16_t metrics_encode(const metric_snapshot_t *s, uint8_t *buf, uint16_t size);
+
+/**
+ * @brief Decodes one binary record.
+ *
+ * @return Bytes consumed, or 0 if the record is truncated or malformed.
+ */
+uint16_t metrics_decode(const uint8_t *buf, uint16_t len, metric_snapshot_t *out);
+
+#endif // METRICS_H
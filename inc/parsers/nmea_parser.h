@@ -36,4 +36,40 @@
  */
 bool nmea_parse_gpgll_and_format(const char* gpgll_sentence, char* out_buf, size_t out_buf_size);
 
+// --- Streaming Sentence Assembly ---
+
+// Longest sentence kept by the assembler, including "$" and the CRLF it appends.
+// NMEA 0183 caps sentences at 82 characters; longer lines are dropped.
+#define NMEA_SENTENCE_MAX_LEN 96
+
+/**
+ * @brief State of the byte-at-a-time sentence assembler.
+ */
+typedef struct {
+    char buf[NMEA_SENTENCE_MAX_LEN + 1]; // Sentence being assembled (NUL-terminated when complete)
+    size_t len;                          // Characters in buf; 0 while waiting for '$'
+    bool overflow;                       // Current line is too long and is being skipped
+} nmea_sentence_state_t;
+
+/**
+ * @brief Resets the assembler to wait for the next '$'.
+ *
+ * @param state Assembler state.
+ */
+void nmea_sentence_init(nmea_sentence_state_t *state);
+
+/**
+ * @brief Feeds one received character to the assembler.
+ *
+ * A sentence starts at '$' and ends at LF; a CR before the LF is optional, so
+ * both raw UART data and captures saved with bare LF line endings work. The
+ * cost per character is constant, however much data has been fed before.
+ *
+ * @param state Assembler state.
+ * @param c The received character.
+ * @return The completed sentence, always ending in "\r\n" (valid until the
+ *         next call), or NULL if none was completed by this character.
+ */
+const char* nmea_sentence_feed(nmea_sentence_state_t *state, char c);
+
 #endif // NMEA_PARSER_H
\ No newline at end of file
@@ -14,6 +14,8 @@
 #include <limits.h>
 #include <stdint.h>
 
+#include "variant.h"     // Sensors built in (FEATURE_GPS_ENABLED, FEATURE_PM_ENABLED)
+
 // C linkage should be maintained
 #ifdef __cplusplus
 extern "C" {
@@ -225,6 +227,11 @@ void platform_usart_cdc_rx_abort(void);
 /// Check whether a reception is on-going
 bool platform_usart_cdc_rx_busy(void);
 
+/*
+ * Sensor receivers; only those selected in variant.h are built
+ * (FEATURE_GPS_ENABLED, FEATURE_PM_ENABLED).
+ */
+
 // GPS-specific USART (SERCOM1) functions
 bool gps_platform_usart_cdc_rx_async(platform_usart_rx_async_desc_t *desc);
 void gps_platform_usart_cdc_rx_abort(void);
@@ -240,6 +247,202 @@ void pm_platform_usart_init(void); // Added for clarity
 void pm_platform_usart_tick_handler(const platform_timespec_t *tick); // Added for clarity
 
 
+//////////////////////////////////////////////////////////////////////////////
+
+/// SD-card SPI clock during card identification
+#define PLATFORM_SPI_SD_HZ_INIT		400000
+
+/// SD-card SPI clock once the card is identified
+#define PLATFORM_SPI_SD_HZ_FAST		12000000
+
+/**
+ * Set the SD-card SPI clock
+ *
+ * @note
+ * Must not be called while a transfer is on-going.
+ *
+ * @p	hz	Desired SCK frequency; rounded down to what the baud generator
+ *		can produce
+ */
+void platform_spi_sd_set_baud(uint32_t hz);
+
+/// Drive the SD-card chip select (active-LO) according to @p sel
+void platform_spi_sd_select(bool sel);
+
+/**
+ * Start a full-duplex transfer with the SD card
+ *
+ * @note
+ * Both buffers must remain valid for the entire time the transfer is
+ * on-going.
+ *
+ * @p	tx	Bytes to send, or @c NULL to send 0xFF throughout
+ * @p	rx	Buffer for the received bytes, or @c NULL to discard them
+ * @p	len	Number of bytes to exchange; must be non-zero
+ *
+ * @return	@c true if the transfer is started, @c false otherwise
+ */
+bool platform_spi_sd_xfer_async(const void *tx, void *rx, uint16_t len);
+
+/// Check whether an SD-card transfer is on-going
+bool platform_spi_sd_busy(void);
+
+
+//////////////////////////////////////////////////////////////////////////////
+
+/**
+ * Run the DSU CRC32 engine over a memory range
+ *
+ * Blocks until the engine is done; it processes about one word every few
+ * cycles.
+ *
+ * @p	addr	Start of the range; must be word-aligned
+ * @p	len	Length of the range in bytes; must be a non-zero multiple of 4
+ * @p	crc	On entry, the running (non-inverted) CRC register value, i.e.
+ *		0xFFFFFFFF to start; on return, the updated value
+ *
+ * @return	@c true on success, @c false if the DSU reported a bus error (in
+ *		which case @p crc is left unchanged)
+ */
+bool platform_dsu_crc32(const void *addr, uint32_t len, uint32_t *crc);
+
+
+//////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Hardware capture of the first start bit of each sensor message (optional)
+ *
+ * With PLATFORM_RXCAP_ENABLED, a falling edge on a capture pin starts a
+ * hardware timer (EIC -> EVSYS -> TC, no CPU involvement); later edges are
+ * ignored until the timer is collected. The capture pins must be wired to the
+ * same lines as the GPS and PM RX pins (see platform/rxcap.c).
+ */
+#ifndef PLATFORM_RXCAP_ENABLED
+#define PLATFORM_RXCAP_ENABLED		0
+#endif
+
+/// Capture sources
+#define PLATFORM_RXCAP_GPS		0
+#define PLATFORM_RXCAP_PM		1
+#define PLATFORM_RXCAP_NR		2
+
+/// Resolution of the timers (4 MHz / 64)
+#define PLATFORM_RXCAP_TICK_US		16
+
+/**
+ * Longest age the 16-bit timers can represent (about 1.05 s, several times
+ * the 133 ms a full GPS buffer takes at 9600 bd); older edges read as
+ * UINT32_MAX
+ */
+#define PLATFORM_RXCAP_AGE_MAX_US	(65535UL * PLATFORM_RXCAP_TICK_US)
+
+/**
+ * Collect the start-bit timer of a source, and re-arm it
+ *
+ * @p	src	Capture source (PLATFORM_RXCAP_*)
+ * @p	age_us	Receives the time since the first falling edge after the
+ *		previous call, in microseconds (in steps of
+ *		PLATFORM_RXCAP_TICK_US); UINT32_MAX if that exceeds
+ *		PLATFORM_RXCAP_AGE_MAX_US
+ *
+ * @return	@c true if an edge was captured, @c false otherwise (or if
+ *		capture is disabled)
+ */
+bool platform_rxcap_take(unsigned int src, uint32_t *age_us);
+
+
+//////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Stack usage
+ *
+ * The PLATFORM_STACK_WATCH_SZ bytes below the top of the main stack are
+ * painted at start-up, and the loop scans them for the deepest word written
+ * (see platform/stack.c). Interrupt handlers record the stack depth they were
+ * entered with.
+ */
+#ifndef PLATFORM_STACK_WATCH_SZ
+#define PLATFORM_STACK_WATCH_SZ		4096
+#endif
+
+/// Interrupt handlers with a depth probe
+#define PLATFORM_STACK_ISR_SYSTICK	0
+#define PLATFORM_STACK_ISR_EIC		1
+#define PLATFORM_STACK_ISR_NR		2
+
+/// Stack usage since start-up
+typedef struct platform_stack_stats_type {
+	/// Bytes watched below the top; 0 if there is no monitor
+	uint32_t watched;
+
+	/// High-water mark: deepest the stack has been, in bytes below the top
+	uint32_t used;
+
+	/// Completed scans of the watched area
+	uint32_t passes;
+
+	/// The whole watched area has been written; the stack may be deeper
+	bool overrun;
+
+	/// Deepest stack on entry to each handler (PLATFORM_STACK_ISR_*)
+	uint32_t isr_depth[PLATFORM_STACK_ISR_NR];
+} platform_stack_stats_t;
+
+/// Report stack usage; the high-water mark trails the stack by one scan
+void platform_stack_get_stats(platform_stack_stats_t *out);
+
+
+//////////////////////////////////////////////////////////////////////////////
+
+/*
+ * Critical sections
+ *
+ * platform_crit_enter() masks interrupts (PRIMASK) and returns the mask state
+ * it found; platform_crit_exit() puts that state back. Sections thus nest:
+ * only the exit of the outermost one unmasks. Use them for state shared with
+ * interrupt handlers that cannot be read or updated in one access.
+ *
+ * With PLATFORM_CRIT_STATS, each outermost section is timed against SysTick
+ * (see platform/crit.c), so the longest time interrupts were held off, i.e.,
+ * the latency a handler may be kept waiting on the loop, can be read back.
+ */
+#ifndef PLATFORM_CRIT_STATS
+#define PLATFORM_CRIT_STATS		0
+#endif
+
+/// Interrupt mask state found by platform_crit_enter()
+typedef uint32_t platform_crit_t;
+
+/**
+ * Enter a critical section
+ *
+ * @return	Mask state to hand to the matching platform_crit_exit()
+ */
+platform_crit_t platform_crit_enter(void);
+
+/**
+ * Leave a critical section
+ *
+ * @p	state	Value returned by the matching platform_crit_enter()
+ */
+void platform_crit_exit(platform_crit_t state);
+
+/// Interrupt-masked time since start-up (outermost sections only)
+typedef struct platform_crit_stats_type {
+	/// Sections timed; 0 without PLATFORM_CRIT_STATS
+	uint32_t nr;
+
+	/// Longest section, in nanoseconds
+	uint32_t max_ns;
+
+	/// All sections together, in nanoseconds
+	uint64_t total_ns;
+} platform_crit_stats_t;
+
+/// Report interrupt-masked time
+void platform_crit_get_stats(platform_crit_stats_t *out);
+
+
 //////////////////////////////////////////////////////////////////////////////
 
 #ifdef __cplusplus
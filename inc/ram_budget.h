@@ -0,0 +1,128 @@
+/**
+ * @file ram_budget.h
+ * @brief Compile-time RAM budget of the modules that hold static state.
+ *
+ * Every module that owns a static buffer or context has an entry in
+ * RAM_BUDGET_TABLE with the bytes it may use, and checks itself against it
+ * with RAM_BUDGET_CHECK(): a module that outgrows its budget fails to build,
+ * instead of quietly eating into the stack. The stack, which on the M23 is
+ * whatever the linker leaves above .bss, has an entry of its own, and the
+ * table as a whole must fit in the part's SRAM.
+ *
+ * Growing a buffer (a larger RX ring, a statistics window) therefore means
+ * raising its module's budget here, where the headroom left is visible; see
+ * ram_budget_report() for the figures of a running build.
+ *
+ * Figures at 32-bit layout, combined build with the SD log, when the table
+ * was drawn up (bytes used / budget):
+ *
+ *   app 804/896, scratch 264/272, uplink 1892/2048, logstore 5272/5632,
+ *   bulkdl 1160/1280, sdcard 112/160, rxlat 64/96, crc32 16/32,
+ *   crit 24/32, metrics 96/128, cdc_usart 528/576, dmac 96/128,
+ *   gps_usart 44/64, pm_usart 44/64, stack 4096: 15504 of 32768 budgeted.
+ *
+ * The uplink has an entry only in builds with UPLINK_ENABLED. The metrics
+ * are defined in the modules that update them (metrics.h), so their entry
+ * is checked when the board reports it rather than at build time, like the
+ * stack's.
+ *
+ * Budgets also hold for host builds of the same sources, where pointers are
+ * 8 bytes and most structures are a little larger.
+ */
+
+#ifndef RAM_BUDGET_H
+#define RAM_BUDGET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "logstore.h"  // LOGSTORE_BACKEND, LOGSTORE_RAM_SZ
+#include "uplink.h"    // UPLINK_ENABLED
+
+#define RAM_BUDGET_SRAM_SZ              32768 // PIC32CM5164LS00048 SRAM
+
+#if LOGSTORE_BACKEND == LOGSTORE_BACKEND_RAM
+#define RAM_BUDGET_LOGSTORE             (LOGSTORE_RAM_SZ + 256)
+#else
+#define RAM_BUDGET_LOGSTORE             5632
+#endif
+
+#if UPLINK_ENABLED
+#define RAM_BUDGET_UPLINK_(X)           X(uplink, 2048, "uplink queue, log block and packet buffers")
+#else
+#define RAM_BUDGET_UPLINK_(X)
+#endif
+
+/**
+ * X(name, budget in bytes, what it holds)
+ */
+#define RAM_BUDGET_TABLE(X) \
+    X(app,       896,                 "prog_state_t: terminal and sensor buffers, parser state") \
+    X(scratch,   272,                 "scratch arena (scratch.h)") \
+    RAM_BUDGET_UPLINK_(X) \
+    X(logstore,  RAM_BUDGET_LOGSTORE, "record log staging (or RAM ring)") \
+    X(bulkdl,    1280,                "bulk download frames") \
+    X(sdcard,    160,                 "SD card driver") \
+    X(rxlat,     96,                  "ingest-latency counters") \
+    X(crc32,     32,                  "CRC32 service: DSU engine state and statistics") \
+    X(crit,      32,                  "interrupt-masked time") \
+    X(metrics,   128,                 "metric storage of all modules (metrics.h)") \
+    X(cdc_usart, 576,                 "terminal USART context and DMA chain") \
+    X(dmac,      128,                 "DMAC base and write-back descriptors") \
+    X(gps_usart, 64,                  "GPS USART context") \
+    X(pm_usart,  64,                  "PM USART context") \
+    X(stack,     4096,                "main stack, interrupts included")
+
+#define RAM_BUDGET_ENUM_(name, budget, desc)    RAM_BUDGET_##name = (budget),
+enum { RAM_BUDGET_TABLE(RAM_BUDGET_ENUM_) };
+
+#define RAM_BUDGET_SUM_(name, budget, desc)     + (budget)
+#define RAM_BUDGET_TOTAL                        (0 RAM_BUDGET_TABLE(RAM_BUDGET_SUM_))
+
+/**
+ * @brief Checks a module's static RAM against its budget, and publishes it.
+ *
+ * Use once, at file scope, after the module's static state.
+ *
+ * @param name Table entry.
+ * @param size Bytes the module holds (sizeof of its state).
+ */
+#define RAM_BUDGET_CHECK(name, size) \
+    _Static_assert((size) <= RAM_BUDGET_##name, "RAM budget exceeded: " #name); \
+    const uint16_t ram_used_##name = (uint16_t)(size)
+
+/**
+ * @brief One entry of the table, as built.
+ */
+typedef struct {
+    const char *name;
+    uint16_t    budget;         // Bytes allowed
+    uint16_t    used;           // Bytes held; 0 if the module is not built
+    bool        built;          // Module linked into this build
+} ram_budget_entry_t;
+
+/**
+ * @brief Number of entries in the table.
+ */
+unsigned int ram_budget_count(void);
+
+/**
+ * @brief Returns entry @p i, or false if there is none.
+ *
+ * The stack has no fixed size; its @c used is the high-water mark measured
+ * so far (platform_stack_get_stats()), 0 where the stack is not watched.
+ * The metrics' @c used is added up over the registry (metrics_ram_used()).
+ */
+bool ram_budget_get(unsigned int i, ram_budget_entry_t *out);
+
+/**
+ * @brief Formats entry @p i (or, at the end of the table, the totals) as one
+ *        terminal line.
+ *
+ * @param i Entry; ram_budget_count() gives the totals line.
+ * @param buf Destination.
+ * @param size Size of @p buf.
+ * @return Length of the line, or 0 past the totals line.
+ */
+int ram_budget_report(unsigned int i, char *buf, unsigned int size);
+
+#endif // RAM_BUDGET_H
@@ -0,0 +1,56 @@
+/**
+ * @file rxlat.h
+ * @brief Per-message ingest latency of the sensor UARTs.
+ *
+ * Ingest latency is the time from the start bit of the first byte of a
+ * message until the main loop hands the completed message to the parsers. The
+ * start is stamped in hardware (platform_rxcap_take(), only in builds with
+ * PLATFORM_RXCAP_ENABLED); the end is the moment rxlat_message() is called, so
+ * the figure covers the time on the wire, the receive idle timeout and any
+ * main-loop delay.
+ */
+
+#ifndef RXLAT_H
+#define RXLAT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "platform.h"
+
+/**
+ * @brief Latency counters of one source since @c rxlat_init().
+ */
+typedef struct {
+    uint32_t msgs;              // Messages handed to the parsers
+    uint32_t stamped;           // Of those, with a hardware start-bit stamp
+    uint32_t over_range;        // Stamps older than PLATFORM_RXCAP_AGE_MAX_US
+    uint32_t min_us;            // Shortest stamped latency (0 if none yet)
+    uint32_t max_us;            // Longest stamped latency
+    uint32_t last_us;           // Latest stamped latency
+    uint64_t sum_us;            // Sum of stamped latencies (for the mean)
+} rxlat_stats_t;
+
+/**
+ * @brief Clears the counters.
+ */
+void rxlat_init(void);
+
+/**
+ * @brief Records that a message from @p src has just been completed.
+ *
+ * Collects (and re-arms) the source's start-bit stamp. Call it once per
+ * completed receive, before the message is parsed.
+ *
+ * @param src Capture source (PLATFORM_RXCAP_*).
+ */
+void rxlat_message(unsigned int src);
+
+/**
+ * @brief Copies the counters of one source.
+ *
+ * @param src Capture source (PLATFORM_RXCAP_*).
+ * @param out Destination for the counters.
+ */
+void rxlat_get_stats(unsigned int src, rxlat_stats_t *out);
+
+#endif // RXLAT_H
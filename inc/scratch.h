@@ -0,0 +1,80 @@
+/**
+ * @file scratch.h
+ * @brief Scratch arena for short-lived buffers of the main loop.
+ *
+ * A buffer that is only needed while one step of prog_loop_one() runs (a
+ * record being framed, a sentence being formatted) comes from here instead of
+ * the stack, so that those buffers share one block of SCRATCH_SZ bytes instead
+ * of each adding to the deepest stack frame.
+ *
+ * Allocation is a bump pointer; lifetimes are scopes:
+ *
+ *     scratch_mark_t mark = scratch_mark();
+ *     char *buf = scratch_alloc(len);
+ *     if (buf != NULL) {
+ *         ... use buf ...
+ *     }
+ *     scratch_release(mark);
+ *
+ * Rules:
+ * - a buffer must not outlive the scratch_release() of its scope, so it must
+ *   never be handed to the DMAC (platform_usart_cdc_tx_async() and friends
+ *   read it after the call returns) or stored in module state;
+ * - scopes nest, and are released in reverse order;
+ * - main loop only: nothing here is safe to call from an interrupt handler;
+ * - scratch_alloc() returns NULL when the arena is full, and the caller skips
+ *   the step it needed the buffer for.
+ *
+ * With SCRATCH_POISON set, released memory is filled with 0xA5, so that a
+ * buffer used after its scope shows up as garbage rather than stale data.
+ */
+
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <stdint.h>
+
+#ifndef SCRATCH_SZ
+#define SCRATCH_SZ                      256  // Bytes; the largest transient of one loop step
+#endif
+
+#ifndef SCRATCH_POISON
+#define SCRATCH_POISON                  0    // 1 to fill released memory with 0xA5
+#endif
+
+/**
+ * @brief Position in the arena, taken at the start of a scope.
+ */
+typedef uint16_t scratch_mark_t;
+
+/**
+ * @brief Returns the current position, to be passed to scratch_release().
+ */
+scratch_mark_t scratch_mark(void);
+
+/**
+ * @brief Takes @p size bytes, word-aligned, from the arena.
+ *
+ * @param size Bytes needed.
+ * @return The buffer, or NULL if fewer than @p size bytes are left.
+ */
+void *scratch_alloc(uint16_t size);
+
+/**
+ * @brief Gives back everything taken since @p mark was returned.
+ *
+ * @param mark Result of the scratch_mark() that opened the scope.
+ */
+void scratch_release(scratch_mark_t mark);
+
+/**
+ * @brief Returns the most bytes that were in use at once since start-up.
+ */
+uint16_t scratch_peak(void);
+
+/**
+ * @brief Returns how many allocations failed for lack of space since start-up.
+ */
+uint32_t scratch_failures(void);
+
+#endif // SCRATCH_H
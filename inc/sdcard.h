@@ -0,0 +1,120 @@
+/**
+ * @file sdcard.h
+ * @brief Non-blocking SD card block driver (SPI mode).
+ *
+ * The driver is a state machine advanced by @c sd_service(): every call
+ * handles the completion of the previous SPI transfer and starts at most one
+ * new one, so no call waits on the card. Data blocks move by DMA (see
+ * @c platform_spi_sd_xfer_async()); only command bytes and busy polls are
+ * short transfers.
+ *
+ * Only what an append-only log needs is supported: card identification
+ * (SDSC, SDHC and SDXC), single-block reads, and multi-block writes preceded
+ * by a pre-erase hint (ACMD23), which lets the card prepare the whole range
+ * before the first block arrives. Blocks are always 512 bytes.
+ */
+
+#ifndef SDCARD_H
+#define SDCARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "platform.h"
+
+#define SD_BLOCK_SZ                     512
+
+// --- Tunables ---
+#define SD_INIT_TIMEOUT_MS              1000 // ACMD41 must report ready within this
+#define SD_READ_TIMEOUT_MS              100  // Data token of a read
+#define SD_WRITE_TIMEOUT_MS             500  // Busy after a block or the stop token
+#define SD_BUSY_POLL_LEN                8    // Bytes clocked per busy poll
+
+/**
+ * @brief Outcome of the last operation.
+ */
+typedef enum {
+    SD_OK = 0,
+    SD_ERR_NO_CARD,     // No (or no usable) card answered identification
+    SD_ERR_TIMEOUT,     // Response, data token or busy timed out
+    SD_ERR_CMD,         // Command rejected (R1 error bits)
+    SD_ERR_DATA         // Data error token, or write data not accepted
+} sd_err_t;
+
+/**
+ * @brief Counters describing card traffic since @c sd_init().
+ */
+typedef struct {
+    uint32_t blocks_read;       // Blocks read successfully
+    uint32_t blocks_written;    // Blocks accepted by the card
+    uint32_t write_cmds;        // Multi-block write commands issued
+    uint32_t errors;            // Operations that ended with an error
+    uint32_t busy_max_us;       // Longest busy period after a block or stop token
+} sd_stats_t;
+
+/**
+ * @brief (Re)starts card identification.
+ *
+ * The card is clocked at PLATFORM_SPI_SD_HZ_INIT until it is identified, then
+ * at PLATFORM_SPI_SD_HZ_FAST. Any operation in progress is abandoned.
+ */
+void sd_init(void);
+
+/**
+ * @brief Advances the driver by at most one SPI transfer.
+ *
+ * Intended to be called once per main-loop iteration.
+ *
+ * @param now Current time.
+ */
+void sd_service(const platform_timespec_t *now);
+
+/**
+ * @brief Checks whether the card is identified and idle.
+ */
+bool sd_ready(void);
+
+/**
+ * @brief Checks whether identification failed; @c sd_init() retries it.
+ */
+bool sd_failed(void);
+
+/**
+ * @brief Returns the outcome of the last identification, read or write.
+ */
+sd_err_t sd_last_error(void);
+
+/**
+ * @brief Returns the card capacity in blocks (0 until identified).
+ */
+uint32_t sd_capacity_blocks(void);
+
+/**
+ * @brief Starts reading one block.
+ *
+ * @param lba Block address.
+ * @param buf Destination of SD_BLOCK_SZ bytes; must stay valid until
+ *            @c sd_ready() returns true again.
+ * @return true if the read was started, false if the card is not ready.
+ */
+bool sd_read_start(uint32_t lba, uint8_t *buf);
+
+/**
+ * @brief Starts writing consecutive blocks with a single multi-block command.
+ *
+ * @param lba Address of the first block.
+ * @param blocks Pointers to the SD_BLOCK_SZ-byte blocks, in order; the array
+ *               and the blocks must stay valid until @c sd_ready() returns
+ *               true again.
+ * @param n Number of blocks; must be non-zero.
+ * @return true if the write was started, false if the card is not ready.
+ */
+bool sd_write_start(uint32_t lba, const uint8_t *const *blocks, uint16_t n);
+
+/**
+ * @brief Copies the current driver counters.
+ *
+ * @param out Destination for the counters.
+ */
+void sd_get_stats(sd_stats_t *out);
+
+#endif // SDCARD_H
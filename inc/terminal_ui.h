@@ -10,6 +10,10 @@
 #include <stdbool.h>
 #include <stddef.h> // For size_t
 #include <stdint.h> // For uint16_t
+#include "rxlat.h"  // For rxlat_stats_t
+#include "platform.h" // For platform_stack_stats_t
+#include "metrics.h"  // For metric_snapshot_t
+#include "variant.h" // FEATURE_GPS_ENABLED, FEATURE_PM_ENABLED
 
 // Forward declaration of prog_state_t to avoid circular dependencies with main.c
 struct prog_state_type;
@@ -21,6 +25,7 @@ struct prog_state_type;
  */
 void ui_handle_banner_transmission(struct prog_state_type *ps);
 
+#if FEATURE_GPS_ENABLED
 /**
  * @brief Handles the transmission of GPS data in a scrolling format.
  *
@@ -37,6 +42,9 @@ bool ui_handle_gps_data_transmission(struct prog_state_type *ps,
                                     const char *lon_str,
                                     char *raw_sentence_buf);
 
+#endif
+
+#if FEATURE_PM_ENABLED
 /**
  * @brief Handles the transmission of PM sensor data in a scrolling format.
  *
@@ -51,6 +59,9 @@ bool ui_handle_pm_data_transmission(struct prog_state_type *ps,
                                    uint16_t pm2_5,
                                    uint16_t pm10);
 
+#endif
+
+#if FEATURE_GPS_ENABLED && FEATURE_PM_ENABLED
 /**
  * @brief Handles combined transmission of GPS and PM data in a single line.
  * 
@@ -70,6 +81,7 @@ bool ui_handle_combined_data_transmission(struct prog_state_type *ps,
                                          uint16_t pm1_0,
                                          uint16_t pm2_5,
                                          uint16_t pm10);
+#endif
 
 /**
  * @brief Handles the transmission of raw data (for debugging).
@@ -85,4 +97,40 @@ bool ui_handle_raw_data_transmission(struct prog_state_type *ps,
                                      const char *raw_data_str,
                                      size_t raw_data_len);
 
+/**
+ * @brief Handles the transmission of the ingest-latency statistics (one line).
+ *
+ * @param ps Pointer to the program state structure.
+ * @param gps Latency counters of the GPS receiver (NULL in a build without it).
+ * @param pm Latency counters of the PM sensor receiver (NULL in a build without it).
+ * @return true if transmission was successfully initiated, false otherwise.
+ */
+bool ui_handle_latency_transmission(struct prog_state_type *ps,
+                                    const rxlat_stats_t *gps,
+                                    const rxlat_stats_t *pm);
+
+/**
+ * @brief Handles the transmission of the stack, scratch and interrupt-masking figures (one line).
+ *
+ * @param ps Pointer to the program state structure.
+ * @param stk Stack usage (platform_stack_get_stats()).
+ * @param scratch_peak Most bytes of the scratch arena in use at once.
+ * @param crit Interrupt-masked time (platform_crit_get_stats()); left out if none was timed.
+ * @return true if transmission was successfully initiated, false otherwise.
+ */
+bool ui_handle_stack_transmission(struct prog_state_type *ps,
+                                  const platform_stack_stats_t *stk,
+                                  uint16_t scratch_peak,
+                                  const platform_crit_stats_t *crit);
+
+/**
+ * @brief Handles the transmission of one metric (one line of the "metrics" command).
+ *
+ * @param ps Pointer to the program state structure.
+ * @param m Metric to list (metrics_snapshot()).
+ * @return true if transmission was successfully initiated, false otherwise.
+ */
+bool ui_handle_metric_transmission(struct prog_state_type *ps,
+                                   const metric_snapshot_t *m);
+
 #endif // TERMINAL_UI_H 
\ No newline at end of file
@@ -0,0 +1,135 @@
+/**
+ * @file uplink.h
+ * @brief Store-and-forward uplink queue for sensor records.
+ *
+ * Records (parsed PM samples, GPS sentences) are read from the record log
+ * (logstore.h), where main.c appends them, and sent to a gateway over the CDC
+ * link in batched, sequence-numbered packets. The uplink keeps a cursor into
+ * the log: records past it are copied into a small RAM queue as room allows,
+ * and leave the queue once the gateway acknowledges the packet carrying
+ * them. Missing ACKs are retried with exponential backoff. During a host
+ * disconnect the backlog stays in the log (on the SD card), and once the
+ * link is back it is drained from there at link rate.
+ *
+ * NOTE: The cursor lives in RAM. After a reset the uplink starts with the
+ *       records appended since, and records not acknowledged before the
+ *       reset are left to a bulk download (bulkdl.h). Records that the log
+ *       evicts before the cursor reaches them (no card: the log is a RAM
+ *       ring) are skipped, and the cursor moves on to the end of the log.
+ *
+ * The uplink is built only with UPLINK_ENABLED (off by default): its frames
+ * travel on the CDC link that also carries the terminal text, and with it
+ * off src/uplink.c compiles to nothing, so its queue takes no RAM.
+ *
+ * Frame layout (all multi-byte fields little-endian):
+ *
+ *   +------+------+------+-------+-------+-------+---------+-------+
+ *   | 0xA5 | 0x5A | type | flags | seq   | len   | payload | crc16 |
+ *   |  1   |  1   |  1   |  1    | 2     | 2     | len     | 2     |
+ *   +------+------+------+-------+-------+-------+---------+-------+
+ *
+ * The CRC (CRC-16/CCITT-FALSE) covers everything from @c type to the end of
+ * the payload. DATA payloads are a sequence of records, each laid out as
+ * @code [rec_type:1][rec_len:1][rec_data:rec_len] @endcode. ACK frames carry no
+ * payload; their @c seq is cumulative (every packet up to and including it
+ * has been received). A gateway may repeat its last ACK while the link is
+ * idle; a device that is backing off then retries immediately.
+ */
+
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "platform.h"
+
+// --- Build Switch ---
+#ifndef UPLINK_ENABLED
+#define UPLINK_ENABLED                  0    // 1 to build the uplink; its binary frames share the CDC terminal
+#endif
+
+// --- Frame Definitions ---
+#define UPLINK_SYNC_1                   0xA5
+#define UPLINK_SYNC_2                   0x5A
+#define UPLINK_HDR_LEN                  8   // Sync, type, flags, seq, len
+#define UPLINK_CRC_LEN                  2
+
+#define UPLINK_TYPE_DATA                0x01 // Device -> gateway, carries records
+#define UPLINK_TYPE_ACK                 0x02 // Gateway -> device, cumulative ACK
+
+#define UPLINK_FLAG_RESYNC              0x01 // First packet of a new sequence space
+
+// --- Record Types ---
+#define UPLINK_REC_PM                   0x01 // uint32 ts_ms + pms_data_t (12 x uint16)
+#define UPLINK_REC_GPS                  0x02 // uint32 ts_ms + raw NMEA sentence text
+
+// --- Tunables ---
+#define UPLINK_QUEUE_SZ                 1024 // Bytes of queued (unacknowledged) records; holds a full window
+#define UPLINK_PKT_PAYLOAD_MAX          240  // Maximum record bytes per packet
+#define UPLINK_REC_DATA_MAX             (UPLINK_PKT_PAYLOAD_MAX - 2)
+#define UPLINK_WINDOW                   4    // Packets in flight before waiting for an ACK
+#define UPLINK_BATCH_TIMEOUT_MS         500  // Flush a partial packet after this long
+#define UPLINK_RTO_MIN_MS               250  // Initial retransmission timeout
+#define UPLINK_RTO_MAX_MS               8000 // Backoff ceiling
+
+/**
+ * @brief Counters describing uplink behaviour since @c uplink_init().
+ */
+typedef struct {
+    uint32_t bytes_read;        // Log bytes copied into the queue
+    uint32_t bytes_skipped;     // Log bytes evicted before the cursor reached them
+    uint32_t packets_sent;      // DATA frames handed to the CDC driver (incl. retries)
+    uint32_t packets_retried;   // DATA frames re-sent after a timeout
+    uint32_t packets_acked;     // Packets released by cumulative ACKs
+    uint32_t acks_bad;          // ACK frames with a bad CRC or unknown sequence
+    uint16_t queue_used;        // Bytes currently held in the queue
+    uint16_t queue_peak;        // High-water mark of queue_used
+    uint16_t rto_ms;            // Current retransmission timeout
+} uplink_stats_t;
+
+/**
+ * @brief Initializes the uplink queue and its ACK parser.
+ *
+ * The cursor is placed at the first record appended to the log since
+ * @c logstore_init(), once the log can be read.
+ */
+void uplink_init(void);
+
+/**
+ * @brief Feeds bytes received from the gateway (CDC RX) into the ACK parser.
+ *
+ * @param buf Received bytes.
+ * @param len Number of bytes in @p buf.
+ */
+void uplink_rx_feed(const char *buf, uint16_t len);
+
+/**
+ * @brief Runs the batching and retransmission state machine.
+ *
+ * Takes new records from the log, then builds and sends at most one packet
+ * per call, and only when the CDC transmitter is idle. Intended to be called
+ * once per main-loop iteration, after @c logstore_service().
+ *
+ * @param now Current time.
+ */
+void uplink_service(const platform_timespec_t *now);
+
+/**
+ * @brief Copies the current uplink counters.
+ *
+ * @param out Destination for the counters.
+ */
+void uplink_get_stats(uplink_stats_t *out);
+
+/**
+ * @brief Computes the CRC-16/CCITT-FALSE used by uplink frames.
+ *
+ * @param crc Running CRC; use 0xFFFF for the first block.
+ * @param buf Data to include.
+ * @param len Number of bytes in @p buf.
+ * @return Updated CRC.
+ */
+uint16_t uplink_crc16(uint16_t crc, const void *buf, size_t len);
+
+#endif // UPLINK_H
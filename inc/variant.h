@@ -0,0 +1,42 @@
+/**
+ * @file variant.h
+ * @brief Compile-time selection of the sensors a unit is built for.
+ *
+ * One tree builds all three units:
+ * - combined (default): GPS receiver on SERCOM1 and PMS5003 on SERCOM0;
+ * - GPS only: -DFEATURE_PM_ENABLED=0 (MPLAB X configuration "gps");
+ * - PM only:  -DFEATURE_GPS_ENABLED=0 (MPLAB X configuration "pms").
+ *
+ * A sensor that is left out takes its driver, its parser, its UI paths and
+ * its receive buffer and parser state in prog_state_t with it: the files
+ * compile to nothing, and platform_init() does not bring up its SERCOM.
+ * This replaces the separate eee192-gps/ and eee192-pms/ projects.
+ *
+ * What each sensor costs (flash: XC32 at -O0, from the last combined map;
+ * RAM: prog_state_t at 32-bit layout):
+ *
+ *                  flash                               RAM
+ *   GPS    nmea_parse 1590, gps_usart 972, and         144 in prog_state_t,
+ *          4333 of libc behind atof()                  44 driver
+ *   PM     pms_parser 1816, pm_usart 944               304 in prog_state_t,
+ *                                                      44 driver
+ *
+ * prog_state_t is 804 bytes combined, 660 for GPS only and 500 for PM only.
+ */
+
+#ifndef VARIANT_H
+#define VARIANT_H
+
+#ifndef FEATURE_GPS_ENABLED
+#define FEATURE_GPS_ENABLED     1 // GPS receiver (SERCOM1), NMEA parser, GPGLL display and records
+#endif
+
+#ifndef FEATURE_PM_ENABLED
+#define FEATURE_PM_ENABLED      1 // PMS5003 (SERCOM0), frame parser, PM display and records
+#endif
+
+#if !FEATURE_GPS_ENABLED && !FEATURE_PM_ENABLED
+#error "variant.h: at least one of FEATURE_GPS_ENABLED and FEATURE_PM_ENABLED must be set"
+#endif
+
+#endif // VARIANT_H
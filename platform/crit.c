@@ -0,0 +1,93 @@
+/**
+ * @file platform/crit.c
+ * @brief Platform-support routines, critical sections
+ */
+
+/*
+ * A critical section masks every configurable interrupt through PRIMASK.
+ * platform_crit_enter() hands back the PRIMASK it found, so an inner section
+ * (or one entered from a handler, or with interrupts already masked) leaves
+ * them masked on exit, and only the outermost exit unmasks.
+ *
+ * With PLATFORM_CRIT_STATS, the outermost sections are timed with the SysTick
+ * counter, which keeps counting while its interrupt is held off. A section
+ * longer than one tick period wraps the counter; the first wrap shows as a
+ * pending SysTick and is accounted for, further ones are not. Times are thus
+ * exact up to one period (PLATFORM_TICK_PERIOD_US) and lower bounds beyond.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+
+#include "../inc/platform.h"
+#include "../inc/ram_budget.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// SysTick counts per microsecond (see platform/systick.c)
+#define CRIT_SYSTICK_PER_US	12
+
+static struct {
+	uint32_t start;		///< SysTick VAL at the outermost enter
+	bool     st_pending;	///< SysTick already pending at that enter
+	uint32_t nr;		///< Sections timed
+	uint32_t max;		///< Longest section, in SysTick counts
+	uint64_t total;		///< All sections, in SysTick counts
+} crit;
+
+RAM_BUDGET_CHECK(crit, sizeof(crit));
+
+// Mask interrupts
+platform_crit_t platform_crit_enter(void)
+{
+	platform_crit_t state = __get_PRIMASK();
+
+	__disable_irq();
+#if PLATFORM_CRIT_STATS
+	if (state == 0) {
+		crit.start      = SysTick->VAL;
+		crit.st_pending = (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0;
+	}
+#endif
+	return state;
+}
+
+// Restore the mask state found by platform_crit_enter()
+void platform_crit_exit(platform_crit_t state)
+{
+#if PLATFORM_CRIT_STATS
+	if (state == 0) {
+		uint32_t now = SysTick->VAL;
+		uint32_t n;
+
+		// SysTick counts down, from LOAD to 0
+		if (now <= crit.start) {
+			n = crit.start - now;
+			if (!crit.st_pending &&
+			    (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0)
+				n += SysTick->LOAD + 1;	// Wrapped all the way round
+		} else {
+			n = crit.start + (SysTick->LOAD + 1) - now;
+		}
+		++crit.nr;
+		crit.total += n;
+		if (n > crit.max)
+			crit.max = n;
+	}
+#endif
+	__set_PRIMASK(state);
+	return;
+}
+
+// Report interrupt-masked time
+void platform_crit_get_stats(platform_crit_stats_t *out)
+{
+	platform_crit_t c = platform_crit_enter();
+
+	out->nr       = crit.nr;
+	out->max_ns   = (uint32_t)(((uint64_t)crit.max * 1000u) / CRIT_SYSTICK_PER_US);
+	out->total_ns = (crit.total * 1000u) / CRIT_SYSTICK_PER_US;
+	platform_crit_exit(c);
+	return;
+}
@@ -0,0 +1,95 @@
+/**
+ * @file platform/dmac.c
+ * @brief Platform-support routines, DMAC component
+ */
+
+/*
+ * The DMAC is shared by the peripheral drivers in this directory; channel
+ * numbers and trigger sources are assigned in dmac.h. Channels are only ever
+ * touched from the main loop, so the CHID-indexed channel registers need no
+ * locking.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../inc/platform.h"
+#include "../inc/ram_budget.h"
+#include "dmac.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// First descriptor of each channel, and the channels' write-back area
+platform_dmac_desc_t platform_dmac_base[PLATFORM_DMAC_NR_CH];
+static platform_dmac_desc_t dmac_wrb[PLATFORM_DMAC_NR_CH];
+
+RAM_BUDGET_CHECK(dmac, sizeof(platform_dmac_base) + sizeof(dmac_wrb));
+
+// Configure the DMAC
+void platform_dmac_init(void)
+{
+	/*
+	 * Enable the AHB/APB clocks for this peripheral
+	 * 
+	 * NOTE: The chip resets with them enabled; hence, commented-out.
+	 */
+	// MCLK_REGS->MCLK_AHBMASK |= (1 << ???);
+	
+	// Software reset, which requires the controller to be disabled first
+	DMAC_SEC_REGS->DMAC_CTRL &= ~(0x1 << 1);
+	while ((DMAC_SEC_REGS->DMAC_CTRL & (0x1 << 1)) != 0) asm("nop");
+	DMAC_SEC_REGS->DMAC_CTRL = (0x1 << 0);
+	while ((DMAC_SEC_REGS->DMAC_CTRL & (0x1 << 0)) != 0) asm("nop");
+	
+	memset(platform_dmac_base, 0, sizeof(platform_dmac_base));
+	memset(dmac_wrb, 0, sizeof(dmac_wrb));
+	DMAC_SEC_REGS->DMAC_BASEADDR = (uint32_t)platform_dmac_base;
+	DMAC_SEC_REGS->DMAC_WRBADDR  = (uint32_t)dmac_wrb;
+	
+	// Enable the controller, with all four priority levels
+	DMAC_SEC_REGS->DMAC_CTRL = (0xF << 8) | (0x1 << 1);
+	return;
+}
+
+// Configure a channel
+void platform_dmac_ch_setup(unsigned int ch, unsigned int trig)
+{
+	/*
+	 * - Reset the channel first
+	 * - One beat per trigger (TRIGACT = BEAT), as all triggers in use are
+	 *   SERCOM DRE/RXC
+	 * - Priority level 0
+	 */
+	DMAC_SEC_REGS->DMAC_CHID = ch;
+	DMAC_SEC_REGS->DMAC_CHCTRLA = (0x1 << 0);
+	while ((DMAC_SEC_REGS->DMAC_CHCTRLA & (0x1 << 0)) != 0) asm("nop");
+	DMAC_SEC_REGS->DMAC_CHCTRLB = (0x2 << 22) | ((trig & 0x3F) << 8) | (0x0 << 5);
+	return;
+}
+
+void platform_dmac_ch_enable(unsigned int ch)
+{
+	DMAC_SEC_REGS->DMAC_CHID = ch;
+	DMAC_SEC_REGS->DMAC_CHCTRLA |= (0x1 << 1);
+	return;
+}
+
+bool platform_dmac_ch_busy(unsigned int ch)
+{
+	/*
+	 * The DMAC clears CHCTRLA.ENABLE on its own once the last descriptor
+	 * of the chain has been processed.
+	 */
+	DMAC_SEC_REGS->DMAC_CHID = ch;
+	return (DMAC_SEC_REGS->DMAC_CHCTRLA & (0x1 << 1)) != 0;
+}
+
+void platform_dmac_ch_abort(unsigned int ch)
+{
+	DMAC_SEC_REGS->DMAC_CHID = ch;
+	DMAC_SEC_REGS->DMAC_CHCTRLA &= ~(0x1 << 1);
+	while ((DMAC_SEC_REGS->DMAC_CHCTRLA & (0x1 << 1)) != 0) asm("nop");
+	return;
+}
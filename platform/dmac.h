@@ -0,0 +1,74 @@
+/**
+ * @file platform/dmac.h
+ * @brief Platform-internal declarations for the DMAC component
+ *
+ * NOTE: This header is only meant for platform/*.c; application code uses
+ *       the peripheral-level APIs in platform.h instead.
+ */
+
+#if !defined(PLATFORM_DMAC_H_)
+#define PLATFORM_DMAC_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/// DMAC channel assignments
+#define PLATFORM_DMAC_CH_CDC_TX		0	///< SERCOM3 TX (CDC)
+#define PLATFORM_DMAC_CH_SD_RX		1	///< SERCOM2 RX (SD card SPI)
+#define PLATFORM_DMAC_CH_SD_TX		2	///< SERCOM2 TX (SD card SPI)
+
+/// Number of DMAC channels in use (and thus with base/write-back entries)
+#define PLATFORM_DMAC_NR_CH		3
+
+/// DMAC trigger sources (DMAC.CHCTRLB.TRIGSRC)
+#define PLATFORM_DMAC_TRIG_SERCOM2_RX	8
+#define PLATFORM_DMAC_TRIG_SERCOM2_TX	9
+#define PLATFORM_DMAC_TRIG_SERCOM3_TX	11
+
+/// BTCTRL bits of a transfer descriptor
+#define PLATFORM_DMAC_BTCTRL_VALID	(0x1 << 0)
+#define PLATFORM_DMAC_BTCTRL_SRCINC	(0x1 << 10)
+#define PLATFORM_DMAC_BTCTRL_DSTINC	(0x1 << 11)
+
+/**
+ * DMAC transfer descriptor, as laid out in SRAM
+ * 
+ * NOTE: The DMAC requires descriptors (and the base/write-back sections) to
+ *       be 128-bit aligned.
+ * 
+ * NOTE: When an address increments, the descriptor holds the address just
+ *       past the end of the block, not its start.
+ */
+typedef struct platform_dmac_desc_type {
+	volatile uint16_t btctrl;
+	volatile uint16_t btcnt;
+	volatile uint32_t srcaddr;
+	volatile uint32_t dstaddr;
+	volatile uint32_t descaddr;
+} __attribute__((aligned(16))) platform_dmac_desc_t;
+
+/// First descriptor of each channel; filled in before enabling a channel
+extern platform_dmac_desc_t platform_dmac_base[PLATFORM_DMAC_NR_CH];
+
+/// Reset and enable the DMAC; must precede any channel setup
+void platform_dmac_init(void);
+
+/**
+ * Reset a channel and bind it to a peripheral trigger
+ * 
+ * @param[in]	ch	Channel (PLATFORM_DMAC_CH_*)
+ * @param[in]	trig	Trigger source (PLATFORM_DMAC_TRIG_*); one beat is
+ * 			moved per trigger
+ */
+void platform_dmac_ch_setup(unsigned int ch, unsigned int trig);
+
+/// Start a channel, using the descriptor chain at @c platform_dmac_base[ch]
+void platform_dmac_ch_enable(unsigned int ch);
+
+/// Check whether a channel has yet to finish its descriptor chain
+bool platform_dmac_ch_busy(unsigned int ch);
+
+/// Stop a channel, discarding the rest of its descriptor chain
+void platform_dmac_ch_abort(unsigned int ch);
+
+#endif	// !defined(PLATFORM_DMAC_H_)
@@ -0,0 +1,76 @@
+/**
+ * @file platform/dsu.c
+ * @brief Platform-support routines, DSU component (CRC32 engine)
+ */
+
+/*
+ * The Device Service Unit can compute the IEEE 802.3 CRC32 (reflected
+ * polynomial 0xEDB88320) of any word-aligned range the bus matrix reaches,
+ * flash and SRAM alike. DATA holds the CRC register itself: it is seeded with
+ * 0xFFFFFFFF (or the register value left by a previous range, to chain
+ * ranges), and the result must be complemented to give the standard CRC32.
+ *
+ * The DSU is write-protected by the PAC out of reset; that protection is
+ * lifted once, in platform_dsu_init().
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+
+#include "../inc/platform.h"
+
+// Functions "exported" by this file
+void platform_dsu_init(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// PAC peripheral identifier of the DSU (bridge B, index 1)
+#define DSU_PAC_PERID	(32 + 1)
+
+// Configure the DSU
+void platform_dsu_init(void)
+{
+	/*
+	 * Enable the AHB/APB clocks for this peripheral
+	 *
+	 * NOTE: The chip resets with them enabled; hence, commented-out.
+	 */
+	// MCLK_REGS->MCLK_APBBMASK |= (1 << 1);
+
+	// Lift the PAC write protection (KEY = CLR)
+	PAC_REGS->PAC_WRCTRL = (0x1 << 16) | DSU_PAC_PERID;
+
+	// Clear any stale status
+	DSU_REGS->DSU_STATUSA = (0x1 << 2) | (0x1 << 0);
+	return;
+}
+
+// Run the CRC32 engine over a range
+bool platform_dsu_crc32(const void *addr, uint32_t len, uint32_t *crc)
+{
+	uint8_t st;
+
+	/*
+	 * - ADDR[1:0] is AMOD, which must be zero (plain range)
+	 * - LENGTH[1:0] is reserved; the length is in bytes
+	 */
+	DSU_REGS->DSU_ADDR   = (uint32_t)addr & ~0x3UL;
+	DSU_REGS->DSU_LENGTH = len & ~0x3UL;
+	DSU_REGS->DSU_DATA   = *crc;
+	DSU_REGS->DSU_STATUSA = (0x1 << 2) | (0x1 << 0);
+	DSU_REGS->DSU_CTRL   = (0x1 << 2);	// CRC
+
+	do {
+		st = DSU_REGS->DSU_STATUSA;
+	} while ((st & (0x1 << 0)) == 0);	// DONE
+
+	if ((st & (0x1 << 2)) != 0) {
+		// BERR
+		DSU_REGS->DSU_STATUSA = (0x1 << 2) | (0x1 << 0);
+		return false;
+	}
+	*crc = DSU_REGS->DSU_DATA;
+	DSU_REGS->DSU_STATUSA = (0x1 << 0);
+	return true;
+}
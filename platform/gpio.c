@@ -29,9 +29,17 @@
 #include <string.h>
 
 #include "../inc/platform.h" // Corrected include path
+#include "../inc/metrics.h"
+#include "stack.h"
 
 // Initializers defined in other platform/*.c files
 extern void platform_systick_init(void);
+extern void platform_dmac_init(void);
+extern void platform_dsu_init(void);
+
+// Stack painting and high-water-mark scan
+extern void platform_stack_init(void);
+extern void platform_stack_scan(void);
 
 // USART for CDC/Terminal (SERCOM3)
 extern void platform_usart_init(void);
@@ -45,6 +53,12 @@ extern void pm_platform_usart_tick_handler(const platform_timespec_t *tick);
 extern void gps_platform_usart_init(void);
 extern void gps_platform_usart_tick_handler(const platform_timespec_t *tick);
 
+// SPI for the SD card (SERCOM2)
+extern void platform_spi_sd_init(void);
+
+// Start-bit capture for the sensor UARTs (TC0/TC1)
+extern void platform_rxcap_init(void);
+
 /////////////////////////////////////////////////////////////////////////////
 
 // Enable higher frequencies for higher performance
@@ -260,8 +274,12 @@ void platform_gpo_modify(uint16_t set, uint16_t clr)
  * (IRQ) handler is thus named EIC_EXTINT_2_Handler.
  */
 static volatile uint16_t pb_press_mask = 0;
+METRIC_COUNTER(pb_edges);	// Push-button presses and releases
 void __attribute__((used, interrupt())) EIC_EXTINT_2_Handler(void)
 {
+	platform_stack_probe(PLATFORM_STACK_ISR_EIC);
+	metric_inc(&pb_edges);
+	
 	pb_press_mask &= ~PLATFORM_PB_ONBOARD_MASK;
 	if ((EIC_SEC_REGS->EIC_PINSTATE & (1 << 2)) == 0)
 		pb_press_mask |= PLATFORM_PB_ONBOARD_PRESS;
@@ -308,9 +326,12 @@ static void PB_init(void)
 // Get the mask of currently-pressed buttons
 uint16_t platform_pb_get_event(void)
 {
+	// An edge between the read and the clear would otherwise be lost
+	platform_crit_t c = platform_crit_enter();
 	uint16_t cache = pb_press_mask;
 	
 	pb_press_mask = 0;
+	platform_crit_exit(c);
 	return cache;
 }
 
@@ -342,19 +363,30 @@ static void NVIC_init(void)
 // Initialize the platform
 void platform_init(void)
 {
+	// Paint the stack before anything else can use it
+	platform_stack_init();
+	
 	// Raise the power level
 	raise_perf_level();
 	
 	// Early initialization
 	EVSYS_init();
 	EIC_init_early();
+	platform_dmac_init();
+	platform_dsu_init();
 	
 	// Regular initialization
 	PB_init();
 	GPO_init();
 	platform_usart_init(); // For CDC/SERCOM3
+#if FEATURE_PM_ENABLED
     pm_platform_usart_init();    // For PM/SERCOM0
+#endif
+#if FEATURE_GPS_ENABLED
     gps_platform_usart_init();   // For GPS/SERCOM1
+#endif
+	platform_spi_sd_init();      // For the SD card/SERCOM2
+	platform_rxcap_init();       // Needs the EIC still disabled
 	
 	// Late initialization
 	EIC_init_late();
@@ -376,6 +408,13 @@ void platform_do_loop_one(void)
 	platform_tick_hrcount(&tick);
     
 	platform_usart_tick_handler(&tick);    // CDC/SERCOM3
+#if FEATURE_PM_ENABLED
 	pm_platform_usart_tick_handler(&tick); // PM/SERCOM0
+#endif
+#if FEATURE_GPS_ENABLED
     gps_platform_usart_tick_handler(&tick);  // GPS/SERCOM1
+#endif
+	
+	// A few words of the stack high-water-mark scan
+	platform_stack_scan();
 }
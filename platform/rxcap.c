@@ -0,0 +1,222 @@
+/**
+ * @file platform/rxcap.c
+ * @brief Platform-support routines, start-bit capture for the sensor UARTs
+ */
+
+/*
+ * HW configuration (only with PLATFORM_RXCAP_ENABLED):
+ * -- PA06: GPS capture input (EXTINT[6]); jumper to the GPS RX line
+ * -- PA07: PM capture input  (EXTINT[7]); jumper to the PM RX line
+ *
+ * A pin muxed to a SERCOM cannot also feed the EIC, so each RX line is
+ * sampled a second time on a spare pin.
+ *
+ * Signal path, per source:
+ *
+ *   EXTINTn (falling edge) -> EVSYS channel (asynchronous path)
+ *     -> TCx event input, action START
+ *
+ * TCx counts at 62.5 kHz (GCLK_GEN2, 4 MHz, /64), i.e., in steps of
+ * PLATFORM_RXCAP_TICK_US (16 us), in one-shot mode, so the first start bit
+ * after the timer was collected starts it, further start bits have no effect,
+ * and the counter stops (with OVF set) after PLATFORM_RXCAP_AGE_MAX_US
+ * (about 1.05 s). That covers a 128-byte GPS buffer filling up at 9600 bd
+ * (about 133 ms) several times over; 16 us is well below one character time
+ * at any of the sensor baud rates. Collecting the timer reads it, stops it
+ * and clears it, which re-arms the capture.
+ *
+ * Only the sources of the sensors built in (FEATURE_*_ENABLED) are
+ * configured; the pin, EXTINT line, EVSYS channel and TC of the other are
+ * left untouched.
+ *
+ * No interrupts are used; the timestamp is taken entirely in hardware.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "../inc/platform.h"
+
+// Functions "exported" by this file
+void platform_rxcap_init(void);
+
+#if PLATFORM_RXCAP_ENABLED
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// GCLK peripheral channel shared by TC0 and TC1
+#define RXCAP_GCLK_TC0_TC1	23
+
+/// EVSYS generators for EXTINT[6] and EXTINT[7]
+#define RXCAP_EVGEN_EXTINT6	23
+#define RXCAP_EVGEN_EXTINT7	24
+
+/// EVSYS users for the TC0 and TC1 event inputs
+#define RXCAP_EVU_TC0		12
+#define RXCAP_EVU_TC1		13
+
+/// EVSYS channels used by this file (the button does not use any)
+#define RXCAP_EVSYS_CH_GPS	0
+#define RXCAP_EVSYS_CH_PM	1
+
+/// Timer of each source; NULL for a sensor that is not built in
+static tc_count16_registers_t * const rxcap_tc[PLATFORM_RXCAP_NR] = {
+#if FEATURE_GPS_ENABLED
+	[PLATFORM_RXCAP_GPS] = &(TC0_REGS->COUNT16),
+#endif
+#if FEATURE_PM_ENABLED
+	[PLATFORM_RXCAP_PM]  = &(TC1_REGS->COUNT16)
+#endif
+};
+
+// Configure one timer
+static void rxcap_tc_init(tc_count16_registers_t *tc)
+{
+	// Software reset
+	tc->TC_CTRLA = (0x1 << 0);
+	while ((tc->TC_SYNCBUSY & (0x1 << 0)) != 0) asm("nop");
+
+	/*
+	 * - COUNT16, prescaler /64 (62.5 kHz), PRESCSYNC = GCLK
+	 * - One-shot: stop at overflow instead of wrapping
+	 * - Event input enabled, action START
+	 */
+	tc->TC_CTRLA    = (0x5 << 8) | (0x0 << 4) | (0x0 << 2);
+	tc->TC_CTRLBSET = (0x1 << 2);
+	while ((tc->TC_SYNCBUSY & (0x1 << 2)) != 0) asm("nop");
+	tc->TC_EVCTRL   = (0x1 << 5) | (0x3 << 0);
+	tc->TC_INTFLAG  = 0xFF;
+
+	/*
+	 * Enabling a TC whose event action is START leaves it stopped until the
+	 * first event.
+	 */
+	tc->TC_CTRLA |= (0x1 << 1);
+	while ((tc->TC_SYNCBUSY & (0x1 << 1)) != 0) asm("nop");
+	return;
+}
+
+// Configure the capture path
+void platform_rxcap_init(void)
+{
+	/*
+	 * Enable the APB clocks for TC0 and TC1
+	 *
+	 * NOTE: The chip resets with them enabled; hence, commented-out.
+	 */
+	// MCLK_REGS->MCLK_APBCMASK |= (1 << ???);
+
+	// GCLK_GEN2 (4 MHz) for both timers
+	GCLK_REGS->GCLK_PCHCTRL[RXCAP_GCLK_TC0_TC1] = 0x00000042;
+	while ((GCLK_REGS->GCLK_PCHCTRL[RXCAP_GCLK_TC0_TC1] & 0x00000040) == 0) asm("nop");
+
+	/*
+	 * PA06 and PA07: inputs, Peripheral Function A (EIC)
+	 *
+	 * NOTE: PORT I/O configuration is never separable from the in-circuit
+	 *       wiring. Refer to the top of this source file for each PORT
+	 *       pin assignments.
+	 */
+	/*
+	 * EXTINT[6] and EXTINT[7]: falling edge, no filter, no debouncing, with
+	 * event output. No interrupt is enabled.
+	 *
+	 * NOTE: EIC has been reset and pre-configured by the time this
+	 *       function is called, and is enabled afterwards.
+	 *
+	 * EVSYS: asynchronous path (no edge selection, no clock needed), and
+	 * the users are connected to channel n by writing n + 1.
+	 */
+#if FEATURE_GPS_ENABLED
+	PORT_SEC_REGS->GROUP[0].PORT_DIRCLR = (1 << 6);
+	PORT_SEC_REGS->GROUP[0].PORT_PINCFG[6] = 0x03;
+	PORT_SEC_REGS->GROUP[0].PORT_PMUX[(6 >> 1)] &= ~(0x0F);
+
+	EIC_SEC_REGS->EIC_CONFIG0 &= ~((uint32_t)(0xF) << 24);
+	EIC_SEC_REGS->EIC_CONFIG0 |=  ((uint32_t)(0x2) << 24);
+	EIC_SEC_REGS->EIC_EVCTRL  |= (1 << 6);
+
+	EVSYS_SEC_REGS->CHANNEL[RXCAP_EVSYS_CH_GPS].EVSYS_CHANNEL =
+		(0x2 << 8) | RXCAP_EVGEN_EXTINT6;
+	EVSYS_SEC_REGS->EVSYS_USER[RXCAP_EVU_TC0] = RXCAP_EVSYS_CH_GPS + 1;
+
+	rxcap_tc_init(rxcap_tc[PLATFORM_RXCAP_GPS]);
+#endif
+
+#if FEATURE_PM_ENABLED
+	PORT_SEC_REGS->GROUP[0].PORT_DIRCLR = (1 << 7);
+	PORT_SEC_REGS->GROUP[0].PORT_PINCFG[7] = 0x03;
+	PORT_SEC_REGS->GROUP[0].PORT_PMUX[(7 >> 1)] &= ~(0xF0);
+
+	EIC_SEC_REGS->EIC_CONFIG0 &= ~((uint32_t)(0xF) << 28);
+	EIC_SEC_REGS->EIC_CONFIG0 |=  ((uint32_t)(0x2) << 28);
+	EIC_SEC_REGS->EIC_EVCTRL  |= (1 << 7);
+
+	EVSYS_SEC_REGS->CHANNEL[RXCAP_EVSYS_CH_PM].EVSYS_CHANNEL =
+		(0x2 << 8) | RXCAP_EVGEN_EXTINT7;
+	EVSYS_SEC_REGS->EVSYS_USER[RXCAP_EVU_TC1] = RXCAP_EVSYS_CH_PM + 1;
+
+	rxcap_tc_init(rxcap_tc[PLATFORM_RXCAP_PM]);
+#endif
+	return;
+}
+
+// Read COUNT, which needs a READSYNC command first
+static uint16_t rxcap_tc_read(tc_count16_registers_t *tc)
+{
+	tc->TC_CTRLBSET = (0x4 << 5);
+	while ((tc->TC_SYNCBUSY & (0x1 << 2)) != 0) asm("nop");
+	while ((tc->TC_CTRLBSET & (0x7 << 5)) != 0) asm("nop");
+	return tc->TC_COUNT;
+}
+
+// Collect a timer
+bool platform_rxcap_take(unsigned int src, uint32_t *age_us)
+{
+	tc_count16_registers_t *tc;
+	uint16_t cnt;
+
+	if (src >= PLATFORM_RXCAP_NR || rxcap_tc[src] == NULL)
+		return false;
+	tc = rxcap_tc[src];
+
+	/*
+	 * A timer that has neither counted nor overflowed has not seen an
+	 * edge; leave it armed.
+	 */
+	if (rxcap_tc_read(tc) == 0 && (tc->TC_INTFLAG & (0x1 << 0)) == 0)
+		return false;
+
+	// Stop, take the final count, then clear for the next message
+	tc->TC_CTRLBSET = (0x2 << 5);
+	while ((tc->TC_SYNCBUSY & (0x1 << 2)) != 0) asm("nop");
+	cnt = rxcap_tc_read(tc);
+	if ((tc->TC_INTFLAG & (0x1 << 0)) != 0)
+		*age_us = UINT32_MAX;
+	else
+		*age_us = (uint32_t)cnt * PLATFORM_RXCAP_TICK_US;
+
+	tc->TC_COUNT = 0;
+	while ((tc->TC_SYNCBUSY & (0x1 << 4)) != 0) asm("nop");
+	tc->TC_INTFLAG = (0x1 << 0);
+	return true;
+}
+
+#else	// PLATFORM_RXCAP_ENABLED
+
+// Capture is compiled out; leave the pins and timers alone
+void platform_rxcap_init(void)
+{
+	return;
+}
+
+bool platform_rxcap_take(unsigned int src, uint32_t *age_us)
+{
+	(void)src;
+	(void)age_us;
+	return false;
+}
+
+#endif	// PLATFORM_RXCAP_ENABLED
@@ -0,0 +1,211 @@
+/**
+ * @file platform/spi.c
+ * @brief Platform-support routines, SPI component (SD card)
+ */
+
+/*
+ * HW configuration (SD-card breakout on the Curiosity Nano headers):
+ * -- PA08: MOSI (SERCOM2, PAD[0])
+ * -- PA09: SCK  (SERCOM2, PAD[1])
+ * -- PA10: CS   (GPIO, active-LO)
+ * -- PA11: MISO (SERCOM2, PAD[3])
+ *
+ * Each transfer uses two DMAC channels: one feeding DATA on the DRE trigger,
+ * and one draining it on the RXC trigger. The receive channel is started
+ * first, so that no received byte can be missed; since the last byte is
+ * received after it is sent, the receive channel alone tells when a transfer
+ * is complete.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "../inc/platform.h"
+#include "dmac.h"
+
+// Functions "exported" by this file
+void platform_spi_sd_init(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// GCLK frequency fed to SERCOM2
+#define SPI_SD_GCLK_HZ	(24000000UL)
+
+/// Source of the 0xFF filler sent when no transmit buffer is given
+static const uint8_t spi_fill = 0xFF;
+
+/// Sink for bytes received when no receive buffer is given
+static uint8_t spi_sink;
+
+// Configure SPI
+void platform_spi_sd_init(void)
+{
+	/*
+	 * For ease of typing, #define a macro corresponding to the SERCOM
+	 * peripheral and its SPI host view.
+	 *
+	 * To avoid namespace pollution, this macro is #undef'd at the end of
+	 * this function.
+	 */
+#define SPI_REGS (&(SERCOM2_REGS->SPIM))
+
+	/*
+	 * Enable the APB clock for this peripheral
+	 *
+	 * NOTE: The chip resets with it enabled; hence, commented-out.
+	 */
+	// MCLK_REGS->MCLK_APB???MASK |= (1 << ???);
+
+	/*
+	 * Enable the GCLK generator for this peripheral
+	 *
+	 * NOTE: GEN0 (24 MHz) is used, as the SD card may be clocked at up
+	 *       to 25 MHz once identified.
+	 */
+	GCLK_REGS->GCLK_PCHCTRL[19] = 0x00000040;
+	while ((GCLK_REGS->GCLK_PCHCTRL[19] & 0x00000040) == 0) asm("nop");
+
+	// Both directions are DMA-driven
+	platform_dmac_ch_setup(PLATFORM_DMAC_CH_SD_RX, PLATFORM_DMAC_TRIG_SERCOM2_RX);
+	platform_dmac_ch_setup(PLATFORM_DMAC_CH_SD_TX, PLATFORM_DMAC_TRIG_SERCOM2_TX);
+
+	// Software reset, then select SPI host mode
+	SPI_REGS->SERCOM_CTRLA = (0x1 << 0);
+	while ((SPI_REGS->SERCOM_SYNCBUSY & (0x1 << 0)) != 0) asm("nop");
+	SPI_REGS->SERCOM_CTRLA = (0x3 << 2);
+
+	/*
+	 * Select settings compatible with SD cards in SPI mode:
+	 *
+	 * - SPI mode 0 (CPOL = 0, CPHA = 0)
+	 * - MSB first
+	 * - 8-bit characters
+	 * - Use PAD[0] for MOSI and PAD[1] for SCK (DOPO = 0)
+	 * - Use PAD[3] for MISO (DIPO = 3)
+	 * - Chip select is driven by software, not by the SERCOM
+	 */
+	SPI_REGS->SERCOM_CTRLA |= (0x0 << 29) | (0x0 << 28) | (0x0 << 30) |
+				  (0x0 << 16) | (0x3 << 20);
+	SPI_REGS->SERCOM_CTRLB = (0x0 << 0) | (0x0 << 13);
+
+	// Cards must be identified at 400 kHz or less
+	platform_spi_sd_set_baud(PLATFORM_SPI_SD_HZ_INIT);
+
+	// Enable the receiver
+	SPI_REGS->SERCOM_CTRLB |= (0x1 << 17);
+	while ((SPI_REGS->SERCOM_SYNCBUSY & (0x1 << 2)) != 0) asm("nop");
+
+	/*
+	 * Configure the physical pins.
+	 *
+	 * - PA08, PA09, PA11: peripheral function D (SERCOM-ALT); MISO also
+	 *   needs its input buffer
+	 * - PA10: GPIO output, idling HI (card deselected)
+	 */
+	PORT_SEC_REGS->GROUP[0].PORT_OUTSET = (1 << 10);
+	PORT_SEC_REGS->GROUP[0].PORT_DIRSET = (1 << 10);
+	PORT_SEC_REGS->GROUP[0].PORT_PINCFG[10] = 0x00;
+
+	PORT_SEC_REGS->GROUP[0].PORT_PINCFG[8]  = 0x01;
+	PORT_SEC_REGS->GROUP[0].PORT_PINCFG[9]  = 0x01;
+	PORT_SEC_REGS->GROUP[0].PORT_PINCFG[11] = 0x03;
+	PORT_SEC_REGS->GROUP[0].PORT_PMUX[4] = 0x33;
+	PORT_SEC_REGS->GROUP[0].PORT_PMUX[5] = (PORT_SEC_REGS->GROUP[0].PORT_PMUX[5] & 0x0F) | 0x30;
+
+	// Last: enable the peripheral
+	SPI_REGS->SERCOM_CTRLA |= (0x1 << 1);
+	while ((SPI_REGS->SERCOM_SYNCBUSY & (0x1 << 1)) != 0) asm("nop");
+	return;
+
+#undef SPI_REGS
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void platform_spi_sd_set_baud(uint32_t hz)
+{
+	uint32_t baud;
+
+	/*
+	 * f_{SCK} = f_{GCLK} / (2 * (BAUD + 1)); round BAUD up so that the
+	 * card is never clocked faster than requested.
+	 */
+	if (hz == 0)
+		hz = 1;
+	baud = (SPI_SD_GCLK_HZ + (2 * hz) - 1) / (2 * hz);
+	baud = (baud > 0) ? baud - 1 : 0;
+	if (baud > 255)
+		baud = 255;
+
+	/*
+	 * BAUD is enable-protected, so the peripheral must be briefly
+	 * disabled if it is already running.
+	 */
+	if ((SERCOM2_REGS->SPIM.SERCOM_CTRLA & (0x1 << 1)) != 0) {
+		SERCOM2_REGS->SPIM.SERCOM_CTRLA &= ~(0x1 << 1);
+		while ((SERCOM2_REGS->SPIM.SERCOM_SYNCBUSY & (0x1 << 1)) != 0) asm("nop");
+		SERCOM2_REGS->SPIM.SERCOM_BAUD = (uint8_t)baud;
+		SERCOM2_REGS->SPIM.SERCOM_CTRLA |= (0x1 << 1);
+		while ((SERCOM2_REGS->SPIM.SERCOM_SYNCBUSY & (0x1 << 1)) != 0) asm("nop");
+	} else {
+		SERCOM2_REGS->SPIM.SERCOM_BAUD = (uint8_t)baud;
+	}
+	return;
+}
+
+void platform_spi_sd_select(bool sel)
+{
+	if (sel)
+		PORT_SEC_REGS->GROUP[0].PORT_OUTCLR = (1 << 10);
+	else
+		PORT_SEC_REGS->GROUP[0].PORT_OUTSET = (1 << 10);
+	return;
+}
+
+bool platform_spi_sd_busy(void)
+{
+	return platform_dmac_ch_busy(PLATFORM_DMAC_CH_SD_RX) ||
+	       platform_dmac_ch_busy(PLATFORM_DMAC_CH_SD_TX);
+}
+
+bool platform_spi_sd_xfer_async(const void *tx, void *rx, uint16_t len)
+{
+	platform_dmac_desc_t *d;
+	uint32_t data_addr = (uint32_t)&(SERCOM2_REGS->SPIM.SERCOM_DATA);
+
+	if (len == 0 || platform_spi_sd_busy())
+		return false;
+
+	// Receiver: DATA -> rx (or the sink, without incrementing)
+	d = &platform_dmac_base[PLATFORM_DMAC_CH_SD_RX];
+	d->btcnt    = len;
+	d->srcaddr  = data_addr;
+	d->descaddr = 0;
+	if (rx != NULL) {
+		d->btctrl  = PLATFORM_DMAC_BTCTRL_DSTINC | PLATFORM_DMAC_BTCTRL_VALID;
+		d->dstaddr = (uint32_t)rx + len;
+	} else {
+		d->btctrl  = PLATFORM_DMAC_BTCTRL_VALID;
+		d->dstaddr = (uint32_t)&spi_sink;
+	}
+
+	// Transmitter: tx (or the 0xFF filler, without incrementing) -> DATA
+	d = &platform_dmac_base[PLATFORM_DMAC_CH_SD_TX];
+	d->btcnt    = len;
+	d->dstaddr  = data_addr;
+	d->descaddr = 0;
+	if (tx != NULL) {
+		d->btctrl  = PLATFORM_DMAC_BTCTRL_SRCINC | PLATFORM_DMAC_BTCTRL_VALID;
+		d->srcaddr = (uint32_t)tx + len;
+	} else {
+		d->btctrl  = PLATFORM_DMAC_BTCTRL_VALID;
+		d->srcaddr = (uint32_t)&spi_fill;
+	}
+
+	// Receive channel first; the DRE trigger then starts the transfer
+	platform_dmac_ch_enable(PLATFORM_DMAC_CH_SD_RX);
+	platform_dmac_ch_enable(PLATFORM_DMAC_CH_SD_TX);
+	return true;
+}
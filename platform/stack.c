@@ -0,0 +1,111 @@
+/**
+ * @file platform/stack.c
+ * @brief Platform-support routines, stack usage monitor
+ */
+
+/*
+ * The main stack grows down from the initial stack pointer (the first word
+ * of the vector table) into whatever the linker leaves above .bss and the
+ * heap. platform_stack_init() fills the PLATFORM_STACK_WATCH_SZ bytes below
+ * the top that are not yet in use with a pattern; a word that no longer holds
+ * it has been written by some stack frame, so the lowest such word marks the
+ * deepest the stack has been.
+ *
+ * platform_stack_scan() looks for that word a few words at a time, from the
+ * bottom of the watched area up, so that it never holds up the loop; a pass
+ * over 4 KiB of unused stack takes about thirty loop iterations.
+ *
+ * Interrupt handlers run on the same stack. Each calls platform_stack_probe()
+ * (stack.h) on entry, which keeps the deepest stack it was entered with: the
+ * high-water mark shows how deep the stack got, the probes show which handler
+ * was taken at the worst moment.
+ *
+ * NOTE: The watched area must lie within the stack the linker reserves; the
+ *       RAM budget (inc/ram_budget.h) guarantees at least RAM_BUDGET_stack.
+ */
+
+// Common include for the XC32 compiler
+#include <xc.h>
+#include <stdbool.h>
+
+#include "../inc/platform.h"
+#include "../inc/metrics.h"
+#include "stack.h"
+
+// Functions "exported" by this file
+void platform_stack_init(void);
+void platform_stack_scan(void);
+
+/////////////////////////////////////////////////////////////////////////////
+
+/// Fill pattern of unused stack
+#define STACK_PAINT		0xC5C5C5C5UL
+
+/// Words left unpainted below the stack pointer of platform_stack_init()
+#define STACK_PAINT_MARGIN	8
+
+/// Words examined per call of platform_stack_scan()
+#define STACK_SCAN_WORDS	32
+
+uint32_t platform_stack_top;
+volatile uint32_t platform_stack_isr_depth[PLATFORM_STACK_ISR_NR];
+
+static struct {
+	uint32_t *bottom;	///< Lowest watched word
+	uint32_t *low;		///< Lowest word known to have been written
+	uint32_t *cursor;	///< Next word to examine
+	uint32_t passes;	///< Completed scans
+} stk;
+
+METRIC_GAUGE(stack_used);	// High-water mark, in bytes below the top
+
+// Paint the unused part of the watched area
+void platform_stack_init(void)
+{
+	uint32_t *p;
+
+	platform_stack_top = *(const uint32_t *)SCB->VTOR;
+	stk.bottom = (uint32_t *)(platform_stack_top - PLATFORM_STACK_WATCH_SZ);
+	stk.low    = (uint32_t *)(__get_MSP() & ~0x3UL) - STACK_PAINT_MARGIN;
+
+	/*
+	 * Plain stores only: a call (memset) would place its frame below the
+	 * stack pointer read above, i.e., in the area being painted.
+	 */
+	for (p = stk.bottom; p < stk.low; ++p)
+		*p = STACK_PAINT;
+	stk.cursor = stk.bottom;
+	return;
+}
+
+// Advance the search for the high-water mark
+void platform_stack_scan(void)
+{
+	for (unsigned int n = 0; n < STACK_SCAN_WORDS; ++n) {
+		if (stk.cursor < stk.low && *stk.cursor == STACK_PAINT) {
+			++stk.cursor;
+			continue;
+		}
+		if (stk.cursor < stk.low) {
+			stk.low = stk.cursor;
+			metric_set(&stack_used,
+				(int32_t)(platform_stack_top - (uint32_t)stk.low));
+		}
+		stk.cursor = stk.bottom;
+		++stk.passes;
+		break;
+	}
+	return;
+}
+
+// Report stack usage
+void platform_stack_get_stats(platform_stack_stats_t *out)
+{
+	out->watched = PLATFORM_STACK_WATCH_SZ;
+	out->used    = platform_stack_top - (uint32_t)stk.low;
+	out->passes  = stk.passes;
+	out->overrun = (stk.low == stk.bottom);
+	for (unsigned int i = 0; i < PLATFORM_STACK_ISR_NR; ++i)
+		out->isr_depth[i] = platform_stack_isr_depth[i];
+	return;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file platform/stack.h
+ * @brief Platform-internal declarations for the stack monitor
+ *
+ * NOTE: This header is only meant for platform/*.c; application code uses
+ *       platform_stack_get_stats() in platform.h instead.
+ */
+
+#if !defined(PLATFORM_STACK_H_)
+#define PLATFORM_STACK_H_
+
+#include <stdint.h>
+
+/// Initial stack pointer, i.e., the top of the main stack
+extern uint32_t platform_stack_top;
+
+/// Deepest stack seen on entry to each handler (PLATFORM_STACK_ISR_*)
+extern volatile uint32_t platform_stack_isr_depth[PLATFORM_STACK_ISR_NR];
+
+/**
+ * Record the stack depth on entry to an interrupt handler
+ *
+ * Call first thing in the handler. The depth covers the interrupted code's
+ * frames, the exception frame pushed by the core and the handler's prologue.
+ *
+ * @p	isr	Handler (PLATFORM_STACK_ISR_*)
+ */
+static inline void platform_stack_probe(unsigned int isr)
+{
+	uint32_t depth = platform_stack_top - __get_MSP();
+
+	if (depth > platform_stack_isr_depth[isr])
+		platform_stack_isr_depth[isr] = depth;
+}
+
+#endif	// !defined(PLATFORM_STACK_H_)
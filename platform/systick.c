@@ -26,6 +26,7 @@
 #include <string.h>
 
 #include "../inc/platform.h"
+#include "stack.h"
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -63,20 +64,19 @@ int platform_timespec_compare(const platform_timespec_t *lhs,
 
 // SysTick handling
 static volatile platform_timespec_t ts_wall = PLATFORM_TIMESPEC_ZERO;
-static volatile uint32_t ts_wall_cookie = 0;
 void __attribute__((used, interrupt())) SysTick_Handler(void)
 {
 	platform_timespec_t t = ts_wall;
 	
+	platform_stack_probe(PLATFORM_STACK_ISR_SYSTICK);
+	
 	t.nr_nsec += (PLATFORM_TICK_PERIOD_US * 1000);
 	while (t.nr_nsec >= 1000000000) {
 		t.nr_nsec -= 1000000000;
 		++t.nr_sec;	// Wrap-around intentional
 	}
 	
-	++ts_wall_cookie;	// Wrap-around intentional
 	ts_wall = t;
-	++ts_wall_cookie;	// Wrap-around intentional
 	
 	// Reset before returning.
 	SysTick->VAL  = 0x00158158;	// Any value will clear
@@ -100,20 +100,31 @@ void platform_systick_init(void)
 }
 void platform_tick_count(platform_timespec_t *tick)
 {
-	uint32_t cookie;
+	// Both words must come from the same tick
+	platform_crit_t c = platform_crit_enter();
 	
-	// A cookie is used to make sure we get coherent data.
-	do {
-		cookie = ts_wall_cookie;
-		*tick = ts_wall;
-	} while (ts_wall_cookie != cookie);
+	*tick = ts_wall;
+	platform_crit_exit(c);
 }
 void platform_tick_hrcount(platform_timespec_t *tick)
 {
 	platform_timespec_t t;
-	uint32_t s = SYSTICK_RELOAD_VAL - SysTick->VAL;
+	platform_crit_t c = platform_crit_enter();
+	uint32_t s = SysTick->VAL;
+	
+	t = ts_wall;
+	if ((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) != 0) {
+		/*
+		 * The counter has wrapped, but the handler has yet to count the
+		 * tick: read the counter again, now surely past the wrap, and
+		 * count the tick here.
+		 */
+		s = SysTick->VAL;
+		t.nr_nsec += (PLATFORM_TICK_PERIOD_US * 1000);
+	}
+	platform_crit_exit(c);
 	
-	platform_tick_count(&t);
+	s = SYSTICK_RELOAD_VAL - s;
 	t.nr_nsec += (1000 * s)/12;
 	while (t.nr_nsec >= 1000000000) {
 		t.nr_nsec -= 1000000000;
@@ -17,6 +17,10 @@
  * Board:
  * -- PB08: UART via debugger (TX, SERCOM3, PAD[0])
  * -- PB09: UART via debugger (RX, SERCOM3, PAD[1])
+ *
+ * Transmission is done by a DMAC channel triggered by SERCOM3 TX; the
+ * fragments of a request are chained as linked DMA descriptors so that the
+ * whole request goes out back-to-back without CPU involvement.
  */
 
 // Common include for the XC32 compiler
@@ -25,6 +29,8 @@
 #include <string.h>
 
 #include "../inc/platform.h"
+#include "../inc/ram_budget.h"
+#include "dmac.h"
 
 // Functions "exported" by this file
 void platform_usart_init(void);
@@ -45,12 +51,8 @@ typedef struct ctx_usart_type {
 	
 	/// State variables for the transmitter
 	struct {
-		volatile platform_usart_tx_bufdesc_t *desc;
-		volatile uint16_t nr_desc;
-		
-		// Current descriptor
-		volatile const char *buf;
-		volatile uint16_t    len;
+		/// DMAC channel used for transmission
+		uint8_t dma_ch;
 	} tx;
 	
 	/// State variables for the receiver
@@ -75,6 +77,19 @@ typedef struct ctx_usart_type {
 } ctx_usart_t;
 static ctx_usart_t ctx_uart;
 
+/////////////////////////////////////////////////////////////////////////////
+
+/// Maximum number of bytes that may be sent (or received) in one transaction
+#define NR_USART_CHARS_MAX (65528)
+
+/// Maximum number of fragments for USART TX
+#define NR_USART_TX_FRAG_MAX (32)
+
+/// Linked descriptors for the second fragment onwards of a CDC transmission
+static platform_dmac_desc_t cdc_tx_chain[NR_USART_TX_FRAG_MAX - 1];
+
+RAM_BUDGET_CHECK(cdc_usart, sizeof(ctx_uart) + sizeof(cdc_tx_chain));
+
 // Configure USART
 void platform_usart_init(void){
 	/*
@@ -108,6 +123,10 @@ void platform_usart_init(void){
 	// Initialize the peripheral's context structure
 	memset(&ctx_uart, 0, sizeof(ctx_uart));
 	ctx_uart.regs = UART_REGS;
+	ctx_uart.tx.dma_ch = PLATFORM_DMAC_CH_CDC_TX;
+	
+	// Transmission is DMA-driven
+	platform_dmac_ch_setup(PLATFORM_DMAC_CH_CDC_TX, PLATFORM_DMAC_TRIG_SERCOM3_TX);
 	
 	/*
 	 * This is the classic "SWRST" (software-triggered reset).
@@ -208,54 +227,55 @@ static void usart_tick_handler_common(
 	uint8_t  data   = 0x00;
 	platform_timespec_t ts_delta;
 	
-	// TX handling
-	if ((ctx->regs->SERCOM_INTFLAG & (1 << 0)) != 0) {
-		if (ctx->tx.len > 0) {
-			/*
-			 * There is still something to transmit in the working
-			 * copy of the current descriptor.
-			 */
-			ctx->regs->SERCOM_DATA = *(ctx->tx.buf++);
-			--ctx->tx.len;
+	/*
+	 * NOTE: Transmission needs no servicing here, as the DMAC moves the
+	 *       data on its own.
+	 */
+
+	// RX handling
+	if ((ctx->regs->SERCOM_INTFLAG & (1 << 2)) != 0) {
+		/*
+		 * There are unread data
+		 *
+		 * To enable readout of error conditions, STATUS must be read
+		 * before reading DATA.
+		 *
+		 * NOTE: Piggyback on Bit 15, as it is undefined for this
+		 *       platform.
+		 */
+		status = ctx->regs->SERCOM_STATUS | 0x8000;
+		data   = (uint8_t)(ctx->regs->SERCOM_DATA);
+	}
+	do {
+		if (ctx->rx.desc == NULL) {
+			// Nowhere to store any read data
+			break;
 		}
-		if (ctx->tx.len == 0) {
-			// Load a new descriptor
-			ctx->tx.buf = NULL;
-			if (ctx->tx.nr_desc > 0) {
-				/*
-				 * There's at least one descriptor left to
-				 * transmit
-				 * 
-				 * If either ->buf or ->len of the candidate
-				 * descriptor refer to an empty buffer, the
-				 * next invocation of this routine will cause
-				 * the next descriptor to be evaluated.
-				 */
-				ctx->tx.buf = ctx->tx.desc->buf;
-				ctx->tx.len = ctx->tx.desc->len;
-				
-				++ctx->tx.desc;
-				--ctx->tx.nr_desc;
-					
-				if (ctx->tx.buf == NULL || ctx->tx.len == 0) {
-					ctx->tx.buf = NULL;
-					ctx->tx.len = 0;
-				}
-			} else {
-				/*
-				 * No more descriptors available
-				 * 
-				 * Clean up the corresponding context data so
-				 * that we don't trip over them on the next
-				 * invocation.
-				 */
-				ctx->regs->SERCOM_INTENCLR = 0x01;
-				ctx->tx.desc = NULL;
-				ctx->tx.buf = NULL;
+
+		if ((status & 0x8003) == 0x8000) {
+			// No errors detected
+			ctx->rx.desc->buf[ctx->rx.idx++] = data;
+			ctx->rx.ts_idle = *tick;
+		}
+		ctx->regs->SERCOM_STATUS |= (status & 0x00F7);
+
+		// Some housekeeping
+		if (ctx->rx.idx >= ctx->rx.desc->max_len) {
+			// Buffer completely filled
+			usart_rx_abort_helper(ctx);
+			break;
+		} else if (ctx->rx.idx > 0) {
+			platform_timespec_t ts_idle = ctx->rx.ts_idle;
+
+			platform_tick_delta(&ts_delta, tick, &ts_idle);
+			if (platform_timespec_compare(&ts_delta, &ctx->cfg.ts_idle_timeout) >= 0) {
+				// IDLE timeout
+				usart_rx_abort_helper(ctx);
+				break;
 			}
 		}
-	}
-    
+	} while (0);
+
 	// Done
 	return;
 }
@@ -264,16 +284,10 @@ void platform_usart_tick_handler(const platform_timespec_t *tick)
 	usart_tick_handler_common(&ctx_uart, tick);
 }
 
-/// Maximum number of bytes that may be sent (or received) in one transaction
-#define NR_USART_CHARS_MAX (65528)
-
-/// Maximum number of fragments for USART TX
-#define NR_USART_TX_FRAG_MAX (32)
-
 // Enqueue a buffer for transmission
 static bool usart_tx_busy(ctx_usart_t *ctx)
 {
-	return (ctx->tx.len > 0) || (ctx->tx.nr_desc > 0) ||
+	return platform_dmac_ch_busy(ctx->tx.dma_ch) ||
 		((ctx->regs->SERCOM_INTFLAG & (1 << 0)) == 0);
 }
 static bool usart_tx_async(ctx_usart_t *ctx,
@@ -281,6 +295,7 @@ static bool usart_tx_async(ctx_usart_t *ctx,
 	unsigned int nr_desc)
 {
 	uint16_t avail = NR_USART_CHARS_MAX;
+	platform_dmac_desc_t *d = NULL, *prev = NULL;
 	unsigned int x, y;
 	
 	if (!desc || nr_desc == 0)
@@ -293,27 +308,47 @@ static bool usart_tx_async(ctx_usart_t *ctx,
 	if (usart_tx_busy(ctx))
 		return false;
 	
-	for (x = 0, y = 0; x < nr_desc; ++x) {
+	for (x = 0; x < nr_desc; ++x) {
 		if (desc[x].len > avail) {
 			// IF the message is too long, don't enqueue.
 			return false;
 		}
-		
 		avail -= desc[x].len;
+	}
+	
+	/*
+	 * Build the descriptor chain, skipping empty fragments
+	 * 
+	 * - Byte-sized beats, with only the source address incrementing
+	 * - SRCADDR refers to the end of the block when incrementing
+	 * - No block action; the channel disables itself at the end
+	 */
+	for (x = 0, y = 0; x < nr_desc; ++x) {
+		if (desc[x].buf == NULL || desc[x].len == 0)
+			continue;
+		
+		d = (y == 0) ? &platform_dmac_base[ctx->tx.dma_ch] : &cdc_tx_chain[y - 1];
+		d->btctrl   = PLATFORM_DMAC_BTCTRL_SRCINC | PLATFORM_DMAC_BTCTRL_VALID;
+		d->btcnt    = desc[x].len;
+		d->srcaddr  = (uint32_t)(desc[x].buf + desc[x].len);
+		d->dstaddr  = (uint32_t)&ctx->regs->SERCOM_DATA;
+		d->descaddr = 0;
+		if (prev != NULL)
+			prev->descaddr = (uint32_t)d;
+		prev = d;
 		++y;
 	}
+	if (y == 0)
+		// Nothing to send
+		return true;
 	
-	// The tick will trigger the transfer
-	ctx->tx.desc = desc;
-	ctx->tx.nr_desc = nr_desc;
+	// The DRE trigger starts the transfer right away
+	platform_dmac_ch_enable(ctx->tx.dma_ch);
 	return true;
 }
 static void usart_tx_abort(ctx_usart_t *ctx)
 {
-	ctx->tx.nr_desc = 0;
-	ctx->tx.desc = NULL;
-	ctx->tx.len = 0;
-	ctx->tx.buf = NULL;
+	platform_dmac_ch_abort(ctx->tx.dma_ch);
 	return;
 }
 
@@ -0,0 +1,492 @@
+/**
+ * @file bulkdl.c
+ * @brief Sliding-window, selective-repeat bulk log download.
+ *
+ * Blocks are not buffered: each (re)transmission reads the block straight
+ * from the log store, so the window costs a few bytes of bookkeeping per
+ * block. Every transmission is stamped with a send order. When the host
+ * acknowledges a block, any block still unacknowledged that was sent before
+ * it is presumed lost and is re-sent ahead of new blocks; this repairs single
+ * losses within one round trip without touching the blocks that did arrive.
+ * If nothing is acknowledged for a whole retransmission timeout (tail loss,
+ * link outage) only the oldest block is re-sent, and the timeout doubles up to
+ * BULKDL_RTO_MAX_MS; its acknowledgement then flags the rest of the window.
+ *
+ * A block that the log store first has to fetch from its card is simply not
+ * sent yet; the same block is picked again on the next call, by which time
+ * the fetch has usually completed.
+ */
+
+#include "../inc/bulkdl.h"
+#include "../inc/crc32.h"
+#include "../inc/logstore.h"
+#include "../inc/platform.h"
+#include "../inc/ram_budget.h"
+#include "../inc/metrics.h"
+#include "../inc/scratch.h"
+#include <string.h>
+
+/// Largest host -> device frame (START and ACK carry 8 payload bytes)
+#define BULKDL_RX_FRAME_MAX (BULKDL_HDR_LEN + 8 + BULKDL_CRC_LEN)
+
+#if BULKDL_WINDOW > 33
+#error "BULKDL_WINDOW is limited by the 32-bit SACK bitmap"
+#endif
+
+/// Per-block state within the window
+#define BULKDL_SLOT_SENT    0   // In flight, not yet acknowledged
+#define BULKDL_SLOT_RESEND  1   // Presumed lost; to be re-sent
+#define BULKDL_SLOT_ACKED   2   // Acknowledged out of order
+
+/**
+ * @brief Complete download state.
+ */
+static struct {
+    // Session
+    bool     active;
+    uint32_t end;               // One past the last block of the session
+    uint32_t base;              // Oldest unacknowledged block
+    uint32_t next;              // Next block that has never been sent
+
+    // Window, indexed by block % BULKDL_WINDOW
+    uint8_t  slot_state[BULKDL_WINDOW];
+    uint16_t slot_order[BULKDL_WINDOW];
+    uint16_t tx_order;          // Send order of the next transmission
+    uint16_t acked_order;       // Latest send order known to have arrived
+    bool     acked_any;
+
+    // Timing
+    uint32_t last_progress_ms;  // Last ACK progress (or first send into an empty window)
+    uint32_t last_rx_ms;        // Last valid frame from the host
+    uint16_t rto_ms;
+
+    // Replies waiting for the transmitter
+    bool     info_pending;
+    uint8_t  info_flags;
+    uint32_t info_first;
+    uint32_t info_end;
+    bool     done_pending;
+    bool     metrics_pending;
+    uint16_t metrics_first;
+
+    // Transmission staging (must stay valid while the CDC driver sends it)
+    uint8_t  tx_buf[BULKDL_BURST][BULKDL_BLOCK_FRAME_MAX];
+    platform_usart_tx_bufdesc_t tx_desc[BULKDL_BURST];
+
+    // Request parser
+    uint8_t  rx_frame[BULKDL_RX_FRAME_MAX];
+    uint8_t  rx_idx;
+
+    bulkdl_stats_t stats;
+} bulkdl;
+
+RAM_BUDGET_CHECK(bulkdl, sizeof(bulkdl));
+
+// --- Static Helper Functions ---
+
+static uint32_t bulkdl_ms(const platform_timespec_t *t) {
+    return (t->nr_sec * 1000u) + (t->nr_nsec / 1000000u); // Wrap-around intentional
+}
+
+static void bulkdl_put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t bulkdl_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/// Returns true if send order @p a precedes @p b (modulo wrap-around).
+static bool bulkdl_order_before(uint16_t a, uint16_t b) {
+    return (int16_t)(a - b) < 0;
+}
+
+/**
+ * @brief Frames @p plen payload bytes already placed after the header.
+ *
+ * @return Total frame length.
+ */
+static uint16_t bulkdl_frame(uint8_t *f, uint8_t type, uint8_t flags, uint16_t plen) {
+    uint32_t crc;
+
+    f[0] = BULKDL_SYNC_1;
+    f[1] = BULKDL_SYNC_2;
+    f[2] = type;
+    f[3] = flags;
+    f[4] = (uint8_t)(plen & 0xFF);
+    f[5] = (uint8_t)(plen >> 8);
+    crc = crc32_update(0, &f[2], (BULKDL_HDR_LEN - 2) + plen);
+    bulkdl_put_u32(&f[BULKDL_HDR_LEN + plen], crc);
+    return BULKDL_HDR_LEN + plen + BULKDL_CRC_LEN;
+}
+
+/**
+ * @brief Builds a BLOCK frame for @p blk into @p f.
+ *
+ * @return Frame length, or 0 if the log store is still fetching the block.
+ */
+static uint16_t bulkdl_frame_block(uint8_t *f, uint32_t blk) {
+    uint16_t n;
+
+    bulkdl_put_u32(&f[BULKDL_HDR_LEN], blk);
+    n = logstore_read_block(blk, &f[BULKDL_HDR_LEN + 4]);
+    if (n == LOGSTORE_READ_PENDING) {
+        return 0;
+    }
+    return bulkdl_frame(f, BULKDL_TYPE_BLOCK, 0, (uint16_t)(4 + n));
+}
+
+/**
+ * @brief Applies a host ACK to the window.
+ *
+ * @param next_blk Every block below this one has been received.
+ * @param sack Bit i set: block next_blk + 1 + i has been received.
+ */
+static void bulkdl_handle_ack(uint32_t next_blk, uint32_t sack, uint32_t now_ms) {
+    bool progress = false;
+    uint32_t blk;
+
+    if (!bulkdl.active || next_blk < bulkdl.base || next_blk > bulkdl.next) {
+        // Stale, or acknowledges blocks that were never sent
+        return;
+    }
+
+    // Collect the newest send order among the blocks this ACK covers
+    for (blk = bulkdl.base; blk < bulkdl.next; ++blk) {
+        uint8_t s = (uint8_t)(blk % BULKDL_WINDOW);
+        bool acked = (blk < next_blk) ||
+                     (blk > next_blk && blk - next_blk - 1 < 32 &&
+                      (sack & (1UL << (blk - next_blk - 1))) != 0);
+
+        if (!acked || bulkdl.slot_state[s] == BULKDL_SLOT_ACKED) {
+            continue;
+        }
+        if (bulkdl.slot_state[s] == BULKDL_SLOT_SENT &&
+            (!bulkdl.acked_any || bulkdl_order_before(bulkdl.acked_order, bulkdl.slot_order[s]))) {
+            bulkdl.acked_order = bulkdl.slot_order[s];
+            bulkdl.acked_any = true;
+        }
+        bulkdl.slot_state[s] = BULKDL_SLOT_ACKED;
+        bulkdl.stats.blocks_acked++;
+        progress = true;
+    }
+
+    // Slide the window past the contiguously acknowledged blocks
+    while (bulkdl.base < bulkdl.next &&
+           bulkdl.slot_state[bulkdl.base % BULKDL_WINDOW] == BULKDL_SLOT_ACKED) {
+        bulkdl.base++;
+    }
+
+    // Anything sent before a block that arrived was lost
+    for (blk = bulkdl.base; blk < bulkdl.next && bulkdl.acked_any; ++blk) {
+        uint8_t s = (uint8_t)(blk % BULKDL_WINDOW);
+        if (bulkdl.slot_state[s] == BULKDL_SLOT_SENT &&
+            bulkdl_order_before(bulkdl.slot_order[s], bulkdl.acked_order)) {
+            bulkdl.slot_state[s] = BULKDL_SLOT_RESEND;
+        }
+    }
+
+    if (progress) {
+        bulkdl.rto_ms = BULKDL_RTO_MIN_MS;
+        bulkdl.last_progress_ms = now_ms;
+    }
+    if (bulkdl.base == bulkdl.end) {
+        bulkdl.active = false;
+        bulkdl.done_pending = true;
+        bulkdl.stats.sessions_done++;
+    }
+}
+
+/// Starts a session covering [@p from, @p to), clamped to what the log holds.
+static void bulkdl_start(uint32_t from, uint32_t to, uint32_t now_ms) {
+    uint32_t first = logstore_first_block();
+    uint32_t end = logstore_end_block();
+
+    if (to > end) {
+        to = end;
+    }
+    if (from < first) {
+        from = first;
+    }
+    if (from > to) {
+        from = to;
+    }
+
+    bulkdl.base = from;
+    bulkdl.next = from;
+    bulkdl.end = to;
+    bulkdl.acked_any = false;
+    bulkdl.rto_ms = BULKDL_RTO_MIN_MS;
+    bulkdl.last_progress_ms = now_ms;
+    bulkdl.stats.sessions++;
+
+    bulkdl.info_pending = true;
+    bulkdl.info_flags = BULKDL_FLAG_SESSION;
+    bulkdl.info_first = from;
+    bulkdl.info_end = to;
+
+    // An empty range completes immediately
+    bulkdl.active = (from < to);
+    bulkdl.done_pending = !bulkdl.active;
+    if (!bulkdl.active) {
+        bulkdl.stats.sessions_done++;
+    }
+}
+
+/// Acts on a validated host frame.
+static void bulkdl_handle_frame(uint8_t type, const uint8_t *p, uint16_t plen, uint32_t now_ms) {
+    switch (type) {
+    case BULKDL_TYPE_INFO_REQ:
+        bulkdl.info_pending = true;
+        bulkdl.info_flags = 0;
+        bulkdl.info_first = logstore_first_block();
+        bulkdl.info_end = logstore_end_block();
+        break;
+    case BULKDL_TYPE_START:
+        if (plen != 8) {
+            bulkdl.stats.frames_bad++;
+            break;
+        }
+        bulkdl_start(bulkdl_get_u32(&p[0]), bulkdl_get_u32(&p[4]), now_ms);
+        break;
+    case BULKDL_TYPE_ACK:
+        if (plen != 8) {
+            bulkdl.stats.frames_bad++;
+            break;
+        }
+        bulkdl_handle_ack(bulkdl_get_u32(&p[0]), bulkdl_get_u32(&p[4]), now_ms);
+        break;
+    case BULKDL_TYPE_STOP:
+        bulkdl.active = false;
+        bulkdl.done_pending = false;
+        break;
+    case BULKDL_TYPE_METRICS_REQ:
+        if (plen != 2) {
+            bulkdl.stats.frames_bad++;
+            break;
+        }
+        bulkdl.metrics_pending = true;
+        bulkdl.metrics_first = (uint16_t)p[0] | ((uint16_t)p[1] << 8);
+        break;
+    default:
+        bulkdl.stats.frames_bad++;
+        return;
+    }
+    bulkdl.last_rx_ms = now_ms;
+}
+
+/**
+ * @brief Builds a METRICS frame from metric bulkdl.metrics_first on into @p f.
+ *
+ * @return Frame length, or 0 if no scratch space was available.
+ */
+static uint16_t bulkdl_frame_metrics(uint8_t *f) {
+    scratch_mark_t mark = scratch_mark();
+    metric_snapshot_t *s = scratch_alloc(sizeof(*s));
+    uint16_t total = (uint16_t)metrics_count();
+    uint16_t plen = 4;
+    uint16_t len;
+
+    if (s == NULL) {
+        return 0;
+    }
+    f[BULKDL_HDR_LEN + 0] = (uint8_t)(bulkdl.metrics_first & 0xFF);
+    f[BULKDL_HDR_LEN + 1] = (uint8_t)(bulkdl.metrics_first >> 8);
+    f[BULKDL_HDR_LEN + 2] = (uint8_t)(total & 0xFF);
+    f[BULKDL_HDR_LEN + 3] = (uint8_t)(total >> 8);
+    for (uint16_t i = bulkdl.metrics_first; i < total && metrics_snapshot(i, s); ++i) {
+        len = metrics_encode(s, &f[BULKDL_HDR_LEN + plen], (uint16_t)(4 + LOGSTORE_BLOCK_SZ - plen));
+        if (len == 0) {
+            break;
+        }
+        plen += len;
+    }
+    scratch_release(mark);
+    return bulkdl_frame(f, BULKDL_TYPE_METRICS, 0, plen);
+}
+
+/**
+ * @brief Picks the next block to put on the wire.
+ *
+ * @param blk Receives the block number.
+ * @return true if a block is due, false if the window has nothing to send.
+ */
+static bool bulkdl_pick_block(uint32_t *blk) {
+    uint32_t b;
+
+    // Repairs go first, oldest block first
+    for (b = bulkdl.base; b < bulkdl.next; ++b) {
+        if (bulkdl.slot_state[b % BULKDL_WINDOW] == BULKDL_SLOT_RESEND) {
+            *blk = b;
+            return true;
+        }
+    }
+    if (bulkdl.next < bulkdl.end && (bulkdl.next - bulkdl.base) < BULKDL_WINDOW) {
+        *blk = bulkdl.next;
+        return true;
+    }
+    return false;
+}
+
+// --- Public API ---
+
+void bulkdl_init(void) {
+    memset(&bulkdl, 0, sizeof(bulkdl));
+    bulkdl.rto_ms = BULKDL_RTO_MIN_MS;
+}
+
+void bulkdl_rx_feed(const char *buf, uint16_t len) {
+    platform_timespec_t now;
+
+    platform_tick_count(&now);
+    for (uint16_t i = 0; i < len; ++i) {
+        uint8_t c = (uint8_t)buf[i];
+
+        if (bulkdl.rx_idx == 0 && c != BULKDL_SYNC_1) {
+            continue;
+        }
+        if (bulkdl.rx_idx == 1 && c != BULKDL_SYNC_2) {
+            bulkdl.rx_idx = (c == BULKDL_SYNC_1) ? 1 : 0;
+            continue;
+        }
+        bulkdl.rx_frame[bulkdl.rx_idx++] = c;
+        if (bulkdl.rx_idx < BULKDL_HDR_LEN) {
+            continue;
+        }
+
+        uint16_t plen = (uint16_t)bulkdl.rx_frame[4] | ((uint16_t)bulkdl.rx_frame[5] << 8);
+        if (plen > BULKDL_RX_FRAME_MAX - BULKDL_HDR_LEN - BULKDL_CRC_LEN) {
+            // Not a request frame (or a corrupted length); resynchronize
+            bulkdl.rx_idx = 0;
+            bulkdl.stats.frames_bad++;
+            continue;
+        }
+        if (bulkdl.rx_idx < BULKDL_HDR_LEN + plen + BULKDL_CRC_LEN) {
+            continue;
+        }
+
+        // Complete frame; validate before acting on it
+        bulkdl.rx_idx = 0;
+        uint32_t crc = crc32_update(0, &bulkdl.rx_frame[2], (BULKDL_HDR_LEN - 2) + plen);
+        if (crc != bulkdl_get_u32(&bulkdl.rx_frame[BULKDL_HDR_LEN + plen])) {
+            bulkdl.stats.frames_bad++;
+            continue;
+        }
+        bulkdl_handle_frame(bulkdl.rx_frame[2], &bulkdl.rx_frame[BULKDL_HDR_LEN], plen,
+                            bulkdl_ms(&now));
+    }
+}
+
+void bulkdl_service(const platform_timespec_t *now) {
+    uint32_t now_ms = bulkdl_ms(now);
+    uint8_t nr = 0;
+    uint32_t blk;
+    bool metrics_sent = false;
+    bool done_sent = false;
+
+    if (!bulkdl_active() || platform_usart_cdc_tx_busy()) {
+        return;
+    }
+
+    if (bulkdl.active && (now_ms - bulkdl.last_rx_ms) >= BULKDL_IDLE_TIMEOUT_MS) {
+        // The host went away; give the link back to the application
+        bulkdl.active = false;
+        bulkdl.stats.sessions_expired++;
+    }
+
+    // Retransmission timeout: probe with the oldest block alone
+    if (bulkdl.active && bulkdl.base < bulkdl.next &&
+        (now_ms - bulkdl.last_progress_ms) >= bulkdl.rto_ms) {
+        bulkdl.slot_state[bulkdl.base % BULKDL_WINDOW] = BULKDL_SLOT_RESEND;
+        bulkdl.last_progress_ms = now_ms;
+        bulkdl.rto_ms = (bulkdl.rto_ms >= (BULKDL_RTO_MAX_MS / 2)) ?
+                        BULKDL_RTO_MAX_MS : (uint16_t)(bulkdl.rto_ms * 2);
+        bulkdl.stats.timeouts++;
+    }
+
+    if (bulkdl.info_pending) {
+        uint8_t *f = bulkdl.tx_buf[nr];
+
+        bulkdl_put_u32(&f[BULKDL_HDR_LEN], bulkdl.info_first);
+        bulkdl_put_u32(&f[BULKDL_HDR_LEN + 4], bulkdl.info_end);
+        f[BULKDL_HDR_LEN + 8]  = (uint8_t)(LOGSTORE_BLOCK_SZ & 0xFF);
+        f[BULKDL_HDR_LEN + 9]  = (uint8_t)(LOGSTORE_BLOCK_SZ >> 8);
+        f[BULKDL_HDR_LEN + 10] = (uint8_t)BULKDL_WINDOW;
+        f[BULKDL_HDR_LEN + 11] = 0;
+        bulkdl.tx_desc[nr].buf = (const char *)f;
+        bulkdl.tx_desc[nr].len = bulkdl_frame(f, BULKDL_TYPE_INFO, bulkdl.info_flags, 12);
+        nr++;
+    }
+
+    if (bulkdl.metrics_pending && nr < BULKDL_BURST) {
+        uint16_t len = bulkdl_frame_metrics(bulkdl.tx_buf[nr]);
+
+        if (len != 0) {
+            bulkdl.tx_desc[nr].buf = (const char *)bulkdl.tx_buf[nr];
+            bulkdl.tx_desc[nr].len = len;
+            nr++;
+            metrics_sent = true;
+        }
+    }
+
+    while (bulkdl.active && nr < BULKDL_BURST && bulkdl_pick_block(&blk)) {
+        uint8_t s = (uint8_t)(blk % BULKDL_WINDOW);
+        uint16_t len = bulkdl_frame_block(bulkdl.tx_buf[nr], blk);
+
+        if (len == 0) {
+            break;
+        }
+        if (blk == bulkdl.next) {
+            if (bulkdl.base == bulkdl.next) {
+                bulkdl.last_progress_ms = now_ms;
+            }
+            bulkdl.next++;
+        } else {
+            bulkdl.stats.blocks_resent++;
+        }
+        bulkdl.slot_state[s] = BULKDL_SLOT_SENT;
+        bulkdl.slot_order[s] = bulkdl.tx_order++;
+        bulkdl.stats.blocks_sent++;
+
+        bulkdl.tx_desc[nr].buf = (const char *)bulkdl.tx_buf[nr];
+        bulkdl.tx_desc[nr].len = len;
+        nr++;
+    }
+
+    if (bulkdl.done_pending && nr < BULKDL_BURST) {
+        uint8_t *f = bulkdl.tx_buf[nr];
+
+        bulkdl_put_u32(&f[BULKDL_HDR_LEN], bulkdl.end);
+        bulkdl.tx_desc[nr].buf = (const char *)f;
+        bulkdl.tx_desc[nr].len = bulkdl_frame(f, BULKDL_TYPE_DONE, 0, 4);
+        nr++;
+        done_sent = true;
+    }
+
+    /*
+     * The transmitter was checked to be idle, so this only fails on a driver
+     * fault; blocks marked as sent are then recovered by the timeout.
+     */
+    if (nr == 0 || !platform_usart_cdc_tx_async(bulkdl.tx_desc, nr)) {
+        return;
+    }
+    bulkdl.info_pending = false;
+    if (done_sent) {
+        bulkdl.done_pending = false;
+    }
+    if (metrics_sent) {
+        bulkdl.metrics_pending = false;
+    }
+}
+
+bool bulkdl_active(void) {
+    return bulkdl.active || bulkdl.info_pending || bulkdl.done_pending || bulkdl.metrics_pending;
+}
+
+void bulkdl_get_stats(bulkdl_stats_t *out) {
+    *out = bulkdl.stats;
+}
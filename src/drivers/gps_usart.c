@@ -37,6 +37,9 @@
 #include <string.h>  // For memset
 
 #include "platform.h" 
+#include "ram_budget.h"
+
+#if FEATURE_GPS_ENABLED
 
 // Functions "exported" by this file (as per original comment, though they are static or part of the API)
 // Public API functions are declared in platform.h and defined at the end of this file.
@@ -138,6 +141,8 @@ typedef struct ctx_usart_type {
 /** @brief Static instance of the USART context structure for GPS communication (SERCOM1). */
 static gps_ctx_usart_t gps_ctx_uart;
 
+RAM_BUDGET_CHECK(gps_usart, sizeof(gps_ctx_uart));
+
 // Configure USART (SERCOM1 for GPS)
 /**
  * @brief Initializes the USART peripheral (SERCOM1) for GPS communication.
@@ -540,4 +545,6 @@ void gps_platform_usart_cdc_rx_abort(void)
 {
     // Call the internal abort helper function with the GPS UART context.
 	gps_usart_rx_abort_helper(&gps_ctx_uart);
-}
\ No newline at end of file
+}
+
+#endif	// FEATURE_GPS_ENABLED
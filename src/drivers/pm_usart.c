@@ -23,6 +23,9 @@
 #include <stdbool.h>
 #include <string.h>
 #include "platform.h"
+#include "ram_budget.h"
+
+#if FEATURE_PM_ENABLED
 
 
 // Functions "exported" by this file
@@ -74,6 +77,8 @@ typedef struct ctx_usart_type {
 } pm_ctx_usart_t;
 static pm_ctx_usart_t pm_ctx_uart;
 
+RAM_BUDGET_CHECK(pm_usart, sizeof(pm_ctx_uart));
+
 // Configure USART
 void pm_platform_usart_init(void){
 	/*
@@ -305,3 +310,5 @@ void pm_platform_usart_cdc_rx_abort(void)
 {
 	pm_usart_rx_abort_helper(&pm_ctx_uart);
 }
+
+#endif	// FEATURE_PM_ENABLED
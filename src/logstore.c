@@ -0,0 +1,115 @@
+/**
+ * @file logstore.c
+ * @brief RAM backend for the record log.
+ *
+ * The log is a byte ring indexed by the absolute stream offset, so reading a
+ * block is a (possibly wrapping) copy from offset blk * LOGSTORE_BLOCK_SZ.
+ * Eviction is implicit: once more than LOGSTORE_RAM_SZ bytes have been written
+ * the oldest bytes are overwritten, and the first readable block moves up to
+ * the first one that is still wholly in the ring.
+ */
+
+#include "../inc/logstore.h"
+#include "../inc/ram_budget.h"
+#include <string.h>
+
+#if LOGSTORE_BACKEND == LOGSTORE_BACKEND_RAM
+
+/**
+ * @brief Complete log state.
+ */
+static struct {
+    uint8_t  ring[LOGSTORE_RAM_SZ];
+    uint32_t head;              // Stream offset of the next byte to write
+    uint32_t records;
+} logstore;
+
+RAM_BUDGET_CHECK(logstore, sizeof(logstore));
+
+// --- Static Helper Functions ---
+
+static void logstore_put(const uint8_t *p, uint16_t len) {
+    while (len > 0) {
+        uint32_t off = logstore.head % LOGSTORE_RAM_SZ;
+        uint32_t chunk = LOGSTORE_RAM_SZ - off;
+
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(&logstore.ring[off], p, chunk);
+        logstore.head += chunk;
+        p += chunk;
+        len = (uint16_t)(len - chunk);
+    }
+}
+
+// --- Public API ---
+
+void logstore_init(void) {
+    memset(&logstore, 0, sizeof(logstore));
+}
+
+void logstore_service(const platform_timespec_t *now) {
+    (void)now;
+}
+
+bool logstore_append(uint8_t type, const void *data, uint16_t len) {
+    uint8_t hdr[2];
+
+    if (len > 0xFF) {
+        return false;
+    }
+    hdr[0] = type;
+    hdr[1] = (uint8_t)len;
+    logstore_put(hdr, sizeof(hdr));
+    logstore_put((const uint8_t *)data, len);
+    logstore.records++;
+    return true;
+}
+
+uint32_t logstore_first_block(void) {
+    if (logstore.head <= LOGSTORE_RAM_SZ) {
+        return 0;
+    }
+    // Round up: the block holding the oldest byte is partly overwritten
+    return (logstore.head - LOGSTORE_RAM_SZ + LOGSTORE_BLOCK_SZ - 1) / LOGSTORE_BLOCK_SZ;
+}
+
+uint32_t logstore_end_block(void) {
+    return (logstore.head + LOGSTORE_BLOCK_SZ - 1) / LOGSTORE_BLOCK_SZ;
+}
+
+void logstore_get_end(uint32_t *blk, uint16_t *off) {
+    *blk = logstore.head / LOGSTORE_BLOCK_SZ;
+    *off = (uint16_t)(logstore.head % LOGSTORE_BLOCK_SZ);
+}
+
+bool logstore_get_boot(uint32_t *blk, uint16_t *off) {
+    *blk = 0;
+    *off = 0;
+    return true;
+}
+
+uint16_t logstore_read_block(uint32_t blk, void *buf) {
+    uint32_t start = blk * LOGSTORE_BLOCK_SZ;
+    uint16_t len;
+
+    if (blk < logstore_first_block() || blk >= logstore_end_block()) {
+        return 0;
+    }
+    len = (logstore.head - start >= LOGSTORE_BLOCK_SZ) ?
+          LOGSTORE_BLOCK_SZ : (uint16_t)(logstore.head - start);
+
+    // Blocks never straddle the ring boundary, as the ring size is a multiple
+    memcpy(buf, &logstore.ring[start % LOGSTORE_RAM_SZ], len);
+    return len;
+}
+
+void logstore_get_stats(logstore_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    out->records_appended = logstore.records;
+    out->bytes_appended = logstore.head;
+    out->blocks_evicted = logstore_first_block();
+}
+
+#endif // LOGSTORE_BACKEND == LOGSTORE_BACKEND_RAM
@@ -0,0 +1,536 @@
+/**
+ * @file logstore_sd.c
+ * @brief SD card backend for the record log.
+ *
+ * Records land in a ring of LOGSTORE_SD_STAGE_BLOCKS sector images in RAM.
+ * Complete blocks are written out LOGSTORE_SD_BATCH_MIN or more at a time
+ * with a single multi-block write (preceded by a pre-erase hint), which is
+ * what lets a card sustain its rated write speed; anything that has waited
+ * LOGSTORE_SD_FLUSH_MS is written out regardless, including the open block,
+ * which is copied aside first so that appends can carry on during the write.
+ * A block leaves the ring only once the card has accepted it.
+ *
+ * Blocks are written strictly in order, so the log on the card is always a
+ * contiguous run of valid sectors from LOGSTORE_SD_FIRST_LBA. Mounting finds
+ * its end with a binary search over sector validity (a few dozen single-block
+ * reads even for a large card), and continues the newest block if it is
+ * partial. Records appended before the mount completes are kept and moved
+ * behind the continued block.
+ *
+ * Nothing here waits on the card. When the card falls behind (or goes away
+ * after the mount) the ring fills up and new records are dropped, so the log
+ * on the card never gets a hole; the card is re-identified every
+ * LOGSTORE_SD_RETRY_MS. Without a usable card at start-up, the ring simply
+ * acts as a small RAM log.
+ */
+
+#include "../inc/logstore.h"
+#include "../inc/sdcard.h"
+#include "../inc/crc32.h"
+#include "../inc/platform.h"
+#include "../inc/ram_budget.h"
+#include <string.h>
+
+#if LOGSTORE_BACKEND == LOGSTORE_BACKEND_SD
+
+#if LOGSTORE_SECTOR_SZ != SD_BLOCK_SZ
+#error "Log sectors must match the card block size"
+#endif
+
+#define LS_NONE                 0xFFFFFFFFu
+
+/// Backend states
+enum {
+    LS_ST_IDENTIFY = 0,         // Waiting for the card to be identified
+    LS_ST_MOUNT_FIRST,          // Reading block 0 of the log
+    LS_ST_MOUNT_EPOCH,          // No log: reading block 1 for the epoch of an older one
+    LS_ST_MOUNT_SEARCH,         // Binary search for the end of the log
+    LS_ST_MOUNT_LAST,           // Reading the newest block, to continue it
+    LS_ST_CARD,                 // The log is kept on the card
+    LS_ST_RAM                   // No usable card at start-up
+};
+
+/// Card operations
+enum {
+    LS_OP_NONE = 0,
+    LS_OP_READ,
+    LS_OP_WRITE
+};
+
+/**
+ * @brief Complete backend state.
+ *
+ * Block numbers are relative to @c base (the first block this boot appends
+ * to) unless noted otherwise.
+ */
+static struct {
+    uint8_t  stage[LOGSTORE_SD_STAGE_BLOCKS][LOGSTORE_SECTOR_SZ];
+    uint8_t  tail[LOGSTORE_SECTOR_SZ];      // Open block, copied aside while it is written
+    uint8_t  sector[LOGSTORE_SECTOR_SZ];    // Mount reads, then the read cache
+    const uint8_t *wr_list[LOGSTORE_SD_STAGE_BLOCKS];
+
+    uint8_t  state;
+    uint16_t epoch;
+    uint32_t cap;               // Absolute blocks the card can hold
+    uint32_t base;              // Absolute number of relative block 0
+    uint32_t head;              // Stream bytes from the start of block 0
+    uint32_t shift;             // Bytes of block 0 that were written before this boot
+    uint32_t first;             // Oldest staged block; everything before it is on the card
+    uint32_t first_used;        // Bytes of block @c first already on the card
+
+    // Write-back
+    uint8_t  op;                // Card operation in progress
+    uint16_t wr_full;           // Complete blocks in the write in progress
+    uint16_t wr_tail_used;      // Bytes of the open block in it (0: not included)
+    bool     wr_covers_all;     // It leaves nothing older than its start behind
+    uint32_t wr_start_ms;
+    bool     dirty;             // Some appended bytes are not on the card yet
+    uint32_t dirty_ms;          // Arrival of the oldest of them (or earlier)
+    bool     last_was_read;
+    bool     retry_armed;
+    uint32_t retry_ms;
+
+    // Mount
+    uint32_t lo;                // Blocks below this are known valid
+    uint32_t hi;                // This block is known invalid (or the card ends)
+    uint32_t probe;
+
+    // Read cache (absolute block numbers)
+    uint32_t rd_want;           // Block a reader is waiting for
+    uint32_t rd_blk;            // Block being read
+    uint32_t cache_blk;         // Block held in @c sector
+    uint16_t cache_used;        // Its valid bytes; 0 if it failed the checks
+
+    logstore_stats_t stats;
+} ls;
+
+RAM_BUDGET_CHECK(logstore, sizeof(ls));
+
+// --- Static Helper Functions ---
+
+static uint32_t ls_ms(const platform_timespec_t *t) {
+    return (t->nr_sec * 1000u) + (t->nr_nsec / 1000000u); // Wrap-around intentional
+}
+
+static void ls_put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t ls_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint8_t *ls_slot(uint32_t rel) {
+    return ls.stage[rel % LOGSTORE_SD_STAGE_BLOCKS];
+}
+
+/// Returns the staged byte at stream offset @p off.
+static uint8_t *ls_byte(uint32_t off) {
+    return &ls_slot(off / LOGSTORE_BLOCK_SZ)[LOGSTORE_SECTOR_HDR_SZ + (off % LOGSTORE_BLOCK_SZ)];
+}
+
+static uint32_t ls_sector_crc(const uint8_t *sec) {
+    uint32_t crc = crc32_update(0, sec, 12);
+    return crc32_update(crc, &sec[LOGSTORE_SECTOR_HDR_SZ], LOGSTORE_BLOCK_SZ);
+}
+
+/// Fills in the header of a sector image holding absolute block @p blk.
+static void ls_seal(uint8_t *sec, uint32_t blk, uint16_t used) {
+    ls_put_u32(&sec[0], LOGSTORE_SECTOR_MAGIC);
+    ls_put_u32(&sec[4], blk);
+    sec[8]  = (uint8_t)(used & 0xFF);
+    sec[9]  = (uint8_t)(used >> 8);
+    sec[10] = (uint8_t)(ls.epoch & 0xFF);
+    sec[11] = (uint8_t)(ls.epoch >> 8);
+    ls_put_u32(&sec[12], ls_sector_crc(sec));
+}
+
+/**
+ * @brief Checks a sector read back from the card.
+ *
+ * @param blk Absolute block number the sector should hold.
+ * @param any_epoch Accept a sector of any log, not only the current one.
+ * @return Valid data bytes, or -1 if the sector does not hold that block.
+ */
+static int32_t ls_check(const uint8_t *sec, uint32_t blk, bool any_epoch) {
+    uint16_t used = (uint16_t)(sec[8] | (sec[9] << 8));
+    uint16_t epoch = (uint16_t)(sec[10] | (sec[11] << 8));
+
+    if (ls_get_u32(&sec[0]) != LOGSTORE_SECTOR_MAGIC || ls_get_u32(&sec[4]) != blk ||
+        used == 0 || used > LOGSTORE_BLOCK_SZ || (!any_epoch && epoch != ls.epoch) ||
+        ls_get_u32(&sec[12]) != ls_sector_crc(sec)) {
+        return -1;
+    }
+    return used;
+}
+
+/// Returns true if the staging ring can grow to stream offset @p head.
+static bool ls_fits(uint32_t head, uint32_t nr_blocks) {
+    return (head / LOGSTORE_BLOCK_SZ) - ls.first + 1 <= nr_blocks;
+}
+
+static void ls_put(const uint8_t *p, uint16_t len) {
+    while (len > 0) {
+        uint32_t off = ls.head % LOGSTORE_BLOCK_SZ;
+        uint32_t chunk = LOGSTORE_BLOCK_SZ - off;
+
+        if (off == 0) {
+            memset(ls_slot(ls.head / LOGSTORE_BLOCK_SZ), 0, LOGSTORE_SECTOR_SZ);
+        }
+        if (chunk > len) {
+            chunk = len;
+        }
+        memcpy(ls_byte(ls.head), p, chunk);
+        ls.head += chunk;
+        p += chunk;
+        len = (uint16_t)(len - chunk);
+    }
+}
+
+static void ls_read(uint32_t blk) {
+    ls.cache_blk = LS_NONE;
+    ls.rd_blk = blk;
+    ls.op = LS_OP_READ;
+    sd_read_start(LOGSTORE_SD_FIRST_LBA + blk, ls.sector);
+}
+
+/// Gives up on the card before the log was mounted; the ring becomes the log.
+static void ls_to_ram(void) {
+    ls.state = LS_ST_RAM;
+    ls.base = 0;
+    ls.dirty = false;
+}
+
+/**
+ * @brief Completes the mount: the log on the card ends at absolute block
+ *        @p end, whose last block holds @p used bytes.
+ */
+static void ls_mounted(uint32_t end, uint16_t used) {
+    if (used > 0 && used < LOGSTORE_BLOCK_SZ) {
+        // Continue the partial block: move what arrived meanwhile behind it
+        ls.base = end - 1;
+        for (uint32_t i = ls.head; i-- > 0; ) {
+            *ls_byte(i + used) = *ls_byte(i);
+        }
+        memcpy(ls_byte(0), &ls.sector[LOGSTORE_SECTOR_HDR_SZ], used);
+        ls.head += used;
+        if ((ls.head % LOGSTORE_BLOCK_SZ) != 0) {
+            memset(ls_byte(ls.head), 0, LOGSTORE_BLOCK_SZ - (ls.head % LOGSTORE_BLOCK_SZ));
+        }
+        ls.shift = used;
+        ls.first_used = used;
+    } else {
+        ls.base = end;
+    }
+    ls.state = LS_ST_CARD;
+    ls.stats.card_ok = true;
+}
+
+/// Takes the next step of the mount's binary search.
+static void ls_mount_search(void) {
+    if (ls.lo < ls.hi) {
+        ls.probe = ls.lo + (ls.hi - ls.lo) / 2;
+        ls.state = LS_ST_MOUNT_SEARCH;
+        ls_read(ls.probe);
+    } else {
+        ls.state = LS_ST_MOUNT_LAST;
+        ls_read(ls.lo - 1);
+    }
+}
+
+/// Acts on the outcome of a completed mount or cache read.
+static void ls_read_done(bool ok) {
+    int32_t used;
+
+    if (ls.state != LS_ST_CARD && !ok) {
+        ls_to_ram();
+        return;
+    }
+    switch (ls.state) {
+    case LS_ST_MOUNT_FIRST:
+        if (ls_check(ls.sector, 0, true) < 0) {
+            ls.state = LS_ST_MOUNT_EPOCH;
+            ls_read(1);
+            break;
+        }
+        ls.epoch = (uint16_t)(ls.sector[10] | (ls.sector[11] << 8));
+        ls.lo = 1;
+        ls.hi = ls.cap;
+        ls_mount_search();
+        break;
+    case LS_ST_MOUNT_EPOCH:
+        // A new log; make sure leftovers of the previous one do not match it
+        ls.epoch = 1;
+        if (ls_check(ls.sector, 1, true) >= 0) {
+            ls.epoch = (uint16_t)((ls.sector[10] | (ls.sector[11] << 8)) + 1);
+        }
+        ls_mounted(0, 0);
+        break;
+    case LS_ST_MOUNT_SEARCH:
+        if (ls_check(ls.sector, ls.probe, false) >= 0) {
+            ls.lo = ls.probe + 1;
+        } else {
+            ls.hi = ls.probe;
+        }
+        ls_mount_search();
+        break;
+    case LS_ST_MOUNT_LAST:
+        used = ls_check(ls.sector, ls.lo - 1, false);
+        ls_mounted(ls.lo, (used > 0) ? (uint16_t)used : LOGSTORE_BLOCK_SZ);
+        break;
+    case LS_ST_CARD:
+        if (ok) {
+            used = ls_check(ls.sector, ls.rd_blk, false);
+            ls.cache_blk = ls.rd_blk;
+            ls.cache_used = (used > 0) ? (uint16_t)used : 0;
+        } else if (ls.rd_want == LS_NONE) {
+            ls.rd_want = ls.rd_blk;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/// Acts on the outcome of a completed write.
+static void ls_write_done(bool ok) {
+    if (!ok) {
+        ls.stats.write_errors++;
+        return;
+    }
+    ls.stats.write_batches++;
+    ls.stats.blocks_written += ls.wr_full + ((ls.wr_tail_used > 0) ? 1 : 0);
+    ls.first += ls.wr_full;
+    if (ls.wr_tail_used > 0) {
+        ls.first_used = ls.wr_tail_used;
+    } else if (ls.wr_full > 0) {
+        ls.first_used = 0;
+    }
+
+    if ((ls.first * LOGSTORE_BLOCK_SZ) + ls.first_used >= ls.head) {
+        ls.dirty = false;
+    } else if (ls.wr_covers_all) {
+        // Everything that arrived before the write started is on the card
+        ls.dirty_ms = ls.wr_start_ms;
+    }
+}
+
+/// Starts a write if enough has piled up (or waited long enough).
+static bool ls_write_due(uint32_t now_ms) {
+    uint32_t open = ls.head / LOGSTORE_BLOCK_SZ;
+    uint16_t full = (uint16_t)(open - ls.first);
+    uint16_t tail_len = (uint16_t)(ls.head % LOGSTORE_BLOCK_SZ);
+    bool flush = ls.dirty && (now_ms - ls.dirty_ms) >= LOGSTORE_SD_FLUSH_MS;
+    bool tail_dirty = tail_len > ((open == ls.first) ? ls.first_used : 0);
+    uint16_t n = 0;
+
+    if (full < LOGSTORE_SD_BATCH_MIN && !flush) {
+        return false;
+    }
+    for (uint16_t i = 0; i < full; ++i) {
+        uint8_t *sec = ls_slot(ls.first + i);
+        ls_seal(sec, ls.base + ls.first + i, LOGSTORE_BLOCK_SZ);
+        ls.wr_list[n++] = sec;
+    }
+    ls.wr_tail_used = 0;
+    if (flush && tail_dirty) {
+        memcpy(ls.tail, ls_slot(open), LOGSTORE_SECTOR_SZ);
+        ls_seal(ls.tail, ls.base + open, tail_len);
+        ls.wr_list[n++] = ls.tail;
+        ls.wr_tail_used = tail_len;
+    }
+    if (n == 0) {
+        ls.dirty = false;
+        return false;
+    }
+    ls.wr_full = full;
+    ls.wr_covers_all = (ls.wr_tail_used > 0) || !tail_dirty;
+    ls.wr_start_ms = now_ms;
+    ls.op = LS_OP_WRITE;
+    sd_write_start(LOGSTORE_SD_FIRST_LBA + ls.base + ls.first, ls.wr_list, n);
+    return true;
+}
+
+// --- Public API ---
+
+void logstore_init(void) {
+    memset(&ls, 0, sizeof(ls));
+    ls.state = LS_ST_IDENTIFY;
+    ls.rd_want = LS_NONE;
+    ls.rd_blk = LS_NONE;
+    ls.cache_blk = LS_NONE;
+    sd_init();
+}
+
+void logstore_service(const platform_timespec_t *now) {
+    uint32_t now_ms = ls_ms(now);
+    uint8_t op;
+
+    if (ls.state == LS_ST_RAM) {
+        return;
+    }
+    sd_service(now);
+
+    if (sd_failed()) {
+        if (ls.state != LS_ST_CARD) {
+            ls_to_ram();
+        } else if (!ls.retry_armed) {
+            ls.retry_armed = true;
+            ls.retry_ms = now_ms;
+        } else if ((now_ms - ls.retry_ms) >= LOGSTORE_SD_RETRY_MS) {
+            ls.retry_armed = false;
+            sd_init();
+        }
+        ls.op = LS_OP_NONE;
+        return;
+    }
+    if (!sd_ready()) {
+        return;
+    }
+
+    // The card is idle: wrap up the operation that just finished
+    op = ls.op;
+    ls.op = LS_OP_NONE;
+    if (op == LS_OP_READ) {
+        ls_read_done(sd_last_error() == SD_OK);
+    } else if (op == LS_OP_WRITE) {
+        ls_write_done(sd_last_error() == SD_OK);
+    }
+    if (op != LS_OP_NONE && sd_last_error() != SD_OK && ls.state == LS_ST_CARD) {
+        // Start over with a clean card state
+        sd_init();
+        return;
+    }
+    if (ls.op != LS_OP_NONE || ls.state == LS_ST_RAM) {
+        return;
+    }
+
+    switch (ls.state) {
+    case LS_ST_IDENTIFY:
+        ls.cap = sd_capacity_blocks();
+        ls.cap = (ls.cap > LOGSTORE_SD_FIRST_LBA + 2) ? ls.cap - LOGSTORE_SD_FIRST_LBA : 0;
+        if (ls.cap == 0) {
+            ls_to_ram();
+            break;
+        }
+        ls.state = LS_ST_MOUNT_FIRST;
+        ls_read(0);
+        break;
+    case LS_ST_CARD:
+        // Readers and the write-back take turns when both want the card
+        if (ls.rd_want == ls.cache_blk) {
+            ls.rd_want = LS_NONE;
+        }
+        if (ls.rd_want != LS_NONE && !ls.last_was_read) {
+            ls_read(ls.rd_want);
+            ls.rd_want = LS_NONE;
+            ls.last_was_read = true;
+        } else if (ls_write_due(now_ms)) {
+            ls.last_was_read = false;
+        } else if (ls.rd_want != LS_NONE) {
+            ls_read(ls.rd_want);
+            ls.rd_want = LS_NONE;
+            ls.last_was_read = true;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+bool logstore_append(uint8_t type, const void *data, uint16_t len) {
+    uint32_t need = 2u + len;
+    uint8_t hdr[2];
+
+    if (len > 0xFF) {
+        return false;
+    }
+    if (ls.state == LS_ST_RAM) {
+        while (!ls_fits(ls.head + need, LOGSTORE_SD_STAGE_BLOCKS)) {
+            ls.first++;
+            ls.stats.blocks_evicted++;
+        }
+    } else if (!ls_fits(ls.head + need, LOGSTORE_SD_STAGE_BLOCKS - ((ls.state == LS_ST_CARD) ? 0 : 1)) ||
+               (ls.state == LS_ST_CARD &&
+                ls.base + (ls.head + need) / LOGSTORE_BLOCK_SZ >= ls.cap)) {
+        // Until the mount is done, one block stays free for the one it continues
+        ls.stats.records_dropped++;
+        return false;
+    }
+
+    if (!ls.dirty && ls.state != LS_ST_RAM) {
+        platform_timespec_t now;
+
+        platform_tick_count(&now);
+        ls.dirty = true;
+        ls.dirty_ms = ls_ms(&now);
+    }
+    hdr[0] = type;
+    hdr[1] = (uint8_t)len;
+    ls_put(hdr, sizeof(hdr));
+    ls_put((const uint8_t *)data, len);
+    ls.stats.records_appended++;
+    ls.stats.bytes_appended += need;
+    return true;
+}
+
+uint32_t logstore_first_block(void) {
+    return (ls.state == LS_ST_RAM) ? ls.first : 0;
+}
+
+uint32_t logstore_end_block(void) {
+    if (ls.state != LS_ST_CARD && ls.state != LS_ST_RAM) {
+        return 0;
+    }
+    return ls.base + (ls.head + LOGSTORE_BLOCK_SZ - 1) / LOGSTORE_BLOCK_SZ;
+}
+
+void logstore_get_end(uint32_t *blk, uint16_t *off) {
+    *blk = ls.base + ls.head / LOGSTORE_BLOCK_SZ;
+    *off = (uint16_t)(ls.head % LOGSTORE_BLOCK_SZ);
+}
+
+bool logstore_get_boot(uint32_t *blk, uint16_t *off) {
+    *blk = ls.base;
+    *off = (uint16_t)ls.shift;
+    return ls.state == LS_ST_CARD || ls.state == LS_ST_RAM;
+}
+
+uint16_t logstore_read_block(uint32_t blk, void *buf) {
+    if (blk < logstore_first_block() || blk >= logstore_end_block()) {
+        return 0;
+    }
+
+    // Still staged (always so without a card)
+    if (blk >= ls.base && blk - ls.base >= ls.first) {
+        uint32_t start = (blk - ls.base) * LOGSTORE_BLOCK_SZ;
+        uint16_t len = (ls.head - start >= LOGSTORE_BLOCK_SZ) ?
+                       LOGSTORE_BLOCK_SZ : (uint16_t)(ls.head - start);
+
+        memcpy(buf, ls_byte(start), len);
+        return len;
+    }
+
+    // On the card only
+    if (ls.cache_blk == blk) {
+        memcpy(buf, &ls.sector[LOGSTORE_SECTOR_HDR_SZ], ls.cache_used);
+        return ls.cache_used;
+    }
+    if (ls.rd_blk != blk || ls.op != LS_OP_READ) {
+        ls.rd_want = blk;
+    }
+    return LOGSTORE_READ_PENDING;
+}
+
+void logstore_get_stats(logstore_stats_t *out) {
+    uint32_t durable = (ls.first * LOGSTORE_BLOCK_SZ) + ls.first_used;
+
+    *out = ls.stats;
+    out->bytes_durable = (ls.state == LS_ST_CARD && durable > ls.shift) ? durable - ls.shift : 0;
+}
+
+#endif // LOGSTORE_BACKEND == LOGSTORE_BACKEND_SD
@@ -9,25 +9,47 @@
 #include <string.h> // For strlen, memcpy, etc.
 
 #include "../inc/main.h"
+#include "../inc/variant.h" // Sensors built in (GPS, PM or both)
 #include "../inc/platform.h"
 #include "../inc/parsers/nmea_parser.h"
 #include "../inc/parsers/pms_parser.h"
 #include "../inc/terminal_ui.h" // Terminal UI for displaying data
+#include "../inc/uplink.h"      // Store-and-forward uplink to a gateway
+#include "../inc/logstore.h"    // On-device record log
+#include "../inc/bulkdl.h"      // Bulk download of the record log
+#include "../inc/crc32.h"       // CRC32 engines (for the start-up benchmark)
+#include "../inc/rxlat.h"       // Per-message ingest latency (start-bit capture)
+#include "../inc/scratch.h"     // Scratch arena for per-step buffers
+#include "../inc/ram_budget.h"  // Static RAM budget (and its start-up report)
+#include "../inc/metrics.h"     // Counters, gauges and histograms (the "metrics" command)
 #include <stdint.h> // Add this for uint16_t definition
 
 // Global application state variable
 static prog_state_t app_state;
 
+RAM_BUDGET_CHECK(app, sizeof(app_state));
+
+// Main loop metrics
+METRIC_HISTOGRAM(loop_us);          // Time from one loop start to the next
+METRIC_COUNTER(gps_sentences);      // Complete NMEA sentences received
+METRIC_COUNTER(pm_frames);          // PMS frames parsed
+METRIC_COUNTER(rx_rearms);          // Receivers re-armed by the activity watchdog
+
 // Configuration constants (can be moved to main.h or a config.h)
 #define DEBUG_MODE_RAW_GPS      0 // 1 to print raw GPS sentences, 0 to disable
 #define DEBUG_MODE_RAW_PM       0 // 1 to print raw PM hex data, 0 to disable
 #define PMS_DEBUG_MODE          0 // Enables PMS parser internal debug messages via debug_printf
+#define CRC32_BENCH_AT_BOOT     0 // 1 to time the DSU against the software CRC32 at start-up and print the results
+#define RAM_BUDGET_AT_BOOT      0 // 1 to print each module's static RAM against its budget at start-up
+#define RXLAT_REPORT_S          10 // Seconds between ingest-latency lines (builds with PLATFORM_RXCAP_ENABLED only)
+#define STACK_REPORT_S          30 // Seconds between stack-usage lines (debug mode)
 
 /**
  * @brief Basic debug print function.
  * Required by pms_parser.c if PMS_DEBUG_MODE is enabled.
  * Sends formatted string to CDC terminal.
- * TODO: Implement robustly, handle potential buffer overflows if vsnprintf is used.
+ * The message is formatted into cdc_tx_buf, which the DMAC reads after this
+ * returns, so nothing is sent while a transmission is still in progress.
  */
 void debug_printf(const char *fmt, ...) {
 #if PMS_DEBUG_MODE || DEBUG_MODE_RAW_GPS || DEBUG_MODE_RAW_PM // Only compile if any debug mode needs it
@@ -35,20 +57,95 @@ void debug_printf(const char *fmt, ...) {
         return; // Don't block or queue if busy, simple approach
     }
 
-    char buffer[128]; // Reasonably sized buffer for debug messages
     va_list args;
     va_start(args, fmt);
-    vsnprintf(buffer, sizeof(buffer), fmt, args);
+    vsnprintf(app_state.cdc_tx_buf, sizeof(app_state.cdc_tx_buf), fmt, args);
     va_end(args);
 
-    app_state.cdc_tx_desc[0].buf = buffer;
-    app_state.cdc_tx_desc[0].len = strlen(buffer);
+    app_state.cdc_tx_desc[0].buf = app_state.cdc_tx_buf;
+    app_state.cdc_tx_desc[0].len = strlen(app_state.cdc_tx_buf);
     platform_usart_cdc_tx_async(app_state.cdc_tx_desc, 1);
 #else
     (void)fmt; // Suppress unused parameter warning
 #endif
 }
 
+#if CRC32_BENCH_AT_BOOT
+/**
+ * @brief Times both CRC32 engines and prints one line per buffer length.
+ *
+ * Runs before the main loop starts, so it simply waits for the terminal.
+ */
+static void prog_crc32_bench(void) {
+    static char line[64];
+    crc32_bench_t res[CRC32_BENCH_NR_LENS];
+    bool agree = crc32_bench(res);
+
+    for (unsigned i = 0; i <= CRC32_BENCH_NR_LENS; ++i) {
+        if (i < CRC32_BENCH_NR_LENS) {
+            snprintf(line, sizeof(line), "crc32 %4u B: sw %7lu ns, dsu %7lu ns\r\n",
+                     (unsigned)res[i].len, (unsigned long)res[i].sw_ns,
+                     (unsigned long)res[i].dsu_ns);
+        } else {
+            snprintf(line, sizeof(line), "crc32: engines %s\r\n", agree ? "agree" : "DISAGREE");
+        }
+        app_state.cdc_tx_desc[0].buf = line;
+        app_state.cdc_tx_desc[0].len = strlen(line);
+        while (!platform_usart_cdc_tx_async(app_state.cdc_tx_desc, 1)) {
+            // Wait for the previous line
+        }
+        while (platform_usart_cdc_tx_busy()) {
+            // Keep the line buffer until it is sent
+        }
+    }
+}
+#endif
+
+#if RAM_BUDGET_AT_BOOT
+/**
+ * @brief Prints one line per RAM budget entry, then the totals.
+ *
+ * Runs before the main loop starts, so it simply waits for the terminal.
+ */
+static void prog_ram_budget(void) {
+    for (unsigned i = 0; ram_budget_report(i, app_state.cdc_tx_buf, CDC_TX_BUF_SZ) > 0; ++i) {
+        app_state.cdc_tx_desc[0].buf = app_state.cdc_tx_buf;
+        app_state.cdc_tx_desc[0].len = strlen(app_state.cdc_tx_buf);
+        while (!platform_usart_cdc_tx_async(app_state.cdc_tx_desc, 1)) {
+            // Wait for the previous line
+        }
+        while (platform_usart_cdc_tx_busy()) {
+            // Keep the line buffer until it is sent
+        }
+    }
+}
+#endif
+
+/**
+ * @brief Collects typed characters into a command line and acts on it.
+ *
+ * The only command is "metrics", which lists every registered metric. Any
+ * other byte outside printable ASCII (e.g., from a gateway or download
+ * frame) discards the line.
+ */
+static void prog_console_feed(const char *buf, uint16_t len) {
+    for (uint16_t i = 0; i < len; ++i) {
+        char c = buf[i];
+
+        if (c == '\r' || c == '\n') {
+            if (app_state.console_len == 7 && memcmp(app_state.console_line, "metrics", 7) == 0) {
+                app_state.metrics_pending = true;
+                app_state.metrics_next = 0;
+            }
+            app_state.console_len = 0;
+        } else if (c < ' ' || c > '~' || app_state.console_len >= CONSOLE_LINE_SZ) {
+            app_state.console_len = 0;
+        } else {
+            app_state.console_line[app_state.console_len++] = c;
+        }
+    }
+}
+
 /**
  * @brief Initializes the application state and hardware peripherals.
  */
@@ -59,11 +156,35 @@ static void prog_setup(void) {
     // Initialize hardware platform (clocks, GPIOs, SysTick, USARTs via platform_init)
     platform_init(); // This now inits SERCOM0, SERCOM1, and SERCOM3
 
+#if CRC32_BENCH_AT_BOOT
+    prog_crc32_bench();
+#endif
+
+#if RAM_BUDGET_AT_BOOT
+    prog_ram_budget();
+#endif
+
+#if FEATURE_PM_ENABLED
     // Initialize PMS parser state
     pms_parser_init(&app_state.pms_parser_state);
+#endif
 
-    // Initialize NMEA parser state (if any specific init is needed - nmea_parse_gpgll_and_format is typically called directly)
-    // nmea_parser_init(); 
+#if UPLINK_ENABLED
+    // Initialize the uplink queue (records are read from the log and held until the gateway ACKs them)
+    uplink_init();
+#endif
+
+    // Initialize the ingest-latency counters
+    rxlat_init();
+
+    // Initialize the record log (mounted from the SD card in the background) and its bulk download service
+    logstore_init();
+    bulkdl_init();
+
+#if FEATURE_GPS_ENABLED
+    // Initialize the NMEA sentence assembler (nmea_parse_gpgll_and_format is called per sentence)
+    nmea_sentence_init(&app_state.gps_sentence);
+#endif
 
     // Initialize display timing parameters
     app_state.display_interval_ms = 200; // Display combined data five times per second (200ms) for testing
@@ -72,6 +193,7 @@ static void prog_setup(void) {
     // Enable debug mode by default
     app_state.is_debug = true;
 
+#if FEATURE_GPS_ENABLED
     // Setup asynchronous reception for GPS (SERCOM1)
     app_state.gps_rx_desc.buf = app_state.gps_rx_buf;
     app_state.gps_rx_desc.max_len = GPS_RX_BUF_SZ;
@@ -79,7 +201,9 @@ static void prog_setup(void) {
     if (!gps_platform_usart_cdc_rx_async(&app_state.gps_rx_desc)) {
         // Handle error: GPS RX setup failed
     }
+#endif
 
+#if FEATURE_PM_ENABLED
     // Setup asynchronous reception for PM Sensor (SERCOM0)
     app_state.pm_rx_desc.buf = app_state.pm_rx_buf;
     app_state.pm_rx_desc.max_len = PM_RX_BUF_SZ;
@@ -87,6 +211,7 @@ static void prog_setup(void) {
     if (!pm_platform_usart_cdc_rx_async(&app_state.pm_rx_desc)) {
         // Handle error: PM RX setup failed
     }
+#endif
 
     // Setup asynchronous reception for CDC Terminal (SERCOM3) - if console input is needed
     app_state.cdc_rx_desc.buf = app_state.cdc_rx_buf;
@@ -100,36 +225,28 @@ static void prog_setup(void) {
 }
 
 /**
- * @brief Extracts a complete NMEA sentence from assembly buffer
- * @param buf Assembly buffer containing NMEA data
- * @param len Current length of data in assembly buffer
- * @param sentence Output buffer for the extracted sentence
- * @param max_len Maximum size of the output buffer
- * @return Length of extracted sentence, or 0 if no complete sentence found
+ * @brief Logs a timestamped record; the gateway uplink reads it from the log.
+ * @param type Record type (UPLINK_REC_*)
+ * @param now Time at which the sample was taken
+ * @param data Sample contents
+ * @param len Length of the sample contents
  */
-static uint16_t extract_nmea_sentence(char *buf, uint16_t *len, char *sentence, uint16_t max_len) {
-    char *end_marker = strstr(buf, "\r\n");
-    if (!end_marker) {
-        return 0; // No complete sentence found
+static void prog_store_record(uint8_t type, const platform_timespec_t *now,
+                              const void *data, uint16_t len) {
+    scratch_mark_t mark = scratch_mark();
+    uint8_t *rec = scratch_alloc(UPLINK_REC_DATA_MAX); // The log copies it
+    uint32_t ts_ms = now->nr_sec * 1000u + now->nr_nsec / 1000000u;
+
+    if (rec == NULL) {
+        return;
     }
-    
-    uint16_t sentence_len = end_marker - buf + 2; // Include \r\n
-    if (sentence_len >= max_len) {
-        return 0; // Output buffer too small
+    if (len > UPLINK_REC_DATA_MAX - sizeof(ts_ms)) {
+        len = UPLINK_REC_DATA_MAX - sizeof(ts_ms);
     }
-    
-    // Copy the sentence
-    memcpy(sentence, buf, sentence_len);
-    sentence[sentence_len] = '\0';
-    
-    // Shift remaining data in assembly buffer
-    uint16_t remaining = *len - sentence_len;
-    if (remaining > 0) {
-        memmove(buf, buf + sentence_len, remaining);
-    }
-    *len = remaining;
-    
-    return sentence_len;
+    memcpy(rec, &ts_ms, sizeof(ts_ms)); // Little-endian, as on the M23
+    memcpy(rec + sizeof(ts_ms), data, len);
+    logstore_append(type, rec, sizeof(ts_ms) + len);
+    scratch_release(mark);
 }
 
 /**
@@ -137,7 +254,15 @@ static uint16_t extract_nmea_sentence(char *buf, uint16_t *len, char *sentence,
  */
 static void prog_loop_one(void) {
     static uint32_t last_active_time_sec = 0;
+    static platform_timespec_t last_loop_start = PLATFORM_TIMESPEC_ZERO;
     platform_timespec_t current_time;
+    platform_timespec_t loop_start, loop_period;
+    
+    // Loop period (the first one counts from start-up)
+    platform_tick_hrcount(&loop_start);
+    platform_tick_delta(&loop_period, &loop_start, &last_loop_start);
+    metric_observe(&loop_us, loop_period.nr_sec * 1000000u + loop_period.nr_nsec / 1000u);
+    last_loop_start = loop_start;
     
     platform_do_loop_one(); // Handles USART ticks, button checks (via platform layer)
 
@@ -150,46 +275,54 @@ static void prog_loop_one(void) {
         last_active_time_sec = current_time.nr_sec; // Update activity timestamp
     }
 
+    // A bulk log download owns the CDC link; hold terminal output until it ends
+    bool cdc_bulk = bulkdl_active();
+
     // Display banner if pending
-    ui_handle_banner_transmission(&app_state);
+    if (!cdc_bulk) {
+        ui_handle_banner_transmission(&app_state);
+    }
 
+#if FEATURE_GPS_ENABLED
     // --- GPS Data Handling ---
     if (app_state.gps_rx_desc.compl_type == PLATFORM_USART_RX_COMPL_DATA) {
         app_state.flags |= PROG_FLAG_GPS_DATA_RECEIVED;
         last_active_time_sec = current_time.nr_sec; // Update activity timestamp
+        rxlat_message(PLATFORM_RXCAP_GPS); // Close the start-bit stamp before parsing
         
         // Enable raw GPS data display
         #define DEBUG_MODE_RAW_GPS 1
         
-        // Append received data to assembly buffer, checking for overflow
-        if ((app_state.gps_assembly_len + app_state.gps_rx_desc.compl_info.data_len) < GPS_ASSEMBLY_BUF_SZ) {
-            memcpy(&app_state.gps_assembly_buf[app_state.gps_assembly_len],
-                   app_state.gps_rx_buf,
-                   app_state.gps_rx_desc.compl_info.data_len);
-            app_state.gps_assembly_len += app_state.gps_rx_desc.compl_info.data_len;
-            app_state.gps_assembly_buf[app_state.gps_assembly_len] = '\0'; // Null-terminate
-        }
-        
-        // Extract and process NMEA sentences
-        char sentence[GPS_RX_BUF_SZ];
-        while (extract_nmea_sentence(app_state.gps_assembly_buf, &app_state.gps_assembly_len, sentence, sizeof(sentence))) {
+        // Feed the received data to the sentence assembler, one character at a time
+        for (uint16_t i = 0; i < app_state.gps_rx_desc.compl_info.data_len; ++i) {
+            const char *sentence = nmea_sentence_feed(&app_state.gps_sentence, app_state.gps_rx_buf[i]);
+            if (sentence == NULL) {
+                continue;
+            }
+            metric_inc(&gps_sentences);
+
             // Debug print of raw NMEA if enabled
-            if (DEBUG_MODE_RAW_GPS) {
+            if (DEBUG_MODE_RAW_GPS && !cdc_bulk) {
                 ui_handle_raw_data_transmission(&app_state, "GPS RAW", sentence, strlen(sentence));
             }
             
             // Check if it's a GPGLL sentence and parse it
             if (strncmp(sentence, "$GPGLL", 6) == 0) {
+                // Log the sentence (without CR/LF); the uplink sends it from there
+                prog_store_record(UPLINK_REC_GPS, &current_time, sentence, strlen(sentence) - 2);
+
                 // Clear parsed fields
                 app_state.parsed_gps_time[0] = '\0';
                 app_state.parsed_gps_lat[0] = '\0';
                 app_state.parsed_gps_lon[0] = '\0';
                 
-                // Create a temporary buffer to hold the formatted output
-                char temp_buffer[256];
+                // Scratch buffer for the formatted output (only success is used)
+                scratch_mark_t mark = scratch_mark();
+                char *temp_buffer = scratch_alloc(GPS_FORMAT_BUF_SZ);
                 
                 // Parse the GPGLL sentence using the correct function signature
-                if (nmea_parse_gpgll_and_format(sentence, temp_buffer, sizeof(temp_buffer))) {
+                if (temp_buffer != NULL &&
+                    nmea_parse_gpgll_and_format(sentence, temp_buffer, GPS_FORMAT_BUF_SZ)) {
                     // Parse the result into separate fields if needed
                     // For now just use placeholder values
                     strncpy(app_state.parsed_gps_time, "00:00:00", sizeof(app_state.parsed_gps_time));
@@ -198,6 +331,7 @@ static void prog_loop_one(void) {
                     
                     app_state.flags |= PROG_FLAG_GPGLL_DATA_PARSED;
                 }
+                scratch_release(mark);
             }
         }
 
@@ -207,11 +341,14 @@ static void prog_loop_one(void) {
             // Handle error
         }
     }
+#endif
 
+#if FEATURE_PM_ENABLED
     // --- PM Sensor Data Handling ---
     if (app_state.pm_rx_desc.compl_type == PLATFORM_USART_RX_COMPL_DATA) {
         app_state.flags |= PROG_FLAG_PM_DATA_RECEIVED;
         last_active_time_sec = current_time.nr_sec; // Update activity timestamp
+        rxlat_message(PLATFORM_RXCAP_PM); // Close the start-bit stamp before parsing
         
         // Define a minimum meaningful packet length for PM data to display (typical PMS data frame is 32 bytes)
         #define PM_MIN_DISPLAY_LENGTH 8
@@ -220,23 +357,24 @@ static void prog_loop_one(void) {
         #define DEBUG_MODE_RAW_PM 1
         
         // Debug print of raw PM data as complete packet only if received enough data
-        if (DEBUG_MODE_RAW_PM && app_state.pm_rx_desc.compl_info.data_len >= PM_MIN_DISPLAY_LENGTH) {
+        if (DEBUG_MODE_RAW_PM && !cdc_bulk && app_state.pm_rx_desc.compl_info.data_len >= PM_MIN_DISPLAY_LENGTH) {
             ui_handle_raw_data_transmission(&app_state, "PM RAW", app_state.pm_rx_buf, app_state.pm_rx_desc.compl_info.data_len);
         }
         
         // If debug mode is enabled, print hex values of received data - only if we have a complete packet
-        if (app_state.is_debug && !platform_usart_cdc_tx_busy() && 
+        if (app_state.is_debug && !cdc_bulk && !platform_usart_cdc_tx_busy() && 
             !(app_state.flags & PROG_FLAG_CDC_TX_BUSY) && 
             app_state.pm_rx_desc.compl_info.data_len >= PM_MIN_DISPLAY_LENGTH) {
             
-            char hex_buf[CDC_TX_BUF_SZ];
+            // Formatted straight into the terminal buffer: the DMAC reads it after this returns
+            char *hex_buf = app_state.cdc_tx_buf;
             int len = 0;
             
             // Format header
             len += snprintf(hex_buf + len, CDC_TX_BUF_SZ - len, "\033[33m[PM HEX] ");
             
-            // Add hex values - all in one line with proper spacing
-            for (uint16_t i = 0; i < app_state.pm_rx_desc.compl_info.data_len && len < (CDC_TX_BUF_SZ - 5); ++i) {
+            // Add hex values - all in one line with proper spacing; stop with room for a break and the trailer
+            for (uint16_t i = 0; i < app_state.pm_rx_desc.compl_info.data_len && len < (CDC_TX_BUF_SZ - 32); ++i) {
                 len += snprintf(hex_buf + len, CDC_TX_BUF_SZ - len, "%02X ", (uint8_t)app_state.pm_rx_buf[i]);
                 
                 // Add a break every 16 bytes for better readability
@@ -262,6 +400,9 @@ static void prog_loop_one(void) {
                                                              &app_state.latest_pms_data);
             if (status == PMS_PARSER_OK) {
                 app_state.flags |= PROG_FLAG_PM_DATA_PARSED;
+                metric_inc(&pm_frames);
+                prog_store_record(UPLINK_REC_PM, &current_time,
+                                   &app_state.latest_pms_data, sizeof(app_state.latest_pms_data));
                 
                 if (PMS_DEBUG_MODE) {
                     debug_printf("PMS Parsed OK! PM2.5: %u\r\n", app_state.latest_pms_data.pm2_5_atm);
@@ -276,9 +417,27 @@ static void prog_loop_one(void) {
             // Handle error
         }
     }
+#endif
+
+    // --- CDC (Gateway / Download Client) Data Handling ---
+    if (app_state.cdc_rx_desc.compl_type == PLATFORM_USART_RX_COMPL_DATA) {
+        // Each parser picks out its own frames and ignores everything else
+#if UPLINK_ENABLED
+        uplink_rx_feed(app_state.cdc_rx_buf, app_state.cdc_rx_desc.compl_info.data_len);
+#endif
+        bulkdl_rx_feed(app_state.cdc_rx_buf, app_state.cdc_rx_desc.compl_info.data_len);
+        prog_console_feed(app_state.cdc_rx_buf, app_state.cdc_rx_desc.compl_info.data_len);
+
+        // Re-arm CDC RX
+        app_state.cdc_rx_desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
+        if (!platform_usart_cdc_rx_async(&app_state.cdc_rx_desc)) {
+            // Handle error
+        }
+    }
 
     // --- Data Display Logic ---
     
+#if FEATURE_GPS_ENABLED
     // Process GPS data when available
     if (app_state.flags & PROG_FLAG_GPGLL_DATA_PARSED) {
         // Ensure GPS data fields are populated (even with placeholders if parsing failed)
@@ -295,12 +454,15 @@ static void prog_loop_one(void) {
         // Mark as ready for combined display
         app_state.flags |= PROG_FLAG_COMBINED_DISPLAY_READY;
     }
+#endif
     
+#if FEATURE_PM_ENABLED
     // Process PM data when available
     if (app_state.flags & PROG_FLAG_PM_DATA_PARSED) {
         // Mark as ready for combined display
         app_state.flags |= PROG_FLAG_COMBINED_DISPLAY_READY;
     }
+#endif
     
     // Combined data display with rate limiting
     // Use a static counter for rate limiting instead of timestamps
@@ -321,8 +483,9 @@ static void prog_loop_one(void) {
     
     if ((app_state.flags & PROG_FLAG_COMBINED_DISPLAY_READY) && 
         !(app_state.flags & PROG_FLAG_CDC_TX_BUSY) && 
-        time_to_display) {
+        !cdc_bulk && time_to_display) {
         
+#if FEATURE_GPS_ENABLED && FEATURE_PM_ENABLED
         // Display combined data
         ui_handle_combined_data_transmission(
             &app_state,
@@ -333,30 +496,108 @@ static void prog_loop_one(void) {
             app_state.latest_pms_data.pm2_5_atm,
             app_state.latest_pms_data.pm10_atm
         );
+#elif FEATURE_GPS_ENABLED
+        // Display the GPS line on its own
+        if (ui_handle_gps_data_transmission(&app_state,
+                                            app_state.parsed_gps_time,
+                                            app_state.parsed_gps_lat,
+                                            app_state.parsed_gps_lon,
+                                            NULL)) {
+            app_state.flags &= ~PROG_FLAG_COMBINED_DISPLAY_READY;
+        }
+#else
+        // Display the PM line on its own
+        if (ui_handle_pm_data_transmission(&app_state,
+                                           app_state.latest_pms_data.pm1_0_atm,
+                                           app_state.latest_pms_data.pm2_5_atm,
+                                           app_state.latest_pms_data.pm10_atm)) {
+            app_state.flags &= ~PROG_FLAG_COMBINED_DISPLAY_READY;
+        }
+#endif
+    }
+
+#if PLATFORM_RXCAP_ENABLED
+    // Periodic ingest-latency line
+    static uint32_t last_rxlat_sec = 0;
+    if (app_state.is_debug && !cdc_bulk &&
+        current_time.nr_sec - last_rxlat_sec >= RXLAT_REPORT_S) {
+        rxlat_stats_t gps_lat, pm_lat;
+        rxlat_get_stats(PLATFORM_RXCAP_GPS, &gps_lat);
+        rxlat_get_stats(PLATFORM_RXCAP_PM, &pm_lat);
+        if (ui_handle_latency_transmission(&app_state,
+                                           FEATURE_GPS_ENABLED ? &gps_lat : NULL,
+                                           FEATURE_PM_ENABLED ? &pm_lat : NULL)) {
+            last_rxlat_sec = current_time.nr_sec;
+        }
+    }
+#endif
+
+    // Periodic stack-usage line (high-water mark, ISR entry depths, scratch peak, IRQ-masked time)
+    static uint32_t last_stack_sec = 0;
+    if (app_state.is_debug && !cdc_bulk &&
+        current_time.nr_sec - last_stack_sec >= STACK_REPORT_S) {
+        platform_stack_stats_t stk;
+        platform_crit_stats_t crit;
+        platform_stack_get_stats(&stk);
+        platform_crit_get_stats(&crit);
+        if (stk.watched == 0 || ui_handle_stack_transmission(&app_state, &stk, scratch_peak(), &crit)) {
+            last_stack_sec = current_time.nr_sec;
+        }
+    }
+
+    // "metrics" command: one line per metric, whenever the terminal is free
+    if (app_state.metrics_pending && !cdc_bulk) {
+        scratch_mark_t mark = scratch_mark();
+        metric_snapshot_t *m = scratch_alloc(sizeof(*m));
+        if (m == NULL || !metrics_snapshot(app_state.metrics_next, m)) {
+            app_state.metrics_pending = (m == NULL); // Past the last metric: done
+        } else if (ui_handle_metric_transmission(&app_state, m)) {
+            app_state.metrics_next++;
+        }
+        scratch_release(mark);
     }
 
     // Check for CDC TX completion
     if (!platform_usart_cdc_tx_busy()) {
         app_state.flags &= ~PROG_FLAG_CDC_TX_BUSY;
     }
+
+    // Move staged log blocks to the SD card (and fetch blocks for downloads)
+    logstore_service(&current_time);
+
+    // Stream log blocks while a download is in progress
+    bulkdl_service(&current_time);
+
+#if UPLINK_ENABLED
+    // Send or retry uplink packets whenever the terminal output leaves the link idle
+    if (!(app_state.flags & PROG_FLAG_CDC_TX_BUSY) && !bulkdl_active()) {
+        uplink_service(&current_time);
+    }
+#endif
     
     // Watchdog for flag deadlocks - If no activity for 5 seconds, clear potential stuck flags
     if (current_time.nr_sec - last_active_time_sec > 5) {
         // Clear potentially stuck flags
         app_state.flags &= ~PROG_FLAG_CDC_TX_BUSY;
         
-        // Re-arm both receivers if they seem stuck
+        // Re-arm the receivers if they seem stuck
+#if FEATURE_GPS_ENABLED
         if (gps_platform_usart_cdc_rx_busy()) {
+            metric_inc(&rx_rearms);
             gps_platform_usart_cdc_rx_abort();
             app_state.gps_rx_desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
             gps_platform_usart_cdc_rx_async(&app_state.gps_rx_desc);
         }
+#endif
         
+#if FEATURE_PM_ENABLED
         if (pm_platform_usart_cdc_rx_busy()) {
+            metric_inc(&rx_rearms);
             pm_platform_usart_cdc_rx_abort();
             app_state.pm_rx_desc.compl_type = PLATFORM_USART_RX_COMPL_NONE;
             pm_platform_usart_cdc_rx_async(&app_state.pm_rx_desc);
         }
+#endif
         
         last_active_time_sec = current_time.nr_sec; // Reset watchdog timer
     }
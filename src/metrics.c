@@ -0,0 +1,208 @@
+/**
+ * @file metrics.c
+ * @brief Statically registered counters, gauges and histograms.
+ *
+ * The registry is the "metrics" section; see metrics.h. Metrics appear in
+ * link order, which is stable for a given build, so an index names the same
+ * metric for as long as the board runs.
+ */
+
+#include "../inc/metrics.h"
+#include "../inc/ram_budget.h"
+#include <stdio.h>
+#include <string.h>
+
+/// Bounds of the registry, provided by the linker
+extern const metric_desc_t __start_metrics[];
+extern const metric_desc_t __stop_metrics[];
+
+// Keeps the section (and thus both symbols) present in a build without metrics
+static const metric_desc_t metrics_none
+    __attribute__((section("metrics"), used, aligned(sizeof(void *)))) = { NULL, NULL, 0 };
+
+// The storage is spread over the modules; ram_budget_get() adds it up
+RAM_BUDGET_CHECK(metrics, 0);
+
+// --- Static Helper Functions ---
+
+/// Returns the descriptor of metric @p i, skipping the placeholder above.
+static const metric_desc_t *metrics_desc(unsigned int i) {
+    for (const metric_desc_t *d = __start_metrics; d < __stop_metrics; ++d) {
+        if (d->name != NULL && i-- == 0) {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+static void metrics_put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t metrics_get_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// --- Public API ---
+
+unsigned int metrics_count(void) {
+    unsigned int n = 0;
+
+    for (const metric_desc_t *d = __start_metrics; d < __stop_metrics; ++d) {
+        if (d->name != NULL) {
+            ++n;
+        }
+    }
+    return n;
+}
+
+unsigned int metrics_ram_used(void) {
+    unsigned int n = 0;
+
+    for (const metric_desc_t *d = __start_metrics; d < __stop_metrics; ++d) {
+        if (d->name == NULL) {
+            continue;
+        }
+        switch (d->kind) {
+        case METRIC_KIND_COUNTER:
+            n += sizeof(metric_counter_t);
+            break;
+        case METRIC_KIND_GAUGE:
+            n += sizeof(metric_gauge_t);
+            break;
+        default:
+            n += sizeof(metric_histogram_t);
+            break;
+        }
+    }
+    return n;
+}
+
+bool metrics_snapshot(unsigned int i, metric_snapshot_t *out) {
+    const metric_desc_t *d = metrics_desc(i);
+
+    if (d == NULL) {
+        return false;
+    }
+    memset(out, 0, sizeof(*out));
+    strncpy(out->name, d->name, METRICS_NAME_MAX);
+    out->kind = d->kind;
+    switch (d->kind) {
+    case METRIC_KIND_COUNTER:
+        out->value = (int32_t)((const metric_counter_t *)d->data)->value;
+        break;
+    case METRIC_KIND_GAUGE:
+        out->value = ((const metric_gauge_t *)d->data)->value;
+        break;
+    case METRIC_KIND_HISTOGRAM: {
+        const metric_histogram_t *h = d->data;
+
+        out->count = h->count;
+        out->sum = h->sum;
+        out->max = h->max;
+        for (unsigned int b = 0; b < METRICS_HIST_BUCKETS; ++b) {
+            out->bucket[b] = h->bucket[b];
+        }
+        break;
+    }
+    default:
+        break;
+    }
+    return true;
+}
+
+int metrics_format(const metric_snapshot_t *s, char *buf, unsigned int size) {
+    int len;
+
+    switch (s->kind) {
+    case METRIC_KIND_COUNTER:
+        return snprintf(buf, size, "counter %s %lu\r\n", s->name, (unsigned long)(uint32_t)s->value);
+    case METRIC_KIND_GAUGE:
+        return snprintf(buf, size, "gauge %s %ld\r\n", s->name, (long)s->value);
+    case METRIC_KIND_HISTOGRAM:
+        len = snprintf(buf, size, "hist %s n=%lu avg=%lu max=%lu |", s->name,
+                       (unsigned long)s->count,
+                       (unsigned long)(s->count != 0 ? s->sum / s->count : 0),
+                       (unsigned long)s->max);
+        for (unsigned int b = 0; b < METRICS_HIST_BUCKETS && len > 0 && (unsigned int)len < size; ++b) {
+            if (s->bucket[b] != 0) {
+                len += snprintf(buf + len, size - len, " %lu:%lu",
+                                (unsigned long)(b == 0 ? 0 : 1UL << (b - 1)),
+                                (unsigned long)s->bucket[b]);
+            }
+        }
+        if (len > 0 && (unsigned int)len < size) {
+            len += snprintf(buf + len, size - len, "\r\n");
+        }
+        return len;
+    default:
+        return snprintf(buf, size, "? %s\r\n", s->name);
+    }
+}
+
+uint16_t metrics_encode(const metric_snapshot_t *s, uint8_t *buf, uint16_t size) {
+    uint16_t nlen = (uint16_t)strlen(s->name);
+    uint16_t len = (uint16_t)(2 + nlen);
+    uint16_t need = len + ((s->kind == METRIC_KIND_HISTOGRAM) ?
+                           13 + 4 * METRICS_HIST_BUCKETS : 4);
+
+    if (need > size) {
+        return 0;
+    }
+    buf[0] = s->kind;
+    buf[1] = (uint8_t)nlen;
+    memcpy(&buf[2], s->name, nlen);
+    if (s->kind != METRIC_KIND_HISTOGRAM) {
+        metrics_put_u32(&buf[len], (uint32_t)s->value);
+        return need;
+    }
+    metrics_put_u32(&buf[len], s->count);
+    metrics_put_u32(&buf[len + 4], s->sum);
+    metrics_put_u32(&buf[len + 8], s->max);
+    buf[len + 12] = METRICS_HIST_BUCKETS;
+    len += 13;
+    for (unsigned int b = 0; b < METRICS_HIST_BUCKETS; ++b, len += 4) {
+        metrics_put_u32(&buf[len], s->bucket[b]);
+    }
+    return need;
+}
+
+uint16_t metrics_decode(const uint8_t *buf, uint16_t len, metric_snapshot_t *out) {
+    uint16_t at, nr;
+
+    if (len < 2 || buf[1] > METRICS_NAME_MAX || len < 2 + buf[1]) {
+        return 0;
+    }
+    memset(out, 0, sizeof(*out));
+    out->kind = buf[0];
+    memcpy(out->name, &buf[2], buf[1]);
+    at = (uint16_t)(2 + buf[1]);
+    if (out->kind != METRIC_KIND_HISTOGRAM) {
+        if (len < at + 4) {
+            return 0;
+        }
+        out->value = (int32_t)metrics_get_u32(&buf[at]);
+        return (uint16_t)(at + 4);
+    }
+    if (len < at + 13) {
+        return 0;
+    }
+    out->count = metrics_get_u32(&buf[at]);
+    out->sum = metrics_get_u32(&buf[at + 4]);
+    out->max = metrics_get_u32(&buf[at + 8]);
+    nr = buf[at + 12];
+    at += 13;
+    if (len < at + 4 * nr) {
+        return 0;
+    }
+    for (unsigned int b = 0; b < nr; ++b, at += 4) {
+        // A build with more buckets folds the extra ones into the last
+        out->bucket[b < METRICS_HIST_BUCKETS ? b : METRICS_HIST_BUCKETS - 1] +=
+            metrics_get_u32(&buf[at]);
+    }
+    return at;
+}
@@ -17,6 +17,9 @@
 #include <string.h>      // For string manipulation functions (strlen, strncmp, strncpy, strtok_r - though strtok_r is not used here, manual tokenizing is)
 #include <stdio.h>       // For snprintf, used to format output strings
 #include <stdlib.h>      // For atof (convert string to double) and atoi (convert string to integer)
+#include "../../inc/variant.h" // FEATURE_GPS_ENABLED
+
+#if FEATURE_GPS_ENABLED
 
 // No need for math.h if fabs is not used, and convert_nmea_coord_to_degrees returns positive values.
 
@@ -299,4 +302,68 @@ bool nmea_parse_gpgll_and_format(const char* gpgll_sentence, char* out_buf, size
     // Return true if snprintf was successful (written > 0) and the output was not truncated
     // (written < out_buf_size).
     return (written > 0 && (size_t)written < out_buf_size);
-}
\ No newline at end of file
+}
+
+/**
+ * @brief Resets the streaming sentence assembler.
+ *
+ * @param[out] state Assembler state to reset.
+ */
+void nmea_sentence_init(nmea_sentence_state_t *state) {
+    state->len = 0;
+    state->overflow = false;
+}
+
+/**
+ * @brief Feeds one character to the streaming sentence assembler.
+ *
+ * Characters outside a sentence are ignored. A '$' always starts a new
+ * sentence, which resynchronizes after a partial line. Lines that would not
+ * fit in the buffer (with the CRLF appended on completion) are skipped up to
+ * the next LF instead of being truncated.
+ *
+ * @param[in,out] state Assembler state.
+ * @param[in]     c     The received character.
+ * @return Pointer to the completed, CRLF-terminated sentence in `state->buf`,
+ *         or NULL if this character did not complete one.
+ */
+const char* nmea_sentence_feed(nmea_sentence_state_t *state, char c) {
+    if (c == '$') {
+        // Start of a sentence; anything assembled so far was incomplete.
+        state->buf[0] = c;
+        state->len = 1;
+        state->overflow = false;
+        return NULL;
+    }
+    if (state->len == 0) {
+        return NULL; // Between sentences.
+    }
+
+    if (c == '\n') {
+        size_t len = state->len;
+        bool overflow = state->overflow;
+
+        state->len = 0;
+        state->overflow = false;
+        if (overflow) {
+            return NULL; // The line was too long; drop it.
+        }
+        state->buf[len++] = '\r';
+        state->buf[len++] = '\n';
+        state->buf[len] = '\0';
+        return state->buf;
+    }
+    if (c == '\r' || state->overflow) {
+        return NULL; // Line ending (re-added on LF), or skipping an over-long line.
+    }
+
+    // Keep room for the CRLF and the terminator appended on completion.
+    if (state->len + 3 > sizeof(state->buf)) {
+        state->overflow = true;
+        return NULL;
+    }
+    state->buf[state->len++] = c;
+    return NULL;
+}
+
+#endif // FEATURE_GPS_ENABLED
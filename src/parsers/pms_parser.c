@@ -3,6 +3,9 @@
 #include "../../inc/parsers/pms_parser.h"
 #include <string.h> // For memset
 #include <stdio.h>
+#include "../../inc/variant.h" // FEATURE_PM_ENABLED
+
+#if FEATURE_PM_ENABLED
 
 // Forward declaration from main.c for debug_printf
 struct prog_state_type; // Already in pms_parser.h
@@ -165,4 +168,6 @@ pms_parser_status_t pms_parser_feed_byte(struct prog_state_type *ps,
             break;
     }
     return PMS_PARSER_PROCESSING_BYTE;
-}
\ No newline at end of file
+}
+
+#endif // FEATURE_PM_ENABLED
@@ -0,0 +1,90 @@
+/**
+ * @file ram_budget.c
+ * @brief Compile-time RAM budget of the modules that hold static state.
+ *
+ * Each module publishes ram_used_<name> through RAM_BUDGET_CHECK(); the
+ * references here are weak, so that a module left out of a build (a sensor
+ * driver, the SD backend) reads as absent instead of failing to link.
+ */
+
+#include "../inc/ram_budget.h"
+#include "../inc/scratch.h"
+#include "../inc/platform.h"
+#include "../inc/metrics.h"
+#include <stdio.h>
+
+_Static_assert(RAM_BUDGET_TOTAL <= RAM_BUDGET_SRAM_SZ, "RAM budget exceeds SRAM");
+_Static_assert(PLATFORM_STACK_WATCH_SZ <= RAM_BUDGET_stack, "Stack monitor watches past the stack budget");
+
+#define RAM_BUDGET_EXTERN_(name, budget, desc) \
+    extern const uint16_t ram_used_##name __attribute__((weak));
+RAM_BUDGET_TABLE(RAM_BUDGET_EXTERN_)
+
+// The stack has no static size; ram_budget_get() fills in its high-water mark
+RAM_BUDGET_CHECK(stack, 0);
+
+#define RAM_BUDGET_ENTRY_(name, budget, desc) \
+    { #name, (budget), &ram_used_##name },
+
+static const struct {
+    const char     *name;
+    uint16_t        budget;
+    const uint16_t *used;       // NULL if the module is not built
+} entries[] = {
+    RAM_BUDGET_TABLE(RAM_BUDGET_ENTRY_)
+};
+
+#define NR_ENTRIES (sizeof(entries) / sizeof(entries[0]))
+
+// --- Public API ---
+
+unsigned int ram_budget_count(void) {
+    return NR_ENTRIES;
+}
+
+bool ram_budget_get(unsigned int i, ram_budget_entry_t *out) {
+    if (i >= NR_ENTRIES) {
+        return false;
+    }
+    out->name = entries[i].name;
+    out->budget = entries[i].budget;
+    out->used = entries[i].used != NULL ? *entries[i].used : 0;
+    out->built = entries[i].used != NULL;
+    if (entries[i].used == &ram_used_stack) {
+        platform_stack_stats_t stk;
+
+        platform_stack_get_stats(&stk);
+        out->used = (uint16_t)stk.used;
+    } else if (entries[i].used == &ram_used_metrics) {
+        out->used = (uint16_t)metrics_ram_used();
+    }
+    return true;
+}
+
+int ram_budget_report(unsigned int i, char *buf, unsigned int size) {
+    ram_budget_entry_t e;
+
+    if (ram_budget_get(i, &e)) {
+        if (!e.built) {
+            return snprintf(buf, size, "ram %-9s     - / %5u\r\n", e.name, (unsigned)e.budget);
+        }
+        if (e.used == 0) {
+            return snprintf(buf, size, "ram %-9s       / %5u reserved\r\n", e.name, (unsigned)e.budget);
+        }
+        return snprintf(buf, size, "ram %-9s %5u / %5u%s\r\n", e.name, (unsigned)e.used,
+                        (unsigned)e.budget, e.used > e.budget ? " OVER" : "");
+    }
+    if (i == NR_ENTRIES) {
+        unsigned long used = 0;
+
+        for (unsigned int j = 0; j < NR_ENTRIES; ++j) {
+            if (ram_budget_get(j, &e)) {
+                used += e.used;
+            }
+        }
+        return snprintf(buf, size, "ram static %lu B, budget %u of %u B, scratch peak %u\r\n",
+                        used, (unsigned)RAM_BUDGET_TOTAL, (unsigned)RAM_BUDGET_SRAM_SZ,
+                        (unsigned)scratch_peak());
+    }
+    return 0;
+}
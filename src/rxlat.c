@@ -0,0 +1,55 @@
+/**
+ * @file rxlat.c
+ * @brief Per-message ingest latency of the sensor UARTs.
+ */
+
+#include "../inc/rxlat.h"
+#include "../inc/ram_budget.h"
+#include <string.h>
+
+static struct {
+    rxlat_stats_t src[PLATFORM_RXCAP_NR];
+} rxlat;
+
+RAM_BUDGET_CHECK(rxlat, sizeof(rxlat));
+
+// --- Public API ---
+
+void rxlat_init(void) {
+    memset(&rxlat, 0, sizeof(rxlat));
+}
+
+void rxlat_message(unsigned int src) {
+    rxlat_stats_t *st;
+    uint32_t age_us;
+
+    if (src >= PLATFORM_RXCAP_NR) {
+        return;
+    }
+    st = &rxlat.src[src];
+    ++st->msgs;
+    if (!platform_rxcap_take(src, &age_us)) {
+        return;
+    }
+    ++st->stamped;
+    if (age_us == UINT32_MAX) {
+        ++st->over_range;
+        return;
+    }
+    if (st->stamped - st->over_range == 1 || age_us < st->min_us) {
+        st->min_us = age_us;
+    }
+    if (age_us > st->max_us) {
+        st->max_us = age_us;
+    }
+    st->last_us = age_us;
+    st->sum_us += age_us;
+}
+
+void rxlat_get_stats(unsigned int src, rxlat_stats_t *out) {
+    if (src >= PLATFORM_RXCAP_NR) {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    *out = rxlat.src[src];
+}
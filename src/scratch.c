@@ -0,0 +1,57 @@
+/**
+ * @file scratch.c
+ * @brief Scratch arena for short-lived buffers of the main loop.
+ */
+
+#include "../inc/scratch.h"
+#include "../inc/ram_budget.h"
+#include <string.h>
+
+static struct {
+    uint32_t mem[(SCRATCH_SZ + 3) / 4]; // Words, so that every buffer is word-aligned
+    uint16_t top;                       // Bytes in use
+    uint16_t peak;                      // Largest top since start-up
+    uint32_t failures;                  // Allocations refused
+} scratch;
+
+RAM_BUDGET_CHECK(scratch, sizeof(scratch));
+
+// --- Public API ---
+
+scratch_mark_t scratch_mark(void) {
+    return scratch.top;
+}
+
+void *scratch_alloc(uint16_t size) {
+    uint16_t need = (uint16_t)((size + 3u) & ~3u);
+    void *p;
+
+    if (need > sizeof(scratch.mem) - scratch.top) {
+        ++scratch.failures;
+        return NULL;
+    }
+    p = (uint8_t *)scratch.mem + scratch.top;
+    scratch.top += need;
+    if (scratch.top > scratch.peak) {
+        scratch.peak = scratch.top;
+    }
+    return p;
+}
+
+void scratch_release(scratch_mark_t mark) {
+    if (mark >= scratch.top) {
+        return;
+    }
+#if SCRATCH_POISON
+    memset((uint8_t *)scratch.mem + mark, 0xA5, scratch.top - mark);
+#endif
+    scratch.top = mark;
+}
+
+uint16_t scratch_peak(void) {
+    return scratch.peak;
+}
+
+uint32_t scratch_failures(void) {
+    return scratch.failures;
+}
@@ -0,0 +1,550 @@
+/**
+ * @file sdcard.c
+ * @brief Non-blocking SD card block driver (SPI mode).
+ *
+ * Every state stands for a transfer in flight; when it completes, the state's
+ * handler looks at the received bytes and starts the next transfer. Handlers
+ * that only pick the next step without touching the bus return true, and the
+ * service loop runs them back-to-back. Commands share one sub-machine
+ * (frame, R1 poll, trailing response bytes), as do data-block reads (token
+ * poll, data, CRC); the operation states only say what comes after them.
+ *
+ * Chip select stays asserted for a whole operation and is released with one
+ * trailing byte, as cards only let go of MISO on a clock edge.
+ */
+
+#include "../inc/sdcard.h"
+#include "../inc/platform.h"
+#include "../inc/ram_budget.h"
+#include <string.h>
+
+// --- Protocol Definitions ---
+#define SD_CMD0                         0   // GO_IDLE_STATE
+#define SD_CMD8                         8   // SEND_IF_COND
+#define SD_CMD9                         9   // SEND_CSD
+#define SD_CMD16                        16  // SET_BLOCKLEN
+#define SD_CMD17                        17  // READ_SINGLE_BLOCK
+#define SD_ACMD23                       23  // SET_WR_BLK_ERASE_COUNT (pre-erase hint)
+#define SD_CMD25                        25  // WRITE_MULTIPLE_BLOCK
+#define SD_ACMD41                       41  // SD_SEND_OP_COND
+#define SD_CMD55                        55  // APP_CMD
+#define SD_CMD58                        58  // READ_OCR
+
+#define SD_R1_IDLE                      0x01
+#define SD_R1_ILLEGAL                   0x04
+
+#define SD_TOKEN_DATA                   0xFE // Single-block read data
+#define SD_TOKEN_WRITE_MULTI            0xFC // Multi-block write data
+#define SD_TOKEN_STOP_TRAN              0xFD // End of a multi-block write
+#define SD_DATA_ACCEPTED                0x05
+
+#define SD_R1_POLL_MAX                  10  // NCR is at most 8 bytes
+#define SD_CMD0_TRIES                   10
+#define SD_PWRUP_LEN                    10  // 80 clocks with the card deselected
+
+/// Driver states; each one (except the idle ones) has a transfer in flight.
+enum {
+    SD_ST_OFF = 0,
+    SD_ST_FAILED,
+    SD_ST_READY,
+
+    // Identification
+    SD_ST_START,
+    SD_ST_PWRUP,
+    SD_ST_INIT_CMD0,
+    SD_ST_INIT_CMD8,
+    SD_ST_INIT_ACMD41,
+    SD_ST_INIT_CMD58,
+    SD_ST_INIT_CMD9,
+    SD_ST_INIT_CSD,
+    SD_ST_INIT_CMD16,
+
+    // Command sub-machine
+    SD_ST_CMD_SENT,
+    SD_ST_CMD_R1,
+    SD_ST_CMD_EXTRA,
+
+    // Data-block read sub-machine
+    SD_ST_DIN_TOKEN,
+    SD_ST_DIN_DATA,
+    SD_ST_DIN_CRC,
+
+    // Single-block read
+    SD_ST_RD_CMD17,
+    SD_ST_RD_DONE,
+
+    // Multi-block write
+    SD_ST_WR_ACMD23,
+    SD_ST_WR_CMD25,
+    SD_ST_WR_NEXT,
+    SD_ST_WR_TOKEN,
+    SD_ST_WR_DATA,
+    SD_ST_WR_RESP,
+    SD_ST_WR_BUSY,
+    SD_ST_WR_STOP,
+    SD_ST_WR_STOP_SENT,
+    SD_ST_WR_STOP_BUSY,
+
+    // Deselect, then READY or FAILED
+    SD_ST_END
+};
+
+/**
+ * @brief Complete driver state.
+ */
+static struct {
+    uint8_t  state;
+    uint8_t  cont;              // State that takes over after a command or data read
+
+    // Command in progress
+    uint8_t  cmd;
+    uint32_t arg;
+    uint8_t  nr_extra;          // Response bytes after R1 (R3/R7: 4)
+    bool     app_pending;       // CMD55 sent; the application command follows
+    uint8_t  tries;             // R1 polls so far
+    uint8_t  cmd0_tries;
+    uint8_t  r1;
+    uint8_t  cmd_buf[7];        // Leading 0xFF, then the 6-byte command frame
+    uint8_t  resp[SD_BUSY_POLL_LEN];
+
+    // Data in progress
+    uint8_t *din_buf;
+    uint16_t din_len;
+    const uint8_t *const *wr_blocks;
+    uint32_t wr_addr;           // CMD25 argument
+    uint16_t wr_n;
+    uint16_t wr_idx;
+    sd_err_t wr_err;            // Error to report once the write is stopped
+
+    // Timing
+    uint32_t now_us;
+    uint32_t t_start_us;        // Start of the current timeout window
+
+    // Card
+    bool     v2;                // Answered CMD8 (SD version 2.00 or later)
+    bool     block_addr;        // SDHC/SDXC: commands take block, not byte, addresses
+    uint32_t capacity;
+    uint8_t  csd[16];
+
+    sd_err_t err;
+    bool     end_failed;        // Where SD_ST_END leads
+    sd_stats_t stats;
+} sd;
+
+RAM_BUDGET_CHECK(sdcard, sizeof(sd));
+
+// --- Static Helper Functions ---
+
+static uint32_t sd_us(const platform_timespec_t *t) {
+    return (t->nr_sec * 1000000u) + (t->nr_nsec / 1000u); // Wrap-around intentional
+}
+
+static bool sd_elapsed_ms(uint32_t ms) {
+    return (sd.now_us - sd.t_start_us) >= ms * 1000u;
+}
+
+/// CRC7 of a command frame; only checked by the card for CMD0 and CMD8.
+static uint8_t sd_crc7(const uint8_t *p, uint8_t len) {
+    uint8_t crc = 0;
+
+    while (len--) {
+        uint8_t c = *p++;
+        for (uint8_t i = 0; i < 8; ++i) {
+            crc <<= 1;
+            if (((c ^ crc) & 0x80) != 0) {
+                crc ^= 0x09;
+            }
+            c <<= 1;
+        }
+    }
+    return crc & 0x7F;
+}
+
+static void sd_xfer(const void *tx, void *rx, uint16_t len, uint8_t next) {
+    sd.state = next;
+    platform_spi_sd_xfer_async(tx, rx, len);
+}
+
+/// Clocks out one command frame; R1 is collected by the command sub-machine.
+static void sd_send_frame(uint8_t cmd, uint32_t arg) {
+    sd.cmd_buf[0] = 0xFF;
+    sd.cmd_buf[1] = (uint8_t)(0x40 | cmd);
+    sd.cmd_buf[2] = (uint8_t)(arg >> 24);
+    sd.cmd_buf[3] = (uint8_t)(arg >> 16);
+    sd.cmd_buf[4] = (uint8_t)(arg >> 8);
+    sd.cmd_buf[5] = (uint8_t)arg;
+    sd.cmd_buf[6] = (uint8_t)((sd_crc7(&sd.cmd_buf[1], 5) << 1) | 0x01);
+    sd_xfer(sd.cmd_buf, NULL, sizeof(sd.cmd_buf), SD_ST_CMD_SENT);
+}
+
+/**
+ * @brief Issues a command; @p cont runs once its response is in.
+ *
+ * @param app Precede the command with CMD55.
+ */
+static void sd_cmd(uint8_t cmd, uint32_t arg, uint8_t nr_extra, bool app, uint8_t cont) {
+    sd.cmd = cmd;
+    sd.arg = arg;
+    sd.nr_extra = nr_extra;
+    sd.app_pending = app;
+    sd.cont = cont;
+    sd_send_frame(app ? SD_CMD55 : cmd, app ? 0 : arg);
+}
+
+/// Reads a data block (token, @p len bytes, CRC); @p cont runs once it is in.
+static void sd_data_in(uint8_t *buf, uint16_t len, uint8_t cont) {
+    sd.din_buf = buf;
+    sd.din_len = len;
+    sd.cont = cont;
+    sd.t_start_us = sd.now_us;
+    sd_xfer(NULL, sd.resp, 1, SD_ST_DIN_TOKEN);
+}
+
+/// Clocks bytes while the card holds MISO low after a write.
+static void sd_busy_poll(uint8_t state) {
+    sd_xfer(NULL, sd.resp, SD_BUSY_POLL_LEN, state);
+}
+
+/// Returns true once the last busy poll saw the card release MISO.
+static bool sd_busy_done(void) {
+    if (sd.resp[SD_BUSY_POLL_LEN - 1] != 0xFF) {
+        return false;
+    }
+    if (sd.now_us - sd.t_start_us > sd.stats.busy_max_us) {
+        sd.stats.busy_max_us = sd.now_us - sd.t_start_us;
+    }
+    return true;
+}
+
+/// Ends the operation in progress: deselect, then go idle (or failed).
+static void sd_end(sd_err_t err, bool failed) {
+    sd.err = err;
+    sd.end_failed = failed;
+    if (err != SD_OK) {
+        sd.stats.errors++;
+    }
+    platform_spi_sd_select(false);
+    sd_xfer(NULL, NULL, 1, SD_ST_END);
+}
+
+/// Returns true while the card is being identified.
+static bool sd_in_init(void) {
+    return sd.cont >= SD_ST_START && sd.cont <= SD_ST_INIT_CMD16;
+}
+
+static void sd_fail_init(sd_err_t err) {
+    sd.capacity = 0;
+    sd_end(err, true);
+}
+
+/// Decodes the capacity from the CSD (version 1.0 or 2.0 layout).
+static uint32_t sd_csd_capacity(const uint8_t *csd) {
+    if ((csd[0] >> 6) == 1) {
+        uint32_t c_size = ((uint32_t)(csd[7] & 0x3F) << 16) |
+                          ((uint32_t)csd[8] << 8) | csd[9];
+        return (c_size + 1) * 1024u;
+    } else {
+        uint32_t read_bl_len = csd[5] & 0x0F;
+        uint32_t c_size = ((uint32_t)(csd[6] & 0x03) << 10) |
+                          ((uint32_t)csd[7] << 2) | (csd[8] >> 6);
+        uint32_t c_size_mult = ((uint32_t)(csd[9] & 0x03) << 1) | (csd[10] >> 7);
+        return (c_size + 1) << (c_size_mult + 2 + read_bl_len - 9);
+    }
+}
+
+/**
+ * @brief Handles the completion of the transfer of the current state.
+ *
+ * @return true to run the next state right away (no transfer was started).
+ */
+static bool sd_step(void) {
+    switch (sd.state) {
+    case SD_ST_OFF:
+    case SD_ST_FAILED:
+    case SD_ST_READY:
+        return false;
+
+    // --- Identification ---
+    case SD_ST_START:
+        sd.cont = SD_ST_START;
+        platform_spi_sd_select(false);
+        platform_spi_sd_set_baud(PLATFORM_SPI_SD_HZ_INIT);
+        sd_xfer(NULL, NULL, SD_PWRUP_LEN, SD_ST_PWRUP);
+        break;
+    case SD_ST_PWRUP:
+        platform_spi_sd_select(true);
+        sd.cmd0_tries = 0;
+        sd_cmd(SD_CMD0, 0, 0, false, SD_ST_INIT_CMD0);
+        break;
+    case SD_ST_INIT_CMD0:
+        if (sd.r1 != SD_R1_IDLE) {
+            if (++sd.cmd0_tries >= SD_CMD0_TRIES) {
+                sd_fail_init(SD_ERR_NO_CARD);
+            } else {
+                sd_cmd(SD_CMD0, 0, 0, false, SD_ST_INIT_CMD0);
+            }
+            break;
+        }
+        sd_cmd(SD_CMD8, 0x1AA, 4, false, SD_ST_INIT_CMD8);
+        break;
+    case SD_ST_INIT_CMD8:
+        if ((sd.r1 & SD_R1_ILLEGAL) != 0) {
+            sd.v2 = false;
+        } else if (sd.resp[3] == 0xAA && (sd.resp[2] & 0x0F) == 0x01) {
+            sd.v2 = true;
+        } else {
+            sd_fail_init(SD_ERR_NO_CARD); // Unusable voltage range
+            break;
+        }
+        sd.t_start_us = sd.now_us;
+        sd_cmd(SD_ACMD41, sd.v2 ? 0x40000000u : 0, 0, true, SD_ST_INIT_ACMD41);
+        break;
+    case SD_ST_INIT_ACMD41:
+        if (sd.r1 == SD_R1_IDLE && !sd_elapsed_ms(SD_INIT_TIMEOUT_MS)) {
+            sd_cmd(SD_ACMD41, sd.v2 ? 0x40000000u : 0, 0, true, SD_ST_INIT_ACMD41);
+        } else if (sd.r1 != 0) {
+            sd_fail_init(sd.r1 == SD_R1_IDLE ? SD_ERR_TIMEOUT : SD_ERR_CMD);
+        } else if (sd.v2) {
+            sd_cmd(SD_CMD58, 0, 4, false, SD_ST_INIT_CMD58);
+        } else {
+            sd.block_addr = false;
+            sd_cmd(SD_CMD9, 0, 0, false, SD_ST_INIT_CMD9);
+        }
+        break;
+    case SD_ST_INIT_CMD58:
+        sd.block_addr = (sd.r1 == 0) && ((sd.resp[0] & 0x40) != 0); // OCR.CCS
+        sd_cmd(SD_CMD9, 0, 0, false, SD_ST_INIT_CMD9);
+        break;
+    case SD_ST_INIT_CMD9:
+        if (sd.r1 != 0) {
+            sd_fail_init(SD_ERR_CMD);
+            break;
+        }
+        sd_data_in(sd.csd, sizeof(sd.csd), SD_ST_INIT_CSD);
+        break;
+    case SD_ST_INIT_CSD:
+        sd.capacity = sd_csd_capacity(sd.csd);
+        if (!sd.block_addr) {
+            sd_cmd(SD_CMD16, SD_BLOCK_SZ, 0, false, SD_ST_INIT_CMD16);
+            break;
+        }
+        sd.state = SD_ST_INIT_CMD16;
+        sd.r1 = 0;
+        return true;
+    case SD_ST_INIT_CMD16:
+        if (sd.r1 != 0) {
+            sd_fail_init(SD_ERR_CMD);
+            break;
+        }
+        platform_spi_sd_set_baud(PLATFORM_SPI_SD_HZ_FAST);
+        sd_end(SD_OK, false);
+        break;
+
+    // --- Command sub-machine ---
+    case SD_ST_CMD_SENT:
+        sd.tries = 0;
+        sd_xfer(NULL, &sd.r1, 1, SD_ST_CMD_R1);
+        break;
+    case SD_ST_CMD_R1:
+        if ((sd.r1 & 0x80) != 0) {
+            if (++sd.tries < SD_R1_POLL_MAX) {
+                sd_xfer(NULL, &sd.r1, 1, SD_ST_CMD_R1);
+            } else if (sd.cont == SD_ST_INIT_CMD0) {
+                // No answer at all: let CMD0 retry, then report no card
+                sd.state = sd.cont;
+                return true;
+            } else {
+                sd_end(SD_ERR_TIMEOUT, sd_in_init());
+            }
+            break;
+        }
+        if (sd.app_pending) {
+            sd.app_pending = false;
+            sd_send_frame(sd.cmd, sd.arg);
+            break;
+        }
+        if (sd.nr_extra > 0) {
+            sd_xfer(NULL, sd.resp, sd.nr_extra, SD_ST_CMD_EXTRA);
+            break;
+        }
+        sd.state = sd.cont;
+        return true;
+    case SD_ST_CMD_EXTRA:
+        sd.state = sd.cont;
+        return true;
+
+    // --- Data-block read sub-machine ---
+    case SD_ST_DIN_TOKEN:
+        if (sd.resp[0] == SD_TOKEN_DATA) {
+            sd_xfer(NULL, sd.din_buf, sd.din_len, SD_ST_DIN_DATA);
+        } else if (sd.resp[0] != 0xFF) {
+            sd_end(SD_ERR_DATA, sd_in_init());
+        } else if (sd_elapsed_ms(SD_READ_TIMEOUT_MS)) {
+            sd_end(SD_ERR_TIMEOUT, sd_in_init());
+        } else {
+            sd_xfer(NULL, sd.resp, 1, SD_ST_DIN_TOKEN);
+        }
+        break;
+    case SD_ST_DIN_DATA:
+        // CRC checking is off in SPI mode; the log format carries its own
+        sd_xfer(NULL, sd.resp, 2, SD_ST_DIN_CRC);
+        break;
+    case SD_ST_DIN_CRC:
+        sd.state = sd.cont;
+        return true;
+
+    // --- Single-block read ---
+    case SD_ST_RD_CMD17:
+        if (sd.r1 != 0) {
+            sd_end(SD_ERR_CMD, false);
+            break;
+        }
+        sd_data_in(sd.din_buf, SD_BLOCK_SZ, SD_ST_RD_DONE);
+        break;
+    case SD_ST_RD_DONE:
+        sd.stats.blocks_read++;
+        sd_end(SD_OK, false);
+        break;
+
+    // --- Multi-block write ---
+    case SD_ST_WR_ACMD23:
+        // Only a hint: a card that rejects it still takes the write
+        sd.stats.write_cmds++;
+        sd_cmd(SD_CMD25, sd.wr_addr, 0, false, SD_ST_WR_CMD25);
+        break;
+    case SD_ST_WR_CMD25:
+        if (sd.r1 != 0) {
+            sd_end(SD_ERR_CMD, false);
+            break;
+        }
+        sd.state = SD_ST_WR_NEXT;
+        return true;
+    case SD_ST_WR_NEXT:
+        sd.cmd_buf[0] = 0xFF;
+        sd.cmd_buf[1] = SD_TOKEN_WRITE_MULTI;
+        sd_xfer(sd.cmd_buf, NULL, 2, SD_ST_WR_TOKEN);
+        break;
+    case SD_ST_WR_TOKEN:
+        sd_xfer(sd.wr_blocks[sd.wr_idx], NULL, SD_BLOCK_SZ, SD_ST_WR_DATA);
+        break;
+    case SD_ST_WR_DATA:
+        // Dummy CRC, then the data response
+        sd_xfer(NULL, sd.resp, 3, SD_ST_WR_RESP);
+        break;
+    case SD_ST_WR_RESP:
+        if ((sd.resp[2] & 0x1F) != SD_DATA_ACCEPTED) {
+            sd.wr_err = SD_ERR_DATA;
+            sd.state = SD_ST_WR_STOP;
+            return true;
+        }
+        sd.t_start_us = sd.now_us;
+        sd_busy_poll(SD_ST_WR_BUSY);
+        break;
+    case SD_ST_WR_BUSY:
+        if (!sd_busy_done()) {
+            if (sd_elapsed_ms(SD_WRITE_TIMEOUT_MS)) {
+                sd_end(SD_ERR_TIMEOUT, false);
+            } else {
+                sd_busy_poll(SD_ST_WR_BUSY);
+            }
+            break;
+        }
+        sd.stats.blocks_written++;
+        sd.state = (++sd.wr_idx < sd.wr_n) ? SD_ST_WR_NEXT : SD_ST_WR_STOP;
+        return true;
+    case SD_ST_WR_STOP:
+        // The card needs one byte after the stop token before it signals busy
+        sd.cmd_buf[0] = SD_TOKEN_STOP_TRAN;
+        sd.cmd_buf[1] = 0xFF;
+        sd_xfer(sd.cmd_buf, NULL, 2, SD_ST_WR_STOP_SENT);
+        break;
+    case SD_ST_WR_STOP_SENT:
+        sd.t_start_us = sd.now_us;
+        sd_busy_poll(SD_ST_WR_STOP_BUSY);
+        break;
+    case SD_ST_WR_STOP_BUSY:
+        if (sd_busy_done()) {
+            sd_end(sd.wr_err, false);
+        } else if (sd_elapsed_ms(SD_WRITE_TIMEOUT_MS)) {
+            sd_end(SD_ERR_TIMEOUT, false);
+        } else {
+            sd_busy_poll(SD_ST_WR_STOP_BUSY);
+        }
+        break;
+
+    case SD_ST_END:
+        sd.state = sd.end_failed ? SD_ST_FAILED : SD_ST_READY;
+        return false;
+
+    default:
+        sd.state = SD_ST_FAILED;
+        return false;
+    }
+    return false;
+}
+
+// --- Public API ---
+
+void sd_init(void) {
+    sd_stats_t stats = sd.stats;
+
+    /*
+     * The power-up sequence starts from sd_service(), once a transfer of an
+     * abandoned operation (if any) has run out.
+     */
+    memset(&sd, 0, sizeof(sd));
+    sd.stats = stats;
+    sd.state = SD_ST_START;
+}
+
+void sd_service(const platform_timespec_t *now) {
+    sd.now_us = sd_us(now);
+    while (!platform_spi_sd_busy() && sd_step()) {
+    }
+}
+
+bool sd_ready(void) {
+    return sd.state == SD_ST_READY;
+}
+
+bool sd_failed(void) {
+    return sd.state == SD_ST_FAILED;
+}
+
+sd_err_t sd_last_error(void) {
+    return sd.err;
+}
+
+uint32_t sd_capacity_blocks(void) {
+    return sd.capacity;
+}
+
+bool sd_read_start(uint32_t lba, uint8_t *buf) {
+    if (sd.state != SD_ST_READY) {
+        return false;
+    }
+    sd.din_buf = buf;
+    platform_spi_sd_select(true);
+    sd_cmd(SD_CMD17, sd.block_addr ? lba : lba * SD_BLOCK_SZ, 0, false, SD_ST_RD_CMD17);
+    return true;
+}
+
+bool sd_write_start(uint32_t lba, const uint8_t *const *blocks, uint16_t n) {
+    if (sd.state != SD_ST_READY || n == 0) {
+        return false;
+    }
+    sd.wr_blocks = blocks;
+    sd.wr_n = n;
+    sd.wr_idx = 0;
+    sd.wr_addr = sd.block_addr ? lba : lba * SD_BLOCK_SZ;
+    sd.wr_err = SD_OK;
+    platform_spi_sd_select(true);
+
+    // Pre-erase hint first
+    sd_cmd(SD_ACMD23, n, 0, true, SD_ST_WR_ACMD23);
+    return true;
+}
+
+void sd_get_stats(sd_stats_t *out) {
+    *out = sd.stats;
+}
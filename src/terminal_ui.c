@@ -7,6 +7,7 @@
 #include "../inc/terminal_ui.h"
 #include "../inc/main.h"
 #include "../inc/platform.h"
+#include "../inc/scratch.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -28,7 +29,13 @@ static const char banner_text[] =
     "| EEE 192: Electrical and Electronics Engineering Laboratory VI      |\r\n"
     "|          Academic Year 2024-2025, Semester 2                       |\r\n"
     "|                                                                    |\r\n"
+#if FEATURE_GPS_ENABLED && FEATURE_PM_ENABLED
     "| Combined Project: GPS Module and PM Sensor                         |\r\n"
+#elif FEATURE_GPS_ENABLED
+    "| GPS Module                                                         |\r\n"
+#else
+    "| PM Sensor                                                          |\r\n"
+#endif
     "|                                                                    |\r\n"
     "| Authors: De Villa, Estrada, & Ramos (EEE 192 2S)                   |\r\n"
     "| Date:    2025                                                      |\r\n"
@@ -73,6 +80,7 @@ void ui_handle_banner_transmission(struct prog_state_type *ps) {
     }
 }
 
+#if FEATURE_GPS_ENABLED
 /**
  * @brief Handles the transmission of GPS data in a scrolling format.
  *
@@ -148,6 +156,9 @@ bool ui_handle_gps_data_transmission(struct prog_state_type *ps,
     }
 }
 
+#endif // FEATURE_GPS_ENABLED
+
+#if FEATURE_PM_ENABLED
 /**
  * @brief Handles the transmission of PM sensor data in a scrolling format.
  *
@@ -213,6 +224,9 @@ bool ui_handle_pm_data_transmission(struct prog_state_type *ps,
     }
 }
 
+#endif // FEATURE_PM_ENABLED
+
+#if FEATURE_GPS_ENABLED && FEATURE_PM_ENABLED
 /**
  * @brief Handles combined transmission of GPS and PM data in a single line.
  * 
@@ -289,6 +303,7 @@ bool ui_handle_combined_data_transmission(struct prog_state_type *ps,
         return false;
     }
 }
+#endif // FEATURE_GPS_ENABLED && FEATURE_PM_ENABLED
 
 /**
  * @brief Handles the transmission of raw data (for debugging).
@@ -391,4 +406,163 @@ bool ui_handle_raw_data_transmission(struct prog_state_type *ps,
         // Keep TX busy flag set for retry
         return false;
     }
-} 
\ No newline at end of file
+} 
+
+/**
+ * @brief Formats the latency counters of one receiver.
+ *
+ * @param buf Destination buffer.
+ * @param size Size of @p buf.
+ * @param name Receiver name.
+ * @param st Latency counters.
+ * @return Number of characters written (as snprintf).
+ */
+static int ui_format_latency(char *buf, size_t size, const char *name, const rxlat_stats_t *st) {
+    uint32_t nr = st->stamped - st->over_range;
+
+    if (nr == 0) {
+        return snprintf(buf, size, "%s %lu/%lu stamped", name,
+                        (unsigned long)st->stamped, (unsigned long)st->msgs);
+    }
+    return snprintf(buf, size, "%s %lu/%lu stamped: avg %lu us, min %lu, max %lu, last %lu, >%lu us %lu",
+                    name, (unsigned long)st->stamped, (unsigned long)st->msgs,
+                    (unsigned long)(st->sum_us / nr), (unsigned long)st->min_us,
+                    (unsigned long)st->max_us, (unsigned long)st->last_us,
+                    (unsigned long)PLATFORM_RXCAP_AGE_MAX_US, (unsigned long)st->over_range);
+}
+
+/**
+ * @brief Handles the transmission of the ingest-latency statistics (one line).
+ *
+ * @param ps Pointer to the program state structure.
+ * @param gps Latency counters of the GPS receiver (NULL in a build without it).
+ * @param pm Latency counters of the PM sensor receiver (NULL in a build without it).
+ * @return true if transmission was successfully initiated, false otherwise.
+ */
+bool ui_handle_latency_transmission(struct prog_state_type *ps,
+                                    const rxlat_stats_t *gps,
+                                    const rxlat_stats_t *pm) {
+    // Check if CDC TX is available
+    if (platform_usart_cdc_tx_busy()) {
+        return false;
+    }
+    
+    if (ps->flags & PROG_FLAG_CDC_TX_BUSY) {
+        return false;
+    }
+    
+    int len = snprintf(ps->cdc_tx_buf, CDC_TX_BUF_SZ, "%s[LAT] ", ANSI_BOLD);
+    if (gps != NULL) {
+        len += ui_format_latency(ps->cdc_tx_buf + len, CDC_TX_BUF_SZ - len, "GPS", gps);
+    }
+    if (gps != NULL && pm != NULL && len < CDC_TX_BUF_SZ) {
+        len += snprintf(ps->cdc_tx_buf + len, CDC_TX_BUF_SZ - len, " | ");
+    }
+    if (pm != NULL && len < CDC_TX_BUF_SZ) {
+        len += ui_format_latency(ps->cdc_tx_buf + len, CDC_TX_BUF_SZ - len, "PM", pm);
+    }
+    if (len < CDC_TX_BUF_SZ) {
+        len += snprintf(ps->cdc_tx_buf + len, CDC_TX_BUF_SZ - len, "%s\r\n", ANSI_RESET);
+    }
+    
+    // Check if formatting was successful
+    if (len <= 0 || len >= CDC_TX_BUF_SZ) {
+        return false;
+    }
+    
+    // Configure the transmission descriptor
+    ps->cdc_tx_desc[0].buf = ps->cdc_tx_buf;
+    ps->cdc_tx_desc[0].len = len;
+    
+    return platform_usart_cdc_tx_async(ps->cdc_tx_desc, 1);
+}
+
+/**
+ * @brief Handles the transmission of the stack, scratch and interrupt-masking figures (one line).
+ *
+ * @param ps Pointer to the program state structure.
+ * @param stk Stack usage (platform_stack_get_stats()).
+ * @param scratch_peak Most bytes of the scratch arena in use at once.
+ * @param crit Interrupt-masked time (platform_crit_get_stats()); left out if none was timed.
+ * @return true if transmission was successfully initiated, false otherwise.
+ */
+bool ui_handle_stack_transmission(struct prog_state_type *ps,
+                                  const platform_stack_stats_t *stk,
+                                  uint16_t scratch_peak,
+                                  const platform_crit_stats_t *crit) {
+    static const char *const isr_names[PLATFORM_STACK_ISR_NR] = {
+        [PLATFORM_STACK_ISR_SYSTICK] = "SysTick",
+        [PLATFORM_STACK_ISR_EIC]     = "EIC",
+    };
+
+    // Check if CDC TX is available
+    if (platform_usart_cdc_tx_busy()) {
+        return false;
+    }
+    
+    if (ps->flags & PROG_FLAG_CDC_TX_BUSY) {
+        return false;
+    }
+    
+    int len = snprintf(ps->cdc_tx_buf, CDC_TX_BUF_SZ, "%s[STK] %s%lu of %lu B, ISR entry:",
+                       ANSI_BOLD, stk->overrun ? "over " : "",
+                       (unsigned long)stk->used, (unsigned long)stk->watched);
+    for (unsigned i = 0; i < PLATFORM_STACK_ISR_NR && len < CDC_TX_BUF_SZ; ++i) {
+        len += snprintf(ps->cdc_tx_buf + len, CDC_TX_BUF_SZ - len, " %s %lu",
+                        isr_names[i], (unsigned long)stk->isr_depth[i]);
+    }
+    if (len < CDC_TX_BUF_SZ) {
+        len += snprintf(ps->cdc_tx_buf + len, CDC_TX_BUF_SZ - len, " | scratch %u of %u B",
+                        (unsigned)scratch_peak, (unsigned)SCRATCH_SZ);
+    }
+    if (crit->nr != 0 && len < CDC_TX_BUF_SZ) {
+        len += snprintf(ps->cdc_tx_buf + len, CDC_TX_BUF_SZ - len, " | IRQs masked: max %lu ns, %lu us total",
+                        (unsigned long)crit->max_ns, (unsigned long)(crit->total_ns / 1000u));
+    }
+    if (len < CDC_TX_BUF_SZ) {
+        len += snprintf(ps->cdc_tx_buf + len, CDC_TX_BUF_SZ - len, "%s\r\n", ANSI_RESET);
+    }
+    
+    // Check if formatting was successful
+    if (len <= 0 || len >= CDC_TX_BUF_SZ) {
+        return false;
+    }
+    
+    // Configure the transmission descriptor
+    ps->cdc_tx_desc[0].buf = ps->cdc_tx_buf;
+    ps->cdc_tx_desc[0].len = len;
+    
+    return platform_usart_cdc_tx_async(ps->cdc_tx_desc, 1);
+}
+
+bool ui_handle_metric_transmission(struct prog_state_type *ps,
+                                   const metric_snapshot_t *m) {
+    // Check if CDC TX is available
+    if (platform_usart_cdc_tx_busy()) {
+        return false;
+    }
+    
+    if (ps->flags & PROG_FLAG_CDC_TX_BUSY) {
+        return false;
+    }
+    
+    int len = metrics_format(m, ps->cdc_tx_buf, CDC_TX_BUF_SZ);
+    
+    // Check if formatting was successful
+    if (len <= 0) {
+        return false;
+    }
+    
+    // A histogram with every bucket in use may not fit; end the line where it was cut
+    if (len >= CDC_TX_BUF_SZ) {
+        len = CDC_TX_BUF_SZ - 1;
+        ps->cdc_tx_buf[len - 2] = '\r';
+        ps->cdc_tx_buf[len - 1] = '\n';
+    }
+    
+    // Configure the transmission descriptor
+    ps->cdc_tx_desc[0].buf = ps->cdc_tx_buf;
+    ps->cdc_tx_desc[0].len = len;
+    
+    return platform_usart_cdc_tx_async(ps->cdc_tx_desc, 1);
+}
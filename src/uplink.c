@@ -0,0 +1,456 @@
+/**
+ * @file uplink.c
+ * @brief Store-and-forward uplink queue with batching and ACK-driven retries.
+ *
+ * The queue is a byte ring holding a stretch of the record log, copied from
+ * the cursor onwards as room allows. Log records already have their
+ * on-the-wire layout, so a packet payload is simply a run of consecutive
+ * ring bytes; the copy may stop mid-record, and packets take only whole
+ * records. Records leave the ring when their packet is acknowledged, which
+ * frees room for the next stretch of the log. Up to
+ * UPLINK_WINDOW packets may be in flight; the gateway acknowledges them
+ * cumulatively. On a retransmission timeout the oldest packet is re-sent on
+ * its own (a probe) and the timeout doubles, up to UPLINK_RTO_MAX_MS. Once the
+ * probe is acknowledged the timeout resets, the rest of the window is re-sent
+ * and new packets follow back-to-back, so a backlog drains at link rate.
+ */
+
+#include "../inc/uplink.h"
+#include "../inc/logstore.h"
+#include "../inc/platform.h"
+#include "../inc/ram_budget.h"
+#include <string.h>
+
+#if UPLINK_ENABLED // Otherwise compiled out (see uplink.h)
+
+/// Size of a complete frame with the largest payload
+#define UPLINK_FRAME_MAX (UPLINK_HDR_LEN + UPLINK_PKT_PAYLOAD_MAX + UPLINK_CRC_LEN)
+
+/// Size of an ACK frame (no payload)
+#define UPLINK_ACK_FRAME_LEN (UPLINK_HDR_LEN + UPLINK_CRC_LEN)
+
+/// No log block held in the block buffer
+#define UPLINK_NO_BLOCK 0xFFFFFFFFu
+
+/**
+ * @brief Bookkeeping for one packet that has been sent but not acknowledged.
+ */
+typedef struct {
+    uint16_t seq;       // Sequence number carried by the packet
+    uint16_t nbytes;    // Record bytes (taken from the ring) in the packet
+    uint8_t  flags;     // Frame flags (UPLINK_FLAG_*)
+} uplink_inflight_t;
+
+/**
+ * @brief Complete uplink state.
+ */
+static struct {
+    // Record ring
+    uint8_t  queue[UPLINK_QUEUE_SZ];
+    uint16_t head;              // Offset at which the next record is written
+    uint16_t tail;              // Offset of the oldest unacknowledged record
+    uint16_t used;              // Bytes between tail and head
+    uint16_t sent;              // Bytes from tail already packetised
+
+    // Log cursor: the first log byte not yet copied into the ring
+    bool     cursor_set;        // Placed once the log could be read
+    uint32_t cur_blk;
+    uint16_t cur_off;
+    uint32_t blk_nr;            // Log block held in blk_buf
+    uint16_t blk_len;           // Its bytes when it was read
+    uint8_t  blk_buf[LOGSTORE_BLOCK_SZ];
+
+    // Packets in flight, oldest first
+    uplink_inflight_t inflight[UPLINK_WINDOW];
+    uint8_t  nr_inflight;
+    uint8_t  resend_idx;        // Next in-flight packet to (re)transmit
+    uint16_t next_seq;
+    uint16_t last_acked_seq;
+    bool     resync;            // Next new packet starts a new sequence space
+    bool     probing;           // Timed out; only the oldest packet is sent
+
+    // Timing
+    bool     batch_open;        // Unsent records are waiting to be batched
+    uint32_t batch_start_ms;
+    uint32_t last_tx_ms;        // When the oldest in-flight packet was last sent
+    uint16_t rto_ms;
+
+    // Transmission staging (must stay valid while the CDC driver sends it)
+    char     tx_buf[UPLINK_FRAME_MAX];
+    platform_usart_tx_bufdesc_t tx_desc[1];
+
+    // ACK parser
+    uint8_t  rx_frame[UPLINK_ACK_FRAME_LEN];
+    uint8_t  rx_idx;
+
+    uplink_stats_t stats;
+} uplink;
+
+RAM_BUDGET_CHECK(uplink, sizeof(uplink));
+
+// --- Static Helper Functions ---
+
+static uint32_t uplink_ms(const platform_timespec_t *t) {
+    return (t->nr_sec * 1000u) + (t->nr_nsec / 1000000u); // Wrap-around intentional
+}
+
+static uint16_t uplink_ring_wrap(uint32_t off) {
+    return (uint16_t)(off % UPLINK_QUEUE_SZ);
+}
+
+static uint8_t uplink_ring_peek(uint16_t off) {
+    return uplink.queue[uplink_ring_wrap(off)];
+}
+
+static void uplink_ring_copy_out(uint16_t off, uint8_t *dst, uint16_t len) {
+    uint16_t start = uplink_ring_wrap(off);
+    uint16_t first = UPLINK_QUEUE_SZ - start;
+
+    if (first > len) {
+        first = len;
+    }
+    memcpy(dst, &uplink.queue[start], first);
+    memcpy(dst + first, &uplink.queue[0], len - first);
+}
+
+static void uplink_ring_copy_in(const uint8_t *src, uint16_t len) {
+    uint16_t first = UPLINK_QUEUE_SZ - uplink.head;
+
+    if (first > len) {
+        first = len;
+    }
+    memcpy(&uplink.queue[uplink.head], src, first);
+    memcpy(&uplink.queue[0], src + first, len - first);
+    uplink.head = uplink_ring_wrap((uint32_t)uplink.head + len);
+}
+
+/// Returns the ring offset of the first record byte of in-flight packet @p idx.
+static uint16_t uplink_inflight_offset(uint8_t idx) {
+    uint32_t off = uplink.tail;
+
+    for (uint8_t i = 0; i < idx; ++i) {
+        off += uplink.inflight[i].nbytes;
+    }
+    return uplink_ring_wrap(off);
+}
+
+/**
+ * @brief Counts how many whole records starting at the first unsent byte fit
+ *        into one packet.
+ *
+ * @param full Set if a record that does not fit stopped the count.
+ * @return Number of record bytes to put into the next packet.
+ */
+static uint16_t uplink_next_packet_bytes(bool *full) {
+    uint16_t unsent = uplink.used - uplink.sent;
+    uint16_t off = uplink_ring_wrap((uint32_t)uplink.tail + uplink.sent);
+    uint16_t total = 0;
+
+    *full = false;
+    while (unsent - total >= 2) {
+        uint16_t rec_len = 2 + uplink_ring_peek(off + 1);
+        if (total + rec_len > UPLINK_PKT_PAYLOAD_MAX) {
+            *full = true;
+            break;
+        }
+        if (rec_len > unsent - total) {
+            break; // The rest of the record is still in the log
+        }
+        total += rec_len;
+        off = uplink_ring_wrap((uint32_t)off + rec_len);
+    }
+    if (total == UPLINK_PKT_PAYLOAD_MAX) {
+        *full = true;
+    }
+    return total;
+}
+
+/**
+ * @brief Moves the cursor to the end of the log, past bytes that can no
+ *        longer be read.
+ *
+ * The ring keeps its whole records; one that the gap cuts short is dropped.
+ */
+static void uplink_skip(uint32_t end_blk, uint16_t end_off) {
+    uint16_t whole = 0;
+
+    while (uplink.used - whole >= 2) {
+        uint16_t rec_len = 2 + uplink_ring_peek(uplink.tail + whole + 1);
+        if (rec_len > uplink.used - whole) {
+            break;
+        }
+        whole += rec_len;
+    }
+    uplink.stats.bytes_skipped += (end_blk - uplink.cur_blk) * LOGSTORE_BLOCK_SZ +
+                                  end_off - uplink.cur_off + (uplink.used - whole);
+    uplink.head = uplink_ring_wrap((uint32_t)uplink.tail + whole);
+    uplink.used = whole;
+    uplink.cur_blk = end_blk;
+    uplink.cur_off = end_off;
+    uplink.blk_nr = UPLINK_NO_BLOCK;
+}
+
+/**
+ * @brief Copies log bytes from the cursor into the ring, as far as the ring
+ *        has room and the log has data.
+ *
+ * Stops early while a block is fetched from the card.
+ */
+static void uplink_fill(uint32_t now_ms) {
+    uint32_t end_blk;
+    uint16_t end_off;
+
+    if (!uplink.cursor_set) {
+        if (!logstore_get_boot(&uplink.cur_blk, &uplink.cur_off)) {
+            return;
+        }
+        uplink.cursor_set = true;
+    }
+    logstore_get_end(&end_blk, &end_off);
+
+    while (uplink.used < UPLINK_QUEUE_SZ &&
+           (uplink.cur_blk < end_blk ||
+            (uplink.cur_blk == end_blk && uplink.cur_off < end_off))) {
+        uint16_t n;
+
+        if (uplink.cur_blk < logstore_first_block()) {
+            uplink_skip(end_blk, end_off);
+            return;
+        }
+        // (Re-)read the block once its copy is used up; the newest one grows
+        if (uplink.blk_nr != uplink.cur_blk || uplink.cur_off >= uplink.blk_len) {
+            n = logstore_read_block(uplink.cur_blk, uplink.blk_buf);
+            if (n == LOGSTORE_READ_PENDING) {
+                return;
+            }
+            if (n <= uplink.cur_off) {
+                uplink_skip(end_blk, end_off); // Unreadable on the card
+                return;
+            }
+            uplink.blk_nr = uplink.cur_blk;
+            uplink.blk_len = n;
+        }
+
+        n = uplink.blk_len - uplink.cur_off;
+        if (n > UPLINK_QUEUE_SZ - uplink.used) {
+            n = UPLINK_QUEUE_SZ - uplink.used;
+        }
+        uplink_ring_copy_in(&uplink.blk_buf[uplink.cur_off], n);
+        uplink.used += n;
+        uplink.cur_off += n;
+        if (uplink.cur_off == LOGSTORE_BLOCK_SZ) {
+            uplink.cur_blk++;
+            uplink.cur_off = 0;
+        }
+        uplink.stats.bytes_read += n;
+
+        if (uplink.used > uplink.stats.queue_peak) {
+            uplink.stats.queue_peak = uplink.used;
+        }
+        if (!uplink.batch_open) {
+            uplink.batch_open = true;
+            uplink.batch_start_ms = now_ms;
+        }
+    }
+}
+
+/**
+ * @brief Frames and sends a packet taken from the ring.
+ *
+ * @return true if the CDC driver accepted the frame.
+ */
+static bool uplink_send_packet(uint16_t ring_off, const uplink_inflight_t *pkt) {
+    uint8_t *f = (uint8_t *)uplink.tx_buf;
+    uint16_t crc;
+
+    f[0] = UPLINK_SYNC_1;
+    f[1] = UPLINK_SYNC_2;
+    f[2] = UPLINK_TYPE_DATA;
+    f[3] = pkt->flags;
+    f[4] = (uint8_t)(pkt->seq & 0xFF);
+    f[5] = (uint8_t)(pkt->seq >> 8);
+    f[6] = (uint8_t)(pkt->nbytes & 0xFF);
+    f[7] = (uint8_t)(pkt->nbytes >> 8);
+    uplink_ring_copy_out(ring_off, &f[UPLINK_HDR_LEN], pkt->nbytes);
+
+    crc = uplink_crc16(0xFFFF, &f[2], (UPLINK_HDR_LEN - 2) + pkt->nbytes);
+    f[UPLINK_HDR_LEN + pkt->nbytes]     = (uint8_t)(crc & 0xFF);
+    f[UPLINK_HDR_LEN + pkt->nbytes + 1] = (uint8_t)(crc >> 8);
+
+    uplink.tx_desc[0].buf = uplink.tx_buf;
+    uplink.tx_desc[0].len = UPLINK_HDR_LEN + pkt->nbytes + UPLINK_CRC_LEN;
+    if (!platform_usart_cdc_tx_async(uplink.tx_desc, 1)) {
+        return false;
+    }
+    uplink.stats.packets_sent++;
+    return true;
+}
+
+/// Releases in-flight packets up to and including @p seq.
+static void uplink_handle_ack(uint16_t seq, uint32_t now_ms) {
+    uint8_t k;
+
+    for (k = 0; k < uplink.nr_inflight; ++k) {
+        if (uplink.inflight[k].seq == seq) {
+            break;
+        }
+    }
+    if (k == uplink.nr_inflight) {
+        // Duplicate ACKs are expected after retransmissions; others are not
+        if (seq != uplink.last_acked_seq) {
+            uplink.stats.acks_bad++;
+        } else if (uplink.probing) {
+            // The gateway is reachable again; probe now instead of backing off
+            uplink.rto_ms = UPLINK_RTO_MIN_MS;
+            uplink.resend_idx = 0;
+        }
+        return;
+    }
+
+    for (uint8_t i = 0; i <= k; ++i) {
+        uplink.tail = uplink_ring_wrap((uint32_t)uplink.tail + uplink.inflight[i].nbytes);
+        uplink.used -= uplink.inflight[i].nbytes;
+        uplink.sent -= uplink.inflight[i].nbytes;
+    }
+    uplink.nr_inflight -= (k + 1);
+    memmove(&uplink.inflight[0], &uplink.inflight[k + 1],
+            uplink.nr_inflight * sizeof(uplink.inflight[0]));
+    uplink.stats.packets_acked += (k + 1);
+    uplink.last_acked_seq = seq;
+
+    if (uplink.probing) {
+        // The link is back; whatever else was in flight was likely lost too
+        uplink.probing = false;
+        uplink.resend_idx = 0;
+    } else {
+        uplink.resend_idx = (uplink.resend_idx > k) ? (uplink.resend_idx - (k + 1)) : 0;
+    }
+    uplink.rto_ms = UPLINK_RTO_MIN_MS;
+    uplink.last_tx_ms = now_ms;
+}
+
+// --- Public Function Implementations ---
+
+uint16_t uplink_crc16(uint16_t crc, const void *buf, size_t len) {
+    const uint8_t *p = (const uint8_t *)buf;
+
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (uint8_t b = 0; b < 8; ++b) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+void uplink_init(void) {
+    memset(&uplink, 0, sizeof(uplink));
+    uplink.resync = true;
+    uplink.rto_ms = UPLINK_RTO_MIN_MS;
+    uplink.last_acked_seq = 0xFFFF;
+    uplink.blk_nr = UPLINK_NO_BLOCK;
+}
+
+void uplink_rx_feed(const char *buf, uint16_t len) {
+    platform_timespec_t now;
+
+    platform_tick_count(&now);
+    for (uint16_t i = 0; i < len; ++i) {
+        uint8_t c = (uint8_t)buf[i];
+
+        if (uplink.rx_idx == 0 && c != UPLINK_SYNC_1) {
+            continue;
+        }
+        if (uplink.rx_idx == 1 && c != UPLINK_SYNC_2) {
+            uplink.rx_idx = (c == UPLINK_SYNC_1) ? 1 : 0;
+            continue;
+        }
+        uplink.rx_frame[uplink.rx_idx++] = c;
+        if (uplink.rx_idx < UPLINK_ACK_FRAME_LEN) {
+            continue;
+        }
+
+        // Complete ACK-sized frame; validate before acting on it
+        uplink.rx_idx = 0;
+        uint16_t crc = uplink_crc16(0xFFFF, &uplink.rx_frame[2], UPLINK_HDR_LEN - 2);
+        uint16_t rx_crc = (uint16_t)uplink.rx_frame[8] | ((uint16_t)uplink.rx_frame[9] << 8);
+        if (uplink.rx_frame[2] != UPLINK_TYPE_ACK || uplink.rx_frame[6] != 0 ||
+            uplink.rx_frame[7] != 0 || crc != rx_crc) {
+            uplink.stats.acks_bad++;
+            continue;
+        }
+        uplink_handle_ack((uint16_t)uplink.rx_frame[4] | ((uint16_t)uplink.rx_frame[5] << 8),
+                          uplink_ms(&now));
+    }
+}
+
+void uplink_service(const platform_timespec_t *now) {
+    uint32_t now_ms = uplink_ms(now);
+
+    uplink_fill(now_ms);
+    if (platform_usart_cdc_tx_busy()) {
+        return;
+    }
+
+    // Retransmission timeout on the oldest packet: probe with it alone
+    if (uplink.nr_inflight > 0 && uplink.resend_idx >= uplink.nr_inflight &&
+        (now_ms - uplink.last_tx_ms) >= uplink.rto_ms) {
+        uplink.probing = true;
+        uplink.resend_idx = 0;
+        uplink.rto_ms = (uplink.rto_ms >= (UPLINK_RTO_MAX_MS / 2)) ?
+                        UPLINK_RTO_MAX_MS : (uint16_t)(uplink.rto_ms * 2);
+    }
+
+    // Pending retransmissions take precedence over new data
+    if (uplink.resend_idx < uplink.nr_inflight) {
+        uint8_t idx = uplink.resend_idx;
+        if (uplink_send_packet(uplink_inflight_offset(idx), &uplink.inflight[idx])) {
+            uplink.stats.packets_retried++;
+            if (idx == 0) {
+                uplink.last_tx_ms = now_ms;
+            }
+            uplink.resend_idx = uplink.probing ? uplink.nr_inflight : (uint8_t)(idx + 1);
+        }
+        return;
+    }
+
+    if (uplink.probing || uplink.nr_inflight >= UPLINK_WINDOW || !uplink.batch_open) {
+        return;
+    }
+
+    // Send a full packet right away; otherwise wait for the batch timeout
+    bool full;
+    uint16_t nbytes = uplink_next_packet_bytes(&full);
+    if (nbytes == 0 ||
+        (!full && (now_ms - uplink.batch_start_ms) < UPLINK_BATCH_TIMEOUT_MS)) {
+        return;
+    }
+
+    uplink_inflight_t *pkt = &uplink.inflight[uplink.nr_inflight];
+    pkt->seq = uplink.next_seq;
+    pkt->nbytes = nbytes;
+    pkt->flags = uplink.resync ? UPLINK_FLAG_RESYNC : 0;
+    if (!uplink_send_packet(uplink_ring_wrap((uint32_t)uplink.tail + uplink.sent), pkt)) {
+        return;
+    }
+
+    if (uplink.nr_inflight == 0) {
+        uplink.last_tx_ms = now_ms;
+    }
+    uplink.nr_inflight++;
+    uplink.resend_idx = uplink.nr_inflight;
+    uplink.next_seq++;
+    uplink.sent += nbytes;
+    uplink.resync = false;
+    if (uplink.sent == uplink.used) {
+        uplink.batch_open = false;
+    }
+}
+
+void uplink_get_stats(uplink_stats_t *out) {
+    uplink.stats.queue_used = uplink.used;
+    uplink.stats.rto_ms = uplink.rto_ms;
+    *out = uplink.stats;
+}
+
+#endif // UPLINK_ENABLED